@@ -64,6 +64,11 @@ D2CfgMgr::D2CfgMgr() : DCfgMgrBase(DCfgContextBasePtr(new D2CfgContext())) {
     addToParseOrder("interface");
     addToParseOrder("ip_address");
     addToParseOrder("port");
+    addToParseOrder("max_coalesced_names");
+    addToParseOrder("dns_protocol");
+    addToParseOrder("queue_file");
+    addToParseOrder("ncr_format");
+    addToParseOrder("ncr_socket");
     addToParseOrder("tsig_keys");
     addToParseOrder("forward_ddns");
     addToParseOrder("reverse_ddns");
@@ -196,10 +201,17 @@ D2CfgMgr::createConfigParser(const std::string& config_id) {
     // Create parser instance based on element_id.
     bundy::dhcp::DhcpConfigParser* parser = NULL;
     if ((config_id == "interface")  ||
-        (config_id == "ip_address")) {
+        (config_id == "ip_address") ||
+        (config_id == "queue_file") ||
+        (config_id == "ncr_socket")) {
         parser = new bundy::dhcp::StringParser(config_id,
                                              context->getStringStorage());
-    } else if (config_id == "port") {
+    } else if (config_id == "dns_protocol") {
+        parser = new DnsProtocolParser(config_id, context->getStringStorage());
+    } else if (config_id == "ncr_format") {
+        parser = new NcrFormatParser(config_id, context->getStringStorage());
+    } else if ((config_id == "port") ||
+               (config_id == "max_coalesced_names")) {
         parser = new bundy::dhcp::Uint32Parser(config_id,
                                              context->getUint32Storage());
     } else if (config_id ==  "forward_ddns") {
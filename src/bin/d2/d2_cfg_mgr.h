@@ -235,8 +235,13 @@ protected:
     ///     1. interface
     ///     2. ip_address
     ///     3. port
-    ///     4. forward_ddns
-    ///     5. reverse_ddns
+    ///     4. max_coalesced_names
+    ///     5. dns_protocol
+    ///     6. queue_file
+    ///     7. ncr_format
+    ///     8. ncr_socket
+    ///     9. forward_ddns
+    ///     10. reverse_ddns
     ///
     /// @param element_id is the string name of the element as it will appear
     /// in the configuration set.
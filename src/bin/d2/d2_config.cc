@@ -14,14 +14,17 @@
 
 #include <d2/d2_log.h>
 #include <d2/d2_cfg_mgr.h>
+#include <dhcp_ddns/ncr_msg.h>
 #include <dhcpsrv/dhcp_parsers.h>
 #include <exceptions/exceptions.h>
 #include <asiolink/io_error.h>
 
 #include <boost/foreach.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/algorithm/string/case_conv.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 
+#include <algorithm>
 #include <string>
 
 namespace bundy {
@@ -37,6 +40,28 @@ TSIGKeyInfo::TSIGKeyInfo(const std::string& name, const std::string& algorithm,
 TSIGKeyInfo::~TSIGKeyInfo() {
 }
 
+dns::TSIGKey
+TSIGKeyInfo::toTSIGKey() const {
+    std::string algorithm = boost::algorithm::to_lower_copy(algorithm_);
+    std::replace(algorithm.begin(), algorithm.end(), '_', '-');
+    if (!boost::algorithm::starts_with(algorithm, "hmac-")) {
+        algorithm = "hmac-" + algorithm;
+    }
+
+    // The short name of HMAC-MD5 is accepted by TSIGKey but is not the name
+    // sent on the wire.
+    if (algorithm == "hmac-md5") {
+        algorithm = dns::TSIGKey::HMACMD5_NAME().toText();
+    }
+
+    try {
+        return (dns::TSIGKey(name_ + ":" + secret_ + ":" + algorithm));
+    } catch (const std::exception& ex) {
+        bundy_throw(D2CfgError, "TSIG key " << name_ << " cannot be used: "
+                    << ex.what());
+    }
+}
+
 
 // *********************** DnsServerInfo  *************************
 
@@ -645,6 +670,47 @@ DdnsDomainListMgrParser::commit() {
     mgr_->setDomains(local_domains_);
 }
 
+// *********************** DnsProtocolParser  *************************
+
+DnsProtocolParser::DnsProtocolParser(const std::string& param_name,
+                                     bundy::dhcp::StringStoragePtr storage)
+    : bundy::dhcp::StringParser(param_name, storage) {
+}
+
+DnsProtocolParser::~DnsProtocolParser() {
+}
+
+void
+DnsProtocolParser::build(bundy::data::ConstElementPtr value) {
+    const std::string protocol = value->stringValue();
+    if ((protocol != "UDP") && (protocol != "TCP")) {
+        bundy_throw(D2CfgError, "DNS protocol must be UDP or TCP: "
+                    << protocol);
+    }
+    bundy::dhcp::StringParser::build(value);
+}
+
+// *********************** NcrFormatParser  *************************
+
+NcrFormatParser::NcrFormatParser(const std::string& param_name,
+                                 bundy::dhcp::StringStoragePtr storage)
+    : bundy::dhcp::StringParser(param_name, storage) {
+}
+
+NcrFormatParser::~NcrFormatParser() {
+}
+
+void
+NcrFormatParser::build(bundy::data::ConstElementPtr value) {
+    try {
+        dhcp_ddns::stringToNcrFormat(value->stringValue());
+    } catch (const bundy::BadValue& ex) {
+        bundy_throw(D2CfgError, "NCR format must be JSON or BINARY: "
+                    << value->stringValue());
+    }
+    bundy::dhcp::StringParser::build(value);
+}
+
 
 }; // end of bundy::dhcp namespace
 }; // end of bundy namespace
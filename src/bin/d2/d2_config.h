@@ -19,6 +19,7 @@
 #include <d2/d2_asio.h>
 #include <d2/d_cfg_mgr.h>
 #include <dhcpsrv/dhcp_parsers.h>
+#include <dns/tsigkey.h>
 #include <exceptions/exceptions.h>
 
 #include <boost/foreach.hpp>
@@ -147,10 +148,8 @@ public:
 ///
 /// Currently, this is simple storage class containing the basic attributes of
 /// a TSIG Key.  It is intended primarily as a reference for working with
-/// actual keys and may eventually be replaced by bundy::dns::TSIGKey.  TSIG Key
-/// functionality at this stage is strictly limited to configuration parsing.
-/// @todo full functionality for using TSIG during DNS updates will be added
-/// in a future release.
+/// actual keys, the bundy::dns::TSIGKey signing the DNS updates is made from
+/// it by toTSIGKey().
 class TSIGKeyInfo {
 public:
 
@@ -188,6 +187,16 @@ public:
         return (secret_);
     }
 
+    /// @brief Makes the key used to sign the DNS updates.
+    ///
+    /// The algorithm may be given with or without its "hmac" prefix, e.g.
+    /// "md5", "hmac_md5" or "HMAC-MD5.SIG-ALG.REG.INT".
+    ///
+    /// @return the key
+    /// @throw D2CfgError if the algorithm is not supported or the secret is
+    /// not valid base64.
+    dns::TSIGKey toTSIGKey() const;
+
 private:
     /// @brief The name of the key.
     ///
@@ -952,6 +961,52 @@ private:
     DScalarContext local_scalars_;
 };
 
+/// @brief Parser for the protocol used to send the DNS updates.
+///
+/// The value must be "UDP" or "TCP".
+class DnsProtocolParser : public bundy::dhcp::StringParser {
+public:
+    /// @brief Constructor
+    ///
+    /// @param param_name name of the parameter.
+    /// @param storage is the storage where the value is stored upon commit.
+    DnsProtocolParser(const std::string& param_name,
+                      bundy::dhcp::StringStoragePtr storage);
+
+    /// @brief Destructor
+    virtual ~DnsProtocolParser();
+
+    /// @brief Parses the protocol.
+    ///
+    /// @param value the protocol element.
+    ///
+    /// @throw D2CfgError if the protocol is not supported.
+    virtual void build(bundy::data::ConstElementPtr value);
+};
+
+/// @brief Parser for the wire format of the requests received.
+///
+/// The value must be "JSON" or "BINARY".
+class NcrFormatParser : public bundy::dhcp::StringParser {
+public:
+    /// @brief Constructor
+    ///
+    /// @param param_name name of the parameter.
+    /// @param storage is the storage where the value is stored upon commit.
+    NcrFormatParser(const std::string& param_name,
+                    bundy::dhcp::StringStoragePtr storage);
+
+    /// @brief Destructor
+    virtual ~NcrFormatParser();
+
+    /// @brief Parses the format.
+    ///
+    /// @param value the format element.
+    ///
+    /// @throw D2CfgError if the format is not supported.
+    virtual void build(bundy::data::ConstElementPtr value);
+};
+
 
 }; // end of bundy::d2 namespace
 }; // end of bundy namespace
@@ -62,6 +62,10 @@ D2Process::run() {
             // process finished ones.
             update_mgr_->sweep();
 
+            // Flush the requests received and completed during the last
+            // events to the queue file, if any, in a single write.
+            queue_mgr_->syncQueueFile();
+
             // Wait on IO event(s)  - block until one or more of the following
             // has occurred:
             //   a. NCR message has been received
@@ -82,9 +86,9 @@ D2Process::run() {
         }
     }
 
-    // @todo - if queue isn't empty, we may need to persist its contents
-    // this might be the place to do it, once there is a persistence mgr.
-    // This may also be better in checkQueueStatus.
+    // The requests still queued, if any, are queued again after a restart
+    // when a queue file is configured.
+    queue_mgr_->syncQueueFile();
 
     LOG_DEBUG(dctl_logger, DBGLVL_START_SHUT, DHCP_DDNS_RUN_EXIT);
 
@@ -213,6 +217,19 @@ D2Process::configure(bundy::data::ConstElementPtr config_set) {
         return (answer);
     }
 
+    // The update manager takes the new values right away: the updates
+    // already collected are sent by the next sweep and the transactions in
+    // progress keep their protocol.
+    uint32_t max_coalesced_names = 1;
+    getCfgMgr()->getContext()->getParam("max_coalesced_names",
+                                        max_coalesced_names, true);
+    update_mgr_->setMaxCoalescedNames(max_coalesced_names);
+
+    std::string dns_protocol = "UDP";
+    getCfgMgr()->getContext()->getParam("dns_protocol", dns_protocol, true);
+    update_mgr_->setDNSProtocol(dns_protocol == "TCP" ? DNSClient::TCP :
+                                DNSClient::UDP);
+
     // Set the reconf_queue_flag to indicate that we need to reconfigure
     // the queue manager.  Reconfiguring the queue manager may be asynchronous
     // and require one or more events to occur, therefore we set a flag
@@ -325,7 +342,7 @@ D2Process::reconfigureQueueMgr() {
         queue_mgr_->removeListener();
 
         // Get the configuration parameters that affect Queue Manager.
-        // @todo Need to add parameters for listener TYPE, FORMAT, address reuse
+        // @todo Need to add parameters for address reuse
         std::string ip_address;
         uint32_t port;
         getCfgMgr()->getContext()->getParam("ip_address", ip_address);
@@ -339,8 +356,30 @@ D2Process::reconfigureQueueMgr() {
         getCfgMgr()->getContext()->getParam("port", port);
         bundy::asiolink::IOAddress addr(ip_address);
 
-        // Instantiate the listener.
-        queue_mgr_->initUDPListener(addr, port, dhcp_ddns::FMT_JSON, true);
+        // Open the queue file first, so the requests it holds are queued
+        // before the new ones.  The requests are still received if the file
+        // can't be opened.
+        std::string queue_file;
+        getCfgMgr()->getContext()->getParam("queue_file", queue_file, true);
+        try {
+            queue_mgr_->setQueueFile(queue_file);
+        } catch (const std::exception& ex) {
+            LOG_ERROR(dctl_logger, DHCP_DDNS_QUEUE_FILE_ERROR)
+                      .arg(queue_file).arg(ex.what());
+        }
+
+        // Instantiate the listener, on the Unix socket if one is configured.
+        std::string ncr_format("JSON");
+        getCfgMgr()->getContext()->getParam("ncr_format", ncr_format, true);
+        const dhcp_ddns::NameChangeFormat format =
+            dhcp_ddns::stringToNcrFormat(ncr_format);
+        std::string ncr_socket;
+        getCfgMgr()->getContext()->getParam("ncr_socket", ncr_socket, true);
+        if (ncr_socket.empty()) {
+            queue_mgr_->initUDPListener(addr, port, format, true);
+        } else {
+            queue_mgr_->initUnixListener(ncr_socket, format);
+        }
 
         // Now start it. This assumes that starting is a synchronous,
         // blocking call that executes quickly.  @todo Should that change then
@@ -0,0 +1,354 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <d2/d2_log.h>
+#include <d2/d2_queue_file.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace bundy {
+namespace d2 {
+
+// Makes constants visible to Google test macros.
+const size_t D2QueueFile::MAX_BUFFERED_RECORDS;
+const size_t D2QueueFile::MIN_COMPACT_RECORDS;
+
+D2QueueFile::D2QueueFile(const std::string& filename)
+    : filename_(filename), fd_(-1), buffer_(), buffered_(0), pending_(),
+      next_id_(1), completed_(0) {
+}
+
+D2QueueFile::~D2QueueFile() {
+    try {
+        close();
+    } catch (const std::exception& ex) {
+        LOG_ERROR(dctl_logger, DHCP_DDNS_QUEUE_FILE_ERROR)
+                  .arg(filename_).arg(ex.what());
+    }
+}
+
+void
+D2QueueFile::open(QueuedRequestList& requests) {
+    if (isOpen()) {
+        bundy_throw(D2QueueFileError, "queue file '" << filename_
+                  << "' is already open");
+    }
+
+    // The file is the only source of the requests, in case it is opened again.
+    pending_.clear();
+    buffer_.clear();
+    buffered_ = 0;
+    completed_ = 0;
+
+    fd_ = ::open(filename_.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd_ < 0) {
+        bundy_throw(D2QueueFileError, "unable to open queue file '"
+                  << filename_ << "': " << strerror(errno));
+    }
+
+    try {
+        size_t invalid = replay();
+
+        // The requests which can't be parsed are dropped by the compaction.
+        std::map<uint64_t, std::string>::iterator it = pending_.begin();
+        while (it != pending_.end()) {
+            try {
+                requests.push_back(QueuedRequest(it->first,
+                                                 dhcp_ddns::NameChangeRequest::
+                                                 fromJSON(it->second)));
+                ++it;
+            } catch (const std::exception&) {
+                ++invalid;
+                pending_.erase(it++);
+            }
+        }
+
+        if (invalid) {
+            LOG_WARN(dctl_logger, DHCP_DDNS_QUEUE_FILE_INVALID_RECORDS)
+                     .arg(invalid).arg(filename_);
+        }
+
+        // Start from a clean file, without the completed requests nor the
+        // last record if it was cut short.
+        compact();
+    } catch (...) {
+        ::close(fd_);
+        fd_ = -1;
+        pending_.clear();
+        throw;
+    }
+
+    LOG_INFO(dctl_logger, DHCP_DDNS_QUEUE_FILE_OPENED)
+             .arg(filename_).arg(requests.size());
+}
+
+void
+D2QueueFile::close() {
+    if (!isOpen()) {
+        return;
+    }
+
+    try {
+        flush();
+        syncFd(fd_, filename_);
+    } catch (...) {
+        ::close(fd_);
+        fd_ = -1;
+        throw;
+    }
+
+    ::close(fd_);
+    fd_ = -1;
+}
+
+uint64_t
+D2QueueFile::append(const dhcp_ddns::NameChangeRequest& ncr) {
+    if (!isOpen()) {
+        bundy_throw(D2QueueFileError, "queue file '" << filename_
+                  << "' is not open");
+    }
+
+    const uint64_t id = next_id_++;
+    const std::string json = ncr.toJSON();
+    std::ostringstream record;
+    record << "+" << id << " " << json << "\n";
+    buffer(record.str());
+    pending_[id] = json;
+    return (id);
+}
+
+void
+D2QueueFile::complete(const uint64_t id) {
+    if (!isOpen()) {
+        bundy_throw(D2QueueFileError, "queue file '" << filename_
+                  << "' is not open");
+    }
+
+    if (pending_.count(id) == 0) {
+        return;
+    }
+
+    std::ostringstream record;
+    record << "-" << id << "\n";
+    buffer(record.str());
+    pending_.erase(id);
+    ++completed_;
+}
+
+void
+D2QueueFile::sync() {
+    if (!isOpen()) {
+        return;
+    }
+
+    flush();
+    syncFd(fd_, filename_);
+
+    if ((completed_ >= MIN_COMPACT_RECORDS) &&
+        (completed_ > pending_.size())) {
+        compact();
+    }
+}
+
+void
+D2QueueFile::clear() {
+    // The completion records are still written by close() if the
+    // compaction fails.
+    while (!pending_.empty()) {
+        complete(pending_.begin()->first);
+    }
+    compact();
+}
+
+void
+D2QueueFile::compact() {
+    if (!isOpen()) {
+        bundy_throw(D2QueueFileError, "queue file '" << filename_
+                  << "' is not open");
+    }
+
+    // The pending requests include those of the buffered records, which
+    // are dropped once the new file is in place.
+    std::ostringstream content;
+    for (std::map<uint64_t, std::string>::const_iterator it =
+         pending_.begin(); it != pending_.end(); ++it) {
+        content << "+" << it->first << " " << it->second << "\n";
+    }
+
+    const std::string tmp_name = filename_ + ".tmp";
+    const int tmp_fd = ::open(tmp_name.c_str(),
+                              O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (tmp_fd < 0) {
+        bundy_throw(D2QueueFileError, "unable to open queue file '"
+                  << tmp_name << "': " << strerror(errno));
+    }
+
+    try {
+        writeAll(tmp_fd, content.str(), tmp_name);
+        syncFd(tmp_fd, tmp_name);
+        if (::rename(tmp_name.c_str(), filename_.c_str()) != 0) {
+            bundy_throw(D2QueueFileError, "unable to rename queue file '"
+                      << tmp_name << "' to '" << filename_ << "': "
+                      << strerror(errno));
+        }
+    } catch (...) {
+        ::close(tmp_fd);
+        ::unlink(tmp_name.c_str());
+        throw;
+    }
+
+    // The new file takes the place of the old one.
+    ::close(fd_);
+    fd_ = tmp_fd;
+    buffer_.clear();
+    buffered_ = 0;
+    completed_ = 0;
+
+    LOG_DEBUG(dctl_logger, DBGLVL_TRACE_DETAIL, DHCP_DDNS_QUEUE_FILE_COMPACTED)
+              .arg(filename_).arg(pending_.size());
+}
+
+size_t
+D2QueueFile::replay() {
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        bundy_throw(D2QueueFileError, "unable to read queue file '"
+                  << filename_ << "': " << strerror(errno));
+    }
+    if (st.st_size == 0) {
+        return (0);
+    }
+
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (map == MAP_FAILED) {
+        bundy_throw(D2QueueFileError, "unable to map queue file '"
+                  << filename_ << "': " << strerror(errno));
+    }
+
+    const char* pos = static_cast<const char*>(map);
+    const char* const end = pos + st.st_size;
+    size_t invalid = 0;
+    while (pos < end) {
+        const char* eol = static_cast<const char*>(memchr(pos, '\n',
+                                                          end - pos));
+        if (!eol) {
+            // The last record was cut short by a crash.
+            ++invalid;
+            break;
+        }
+
+        const std::string line(pos, eol);
+        pos = eol + 1;
+
+        char* id_end = NULL;
+        const uint64_t id = (line.size() > 1) ?
+            strtoull(line.c_str() + 1, &id_end, 10) : 0;
+        if ((id == 0) || (id_end == line.c_str() + 1)) {
+            ++invalid;
+            continue;
+        }
+
+        if ((line[0] == '+') && (*id_end == ' ')) {
+            pending_[id] = std::string(id_end + 1);
+        } else if ((line[0] == '-') && (*id_end == '\0')) {
+            pending_.erase(id);
+        } else {
+            ++invalid;
+            continue;
+        }
+
+        if (id >= next_id_) {
+            next_id_ = id + 1;
+        }
+    }
+
+    munmap(map, st.st_size);
+    return (invalid);
+}
+
+void
+D2QueueFile::buffer(const std::string& record) {
+    // The buffer is written before the record is added, so the record is
+    // not taken if the write fails.
+    if (buffered_ >= MAX_BUFFERED_RECORDS) {
+        flush();
+    }
+    buffer_ += record;
+    ++buffered_;
+}
+
+void
+D2QueueFile::flush() {
+    if (buffer_.empty()) {
+        return;
+    }
+
+    // A failed write must not leave a partial record in front of the next
+    // ones.
+    const off_t size = lseek(fd_, 0, SEEK_END);
+    try {
+        writeAll(fd_, buffer_, filename_);
+    } catch (...) {
+        if ((size >= 0) && (ftruncate(fd_, size) != 0)) {
+            // Nothing more can be done, the next replay ignores the record.
+        }
+        throw;
+    }
+
+    buffer_.clear();
+    buffered_ = 0;
+}
+
+void
+D2QueueFile::writeAll(const int fd, const std::string& data,
+                      const std::string& name) const {
+    const char* pos = data.c_str();
+    size_t left = data.size();
+    while (left > 0) {
+        const ssize_t written = ::write(fd, pos, left);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            bundy_throw(D2QueueFileError, "unable to write queue file '"
+                      << name << "': " << strerror(errno));
+        }
+        pos += written;
+        left -= written;
+    }
+}
+
+void
+D2QueueFile::syncFd(const int fd, const std::string& name) const {
+#ifdef OS_LINUX
+    const int result = fdatasync(fd);
+#else
+    const int result = fsync(fd);
+#endif
+    if (result != 0) {
+        bundy_throw(D2QueueFileError, "unable to flush queue file '"
+                  << name << "' to the disk: " << strerror(errno));
+    }
+}
+
+} // namespace bundy::d2
+} // namespace bundy
@@ -0,0 +1,222 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef D2_QUEUE_FILE_H
+#define D2_QUEUE_FILE_H
+
+/// @file d2_queue_file.h This file defines the class D2QueueFile.
+
+#include <exceptions/exceptions.h>
+#include <dhcp_ddns/ncr_msg.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+namespace bundy {
+namespace d2 {
+
+/// @brief Thrown if the queue file can't be read or written.
+class D2QueueFileError : public bundy::Exception {
+public:
+    D2QueueFileError(const char* file, size_t line, const char* what) :
+        bundy::Exception(file, line, what) { };
+};
+
+/// @brief A request read back from the queue file, with its record id.
+typedef std::pair<uint64_t, dhcp_ddns::NameChangeRequestPtr> QueuedRequest;
+
+/// @brief The requests read back from the queue file, in arrival order.
+typedef std::vector<QueuedRequest> QueuedRequestList;
+
+/// @brief Append-only file keeping the requests of D2QueueMgr across restarts.
+///
+/// The file is a journal of text records, one per line:
+///
+///     - "+<id> <request in JSON>" when a request is received,
+///     - "-<id>" when the request has been carried out (or given up).
+///
+/// The records are buffered and written by sync(), which also flushes the
+/// file to the disk, so a single flush serves all the requests received
+/// meanwhile.  The buffer is written on its own once it holds
+/// MAX_BUFFERED_RECORDS records.  The requests received since the last
+/// sync() are lost if the process crashes; the others are never lost.
+///
+/// When the file is opened, it is mapped in memory and the requests which
+/// have no completion record are returned, to be queued again.  A record cut
+/// short by a crash is ignored.  The file is then compacted: it is rewritten
+/// with the pending requests only, in a temporary file renamed over the
+/// original one, so a crash at any point leaves a complete file.  The file
+/// is compacted again by sync() when the completed requests outnumber the
+/// pending ones (and MIN_COMPACT_RECORDS at least).
+///
+/// A request replayed after a crash may have been carried out already: the
+/// DNS updates are applied at least once, never lost.
+class D2QueueFile : public boost::noncopyable {
+public:
+    /// @brief Number of records buffered before they are written.
+    static const size_t MAX_BUFFERED_RECORDS = 256;
+
+    /// @brief Minimum number of completion records triggering a compaction.
+    static const size_t MIN_COMPACT_RECORDS = 1024;
+
+    /// @brief Constructor
+    ///
+    /// The file is not opened until open() is called.
+    ///
+    /// @param filename the name of the file
+    explicit D2QueueFile(const std::string& filename);
+
+    /// @brief Destructor
+    ///
+    /// Writes the records buffered and closes the file.  Errors are logged.
+    ~D2QueueFile();
+
+    /// @brief Opens the file, creating it if needed.
+    ///
+    /// @param[out] requests the pending requests found in the file, which
+    /// keep their ids.
+    ///
+    /// @throw D2QueueFileError if the file is already open, or if it
+    /// can't be read or rewritten.
+    void open(QueuedRequestList& requests);
+
+    /// @brief Writes the buffered records and closes the file.
+    ///
+    /// It is a no-op if the file is not open.
+    ///
+    /// @throw D2QueueFileError if the records can't be written.
+    void close();
+
+    /// @brief Returns true if the file is open.
+    bool isOpen() const {
+        return (fd_ >= 0);
+    }
+
+    /// @brief Records a request.
+    ///
+    /// @param ncr the request
+    ///
+    /// @return the id of the request, to be passed to complete().
+    ///
+    /// @throw D2QueueFileError if the file is not open or the buffer
+    /// can't be written, in which case the request is not recorded.
+    uint64_t append(const dhcp_ddns::NameChangeRequest& ncr);
+
+    /// @brief Records the completion of a request.
+    ///
+    /// Unknown ids are ignored.
+    ///
+    /// @param id the id returned by append(), or read back by open()
+    ///
+    /// @throw D2QueueFileError if the file is not open or the buffer
+    /// can't be written.
+    void complete(const uint64_t id);
+
+    /// @brief Writes the buffered records and flushes the file to the disk.
+    ///
+    /// The file is compacted if enough requests have completed.
+    ///
+    /// @throw D2QueueFileError if the file can't be written.
+    void sync();
+
+    /// @brief Records the completion of all the pending requests.
+    ///
+    /// The file is compacted, so it is left empty.
+    ///
+    /// @throw D2QueueFileError if the file is not open or can't be
+    /// written.
+    void clear();
+
+    /// @brief Rewrites the file with the pending requests only.
+    ///
+    /// @throw D2QueueFileError if the file can't be rewritten.
+    void compact();
+
+    /// @brief Returns the name of the file.
+    const std::string& getFilename() const {
+        return (filename_);
+    }
+
+    /// @brief Returns the number of requests not completed.
+    size_t getPendingCount() const {
+        return (pending_.size());
+    }
+
+    /// @brief Returns the number of completion records in the file.
+    size_t getCompletedCount() const {
+        return (completed_);
+    }
+
+private:
+    /// @brief Reads the records of the file.
+    ///
+    /// @return the number of records which couldn't be parsed.
+    size_t replay();
+
+    /// @brief Adds a record to the buffer, writing the buffer first if full.
+    void buffer(const std::string& record);
+
+    /// @brief Writes the buffered records to the file.
+    void flush();
+
+    /// @brief Writes data to a descriptor.
+    ///
+    /// @param fd the descriptor
+    /// @param data the data to write
+    /// @param name the name of the file written, for the errors
+    void writeAll(const int fd, const std::string& data,
+                  const std::string& name) const;
+
+    /// @brief Flushes a descriptor to the disk.
+    ///
+    /// @param fd the descriptor
+    /// @param name the name of the file flushed, for the errors
+    void syncFd(const int fd, const std::string& name) const;
+
+    /// @brief The name of the file.
+    std::string filename_;
+
+    /// @brief The descriptor of the file, -1 when it is closed.
+    int fd_;
+
+    /// @brief The records not written yet.
+    std::string buffer_;
+
+    /// @brief The number of records in the buffer.
+    size_t buffered_;
+
+    /// @brief The pending requests in JSON, by id.
+    std::map<uint64_t, std::string> pending_;
+
+    /// @brief The id of the next request.
+    uint64_t next_id_;
+
+    /// @brief The number of completion records in the file.
+    size_t completed_;
+};
+
+/// @brief Defines a pointer to a queue file.
+typedef boost::shared_ptr<D2QueueFile> D2QueueFilePtr;
+
+} // namespace bundy::d2
+} // namespace bundy
+
+#endif
@@ -15,6 +15,7 @@
 #include <d2/d2_log.h>
 #include <d2/d2_queue_mgr.h>
 #include <dhcp_ddns/ncr_udp.h>
+#include <dhcp_ddns/ncr_unix.h>
 
 namespace bundy {
 namespace d2 {
@@ -34,6 +35,7 @@ D2QueueMgr::D2QueueMgr(IOServicePtr& io_service, const size_t max_queue_size)
 }
 
 D2QueueMgr::~D2QueueMgr() {
+    // The queue file is written by its destructor.
 }
 
 void
@@ -56,11 +58,12 @@ D2QueueMgr::operator()(const dhcp_ddns::NameChangeListener::Result result,
                 return;
             }
 
-            // Queue is full, stop the listener.
+            // Queue is full, keep the request aside and stop the listener.
             // Note that we can move straight to a STOPPED state as there
             // is no receive in progress.
             LOG_ERROR(dctl_logger, DHCP_DDNS_QUEUE_MGR_QUEUE_FULL)
                       .arg(max_queue_size_);
+            overflow(ncr);
             stopListening(STOPPED_QUEUE_FULL);
             break;
 
@@ -115,6 +118,19 @@ D2QueueMgr::initUDPListener(const bundy::asiolink::IOAddress& ip_address,
     mgr_state_ = INITTED;
 }
 
+void
+D2QueueMgr::initUnixListener(const std::string& socket_path,
+                             const dhcp_ddns::NameChangeFormat format) {
+    if (listener_) {
+        bundy_throw(D2QueueMgrError,
+                  "D2QueueMgr listener is already initialized");
+    }
+
+    listener_.reset(new dhcp_ddns::
+                    NameChangeUnixListener(socket_path, format, *this));
+    mgr_state_ = INITTED;
+}
+
 void
 D2QueueMgr::startListening() {
     // We can't listen if we haven't initialized the listener yet.
@@ -130,6 +146,12 @@ D2QueueMgr::startListening() {
                   "cannot call startListening from the RUNNING state");
     }
 
+    // The requests received while the queue was full come first.
+    while (!overflow_.empty() && getQueueSize() < getMaxQueueSize()) {
+        ncr_queue_.push_back(overflow_.front());
+        overflow_.pop_front();
+    }
+
     // Instruct the listener to start listening and set state accordingly.
     try {
         listener_->startListening(*io_service_);
@@ -237,11 +259,143 @@ D2QueueMgr::dequeue() {
 void
 D2QueueMgr::enqueue(dhcp_ddns::NameChangeRequestPtr& ncr) {
     ncr_queue_.push_back(ncr);
+    if (queue_file_) {
+        // The request is still processed if it can't be recorded.
+        try {
+            queue_file_ids_[ncr] = queue_file_->append(*ncr);
+        } catch (const std::exception& ex) {
+            LOG_ERROR(dctl_logger, DHCP_DDNS_QUEUE_FILE_ERROR)
+                      .arg(queue_file_->getFilename()).arg(ex.what());
+        }
+    }
+}
+
+void
+D2QueueMgr::overflow(const dhcp_ddns::NameChangeRequestPtr& ncr) {
+    if (!queue_file_) {
+        LOG_ERROR(dctl_logger, DHCP_DDNS_QUEUE_MGR_REQUEST_DROPPED)
+                  .arg(ncr->toText());
+        return;
+    }
+
+    try {
+        queue_file_ids_[ncr] = queue_file_->append(*ncr);
+        overflow_.push_back(ncr);
+        LOG_INFO(dctl_logger, DHCP_DDNS_QUEUE_MGR_REQUEST_KEPT)
+                 .arg(ncr->toText());
+    } catch (const std::exception& ex) {
+        LOG_ERROR(dctl_logger, DHCP_DDNS_QUEUE_FILE_ERROR)
+                  .arg(queue_file_->getFilename()).arg(ex.what());
+        LOG_ERROR(dctl_logger, DHCP_DDNS_QUEUE_MGR_REQUEST_DROPPED)
+                  .arg(ncr->toText());
+    }
 }
 
 void
 D2QueueMgr::clearQueue() {
+    for (RequestQueue::const_iterator it = ncr_queue_.begin();
+         it != ncr_queue_.end(); ++it) {
+        complete(*it);
+    }
     ncr_queue_.clear();
+    for (RequestQueue::const_iterator it = overflow_.begin();
+         it != overflow_.end(); ++it) {
+        complete(*it);
+    }
+    overflow_.clear();
+}
+
+void
+D2QueueMgr::setQueueFile(const std::string& filename) {
+    if (getQueueFile() == filename) {
+        return;
+    }
+
+    // Open the new file first, so the current one stays in use if it
+    // can't be opened.
+    D2QueueFilePtr queue_file;
+    QueuedRequestList replayed;
+    if (!filename.empty()) {
+        queue_file.reset(new D2QueueFile(filename));
+        queue_file->open(replayed);
+    }
+
+    // The requests of the current file, and those queued, are recorded in
+    // the new one.
+    std::map<dhcp_ddns::NameChangeRequestPtr, uint64_t> ids;
+    if (queue_file) {
+        try {
+            for (std::map<dhcp_ddns::NameChangeRequestPtr, uint64_t>::
+                 const_iterator it = queue_file_ids_.begin();
+                 it != queue_file_ids_.end(); ++it) {
+                ids[it->first] = queue_file->append(*it->first);
+            }
+            for (RequestQueue::const_iterator it = ncr_queue_.begin();
+                 it != ncr_queue_.end(); ++it) {
+                if (!ids.count(*it)) {
+                    ids[*it] = queue_file->append(**it);
+                }
+            }
+            queue_file->sync();
+        } catch (...) {
+            // Don't leave the copies behind, they would be queued twice.
+            for (std::map<dhcp_ddns::NameChangeRequestPtr, uint64_t>::
+                 const_iterator it = ids.begin(); it != ids.end(); ++it) {
+                queue_file->complete(it->second);
+            }
+            throw;
+        }
+
+        for (QueuedRequestList::const_iterator it = replayed.begin();
+             it != replayed.end(); ++it) {
+            ncr_queue_.push_back(it->second);
+            ids[it->second] = it->first;
+        }
+    }
+
+    // Once they are safe in the new file (or in memory only if the file is
+    // no longer wanted), the requests are cleared from the old file, so
+    // they are not replayed if it is used again.
+    if (queue_file_) {
+        try {
+            queue_file_->clear();
+            queue_file_->close();
+        } catch (const std::exception& ex) {
+            LOG_ERROR(dctl_logger, DHCP_DDNS_QUEUE_FILE_ERROR)
+                      .arg(queue_file_->getFilename()).arg(ex.what());
+        }
+    }
+    queue_file_ = queue_file;
+    queue_file_ids_.swap(ids);
+}
+
+void
+D2QueueMgr::complete(const dhcp_ddns::NameChangeRequestPtr& ncr) {
+    std::map<dhcp_ddns::NameChangeRequestPtr, uint64_t>::iterator it =
+        queue_file_ids_.find(ncr);
+    if (it == queue_file_ids_.end()) {
+        return;
+    }
+
+    try {
+        queue_file_->complete(it->second);
+    } catch (const std::exception& ex) {
+        LOG_ERROR(dctl_logger, DHCP_DDNS_QUEUE_FILE_ERROR)
+                  .arg(queue_file_->getFilename()).arg(ex.what());
+    }
+    queue_file_ids_.erase(it);
+}
+
+void
+D2QueueMgr::syncQueueFile() {
+    if (queue_file_) {
+        try {
+            queue_file_->sync();
+        } catch (const std::exception& ex) {
+            LOG_ERROR(dctl_logger, DHCP_DDNS_QUEUE_FILE_ERROR)
+                      .arg(queue_file_->getFilename()).arg(ex.what());
+        }
+    }
 }
 
 void
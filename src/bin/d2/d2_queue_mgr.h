@@ -19,11 +19,14 @@
 
 #include <exceptions/exceptions.h>
 #include <d2/d2_asio.h>
+#include <d2/d2_queue_file.h>
 #include <dhcp_ddns/ncr_msg.h>
 #include <dhcp_ddns/ncr_io.h>
 
 #include <boost/noncopyable.hpp>
 #include <deque>
+#include <map>
+#include <string>
 
 namespace bundy {
 namespace d2 {
@@ -94,11 +97,10 @@ public:
 ///
 ///     * INITTED - The listener has been initialized, but it is not open for
 ///     listening.   To move from NOT_INITTED to INITTED, one of the D2QueueMgr
-///     listener initialization methods must be invoked.  Currently there is
-///     only one type of listener, NameChangeUDPListener, hence there is only
-///     one listener initialization method, initUDPListener.  As more listener
-///     types are created, listener initialization methods will need to be
-///     added.
+///     listener initialization methods must be invoked: initUDPListener for
+///     a NameChangeUDPListener, or initUnixListener for a
+///     NameChangeUnixListener.  As more listener types are created, listener
+///     initialization methods will need to be added.
 ///
 ///     * RUNNING - The listener is open and listening for requests.
 ///     Once initialized, in order to begin listening for requests, the
@@ -120,6 +122,9 @@ public:
 ///     listener will be closed and no further requests will be received.
 ///     To return to listening, startListener() must be invoked.  Note that so
 ///     long as the queue is full, any attempt to queue a request will fail.
+///     The request received while the queue is full is kept in the queue
+///     file, and queued by startListening(); without a queue file, it is
+///     dropped.
 ///
 ///     * STOPPED_RECV_ERROR - The listener has experienced a receive error
 ///     and has been stopped.  D2QueueMgr will enter this state when it is
@@ -134,6 +139,12 @@ public:
 /// until they are removed explicitly via the deque() or implicitly by
 /// via the clearQueue() method.
 ///
+/// The requests may also be kept in a queue file (see @c D2QueueFile), so
+/// they survive a restart.  Each request is recorded when it is queued and
+/// stays in the file until complete() is called for it, which the update
+/// manager does once its transaction has finished.  The requests found in
+/// the file when it is opened are queued again.
+///
 class D2QueueMgr : public dhcp_ddns::NameChangeListener::RequestReceiveHandler,
                    boost::noncopyable {
 public:
@@ -187,10 +198,25 @@ public:
                          const dhcp_ddns::NameChangeFormat format,
                          const bool reuse_address = false);
 
+    /// @brief Initializes the listener as a Unix domain socket listener.
+    ///
+    /// Instantiates the listener_ member as NameChangeUnixListener passing
+    /// the given parameters.  Upon successful completion, the D2QueueMgr state
+    /// will be INITTED.
+    ///
+    /// @param socket_path is the path of the socket on which to listen
+    /// @param format is the wire format of the inbound requests.
+    ///
+    /// @throw D2QueueMgrError if the listener is already initialized.
+    /// @throw dhcp_ddns::NcrUnixError if the path is invalid.
+    void initUnixListener(const std::string& socket_path,
+                          const dhcp_ddns::NameChangeFormat format);
+
     /// @brief Starts actively listening for requests.
     ///
     /// Invokes the listener's startListening method passing in our
-    /// IOService instance.
+    /// IOService instance.  The requests kept in the queue file while the
+    /// queue was full are queued first, as long as there is room.
     ///
     /// @throw D2QueueMgrError if the listener has not been initialized,
     /// state is already RUNNING, or the listener fails to actually start.
@@ -255,6 +281,12 @@ public:
         return (ncr_queue_.size());
     };
 
+    /// @brief Returns the number of requests kept in the queue file while
+    /// the queue was full.
+    size_t getOverflowSize() const {
+        return (overflow_.size());
+    }
+
     /// @brief Returns the maximum number of entries allowed in the queue.
     size_t getMaxQueueSize() const {
         return (max_queue_size_);
@@ -317,9 +349,56 @@ public:
     void enqueue(dhcp_ddns::NameChangeRequestPtr& ncr);
 
     /// @brief Removes all entries from the queue.
+    ///
+    /// The requests kept in the queue file while the queue was full are
+    /// removed too.  The requests removed are completed in the queue file.
     void clearQueue();
 
+    /// @brief Sets the file keeping the requests across restarts.
+    ///
+    /// The requests pending in the file are added to the end of the queue.
+    /// The requests in the queue, and those dequeued but not completed yet
+    /// if a file was already in use, are recorded in the new file.  They
+    /// are then completed in the old file, so they are not queued again if
+    /// it is used later.  Setting the name of the file in use is a no-op.
+    ///
+    /// @param filename is the name of the file, an empty name clears and
+    /// closes the current file and keeps the requests in memory only.
+    ///
+    /// @throw D2QueueFileError if the file can't be opened, in which case
+    /// the current file stays in use, or if the requests can't be recorded
+    /// in it.
+    void setQueueFile(const std::string& filename);
+
+    /// @brief Returns the name of the queue file, empty if there is none.
+    std::string getQueueFile() const {
+        return (queue_file_ ? queue_file_->getFilename() : "");
+    }
+
+    /// @brief Records that a request has been carried out.
+    ///
+    /// The request is removed from the queue file, so it is not queued
+    /// again after a restart.  It is a no-op without a queue file.
+    ///
+    /// @param ncr the request, as returned by peek() or peekAt()
+    void complete(const dhcp_ddns::NameChangeRequestPtr& ncr);
+
+    /// @brief Writes the queue file and flushes it to the disk.
+    ///
+    /// It is called once per event loop, so a single flush serves all the
+    /// requests received meanwhile.  Errors are logged.
+    void syncQueueFile();
+
   private:
+    /// @brief Handles a request received while the queue is full.
+    ///
+    /// The request is recorded in the queue file, to be queued by
+    /// startListening().  Without a queue file it is dropped.  Errors are
+    /// logged.
+    ///
+    /// @param ncr the request
+    void overflow(const dhcp_ddns::NameChangeRequestPtr& ncr);
+
     /// @brief Sets the manager state to the target stop state.
     ///
     /// Convenience method which sets the manager state to the target stop
@@ -335,6 +414,9 @@ public:
     /// @brief Queue of received NameChangeRequests.
     RequestQueue ncr_queue_;
 
+    /// @brief Requests received while the queue was full, in the queue file.
+    RequestQueue overflow_;
+
     /// @brief Listener instance from which requests are received.
     boost::shared_ptr<dhcp_ddns::NameChangeListener> listener_;
 
@@ -343,6 +425,12 @@ public:
 
     /// @brief Tracks the state the manager should be in once stopped.
     State target_stop_state_;
+
+    /// @brief The file keeping the requests, if any.
+    D2QueueFilePtr queue_file_;
+
+    /// @brief The ids of the requests in the queue file.
+    std::map<dhcp_ddns::NameChangeRequestPtr, uint64_t> queue_file_ids_;
 };
 
 /// @brief Defines a pointer for manager instances.
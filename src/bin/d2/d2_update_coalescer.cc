@@ -0,0 +1,308 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <d2/d2_log.h>
+#include <d2/d2_update_coalescer.h>
+
+#include <set>
+#include <sstream>
+#include <vector>
+
+namespace bundy {
+namespace d2 {
+
+/// @brief The updates of several transactions, merged into one message.
+class CoalescedUpdate : public DNSClient::Callback {
+public:
+    /// @brief Constructor
+    ///
+    /// @param owner the coalescer collecting the updates
+    /// @param server the server to send the message to
+    /// @param zone the zone of the updates
+    /// @param tsig_key_info the key signing the message, if any
+    /// @param connection_pool the pool of the TCP connections, if any
+    CoalescedUpdate(D2UpdateCoalescer& owner, const DnsServerInfoPtr& server,
+                    const D2ZonePtr& zone, const TSIGKeyInfoPtr& tsig_key_info,
+                    const asiodns::TCPConnectionPoolPtr& connection_pool)
+        : owner_(owner), server_(server), zone_(zone),
+          tsig_key_info_(tsig_key_info),
+          request_(new D2UpdateMessage(D2UpdateMessage::OUTBOUND)),
+          response_(), client_(new DNSClient(response_, this,
+                                             connection_pool ?
+                                             DNSClient::TCP : DNSClient::UDP,
+                                             connection_pool)) {
+        request_->setZone(zone->getName(), zone->getClass());
+    }
+
+    /// @brief Checks if the update of a name can be added to the message.
+    ///
+    /// @param names the names of the update
+    bool accepts(const std::set<dns::Name>& names) const {
+        for (std::set<dns::Name>::const_iterator name = names.begin();
+             name != names.end(); ++name) {
+            if (names_.count(*name)) {
+                return (false);
+            }
+        }
+        return (true);
+    }
+
+    /// @brief Adds the update of a transaction to the message.
+    ///
+    /// @param trans the transaction
+    /// @param names the names of the update
+    void add(NameChangeTransaction& trans, const std::set<dns::Name>& names) {
+        const D2UpdateMessagePtr& request = trans.getDnsUpdateRequest();
+        copySection(*request, D2UpdateMessage::SECTION_PREREQUISITE);
+        copySection(*request, D2UpdateMessage::SECTION_UPDATE);
+        names_.insert(names.begin(), names.end());
+        transactions_.push_back(&trans);
+    }
+
+    /// @brief DNSClient completion handler.
+    ///
+    /// @param status the outcome of the DNS packet exchange
+    virtual void operator()(DNSClient::Status status) {
+        owner_.completed(this, status);
+    }
+
+    /// @brief Returns a text describing the message, for logging.
+    std::string toText() const {
+        std::ostringstream stream;
+        stream << transactions_.size() << " names, zone: "
+               << zone_->getName().toText() << ", server: "
+               << server_->toText();
+        return (stream.str());
+    }
+
+    /// @brief The coalescer collecting the updates.
+    D2UpdateCoalescer& owner_;
+
+    /// @brief The server to send the message to.
+    DnsServerInfoPtr server_;
+
+    /// @brief The zone of the updates.
+    D2ZonePtr zone_;
+
+    /// @brief The key signing the message, if any.
+    TSIGKeyInfoPtr tsig_key_info_;
+
+    /// @brief The merged update.
+    D2UpdateMessagePtr request_;
+
+    /// @brief The response of the server.
+    D2UpdateMessagePtr response_;
+
+    /// @brief The DNSClient sending the message.
+    DNSClientPtr client_;
+
+    /// @brief The names updated by the message.
+    std::set<dns::Name> names_;
+
+    /// @brief The transactions waiting for the message.
+    std::vector<NameChangeTransaction*> transactions_;
+
+private:
+    /// @brief Copies a section of an update to the merged update.
+    void copySection(const D2UpdateMessage& request,
+                     const D2UpdateMessage::UpdateMsgSection section) {
+        for (dns::RRsetIterator rrset = request.beginSection(section);
+             rrset != request.endSection(section); ++rrset) {
+            request_->addRRset(section, *rrset);
+        }
+    }
+};
+
+namespace {
+
+/// @brief Returns the owner names of the RRsets of an update.
+std::set<dns::Name>
+getUpdatedNames(const D2UpdateMessage& request) {
+    std::set<dns::Name> names;
+    const D2UpdateMessage::UpdateMsgSection sections[] = {
+        D2UpdateMessage::SECTION_PREREQUISITE,
+        D2UpdateMessage::SECTION_UPDATE
+    };
+    for (size_t i = 0; i < sizeof(sections) / sizeof(sections[0]); ++i) {
+        for (dns::RRsetIterator rrset = request.beginSection(sections[i]);
+             rrset != request.endSection(sections[i]); ++rrset) {
+            names.insert((*rrset)->getName());
+        }
+    }
+    return (names);
+}
+
+}
+
+D2UpdateCoalescer::D2UpdateCoalescer(IOServicePtr& io_service,
+                                     const size_t max_names)
+    : io_service_(io_service), max_names_(max_names), connection_pool_() {
+    if (!io_service_) {
+        bundy_throw(NameChangeTransactionError, "IOServicePtr cannot be null");
+    }
+}
+
+D2UpdateCoalescer::~D2UpdateCoalescer() {
+    cancel();
+}
+
+bool
+D2UpdateCoalescer::add(NameChangeTransaction& trans) {
+    if (!isEnabled()) {
+        return (false);
+    }
+
+    const D2UpdateMessagePtr& request = trans.getDnsUpdateRequest();
+    const DnsServerInfoPtr& server = trans.getCurrentServer();
+    if (!request || !server) {
+        bundy_throw(NameChangeTransactionError,
+                  "coalesced update must have a request and a server");
+    }
+
+    const D2ZonePtr zone = request->getZone();
+    if (!zone) {
+        bundy_throw(NameChangeTransactionError,
+                  "coalesced update must have a zone");
+    }
+
+    // The updates signed with different keys are not merged.
+    const TSIGKeyInfoPtr& tsig_key_info = trans.getTSIGKeyInfo();
+    std::ostringstream key;
+    key << server->getIpAddress().toText() << "#" << server->getPort()
+        << "/" << zone->toText() << "/"
+        << (tsig_key_info ? tsig_key_info->getName() : "");
+
+    const std::set<dns::Name> names = getUpdatedNames(*request);
+    CoalescedUpdatePtr& update = pending_[key.str()];
+    if (update && !update->accepts(names)) {
+        // Another transaction updates the same name, send its update first.
+        send(update);
+        update.reset();
+    }
+
+    if (!update) {
+        update.reset(new CoalescedUpdate(*this, server, zone, tsig_key_info,
+                                         connection_pool_));
+    }
+
+    update->add(trans, names);
+    if (update->transactions_.size() >= max_names_) {
+        send(update);
+        pending_.erase(key.str());
+    }
+
+    return (true);
+}
+
+void
+D2UpdateCoalescer::flush() {
+    done_.clear();
+
+    // Take the list, in case the send of an update calls add() again.
+    std::map<std::string, CoalescedUpdatePtr> pending;
+    pending.swap(pending_);
+    for (std::map<std::string, CoalescedUpdatePtr>::const_iterator it =
+         pending.begin(); it != pending.end(); ++it) {
+        send(it->second);
+    }
+}
+
+void
+D2UpdateCoalescer::cancel() {
+    pending_.clear();
+    for (std::list<CoalescedUpdatePtr>::const_iterator it =
+         in_flight_.begin(); it != in_flight_.end(); ++it) {
+        (*it)->transactions_.clear();
+    }
+}
+
+size_t
+D2UpdateCoalescer::getPendingCount() const {
+    size_t count = 0;
+    for (std::map<std::string, CoalescedUpdatePtr>::const_iterator it =
+         pending_.begin(); it != pending_.end(); ++it) {
+        count += it->second->transactions_.size();
+    }
+    return (count);
+}
+
+size_t
+D2UpdateCoalescer::getInFlightCount() const {
+    return (in_flight_.size());
+}
+
+void
+D2UpdateCoalescer::send(const CoalescedUpdatePtr& update) {
+    in_flight_.push_back(update);
+    try {
+        if (update->tsig_key_info_) {
+            update->client_->doUpdate(*io_service_,
+                                      update->server_->getIpAddress(),
+                                      update->server_->getPort(),
+                                      *update->request_,
+                                      NameChangeTransaction::
+                                      DNS_UPDATE_DEFAULT_TIMEOUT,
+                                      update->tsig_key_info_->toTSIGKey());
+        } else {
+            update->client_->doUpdate(*io_service_,
+                                      update->server_->getIpAddress(),
+                                      update->server_->getPort(),
+                                      *update->request_,
+                                      NameChangeTransaction::
+                                      DNS_UPDATE_DEFAULT_TIMEOUT);
+        }
+        LOG_DEBUG(dctl_logger, DBGLVL_TRACE_DETAIL,
+                  DHCP_DDNS_COALESCED_UPDATE_SENT).arg(update->toText());
+    } catch (const std::exception& ex) {
+        // As for the transactions, a throw means the message can't be
+        // rendered.  Each transaction sends its own update, so only the
+        // faulty ones fail.
+        LOG_ERROR(dctl_logger, DHCP_DDNS_COALESCED_UPDATE_SEND_ERROR)
+                  .arg(update->toText()).arg(ex.what());
+        completed(update.get(), DNSClient::OTHER);
+    }
+}
+
+void
+D2UpdateCoalescer::completed(CoalescedUpdate* update,
+                             DNSClient::Status status) {
+    for (std::list<CoalescedUpdatePtr>::iterator it = in_flight_.begin();
+         it != in_flight_.end(); ++it) {
+        if (it->get() == update) {
+            done_.push_back(*it);
+            in_flight_.erase(it);
+            break;
+        }
+    }
+
+    // A message refused as a whole is retried name by name.
+    const bool shared = (update->transactions_.size() > 1);
+    if (shared && (status == DNSClient::SUCCESS) && update->response_ &&
+        (update->response_->getRcode() != dns::Rcode::NOERROR())) {
+        LOG_DEBUG(dctl_logger, DBGLVL_TRACE_DETAIL,
+                  DHCP_DDNS_COALESCED_UPDATE_REFUSED)
+                  .arg(update->toText())
+                  .arg(update->response_->getRcode().toText());
+    }
+
+    std::vector<NameChangeTransaction*> transactions;
+    transactions.swap(update->transactions_);
+    for (std::vector<NameChangeTransaction*>::const_iterator trans =
+         transactions.begin(); trans != transactions.end(); ++trans) {
+        (*trans)->onCoalescedUpdate(status, update->response_, shared);
+    }
+}
+
+} // namespace bundy::d2
+} // namespace bundy
@@ -0,0 +1,176 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef D2_UPDATE_COALESCER_H
+#define D2_UPDATE_COALESCER_H
+
+/// @file d2_update_coalescer.h This file defines the class D2UpdateCoalescer.
+
+#include <d2/d2_asio.h>
+#include <d2/nc_trans.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <list>
+#include <map>
+#include <string>
+
+namespace bundy {
+namespace d2 {
+
+class CoalescedUpdate;
+
+/// @brief Merges the DNS updates of several transactions into one message.
+///
+/// Without coalescing, each transaction sends its own DNS UPDATE and a
+/// storm of requests is served at one round trip per name.  When coalescing
+/// is enabled, the first attempt of each update is handed to the coalescer
+/// instead, which merges the updates sent to the same server for the same
+/// zone into a single message: the prerequisites and the updates of all the
+/// names are put in the prerequisite and update sections of the message.
+///
+/// RFC 2136 applies a message as a whole: if the prerequisite of any name
+/// fails, none of the names is updated.  The coalescer never merges two
+/// updates of the same name, as their prerequisites would be checked
+/// together before either update is applied.  If the server responds
+/// with anything else than NOERROR to a merged update, each transaction
+/// sends its own update again, so the transactions whose prerequisites
+/// fail take their usual path (e.g. replacing the addresses of a name in
+/// use) and the others still complete.  IO errors are given to each
+/// transaction as the outcome of its first attempt.
+///
+/// The updates signed with different TSIG keys are never merged, the message
+/// is signed with the key of its updates.
+///
+/// The updates are collected while the transactions run and the merged
+/// messages are sent by flush(), which D2UpdateMgr calls on each sweep.
+class D2UpdateCoalescer : public boost::noncopyable {
+public:
+    /// @brief Constructor
+    ///
+    /// @param io_service IO service used to send the merged updates
+    /// @param max_names maximum number of names in one message, values
+    /// lower than two disable coalescing
+    D2UpdateCoalescer(IOServicePtr& io_service, const size_t max_names = 1);
+
+    /// @brief Destructor
+    ~D2UpdateCoalescer();
+
+    /// @brief Returns the maximum number of names in one message.
+    size_t getMaxNames() const {
+        return (max_names_);
+    }
+
+    /// @brief Sets the maximum number of names in one message.
+    ///
+    /// The updates collected so far are sent by the next flush().
+    ///
+    /// @param max_names the new maximum, values lower than two disable
+    /// coalescing
+    void setMaxNames(const size_t max_names) {
+        max_names_ = max_names;
+    }
+
+    /// @brief Sets the pool of the TCP connections to the servers.
+    ///
+    /// It is used by the messages created afterwards.
+    ///
+    /// @param connection_pool the pool, or an empty pointer to send the
+    /// messages over UDP
+    void setConnectionPool(const asiodns::TCPConnectionPoolPtr&
+                           connection_pool) {
+        connection_pool_ = connection_pool;
+    }
+
+    /// @brief Returns true if the coalescing is enabled.
+    bool isEnabled() const {
+        return (max_names_ > 1);
+    }
+
+    /// @brief Takes the current update of a transaction.
+    ///
+    /// The update is the current request of the transaction, sent to its
+    /// current server.  The transaction waits until the merged update has
+    /// completed, at which point its onCoalescedUpdate() method is called.
+    ///
+    /// If the message collecting the updates for the server and zone is
+    /// full, or already holds an update of one of the names, it is sent
+    /// and the update is put in a new message.
+    ///
+    /// @param trans the transaction
+    ///
+    /// @return false if the coalescing is disabled, in which case the
+    /// transaction must send its update itself.
+    ///
+    /// @throw NameChangeTransactionError if the transaction has no request
+    /// or no server.
+    bool add(NameChangeTransaction& trans);
+
+    /// @brief Sends all the updates collected.
+    void flush();
+
+    /// @brief Forgets all the transactions.
+    ///
+    /// The updates collected are discarded and the transactions waiting
+    /// on the messages in flight are not called anymore.  It must be called
+    /// before the transactions are destroyed.
+    void cancel();
+
+    /// @brief Returns the number of the updates waiting for flush().
+    size_t getPendingCount() const;
+
+    /// @brief Returns the number of the messages sent and not completed.
+    size_t getInFlightCount() const;
+
+    /// @brief Completion handler of the merged updates.
+    ///
+    /// @param update the merged update
+    /// @param status the outcome of the DNS packet exchange
+    void completed(CoalescedUpdate* update, DNSClient::Status status);
+
+private:
+    /// @brief Pointer to a merged update.
+    typedef boost::shared_ptr<CoalescedUpdate> CoalescedUpdatePtr;
+
+    /// @brief Sends a merged update.
+    ///
+    /// @param update the update to send
+    void send(const CoalescedUpdatePtr& update);
+
+    /// @brief IO service used to send the updates.
+    IOServicePtr io_service_;
+
+    /// @brief Maximum number of names in one message.
+    size_t max_names_;
+
+    /// @brief The pool of the TCP connections, if any.
+    asiodns::TCPConnectionPoolPtr connection_pool_;
+
+    /// @brief The updates collected, by server and zone.
+    std::map<std::string, CoalescedUpdatePtr> pending_;
+
+    /// @brief The updates sent.
+    std::list<CoalescedUpdatePtr> in_flight_;
+
+    /// @brief The updates completed.
+    ///
+    /// They are destroyed by the next flush(), outside of the callback of
+    /// their DNSClient.
+    std::list<CoalescedUpdatePtr> done_;
+};
+
+} // namespace bundy::d2
+} // namespace bundy
+#endif
@@ -108,7 +108,8 @@ D2UpdateMessage::addRRset(const UpdateMsgSection section,
 }
 
 void
-D2UpdateMessage::toWire(AbstractMessageRenderer& renderer) {
+D2UpdateMessage::toWire(AbstractMessageRenderer& renderer,
+                        TSIGContext* const tsig_ctx) {
     // We are preparing the wire format of the message, meaning
     // that this message will be sent as a request to the DNS.
     // Therefore, we expect that this message is a REQUEST.
@@ -122,7 +123,7 @@ D2UpdateMessage::toWire(AbstractMessageRenderer& renderer) {
         bundy_throw(InvalidZoneSection, "Zone section of the DNS Update message"
                   " must comprise exactly one record (RFC2136, section 2.3)");
     }
-    message_.toWire(renderer);
+    message_.toWire(renderer, tsig_ctx);
 }
 
 void
@@ -161,6 +162,11 @@ D2UpdateMessage::fromWire(bundy::util::InputBuffer& buffer) {
     validateResponse();
 }
 
+const dns::TSIGRecord*
+D2UpdateMessage::getTSIGRecord() const {
+    return (message_.getTSIGRecord());
+}
+
 dns::Message::Section
 D2UpdateMessage::ddnsToDnsSection(const UpdateMsgSection section) {
     /// The following switch maps the enumerator values from the
@@ -260,7 +260,10 @@ public:
     ///
     /// @param renderer A renderer object used to generate the message wire
     /// format.
-    void toWire(dns::AbstractMessageRenderer& renderer);
+    /// @param tsig_ctx A TSIG context used to sign the message, or NULL if
+    /// the message is not signed.
+    void toWire(dns::AbstractMessageRenderer& renderer,
+                dns::TSIGContext* const tsig_ctx = NULL);
 
     /// @brief Decode incoming message from the wire format.
     ///
@@ -284,6 +287,12 @@ public:
     ///
     /// @param buffer input buffer, holding DNS Update message to be parsed.
     void fromWire(bundy::util::InputBuffer& buffer);
+
+    /// @brief Returns the TSIG record of an incoming message.
+    ///
+    /// @return A pointer to the TSIG record of the message parsed by
+    /// @c D2UpdateMessage::fromWire, or NULL if the message is not signed.
+    const dns::TSIGRecord* getTSIGRecord() const;
     //@}
 
 private:
@@ -28,7 +28,8 @@ const size_t D2UpdateMgr::MAX_TRANSACTIONS_DEFAULT;
 D2UpdateMgr::D2UpdateMgr(D2QueueMgrPtr& queue_mgr, D2CfgMgrPtr& cfg_mgr,
                          IOServicePtr& io_service,
                          const size_t max_transactions)
-    :queue_mgr_(queue_mgr), cfg_mgr_(cfg_mgr), io_service_(io_service) {
+    :queue_mgr_(queue_mgr), cfg_mgr_(cfg_mgr), io_service_(io_service),
+     coalescer_(), connection_pool_() {
     if (!queue_mgr_) {
         bundy_throw(D2UpdateMgrError, "D2UpdateMgr queue manager cannot be null");
     }
@@ -44,10 +45,14 @@ D2UpdateMgr::D2UpdateMgr(D2QueueMgrPtr& queue_mgr, D2CfgMgrPtr& cfg_mgr,
 
     // Use setter to do validation.
     setMaxTransactions(max_transactions);
+
+    coalescer_.reset(new D2UpdateCoalescer(io_service_));
 }
 
 D2UpdateMgr::~D2UpdateMgr() {
+    coalescer_->cancel();
     transaction_list_.clear();
+    connection_pool_.reset();
 }
 
 void D2UpdateMgr::sweep() {
@@ -61,17 +66,33 @@ void D2UpdateMgr::sweep() {
     // system will generate many IO events and this method will be called
     // frequently.  It will likely achieve max transactions quickly on its own.
     if (getQueueCount() > 0)  {
-        if (getTransactionCount() >= max_transactions_) {
+        // When the updates are coalesced, each transaction slot may carry
+        // as many names as a message.
+        const size_t max_transactions = coalescer_->isEnabled() ?
+            max_transactions_ * coalescer_->getMaxNames() : max_transactions_;
+        if (getTransactionCount() >= max_transactions) {
             LOG_DEBUG(dctl_logger, DBGLVL_TRACE_DETAIL_DATA,
                       DHCP_DDNS_AT_MAX_TRANSACTIONS).arg(getQueueCount())
-                      .arg(getMaxTransactions());
-
-            return;
+                      .arg(max_transactions);
+        } else if (connection_pool_ && connection_pool_->isSaturated()) {
+            // The servers don't keep up, adding transactions would only
+            // lengthen the queues of the connections.
+            LOG_DEBUG(dctl_logger, DBGLVL_TRACE_DETAIL_DATA,
+                      DHCP_DDNS_CONNECTIONS_SATURATED)
+                      .arg(connection_pool_->getPendingCount());
+        } else if (pickNextJob() && coalescer_->isEnabled()) {
+            // Start the other jobs now, so their updates are merged.
+            while ((getTransactionCount() < max_transactions) &&
+                   (getQueueCount() > 0) &&
+                   !(connection_pool_ && connection_pool_->isSaturated()) &&
+                   pickNextJob()) {
+            }
         }
-
-        // We are not at maximum transactions, so pick and start the next job.
-        pickNextJob();
     }
+
+    // Send the updates collected by the coalescer, including those of the
+    // transactions which moved on during the last IO events.
+    coalescer_->flush();
 }
 
 void
@@ -90,6 +111,8 @@ D2UpdateMgr::checkFinishedTransactions() {
         if (trans->isModelDone()) {
             // @todo  Addtional actions based on NCR status could be
             // performed here.
+            // The request is not replayed after a restart.
+            queue_mgr_->complete(trans->getNcr());
             transaction_list_.erase(it++);
         } else {
             ++it;
@@ -97,7 +120,7 @@ D2UpdateMgr::checkFinishedTransactions() {
     }
 }
 
-void D2UpdateMgr::pickNextJob() {
+bool D2UpdateMgr::pickNextJob() {
     // Start at the front of the queue, looking for the first entry for
     // which no transaction is in progress.  If we find an eligible entry
     // remove it from the queue and  make a transaction for it.
@@ -110,7 +133,11 @@ void D2UpdateMgr::pickNextJob() {
         if (!hasTransaction(found_ncr->getDhcid())) {
             queue_mgr_->dequeueAt(index);
             makeTransaction(found_ncr);
-            return;
+            // A request dropped on the floor is done with as well.
+            if (!hasTransaction(found_ncr->getDhcid())) {
+                queue_mgr_->complete(found_ncr);
+            }
+            return (true);
         }
     }
 
@@ -118,6 +145,7 @@ void D2UpdateMgr::pickNextJob() {
     // transactions pending.
     LOG_DEBUG(dctl_logger, DBGLVL_TRACE_DETAIL_DATA, DHCP_DDNS_NO_ELIGIBLE_JOBS)
               .arg(getQueueCount()).arg(getTransactionCount());
+    return (false);
 }
 
 void
@@ -201,6 +229,12 @@ D2UpdateMgr::makeTransaction(dhcp_ddns::NameChangeRequestPtr& next_ncr) {
                                               forward_domain, reverse_domain));
     }
 
+    // Updates are merged if coalescing is enabled, signed with the keys of
+    // the domains and sent over TCP if the connection pool is set up.
+    trans->setUpdateCoalescer(coalescer_);
+    trans->setConnectionPool(connection_pool_);
+    trans->setTSIGKeys(cfg_mgr_->getD2CfgContext()->getKeys());
+
     // Add the new transaction to the list.
     transaction_list_[key] = trans;
 
@@ -240,6 +274,7 @@ void
 D2UpdateMgr::clearTransactionList() {
     // @todo for now this just wipes them out. We might need something
     // more elegant, that allows a cancel first.
+    coalescer_->cancel();
     transaction_list_.clear();
 }
 
@@ -261,6 +296,27 @@ D2UpdateMgr::setMaxTransactions(const size_t new_trans_max) {
     max_transactions_ = new_trans_max;
 }
 
+void
+D2UpdateMgr::setMaxCoalescedNames(const size_t max_names) {
+    coalescer_->setMaxNames(max_names);
+}
+
+void
+D2UpdateMgr::setDNSProtocol(const DNSClient::Protocol protocol) {
+    if (protocol == getDNSProtocol()) {
+        return;
+    }
+
+    // The transactions in progress keep the pool they were given, it is
+    // closed when the last of them completes.
+    if (protocol == DNSClient::TCP) {
+        connection_pool_.reset(new asiodns::TCPConnectionPool(*io_service_));
+    } else {
+        connection_pool_.reset();
+    }
+    coalescer_->setConnectionPool(connection_pool_);
+}
+
 size_t
 D2UpdateMgr::getQueueCount() const {
     return (queue_mgr_->getQueueSize());
@@ -22,6 +22,8 @@
 #include <d2/d2_log.h>
 #include <d2/d2_queue_mgr.h>
 #include <d2/d2_cfg_mgr.h>
+#include <d2/d2_update_coalescer.h>
+#include <asiodns/tcp_connection_pool.h>
 #include <d2/nc_trans.h>
 
 #include <boost/noncopyable.hpp>
@@ -70,6 +72,11 @@ typedef std::map<TransactionKey, NameChangeTransactionPtr> TransactionList;
 /// The upper layer(s) are responsible for calling sweep in a timely and cyclic
 /// manner.
 ///
+/// Optionally, the DNS updates of the transactions for the same zone and
+/// server may be merged into one message by a D2UpdateCoalescer, see
+/// setMaxCoalescedNames().  The merged updates are sent at the end of
+/// each sweep().
+///
 class D2UpdateMgr : public boost::noncopyable {
 public:
     /// @brief Maximum number of concurrent transactions
@@ -120,6 +127,13 @@ public:
     ///
     /// - If a request was selected, start a new transaction for it and
     /// add the transaction to the list of transactions.
+    ///
+    /// When the updates are coalesced, as many transactions as allowed are
+    /// started and the updates they collected are sent.
+    ///
+    /// When the updates are sent over TCP and the connections to a server
+    /// are saturated, no transaction is started: the requests stay in the
+    /// queue until the servers have answered the updates in flight.
     void sweep();
 
 protected:
@@ -143,7 +157,9 @@ protected:
     /// It is possible that no such request exists, though this is likely to be
     /// rather rare unless a system is frequently seeing requests for the same
     /// clients in quick succession.
-    void pickNextJob();
+    ///
+    /// @return True if a request was selected.
+    bool pickNextJob();
 
     /// @brief Create a new transaction for the given request.
     ///
@@ -191,6 +207,47 @@ public:
     /// queue.
     void setMaxTransactions(const size_t max_transactions);
 
+    /// @brief Returns the maximum number of names in one DNS update.
+    size_t getMaxCoalescedNames() const {
+        return (coalescer_->getMaxNames());
+    }
+
+    /// @brief Sets the maximum number of names in one DNS update.
+    ///
+    /// With a value greater than one, the updates of the transactions for
+    /// the same zone and server are merged into one message.  Each of the
+    /// maximum transactions may then carry as many names: the number of
+    /// concurrent transactions is limited to the product of the two
+    /// maximums, rather than to the maximum transactions alone.
+    ///
+    /// @param max_names is the new maximum, one (the default) disables
+    /// coalescing.
+    void setMaxCoalescedNames(const size_t max_names);
+
+    /// @brief Returns the protocol used to send the DNS updates.
+    DNSClient::Protocol getDNSProtocol() const {
+        return (connection_pool_ ? DNSClient::TCP : DNSClient::UDP);
+    }
+
+    /// @brief Sets the protocol used to send the DNS updates.
+    ///
+    /// Over TCP, the updates are pipelined on a persistent connection to
+    /// each server, see @c asiodns::TCPConnectionPool.  The new protocol is used by the
+    /// transactions started afterwards, those in progress keep theirs.
+    ///
+    /// @param protocol is the new protocol
+    void setDNSProtocol(const DNSClient::Protocol protocol);
+
+    /// @brief Returns the pool of the TCP connections, empty over UDP.
+    const asiodns::TCPConnectionPoolPtr& getConnectionPool() const {
+        return (connection_pool_);
+    }
+
+    /// @brief Returns the coalescer merging the updates.
+    const D2UpdateCoalescerPtr& getUpdateCoalescer() const {
+        return (coalescer_);
+    }
+
     /// @brief Search the transaction list for the given key.
     ///
     /// @param key the transaction key value for which to search.
@@ -253,6 +310,12 @@ private:
 
     /// @brief List of transactions.
     TransactionList transaction_list_;
+
+    /// @brief Merges the DNS updates of the transactions.
+    D2UpdateCoalescerPtr coalescer_;
+
+    /// @brief The TCP connections to the servers, only used over TCP.
+    asiodns::TCPConnectionPoolPtr connection_pool_;
 };
 
 /// @brief Defines a pointer to a D2UpdateMgr instance.
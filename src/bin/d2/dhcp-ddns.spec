@@ -24,6 +24,36 @@
         "item_optional": true,
         "item_default": 53001 
     },
+    {
+        "item_name": "max_coalesced_names",
+        "item_type": "integer",
+        "item_optional": true,
+        "item_default": 1
+    },
+    {
+        "item_name": "dns_protocol",
+        "item_type": "string",
+        "item_optional": true,
+        "item_default": "UDP"
+    },
+    {
+        "item_name": "queue_file",
+        "item_type": "string",
+        "item_optional": true,
+        "item_default": ""
+    },
+    {
+        "item_name": "ncr_format",
+        "item_type": "string",
+        "item_optional": true,
+        "item_default": "JSON"
+    },
+    {
+        "item_name": "ncr_socket",
+        "item_type": "string",
+        "item_optional": true,
+        "item_default": ""
+    },
     {
         "item_name": "tsig_keys",
         "item_type": "list",
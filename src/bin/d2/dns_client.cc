@@ -15,6 +15,7 @@
 #include <d2/dns_client.h>
 #include <d2/d2_log.h>
 #include <dns/messagerenderer.h>
+#include <boost/scoped_ptr.hpp>
 #include <limits>
 
 namespace bundy {
@@ -37,9 +38,10 @@ using namespace bundy::dns;
 // This class provides the implementation for the DNSClient. This allows for
 // the separation of the DNSClient interface from the implementation details.
 // Currently, implementation uses IOFetch object to handle asynchronous
-// communication with the DNS. This design may be revisited in the future. If
-// implementation is changed, the DNSClient API will remain unchanged thanks
-// to this separation.
+// communication with the DNS. Over TCP, the IOFetch sends the message through
+// a pool of persistent connections. This design may be revisited in the
+// future. If implementation is changed, the DNSClient API will remain
+// unchanged thanks to this separation.
 class DNSClientImpl : public asiodns::IOFetch::Callback {
 public:
     // A buffer holding response from a DNS.
@@ -60,11 +62,17 @@ public:
     DNSClient::Callback* callback_;
     // A Transport Layer protocol used to communicate with a DNS.
     DNSClient::Protocol proto_;
+    // The pool of the TCP connections, only used with TCP.
+    TCPConnectionPoolPtr connection_pool_;
+    // The TSIG context of the last request, if it was signed. It is used to
+    // verify the signature of the response.
+    boost::scoped_ptr<dns::TSIGContext> tsig_context_;
 
     // Constructor and Destructor
     DNSClientImpl(D2UpdateMessagePtr& response_placeholder,
                   DNSClient::Callback* callback,
-                  const DNSClient::Protocol proto);
+                  const DNSClient::Protocol proto,
+                  const TCPConnectionPoolPtr& connection_pool);
     virtual ~DNSClientImpl();
 
     // This internal callback is called when the DNS update message exchange is
@@ -73,12 +81,18 @@ public:
     // type, representing a response from the server is set.
     virtual void operator()(asiodns::IOFetch::Result result);
 
-    // Starts asynchronous DNS Update.
+    // Starts asynchronous DNS Update, signed if a TSIG key is given.
     void doUpdate(asiolink::IOService& io_service,
                   const asiolink::IOAddress& ns_addr,
                   const uint16_t ns_port,
                   D2UpdateMessage& update,
-                  const unsigned int wait);
+                  const unsigned int wait,
+                  const dns::TSIGKey* tsig_key);
+
+    // Parses the response and verifies its signature, then invokes the
+    // external callback.
+    void complete(DNSClient::Status status, const uint8_t* data,
+                  size_t length);
 
     // This function maps the IO error to the DNSClient error.
     DNSClient::Status getStatus(const asiodns::IOFetch::Result);
@@ -86,9 +100,11 @@ public:
 
 DNSClientImpl::DNSClientImpl(D2UpdateMessagePtr& response_placeholder,
                              DNSClient::Callback* callback,
-                             const DNSClient::Protocol proto)
+                             const DNSClient::Protocol proto,
+                             const TCPConnectionPoolPtr& connection_pool)
     : in_buf_(new OutputBuffer(DEFAULT_BUFFER_SIZE)),
-      response_(response_placeholder), callback_(callback), proto_(proto) {
+      response_(response_placeholder), callback_(callback), proto_(proto),
+      connection_pool_(connection_pool), tsig_context_() {
 
     // Response should be an empty pointer. It gets populated by the
     // operator() method.
@@ -96,17 +112,13 @@ DNSClientImpl::DNSClientImpl(D2UpdateMessagePtr& response_placeholder,
         bundy_throw(bundy::BadValue, "Response buffer pointer should be null");
     }
 
-    // @todo Currently we only support UDP. The support for TCP is planned for
-    // the future release.
-    if (proto_ == DNSClient::TCP) {
-        bundy_throw(bundy::NotImplemented, "TCP is currently not supported as a"
-                  << " Transport protocol for DNS Updates; please use UDP");
+    // TCP is only supported through the persistent connections of a pool.
+    if ((proto_ == DNSClient::TCP) && !connection_pool_) {
+        bundy_throw(bundy::NotImplemented, "TCP is only supported as a"
+                  << " Transport protocol for DNS Updates with a connection"
+                  << " pool; please use UDP");
     }
 
-    // Given that we already eliminated the possibility that TCP is used, it
-    // would be sufficient  to check that (proto != DNSClient::UDP). But, once
-    // support TCP is added the check above will disappear and the extra check
-    // will be needed here anyway.
     // Note that cascaded check is used here instead of:
     //   if (proto_ != DNSClient::TCP && proto_ != DNSClient::UDP)..
     // because some versions of GCC compiler complain that check above would
@@ -128,9 +140,15 @@ void
 DNSClientImpl::operator()(asiodns::IOFetch::Result result) {
     // Get the status from IO. If no success, we just call user's callback
     // and pass the status code.
-    DNSClient::Status status = getStatus(result);
+    complete(getStatus(result), static_cast<const uint8_t*>(in_buf_->getData()),
+             in_buf_->getLength());
+}
+
+void
+DNSClientImpl::complete(DNSClient::Status status, const uint8_t* data,
+                        size_t length) {
     if (status == DNSClient::SUCCESS) {
-        InputBuffer response_buf(in_buf_->getData(), in_buf_->getLength());
+        InputBuffer response_buf(data, length);
         // Allocate a new response message. (Note that Message::fromWire
         // may only be run once per message, so we need to start fresh
         // each time.)
@@ -150,6 +168,18 @@ DNSClientImpl::operator()(asiodns::IOFetch::Result result) {
         }
     }
 
+    // The response to a signed request must be signed with the same key.
+    if ((status == DNSClient::SUCCESS) && tsig_context_) {
+        const TSIGError error = tsig_context_->verify(response_->
+                                                      getTSIGRecord(),
+                                                      data, length);
+        if (error != TSIGError::NOERROR()) {
+            status = DNSClient::INVALID_RESPONSE;
+            LOG_DEBUG(dctl_logger, DBGLVL_TRACE_DETAIL,
+                      DHCP_DDNS_RESPONSE_TSIG_ERROR).arg(error.toText());
+        }
+    }
+
     // Once we are done with internal business, let's call a callback supplied
     // by a caller.
     if (callback_ != NULL) {
@@ -180,7 +210,12 @@ DNSClientImpl::doUpdate(asiolink::IOService& io_service,
                         const IOAddress& ns_addr,
                         const uint16_t ns_port,
                         D2UpdateMessage& update,
-                        const unsigned int wait) {
+                        const unsigned int wait,
+                        const dns::TSIGKey* tsig_key) {
+    // Each request has its own TSIG context, which also verifies the
+    // response.
+    tsig_context_.reset(tsig_key ? new TSIGContext(*tsig_key) : NULL);
+
     // A renderer is used by the toWire function which creates the on-wire data
     // from the DNS Update message. A renderer has its internal buffer where it
     // renders data by default. However, this buffer can't be directly accessed.
@@ -193,7 +228,7 @@ DNSClientImpl::doUpdate(asiolink::IOService& io_service,
 
     // Render DNS Update message. This may throw a bunch of exceptions if
     // invalid message object is given.
-    update.toWire(renderer);
+    update.toWire(renderer, tsig_context_.get());
 
     // IOFetch has all the mechanisms that we need to perform asynchronous
     // communication with the DNS server. The last but one argument points to
@@ -203,8 +238,16 @@ DNSClientImpl::doUpdate(asiolink::IOService& io_service,
     // Timeout value is explicitly cast to the int type to avoid warnings about
     // overflows when doing implicit cast. It should have been checked by the
     // caller that the unsigned timeout value will fit into int.
-    IOFetch io_fetch(IOFetch::UDP, io_service, msg_buf, ns_addr, ns_port,
-                     in_buf_, this, static_cast<int>(wait));
+    IOFetch io_fetch(proto_ == DNSClient::TCP ? IOFetch::TCP : IOFetch::UDP,
+                     io_service, msg_buf, ns_addr, ns_port, in_buf_, this,
+                     static_cast<int>(wait));
+
+    // Over TCP, the message is pipelined with the other messages sent to the
+    // server. The pool may change the message id, which doesn't break the
+    // signature as TSIG covers the original id.
+    if (proto_ == DNSClient::TCP) {
+        io_fetch.setConnectionPool(connection_pool_);
+    }
 
     // Post the task to the task queue in the IO service. Caller will actually
     // run these tasks by executing IOService::run.
@@ -213,8 +256,10 @@ DNSClientImpl::doUpdate(asiolink::IOService& io_service,
 
 
 DNSClient::DNSClient(D2UpdateMessagePtr& response_placeholder,
-                     Callback* callback, const DNSClient::Protocol proto)
-    : impl_(new DNSClientImpl(response_placeholder, callback, proto)) {
+                     Callback* callback, const DNSClient::Protocol proto,
+                     const TCPConnectionPoolPtr& connection_pool)
+    : impl_(new DNSClientImpl(response_placeholder, callback, proto,
+                              connection_pool)) {
 }
 
 DNSClient::~DNSClient() {
@@ -228,14 +273,18 @@ DNSClient::getMaxTimeout() {
 }
 
 void
-DNSClient::doUpdate(asiolink::IOService&,
-                    const IOAddress&,
-                    const uint16_t,
-                    D2UpdateMessage&,
-                    const unsigned int,
-                    const dns::TSIGKey&) {
-    bundy_throw(bundy::NotImplemented, "TSIG is currently not supported for"
-              "DNS Update message");
+DNSClient::doUpdate(asiolink::IOService& io_service,
+                    const IOAddress& ns_addr,
+                    const uint16_t ns_port,
+                    D2UpdateMessage& update,
+                    const unsigned int wait,
+                    const dns::TSIGKey& tsig_key) {
+    if (wait > getMaxTimeout()) {
+        bundy_throw(bundy::BadValue, "A timeout value for DNS Update request must"
+                  " not exceed " << getMaxTimeout()
+                  << ". Provided timeout value is '" << wait << "'");
+    }
+    impl_->doUpdate(io_service, ns_addr, ns_port, update, wait, &tsig_key);
 }
 
 void
@@ -252,7 +301,7 @@ DNSClient::doUpdate(asiolink::IOService& io_service,
                   " not exceed " << getMaxTimeout()
                   << ". Provided timeout value is '" << wait << "'");
     }
-    impl_->doUpdate(io_service, ns_addr, ns_port, update, wait);
+    impl_->doUpdate(io_service, ns_addr, ns_port, update, wait, NULL);
 }
 
 
@@ -47,13 +47,20 @@ class DNSClientImpl;
 /// encapsulate DNS response, through class constructor. An exception will be
 /// thrown if the pointer is not initialized by the caller.
 ///
-/// @todo Ultimately, this class will support both TCP and UDP Transport.
-/// Currently only UDP is supported and can be specified as a preferred
-/// protocol. @c DNSClient constructor will throw an exception if TCP is
-/// specified. Once both protocols are supported, the @c DNSClient logic will
-/// try to obey caller's preference. However, it may use the other protocol if
-/// on its own discretion, when there is a legitimate reason to do so. For
-/// example, if communication with the server using preferred protocol fails.
+/// Over UDP, each DNS Update is an independent exchange. TCP is supported
+/// through a @c asiodns::TCPConnectionPool, which keeps the connections to
+/// the servers open and pipelines the DNS Updates of all the clients sharing
+/// it. The
+/// @c DNSClient constructor will throw an exception if TCP is specified
+/// without a pool.
+///
+/// The DNS Updates may be signed with a TSIG key, in which case the
+/// signature of the response is verified too. A response which fails the
+/// verification is reported as @c DNSClient::INVALID_RESPONSE.
+///
+/// @todo The @c DNSClient logic could use the other protocol on its own
+/// discretion, when there is a legitimate reason to do so. For example, if
+/// communication with the server using preferred protocol fails.
 class DNSClient {
 public:
 
@@ -100,8 +107,14 @@ public:
     /// if an error occurs. NULL value disables callback invocation.
     /// @param proto caller's preference regarding Transport layer protocol to
     /// be used by DNS Client to communicate with a server.
+    /// @param connection_pool Pool of the TCP connections, required with
+    /// TCP.
+    ///
+    /// @throw bundy::NotImplemented if TCP is specified without a pool.
     DNSClient(D2UpdateMessagePtr& response_placeholder, Callback* callback,
-              const Protocol proto = UDP);
+              const Protocol proto = UDP,
+              const asiodns::TCPConnectionPoolPtr& connection_pool =
+              asiodns::TCPConnectionPoolPtr());
 
     /// @brief Virtual destructor, does nothing.
     ~DNSClient();
@@ -147,10 +160,8 @@ public:
     /// is not received within the timeout, exchange is interrupted. This value
     /// must not exceed maximal value for 'int' data type.
     /// @param tsig_key An @c bundy::dns::TSIGKey object representing TSIG
-    /// context which will be used to render the DNS Update message.
-    ///
-    /// @todo Implement TSIG Support. Currently any attempt to call this
-    /// function will result in exception.
+    /// context which will be used to render the DNS Update message and to
+    /// verify the response.
     void doUpdate(asiolink::IOService& io_service,
                   const asiolink::IOAddress& ns_addr,
                   const uint16_t ns_port,
@@ -13,6 +13,7 @@
 // PERFORMANCE OF THIS SOFTWARE.
 
 #include <d2/d2_log.h>
+#include <d2/d2_update_coalescer.h>
 #include <d2/nc_trans.h>
 #include <dns/rdata.h>
 
@@ -54,7 +55,8 @@ NameChangeTransaction(IOServicePtr& io_service,
      dns_update_status_(DNSClient::OTHER), dns_update_response_(),
      forward_change_completed_(false), reverse_change_completed_(false),
      current_server_list_(), current_server_(), next_server_pos_(0),
-     update_attempts_(0) {
+     update_attempts_(0), coalescer_(), connection_pool_(), tsig_keys_(),
+     tsig_key_info_(), send_alone_(false) {
     // @todo if io_service is NULL we are multi-threading and should
     // instantiate our own
     if (!io_service_) {
@@ -106,6 +108,42 @@ NameChangeTransaction::operator()(DNSClient::Status status) {
     runModel(IO_COMPLETED_EVT);
 }
 
+void
+NameChangeTransaction::onCoalescedUpdate(DNSClient::Status status,
+                                         const D2UpdateMessagePtr& response,
+                                         bool shared) {
+    if (shared && (status == DNSClient::SUCCESS) && response &&
+        (response->getRcode() != dns::Rcode::NOERROR())) {
+        // Send the request again, alone, as the first attempt.  Re-entering
+        // the current state with the server selected does the send, as for
+        // a retry.
+        update_attempts_ = 0;
+        send_alone_ = true;
+        runModel(SERVER_SELECTED_EVT);
+        return;
+    }
+
+    dns_update_response_ = response;
+    (*this)(status);
+}
+
+void
+NameChangeTransaction::setUpdateCoalescer(const D2UpdateCoalescerPtr&
+                                          coalescer) {
+    coalescer_ = coalescer;
+}
+
+void
+NameChangeTransaction::setConnectionPool(const asiodns::TCPConnectionPoolPtr&
+                                         connection_pool) {
+    connection_pool_ = connection_pool;
+}
+
+void
+NameChangeTransaction::setTSIGKeys(const TSIGKeyInfoMapPtr& keys) {
+    tsig_keys_ = keys;
+}
+
 std::string
 NameChangeTransaction::responseString() const {
     std::ostringstream stream;
@@ -167,15 +205,36 @@ NameChangeTransaction::sendUpdate(const std::string& comment,
                                   bool /* use_tsig_ */) {
     try {
         ++update_attempts_;
-        // @todo add logic to add/replace TSIG key info in request if
-        // use_tsig_ is true. We should be able to navigate to the TSIG key
-        // for the current server.  If not we would need to add that.
+
+        // The first attempt may be merged with the updates of other
+        // transactions.
+        if ((update_attempts_ == 1) && !send_alone_ && coalescer_ &&
+            coalescer_->add(*this)) {
+            postNextEvent(NOP_EVT);
+            LOG_DEBUG(dctl_logger, DBGLVL_TRACE_DETAIL,
+                      DHCP_DDNS_UPDATE_REQUEST_COALESCED)
+                      .arg(comment)
+                      .arg(getTransactionKey().toStr())
+                      .arg(current_server_->toText());
+            return;
+        }
 
         // @todo time out should ultimately be configurable, down to
         // server level?
-        dns_client_->doUpdate(*io_service_, current_server_->getIpAddress(),
-                              current_server_->getPort(), *dns_update_request_,
-                              DNS_UPDATE_DEFAULT_TIMEOUT);
+        if (tsig_key_info_) {
+            dns_client_->doUpdate(*io_service_,
+                                  current_server_->getIpAddress(),
+                                  current_server_->getPort(),
+                                  *dns_update_request_,
+                                  DNS_UPDATE_DEFAULT_TIMEOUT,
+                                  tsig_key_info_->toTSIGKey());
+        } else {
+            dns_client_->doUpdate(*io_service_,
+                                  current_server_->getIpAddress(),
+                                  current_server_->getPort(),
+                                  *dns_update_request_,
+                                  DNS_UPDATE_DEFAULT_TIMEOUT);
+        }
 
         // Message is on its way, so the next event should be NOP_EVT.
         postNextEvent(NOP_EVT);
@@ -276,6 +335,7 @@ NameChangeTransaction::setDnsUpdateRequest(D2UpdateMessagePtr& request) {
 void
 NameChangeTransaction::clearDnsUpdateRequest() {
     update_attempts_ = 0;
+    send_alone_ = false;
     dns_update_request_.reset();
 }
 
@@ -423,6 +483,16 @@ NameChangeTransaction::initServerSelection(const DdnsDomainPtr& domain) {
     current_server_list_ = domain->getServers();
     next_server_pos_ = 0;
     current_server_.reset();
+
+    // The domain parser has checked that the key exists.
+    tsig_key_info_.reset();
+    const std::string key_name = domain->getKeyName();
+    if (!key_name.empty() && tsig_keys_) {
+        TSIGKeyInfoMap::const_iterator key = tsig_keys_->find(key_name);
+        if (key != tsig_keys_->end()) {
+            tsig_key_info_ = key->second;
+        }
+    }
 }
 
 bool
@@ -433,12 +503,13 @@ NameChangeTransaction::selectNextServer() {
         // Toss out any previous response.
         dns_update_response_.reset();
 
-        // @todo  Protocol is set on DNSClient constructor.  We need
-        // to propagate a configuration value downward, probably starting
-        // at global, then domain, then server
-        // Once that is supported we need to add it here.
+        // The updates are sent over TCP when the update manager has set up
+        // the connections to the servers.
+        // @todo The protocol could be configured down to the domain and the
+        // server levels.
         dns_client_.reset(new DNSClient(dns_update_response_ , this,
-                                        DNSClient::UDP));
+                                        connection_pool_ ? DNSClient::TCP :
+                                        DNSClient::UDP, connection_pool_));
         ++next_server_pos_;
         return (true);
     }
@@ -456,6 +527,11 @@ NameChangeTransaction::getCurrentServer() const {
     return (current_server_);
 }
 
+const TSIGKeyInfoPtr&
+NameChangeTransaction::getTSIGKeyInfo() const {
+    return (tsig_key_info_);
+}
+
 void
 NameChangeTransaction::setNcrStatus(const dhcp_ddns::NameChangeStatus& status) {
     return (ncr_->setStatus(status));
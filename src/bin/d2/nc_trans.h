@@ -41,6 +41,11 @@ public:
 /// @brief Defines the type used as the unique key for transactions.
 typedef bundy::dhcp_ddns::D2Dhcid TransactionKey;
 
+class D2UpdateCoalescer;
+
+/// @brief Defines a pointer to a D2UpdateCoalescer.
+typedef boost::shared_ptr<D2UpdateCoalescer> D2UpdateCoalescerPtr;
+
 /// @brief Embodies the "life-cycle" required to carry out a DDNS update.
 ///
 /// NameChangeTransaction is the base class that provides the common state
@@ -199,6 +204,47 @@ public:
     /// This method is exception safe.
     virtual void operator()(DNSClient::Status status);
 
+    /// @brief Serves as the completion handler of a coalesced update.
+    ///
+    /// This method is called by the D2UpdateCoalescer when the message
+    /// carrying the update of the transaction has completed.  If the update
+    /// was sent alone, or if the server accepted the merged update, the
+    /// outcome is handled exactly as the outcome of an update sent by the
+    /// transaction itself.  If the server responded to a merged update
+    /// with an RCODE other than NOERROR, there is no telling which of the
+    /// names caused it, so the transaction sends its update again, alone.
+    ///
+    /// @param status is the outcome of the DNS update packet exchange.
+    /// @param response is the response received from the server, if any.
+    /// @param shared is true if the update was merged with the updates of
+    /// other transactions.
+    void onCoalescedUpdate(DNSClient::Status status,
+                           const D2UpdateMessagePtr& response,
+                           bool shared);
+
+    /// @brief Sets the coalescer taking the updates of the transaction.
+    ///
+    /// @param coalescer is the coalescer, or an empty pointer to always
+    /// send the updates directly.
+    void setUpdateCoalescer(const D2UpdateCoalescerPtr& coalescer);
+
+    /// @brief Sets the pool of the TCP connections to the servers.
+    ///
+    /// It is used by the servers selected afterwards.
+    ///
+    /// @param connection_pool is the pool, or an empty pointer to send the
+    /// updates over UDP.
+    void setConnectionPool(const asiodns::TCPConnectionPoolPtr&
+                           connection_pool);
+
+    /// @brief Sets the TSIG keys which the domains refer to.
+    ///
+    /// The updates are signed with the key of the domain of the current
+    /// server, if it has one.  It is used by the next server selection.
+    ///
+    /// @param keys is the map of the configured keys.
+    void setTSIGKeys(const TSIGKeyInfoMapPtr& keys);
+
 protected:
     /// @brief Send the update request to the current server.
     ///
@@ -207,9 +253,15 @@ protected:
     /// currently selected server.  Since the send is asynchronous, the method
     /// posts NOP_EVT as the next event and then returns.
     ///
+    /// If an update coalescer is set, the first attempt of each request is
+    /// given to the coalescer rather than to the DNSClient.
+    ///
+    /// The request is signed if the domain of the current server specifies a
+    /// TSIG key (see setTSIGKeys).
+    ///
     /// @param comment text to include in log detail
-    /// @param use_tsig True if the update should be include a TSIG key. This
-    /// is not yet implemented.
+    /// @param use_tsig is unused: the signing follows the configuration of
+    /// the domain.
     ///
     /// If an exception occurs it will be logged and and the transaction will
     /// be failed.
@@ -464,6 +516,12 @@ public:
     /// server.
     const DnsServerInfoPtr& getCurrentServer() const;
 
+    /// @brief Fetches the TSIG key of the current domain.
+    ///
+    /// @return A const pointer reference to the key, empty if the requests
+    /// are not signed.
+    const TSIGKeyInfoPtr& getTSIGKeyInfo() const;
+
     /// @brief Fetches the DNSClient instance
     ///
     /// @return A const pointer reference to the DNSClient
@@ -570,6 +628,24 @@ private:
 
     /// @brief Number of transmit attempts for the current request.
     size_t update_attempts_;
+
+    /// @brief The coalescer taking the updates, if any.
+    D2UpdateCoalescerPtr coalescer_;
+
+    /// @brief The pool of the TCP connections, if any.
+    asiodns::TCPConnectionPoolPtr connection_pool_;
+
+    /// @brief The configured TSIG keys.
+    TSIGKeyInfoMapPtr tsig_keys_;
+
+    /// @brief The TSIG key of the current domain, if any.
+    TSIGKeyInfoPtr tsig_key_info_;
+
+    /// @brief Indicator for whether the current request must be sent alone.
+    ///
+    /// It is set when a merged update including the current request was
+    /// refused by the server.
+    bool send_alone_;
 };
 
 /// @brief Defines a pointer to a NameChangeTransaction.
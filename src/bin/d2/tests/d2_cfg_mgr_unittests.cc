@@ -443,6 +443,31 @@ TEST_F(TSIGKeyInfoTest, validTSIGKeyList) {
     EXPECT_TRUE(checkKey(key, "key3", "algo3", "secret3"));
 }
 
+/// @brief Verifies the conversion of TSIGKeyInfos into the keys signing the
+/// DNS updates, with the algorithm names accepted by the configuration.
+TEST(TSIGKeyInfo, toTSIGKey) {
+    dns::TSIGKey key = TSIGKeyInfo("d2_key.example.com", "md5",
+                                   "MSG6Ng==").toTSIGKey();
+    EXPECT_EQ("d2_key.example.com.", key.getKeyName().toText());
+    EXPECT_EQ(dns::TSIGKey::HMACMD5_NAME(), key.getAlgorithmName());
+
+    key = TSIGKeyInfo("d2_key.example.com", "hmac_md5",
+                      "MSG6Ng==").toTSIGKey();
+    EXPECT_EQ(dns::TSIGKey::HMACMD5_NAME(), key.getAlgorithmName());
+
+    key = TSIGKeyInfo("d2_key.example.com", "HMAC-SHA256",
+                      "MSG6Ng==").toTSIGKey();
+    EXPECT_EQ(dns::TSIGKey::HMACSHA256_NAME(), key.getAlgorithmName());
+
+    // Unknown algorithm.
+    EXPECT_THROW(TSIGKeyInfo("d2_key.example.com", "md4",
+                             "MSG6Ng==").toTSIGKey(), D2CfgError);
+
+    // Secret not in base64.
+    EXPECT_THROW(TSIGKeyInfo("d2_key.example.com", "md5",
+                             "#secret#").toTSIGKey(), D2CfgError);
+}
+
 /// @brief Tests the enforcement of data validation when parsing DnsServerInfos.
 /// It verifies that:
 /// 1. Specifying both a hostname and an ip address is not allowed.
@@ -893,6 +918,11 @@ TEST_F(D2CfgMgrTest, fullConfig) {
                         "\"interface\" : \"eth1\" , "
                         "\"ip_address\" : \"192.168.1.33\" , "
                         "\"port\" : 88 , "
+                        "\"max_coalesced_names\" : 16 , "
+                        "\"dns_protocol\" : \"TCP\" , "
+                        "\"queue_file\" : \"d2.queue\" , "
+                        "\"ncr_format\" : \"BINARY\" , "
+                        "\"ncr_socket\" : \"/tmp/d2.sock\" , "
                         "\"tsig_keys\": ["
                         "{"
                         "  \"name\": \"d2_key.tmark.org\" , "
@@ -964,6 +994,27 @@ TEST_F(D2CfgMgrTest, fullConfig) {
     EXPECT_NO_THROW (context->getParam("port", port));
     EXPECT_EQ(88, port);
 
+    uint32_t max_coalesced_names = 0;
+    EXPECT_NO_THROW (context->getParam("max_coalesced_names",
+                                       max_coalesced_names));
+    EXPECT_EQ(16, max_coalesced_names);
+
+    std::string dns_protocol;
+    EXPECT_NO_THROW (context->getParam("dns_protocol", dns_protocol));
+    EXPECT_EQ("TCP", dns_protocol);
+
+    std::string queue_file;
+    EXPECT_NO_THROW (context->getParam("queue_file", queue_file));
+    EXPECT_EQ("d2.queue", queue_file);
+
+    std::string ncr_format;
+    EXPECT_NO_THROW (context->getParam("ncr_format", ncr_format));
+    EXPECT_EQ("BINARY", ncr_format);
+
+    std::string ncr_socket;
+    EXPECT_NO_THROW (context->getParam("ncr_socket", ncr_socket));
+    EXPECT_EQ("/tmp/d2.sock", ncr_socket);
+
     // Verify that the forward manager can be retrieved.
     DdnsDomainListMgrPtr mgr = context->getForwardMgr();
     ASSERT_TRUE(mgr);
@@ -1034,6 +1085,11 @@ TEST_F(D2CfgMgrTest, forwardMatch) {
                         "\"interface\" : \"eth1\" , "
                         "\"ip_address\" : \"192.168.1.33\" , "
                         "\"port\" : 88 , "
+                        "\"max_coalesced_names\" : 1 , "
+                        "\"dns_protocol\" : \"UDP\" , "
+                        "\"queue_file\" : \"\" , "
+                        "\"ncr_format\" : \"JSON\" , "
+                        "\"ncr_socket\" : \"\" , "
                         "\"tsig_keys\": [] ,"
                         "\"forward_ddns\" : {"
                         "\"ddns_domains\": [ "
@@ -1108,6 +1164,11 @@ TEST_F(D2CfgMgrTest, matchNoWildcard) {
                         "\"interface\" : \"eth1\" , "
                         "\"ip_address\" : \"192.168.1.33\" , "
                         "\"port\" : 88 , "
+                        "\"max_coalesced_names\" : 1 , "
+                        "\"dns_protocol\" : \"UDP\" , "
+                        "\"queue_file\" : \"\" , "
+                        "\"ncr_format\" : \"JSON\" , "
+                        "\"ncr_socket\" : \"\" , "
                         "\"tsig_keys\": [] ,"
                         "\"forward_ddns\" : {"
                         "\"ddns_domains\": [ "
@@ -1156,6 +1217,11 @@ TEST_F(D2CfgMgrTest, matchAll) {
                         "\"interface\" : \"eth1\" , "
                         "\"ip_address\" : \"192.168.1.33\" , "
                         "\"port\" : 88 , "
+                        "\"max_coalesced_names\" : 1 , "
+                        "\"dns_protocol\" : \"UDP\" , "
+                        "\"queue_file\" : \"\" , "
+                        "\"ncr_format\" : \"JSON\" , "
+                        "\"ncr_socket\" : \"\" , "
                         "\"tsig_keys\": [] ,"
                         "\"forward_ddns\" : {"
                         "\"ddns_domains\": [ "
@@ -1203,6 +1269,11 @@ TEST_F(D2CfgMgrTest, matchReverse) {
                         "\"interface\" : \"eth1\" , "
                         "\"ip_address\" : \"192.168.1.33\" , "
                         "\"port\" : 88 , "
+                        "\"max_coalesced_names\" : 1 , "
+                        "\"dns_protocol\" : \"UDP\" , "
+                        "\"queue_file\" : \"\" , "
+                        "\"ncr_format\" : \"JSON\" , "
+                        "\"ncr_socket\" : \"\" , "
                         "\"tsig_keys\": [] ,"
                         "\"forward_ddns\" : {}, "
                         "\"reverse_ddns\" : {"
@@ -38,6 +38,11 @@ const char* bad_ip_d2_config = "{ "
                         "\"interface\" : \"eth1\" , "
                         "\"ip_address\" : \"1.1.1.1\" , "
                         "\"port\" : 5031, "
+                        "\"max_coalesced_names\" : 1 , "
+                        "\"dns_protocol\" : \"UDP\" , "
+                        "\"queue_file\" : \"\" , "
+                        "\"ncr_format\" : \"JSON\" , "
+                        "\"ncr_socket\" : \"\" , "
                         "\"tsig_keys\": ["
                         "{ \"name\": \"d2_key.tmark.org\" , "
                         "   \"algorithm\": \"md5\" ,"
@@ -610,6 +615,11 @@ TEST_F(D2ProcessTest, notLoopbackTest) {
                         "\"interface\" : \"\" , "
                         "\"ip_address\" : \"0.0.0.0\" , "
                         "\"port\" : 53001, "
+                        "\"max_coalesced_names\" : 1 , "
+                        "\"dns_protocol\" : \"UDP\" , "
+                        "\"queue_file\" : \"\" , "
+                        "\"ncr_format\" : \"JSON\" , "
+                        "\"ncr_socket\" : \"\" , "
                         "\"tsig_keys\": [],"
                         "\"forward_ddns\" : {},"
                         "\"reverse_ddns\" : {}"
@@ -629,6 +639,11 @@ TEST_F(D2ProcessTest, v4LoopbackTest) {
                         "\"interface\" : \"\" , "
                         "\"ip_address\" : \"127.0.0.1\" , "
                         "\"port\" : 53001, "
+                        "\"max_coalesced_names\" : 1 , "
+                        "\"dns_protocol\" : \"UDP\" , "
+                        "\"queue_file\" : \"\" , "
+                        "\"ncr_format\" : \"JSON\" , "
+                        "\"ncr_socket\" : \"\" , "
                         "\"tsig_keys\": [],"
                         "\"forward_ddns\" : {},"
                         "\"reverse_ddns\" : {}"
@@ -643,6 +658,11 @@ TEST_F(D2ProcessTest, v6LoopbackTest) {
                         "\"interface\" : \"\" , "
                         "\"ip_address\" : \"::1\" , "
                         "\"port\" : 53001, "
+                        "\"max_coalesced_names\" : 1 , "
+                        "\"dns_protocol\" : \"UDP\" , "
+                        "\"queue_file\" : \"\" , "
+                        "\"ncr_format\" : \"JSON\" , "
+                        "\"ncr_socket\" : \"\" , "
                         "\"tsig_keys\": [],"
                         "\"forward_ddns\" : {},"
                         "\"reverse_ddns\" : {}"
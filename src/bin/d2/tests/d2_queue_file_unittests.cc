@@ -0,0 +1,186 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <d2/d2_queue_file.h>
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <stdio.h>
+
+using namespace std;
+using namespace bundy;
+using namespace bundy::dhcp_ddns;
+using namespace bundy::d2;
+
+namespace {
+
+/// @brief Returns a request for the given FQDN.
+NameChangeRequestPtr
+makeRequest(const std::string& fqdn) {
+    std::ostringstream json;
+    json << "{"
+         " \"change_type\" : 0 , "
+         " \"forward_change\" : true , "
+         " \"reverse_change\" : false , "
+         " \"fqdn\" : \"" << fqdn << "\" , "
+         " \"ip_address\" : \"192.168.2.1\" , "
+         " \"dhcid\" : \"010203040A7F8E3D\" , "
+         " \"lease_expires_on\" : \"20130121132405\" , "
+         " \"lease_length\" : 1300 "
+         "}";
+    return (NameChangeRequest::fromJSON(json.str()));
+}
+
+/// @brief Test fixture removing the queue file before and after each test.
+class D2QueueFileTest : public ::testing::Test {
+public:
+    D2QueueFileTest()
+        : filename_(std::string(TEST_DATA_BUILDDIR) + "/d2-queue-test.db") {
+        removeFiles();
+    }
+
+    ~D2QueueFileTest() {
+        removeFiles();
+    }
+
+    void removeFiles() {
+        remove(filename_.c_str());
+        remove((filename_ + ".tmp").c_str());
+    }
+
+    /// @brief Returns the content of the queue file.
+    std::string readFile() const {
+        std::ifstream fs(filename_.c_str());
+        std::ostringstream content;
+        content << fs.rdbuf();
+        return (content.str());
+    }
+
+    std::string filename_;
+};
+
+// Checks that the pending requests are read back when the file is opened
+// again, with their ids.
+TEST_F(D2QueueFileTest, replay) {
+    QueuedRequestList requests;
+    uint64_t id1 = 0, id2 = 0, id3 = 0;
+    {
+        D2QueueFile file(filename_);
+        EXPECT_FALSE(file.isOpen());
+        ASSERT_NO_THROW(file.open(requests));
+        EXPECT_TRUE(file.isOpen());
+        EXPECT_TRUE(requests.empty());
+
+        ASSERT_NO_THROW(id1 = file.append(*makeRequest("one.example.com.")));
+        ASSERT_NO_THROW(id2 = file.append(*makeRequest("two.example.com.")));
+        ASSERT_NO_THROW(id3 = file.append(*makeRequest("three.example.com.")));
+        EXPECT_EQ(3, file.getPendingCount());
+
+        ASSERT_NO_THROW(file.complete(id2));
+        // Unknown ids are ignored.
+        ASSERT_NO_THROW(file.complete(id2));
+        EXPECT_EQ(2, file.getPendingCount());
+        EXPECT_EQ(1, file.getCompletedCount());
+        ASSERT_NO_THROW(file.sync());
+    }
+
+    D2QueueFile file(filename_);
+    ASSERT_NO_THROW(file.open(requests));
+    ASSERT_EQ(2, requests.size());
+    EXPECT_EQ(id1, requests[0].first);
+    EXPECT_EQ("one.example.com.", requests[0].second->getFqdn());
+    EXPECT_EQ(id3, requests[1].first);
+    EXPECT_EQ("three.example.com.", requests[1].second->getFqdn());
+
+    // The file has been compacted and the ids keep growing.
+    EXPECT_EQ(0, file.getCompletedCount());
+    EXPECT_GT(file.append(*makeRequest("four.example.com.")), id3);
+}
+
+// Checks that a record cut short by a crash and the invalid records are
+// ignored, and dropped from the file.
+TEST_F(D2QueueFileTest, invalidRecords) {
+    const std::string valid = "+1 " + makeRequest("one.example.com.")->toJSON();
+    {
+        std::ofstream fs(filename_.c_str());
+        fs << valid << "\n"
+           << "garbage\n"
+           << "+2 {\"not\":\"a request\"}\n"
+           << "-\n"
+           << "+3 {\"change_type\":0,";
+    }
+
+    QueuedRequestList requests;
+    D2QueueFile file(filename_);
+    ASSERT_NO_THROW(file.open(requests));
+    ASSERT_EQ(1, requests.size());
+    EXPECT_EQ(1, requests[0].first);
+    EXPECT_EQ(valid + "\n", readFile());
+}
+
+// Checks that the file is compacted once the completed requests outnumber
+// the pending ones.
+TEST_F(D2QueueFileTest, compaction) {
+    QueuedRequestList requests;
+    D2QueueFile file(filename_);
+    ASSERT_NO_THROW(file.open(requests));
+
+    NameChangeRequestPtr ncr = makeRequest("one.example.com.");
+    const uint64_t kept = file.append(*ncr);
+    for (size_t i = 0; i < D2QueueFile::MIN_COMPACT_RECORDS; ++i) {
+        file.complete(file.append(*ncr));
+    }
+
+    // The records are written in batches.
+    EXPECT_FALSE(readFile().empty());
+    EXPECT_EQ(D2QueueFile::MIN_COMPACT_RECORDS, file.getCompletedCount());
+
+    ASSERT_NO_THROW(file.sync());
+    EXPECT_EQ(0, file.getCompletedCount());
+    EXPECT_EQ(1, file.getPendingCount());
+
+    std::ostringstream expected;
+    expected << "+" << kept << " " << ncr->toJSON() << "\n";
+    EXPECT_EQ(expected.str(), readFile());
+
+    // The file is still written after the compaction.
+    file.complete(kept);
+    ASSERT_NO_THROW(file.close());
+    std::ostringstream completed;
+    completed << expected.str() << "-" << kept << "\n";
+    EXPECT_EQ(completed.str(), readFile());
+}
+
+// Checks the errors.
+TEST_F(D2QueueFileTest, errors) {
+    QueuedRequestList requests;
+    D2QueueFile file(filename_);
+    EXPECT_THROW(file.append(*makeRequest("one.example.com.")),
+                 D2QueueFileError);
+    EXPECT_THROW(file.complete(1), D2QueueFileError);
+    EXPECT_NO_THROW(file.close());
+
+    ASSERT_NO_THROW(file.open(requests));
+    EXPECT_THROW(file.open(requests), D2QueueFileError);
+
+    D2QueueFile bad_file("/nonexistent-dir/d2-queue-test.db");
+    EXPECT_THROW(bad_file.open(requests), D2QueueFileError);
+    EXPECT_FALSE(bad_file.isOpen());
+}
+
+}
@@ -15,6 +15,7 @@
 #include <d2/d2_asio.h>
 #include <d2/d2_queue_mgr.h>
 #include <dhcp_ddns/ncr_udp.h>
+#include <dhcp_ddns/ncr_unix.h>
 #include <util/time_utilities.h>
 
 #include <boost/function.hpp>
@@ -24,6 +25,8 @@
 #include <algorithm>
 #include <vector>
 
+#include <stdio.h>
+
 using namespace std;
 using namespace bundy;
 using namespace bundy::dhcp_ddns;
@@ -197,6 +200,109 @@ TEST(D2QueueMgrBasicTest, basicQueue) {
                  D2QueueMgrInvalidIndex);
 }
 
+/// @brief Tests that the requests are kept in the queue file.
+/// This test verifies that:
+/// 1. The requests queued before and after the file is set are recorded
+/// 2. The requests completed or cleared are not queued again
+/// 3. The requests dequeued and not completed are queued again
+TEST(D2QueueMgrBasicTest, queueFile) {
+    IOServicePtr io_service(new bundy::asiolink::IOService());
+    const std::string filename = std::string(TEST_DATA_BUILDDIR) +
+                                 "/d2-queue-mgr-test.db";
+    remove(filename.c_str());
+
+    std::vector<NameChangeRequestPtr> ref_msgs;
+    {
+        D2QueueMgr queue_mgr(io_service);
+        EXPECT_EQ("", queue_mgr.getQueueFile());
+
+        NameChangeRequestPtr ncr;
+        for (int i = 0; i < VALID_MSG_CNT; i++) {
+            ASSERT_NO_THROW(ncr = NameChangeRequest::fromJSON(valid_msgs[i]));
+            ref_msgs.push_back(ncr);
+            if (i == 1) {
+                ASSERT_NO_THROW(queue_mgr.setQueueFile(filename));
+                EXPECT_EQ(filename, queue_mgr.getQueueFile());
+            }
+            ASSERT_NO_THROW(queue_mgr.enqueue(ncr));
+        }
+
+        // The first request is carried out, the second one is in progress.
+        ncr = queue_mgr.peek();
+        queue_mgr.dequeue();
+        queue_mgr.complete(ncr);
+        queue_mgr.dequeue();
+        queue_mgr.syncQueueFile();
+    }
+
+    {
+        D2QueueMgr queue_mgr(io_service);
+        ASSERT_NO_THROW(queue_mgr.setQueueFile(filename));
+        ASSERT_EQ(VALID_MSG_CNT - 1, queue_mgr.getQueueSize());
+        for (int i = 1; i < VALID_MSG_CNT; i++) {
+            EXPECT_TRUE(*(ref_msgs[i]) == *queue_mgr.peekAt(i - 1));
+        }
+
+        // The requests cleared are not queued again.
+        queue_mgr.clearQueue();
+    }
+
+    D2QueueMgr queue_mgr(io_service);
+    ASSERT_NO_THROW(queue_mgr.setQueueFile(filename));
+    EXPECT_EQ(0, queue_mgr.getQueueSize());
+
+    // An empty name closes the file.
+    ASSERT_NO_THROW(queue_mgr.setQueueFile(""));
+    EXPECT_EQ("", queue_mgr.getQueueFile());
+    remove(filename.c_str());
+}
+
+/// @brief Tests that switching the queue files moves the requests.
+/// This test verifies that:
+/// 1. The requests of the old file are recorded in the new one
+/// 2. They are not queued again when the old file is used again
+TEST(D2QueueMgrBasicTest, queueFileSwitch) {
+    IOServicePtr io_service(new bundy::asiolink::IOService());
+    const std::string filename1 = std::string(TEST_DATA_BUILDDIR) +
+                                  "/d2-queue-mgr-test1.db";
+    const std::string filename2 = std::string(TEST_DATA_BUILDDIR) +
+                                  "/d2-queue-mgr-test2.db";
+    remove(filename1.c_str());
+    remove(filename2.c_str());
+
+    {
+        D2QueueMgr queue_mgr(io_service);
+        ASSERT_NO_THROW(queue_mgr.setQueueFile(filename1));
+        NameChangeRequestPtr ncr;
+        for (int i = 0; i < VALID_MSG_CNT; i++) {
+            ASSERT_NO_THROW(ncr = NameChangeRequest::fromJSON(valid_msgs[i]));
+            ASSERT_NO_THROW(queue_mgr.enqueue(ncr));
+        }
+        queue_mgr.syncQueueFile();
+        ASSERT_NO_THROW(queue_mgr.setQueueFile(filename2));
+        EXPECT_EQ(VALID_MSG_CNT, queue_mgr.getQueueSize());
+    }
+
+    {
+        D2QueueMgr queue_mgr(io_service);
+        ASSERT_NO_THROW(queue_mgr.setQueueFile(filename1));
+        EXPECT_EQ(0, queue_mgr.getQueueSize());
+    }
+
+    D2QueueMgr queue_mgr(io_service);
+    ASSERT_NO_THROW(queue_mgr.setQueueFile(filename2));
+    EXPECT_EQ(VALID_MSG_CNT, queue_mgr.getQueueSize());
+
+    // Closing the file clears it too.
+    ASSERT_NO_THROW(queue_mgr.setQueueFile(""));
+    EXPECT_EQ(VALID_MSG_CNT, queue_mgr.getQueueSize());
+    ASSERT_NO_THROW(queue_mgr.setQueueFile(filename2));
+    EXPECT_EQ(VALID_MSG_CNT, queue_mgr.getQueueSize());
+    ASSERT_NO_THROW(queue_mgr.setQueueFile(""));
+    remove(filename1.c_str());
+    remove(filename2.c_str());
+}
+
 /// @brief Compares two NameChangeRequests for equality.
 bool checkSendVsReceived(NameChangeRequestPtr sent_ncr,
                          NameChangeRequestPtr received_ncr) {
@@ -208,7 +314,7 @@ bool checkSendVsReceived(NameChangeRequestPtr sent_ncr,
 /// It derives from both the receive and send handler classes and contains
 /// and instance of UDP listener and UDP sender.
 class QueueMgrUDPTest : public virtual ::testing::Test,
-                        NameChangeSender::RequestSendHandler {
+                        public NameChangeSender::RequestSendHandler {
 public:
     IOServicePtr io_service_;
     NameChangeSenderPtr   sender_;
@@ -442,4 +548,86 @@ TEST_F (QueueMgrUDPTest, liveFeed) {
     EXPECT_EQ(1, queue_mgr_->getQueueSize());
 }
 
+/// @brief Tests that the request received while the queue is full is kept.
+/// This test verifies that:
+/// 1. The request is kept in the queue file when the queue is full
+/// 2. It is queued when the listener is restarted
+TEST_F (QueueMgrUDPTest, overflow) {
+    const std::string filename = std::string(TEST_DATA_BUILDDIR) +
+                                 "/d2-queue-mgr-test.db";
+    remove(filename.c_str());
+    ASSERT_NO_THROW(queue_mgr_.reset(new D2QueueMgr(io_service_, 1)));
+    ASSERT_NO_THROW(queue_mgr_->setQueueFile(filename));
+    bundy::asiolink::IOAddress addr(TEST_ADDRESS);
+    ASSERT_NO_THROW(queue_mgr_->initUDPListener(addr, LISTENER_PORT,
+                                                FMT_JSON, true));
+    ASSERT_NO_THROW(queue_mgr_->startListening());
+    ASSERT_NO_THROW(sender_->startSending(*io_service_));
+
+    std::vector<NameChangeRequestPtr> sent;
+    for (int i = 0; i < 2; i++) {
+        NameChangeRequestPtr send_ncr;
+        ASSERT_NO_THROW(send_ncr = NameChangeRequest::fromJSON(valid_msgs[i]));
+        sent.push_back(send_ncr);
+        ASSERT_NO_THROW(sender_->sendRequest(send_ncr));
+        EXPECT_NO_THROW(io_service_->run_one());
+        EXPECT_NO_THROW(io_service_->run_one());
+    }
+    EXPECT_EQ(D2QueueMgr::STOPPED_QUEUE_FULL, queue_mgr_->getMgrState());
+    EXPECT_EQ(1, queue_mgr_->getQueueSize());
+    EXPECT_EQ(1, queue_mgr_->getOverflowSize());
+
+    // The overflowing request is queued once there is room.
+    NameChangeRequestPtr ncr = queue_mgr_->peek();
+    EXPECT_TRUE(checkSendVsReceived(sent[0], ncr));
+    queue_mgr_->dequeue();
+    queue_mgr_->complete(ncr);
+    EXPECT_NO_THROW(queue_mgr_->startListening());
+    EXPECT_EQ(0, queue_mgr_->getOverflowSize());
+    ASSERT_EQ(1, queue_mgr_->getQueueSize());
+    EXPECT_TRUE(checkSendVsReceived(sent[1], queue_mgr_->peek()));
+
+    ASSERT_NO_THROW(queue_mgr_->setQueueFile(""));
+    remove(filename.c_str());
+}
+
+/// @brief Tests that D2QueueMgr receives the requests on a Unix socket,
+/// in the binary format.
+TEST_F (QueueMgrUDPTest, unixFeed) {
+    const std::string socket_path = std::string(TEST_DATA_BUILDDIR) +
+                                    "/d2-queue-test.sock";
+    ASSERT_NO_THROW(queue_mgr_.reset(new D2QueueMgr(io_service_,
+                                                    VALID_MSG_CNT)));
+    ASSERT_NO_THROW(queue_mgr_->initUnixListener(socket_path, FMT_BINARY));
+    ASSERT_EQ(D2QueueMgr::INITTED, queue_mgr_->getMgrState());
+    EXPECT_THROW(queue_mgr_->initUnixListener(socket_path, FMT_BINARY),
+                 D2QueueMgrError);
+    ASSERT_NO_THROW(queue_mgr_->startListening());
+
+    NameChangeUnixSender sender(socket_path, FMT_BINARY, *this);
+    ASSERT_NO_THROW(sender.startSending(*io_service_));
+
+    std::vector<NameChangeRequestPtr> send_ncrs;
+    for (int i = 0; i < VALID_MSG_CNT; i++) {
+        NameChangeRequestPtr send_ncr;
+        ASSERT_NO_THROW(send_ncr = NameChangeRequest::fromJSON(valid_msgs[i]));
+        ASSERT_NO_THROW(sender.sendRequest(send_ncr));
+        send_ncrs.push_back(send_ncr);
+    }
+
+    while (queue_mgr_->getQueueSize() < VALID_MSG_CNT) {
+        ASSERT_NO_THROW(io_service_->run_one());
+    }
+
+    for (int i = 0; i < VALID_MSG_CNT; i++) {
+        EXPECT_TRUE(checkSendVsReceived(send_ncrs[i], queue_mgr_->peek()));
+        queue_mgr_->dequeue();
+    }
+
+    EXPECT_NO_THROW(sender.stopSending());
+    EXPECT_NO_THROW(queue_mgr_->stopListening());
+    EXPECT_NO_THROW(io_service_->run_one());
+    EXPECT_EQ(D2QueueMgr::STOPPED, queue_mgr_->getMgrState());
+}
+
 } // end of anonymous namespace
@@ -123,6 +123,11 @@ public:
                   "\"interface\" : \"eth1\" , "
                   "\"ip_address\" : \"192.168.1.33\" , "
                   "\"port\" : 88 , "
+                  "\"max_coalesced_names\" : 1 , "
+                  "\"dns_protocol\" : \"UDP\" , "
+                  "\"queue_file\" : \"\" , "
+                  "\"ncr_format\" : \"JSON\" , "
+                  "\"ncr_socket\" : \"\" , "
                   "\"tsig_keys\": [] ,"
                   "\"forward_ddns\" : {"
                   "\"ddns_domains\": [ "
@@ -872,4 +877,97 @@ TEST_F(D2UpdateMgrTest, multiTransactionTimeout) {
     }
 }
 
+/// @brief Tests processing of multiple transactions with coalesced updates.
+/// This test verifies that when the updates are coalesced:
+/// 1. One sweep starts the transactions for all the requests.
+/// 2. Their updates, for different names of the same zone, are sent in
+/// one message.
+/// 3. The transactions all complete when the server accepts the message.
+TEST_F(D2UpdateMgrTest, coalescedTransactions) {
+    update_mgr_->setMaxCoalescedNames(canned_count_);
+    EXPECT_EQ(canned_count_, update_mgr_->getMaxCoalescedNames());
+
+    const char* fqdns[] = { "one.example.com.", "two.example.com.",
+                            "three.example.com.", "four.example.com." };
+    int test_count = canned_count_;
+    for (int i = 0; i < test_count; i++) {
+        canned_ncrs_[i]->setFqdn(fqdns[i]);
+        canned_ncrs_[i]->setChangeType(dhcp_ddns::CHG_ADD);
+        ASSERT_NO_THROW(queue_mgr_->enqueue(canned_ncrs_[i]));
+    }
+
+    ASSERT_NO_THROW(update_mgr_->sweep());
+    EXPECT_EQ(0, update_mgr_->getQueueCount());
+    EXPECT_EQ(test_count, update_mgr_->getTransactionCount());
+    const D2UpdateCoalescerPtr& coalescer = update_mgr_->getUpdateCoalescer();
+    EXPECT_EQ(0, coalescer->getPendingCount());
+    EXPECT_EQ(1, coalescer->getInFlightCount());
+
+    asiolink::IOAddress server_ip("127.0.0.1");
+    FauxServer server(*io_service_, server_ip, 5301);
+    server.receive(FauxServer::USE_RCODE, dns::Rcode::NOERROR());
+
+    // Run sweep and IO until everything is done.
+    processAll();
+
+    for (int i = 0; i < test_count; i++) {
+        EXPECT_EQ(dhcp_ddns::ST_COMPLETED, canned_ncrs_[i]->getStatus());
+    }
+}
+
+/// @brief Tests that the updates of the same name are never merged.
+/// The canned requests are all for the same name, so each update must be
+/// sent in its own message.
+TEST_F(D2UpdateMgrTest, coalescedSameName) {
+    update_mgr_->setMaxCoalescedNames(canned_count_);
+
+    int test_count = canned_count_;
+    for (int i = 0; i < test_count; i++) {
+        ASSERT_NO_THROW(queue_mgr_->enqueue(canned_ncrs_[i]));
+    }
+
+    ASSERT_NO_THROW(update_mgr_->sweep());
+    EXPECT_EQ(test_count, update_mgr_->getTransactionCount());
+    EXPECT_EQ(test_count,
+              update_mgr_->getUpdateCoalescer()->getInFlightCount());
+
+    asiolink::IOAddress server_ip("127.0.0.1");
+    FauxServer server(*io_service_, server_ip, 5301);
+    server.receive(FauxServer::USE_RCODE, dns::Rcode::NOERROR());
+
+    processAll();
+
+    for (int i = 0; i < test_count; i++) {
+        EXPECT_EQ(dhcp_ddns::ST_COMPLETED, canned_ncrs_[i]->getStatus());
+    }
+}
+
+/// @brief Tests the fallback when a coalesced update is refused.
+/// The server refuses all the updates.  The merged update being refused,
+/// each transaction sends its own update, which is refused as well, so
+/// all the requests fail rather than wait.
+TEST_F(D2UpdateMgrTest, coalescedRefused) {
+    update_mgr_->setMaxCoalescedNames(canned_count_);
+
+    const char* fqdns[] = { "one.example.com.", "two.example.com.",
+                            "three.example.com.", "four.example.com." };
+    int test_count = canned_count_;
+    for (int i = 0; i < test_count; i++) {
+        canned_ncrs_[i]->setFqdn(fqdns[i]);
+        canned_ncrs_[i]->setChangeType(dhcp_ddns::CHG_ADD);
+        ASSERT_NO_THROW(queue_mgr_->enqueue(canned_ncrs_[i]));
+    }
+
+    asiolink::IOAddress server_ip("127.0.0.1");
+    FauxServer server(*io_service_, server_ip, 5301);
+    server.receive(FauxServer::USE_RCODE, dns::Rcode::REFUSED());
+
+    processAll();
+
+    for (int i = 0; i < test_count; i++) {
+        EXPECT_EQ(dhcp_ddns::ST_FAILED, canned_ncrs_[i]->getStatus());
+    }
+    EXPECT_EQ(0, update_mgr_->getUpdateCoalescer()->getInFlightCount());
+}
+
 }
@@ -25,6 +25,11 @@ const char* valid_d2_config = "{ "
                         "\"interface\" : \"eth1\" , "
                         "\"ip_address\" : \"127.0.0.1\" , "
                         "\"port\" : 5031, "
+                        "\"max_coalesced_names\" : 1 , "
+                        "\"dns_protocol\" : \"UDP\" , "
+                        "\"queue_file\" : \"\" , "
+                        "\"ncr_format\" : \"JSON\" , "
+                        "\"ncr_socket\" : \"\" , "
                         "\"tsig_keys\": ["
                         "{ \"name\": \"d2_key.tmark.org\" , "
                         "   \"algorithm\": \"md5\" ,"
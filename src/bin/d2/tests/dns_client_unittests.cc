@@ -196,11 +196,13 @@ public:
     void runConstructorTest() {
         EXPECT_NO_THROW(DNSClient(response_, NULL, DNSClient::UDP));
 
-        // The TCP Transport is not supported right now. So, we return exception
-        // if caller specified TCP as a preferred protocol. This test will be
-        // removed once TCP is supported.
+        // The TCP Transport is only supported through a pool of connections.
+        // So, we return exception if caller specified TCP as a preferred
+        // protocol without a pool.
         EXPECT_THROW(DNSClient(response_, NULL, DNSClient::TCP),
                      bundy::NotImplemented);
+        TCPConnectionPoolPtr pool(new TCPConnectionPool(service_));
+        EXPECT_NO_THROW(DNSClient(response_, NULL, DNSClient::TCP, pool));
     }
 
     // This test verifies that it accepted timeout values belong to the range of
@@ -229,9 +231,13 @@ public:
                      bundy::BadValue);
     }
 
-    // This test verifies that bundy::NotImplemented exception is thrown when
-    // attempt to send DNS Update message with TSIG is attempted.
+    // This test verifies that a DNS Update message can be signed with TSIG
+    // and that the signature of the response is verified. The test server
+    // echoes the request, including its signature, which is not a valid
+    // signature of a response: the response is expected to be invalid.
     void runTSIGTest() {
+        corrupt_response_ = true;
+
         // Create outgoing message. Simply set the required message fields:
         // error code and Zone section. This is enough to create on-wire format
         // of this message and send it.
@@ -239,14 +245,30 @@ public:
         ASSERT_NO_THROW(message.setRcode(Rcode(Rcode::NOERROR_CODE)));
         ASSERT_NO_THROW(message.setZone(Name("example.com"), RRClass::IN()));
 
-        const int timeout = 0;
-        // Try to send DNS Update with TSIG key. Currently TSIG is not supported
-        // and therefore we expect an exception.
+        // The server sends back the request with the QR bit set.
+        udp::socket udp_socket(service_.get_io_service(), asio::ip::udp::v4());
+        udp_socket.set_option(socket_base::reuse_address(true));
+        udp_socket.bind(udp::endpoint(address::from_string(TEST_ADDRESS),
+                                      TEST_PORT));
+        udp::endpoint remote;
+        udp_socket.async_receive_from(asio::buffer(receive_buffer_,
+                                                   sizeof(receive_buffer_)),
+                                      remote,
+                                      boost::bind(&DNSClientTest::udpReceiveHandler,
+                                                  this, &udp_socket, &remote, _2,
+                                                  false));
+
+        const int timeout = 500;
         TSIGKey tsig_key("key.example:MSG6Ng==");
-        EXPECT_THROW(dns_client_->doUpdate(service_, IOAddress(TEST_ADDRESS),
-                                           TEST_PORT, message, timeout,
-                                           tsig_key),
-                     bundy::NotImplemented);
+        expected_++;
+        ASSERT_NO_THROW(dns_client_->doUpdate(service_,
+                                              IOAddress(TEST_ADDRESS),
+                                              TEST_PORT, message, timeout,
+                                              tsig_key));
+        service_.run();
+
+        udp_socket.close();
+        service_.get_io_service().reset();
     }
 
     // This test verifies the DNSClient behavior when a server does not respond
@@ -384,8 +406,8 @@ TEST_F(DNSClientTest, invalidTimeout) {
     runInvalidTimeoutTest();
 }
 
-// Verify that exception is thrown when an attempt to send DNS Update with TSIG
-// is made. This test will be removed/changed once TSIG support is added.
+// Verify that the response to a signed DNS Update must be signed with the
+// key of the request.
 TEST_F(DNSClientTest, runTSIGTest) {
     runTSIGTest();
 }
@@ -36,6 +36,7 @@
 #include <dhcpsrv/utils.h>
 #include <hooks/callout_handle.h>
 #include <hooks/hooks_manager.h>
+#include <util/buffer.h>
 #include <util/strutil.h>
 
 #include <boost/bind.hpp>
@@ -84,9 +85,11 @@ const std::string Dhcpv4Srv::VENDOR_CLASS_PREFIX("VENDOR_CLASS_");
 
 Dhcpv4Srv::Dhcpv4Srv(uint16_t port, const char* dbconfig, const bool use_bcast,
                      const bool direct_response_desired)
-: shutdown_(true), alloc_engine_(), port_(port),
+: shutdown_(true), worker_threads_(0), reclaim_interval_(0),
+    last_reclaim_(0), alloc_engine_(), port_(port),
     use_bcast_(use_bcast), hook_index_pkt4_receive_(-1),
-    hook_index_subnet4_select_(-1), hook_index_pkt4_send_(-1) {
+    hook_index_subnet4_select_(-1), hook_index_pkt4_send_(-1),
+    hook_index_lease4_renew_(-1) {
 
     LOG_DEBUG(dhcp4_logger, DBG_DHCP4_START, DHCP4_OPEN_SOCKET).arg(port);
     try {
@@ -126,6 +129,9 @@ Dhcpv4Srv::Dhcpv4Srv(uint16_t port, const char* dbconfig, const bool use_bcast,
         hook_index_pkt4_receive_   = Hooks.hook_index_pkt4_receive_;
         hook_index_subnet4_select_ = Hooks.hook_index_subnet4_select_;
         hook_index_pkt4_send_      = Hooks.hook_index_pkt4_send_;
+        // The allocation engine registers this one.
+        hook_index_lease4_renew_   =
+            ServerHooks::getServerHooks().getIndex("lease4_renew");
 
         /// @todo call loadLibraries() when handling configuration changes
 
@@ -139,6 +145,7 @@ Dhcpv4Srv::Dhcpv4Srv(uint16_t port, const char* dbconfig, const bool use_bcast,
 }
 
 Dhcpv4Srv::~Dhcpv4Srv() {
+    workers_.stop();
     IfaceMgr::instance().closeSockets();
 }
 
@@ -160,14 +167,20 @@ Dhcpv4Srv::sendPacket(const Pkt4Ptr& packet) {
 
 bool
 Dhcpv4Srv::run() {
+    if (worker_threads_ > 0) {
+        LOG_INFO(dhcp4_logger, DHCP4_WORKER_THREADS).arg(worker_threads_);
+    }
+    if (reclaim_interval_ > 0) {
+        LOG_INFO(dhcp4_logger, DHCP4_RECLAIM_INTERVAL).arg(reclaim_interval_);
+    }
+    workers_.start(worker_threads_);
+
     while (!shutdown_) {
-        /// @todo: calculate actual timeout once we have lease database
-        //cppcheck-suppress variableScope This is temporary anyway
-        const int timeout = 1000;
+        // Wait for a packet until the next reclamation at most.
+        const int timeout = getReceiveTimeout();
 
-        // client's message and server's response
+        // client's message
         Pkt4Ptr query;
-        Pkt4Ptr rsp;
 
         try {
             query = receivePacket(timeout);
@@ -175,258 +188,330 @@ Dhcpv4Srv::run() {
             LOG_ERROR(dhcp4_logger, DHCP4_PACKET_RECEIVE_FAIL).arg(e.what());
         }
 
+        reclaimExpiredLeases();
+
         // Timeout may be reached or signal received, which breaks select()
         // with no reception ocurred
         if (!query) {
             continue;
         }
 
-        // In order to parse the DHCP options, the server needs to use some
-        // configuration information such as: existing option spaces, option
-        // definitions etc. This is the kind of information which is not
-        // available in the libdhcp, so we need to supply our own implementation
-        // of the option parsing function here, which would rely on the
-        // configuration data.
-        query->setCallback(boost::bind(&Dhcpv4Srv::unpackOptions, this,
-                                       _1, _2, _3));
+        // Without the worker threads, the packet is processed right away.
+        if (!workers_.add(boost::bind(&Dhcpv4Srv::processPacket, this,
+                                      query))) {
+            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL, DHCP4_PACKET_QUEUE_FULL)
+                .arg(query->getIface()).arg(workers_.getMaxQueueSize());
+        }
+    }
 
-        bool skip_unpack = false;
+    // Complete the packets already queued.
+    workers_.stop();
 
-        // The packet has just been received so contains the uninterpreted wire
-        // data; execute callouts registered for buffer4_receive.
-        if (HooksManager::calloutsPresent(Hooks.hook_index_buffer4_receive_)) {
-            CalloutHandlePtr callout_handle = getCalloutHandle(query);
+    return (true);
+}
 
-            // Delete previously set arguments
-            callout_handle->deleteAllArguments();
+void
+Dhcpv4Srv::reclaimExpiredLeases() {
+    if (reclaim_interval_ == 0) {
+        return;
+    }
+    const time_t now = time(NULL);
+    if (now - last_reclaim_ < static_cast<time_t>(reclaim_interval_)) {
+        return;
+    }
+    last_reclaim_ = now;
+    try {
+        alloc_engine_->reclaimExpiredLeases4(RECLAIM_MAX_LEASES,
+                                             RECLAIM_TIMEOUT);
+    } catch (const std::exception& ex) {
+        LOG_ERROR(dhcp4_logger, DHCP4_RECLAIM_FAIL).arg(ex.what());
+    }
+}
 
-            // Pass incoming packet as argument
-            callout_handle->setArgument("query4", query);
+int
+Dhcpv4Srv::getReceiveTimeout() const {
+    const int max_timeout = 1000;
+    if (reclaim_interval_ == 0) {
+        return (max_timeout);
+    }
+    const time_t left = last_reclaim_ + reclaim_interval_ - time(NULL);
+    if (left <= 0) {
+        return (0);
+    }
+    return (left < max_timeout ? static_cast<int>(left) : max_timeout);
+}
 
-            // Call callouts
-            HooksManager::callCallouts(Hooks.hook_index_buffer4_receive_,
-                                       *callout_handle);
+void
+Dhcpv4Srv::setWorkerThreads(size_t threads) {
+    worker_threads_ = threads;
+}
 
-            // Callouts decided to skip the next processing step. The next
-            // processing step would to parse the packet, so skip at this
-            // stage means that callouts did the parsing already, so server
-            // should skip parsing.
-            if (callout_handle->getSkip()) {
-                LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS, DHCP4_HOOK_BUFFER_RCVD_SKIP);
-                skip_unpack = true;
-            }
+void
+Dhcpv4Srv::setAllocType(AllocEngine::AllocType type) {
+    alloc_engine_.reset(new AllocEngine(type, 100, false /* false = IPv4 */));
+}
 
-            callout_handle->getArgument("query4", query);
-        }
+void
+Dhcpv4Srv::processPacket(Pkt4Ptr query) {
+    // server's response
+    Pkt4Ptr rsp;
+
+    // In order to parse the DHCP options, the server needs to use some
+    // configuration information such as: existing option spaces, option
+    // definitions etc. This is the kind of information which is not
+    // available in the libdhcp, so we need to supply our own implementation
+    // of the option parsing function here, which would rely on the
+    // configuration data.
+    query->setCallback(boost::bind(&Dhcpv4Srv::unpackOptions, this,
+                                   _1, _2, _3));
+
+    bool skip_unpack = false;
+
+    // The packet has just been received so contains the uninterpreted wire
+    // data; execute callouts registered for buffer4_receive.
+    if (HooksManager::calloutsPresent(Hooks.hook_index_buffer4_receive_)) {
+        CalloutHandlePtr callout_handle = getCalloutHandle(query);
+
+        // Delete previously set arguments
+        callout_handle->deleteAllArguments();
 
-        // Unpack the packet information unless the buffer4_receive callouts
-        // indicated they did it
-        if (!skip_unpack) {
-            try {
-                query->unpack();
-            } catch (const std::exception& e) {
-                // Failed to parse the packet.
-                LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL,
-                          DHCP4_PACKET_PARSE_FAIL).arg(e.what());
-                continue;
-            }
+        // Pass incoming packet as argument
+        callout_handle->setArgument("query4", query);
+
+        // Call callouts
+        HooksManager::callCallouts(Hooks.hook_index_buffer4_receive_,
+                                   *callout_handle);
+
+        // Callouts decided to skip the next processing step. The next
+        // processing step would to parse the packet, so skip at this
+        // stage means that callouts did the parsing already, so server
+        // should skip parsing.
+        if (callout_handle->getSkip()) {
+            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS, DHCP4_HOOK_BUFFER_RCVD_SKIP);
+            skip_unpack = true;
         }
 
-        // Assign this packet to one or more classes if needed. We need to do
-        // this before calling accept(), because getSubnet4() may need client
-        // class information.
-        classifyPacket(query);
+        callout_handle->getArgument("query4", query);
+    }
 
-        // Check whether the message should be further processed or discarded.
-        // There is no need to log anything here. This function logs by itself.
-        if (!accept(query)) {
-            continue;
+    // Unpack the packet information unless the buffer4_receive callouts
+    // indicated they did it
+    if (!skip_unpack) {
+        // The options are created when the server looks at them, most of
+        // the options sent by the clients are never used.
+        query->setLazyOptions(true);
+        try {
+            query->unpack();
+        } catch (const std::exception& e) {
+            // Failed to parse the packet.
+            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL,
+                      DHCP4_PACKET_PARSE_FAIL).arg(e.what());
+            return;
         }
+    }
 
-        // We have sanity checked (in accept() that the Message Type option
-        // exists, so we can safely get it here.
-        int type = query->getType();
-        LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL, DHCP4_PACKET_RECEIVED)
-            .arg(serverReceivedPacketName(type))
-            .arg(type)
-            .arg(query->getIface());
-        LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL_DATA, DHCP4_QUERY_DATA)
-            .arg(type)
-            .arg(query->toText());
+    // Assign this packet to one or more classes if needed. We need to do
+    // this before calling accept(), because getSubnet4() may need client
+    // class information.
+    classifyPacket(query);
 
-        // Let's execute all callouts registered for pkt4_receive
-        if (HooksManager::calloutsPresent(hook_index_pkt4_receive_)) {
-            CalloutHandlePtr callout_handle = getCalloutHandle(query);
+    // Check whether the message should be further processed or discarded.
+    // There is no need to log anything here. This function logs by itself.
+    if (!accept(query)) {
+        return;
+    }
 
-            // Delete previously set arguments
-            callout_handle->deleteAllArguments();
+    // We have sanity checked (in accept() that the Message Type option
+    // exists, so we can safely get it here.
+    int type = query->getType();
+    LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL, DHCP4_PACKET_RECEIVED)
+        .arg(serverReceivedPacketName(type))
+        .arg(type)
+        .arg(query->getIface());
+    LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL_DATA, DHCP4_QUERY_DATA)
+        .arg(type)
+        .arg(query->toText());
 
-            // Pass incoming packet as argument
-            callout_handle->setArgument("query4", query);
+    // Let's execute all callouts registered for pkt4_receive
+    if (HooksManager::calloutsPresent(hook_index_pkt4_receive_)) {
+        CalloutHandlePtr callout_handle = getCalloutHandle(query);
 
-            // Call callouts
-            HooksManager::callCallouts(hook_index_pkt4_receive_,
-                                       *callout_handle);
+        // Delete previously set arguments
+        callout_handle->deleteAllArguments();
 
-            // Callouts decided to skip the next processing step. The next
-            // processing step would to process the packet, so skip at this
-            // stage means drop.
-            if (callout_handle->getSkip()) {
-                LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS, DHCP4_HOOK_PACKET_RCVD_SKIP);
-                continue;
-            }
+        // Pass incoming packet as argument
+        callout_handle->setArgument("query4", query);
+
+        // Call callouts
+        HooksManager::callCallouts(hook_index_pkt4_receive_,
+                                   *callout_handle);
 
-            callout_handle->getArgument("query4", query);
+        // Callouts decided to skip the next processing step. The next
+        // processing step would to process the packet, so skip at this
+        // stage means drop.
+        if (callout_handle->getSkip()) {
+            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS, DHCP4_HOOK_PACKET_RCVD_SKIP);
+            return;
         }
 
-        try {
-            switch (query->getType()) {
-            case DHCPDISCOVER:
-                rsp = processDiscover(query);
-                break;
-
-            case DHCPREQUEST:
-                // Note that REQUEST is used for many things in DHCPv4: for
-                // requesting new leases, renewing existing ones and even
-                // for rebinding.
-                rsp = processRequest(query);
-                break;
-
-            case DHCPRELEASE:
-                processRelease(query);
-                break;
-
-            case DHCPDECLINE:
-                processDecline(query);
-                break;
-
-            case DHCPINFORM:
-                processInform(query);
-                break;
-
-            default:
-                // Only action is to output a message if debug is enabled,
-                // and that is covered by the debug statement before the
-                // "switch" statement.
-                ;
-            }
-        } catch (const bundy::Exception& e) {
-
-            // Catch-all exception (at least for ones based on the isc
-            // Exception class, which covers more or less all that
-            // are explicitly raised in the BUNDY code).  Just log
-            // the problem and ignore the packet. (The problem is logged
-            // as a debug message because debug is disabled by default -
-            // it prevents a DDOS attack based on the sending of problem
-            // packets.)
-            if (dhcp4_logger.isDebugEnabled(DBG_DHCP4_BASIC)) {
-                std::string source = "unknown";
-                HWAddrPtr hwptr = query->getHWAddr();
-                if (hwptr) {
-                    source = hwptr->toText();
-                }
-                LOG_DEBUG(dhcp4_logger, DBG_DHCP4_BASIC,
-                          DHCP4_PACKET_PROCESS_FAIL)
-                    .arg(source).arg(e.what());
+        callout_handle->getArgument("query4", query);
+    }
+
+    // The packets of the same client are processed one at a time, they would
+    // race for the client's lease otherwise.
+    HWAddrPtr hwaddr = query->getHWAddr();
+    ResourceLocks::Locker client_lock(client_locks_, hwaddr ? hwaddr->hwaddr_ :
+                                      std::vector<uint8_t>());
+
+    try {
+        switch (query->getType()) {
+        case DHCPDISCOVER:
+            rsp = processDiscover(query);
+            break;
+
+        case DHCPREQUEST:
+            // Note that REQUEST is used for many things in DHCPv4: for
+            // requesting new leases, renewing existing ones and even
+            // for rebinding.
+            rsp = processRequest(query);
+            break;
+
+        case DHCPRELEASE:
+            processRelease(query);
+            break;
+
+        case DHCPDECLINE:
+            processDecline(query);
+            break;
+
+        case DHCPINFORM:
+            processInform(query);
+            break;
+
+        default:
+            // Only action is to output a message if debug is enabled,
+            // and that is covered by the debug statement before the
+            // "switch" statement.
+            ;
+        }
+    } catch (const bundy::Exception& e) {
+
+        // Catch-all exception (at least for ones based on the isc
+        // Exception class, which covers more or less all that
+        // are explicitly raised in the BUNDY code).  Just log
+        // the problem and ignore the packet. (The problem is logged
+        // as a debug message because debug is disabled by default -
+        // it prevents a DDOS attack based on the sending of problem
+        // packets.)
+        if (dhcp4_logger.isDebugEnabled(DBG_DHCP4_BASIC)) {
+            std::string source = "unknown";
+            HWAddrPtr hwptr = query->getHWAddr();
+            if (hwptr) {
+                source = hwptr->toText();
             }
+            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_BASIC,
+                      DHCP4_PACKET_PROCESS_FAIL)
+                .arg(source).arg(e.what());
         }
+    }
 
-        if (!rsp) {
-            continue;
-        }
+    if (!rsp) {
+        return;
+    }
 
-        // Let's do class specific processing. This is done before
-        // pkt4_send.
-        //
-        /// @todo: decide whether we want to add a new hook point for
-        /// doing class specific processing.
-        if (!classSpecificProcessing(query, rsp)) {
-            /// @todo add more verbosity here
-            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_BASIC, DHCP4_CLASS_PROCESSING_FAILED);
+    // Let's do class specific processing. This is done before
+    // pkt4_send.
+    //
+    /// @todo: decide whether we want to add a new hook point for
+    /// doing class specific processing.
+    if (!classSpecificProcessing(query, rsp)) {
+        /// @todo add more verbosity here
+        LOG_DEBUG(dhcp4_logger, DBG_DHCP4_BASIC, DHCP4_CLASS_PROCESSING_FAILED);
 
-            continue;
+        return;
+    }
+
+    // Specifies if server should do the packing
+    bool skip_pack = false;
+
+    // Execute all callouts registered for pkt4_send
+    if (HooksManager::calloutsPresent(hook_index_pkt4_send_)) {
+        CalloutHandlePtr callout_handle = getCalloutHandle(query);
+
+        // Delete all previous arguments
+        callout_handle->deleteAllArguments();
+
+        // Clear skip flag if it was set in previous callouts
+        callout_handle->setSkip(false);
+
+        // Set our response
+        callout_handle->setArgument("response4", rsp);
+
+        // Call all installed callouts
+        HooksManager::callCallouts(hook_index_pkt4_send_,
+                                   *callout_handle);
+
+        // Callouts decided to skip the next processing step. The next
+        // processing step would to send the packet, so skip at this
+        // stage means "drop response".
+        if (callout_handle->getSkip()) {
+            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS, DHCP4_HOOK_PACKET_SEND_SKIP);
+            skip_pack = true;
         }
+    }
 
-        // Specifies if server should do the packing
-        bool skip_pack = false;
+    if (!skip_pack) {
+        try {
+            rsp->pack();
+        } catch (const std::exception& e) {
+            LOG_ERROR(dhcp4_logger, DHCP4_PACKET_SEND_FAIL)
+                .arg(e.what());
+        }
+    }
 
-        // Execute all callouts registered for pkt4_send
-        if (HooksManager::calloutsPresent(hook_index_pkt4_send_)) {
+    try {
+        // Now all fields and options are constructed into output wire buffer.
+        // Option objects modification does not make sense anymore. Hooks
+        // can only manipulate wire buffer at this stage.
+        // Let's execute all callouts registered for buffer4_send
+        if (HooksManager::calloutsPresent(Hooks.hook_index_buffer4_send_)) {
             CalloutHandlePtr callout_handle = getCalloutHandle(query);
 
-            // Delete all previous arguments
+            // Delete previously set arguments
             callout_handle->deleteAllArguments();
 
-            // Clear skip flag if it was set in previous callouts
-            callout_handle->setSkip(false);
-
-            // Set our response
+            // Pass incoming packet as argument
             callout_handle->setArgument("response4", rsp);
 
-            // Call all installed callouts
-            HooksManager::callCallouts(hook_index_pkt4_send_,
+            // Call callouts
+            HooksManager::callCallouts(Hooks.hook_index_buffer4_send_,
                                        *callout_handle);
 
             // Callouts decided to skip the next processing step. The next
-            // processing step would to send the packet, so skip at this
-            // stage means "drop response".
+            // processing step would to parse the packet, so skip at this
+            // stage means drop.
             if (callout_handle->getSkip()) {
-                LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS, DHCP4_HOOK_PACKET_SEND_SKIP);
-                skip_pack = true;
+                LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS,
+                          DHCP4_HOOK_BUFFER_SEND_SKIP);
+                return;
             }
-        }
 
-        if (!skip_pack) {
-            try {
-                rsp->pack();
-            } catch (const std::exception& e) {
-                LOG_ERROR(dhcp4_logger, DHCP4_PACKET_SEND_FAIL)
-                    .arg(e.what());
-            }
+            callout_handle->getArgument("response4", rsp);
         }
 
-        try {
-            // Now all fields and options are constructed into output wire buffer.
-            // Option objects modification does not make sense anymore. Hooks
-            // can only manipulate wire buffer at this stage.
-            // Let's execute all callouts registered for buffer4_send
-            if (HooksManager::calloutsPresent(Hooks.hook_index_buffer4_send_)) {
-                CalloutHandlePtr callout_handle = getCalloutHandle(query);
-
-                // Delete previously set arguments
-                callout_handle->deleteAllArguments();
-
-                // Pass incoming packet as argument
-                callout_handle->setArgument("response4", rsp);
-
-                // Call callouts
-                HooksManager::callCallouts(Hooks.hook_index_buffer4_send_,
-                                           *callout_handle);
-
-                // Callouts decided to skip the next processing step. The next
-                // processing step would to parse the packet, so skip at this
-                // stage means drop.
-                if (callout_handle->getSkip()) {
-                    LOG_DEBUG(dhcp4_logger, DBG_DHCP4_HOOKS,
-                              DHCP4_HOOK_BUFFER_SEND_SKIP);
-                    continue;
-                }
+        LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL_DATA,
+                  DHCP4_RESPONSE_DATA)
+            .arg(static_cast<int>(rsp->getType())).arg(rsp->toText());
 
-                callout_handle->getArgument("response4", rsp);
-            }
+        // Hold the response until the leases it carries are on the disk
+        // (when the lease database batches the writes).
+        LeaseMgrFactory::instance().sync();
 
-            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL_DATA,
-                      DHCP4_RESPONSE_DATA)
-                .arg(static_cast<int>(rsp->getType())).arg(rsp->toText());
-
-            sendPacket(rsp);
-        } catch (const std::exception& e) {
-            LOG_ERROR(dhcp4_logger, DHCP4_PACKET_SEND_FAIL)
-                .arg(e.what());
-        }
+        sendPacket(rsp);
+    } catch (const std::exception& e) {
+        LOG_ERROR(dhcp4_logger, DHCP4_PACKET_SEND_FAIL)
+            .arg(e.what());
     }
-
-    return (true);
 }
 
 string
@@ -597,7 +682,7 @@ Dhcpv4Srv::appendRequestedOptions(const Pkt4Ptr& question, Pkt4Ptr& msg) {
             Subnet::OptionDescriptor desc =
                 subnet->getOptionDescriptor("dhcp4", *opt);
             if (desc.option && !msg->getOption(*opt)) {
-                msg->addOption(desc.option);
+                msg->addOption(desc.option, desc.packed);
             }
         }
     }
@@ -648,7 +733,7 @@ Dhcpv4Srv::appendRequestedVendorOptions(const Pkt4Ptr& question, Pkt4Ptr& answer
             Subnet::OptionDescriptor desc = subnet->getVendorOptionDescriptor(vendor_id,
                                                                               *code);
             if (desc.option) {
-                vendor_rsp->addOption(desc.option);
+                vendor_rsp->addOption(desc.option, desc.packed);
                 added = true;
             }
         }
@@ -687,7 +772,7 @@ Dhcpv4Srv::appendBasicOptions(const Pkt4Ptr& question, Pkt4Ptr& msg) {
             Subnet::OptionDescriptor desc =
                 subnet->getOptionDescriptor("dhcp4", required_options[i]);
             if (desc.option) {
-                msg->addOption(desc.option);
+                msg->addOption(desc.option, desc.packed);
             }
         }
     }
@@ -902,7 +987,7 @@ queueNameChangeRequest(const bundy::dhcp_ddns::NameChangeType chg_type,
     CfgMgr::instance().getD2ClientMgr().sendRequest(ncr);
 }
 
-void
+Lease4Ptr
 Dhcpv4Srv::assignLease(const Pkt4Ptr& question, Pkt4Ptr& answer) {
 
     // We need to select a subnet the client is connected in.
@@ -923,7 +1008,7 @@ Dhcpv4Srv::assignLease(const Pkt4Ptr& question, Pkt4Ptr& answer) {
             .arg(serverReceivedPacketName(question->getType()));
         answer->setType(DHCPNAK);
         answer->setYiaddr(IOAddress("0.0.0.0"));
-        return;
+        return (Lease4Ptr());
     }
 
     // Set up siaddr. Perhaps assignLease is not the best place to call this
@@ -1082,6 +1167,8 @@ Dhcpv4Srv::assignLease(const Pkt4Ptr& question, Pkt4Ptr& answer) {
         answer->delOption(DHO_FQDN);
         answer->delOption(DHO_HOST_NAME);
     }
+
+    return (lease);
 }
 
 void
@@ -1227,6 +1314,16 @@ Dhcpv4Srv::processRequest(Pkt4Ptr& request) {
     copyDefaultFields(request, ack);
     appendDefaultOptions(ack, DHCPACK);
 
+    // Most of the requests renew the lease of a client served recently,
+    // which the client cache allows to do quickly.
+    std::vector<uint8_t> signature;
+    const bool cacheable = getClientSignature(request, signature);
+    if (cacheable && renewFromCache(request, ack, signature)) {
+        adjustIfaceData(request, ack);
+        appendServerID(ack);
+        return (ack);
+    }
+
     // If REQUEST message contains the FQDN or Hostname option, server
     // should respond to the client with the appropriate FQDN or Hostname
     // option to indicate if it takes responsibility for the DNS updates.
@@ -1236,7 +1333,7 @@ Dhcpv4Srv::processRequest(Pkt4Ptr& request) {
     // Note that we treat REQUEST message uniformly, regardless if this is a
     // first request (requesting for new address), renewing existing address
     // or even rebinding.
-    assignLease(request, ack);
+    Lease4Ptr lease = assignLease(request, ack);
 
     // Adding any other options makes sense only when we got the lease.
     if (ack->getYiaddr() != IOAddress("0.0.0.0")) {
@@ -1248,6 +1345,10 @@ Dhcpv4Srv::processRequest(Pkt4Ptr& request) {
         appendBasicOptions(request, ack);
     }
 
+    if (cacheable) {
+        cacheClient(request, ack, lease, signature);
+    }
+
     // Set the src/dest IP address, port and interface for the outgoing
     // packet.
     adjustIfaceData(request, ack);
@@ -1257,6 +1358,161 @@ Dhcpv4Srv::processRequest(Pkt4Ptr& request) {
     return (ack);
 }
 
+bool
+Dhcpv4Srv::getClientSignature(const Pkt4Ptr& request,
+                              std::vector<uint8_t>& signature) const {
+    static const IOAddress notset("0.0.0.0");
+    static const IOAddress bcast("255.255.255.255");
+
+    if (client_cache_.getMaxSize() == 0) {
+        return (false);
+    }
+
+    // The callouts may select another subnet, change the lease or the
+    // response, and the names lead to DNS updates: the fast path would
+    // skip all of them.
+    if (HooksManager::calloutsPresent(hook_index_subnet4_select_) ||
+        HooksManager::calloutsPresent(hook_index_lease4_renew_) ||
+        HooksManager::calloutsPresent(hook_index_pkt4_send_) ||
+        request->getOption(DHO_FQDN) || request->getOption(DHO_HOST_NAME)) {
+        return (false);
+    }
+
+    HWAddrPtr hwaddr = request->getHWAddr();
+    if (!hwaddr || hwaddr->hwaddr_.empty()) {
+        return (false);
+    }
+
+    bundy::util::OutputBuffer buf(64);
+
+    // What the subnet is selected with (see selectSubnet()).
+    if (request->isRelayed()) {
+        buf.writeUint8(1);
+        buf.writeUint32(request->getGiaddr());
+    } else if ((request->getLocalAddr() != bcast) &&
+               (request->getCiaddr() != notset)) {
+        buf.writeUint8(2);
+        buf.writeUint32(request->getCiaddr());
+    } else {
+        buf.writeUint8(3);
+        buf.writeData(request->getIface().c_str(),
+                      request->getIface().size() + 1);
+    }
+    for (ClientClasses::const_iterator cclass = request->classes_.begin();
+         cclass != request->classes_.end(); ++cclass) {
+        buf.writeData(cclass->c_str(), cclass->size() + 1);
+    }
+
+    // The options of the request the response depends on, in full.
+    static const uint8_t types[] = {
+        DHO_DHCP_CLIENT_IDENTIFIER,
+        DHO_DHCP_PARAMETER_REQUEST_LIST,
+        DHO_VIVSO_SUBOPTIONS };
+    for (int i = 0; i < sizeof(types) / sizeof(types[0]); ++i) {
+        OptionPtr opt = request->getOption(types[i]);
+        if (opt) {
+            opt->pack(buf);
+        } else {
+            buf.writeUint8(DHO_PAD);
+        }
+    }
+
+    const uint8_t* data = static_cast<const uint8_t*>(buf.getData());
+    signature.assign(data, data + buf.getLength());
+    return (true);
+}
+
+bool
+Dhcpv4Srv::renewFromCache(const Pkt4Ptr& request, Pkt4Ptr& answer,
+                          const std::vector<uint8_t>& signature) {
+    static const IOAddress notset("0.0.0.0");
+
+    HWAddrPtr hwaddr = request->getHWAddr();
+    ClientCacheEntry4 entry;
+    if (!client_cache_.get(hwaddr->hwaddr_, signature, entry)) {
+        return (false);
+    }
+
+    // A client asking for another address goes the full way.
+    OptionCustomPtr requested = boost::dynamic_pointer_cast<
+        OptionCustom>(request->getOption(DHO_DHCP_REQUESTED_ADDRESS));
+    if (((request->getCiaddr() != notset) &&
+         (request->getCiaddr() != entry.lease_->addr_)) ||
+        (requested && (requested->readAddress() != entry.lease_->addr_))) {
+        return (false);
+    }
+
+    // An expired lease may have been taken over by another client.
+    if (entry.lease_->expired()) {
+        client_cache_.remove(hwaddr->hwaddr_);
+        return (false);
+    }
+
+    // Renew it as the allocation engine would do (see
+    // AllocEngine::renewLease4()).
+    Lease4Ptr lease(new Lease4(*entry.lease_));
+    lease->cltt_ = time(NULL);
+    lease->t1_ = entry.subnet_->getT1();
+    lease->t2_ = entry.subnet_->getT2();
+    lease->valid_lft_ = entry.subnet_->getValid();
+    try {
+        LeaseMgrFactory::instance().updateLease4(lease);
+    } catch (const Exception& ex) {
+        // The lease was deleted meanwhile, e.g. by the administrator.
+        LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL, DHCP4_CACHED_RENEW_FAIL)
+            .arg(lease->addr_.toText()).arg(ex.what());
+        client_cache_.remove(hwaddr->hwaddr_);
+        return (false);
+    }
+    client_cache_.update(hwaddr->hwaddr_, lease);
+
+    LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL, DHCP4_CACHED_RENEW)
+        .arg(lease->addr_.toText()).arg(hwaddr->toText());
+
+    answer->setYiaddr(lease->addr_);
+    answer->setSiaddr(entry.subnet_->getSiaddr());
+    answer->setPackedOptions(entry.options_);
+    return (true);
+}
+
+void
+Dhcpv4Srv::cacheClient(const Pkt4Ptr& request, const Pkt4Ptr& answer,
+                       const Lease4Ptr& lease,
+                       const std::vector<uint8_t>& signature) {
+    const HWAddrPtr& hwaddr = request->getHWAddr();
+    Subnet4Ptr subnet;
+    if (lease && (answer->getType() == DHCPACK) && lease->hostname_.empty() &&
+        !lease->fqdn_fwd_ && !lease->fqdn_rev_) {
+        subnet = selectSubnet(request);
+    }
+    if (!subnet || (subnet->getID() != lease->subnet_id_)) {
+        client_cache_.remove(hwaddr->hwaddr_);
+        return;
+    }
+
+    ClientCacheEntry4 entry;
+    entry.subnet_ = subnet;
+    entry.lease_.reset(new Lease4(*lease));
+    entry.signature_ = signature;
+
+    // The options copied from the request by copyDefaultFields() are added
+    // to each response.
+    bundy::util::OutputBuffer buf(256);
+    const OptionCollection& options = answer->getOptions();
+    for (OptionCollection::const_iterator opt = options.begin();
+         opt != options.end(); ++opt) {
+        if ((opt->first != DHO_DHCP_MESSAGE_TYPE) &&
+            (opt->first != DHO_DHCP_CLIENT_IDENTIFIER) &&
+            (opt->first != DHO_DHCP_AGENT_OPTIONS)) {
+            opt->second->pack(buf);
+        }
+    }
+    const uint8_t* data = static_cast<const uint8_t*>(buf.getData());
+    entry.options_.reset(new OptionBuffer(data, data + buf.getLength()));
+
+    client_cache_.add(hwaddr->hwaddr_, entry);
+}
+
 void
 Dhcpv4Srv::processRelease(Pkt4Ptr& release) {
 
@@ -1339,6 +1595,9 @@ Dhcpv4Srv::processRelease(Pkt4Ptr& release) {
         if (!skip) {
             bool success = LeaseMgrFactory::instance().deleteLease(lease->addr_);
 
+            // The address may go to another client right away.
+            client_cache_.remove(release->getHWAddr()->hwaddr_);
+
             if (success) {
                 // Release successful
                 LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL, DHCP4_RELEASE)
@@ -1844,6 +2103,11 @@ void Dhcpv4Srv::classifyPacket(const Pkt4Ptr& pkt) {
 
 bool Dhcpv4Srv::classSpecificProcessing(const Pkt4Ptr& query, const Pkt4Ptr& rsp) {
 
+    // Most clients belong to no class, don't select their subnet again.
+    if (query->classes_.empty()) {
+        return (true);
+    }
+
     Subnet4Ptr subnet = selectSubnet(query);
     if (!subnet) {
         return (true);
@@ -25,6 +25,9 @@
 #include <dhcpsrv/d2_client_mgr.h>
 #include <dhcpsrv/subnet.h>
 #include <dhcpsrv/alloc_engine.h>
+#include <dhcpsrv/client_cache.h>
+#include <dhcpsrv/resource_locks.h>
+#include <dhcpsrv/thread_pool.h>
 #include <hooks/callout_handle.h>
 
 #include <boost/noncopyable.hpp>
@@ -101,10 +104,79 @@ public:
     /// their correctness, generates appropriate answer (if needed) and
     /// transmits respones.
     ///
+    /// If worker threads were requested with @c setWorkerThreads(), the
+    /// received packets are processed by them, while this loop only
+    /// receives.  The packets of the same client are never processed in
+    /// parallel.  If the threads don't keep up, the packets are dropped.
+    ///
     /// @return true, if being shut down gracefully, fail if experienced
     ///         critical error.
     bool run();
 
+    /// @brief Sets the number of the threads processing the packets.
+    ///
+    /// Takes effect when @c run() is called.  With 0 (the default), the
+    /// packets are processed one after another by the thread calling
+    /// @c run().
+    ///
+    /// @param threads Number of the worker threads.
+    void setWorkerThreads(size_t threads);
+
+    /// @brief Returns the number of the threads processing the packets.
+    size_t getWorkerThreads() const {
+        return (worker_threads_);
+    }
+
+    /// @brief Selects the algorithm picking the addresses to allocate.
+    ///
+    /// The server uses the iterative allocator by default.  It must not be
+    /// called while the packets are being processed.
+    ///
+    /// @param type Type of the allocator.
+    void setAllocType(AllocEngine::AllocType type);
+
+    /// @brief Sets the number of the clients kept to renew their leases.
+    ///
+    /// The server keeps the subnet, the lease and the options sent for
+    /// the clients it served recently.  A REQUEST renewing the lease of
+    /// such a client is then answered with a single update of the lease
+    /// database (see @c renewFromCache()).  The cache is disabled by
+    /// default.
+    ///
+    /// @param size Maximum number of clients, 0 to disable the cache.
+    void setClientCacheSize(size_t size) {
+        client_cache_.setMaxSize(size);
+    }
+
+    /// @brief Returns the maximum number of clients kept in the cache.
+    size_t getClientCacheSize() const {
+        return (client_cache_.getMaxSize());
+    }
+
+    /// @brief Sets the interval of the expired leases reclamation.
+    ///
+    /// Every @c seconds, @c run() reclaims at most
+    /// @c RECLAIM_MAX_LEASES expired leases, spending no more than
+    /// @c RECLAIM_TIMEOUT milliseconds (see
+    /// @c AllocEngine::reclaimExpiredLeases4()).  With 0 (the default)
+    /// the expired leases are only reused when allocated again.
+    ///
+    /// @param seconds Interval in seconds, 0 to disable the reclamation.
+    void setReclaimInterval(uint32_t seconds) {
+        reclaim_interval_ = seconds;
+    }
+
+    /// @brief Returns the interval of the expired leases reclamation.
+    uint32_t getReclaimInterval() const {
+        return (reclaim_interval_);
+    }
+
+    /// @brief Maximum number of leases reclaimed at once.
+    static const size_t RECLAIM_MAX_LEASES = 100;
+
+    /// @brief Maximum time spent reclaiming the leases at once, in ms.
+    static const uint32_t RECLAIM_TIMEOUT = 250;
+
     /// @brief Instructs the server to shut down.
     void shutdown();
 
@@ -316,11 +388,61 @@ protected:
     ///
     /// Returns ACK message, NAK message, or NULL
     ///
+    /// The lease of a client found in the client cache is renewed by
+    /// @c renewFromCache().
+    ///
     /// @param request a message received from client
     ///
     /// @return ACK or NAK message
     Pkt4Ptr processRequest(Pkt4Ptr& request);
 
+    /// @brief Computes the signature of a REQUEST for the client cache.
+    ///
+    /// The signature holds what the subnet selection and the options sent
+    /// to the client depend on: the relay address (or the client's or the
+    /// interface's address), the client classes, the client identifier,
+    /// the requested options and the requested vendor options.  The
+    /// requests carrying a name, and those processed by callouts for
+    /// subnet4_select, lease4_renew or pkt4_send, don't use the cache.
+    ///
+    /// @param request a REQUEST message received from client
+    /// @param [out] signature the signature of the message
+    ///
+    /// @return true if the message may be answered from the cache
+    bool getClientSignature(const Pkt4Ptr& request,
+                            std::vector<uint8_t>& signature) const;
+
+    /// @brief Renews the lease of a client found in the client cache.
+    ///
+    /// The client must have been served for a REQUEST with the same
+    /// signature, under the same configuration, and its lease must not
+    /// have expired: as the clients only take over the expired leases of
+    /// others, the lease is still the client's.  The lease is renewed
+    /// with a single update of the lease database, and the options of the
+    /// previous response are copied to the ACK.
+    ///
+    /// @param request a REQUEST message received from client
+    /// @param answer the ACK message, to complete
+    /// @param signature the signature of the request
+    ///
+    /// @return true if the lease was renewed, false if the request must
+    ///         be processed in full
+    bool renewFromCache(const Pkt4Ptr& request, Pkt4Ptr& answer,
+                        const std::vector<uint8_t>& signature);
+
+    /// @brief Keeps a client in the client cache after a REQUEST.
+    ///
+    /// The options of the ACK, except those copied from the request, are
+    /// kept in the on-wire format.  A client getting a NAK is removed.
+    ///
+    /// @param request a REQUEST message received from client
+    /// @param answer the ACK or NAK message
+    /// @param lease the lease assigned to the client, if any
+    /// @param signature the signature of the request
+    void cacheClient(const Pkt4Ptr& request, const Pkt4Ptr& answer,
+                     const Lease4Ptr& lease,
+                     const std::vector<uint8_t>& signature);
+
     /// @brief Stub function that will handle incoming RELEASE messages.
     ///
     /// In DHCPv4, server does not respond to RELEASE messages, therefore
@@ -377,7 +499,9 @@ protected:
     ///
     /// @param question DISCOVER or REQUEST message from client
     /// @param answer OFFER or ACK/NAK message (lease options will be added here)
-    void assignLease(const Pkt4Ptr& question, Pkt4Ptr& answer);
+    ///
+    /// @return the lease assigned, or NULL if none was
+    Lease4Ptr assignLease(const Pkt4Ptr& question, Pkt4Ptr& answer);
 
     /// @brief Append basic options if they are not present.
     ///
@@ -636,6 +760,39 @@ protected:
     /// initiate server shutdown procedure.
     volatile bool shutdown_;
 
+    /// @brief Number of the threads to process the packets in @c run().
+    size_t worker_threads_;
+
+    /// @brief The threads processing the packets.
+    ///
+    /// The derived classes pause them while the configuration changes.
+    ThreadPool workers_;
+
+    /// @brief The clients whose packets are being processed.
+    ResourceLocks client_locks_;
+
+    /// @brief The clients recently served, to renew their leases quickly.
+    ClientCache4 client_cache_;
+
+    /// @brief Interval of the expired leases reclamation in seconds.
+    uint32_t reclaim_interval_;
+
+    /// @brief Time the expired leases were last reclaimed.
+    time_t last_reclaim_;
+
+    /// @brief Reclaims the expired leases if the interval elapsed.
+    ///
+    /// Called by @c run() between the packets received.  The errors are
+    /// logged, so the server keeps running.
+    void reclaimExpiredLeases();
+
+    /// @brief Returns the timeout of the packet reception in seconds.
+    ///
+    /// This is the time left until the next reclamation of the expired
+    /// leases, up to 1000 seconds, so that an idle server still reclaims
+    /// them on time.
+    int getReceiveTimeout() const;
+
     /// @brief dummy wrapper around IfaceMgr::receive4
     ///
     /// This method is useful for testing purposes, where its replacement
@@ -648,6 +805,14 @@ protected:
     /// simulates transmission of a packet. For that purpose it is protected.
     virtual void sendPacket(const Pkt4Ptr& pkt);
 
+    /// @brief Processes a received packet and sends the response.
+    ///
+    /// Called by @c run() for every packet received, possibly by one of
+    /// the worker threads.
+    ///
+    /// @param query The received packet.
+    void processPacket(Pkt4Ptr query);
+
     /// @brief Implements a callback function to parse options in the message.
     ///
     /// @param buf a A buffer holding options in on-wire format.
@@ -709,6 +874,7 @@ private:
     int hook_index_pkt4_receive_;
     int hook_index_subnet4_select_;
     int hook_index_pkt4_send_;
+    int hook_index_lease4_renew_;
 };
 
 }; // namespace bundy::dhcp
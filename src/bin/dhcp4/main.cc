@@ -23,6 +23,8 @@
 
 #include <iostream>
 
+#include <string.h>
+
 using namespace bundy::dhcp;
 using namespace std;
 
@@ -41,11 +43,20 @@ const char* const DHCP4_NAME = "bundy-dhcp4";
 
 void
 usage() {
-    cerr << "Usage: " << DHCP4_NAME << " [-v] [-s] [-p number]" << endl;
+    cerr << "Usage: " << DHCP4_NAME << " [-v] [-s] [-p number] [-n threads]"
+         << " [-a allocator] [-c clients] [-e seconds]" << endl;
     cerr << "  -v: verbose output" << endl;
     cerr << "  -s: stand-alone mode (don't connect to BUNDY)" << endl;
     cerr << "  -p number: specify non-standard port number 1-65535 "
          << "(useful for testing only)" << endl;
+    cerr << "  -n threads: number of threads processing the packets "
+         << "(default 0, processed by the main thread)" << endl;
+    cerr << "  -a allocator: algorithm picking the addresses, iterative "
+         << "(default), hashed, random or indexed" << endl;
+    cerr << "  -c clients: number of clients kept to renew their leases "
+         << "quickly (default 0, disabled)" << endl;
+    cerr << "  -e seconds: interval of the expired leases reclamation "
+         << "(default 0, disabled)" << endl;
     exit(EXIT_FAILURE);
 }
 } // end of anonymous namespace
@@ -57,8 +68,13 @@ main(int argc, char* argv[]) {
                                          // useful for testing only.
     bool stand_alone = false;  // Should be connect to BUNDY msgq?
     bool verbose_mode = false; // Should server be verbose?
+    int worker_threads = 0;    // Threads processing the packets
+    int client_cache_size = 0; // Clients kept to renew their leases
+    int reclaim_interval = 0;  // Seconds between the leases reclamations
+    // Algorithm picking the addresses
+    AllocEngine::AllocType alloc_type = AllocEngine::ALLOC_ITERATIVE;
 
-    while ((ch = getopt(argc, argv, "vsp:")) != -1) {
+    while ((ch = getopt(argc, argv, "vsp:n:a:c:e:")) != -1) {
         switch (ch) {
         case 'v':
             verbose_mode = true;
@@ -83,6 +99,60 @@ main(int argc, char* argv[]) {
             }
             break;
 
+        case 'n':
+            try {
+                worker_threads = boost::lexical_cast<int>(optarg);
+            } catch (const boost::bad_lexical_cast &) {
+                worker_threads = -1;
+            }
+            if (worker_threads < 0) {
+                cerr << "Failed to parse number of threads: [" << optarg
+                     << "]." << endl;
+                usage();
+            }
+            break;
+
+        case 'a':
+            if (strcmp(optarg, "iterative") == 0) {
+                alloc_type = AllocEngine::ALLOC_ITERATIVE;
+            } else if (strcmp(optarg, "hashed") == 0) {
+                alloc_type = AllocEngine::ALLOC_HASHED;
+            } else if (strcmp(optarg, "random") == 0) {
+                alloc_type = AllocEngine::ALLOC_RANDOM;
+            } else if (strcmp(optarg, "indexed") == 0) {
+                alloc_type = AllocEngine::ALLOC_INDEXED;
+            } else {
+                cerr << "Unknown allocator: [" << optarg << "]." << endl;
+                usage();
+            }
+            break;
+
+        case 'c':
+            try {
+                client_cache_size = boost::lexical_cast<int>(optarg);
+            } catch (const boost::bad_lexical_cast &) {
+                client_cache_size = -1;
+            }
+            if (client_cache_size < 0) {
+                cerr << "Failed to parse number of clients: [" << optarg
+                     << "]." << endl;
+                usage();
+            }
+            break;
+
+        case 'e':
+            try {
+                reclaim_interval = boost::lexical_cast<int>(optarg);
+            } catch (const boost::bad_lexical_cast &) {
+                reclaim_interval = -1;
+            }
+            if (reclaim_interval < 0) {
+                cerr << "Failed to parse reclamation interval: [" << optarg
+                     << "]." << endl;
+                usage();
+            }
+            break;
+
         default:
             usage();
         }
@@ -122,6 +192,10 @@ main(int argc, char* argv[]) {
         } else {
             LOG_DEBUG(dhcp4_logger, DBG_DHCP4_START, DHCP4_STANDALONE);
         }
+        server.setWorkerThreads(worker_threads);
+        server.setAllocType(alloc_type);
+        server.setClientCacheSize(client_cache_size);
+        server.setReclaimInterval(reclaim_interval);
         server.run();
         LOG_INFO(dhcp4_logger, DHCP4_SHUTDOWN);
 
@@ -565,6 +565,48 @@ TEST_F(Dhcpv4SrvTest, DiscoverBasic) {
     checkClientId(offer, clientid);
 }
 
+// This test verifies that the options of the configuration packed in
+// advance are sent as if they were packed for the response.
+TEST_F(Dhcpv4SrvTest, DiscoverPrepackedOptions) {
+    IfaceMgrTestConfig test_config(true);
+    IfaceMgr::instance().openSockets4();
+
+    boost::scoped_ptr<NakedDhcpv4Srv> srv;
+    ASSERT_NO_THROW(srv.reset(new NakedDhcpv4Srv(0)));
+    configureRequestedOptions();
+
+    Pkt4Ptr dis = Pkt4Ptr(new Pkt4(DHCPDISCOVER, 1234));
+    dis->setRemoteAddr(IOAddress("192.0.2.1"));
+    dis->addOption(generateClientId());
+    dis->setIface("eth1");
+    addPrlOption(dis);
+
+    // The options added to the subnet by the test are not packed yet.
+    Pkt4Ptr offer = srv->processDiscover(dis);
+    checkResponse(offer, DHCPOFFER, 1234);
+    ASSERT_NO_THROW(offer->pack());
+    const size_t offset = Pkt4::DHCPV4_PKT_HDR_LEN +
+        sizeof(DHCP_OPTIONS_COOKIE);
+    ASSERT_GT(offer->getBuffer().getLength(), offset);
+    const uint8_t* data =
+        static_cast<const uint8_t*>(offer->getBuffer().getData());
+    const std::vector<uint8_t> options(data + offset,
+                                       data + offer->getBuffer().getLength());
+
+    subnet_->packOptions();
+    ASSERT_TRUE(subnet_->getOptionDescriptor("dhcp4", DHO_DOMAIN_NAME).packed);
+    offer = srv->processDiscover(dis);
+    checkResponse(offer, DHCPOFFER, 1234);
+    EXPECT_TRUE(basicOptionsPresent(offer));
+    EXPECT_EQ(subnet_->getOptionDescriptor("dhcp4", DHO_LOG_SERVERS).option,
+              offer->getOption(DHO_LOG_SERVERS));
+    ASSERT_NO_THROW(offer->pack());
+    data = static_cast<const uint8_t*>(offer->getBuffer().getData());
+    EXPECT_TRUE(options ==
+                std::vector<uint8_t>(data + offset,
+                                     data + offer->getBuffer().getLength()));
+}
+
 
 // This test verifies that incoming DISCOVER can be handled properly, that an
 // OFFER is generated, that the response has an address and that address
@@ -1073,6 +1115,131 @@ TEST_F(Dhcpv4SrvTest, RenewBasic) {
     EXPECT_TRUE(LeaseMgrFactory::instance().deleteLease(addr));
 }
 
+// This test verifies that the leases of the clients served recently are
+// renewed from the client cache, with the same response.
+TEST_F(Dhcpv4SrvTest, RenewFromCache) {
+    IfaceMgrTestConfig test_config(true);
+    IfaceMgr::instance().openSockets4();
+
+    boost::scoped_ptr<NakedDhcpv4Srv> srv;
+    ASSERT_NO_THROW(srv.reset(new NakedDhcpv4Srv(0)));
+    srv->setClientCacheSize(10);
+    EXPECT_EQ(10, srv->getClientCacheSize());
+    configureRequestedOptions();
+
+    const IOAddress addr("192.0.2.106");
+    OptionPtr clientid = generateClientId();
+    const uint8_t mac[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe };
+    Lease4Ptr used(new Lease4(addr, mac, sizeof(mac),
+                              &client_id_->getDuid()[0],
+                              client_id_->getDuid().size(),
+                              100, 50, 75, time(NULL) - 10,
+                              subnet_->getID()));
+    ASSERT_TRUE(LeaseMgrFactory::instance().addLease(used));
+
+    Pkt4Ptr req(new Pkt4(DHCPREQUEST, 1234));
+    req->setRemoteAddr(addr);
+    req->setCiaddr(addr);
+    req->setIface("eth0");
+    req->setHWAddr(HTYPE_ETHER, sizeof(mac),
+                   std::vector<uint8_t>(mac, mac + sizeof(mac)));
+    req->addOption(clientid);
+    req->addOption(srv->getServerID());
+    addPrlOption(req);
+
+    // The first response is built in full.
+    Pkt4Ptr ack = srv->processRequest(req);
+    checkResponse(ack, DHCPACK, 1234);
+    EXPECT_EQ(addr, ack->getYiaddr());
+    EXPECT_FALSE(ack->getPackedOptions());
+    ASSERT_NO_THROW(ack->pack());
+    const util::OutputBuffer& full = ack->getBuffer();
+    const std::vector<uint8_t> full_data(static_cast<const uint8_t*>
+                                         (full.getData()),
+                                         static_cast<const uint8_t*>
+                                         (full.getData()) + full.getLength());
+
+    // Make the lease look older.
+    Lease4Ptr lease = LeaseMgrFactory::instance().getLease4(addr);
+    ASSERT_TRUE(lease);
+    lease->cltt_ = time(NULL) - 20;
+    ASSERT_NO_THROW(LeaseMgrFactory::instance().updateLease4(lease));
+
+    // The second one copies the options of the first one.
+    ack = srv->processRequest(req);
+    checkResponse(ack, DHCPACK, 1234);
+    EXPECT_EQ(addr, ack->getYiaddr());
+    EXPECT_TRUE(ack->getPackedOptions());
+    checkServerId(ack, srv->getServerID());
+    checkClientId(ack, clientid);
+    ASSERT_NO_THROW(ack->pack());
+    const util::OutputBuffer& fast = ack->getBuffer();
+    ASSERT_EQ(full_data.size(), fast.getLength());
+    Pkt4Ptr rcvd(new Pkt4(static_cast<const uint8_t*>(fast.getData()),
+                          fast.getLength()));
+    ASSERT_NO_THROW(rcvd->unpack());
+    boost::shared_ptr<OptionInt<uint32_t> > lease_time =
+        boost::dynamic_pointer_cast<OptionInt<uint32_t> >
+        (rcvd->getOption(DHO_DHCP_LEASE_TIME));
+    ASSERT_TRUE(lease_time);
+    EXPECT_EQ(subnet_->getValid(), lease_time->getValue());
+    EXPECT_TRUE(rcvd->getOption(DHO_DOMAIN_NAME_SERVERS));
+    EXPECT_TRUE(rcvd->getOption(DHO_DOMAIN_NAME));
+    EXPECT_TRUE(rcvd->getOption(DHO_LOG_SERVERS));
+
+    // The lease was renewed.
+    lease = LeaseMgrFactory::instance().getLease4(addr);
+    ASSERT_TRUE(lease);
+    EXPECT_GE(1, abs(static_cast<int32_t>(lease->cltt_) -
+                     static_cast<int32_t>(time(NULL))));
+    EXPECT_EQ(subnet_->getValid(), lease->valid_lft_);
+
+    // Another set of requested options is processed in full.
+    req->delOption(DHO_DHCP_PARAMETER_REQUEST_LIST);
+    ack = srv->processRequest(req);
+    checkResponse(ack, DHCPACK, 1234);
+    EXPECT_FALSE(ack->getPackedOptions());
+    EXPECT_FALSE(ack->getOption(DHO_LOG_SERVERS));
+    ack = srv->processRequest(req);
+    EXPECT_TRUE(ack->getPackedOptions());
+
+    // So is a request for another address.
+    req->setCiaddr(IOAddress("192.0.2.107"));
+    ack = srv->processRequest(req);
+    EXPECT_FALSE(ack->getPackedOptions());
+    req->setCiaddr(addr);
+
+    // The client is removed by the release of its lease.
+    Pkt4Ptr rel(new Pkt4(DHCPRELEASE, 1234));
+    rel->setRemoteAddr(addr);
+    rel->setCiaddr(addr);
+    rel->setHWAddr(req->getHWAddr());
+    rel->addOption(clientid);
+    rel->addOption(srv->getServerID());
+    EXPECT_NO_THROW(srv->processRelease(rel));
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease4(addr));
+    ASSERT_TRUE(LeaseMgrFactory::instance().addLease(Lease4Ptr(new
+                                                               Lease4(*used))));
+    ack = srv->processRequest(req);
+    EXPECT_EQ(addr, ack->getYiaddr());
+    EXPECT_FALSE(ack->getPackedOptions());
+    ack = srv->processRequest(req);
+    EXPECT_TRUE(ack->getPackedOptions());
+
+    // The clients are forgotten when the subnets change.
+    CfgMgr::instance().reindexSubnets4();
+    ack = srv->processRequest(req);
+    checkResponse(ack, DHCPACK, 1234);
+    EXPECT_FALSE(ack->getPackedOptions());
+
+    // Nothing is cached when the cache is disabled.
+    srv->setClientCacheSize(0);
+    ack = srv->processRequest(req);
+    EXPECT_FALSE(ack->getPackedOptions());
+
+    EXPECT_TRUE(LeaseMgrFactory::instance().deleteLease(addr));
+}
+
 // This test verifies that the logic which matches server identifier in the
 // received message with server identifiers used by a server works correctly:
 // - a message with no server identifier is accepted,
@@ -1362,6 +1529,64 @@ TEST_F(Dhcpv4SrvTest, relayAgentInfoEcho) {
     EXPECT_TRUE(rai_response->equal(rai_query));
 }
 
+// Checks that the expired leases are reclaimed by the server loop once
+// the reclamation is enabled.
+TEST_F(Dhcpv4SrvTest, reclaimExpiredLeases) {
+    NakedDhcpv4Srv srv(0);
+    EXPECT_EQ(0, srv.getReclaimInterval());
+    srv.setReclaimInterval(60);
+    EXPECT_EQ(60, srv.getReclaimInterval());
+
+    const uint8_t mac1[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe };
+    const uint8_t mac2[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe, 0xff };
+    const IOAddress expired_addr("192.0.2.106");
+    const IOAddress active_addr("192.0.2.107");
+    Lease4Ptr expired(new Lease4(expired_addr, mac1, sizeof(mac1), 0, 0,
+                                 100, 50, 75, time(NULL) - 200,
+                                 subnet_->getID()));
+    ASSERT_TRUE(LeaseMgrFactory::instance().addLease(expired));
+    Lease4Ptr active(new Lease4(active_addr, mac2, sizeof(mac2), 0, 0,
+                                100, 50, 75, time(NULL) - 10,
+                                subnet_->getID()));
+    ASSERT_TRUE(LeaseMgrFactory::instance().addLease(active));
+
+    // No packet is queued, so the loop ends after the first iteration.
+    srv.run();
+
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease4(expired_addr));
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease4(active_addr));
+}
+
+// Checks that the server loop waits for the packets no longer than until
+// the next reclamation of the expired leases.
+TEST_F(Dhcpv4SrvTest, receiveTimeout) {
+    // Without the reclamation, the server waits 1000 seconds.
+    NakedDhcpv4Srv srv(0);
+    srv.run();
+    ASSERT_EQ(1, srv.fake_timeouts_.size());
+    EXPECT_EQ(1000, srv.fake_timeouts_.front());
+
+    // The leases were never reclaimed, so the first wait ends right away,
+    // the next one when the interval elapses.
+    NakedDhcpv4Srv srv_reclaim(0);
+    srv_reclaim.setReclaimInterval(5);
+    srv_reclaim.fakeReceive(Pkt4Ptr());
+    srv_reclaim.run();
+    ASSERT_EQ(2, srv_reclaim.fake_timeouts_.size());
+    EXPECT_EQ(0, srv_reclaim.fake_timeouts_.front());
+    EXPECT_GE(5, srv_reclaim.fake_timeouts_.back());
+    EXPECT_LE(4, srv_reclaim.fake_timeouts_.back());
+
+    // A long interval is waited for 1000 seconds at a time.
+    NakedDhcpv4Srv srv_long(0);
+    srv_long.setReclaimInterval(5000);
+    srv_long.fakeReceive(Pkt4Ptr());
+    srv_long.run();
+    ASSERT_EQ(2, srv_long.fake_timeouts_.size());
+    EXPECT_EQ(0, srv_long.fake_timeouts_.front());
+    EXPECT_EQ(1000, srv_long.fake_timeouts_.back());
+}
+
 /// @todo move vendor options tests to a separate file.
 /// @todo Add more extensive vendor options tests, including multiple
 ///       vendor options
@@ -137,7 +137,8 @@ public:
     /// another. Once the queue is empty, it initiates the shutdown procedure.
     ///
     /// See fake_received_ field for description
-    virtual Pkt4Ptr receivePacket(int /*timeout*/) {
+    virtual Pkt4Ptr receivePacket(int timeout) {
+        fake_timeouts_.push_back(timeout);
 
         // If there is anything prepared as fake incoming traffic, use it
         if (!fake_received_.empty()) {
@@ -182,6 +183,9 @@ public:
 
     std::list<Pkt4Ptr> fake_sent_;
 
+    /// @brief timeouts passed to receivePacket(), in the order of the calls
+    std::list<int> fake_timeouts_;
+
     using Dhcpv4Srv::adjustIfaceData;
     using Dhcpv4Srv::appendServerID;
     using Dhcpv4Srv::processDiscover;
@@ -191,6 +191,30 @@
                 "item_type": "boolean",
                 "item_optional": true,
                 "item_default": true
+            },
+            {
+                "item_name": "lfc-interval",
+                "item_type": "integer",
+                "item_optional": true,
+                "item_default": 0
+            },
+            {
+                "item_name": "sync-interval",
+                "item_type": "integer",
+                "item_optional": true,
+                "item_default": 0
+            },
+            {
+                "item_name": "connections",
+                "item_type": "integer",
+                "item_optional": true,
+                "item_default": 1
+            },
+            {
+                "item_name": "async-commit",
+                "item_type": "boolean",
+                "item_optional": true,
+                "item_default": false
             }
         ]
       },
@@ -392,19 +416,26 @@
                 "item_default": 53001,
                 "item_description" : "port number of bundy-dhcp-ddns"
             },
+            {
+                "item_name": "server-socket",
+                "item_type": "string",
+                "item_optional": true,
+                "item_default": "",
+                "item_description" : "Path of the bundy-dhcp-ddns Unix socket, used by the UNIX protocol"
+            },
             {
                 "item_name": "ncr-protocol",
                 "item_type": "string",
                 "item_optional": true,
                 "item_default": "UDP",
-                "item_description" : "Socket protocol to use with bundy-dhcp-ddns"
+                "item_description" : "Socket protocol to use with bundy-dhcp-ddns (UDP or UNIX)"
             },
             {
                 "item_name": "ncr-format",
                 "item_type": "string",
                 "item_optional": true,
                 "item_default": "JSON",
-                "item_description" : "Format of the update request packet"
+                "item_description" : "Format of the update request packet (JSON or BINARY)"
             },
             {
 
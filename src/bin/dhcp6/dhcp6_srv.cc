@@ -115,7 +115,8 @@ const std::string Dhcpv6Srv::VENDOR_CLASS_PREFIX("VENDOR_CLASS_");
 static const char* SERVER_DUID_FILE = "bundy-dhcp6-serverid";
 
 Dhcpv6Srv::Dhcpv6Srv(uint16_t port)
-:alloc_engine_(), serverid_(), port_(port), shutdown_(true)
+:alloc_engine_(), serverid_(), port_(port), shutdown_(true),
+ worker_threads_(0), reclaim_interval_(0), last_reclaim_(0)
 {
 
     LOG_DEBUG(dhcp6_logger, DBG_DHCP6_START, DHCP6_OPEN_SOCKET).arg(port);
@@ -171,6 +172,7 @@ Dhcpv6Srv::Dhcpv6Srv(uint16_t port)
 }
 
 Dhcpv6Srv::~Dhcpv6Srv() {
+    workers_.stop();
     IfaceMgr::instance().closeSockets();
 
     LeaseMgrFactory::destroy();
@@ -235,19 +237,20 @@ Dhcpv6Srv::testUnicast(const Pkt6Ptr& pkt) const {
 }
 
 bool Dhcpv6Srv::run() {
+    if (worker_threads_ > 0) {
+        LOG_INFO(dhcp6_logger, DHCP6_WORKER_THREADS).arg(worker_threads_);
+    }
+    if (reclaim_interval_ > 0) {
+        LOG_INFO(dhcp6_logger, DHCP6_RECLAIM_INTERVAL).arg(reclaim_interval_);
+    }
+    workers_.start(worker_threads_);
+
     while (!shutdown_) {
-        /// @todo Calculate actual timeout to the next event (e.g. lease
-        /// expiration) once we have lease database. The idea here is that
-        /// it is possible to do everything in a single process/thread.
-        /// For now, we are just calling select for 1000 seconds. There
-        /// were some issues reported on some systems when calling select()
-        /// with too large values. Unfortunately, I don't recall the details.
-        //cppcheck-suppress variableScope This is temporary anyway
-        const int timeout = 1000;
-
-        // client's message and server's response
+        // Wait for a packet until the next reclamation at most.
+        const int timeout = getReceiveTimeout();
+
+        // client's message
         Pkt6Ptr query;
-        Pkt6Ptr rsp;
 
         try {
             query = receivePacket(timeout);
@@ -255,277 +258,343 @@ bool Dhcpv6Srv::run() {
             LOG_ERROR(dhcp6_logger, DHCP6_PACKET_RECEIVE_FAIL).arg(e.what());
         }
 
+        reclaimExpiredLeases();
+
         // Timeout may be reached or signal received, which breaks select()
         // with no packet received
         if (!query) {
             continue;
         }
 
-        // In order to parse the DHCP options, the server needs to use some
-        // configuration information such as: existing option spaces, option
-        // definitions etc. This is the kind of information which is not
-        // available in the libdhcp, so we need to supply our own implementation
-        // of the option parsing function here, which would rely on the
-        // configuration data.
-        query->setCallback(boost::bind(&Dhcpv6Srv::unpackOptions, this, _1, _2,
-                                       _3, _4, _5));
+        // Without the worker threads, the packet is processed right away.
+        if (!workers_.add(boost::bind(&Dhcpv6Srv::processPacket, this,
+                                      query))) {
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL, DHCP6_PACKET_QUEUE_FULL)
+                .arg(query->getIface()).arg(workers_.getMaxQueueSize());
+        }
+    }
 
-        bool skip_unpack = false;
+    // Complete the packets already queued.
+    workers_.stop();
 
-        // The packet has just been received so contains the uninterpreted wire
-        // data; execute callouts registered for buffer6_receive.
-        if (HooksManager::calloutsPresent(Hooks.hook_index_buffer6_receive_)) {
-            CalloutHandlePtr callout_handle = getCalloutHandle(query);
+    return (true);
+}
 
-            // Delete previously set arguments
-            callout_handle->deleteAllArguments();
+void Dhcpv6Srv::reclaimExpiredLeases() {
+    if (reclaim_interval_ == 0) {
+        return;
+    }
+    const time_t now = time(NULL);
+    if (now - last_reclaim_ < static_cast<time_t>(reclaim_interval_)) {
+        return;
+    }
+    last_reclaim_ = now;
+    try {
+        alloc_engine_->reclaimExpiredLeases6(RECLAIM_MAX_LEASES,
+                                             RECLAIM_TIMEOUT);
+    } catch (const std::exception& ex) {
+        LOG_ERROR(dhcp6_logger, DHCP6_RECLAIM_FAIL).arg(ex.what());
+    }
+}
 
-            // Pass incoming packet as argument
-            callout_handle->setArgument("query6", query);
+int Dhcpv6Srv::getReceiveTimeout() const {
+    // There were some issues reported on some systems when calling select()
+    // with too large values, so the timeout is 1000 seconds at most.
+    const int max_timeout = 1000;
+    if (reclaim_interval_ == 0) {
+        return (max_timeout);
+    }
+    const time_t left = last_reclaim_ + reclaim_interval_ - time(NULL);
+    if (left <= 0) {
+        return (0);
+    }
+    return (left < max_timeout ? static_cast<int>(left) : max_timeout);
+}
 
-            // Call callouts
-            HooksManager::callCallouts(Hooks.hook_index_buffer6_receive_, *callout_handle);
+void Dhcpv6Srv::setWorkerThreads(size_t threads) {
+    worker_threads_ = threads;
+}
 
-            // Callouts decided to skip the next processing step. The next
-            // processing step would to parse the packet, so skip at this
-            // stage means that callouts did the parsing already, so server
-            // should skip parsing.
-            if (callout_handle->getSkip()) {
-                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_BUFFER_RCVD_SKIP);
-                skip_unpack = true;
-            }
+void Dhcpv6Srv::setAllocType(AllocEngine::AllocType type) {
+    alloc_engine_.reset(new AllocEngine(type, 100));
+}
 
-            callout_handle->getArgument("query6", query);
-        }
+void Dhcpv6Srv::processPacket(Pkt6Ptr query) {
+    // server's response
+    Pkt6Ptr rsp;
 
-        // Unpack the packet information unless the buffer6_receive callouts
-        // indicated they did it
-        if (!skip_unpack) {
-            if (!query->unpack()) {
-                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL,
-                          DHCP6_PACKET_PARSE_FAIL);
-                continue;
-            }
-        }
-        // Check if received query carries server identifier matching
-        // server identifier being used by the server.
-        if (!testServerID(query)) {
-            continue;
+    // In order to parse the DHCP options, the server needs to use some
+    // configuration information such as: existing option spaces, option
+    // definitions etc. This is the kind of information which is not
+    // available in the libdhcp, so we need to supply our own implementation
+    // of the option parsing function here, which would rely on the
+    // configuration data.
+    query->setCallback(boost::bind(&Dhcpv6Srv::unpackOptions, this, _1, _2,
+                                   _3, _4, _5));
+
+    bool skip_unpack = false;
+
+    // The packet has just been received so contains the uninterpreted wire
+    // data; execute callouts registered for buffer6_receive.
+    if (HooksManager::calloutsPresent(Hooks.hook_index_buffer6_receive_)) {
+        CalloutHandlePtr callout_handle = getCalloutHandle(query);
+
+        // Delete previously set arguments
+        callout_handle->deleteAllArguments();
+
+        // Pass incoming packet as argument
+        callout_handle->setArgument("query6", query);
+
+        // Call callouts
+        HooksManager::callCallouts(Hooks.hook_index_buffer6_receive_, *callout_handle);
+
+        // Callouts decided to skip the next processing step. The next
+        // processing step would to parse the packet, so skip at this
+        // stage means that callouts did the parsing already, so server
+        // should skip parsing.
+        if (callout_handle->getSkip()) {
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_BUFFER_RCVD_SKIP);
+            skip_unpack = true;
         }
 
-        // Check if the received query has been sent to unicast or multicast.
-        // The Solicit, Confirm, Rebind and Information Request will be
-        // discarded if sent to unicast address.
-        if (!testUnicast(query)) {
-            continue;
+        callout_handle->getArgument("query6", query);
+    }
+
+    // Unpack the packet information unless the buffer6_receive callouts
+    // indicated they did it
+    if (!skip_unpack) {
+        if (!query->unpack()) {
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL,
+                      DHCP6_PACKET_PARSE_FAIL);
+            return;
         }
+    }
+    // Check if received query carries server identifier matching
+    // server identifier being used by the server.
+    if (!testServerID(query)) {
+        return;
+    }
 
-        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL, DHCP6_PACKET_RECEIVED)
-            .arg(query->getName());
-        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA, DHCP6_QUERY_DATA)
-            .arg(static_cast<int>(query->getType()))
-            .arg(query->getBuffer().getLength())
-            .arg(query->toText());
-
-        // At this point the information in the packet has been unpacked into
-        // the various packet fields and option objects has been cretated.
-        // Execute callouts registered for packet6_receive.
-        if (HooksManager::calloutsPresent(Hooks.hook_index_pkt6_receive_)) {
-            CalloutHandlePtr callout_handle = getCalloutHandle(query);
+    // Check if the received query has been sent to unicast or multicast.
+    // The Solicit, Confirm, Rebind and Information Request will be
+    // discarded if sent to unicast address.
+    if (!testUnicast(query)) {
+        return;
+    }
 
-            // Delete previously set arguments
-            callout_handle->deleteAllArguments();
+    LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL, DHCP6_PACKET_RECEIVED)
+        .arg(query->getName());
+    LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA, DHCP6_QUERY_DATA)
+        .arg(static_cast<int>(query->getType()))
+        .arg(query->getBuffer().getLength())
+        .arg(query->toText());
 
-            // Pass incoming packet as argument
-            callout_handle->setArgument("query6", query);
+    // At this point the information in the packet has been unpacked into
+    // the various packet fields and option objects has been cretated.
+    // Execute callouts registered for packet6_receive.
+    if (HooksManager::calloutsPresent(Hooks.hook_index_pkt6_receive_)) {
+        CalloutHandlePtr callout_handle = getCalloutHandle(query);
 
-            // Call callouts
-            HooksManager::callCallouts(Hooks.hook_index_pkt6_receive_, *callout_handle);
+        // Delete previously set arguments
+        callout_handle->deleteAllArguments();
 
-            // Callouts decided to skip the next processing step. The next
-            // processing step would to process the packet, so skip at this
-            // stage means drop.
-            if (callout_handle->getSkip()) {
-                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_PACKET_RCVD_SKIP);
-                continue;
-            }
+        // Pass incoming packet as argument
+        callout_handle->setArgument("query6", query);
 
-            callout_handle->getArgument("query6", query);
+        // Call callouts
+        HooksManager::callCallouts(Hooks.hook_index_pkt6_receive_, *callout_handle);
+
+        // Callouts decided to skip the next processing step. The next
+        // processing step would to process the packet, so skip at this
+        // stage means drop.
+        if (callout_handle->getSkip()) {
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_PACKET_RCVD_SKIP);
+            return;
         }
 
-        // Assign this packet to a class, if possible
-        classifyPacket(query);
+        callout_handle->getArgument("query6", query);
+    }
 
-        try {
-                NameChangeRequestPtr ncr;
-            switch (query->getType()) {
-            case DHCPV6_SOLICIT:
-                rsp = processSolicit(query);
-                    break;
-
-            case DHCPV6_REQUEST:
-                rsp = processRequest(query);
-                break;
+    // Assign this packet to a class, if possible
+    classifyPacket(query);
 
-            case DHCPV6_RENEW:
-                rsp = processRenew(query);
-                break;
+    // The packets of the same client are processed one at a time, they would
+    // race for the client's leases otherwise.
+    OptionPtr client_id = query->getOption(D6O_CLIENTID);
+    ResourceLocks::Locker client_lock(client_locks_, client_id ?
+                                      client_id->getData() : OptionBuffer());
 
-            case DHCPV6_REBIND:
-                rsp = processRebind(query);
+    try {
+            NameChangeRequestPtr ncr;
+        switch (query->getType()) {
+        case DHCPV6_SOLICIT:
+            rsp = processSolicit(query);
                 break;
 
-            case DHCPV6_CONFIRM:
-                rsp = processConfirm(query);
-                break;
+        case DHCPV6_REQUEST:
+            rsp = processRequest(query);
+            break;
 
-            case DHCPV6_RELEASE:
-                rsp = processRelease(query);
-                break;
+        case DHCPV6_RENEW:
+            rsp = processRenew(query);
+            break;
 
-            case DHCPV6_DECLINE:
-                rsp = processDecline(query);
-                break;
+        case DHCPV6_REBIND:
+            rsp = processRebind(query);
+            break;
 
-            case DHCPV6_INFORMATION_REQUEST:
-                rsp = processInfRequest(query);
-                break;
+        case DHCPV6_CONFIRM:
+            rsp = processConfirm(query);
+            break;
 
-            default:
-                // We received a packet type that we do not recognize.
-                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_UNKNOWN_MSG_RECEIVED)
-                    .arg(static_cast<int>(query->getType()))
-                    .arg(query->getIface());
-                // Only action is to output a message if debug is enabled,
-                // and that will be covered by the debug statement before
-                // the "switch" statement.
-                ;
-            }
+        case DHCPV6_RELEASE:
+            rsp = processRelease(query);
+            break;
 
-        } catch (const RFCViolation& e) {
-            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_REQUIRED_OPTIONS_CHECK_FAIL)
-                .arg(query->getName())
-                .arg(query->getRemoteAddr().toText())
-                .arg(e.what());
+        case DHCPV6_DECLINE:
+            rsp = processDecline(query);
+            break;
 
-        } catch (const bundy::Exception& e) {
+        case DHCPV6_INFORMATION_REQUEST:
+            rsp = processInfRequest(query);
+            break;
 
-            // Catch-all exception (at least for ones based on the isc
-            // Exception class, which covers more or less all that
-            // are explicitly raised in the BUNDY code).  Just log
-            // the problem and ignore the packet. (The problem is logged
-            // as a debug message because debug is disabled by default -
-            // it prevents a DDOS attack based on the sending of problem
-            // packets.)
-            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_PACKET_PROCESS_FAIL)
-                .arg(query->getName())
-                .arg(query->getRemoteAddr().toText())
-                .arg(e.what());
+        default:
+            // We received a packet type that we do not recognize.
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_UNKNOWN_MSG_RECEIVED)
+                .arg(static_cast<int>(query->getType()))
+                .arg(query->getIface());
+            // Only action is to output a message if debug is enabled,
+            // and that will be covered by the debug statement before
+            // the "switch" statement.
+            ;
         }
 
-        if (rsp) {
-            rsp->setRemoteAddr(query->getRemoteAddr());
-            rsp->setLocalAddr(query->getLocalAddr());
+    } catch (const RFCViolation& e) {
+        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_REQUIRED_OPTIONS_CHECK_FAIL)
+            .arg(query->getName())
+            .arg(query->getRemoteAddr().toText())
+            .arg(e.what());
+
+    } catch (const bundy::Exception& e) {
+
+        // Catch-all exception (at least for ones based on the isc
+        // Exception class, which covers more or less all that
+        // are explicitly raised in the BUNDY code).  Just log
+        // the problem and ignore the packet. (The problem is logged
+        // as a debug message because debug is disabled by default -
+        // it prevents a DDOS attack based on the sending of problem
+        // packets.)
+        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_PACKET_PROCESS_FAIL)
+            .arg(query->getName())
+            .arg(query->getRemoteAddr().toText())
+            .arg(e.what());
+    }
 
-            if (rsp->relay_info_.empty()) {
-                // Direct traffic, send back to the client directly
-                rsp->setRemotePort(DHCP6_CLIENT_PORT);
-            } else {
-                // Relayed traffic, send back to the relay agent
-                rsp->setRemotePort(DHCP6_SERVER_PORT);
-            }
+    if (rsp) {
+        rsp->setRemoteAddr(query->getRemoteAddr());
+        rsp->setLocalAddr(query->getLocalAddr());
 
-            rsp->setLocalPort(DHCP6_SERVER_PORT);
-            rsp->setIndex(query->getIndex());
-            rsp->setIface(query->getIface());
+        if (rsp->relay_info_.empty()) {
+            // Direct traffic, send back to the client directly
+            rsp->setRemotePort(DHCP6_CLIENT_PORT);
+        } else {
+            // Relayed traffic, send back to the relay agent
+            rsp->setRemotePort(DHCP6_SERVER_PORT);
+        }
 
-            // Specifies if server should do the packing
-            bool skip_pack = false;
+        rsp->setLocalPort(DHCP6_SERVER_PORT);
+        rsp->setIndex(query->getIndex());
+        rsp->setIface(query->getIface());
 
-            // Server's reply packet now has all options and fields set.
-            // Options are represented by individual objects, but the
-            // output wire data has not been prepared yet.
-            // Execute all callouts registered for packet6_send
-            if (HooksManager::calloutsPresent(Hooks.hook_index_pkt6_send_)) {
-                CalloutHandlePtr callout_handle = getCalloutHandle(query);
+        // Specifies if server should do the packing
+        bool skip_pack = false;
 
-                // Delete all previous arguments
-                callout_handle->deleteAllArguments();
+        // Server's reply packet now has all options and fields set.
+        // Options are represented by individual objects, but the
+        // output wire data has not been prepared yet.
+        // Execute all callouts registered for packet6_send
+        if (HooksManager::calloutsPresent(Hooks.hook_index_pkt6_send_)) {
+            CalloutHandlePtr callout_handle = getCalloutHandle(query);
 
-                // Set our response
-                callout_handle->setArgument("response6", rsp);
+            // Delete all previous arguments
+            callout_handle->deleteAllArguments();
 
-                // Call all installed callouts
-                HooksManager::callCallouts(Hooks.hook_index_pkt6_send_, *callout_handle);
+            // Set our response
+            callout_handle->setArgument("response6", rsp);
 
-                // Callouts decided to skip the next processing step. The next
-                // processing step would to pack the packet (create wire data).
-                // That step will be skipped if any callout sets skip flag.
-                // It essentially means that the callout already did packing,
-                // so the server does not have to do it again.
-                if (callout_handle->getSkip()) {
-                    LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_PACKET_SEND_SKIP);
-                    skip_pack = true;
-                }
-            }
+            // Call all installed callouts
+            HooksManager::callCallouts(Hooks.hook_index_pkt6_send_, *callout_handle);
 
-            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA,
-                      DHCP6_RESPONSE_DATA)
-                .arg(static_cast<int>(rsp->getType())).arg(rsp->toText());
+            // Callouts decided to skip the next processing step. The next
+            // processing step would to pack the packet (create wire data).
+            // That step will be skipped if any callout sets skip flag.
+            // It essentially means that the callout already did packing,
+            // so the server does not have to do it again.
+            if (callout_handle->getSkip()) {
+                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_PACKET_SEND_SKIP);
+                skip_pack = true;
+            }
+        }
 
-            if (!skip_pack) {
-                try {
-                    rsp->pack();
-                } catch (const std::exception& e) {
-                    LOG_ERROR(dhcp6_logger, DHCP6_PACK_FAIL)
-                        .arg(e.what());
-                    continue;
-                }
+        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA,
+                  DHCP6_RESPONSE_DATA)
+            .arg(static_cast<int>(rsp->getType())).arg(rsp->toText());
 
+        if (!skip_pack) {
+            try {
+                rsp->pack();
+            } catch (const std::exception& e) {
+                LOG_ERROR(dhcp6_logger, DHCP6_PACK_FAIL)
+                    .arg(e.what());
+                return;
             }
 
-            try {
+        }
 
-                // Now all fields and options are constructed into output wire buffer.
-                // Option objects modification does not make sense anymore. Hooks
-                // can only manipulate wire buffer at this stage.
-                // Let's execute all callouts registered for buffer6_send
-                if (HooksManager::calloutsPresent(Hooks.hook_index_buffer6_send_)) {
-                    CalloutHandlePtr callout_handle = getCalloutHandle(query);
+        try {
 
-                    // Delete previously set arguments
-                    callout_handle->deleteAllArguments();
+            // Now all fields and options are constructed into output wire buffer.
+            // Option objects modification does not make sense anymore. Hooks
+            // can only manipulate wire buffer at this stage.
+            // Let's execute all callouts registered for buffer6_send
+            if (HooksManager::calloutsPresent(Hooks.hook_index_buffer6_send_)) {
+                CalloutHandlePtr callout_handle = getCalloutHandle(query);
 
-                    // Pass incoming packet as argument
-                    callout_handle->setArgument("response6", rsp);
+                // Delete previously set arguments
+                callout_handle->deleteAllArguments();
 
-                    // Call callouts
-                    HooksManager::callCallouts(Hooks.hook_index_buffer6_send_, *callout_handle);
+                // Pass incoming packet as argument
+                callout_handle->setArgument("response6", rsp);
 
-                    // Callouts decided to skip the next processing step. The next
-                    // processing step would to parse the packet, so skip at this
-                    // stage means drop.
-                    if (callout_handle->getSkip()) {
-                        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_BUFFER_SEND_SKIP);
-                        continue;
-                    }
+                // Call callouts
+                HooksManager::callCallouts(Hooks.hook_index_buffer6_send_, *callout_handle);
 
-                    callout_handle->getArgument("response6", rsp);
+                // Callouts decided to skip the next processing step. The next
+                // processing step would to parse the packet, so skip at this
+                // stage means drop.
+                if (callout_handle->getSkip()) {
+                    LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_BUFFER_SEND_SKIP);
+                    return;
                 }
 
-                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA,
-                          DHCP6_RESPONSE_DATA)
-                    .arg(static_cast<int>(rsp->getType())).arg(rsp->toText());
-
-                sendPacket(rsp);
-            } catch (const std::exception& e) {
-                LOG_ERROR(dhcp6_logger, DHCP6_PACKET_SEND_FAIL)
-                    .arg(e.what());
+                callout_handle->getArgument("response6", rsp);
             }
+
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA,
+                      DHCP6_RESPONSE_DATA)
+                .arg(static_cast<int>(rsp->getType())).arg(rsp->toText());
+
+            // Hold the response until the leases it carries are on the disk
+            // (when the lease database batches the writes).
+            LeaseMgrFactory::instance().sync();
+
+            sendPacket(rsp);
+        } catch (const std::exception& e) {
+            LOG_ERROR(dhcp6_logger, DHCP6_PACKET_SEND_FAIL)
+                .arg(e.what());
         }
     }
-
-    return (true);
 }
 
 bool Dhcpv6Srv::loadServerID(const std::string& file_name) {
@@ -724,7 +793,7 @@ Dhcpv6Srv::appendRequestedOptions(const Pkt6Ptr& question, Pkt6Ptr& answer) {
     BOOST_FOREACH(uint16_t opt, requested_opts) {
         Subnet::OptionDescriptor desc = subnet->getOptionDescriptor("dhcp6", opt);
         if (desc.option) {
-            answer->addOption(desc.option);
+            answer->addOption(desc.option, desc.packed);
         }
     }
 }
@@ -770,7 +839,7 @@ Dhcpv6Srv::appendRequestedVendorOptions(const Pkt6Ptr& question, Pkt6Ptr& answer
     BOOST_FOREACH(uint16_t opt, requested_opts) {
         Subnet::OptionDescriptor desc = subnet->getVendorOptionDescriptor(vendor_id, opt);
         if (desc.option) {
-            vendor_rsp->addOption(desc.option);
+            vendor_rsp->addOption(desc.option, desc.packed);
             added = true;
         }
     }
@@ -25,7 +25,9 @@
 #include <dhcp/pkt6.h>
 #include <dhcpsrv/alloc_engine.h>
 #include <dhcpsrv/d2_client_mgr.h>
+#include <dhcpsrv/resource_locks.h>
 #include <dhcpsrv/subnet.h>
+#include <dhcpsrv/thread_pool.h>
 #include <hooks/callout_handle.h>
 
 #include <boost/noncopyable.hpp>
@@ -93,10 +95,61 @@ public:
     /// their correctness, generates appropriate answer (if needed) and
     /// transmits responses.
     ///
+    /// If worker threads were requested with @c setWorkerThreads(), the
+    /// received packets are processed by them, while this loop only
+    /// receives.  The packets of the same client are never processed in
+    /// parallel.  If the threads don't keep up, the packets are dropped.
+    ///
     /// @return true, if being shut down gracefully, fail if experienced
     ///         critical error.
     bool run();
 
+    /// @brief Sets the number of the threads processing the packets.
+    ///
+    /// Takes effect when @c run() is called.  With 0 (the default), the
+    /// packets are processed one after another by the thread calling
+    /// @c run().
+    ///
+    /// @param threads Number of the worker threads.
+    void setWorkerThreads(size_t threads);
+
+    /// @brief Returns the number of the threads processing the packets.
+    size_t getWorkerThreads() const {
+        return (worker_threads_);
+    }
+
+    /// @brief Selects the algorithm picking the addresses to allocate.
+    ///
+    /// The server uses the iterative allocator by default.  It must not be
+    /// called while the packets are being processed.
+    ///
+    /// @param type Type of the allocator.
+    void setAllocType(AllocEngine::AllocType type);
+
+    /// @brief Sets the interval of the expired leases reclamation.
+    ///
+    /// Every @c seconds, @c run() reclaims at most
+    /// @c RECLAIM_MAX_LEASES expired leases, spending no more than
+    /// @c RECLAIM_TIMEOUT milliseconds (see
+    /// @c AllocEngine::reclaimExpiredLeases6()).  With 0 (the default)
+    /// the expired leases are only reused when allocated again.
+    ///
+    /// @param seconds Interval in seconds, 0 to disable the reclamation.
+    void setReclaimInterval(uint32_t seconds) {
+        reclaim_interval_ = seconds;
+    }
+
+    /// @brief Returns the interval of the expired leases reclamation.
+    uint32_t getReclaimInterval() const {
+        return (reclaim_interval_);
+    }
+
+    /// @brief Maximum number of leases reclaimed at once.
+    static const size_t RECLAIM_MAX_LEASES = 100;
+
+    /// @brief Maximum time spent reclaiming the leases at once, in ms.
+    static const uint32_t RECLAIM_TIMEOUT = 250;
+
     /// @brief Instructs the server to shut down.
     void shutdown();
 
@@ -569,6 +622,14 @@ protected:
     /// simulates transmission of a packet. For that purpose it is protected.
     virtual void sendPacket(const Pkt6Ptr& pkt);
 
+    /// @brief Processes a received packet and sends the response.
+    ///
+    /// Called by @c run() for every packet received, possibly by one of
+    /// the worker threads.
+    ///
+    /// @param query The received packet.
+    void processPacket(Pkt6Ptr query);
+
     /// @brief Implements a callback function to parse options in the message.
     ///
     /// @param buf a A buffer holding options in on-wire format.
@@ -677,6 +738,36 @@ protected:
     /// initiate server shutdown procedure.
     volatile bool shutdown_;
 
+    /// @brief Number of the threads to process the packets in @c run().
+    size_t worker_threads_;
+
+    /// @brief The threads processing the packets.
+    ///
+    /// The derived classes pause them while the configuration changes.
+    ThreadPool workers_;
+
+    /// @brief The clients whose packets are being processed.
+    ResourceLocks client_locks_;
+
+    /// @brief Interval of the expired leases reclamation in seconds.
+    uint32_t reclaim_interval_;
+
+    /// @brief Time the expired leases were last reclaimed.
+    time_t last_reclaim_;
+
+    /// @brief Reclaims the expired leases if the interval elapsed.
+    ///
+    /// Called by @c run() between the packets received.  The errors are
+    /// logged, so the server keeps running.
+    void reclaimExpiredLeases();
+
+    /// @brief Returns the timeout of the packet reception in seconds.
+    ///
+    /// This is the time left until the next reclamation of the expired
+    /// leases, up to 1000 seconds, so that an idle server still reclaims
+    /// them on time.
+    int getReceiveTimeout() const;
+
     /// Holds a list of @c bundy::dhcp_ddns::NameChangeRequest objects, which
     /// are waiting for sending to bundy-dhcp-ddns module.
     std::queue<bundy::dhcp_ddns::NameChangeRequest> name_change_reqs_;
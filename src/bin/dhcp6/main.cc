@@ -23,6 +23,8 @@
 
 #include <iostream>
 
+#include <string.h>
+
 using namespace bundy::dhcp;
 using namespace std;
 
@@ -40,11 +42,18 @@ const char* const DHCP6_NAME = "bundy-dhcp6";
 
 void
 usage() {
-    cerr << "Usage: " << DHCP6_NAME << " [-v] [-s] [-p number]" << endl;
+    cerr << "Usage: " << DHCP6_NAME << " [-v] [-s] [-p number] [-n threads]"
+         << " [-a allocator] [-e seconds]" << endl;
     cerr << "  -v: verbose output" << endl;
     cerr << "  -s: stand-alone mode (don't connect to BUNDY)" << endl;
     cerr << "  -p number: specify non-standard port number 1-65535 "
          << "(useful for testing only)" << endl;
+    cerr << "  -n threads: number of threads processing the packets "
+         << "(default 0, processed by the main thread)" << endl;
+    cerr << "  -a allocator: algorithm picking the addresses, iterative "
+         << "(default), hashed, random or indexed" << endl;
+    cerr << "  -e seconds: interval of the expired leases reclamation "
+         << "(default 0, disabled)" << endl;
     exit(EXIT_FAILURE);
 }
 } // end of anonymous namespace
@@ -56,8 +65,12 @@ main(int argc, char* argv[]) {
                                          // useful for testing only.
     bool stand_alone = false;  // Should be connect to BUNDY msgq?
     bool verbose_mode = false; // Should server be verbose?
+    int worker_threads = 0;    // Threads processing the packets
+    int reclaim_interval = 0;  // Seconds between the leases reclamations
+    // Algorithm picking the addresses
+    AllocEngine::AllocType alloc_type = AllocEngine::ALLOC_ITERATIVE;
 
-    while ((ch = getopt(argc, argv, "vsp:")) != -1) {
+    while ((ch = getopt(argc, argv, "vsp:n:a:e:")) != -1) {
         switch (ch) {
         case 'v':
             verbose_mode = true;
@@ -82,6 +95,47 @@ main(int argc, char* argv[]) {
             }
             break;
 
+        case 'n':
+            try {
+                worker_threads = boost::lexical_cast<int>(optarg);
+            } catch (const boost::bad_lexical_cast &) {
+                worker_threads = -1;
+            }
+            if (worker_threads < 0) {
+                cerr << "Failed to parse number of threads: [" << optarg
+                     << "]." << endl;
+                usage();
+            }
+            break;
+
+        case 'a':
+            if (strcmp(optarg, "iterative") == 0) {
+                alloc_type = AllocEngine::ALLOC_ITERATIVE;
+            } else if (strcmp(optarg, "hashed") == 0) {
+                alloc_type = AllocEngine::ALLOC_HASHED;
+            } else if (strcmp(optarg, "random") == 0) {
+                alloc_type = AllocEngine::ALLOC_RANDOM;
+            } else if (strcmp(optarg, "indexed") == 0) {
+                alloc_type = AllocEngine::ALLOC_INDEXED;
+            } else {
+                cerr << "Unknown allocator: [" << optarg << "]." << endl;
+                usage();
+            }
+            break;
+
+        case 'e':
+            try {
+                reclaim_interval = boost::lexical_cast<int>(optarg);
+            } catch (const boost::bad_lexical_cast &) {
+                reclaim_interval = -1;
+            }
+            if (reclaim_interval < 0) {
+                cerr << "Failed to parse reclamation interval: [" << optarg
+                     << "]." << endl;
+                usage();
+            }
+            break;
+
         default:
             usage();
         }
@@ -120,6 +174,9 @@ main(int argc, char* argv[]) {
         } else {
             LOG_DEBUG(dhcp6_logger, DBG_DHCP6_START, DHCP6_STANDALONE);
         }
+        server.setWorkerThreads(worker_threads);
+        server.setAllocType(alloc_type);
+        server.setReclaimInterval(reclaim_interval);
         server.run();
         LOG_INFO(dhcp6_logger, DHCP6_SHUTDOWN);
 
@@ -1421,6 +1421,36 @@ TEST_F(Dhcpv6SrvTest, ServerID) {
     EXPECT_EQ(duid1_text, text);
 }
 
+// Checks that the server loop waits for the packets no longer than until
+// the next reclamation of the expired leases.
+TEST_F(Dhcpv6SrvTest, receiveTimeout) {
+    // Without the reclamation, the server waits 1000 seconds.
+    NakedDhcpv6Srv srv(0);
+    srv.run();
+    ASSERT_EQ(1, srv.fake_timeouts_.size());
+    EXPECT_EQ(1000, srv.fake_timeouts_.front());
+
+    // The leases were never reclaimed, so the first wait ends right away,
+    // the next one when the interval elapses.
+    NakedDhcpv6Srv srv_reclaim(0);
+    srv_reclaim.setReclaimInterval(5);
+    srv_reclaim.fakeReceive(Pkt6Ptr());
+    srv_reclaim.run();
+    ASSERT_EQ(2, srv_reclaim.fake_timeouts_.size());
+    EXPECT_EQ(0, srv_reclaim.fake_timeouts_.front());
+    EXPECT_GE(5, srv_reclaim.fake_timeouts_.back());
+    EXPECT_LE(4, srv_reclaim.fake_timeouts_.back());
+
+    // A long interval is waited for 1000 seconds at a time.
+    NakedDhcpv6Srv srv_long(0);
+    srv_long.setReclaimInterval(5000);
+    srv_long.fakeReceive(Pkt6Ptr());
+    srv_long.run();
+    ASSERT_EQ(2, srv_long.fake_timeouts_.size());
+    EXPECT_EQ(0, srv_long.fake_timeouts_.front());
+    EXPECT_EQ(1000, srv_long.fake_timeouts_.back());
+}
+
 // Checks if server responses are sent to the proper port.
 TEST_F(Dhcpv6SrvTest, portsDirectTraffic) {
 
@@ -57,7 +57,8 @@ public:
     /// it initiates the shutdown procedure.
     ///
     /// See fake_received_ field for description
-    virtual bundy::dhcp::Pkt6Ptr receivePacket(int /*timeout*/) {
+    virtual bundy::dhcp::Pkt6Ptr receivePacket(int timeout) {
+        fake_timeouts_.push_back(timeout);
 
         // If there is anything prepared as fake incoming
         // traffic, use it
@@ -124,6 +125,9 @@ public:
     std::list<bundy::dhcp::Pkt6Ptr> fake_received_;
 
     std::list<bundy::dhcp::Pkt6Ptr> fake_sent_;
+
+    /// @brief timeouts passed to receivePacket(), in the order of the calls
+    std::list<int> fake_timeouts_;
 };
 
 static const char* DUID_FILE = "server-id-test.txt";
@@ -1,36 +0,0 @@
-// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
-//
-// Permission to use, copy, modify, and/or distribute this software for any
-// purpose with or without fee is hereby granted, provided that the above
-// copyright notice and this permission notice appear in all copies.
-//
-// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
-// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
-// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
-// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
-// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
-// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
-// PERFORMANCE OF THIS SOFTWARE.
-
-#ifndef DUMMY_WORK_H
-#define DUMMY_WORK_H
-
-namespace bundy {
-namespace resolver {
-namespace bench {
-
-/// \brief An empty function.
-///
-/// An empty function, to fill the CPU with something during the benchmark.
-/// It is expected to be called many times by whatever simulates doing some
-/// real CPU-bound work.
-///
-/// It is defined in separate translation unit, so the compiler does not
-/// know it is empty and can't optimise the call out.
-void dummy_work();
-
-}
-}
-}
-
-#endif
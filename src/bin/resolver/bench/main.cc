@@ -12,16 +12,139 @@
 // OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
-#include <resolver/bench/naive_resolver.h>
+#include <resolver/bench/resolver_bench.h>
+#include <resolver/bench/simulated_hierarchy.h>
 
-#include <bench/benchmark.h>
+#include <exceptions/exceptions.h>
+#include <log/logger_support.h>
 
-const size_t count = 1000; // TODO: We may want to read this from argv.
+#include <boost/lexical_cast.hpp>
 
-int main(int, const char**) {
-    // Run the naive implementation
-    bundy::resolver::bench::NaiveResolver naive_resolver(count);
-    bundy::bench::BenchMark<bundy::resolver::bench::NaiveResolver>
-        (1, naive_resolver, true);
-    return 0;
+#include <iostream>
+#include <cstdlib>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace bundy::resolver::bench;
+using boost::lexical_cast;
+
+namespace {
+
+void
+usage() {
+    cerr << "Usage: resolver-bench [-c queries] [-C concurrency] [-z exponent]"
+        "\n\t[-t tlds] [-s slds] [-n names] [-l latency] [-L loss] [-T ttl]"
+        "\n\t[-p port] [-q timeout] [-m memory] [-v]" << endl;
+    cerr << "\t-c: number of client queries (default 100000)" << endl;
+    cerr << "\t-C: number of outstanding client queries (default 100)" <<
+        endl;
+    cerr << "\t-z: exponent of the Zipf distribution of the queried names "
+        "(default 1.0)" << endl;
+    cerr << "\t-t: number of TLDs (default 4)" << endl;
+    cerr << "\t-s: number of SLDs in each TLD (default 25)" << endl;
+    cerr << "\t-n: number of names in each SLD (default 100)" << endl;
+    cerr << "\t-l: latency of the authoritative servers in ms (default 10)"
+         << endl;
+    cerr << "\t-L: percentage of queries the servers drop (default 0)" <<
+        endl;
+    cerr << "\t-T: TTL of the names in seconds (default 300)" << endl;
+    cerr << "\t-p: port of the authoritative servers (default 5300)" << endl;
+    cerr << "\t-q: timeout of an upstream query in ms (default 500)" << endl;
+    cerr << "\t-m: memory limit of the cache in bytes (default 0, no limit)"
+         << endl;
+    cerr << "\t-v: verbose output" << endl;
+    exit(1);
+}
+
+template<typename T>
+T
+getValue(const char* option, const char* value) {
+    try {
+        return (lexical_cast<T>(value));
+    } catch (const boost::bad_lexical_cast&) {
+        cerr << "Invalid value of -" << option << ": " << value << endl;
+        usage();
+    }
+    // Not reached
+    return (T());
+}
+
+}
+
+int
+main(int argc, char* argv[]) {
+    SimulatedHierarchy::Parameters hierarchy_parameters;
+    ResolverBench::Parameters bench_parameters;
+    bool verbose = false;
+    int ch;
+
+    while ((ch = getopt(argc, argv, "c:C:z:t:s:n:l:L:T:p:q:m:v")) != -1) {
+        switch (ch) {
+        case 'c':
+            bench_parameters.queries = getValue<size_t>("c", optarg);
+            break;
+        case 'C':
+            bench_parameters.concurrency = getValue<size_t>("C", optarg);
+            break;
+        case 'z':
+            bench_parameters.zipf = getValue<double>("z", optarg);
+            break;
+        case 't':
+            hierarchy_parameters.tlds = getValue<size_t>("t", optarg);
+            break;
+        case 's':
+            hierarchy_parameters.slds = getValue<size_t>("s", optarg);
+            break;
+        case 'n':
+            hierarchy_parameters.names = getValue<size_t>("n", optarg);
+            break;
+        case 'l':
+            hierarchy_parameters.latency = getValue<unsigned>("l", optarg);
+            break;
+        case 'L':
+            hierarchy_parameters.loss = getValue<double>("L", optarg) / 100;
+            break;
+        case 'T':
+            hierarchy_parameters.ttl = getValue<uint32_t>("T", optarg);
+            break;
+        case 'p':
+            hierarchy_parameters.port = getValue<uint16_t>("p", optarg);
+            break;
+        case 'q':
+            bench_parameters.query_timeout = getValue<int>("q", optarg);
+            break;
+        case 'm':
+            bench_parameters.cache_memory = getValue<size_t>("m", optarg);
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        case '?':
+        default:
+            usage();
+        }
+    }
+    if (argc - optind > 0 || bench_parameters.concurrency == 0) {
+        usage();
+    }
+
+    bundy::log::initLogger("resolver-bench",
+                           (verbose ? bundy::log::DEBUG : bundy::log::WARN),
+                           bundy::log::MAX_DEBUG_LEVEL, NULL, true);
+
+    try {
+        SimulatedHierarchy hierarchy(hierarchy_parameters);
+        ResolverBench bench(bench_parameters, hierarchy);
+        hierarchy.start();
+        bench.run();
+        hierarchy.stop();
+        bench.report(cout, hierarchy.getQueryCount());
+        cout << "Dropped upstream queries:   " <<
+            hierarchy.getDroppedCount() << endl;
+    } catch (const bundy::Exception& ex) {
+        cerr << "Benchmark failed: " << ex.what() << endl;
+        return (1);
+    }
+    return (0);
 }
@@ -1,44 +0,0 @@
-// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
-//
-// Permission to use, copy, modify, and/or distribute this software for any
-// purpose with or without fee is hereby granted, provided that the above
-// copyright notice and this permission notice appear in all copies.
-//
-// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
-// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
-// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
-// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
-// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
-// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
-// PERFORMANCE OF THIS SOFTWARE.
-
-#ifndef RESOLVER_BENCH_NAIVE_H
-#define RESOLVER_BENCH_NAIVE_H
-
-#include <resolver/bench/fake_resolution.h>
-
-namespace bundy {
-namespace resolver {
-namespace bench {
-
-/// \brief Naive implementation of resolver for the benchmark
-///
-/// This is here mostly to show how to implement the other benchmark
-/// implementations. Look at the code inside how to use the fake
-/// resolution.
-class NaiveResolver {
-public:
-    /// \brief Constructor. Initializes the data.
-    NaiveResolver(size_t query_count);
-    /// \brief Run the resolution.
-    size_t run();
-private:
-    FakeInterface interface_;
-    bool processed_;
-};
-
-}
-}
-}
-
-#endif
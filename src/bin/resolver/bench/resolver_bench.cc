@@ -0,0 +1,344 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <resolver/bench/resolver_bench.h>
+
+#include <asiodns/dns_service.h>
+#include <asiolink/io_service.h>
+#include <cache/resolver_cache.h>
+#include <dns/message.h>
+#include <dns/question.h>
+#include <dns/rcode.h>
+#include <dns/rdata.h>
+#include <dns/rrclass.h>
+#include <dns/rrset.h>
+#include <dns/rrttl.h>
+#include <dns/rrtype.h>
+#include <exceptions/exceptions.h>
+#include <nsas/nameserver_address_store.h>
+#include <resolve/recursive_query.h>
+#include <resolve/resolver_interface.h>
+#include <util/random/random_number_generator.h>
+
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <string>
+#include <utility>
+
+using namespace std;
+using namespace bundy::dns;
+using namespace boost::posix_time;
+using bundy::asiodns::DNSService;
+using bundy::asiodns::RecursiveQuery;
+using bundy::resolve::ResolverInterface;
+
+namespace bundy {
+namespace resolver {
+namespace bench {
+
+namespace {
+
+// The NSAS needs a resolver to look up the addresses of the nameservers.
+// It is created before the RecursiveQuery, which needs the NSAS.
+class NSASResolver : public ResolverInterface {
+public:
+    NSASResolver() : query_(NULL) {}
+    void setQuery(RecursiveQuery* query) {
+        query_ = query;
+    }
+    virtual void resolve(const QuestionPtr& question,
+                         const CallbackPtr& callback)
+    {
+        query_->resolve(question, callback);
+    }
+private:
+    RecursiveQuery* query_;
+};
+
+// Probabilities of the Zipf distribution over count ranks.
+vector<double>
+zipfProbabilities(size_t count, double exponent) {
+    vector<double> result;
+    result.reserve(count);
+    double sum = 0.0;
+    for (size_t rank = 1; rank <= count; ++rank) {
+        result.push_back(1.0 / pow(static_cast<double>(rank), exponent));
+        sum += result.back();
+    }
+    for (size_t i = 0; i < count; ++i) {
+        result[i] /= sum;
+    }
+    return (result);
+}
+
+// Greatest common divisor.
+size_t
+gcd(size_t a, size_t b) {
+    while (b != 0) {
+        const size_t tmp = a % b;
+        a = b;
+        b = tmp;
+    }
+    return (a);
+}
+
+}
+
+class ResolverBenchImpl {
+public:
+    ResolverBenchImpl(const ResolverBench::Parameters& parameters,
+                      const SimulatedHierarchy& hierarchy);
+    void sendQuery();
+    void answered(const ptime& start, bool success);
+    void prime();
+
+    const ResolverBench::Parameters parameters_;
+    const SimulatedHierarchy& hierarchy_;
+    bundy::asiolink::IOService service_;
+    DNSService dns_service_;
+    boost::shared_ptr<NSASResolver> nsas_resolver_;
+    bundy::nsas::NameserverAddressStore nsas_;
+    bundy::cache::ResolverCache cache_;
+    RecursiveQuery query_;
+    bundy::util::random::WeightedRandomIntegerGenerator ranks_;
+    // Multiplier spreading the popular names over the hierarchy, so the
+    // most popular ones don't all live in the first zone.
+    size_t scatter_;
+    size_t sent_;
+    size_t answered_;
+    size_t hits_;
+    size_t failures_;
+    ptime start_;
+    ptime end_;
+    vector<time_duration> latencies_;
+};
+
+namespace {
+
+// Callback of a client query.
+class ClientCallback : public ResolverInterface::Callback {
+public:
+    ClientCallback(ResolverBenchImpl& bench) :
+        bench_(bench), start_(microsec_clock::universal_time())
+    {}
+    virtual void success(const MessagePtr response) {
+        bench_.answered(start_, response->getRcode() != Rcode::SERVFAIL());
+    }
+    virtual void failure() {
+        bench_.answered(start_, false);
+    }
+private:
+    ResolverBenchImpl& bench_;
+    const ptime start_;
+};
+
+// The addresses the RecursiveQuery wants; they are not used for
+// resolving (the cache is primed instead), but it can't do without them.
+vector<pair<string, uint16_t> >
+rootAddresses(const SimulatedHierarchy& hierarchy) {
+    return (vector<pair<string, uint16_t> >(
+                1, make_pair(hierarchy.getRootAddress(), hierarchy.getPort())));
+}
+
+}
+
+ResolverBenchImpl::ResolverBenchImpl(const ResolverBench::Parameters&
+                                     parameters,
+                                     const SimulatedHierarchy& hierarchy) :
+    parameters_(parameters), hierarchy_(hierarchy),
+    dns_service_(service_, NULL, NULL),
+    nsas_resolver_(new NSASResolver()),
+    nsas_(nsas_resolver_),
+    query_(dns_service_, nsas_, cache_, vector<pair<string, uint16_t> >(),
+           rootAddresses(hierarchy), parameters.query_timeout, -1,
+           parameters.lookup_timeout, parameters.retries),
+    ranks_(zipfProbabilities(hierarchy.getNameCount(), parameters.zipf)),
+    scatter_(1), sent_(0), answered_(0), hits_(0), failures_(0)
+{
+    nsas_resolver_->setQuery(&query_);
+    query_.setUpstreamPort(hierarchy.getPort());
+    cache_.setMemoryLimit(parameters.cache_memory);
+    const size_t count = hierarchy.getNameCount();
+    for (size_t candidate = 7919; candidate < 8000; ++candidate) {
+        if (gcd(candidate, count) == 1) {
+            scatter_ = candidate;
+            break;
+        }
+    }
+    latencies_.reserve(parameters.queries);
+    prime();
+}
+
+// Fake a priming query, the same way the resolver does it.
+void
+ResolverBenchImpl::prime() {
+    const Name root_ns("ns.root.");
+    QuestionPtr question(new Question(Name::ROOT_NAME(), RRClass::IN(),
+                                      RRType::NS()));
+    RRsetPtr ns_rrset(new RRset(Name::ROOT_NAME(), RRClass::IN(),
+                                RRType::NS(), RRTTL(86400)));
+    ns_rrset->addRdata(rdata::createRdata(RRType::NS(), RRClass::IN(),
+                                          root_ns.toText()));
+    RRsetPtr a_rrset(new RRset(root_ns, RRClass::IN(), RRType::A(),
+                               RRTTL(86400)));
+    a_rrset->addRdata(rdata::createRdata(RRType::A(), RRClass::IN(),
+                                         hierarchy_.getRootAddress()));
+    Message priming(Message::RENDER);
+    priming.setRcode(Rcode::NOERROR());
+    priming.addQuestion(question);
+    priming.addRRset(Message::SECTION_ANSWER, ns_rrset);
+    priming.addRRset(Message::SECTION_ADDITIONAL, a_rrset);
+    cache_.update(priming);
+    cache_.update(ns_rrset);
+    cache_.update(a_rrset);
+}
+
+void
+ResolverBenchImpl::sendQuery() {
+    if (sent_ >= parameters_.queries) {
+        return;
+    }
+    ++sent_;
+    const size_t count = hierarchy_.getNameCount();
+    const size_t rank = min(ranks_(), count - 1);
+    const size_t index = (rank * scatter_) % count;
+    QuestionPtr question(new Question(hierarchy_.getName(index),
+                                      RRClass::IN(), RRType::A()));
+    ResolverInterface::CallbackPtr callback(new ClientCallback(*this));
+    // The query is answered from the cache right away, otherwise a running
+    // query is returned.
+    if (query_.resolve(question, callback) == NULL) {
+        ++hits_;
+    }
+}
+
+void
+ResolverBenchImpl::answered(const ptime& start, bool success) {
+    const ptime now(microsec_clock::universal_time());
+    latencies_.push_back(now - start);
+    if (!success) {
+        ++failures_;
+    }
+    if (++answered_ == parameters_.queries) {
+        end_ = now;
+        service_.stop();
+    } else {
+        // Don't send the next one from within the resolver's callback,
+        // a long series of cache hits would recurse too deep.
+        service_.post(boost::bind(&ResolverBenchImpl::sendQuery, this));
+    }
+}
+
+ResolverBench::ResolverBench(const Parameters& parameters,
+                             const SimulatedHierarchy& hierarchy) :
+    impl_(new ResolverBenchImpl(parameters, hierarchy))
+{}
+
+ResolverBench::~ResolverBench() {
+    delete impl_;
+}
+
+void
+ResolverBench::run() {
+    if (impl_->sent_ != 0) {
+        bundy_throw(bundy::InvalidOperation, "The benchmark already ran");
+    }
+    if (impl_->parameters_.queries == 0) {
+        return;
+    }
+    impl_->start_ = microsec_clock::universal_time();
+    const size_t concurrency = min(impl_->parameters_.concurrency,
+                                   impl_->parameters_.queries);
+    for (size_t i = 0; i < concurrency; ++i) {
+        impl_->service_.post(boost::bind(&ResolverBenchImpl::sendQuery,
+                                         impl_));
+    }
+    impl_->service_.run();
+    sort(impl_->latencies_.begin(), impl_->latencies_.end());
+}
+
+size_t
+ResolverBench::getCacheHits() const {
+    return (impl_->hits_);
+}
+
+size_t
+ResolverBench::getFailures() const {
+    return (impl_->failures_);
+}
+
+time_duration
+ResolverBench::getDuration() const {
+    return (impl_->end_ - impl_->start_);
+}
+
+const vector<time_duration>&
+ResolverBench::getLatencies() const {
+    return (impl_->latencies_);
+}
+
+namespace {
+
+// The latency under which the given proportion of the queries were
+// answered, in milliseconds.
+double
+percentile(const vector<time_duration>& latencies, double proportion) {
+    if (latencies.empty()) {
+        return (0.0);
+    }
+    size_t index = static_cast<size_t>(proportion * latencies.size());
+    if (index >= latencies.size()) {
+        index = latencies.size() - 1;
+    }
+    return (latencies[index].total_microseconds() / 1000.0);
+}
+
+}
+
+void
+ResolverBench::report(ostream& output, size_t upstream_queries) const {
+    const size_t queries = impl_->answered_;
+    const double seconds = getDuration().total_microseconds() / 1000000.0;
+    const vector<time_duration>& latencies(getLatencies());
+    output << fixed << setprecision(2);
+    output << "Client queries:             " << queries << endl;
+    output << "Failed queries:             " << getFailures() << endl;
+    output << "Time:                       " << seconds << " s" << endl;
+    output << "Queries per second:         " <<
+        (seconds > 0 ? queries / seconds : 0.0) << endl;
+    output << "Cache hit ratio:            " <<
+        (queries > 0 ? 100.0 * getCacheHits() / queries : 0.0) << " %" <<
+        endl;
+    output << "Upstream queries per query: " <<
+        (queries > 0 ? static_cast<double>(upstream_queries) / queries :
+         0.0) << endl;
+    output << "Latency (ms):               50%: " <<
+        percentile(latencies, 0.5) << ", 90%: " <<
+        percentile(latencies, 0.9) << ", 99%: " <<
+        percentile(latencies, 0.99) << ", max: " <<
+        percentile(latencies, 1.0) << endl;
+    const bundy::cache::CacheMemory& memory(impl_->cache_.getMemory());
+    output << "Cache memory:               " << memory.getUsed() <<
+        " bytes, " << memory.getEvictions() << " evictions, " <<
+        memory.getRejections() << " rejections" << endl;
+}
+
+}
+}
+}
@@ -0,0 +1,112 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef RESOLVER_BENCH_RESOLVER_BENCH_H
+#define RESOLVER_BENCH_RESOLVER_BENCH_H
+
+#include <resolver/bench/simulated_hierarchy.h>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <ostream>
+#include <vector>
+
+namespace bundy {
+namespace resolver {
+namespace bench {
+
+class ResolverBenchImpl;
+
+/// \brief Benchmark of the real resolver.
+///
+/// It runs the \c RecursiveQuery, together with the resolver cache and
+/// the NSAS, against a \c SimulatedHierarchy.  The client queries are
+/// not sent over the network, they are passed directly to the
+/// \c RecursiveQuery.  The queried names are chosen from the names of the
+/// hierarchy, following the Zipf distribution, and a fixed number of the
+/// queries is kept outstanding at any time.
+///
+/// The results are the rate of the answered queries, the proportion of
+/// the queries answered from the cache, the number of the queries sent
+/// to the authoritative servers per client query and the percentiles of
+/// the time to answer a query.
+class ResolverBench : boost::noncopyable {
+public:
+    /// \brief Parameters of the benchmark.
+    struct Parameters {
+        /// \brief Constructor, sets the default values.
+        Parameters() :
+            queries(100000), concurrency(100), zipf(1.0),
+            query_timeout(500), lookup_timeout(10000), retries(3),
+            cache_memory(0)
+        {}
+        size_t queries;         ///< Number of client queries
+        size_t concurrency;     ///< Number of outstanding client queries
+        double zipf;            ///< Exponent of the Zipf distribution
+        int query_timeout;      ///< Timeout of an upstream query (ms)
+        int lookup_timeout;     ///< Time to give up a client query (ms)
+        unsigned retries;       ///< Retries of an upstream query
+        size_t cache_memory;    ///< Cache memory limit (bytes, 0 = none)
+    };
+
+    /// \brief Constructor.
+    ///
+    /// Creates the resolver, with the cache primed with the root server
+    /// of the hierarchy.
+    ///
+    /// \param parameters Parameters of the benchmark.
+    /// \param hierarchy The servers to run the resolver against.
+    ResolverBench(const Parameters& parameters,
+                  const SimulatedHierarchy& hierarchy);
+
+    /// \brief Destructor.
+    ~ResolverBench();
+
+    /// \brief Run the benchmark.
+    ///
+    /// Returns when all the client queries are answered.
+    void run();
+
+    /// \brief Number of the client queries answered from the cache.
+    size_t getCacheHits() const;
+
+    /// \brief Number of the client queries that failed.
+    ///
+    /// A query fails if the resolver gives up on it or answers SERVFAIL.
+    size_t getFailures() const;
+
+    /// \brief Time the benchmark took.
+    boost::posix_time::time_duration getDuration() const;
+
+    /// \brief The times to answer the client queries, sorted.
+    const std::vector<boost::posix_time::time_duration>&
+    getLatencies() const;
+
+    /// \brief Print the results.
+    ///
+    /// \param output Stream to print to.
+    /// \param upstream_queries Number of queries received by the
+    ///     authoritative servers.
+    void report(std::ostream& output, size_t upstream_queries) const;
+
+private:
+    ResolverBenchImpl* impl_;
+};
+
+}
+}
+}
+
+#endif
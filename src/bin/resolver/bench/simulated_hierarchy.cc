@@ -0,0 +1,491 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <resolver/bench/simulated_hierarchy.h>
+
+#include <asio.hpp>
+
+#include <asiolink/io_service.h>
+#include <dns/message.h>
+#include <dns/messagerenderer.h>
+#include <dns/opcode.h>
+#include <dns/question.h>
+#include <dns/rcode.h>
+#include <dns/rdata.h>
+#include <dns/rrclass.h>
+#include <dns/rrset.h>
+#include <dns/rrttl.h>
+#include <dns/rrtype.h>
+#include <exceptions/exceptions.h>
+#include <util/buffer.h>
+#include <util/random/random_number_generator.h>
+#include <util/threads/thread.h>
+
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <sstream>
+#include <vector>
+
+using namespace std;
+using namespace bundy::dns;
+using bundy::util::thread::Thread;
+using boost::lexical_cast;
+
+namespace bundy {
+namespace resolver {
+namespace bench {
+
+namespace {
+
+// TTL of the delegations and the glue.
+const uint32_t DELEGATION_TTL = 86400;
+
+// Address of the n-th (counting from 0) server on the given level.
+string
+serverAddress(unsigned level, size_t n) {
+    if (level == 0) {
+        return ("127.0.0.2");
+    }
+    ++n;
+    ostringstream result;
+    result << "127." << level << '.' << (n >> 8) << '.' << (n & 0xff);
+    return (result.str());
+}
+
+// Parse a label of the form prefix<number>, with the number below limit.
+bool
+parseLabel(const string& label, const string& prefix, size_t limit,
+           size_t& value)
+{
+    if (label.size() <= prefix.size() ||
+        label.compare(0, prefix.size(), prefix) != 0) {
+        return (false);
+    }
+    const string number(label.substr(prefix.size()));
+    if (number.find_first_not_of("0123456789") != string::npos ||
+        (number.size() > 1 && number[0] == '0')) {
+        return (false);
+    }
+    try {
+        value = lexical_cast<size_t>(number);
+    } catch (const boost::bad_lexical_cast&) {
+        return (false);
+    }
+    return (value < limit);
+}
+
+// The labels of a name, from the TLD down, without the root label.
+vector<string>
+reversedLabels(Name name) {
+    name.downcase();
+    vector<string> result;
+    const string text(name.toText());
+    size_t end = text.size() - 1;   // Skip the final dot
+    while (end > 0) {
+        const size_t dot = text.rfind('.', end - 1);
+        const size_t start = (dot == string::npos) ? 0 : dot + 1;
+        result.push_back(text.substr(start, end - start));
+        if (dot == string::npos) {
+            break;
+        }
+        end = dot;
+    }
+    return (result);
+}
+
+RRsetPtr
+createRRset(const Name& name, const RRType& type, uint32_t ttl,
+            const string& rdata)
+{
+    RRsetPtr rrset(new RRset(name, RRClass::IN(), type, RRTTL(ttl)));
+    rrset->addRdata(rdata::createRdata(type, RRClass::IN(), rdata));
+    return (rrset);
+}
+
+}
+
+/// \brief One of the authoritative servers.
+///
+/// It is authoritative for the zone given by the TLD and SLD numbers
+/// (the root server has none of them, a TLD server only the first).
+class SimulatedServer {
+public:
+    SimulatedServer(SimulatedHierarchyImpl& hierarchy, unsigned level,
+                    size_t tld, size_t sld);
+    void receive();
+private:
+    void received(const asio::error_code& ec, size_t length);
+    void send(const boost::shared_ptr<asio::deadline_timer>& timer,
+              const boost::shared_ptr<bundy::util::OutputBuffer>& buffer,
+              const asio::ip::udp::endpoint& remote);
+    // Fill in the response for the query, return false if the query is
+    // to be ignored.
+    bool respond(const Message& query, Message& response) const;
+    void answerApex(const RRType& type, Message& response) const;
+    void addDelegation(const Name& zone, const string& address,
+                       Message& response) const;
+    void addSOA(Message& response,
+                Message::Section section = Message::SECTION_AUTHORITY) const;
+
+    SimulatedHierarchyImpl& hierarchy_;
+    const unsigned level_;
+    const size_t tld_;
+    const size_t sld_;
+    const Name zone_;
+    const string address_;
+    asio::ip::udp::socket socket_;
+    asio::ip::udp::endpoint remote_;
+    uint8_t data_[4096];
+};
+
+class SimulatedHierarchyImpl {
+public:
+    SimulatedHierarchyImpl(const SimulatedHierarchy::Parameters& parameters) :
+        parameters_(parameters), loss_generator_(0, 9999), queries_(0),
+        dropped_(0)
+    {}
+    void run() {
+        service_.run();
+    }
+    string tldZone(size_t tld) const {
+        return ("tld" + lexical_cast<string>(tld) + ".");
+    }
+    string sldZone(size_t tld, size_t sld) const {
+        return ("sld" + lexical_cast<string>(sld) + "." + tldZone(tld));
+    }
+    string tldAddress(size_t tld) const {
+        return (serverAddress(1, tld));
+    }
+    string sldAddress(size_t tld, size_t sld) const {
+        return (serverAddress(2, tld * parameters_.slds + sld));
+    }
+    // Should the current query be dropped?
+    bool drop() {
+        ++queries_;
+        if (parameters_.loss > 0 &&
+            loss_generator_() < parameters_.loss * 10000) {
+            ++dropped_;
+            return (true);
+        }
+        return (false);
+    }
+
+    const SimulatedHierarchy::Parameters parameters_;
+    bundy::asiolink::IOService service_;
+    vector<boost::shared_ptr<SimulatedServer> > servers_;
+    boost::scoped_ptr<Thread> thread_;
+    bundy::util::random::UniformRandomIntegerGenerator loss_generator_;
+    size_t queries_;
+    size_t dropped_;
+};
+
+SimulatedServer::SimulatedServer(SimulatedHierarchyImpl& hierarchy,
+                                 unsigned level, size_t tld, size_t sld) :
+    hierarchy_(hierarchy), level_(level), tld_(tld), sld_(sld),
+    zone_(level == 0 ? "." : level == 1 ? hierarchy.tldZone(tld) :
+          hierarchy.sldZone(tld, sld)),
+    address_(level == 0 ? serverAddress(0, 0) : level == 1 ?
+             hierarchy.tldAddress(tld) : hierarchy.sldAddress(tld, sld)),
+    socket_(hierarchy.service_.get_io_service())
+{
+    const asio::ip::udp::endpoint
+        endpoint(asio::ip::address::from_string(address_),
+                 hierarchy.parameters_.port);
+    asio::error_code ec;
+    socket_.open(endpoint.protocol(), ec);
+    if (!ec) {
+        socket_.bind(endpoint, ec);
+    }
+    if (ec) {
+        bundy_throw(bundy::Unexpected, "Failed to bind " << address_ << "#" <<
+                    hierarchy.parameters_.port << ": " << ec.message());
+    }
+}
+
+void
+SimulatedServer::receive() {
+    socket_.async_receive_from(asio::buffer(data_, sizeof(data_)), remote_,
+                               boost::bind(&SimulatedServer::received, this,
+                                           _1, _2));
+}
+
+void
+SimulatedServer::received(const asio::error_code& ec, size_t length) {
+    if (ec == asio::error::operation_aborted) {
+        return;
+    }
+    if (!ec && !hierarchy_.drop()) {
+        try {
+            bundy::util::InputBuffer input(data_, length);
+            Message query(Message::PARSE);
+            query.fromWire(input);
+            Message response(Message::RENDER);
+            if (respond(query, response)) {
+                boost::shared_ptr<bundy::util::OutputBuffer>
+                    buffer(new bundy::util::OutputBuffer(512));
+                MessageRenderer renderer;
+                renderer.setBuffer(buffer.get());
+                response.toWire(renderer);
+                renderer.setBuffer(NULL);
+                boost::shared_ptr<asio::deadline_timer>
+                    timer(new asio::deadline_timer(
+                              hierarchy_.service_.get_io_service()));
+                timer->expires_from_now(boost::posix_time::milliseconds(
+                    hierarchy_.parameters_.latency));
+                timer->async_wait(boost::bind(&SimulatedServer::send, this,
+                                              timer, buffer, remote_));
+            }
+        } catch (const bundy::Exception&) {
+            // Broken query, ignore it.
+        }
+    }
+    receive();
+}
+
+void
+SimulatedServer::send(const boost::shared_ptr<asio::deadline_timer>&,
+                      const boost::shared_ptr<bundy::util::OutputBuffer>&
+                      buffer,
+                      const asio::ip::udp::endpoint& remote)
+{
+    asio::error_code ec;
+    socket_.send_to(asio::buffer(buffer->getData(), buffer->getLength()),
+                    remote, 0, ec);
+}
+
+bool
+SimulatedServer::respond(const Message& query, Message& response) const {
+    if (query.getRRCount(Message::SECTION_QUESTION) != 1) {
+        return (false);
+    }
+    const QuestionPtr question(*query.beginQuestion());
+    response.setQid(query.getQid());
+    response.setOpcode(Opcode::QUERY());
+    response.setHeaderFlag(Message::HEADERFLAG_QR);
+    response.setHeaderFlag(Message::HEADERFLAG_RD,
+                           query.getHeaderFlag(Message::HEADERFLAG_RD));
+    response.addQuestion(question);
+    response.setRcode(Rcode::NOERROR());
+
+    const SimulatedHierarchy::Parameters& parameters(hierarchy_.parameters_);
+    const Name& qname(question->getName());
+    const RRType& qtype(question->getType());
+    const vector<string> labels(reversedLabels(qname));
+
+    // Check the query is for our zone.
+    size_t value;
+    if ((level_ >= 1 && (labels.size() < 1 ||
+                         !parseLabel(labels[0], "tld", parameters.tlds,
+                                     value) || value != tld_)) ||
+        (level_ >= 2 && (labels.size() < 2 ||
+                         !parseLabel(labels[1], "sld", parameters.slds,
+                                     value) || value != sld_))) {
+        response.setRcode(Rcode::REFUSED());
+        return (true);
+    }
+
+    if (labels.size() == level_) {
+        response.setHeaderFlag(Message::HEADERFLAG_AA);
+        answerApex(qtype, response);
+        return (true);
+    }
+    const string& label(labels[level_]);
+    if (level_ == 0 && parseLabel(label, "tld", parameters.tlds, value)) {
+        addDelegation(Name(hierarchy_.tldZone(value)),
+                      hierarchy_.tldAddress(value), response);
+        return (true);
+    }
+    if (level_ == 1 && parseLabel(label, "sld", parameters.slds, value)) {
+        addDelegation(Name(hierarchy_.sldZone(tld_, value)),
+                      hierarchy_.sldAddress(tld_, value), response);
+        return (true);
+    }
+
+    response.setHeaderFlag(Message::HEADERFLAG_AA);
+    if (labels.size() == level_ + 1 && label == "ns" && level_ > 0) {
+        if (qtype == RRType::A()) {
+            response.addRRset(Message::SECTION_ANSWER,
+                              createRRset(qname, RRType::A(), DELEGATION_TTL,
+                                          address_));
+        } else {
+            addSOA(response);
+        }
+    } else if (labels.size() == level_ + 1 && level_ == 2 &&
+               parseLabel(label, "h", parameters.names, value)) {
+        if (qtype == RRType::A()) {
+            const size_t index = ((tld_ * parameters.slds) + sld_) *
+                parameters.names + value;
+            ostringstream address;
+            address << "10." << ((index >> 16) & 0xff) << '.' <<
+                ((index >> 8) & 0xff) << '.' << (index & 0xff);
+            response.addRRset(Message::SECTION_ANSWER,
+                              createRRset(qname, RRType::A(), parameters.ttl,
+                                          address.str()));
+        } else {
+            addSOA(response);
+        }
+    } else {
+        response.setRcode(Rcode::NXDOMAIN());
+        addSOA(response);
+    }
+    return (true);
+}
+
+void
+SimulatedServer::answerApex(const RRType& type, Message& response) const {
+    const Name ns_name(level_ == 0 ? Name("ns.root.") :
+                       Name("ns").concatenate(zone_));
+    if (type == RRType::NS()) {
+        response.addRRset(Message::SECTION_ANSWER,
+                          createRRset(zone_, RRType::NS(), DELEGATION_TTL,
+                                      ns_name.toText()));
+        response.addRRset(Message::SECTION_ADDITIONAL,
+                          createRRset(ns_name, RRType::A(), DELEGATION_TTL,
+                                      address_));
+    } else if (type == RRType::SOA()) {
+        addSOA(response, Message::SECTION_ANSWER);
+    } else {
+        addSOA(response);
+    }
+}
+
+void
+SimulatedServer::addDelegation(const Name& zone, const string& address,
+                               Message& response) const
+{
+    const Name ns_name(Name("ns").concatenate(zone));
+    response.addRRset(Message::SECTION_AUTHORITY,
+                      createRRset(zone, RRType::NS(), DELEGATION_TTL,
+                                  ns_name.toText()));
+    response.addRRset(Message::SECTION_ADDITIONAL,
+                      createRRset(ns_name, RRType::A(), DELEGATION_TTL,
+                                  address));
+}
+
+void
+SimulatedServer::addSOA(Message& response, Message::Section section) const {
+    const uint32_t ttl = hierarchy_.parameters_.ttl;
+    ostringstream soa;
+    soa << "ns." << (level_ == 0 ? "root." : zone_.toText()) <<
+        " hostmaster." << zone_.toText() << " 1 3600 900 604800 " << ttl;
+    response.addRRset(section,
+                      createRRset(zone_, RRType::SOA(), ttl, soa.str()));
+}
+
+SimulatedHierarchy::SimulatedHierarchy(const Parameters& parameters) :
+    impl_(new SimulatedHierarchyImpl(parameters))
+{
+    if (parameters.tlds == 0 || parameters.slds == 0 ||
+        parameters.names == 0) {
+        delete impl_;
+        bundy_throw(bundy::BadValue, "The hierarchy must not be empty");
+    }
+    if (parameters.tlds >= 0xffff ||
+        parameters.tlds * parameters.slds >= 0xffff) {
+        delete impl_;
+        bundy_throw(bundy::BadValue, "Too many zones in the hierarchy");
+    }
+    if (parameters.loss < 0.0 || parameters.loss > 1.0) {
+        delete impl_;
+        bundy_throw(bundy::BadValue, "Loss must be between 0 and 1");
+    }
+    try {
+        impl_->servers_.push_back(boost::shared_ptr<SimulatedServer>(
+            new SimulatedServer(*impl_, 0, 0, 0)));
+        for (size_t tld = 0; tld < parameters.tlds; ++tld) {
+            impl_->servers_.push_back(boost::shared_ptr<SimulatedServer>(
+                new SimulatedServer(*impl_, 1, tld, 0)));
+            for (size_t sld = 0; sld < parameters.slds; ++sld) {
+                impl_->servers_.push_back(boost::shared_ptr<SimulatedServer>(
+                    new SimulatedServer(*impl_, 2, tld, sld)));
+            }
+        }
+    } catch (...) {
+        delete impl_;
+        throw;
+    }
+}
+
+SimulatedHierarchy::~SimulatedHierarchy() {
+    stop();
+    delete impl_;
+}
+
+void
+SimulatedHierarchy::start() {
+    if (impl_->thread_) {
+        bundy_throw(bundy::InvalidOperation, "Already running");
+    }
+    for (size_t i = 0; i < impl_->servers_.size(); ++i) {
+        impl_->servers_[i]->receive();
+    }
+    impl_->thread_.reset(new Thread(boost::bind(&SimulatedHierarchyImpl::run,
+                                                impl_)));
+}
+
+void
+SimulatedHierarchy::stop() {
+    if (impl_->thread_) {
+        impl_->service_.stop();
+        impl_->thread_->wait();
+        impl_->thread_.reset();
+        impl_->service_.get_io_service().reset();
+    }
+}
+
+string
+SimulatedHierarchy::getRootAddress() const {
+    return (serverAddress(0, 0));
+}
+
+uint16_t
+SimulatedHierarchy::getPort() const {
+    return (impl_->parameters_.port);
+}
+
+size_t
+SimulatedHierarchy::getNameCount() const {
+    return (impl_->parameters_.tlds * impl_->parameters_.slds *
+            impl_->parameters_.names);
+}
+
+Name
+SimulatedHierarchy::getName(size_t index) const {
+    const Parameters& parameters(impl_->parameters_);
+    if (index >= getNameCount()) {
+        bundy_throw(bundy::OutOfRange, "Name index out of range");
+    }
+    const size_t name = index % parameters.names;
+    const size_t sld = (index / parameters.names) % parameters.slds;
+    const size_t tld = index / (parameters.names * parameters.slds);
+    return (Name("h" + lexical_cast<string>(name) + "." +
+                 impl_->sldZone(tld, sld)));
+}
+
+size_t
+SimulatedHierarchy::getQueryCount() const {
+    return (impl_->queries_);
+}
+
+size_t
+SimulatedHierarchy::getDroppedCount() const {
+    return (impl_->dropped_);
+}
+
+}
+}
+}
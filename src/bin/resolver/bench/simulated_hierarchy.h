@@ -0,0 +1,126 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef RESOLVER_BENCH_SIMULATED_HIERARCHY_H
+#define RESOLVER_BENCH_SIMULATED_HIERARCHY_H
+
+#include <dns/name.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <string>
+
+#include <stdint.h>
+
+namespace bundy {
+namespace resolver {
+namespace bench {
+
+class SimulatedHierarchyImpl;
+
+/// \brief In-process imitation of a hierarchy of authoritative servers.
+///
+/// The hierarchy consists of a root server, a number of TLDs (tld0.,
+/// tld1., ...), each of them delegating a number of SLDs (sld0.tld0.,
+/// ...) and each SLD holding a number of host names (h0.sld0.tld0., ...)
+/// with an A record.  Every zone is served by a single server (ns.<zone>)
+/// of its own, listening on its own loopback address, so the resolver
+/// follows the referrals and talks to the NSAS exactly as it would on the
+/// Internet:
+///
+/// - the root server on 127.0.0.2,
+/// - the server of the TLD number \c t on 127.1.x.y, where x.y is t + 1,
+/// - the server of the SLD number \c s of the TLD \c t on 127.2.x.y, where
+///   x.y is t * slds + s + 1.
+///
+/// All the servers listen on the same (configurable) port.  Binding the
+/// addresses requires the whole 127.0.0.0/8 network to be routed to the
+/// loopback interface, which is the case on Linux.
+///
+/// The servers run in a thread of their own.  Each query is delayed by
+/// the configured latency (to imitate the round trip to the server) and
+/// a configured proportion of the queries is dropped.
+class SimulatedHierarchy : boost::noncopyable {
+public:
+    /// \brief Description of the hierarchy.
+    struct Parameters {
+        /// \brief Constructor, sets the default values.
+        Parameters() :
+            tlds(4), slds(25), names(100), port(5300), latency(10),
+            loss(0.0), ttl(300)
+        {}
+        size_t tlds;        ///< Number of TLDs
+        size_t slds;        ///< Number of SLDs in each TLD
+        size_t names;       ///< Number of host names in each SLD
+        uint16_t port;      ///< Port the servers listen on
+        unsigned latency;   ///< Time to answer a query (ms)
+        double loss;        ///< Proportion of dropped queries (0..1)
+        uint32_t ttl;       ///< TTL of the host names (and negative TTL)
+    };
+
+    /// \brief Constructor.
+    ///
+    /// Binds the sockets of all the servers.
+    ///
+    /// \throw bundy::BadValue if the parameters describe a hierarchy that
+    ///     does not fit into the address space.
+    /// \throw bundy::Unexpected if a socket can't be bound.
+    SimulatedHierarchy(const Parameters& parameters);
+
+    /// \brief Destructor.
+    ///
+    /// Stops the servers if they are running.
+    ~SimulatedHierarchy();
+
+    /// \brief Start answering queries in a new thread.
+    void start();
+
+    /// \brief Stop the thread.
+    void stop();
+
+    /// \brief Address of the root server.
+    ///
+    /// The resolver has to be primed with it.
+    std::string getRootAddress() const;
+
+    /// \brief Port the servers listen on.
+    uint16_t getPort() const;
+
+    /// \brief Total number of host names in the hierarchy.
+    size_t getNameCount() const;
+
+    /// \brief Get a host name.
+    ///
+    /// \param index Index of the name, less than \c getNameCount().
+    bundy::dns::Name getName(size_t index) const;
+
+    /// \brief Number of queries the servers received.
+    ///
+    /// Only to be called when the servers are stopped.
+    size_t getQueryCount() const;
+
+    /// \brief Number of queries dropped.
+    ///
+    /// Only to be called when the servers are stopped.
+    size_t getDroppedCount() const;
+
+private:
+    SimulatedHierarchyImpl* impl_;
+};
+
+}
+}
+}
+
+#endif
@@ -16,6 +16,7 @@
 
 #include <resolver/spec_config.h>
 #include <resolver/resolver.h>
+#include <resolver/resolver_worker.h>
 #include "resolver_log.h"
 #include "common.h"
 
@@ -59,6 +60,8 @@
 #include <iostream>
 
 #include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/scoped_ptr.hpp>
 
 using namespace std;
 using namespace bundy::cc;
@@ -73,10 +76,16 @@ static const string PROGRAM = "Resolver";
 
 IOService io_service;
 static boost::shared_ptr<Resolver> resolver;
+// The additional threads, if running with more than one.
+static ResolverWorkerPool* worker_pool = NULL;
 
 ConstElementPtr
 my_config_handler(ConstElementPtr new_config) {
-    return (resolver->updateConfig(new_config));
+    ConstElementPtr answer = resolver->updateConfig(new_config);
+    if (worker_pool != NULL) {
+        worker_pool->updateConfig(new_config, false);
+    }
+    return (answer);
 }
 
 ConstElementPtr
@@ -103,6 +112,8 @@ my_command_handler(const string& command, ConstElementPtr args) {
             LOG_DEBUG(resolver_logger, RESOLVER_DBG_INIT,
                       RESOLVER_SHUTDOWN_RECEIVED);
             io_service.stop();
+        } else if (command == "getstats") {
+            answer = createAnswer(0, resolver->getStatistics());
         }
 
         return (answer);
@@ -113,7 +124,8 @@ my_command_handler(const string& command, ConstElementPtr args) {
 
 void
 usage() {
-    cerr << "Usage:  bundy-resolver [-u user] [-v]" << endl;
+    cerr << "Usage:  bundy-resolver [-u user] [-n threads] [-v]" << endl;
+    cerr << "\t-n: number of threads answering queries (default 1)" << endl;
     cerr << "\t-v: verbose output" << endl;
     exit(1);
 }
@@ -122,10 +134,25 @@ usage() {
 int
 main(int argc, char* argv[]) {
     bool verbose = false;
+    size_t threads = 1;
     int ch;
 
-    while ((ch = getopt(argc, argv, "u:v")) != -1) {
+    while ((ch = getopt(argc, argv, "n:u:v")) != -1) {
         switch (ch) {
+        case 'n':
+            try {
+                threads = boost::lexical_cast<size_t>(optarg);
+            } catch (const boost::bad_lexical_cast&) {
+                cerr << "[bundy-resolver] Invalid number of threads: "
+                     << optarg << endl;
+                usage();
+            }
+            if (threads == 0) {
+                cerr << "[bundy-resolver] The number of threads must be "
+                     << "positive" << endl;
+                usage();
+            }
+            break;
         case 'v':
             verbose = true;
             break;
@@ -171,7 +198,17 @@ main(int argc, char* argv[]) {
         DNSLookup* lookup = resolver->getDNSLookupProvider();
         DNSAnswer* answer = resolver->getDNSAnswerProvider();
 
-        bundy::nsas::NameserverAddressStore nsas(resolver);
+        // With more threads, the NSAS lookups have to be done by the
+        // resolver of the thread asking for them.
+        boost::shared_ptr<bundy::resolve::ResolverInterface>
+            nsas_resolver(resolver);
+        boost::shared_ptr<ResolverDispatcher> dispatcher;
+        if (threads > 1) {
+            dispatcher.reset(new ResolverDispatcher());
+            dispatcher->setThreadResolver(resolver.get());
+            nsas_resolver = dispatcher;
+        }
+        bundy::nsas::NameserverAddressStore nsas(nsas_resolver);
         resolver->setNameserverAddressStore(nsas);
 
         bundy::cache::ResolverCache cache;
@@ -217,7 +254,15 @@ main(int argc, char* argv[]) {
         cache.update(root_aaaa_rrset);
 
         DNSService dns_service(io_service, lookup, answer);
-        resolver->setDNSService(dns_service);
+        boost::scoped_ptr<ResolverWorkerPool> workers;
+        if (threads > 1) {
+            workers.reset(new ResolverWorkerPool(dns_service, threads - 1,
+                                                 *dispatcher, nsas, cache));
+            worker_pool = workers.get();
+            resolver->setDNSService(*workers);
+        } else {
+            resolver->setDNSService(dns_service);
+        }
         LOG_DEBUG(resolver_logger, RESOLVER_DBG_INIT, RESOLVER_SERVICE_CREATED);
 
         cc_session = new Session(io_service.get_io_service());
@@ -238,6 +283,9 @@ main(int argc, char* argv[]) {
         // the default configuration will be installed even if listen_on
         // fails.
         resolver->updateConfig(config_session->getFullConfig(), true);
+        if (worker_pool != NULL) {
+            worker_pool->updateConfig(config_session->getFullConfig(), true);
+        }
         LOG_DEBUG(resolver_logger, RESOLVER_DBG_INIT, RESOLVER_CONFIG_LOADED);
 
         // Now start asynchronous read.
@@ -249,6 +297,7 @@ main(int argc, char* argv[]) {
         LOG_FATAL(resolver_logger, RESOLVER_FAILED).arg(ex.what());
         ret = 1;
     }
+    worker_pool = NULL;
 
     delete config_session;
     delete cc_session;
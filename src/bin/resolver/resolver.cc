@@ -643,6 +643,18 @@ Resolver::updateConfig(ConstElementPtr config, bool startup) {
             retries = retriesE->intValue();
             set_timeouts = true;
         }
+        ConstElementPtr max_stale_ttlE(config->get("max_stale_ttl"));
+        if (max_stale_ttlE && max_stale_ttlE->intValue() < 0) {
+            LOG_ERROR(resolver_logger, RESOLVER_NEGATIVE_MAX_STALE_TTL)
+                      .arg(max_stale_ttlE->intValue());
+            bundy_throw(BadValue, "Negative max stale TTL");
+        }
+        ConstElementPtr max_cache_memoryE(config->get("max_cache_memory"));
+        if (max_cache_memoryE && max_cache_memoryE->intValue() < 0) {
+            LOG_ERROR(resolver_logger, RESOLVER_NEGATIVE_CACHE_MEMORY)
+                      .arg(max_cache_memoryE->intValue());
+            bundy_throw(BadValue, "Negative cache memory limit");
+        }
         // Everything OK, so commit the changes
         // listenAddresses can fail to bind, so try them first
         bool need_query_restart = false;
@@ -666,6 +678,12 @@ Resolver::updateConfig(ConstElementPtr config, bool startup) {
         if (query_acl) {
             setQueryACL(query_acl);
         }
+        if (max_stale_ttlE && cache_ != NULL) {
+            cache_->setMaxStaleTTL(max_stale_ttlE->intValue());
+        }
+        if (max_cache_memoryE && cache_ != NULL) {
+            cache_->setMemoryLimit(max_cache_memoryE->intValue());
+        }
         if (startup && listenAddressesE) {
             setListenAddresses(listenAddresses);
             need_query_restart = true;
@@ -755,6 +773,26 @@ Resolver::getListenAddresses() const {
     return (impl_->listen_);
 }
 
+ConstElementPtr
+Resolver::getStatistics() const {
+    ElementPtr statistics(Element::createMap());
+    if (cache_ != NULL) {
+        typedef long long int Value;
+        const bundy::cache::CacheMemory& memory(cache_->getMemory());
+        statistics->set("cache_memory_used",
+                        Element::create(static_cast<Value>(memory.getUsed())));
+        statistics->set("cache_memory_limit",
+                        Element::create(static_cast<Value>(memory.getLimit())));
+        statistics->set("cache_evictions",
+                        Element::create(static_cast<Value>(
+                                            memory.getEvictions())));
+        statistics->set("cache_rejections",
+                        Element::create(static_cast<Value>(
+                                            memory.getRejections())));
+    }
+    return (statistics);
+}
+
 const RequestACL&
 Resolver::getQueryACL() const {
     return (impl_->getQueryACL());
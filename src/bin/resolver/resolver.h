@@ -234,6 +234,15 @@ public:
      */
     int getRetries() const;
 
+    /// \brief Return the statistics of the resolver.
+    ///
+    /// Currently these are the memory usage and the evictions of the
+    /// cache (see the "statistics" section of the spec file).  If no cache
+    /// is set, an empty map is returned.
+    ///
+    /// \return JSON format statistics data.
+    bundy::data::ConstElementPtr getStatistics() const;
+
     /// Get the query ACL.
     ///
     /// \exception None
@@ -0,0 +1,281 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <resolver/resolver_worker.h>
+#include <resolver/resolver_log.h>
+
+#include <exceptions/exceptions.h>
+#include <util/threads/sync.h>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+using namespace std;
+using namespace bundy::asiodns;
+using namespace bundy::data;
+using bundy::util::thread::CondVar;
+using bundy::util::thread::Mutex;
+using bundy::util::thread::Thread;
+
+ResolverDispatcher::ResolverDispatcher() {
+    const int result = pthread_key_create(&key_, NULL);
+    if (result != 0) {
+        bundy_throw(bundy::Unexpected, "Failed to create thread key: " <<
+                    strerror(result));
+    }
+}
+
+ResolverDispatcher::~ResolverDispatcher() {
+    pthread_key_delete(key_);
+}
+
+void
+ResolverDispatcher::setThreadResolver(
+    bundy::resolve::ResolverInterface* resolver)
+{
+    pthread_setspecific(key_, resolver);
+}
+
+void
+ResolverDispatcher::resolve(const bundy::dns::QuestionPtr& question,
+                            const CallbackPtr& callback)
+{
+    bundy::resolve::ResolverInterface* resolver =
+        static_cast<bundy::resolve::ResolverInterface*>(
+            pthread_getspecific(key_));
+    if (resolver == NULL) {
+        bundy_throw(bundy::InvalidOperation,
+                    "No resolver registered for the current thread");
+    }
+    resolver->resolve(question, callback);
+}
+
+namespace {
+
+// State shared by ResolverWorker::call() and the function run in the
+// worker thread.
+struct CallState {
+    CallState() : done(false) {}
+    Mutex mutex;
+    CondVar cond;
+    bool done;
+    string error;
+};
+
+void
+callWrapper(const boost::function<void()>& function, CallState* state) {
+    string error;
+    try {
+        function();
+    } catch (const std::exception& ex) {
+        error = ex.what();
+        if (error.empty()) {
+            error = "unknown error";
+        }
+    } catch (...) {
+        error = "unknown error";
+    }
+    Mutex::Locker locker(state->mutex);
+    state->error = error;
+    state->done = true;
+    state->cond.signal();
+}
+
+// The configuration without the items handled by the main thread only.
+ConstElementPtr
+workerConfig(ConstElementPtr config) {
+    if (!config || config->getType() != Element::map ||
+        !config->contains("listen_on")) {
+        return (config);
+    }
+    ElementPtr result = Element::createMap();
+    typedef pair<string, ConstElementPtr> ConfigPair;
+    BOOST_FOREACH(const ConfigPair& item, config->mapValue()) {
+        if (item.first != "listen_on") {
+            result->set(item.first, item.second);
+        }
+    }
+    return (result);
+}
+
+}
+
+ResolverWorker::ResolverWorker(ResolverDispatcher& dispatcher,
+                               bundy::nsas::NameserverAddressStore& nsas,
+                               bundy::cache::ResolverCache& cache) :
+    dispatcher_(dispatcher),
+    dns_service_(io_service_, resolver_.getDNSLookupProvider(),
+                 resolver_.getDNSAnswerProvider())
+{
+    resolver_.setNameserverAddressStore(nsas);
+    resolver_.setCache(cache);
+    resolver_.setDNSService(dns_service_);
+    thread_.reset(new Thread(boost::bind(&ResolverWorker::run, this)));
+}
+
+ResolverWorker::~ResolverWorker() {
+    io_service_.stop();
+    thread_->wait();
+}
+
+void
+ResolverWorker::run() {
+    dispatcher_.setThreadResolver(&resolver_);
+    io_service_.run();
+}
+
+void
+ResolverWorker::call(const boost::function<void()>& function) {
+    CallState state;
+    io_service_.post(boost::bind(callWrapper, function, &state));
+    Mutex::Locker locker(state.mutex);
+    while (!state.done) {
+        state.cond.wait(state.mutex);
+    }
+    if (!state.error.empty()) {
+        bundy_throw(bundy::Unexpected, state.error);
+    }
+}
+
+void
+ResolverWorker::doUpdateConfig(ConstElementPtr config, bool startup,
+                               ConstElementPtr& answer)
+{
+    answer = resolver_.updateConfig(config, startup);
+}
+
+ConstElementPtr
+ResolverWorker::updateConfig(ConstElementPtr config, bool startup) {
+    ConstElementPtr answer;
+    call(boost::bind(&ResolverWorker::doUpdateConfig, this,
+                     workerConfig(config), startup, boost::ref(answer)));
+    return (answer);
+}
+
+void
+ResolverWorker::addServerTCPFromFD(int fd, int af) {
+    call(boost::bind(&DNSService::addServerTCPFromFD, &dns_service_, fd, af));
+}
+
+void
+ResolverWorker::addServerUDPFromFD(int fd, int af,
+                                   DNSServiceBase::ServerFlag options)
+{
+    call(boost::bind(&DNSService::addServerUDPFromFD, &dns_service_, fd, af,
+                     options));
+}
+
+void
+ResolverWorker::clearServers() {
+    call(boost::bind(&DNSService::clearServers, &dns_service_));
+}
+
+void
+ResolverWorker::setTCPRecvTimeout(size_t timeout) {
+    call(boost::bind(&DNSService::setTCPRecvTimeout, &dns_service_,
+                     timeout));
+}
+
+namespace {
+
+// Duplicate the descriptor for a worker.
+int
+dupSocket(int fd) {
+    const int result = dup(fd);
+    if (result == -1) {
+        bundy_throw(bundy::Unexpected, "Failed to duplicate socket: " <<
+                    strerror(errno));
+    }
+    return (result);
+}
+
+}
+
+ResolverWorkerPool::ResolverWorkerPool(DNSService& primary, size_t count,
+                                       ResolverDispatcher& dispatcher,
+                                       bundy::nsas::NameserverAddressStore&
+                                       nsas,
+                                       bundy::cache::ResolverCache& cache) :
+    primary_(primary)
+{
+    for (size_t i = 0; i < count; ++i) {
+        workers_.push_back(ResolverWorkerPtr(new ResolverWorker(dispatcher,
+                                                                nsas,
+                                                                cache)));
+    }
+    LOG_INFO(resolver_logger, RESOLVER_WORKERS_STARTED).arg(count);
+}
+
+ResolverWorkerPool::~ResolverWorkerPool() {
+    workers_.clear();
+    LOG_DEBUG(resolver_logger, RESOLVER_DBG_INIT, RESOLVER_WORKERS_STOPPED);
+}
+
+void
+ResolverWorkerPool::updateConfig(ConstElementPtr config, bool startup) {
+    BOOST_FOREACH(const ResolverWorkerPtr& worker, workers_) {
+        worker->updateConfig(config, startup);
+    }
+}
+
+void
+ResolverWorkerPool::addServerTCPFromFD(int fd, int af) {
+    primary_.addServerTCPFromFD(fd, af);
+    BOOST_FOREACH(const ResolverWorkerPtr& worker, workers_) {
+        const int worker_fd = dupSocket(fd);
+        try {
+            worker->addServerTCPFromFD(worker_fd, af);
+        } catch (...) {
+            close(worker_fd);
+            throw;
+        }
+    }
+}
+
+void
+ResolverWorkerPool::addServerUDPFromFD(int fd, int af, ServerFlag options) {
+    primary_.addServerUDPFromFD(fd, af, options);
+    BOOST_FOREACH(const ResolverWorkerPtr& worker, workers_) {
+        const int worker_fd = dupSocket(fd);
+        try {
+            worker->addServerUDPFromFD(worker_fd, af, options);
+        } catch (...) {
+            close(worker_fd);
+            throw;
+        }
+    }
+}
+
+void
+ResolverWorkerPool::clearServers() {
+    primary_.clearServers();
+    BOOST_FOREACH(const ResolverWorkerPtr& worker, workers_) {
+        worker->clearServers();
+    }
+}
+
+void
+ResolverWorkerPool::setTCPRecvTimeout(size_t timeout) {
+    primary_.setTCPRecvTimeout(timeout);
+    BOOST_FOREACH(const ResolverWorkerPtr& worker, workers_) {
+        worker->setTCPRecvTimeout(timeout);
+    }
+}
@@ -0,0 +1,198 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef RESOLVER_WORKER_H
+#define RESOLVER_WORKER_H 1
+
+#include <resolver/resolver.h>
+
+#include <asiodns/dns_service.h>
+#include <asiolink/io_service.h>
+#include <cc/data.h>
+#include <resolve/resolver_interface.h>
+#include <util/threads/thread.h>
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <pthread.h>
+
+#include <vector>
+
+/// \brief Resolver interface handed to a shared NSAS.
+///
+/// The nameserver address store issues its own lookups (for the addresses
+/// of nameservers) through a single \c ResolverInterface given at
+/// construction.  When the store is shared by several threads, each of
+/// them running its own \c Resolver on its own \c IOService, the lookup
+/// must be done by the resolver of the thread asking, otherwise the
+/// answer would be delivered into an event loop the asking thread does
+/// not run.  This class remembers the resolver of each thread and
+/// forwards the lookups to it.
+class ResolverDispatcher : public bundy::resolve::ResolverInterface {
+public:
+    /// \brief Constructor.
+    ///
+    /// \throw bundy::Unexpected if the thread-specific storage can't be
+    ///     allocated.
+    ResolverDispatcher();
+
+    /// \brief Destructor.
+    virtual ~ResolverDispatcher();
+
+    /// \brief Register the resolver to be used by the calling thread.
+    ///
+    /// \param resolver The resolver.  It must outlive any use of the
+    ///     dispatcher from the calling thread.
+    void setThreadResolver(bundy::resolve::ResolverInterface* resolver);
+
+    /// \brief Forward the lookup to the calling thread's resolver.
+    ///
+    /// \throw bundy::InvalidOperation if the calling thread has not
+    ///     registered any resolver.
+    virtual void resolve(const bundy::dns::QuestionPtr& question,
+                         const CallbackPtr& callback);
+
+private:
+    pthread_key_t key_;
+};
+
+/// \brief A resolver running in its own thread.
+///
+/// Each worker has its own \c IOService, \c Resolver and \c DNSService, so
+/// it receives queries, sends the upstream queries and answers the client
+/// without any interaction with the other threads.  The cache and the
+/// NSAS are shared by all the workers.
+///
+/// All the public methods are called from the main thread; they are
+/// executed in the worker thread and the caller waits for them to
+/// complete.
+class ResolverWorker : boost::noncopyable {
+public:
+    /// \brief Constructor.
+    ///
+    /// Creates the resolver and starts the thread.
+    ///
+    /// \param dispatcher The dispatcher used by the shared NSAS.
+    /// \param nsas The shared nameserver address store.
+    /// \param cache The shared resolver cache.
+    ResolverWorker(ResolverDispatcher& dispatcher,
+                   bundy::nsas::NameserverAddressStore& nsas,
+                   bundy::cache::ResolverCache& cache);
+
+    /// \brief Destructor.
+    ///
+    /// Stops the thread and waits for it to terminate.
+    ~ResolverWorker();
+
+    /// \brief Apply a new configuration to the worker's resolver.
+    ///
+    /// The \c listen_on item is ignored, the listening sockets are passed
+    /// to the worker by the \c ResolverWorkerPool.
+    ///
+    /// \return The answer of \c Resolver::updateConfig().
+    bundy::data::ConstElementPtr
+    updateConfig(bundy::data::ConstElementPtr config, bool startup);
+
+    /// \brief Add a TCP server on the given socket.
+    ///
+    /// The worker takes the ownership of the descriptor.
+    void addServerTCPFromFD(int fd, int af);
+
+    /// \brief Add a UDP server on the given socket.
+    ///
+    /// The worker takes the ownership of the descriptor.
+    void addServerUDPFromFD(int fd, int af,
+                            bundy::asiodns::DNSServiceBase::ServerFlag options);
+
+    /// \brief Remove all the servers of the worker.
+    void clearServers();
+
+    /// \brief Set the TCP receive timeout of the worker's servers.
+    void setTCPRecvTimeout(size_t timeout);
+
+private:
+    // The thread main function.
+    void run();
+
+    // Execute the function in the worker thread and wait for it.  An
+    // exception thrown by the function is rethrown as bundy::Unexpected.
+    void call(const boost::function<void()>& function);
+
+    // Helper of updateConfig() run in the worker thread.
+    void doUpdateConfig(bundy::data::ConstElementPtr config, bool startup,
+                        bundy::data::ConstElementPtr& answer);
+
+    ResolverDispatcher& dispatcher_;
+    bundy::asiolink::IOService io_service_;
+    Resolver resolver_;
+    bundy::asiodns::DNSService dns_service_;
+    boost::scoped_ptr<bundy::util::thread::Thread> thread_;
+};
+
+typedef boost::shared_ptr<ResolverWorker> ResolverWorkerPtr;
+
+/// \brief Set of resolver worker threads.
+///
+/// The pool acts as the \c DNSServiceBase of the main resolver.  The
+/// listening sockets are received from the socket creator by the main
+/// thread; every socket is installed in the main \c DNSService and a
+/// duplicate of its descriptor in each of the workers, so all the threads
+/// wait for queries on the same sockets and the kernel hands each query
+/// to one of them.
+class ResolverWorkerPool : public bundy::asiodns::DNSServiceBase {
+public:
+    /// \brief Constructor.
+    ///
+    /// Starts \c count worker threads.
+    ///
+    /// \param primary The DNS service of the main thread.
+    /// \param count Number of the additional threads.
+    /// \param dispatcher The dispatcher used by the shared NSAS.
+    /// \param nsas The shared nameserver address store.
+    /// \param cache The shared resolver cache.
+    ResolverWorkerPool(bundy::asiodns::DNSService& primary, size_t count,
+                       ResolverDispatcher& dispatcher,
+                       bundy::nsas::NameserverAddressStore& nsas,
+                       bundy::cache::ResolverCache& cache);
+
+    /// \brief Destructor.
+    ///
+    /// Stops all the workers.
+    virtual ~ResolverWorkerPool();
+
+    /// \brief Apply a new configuration to all the workers.
+    void updateConfig(bundy::data::ConstElementPtr config, bool startup);
+
+    virtual void addServerTCPFromFD(int fd, int af);
+    virtual void addServerUDPFromFD(int fd, int af,
+                                    ServerFlag options = SERVER_DEFAULT);
+    virtual void clearServers();
+    virtual void setTCPRecvTimeout(size_t timeout);
+    virtual bundy::asiolink::IOService& getIOService() {
+        return (primary_.getIOService());
+    }
+
+private:
+    bundy::asiodns::DNSService& primary_;
+    std::vector<ResolverWorkerPtr> workers_;
+};
+
+#endif // RESOLVER_WORKER_H
+
+// Local Variables:
+// mode: c++
+// End:
@@ -410,6 +410,58 @@ TEST_F(ResolverConfig, invalidTimeoutsConfig) {
         "}", "Negative number of retries");
 }
 
+TEST_F(ResolverConfig, maxStaleTTLConfig) {
+    bundy::cache::ResolverCache cache;
+    server.setCache(cache);
+    EXPECT_EQ(0, cache.getMaxStaleTTL());
+    ConstElementPtr config(Element::fromJSON("{ \"max_stale_ttl\": 86400 }"));
+    ConstElementPtr result(server.updateConfig(config));
+    EXPECT_EQ(result->toWire(), bundy::config::createAnswer()->toWire());
+    EXPECT_EQ(86400, cache.getMaxStaleTTL());
+
+    invalidTest("{"
+        "\"max_stale_ttl\": \"error\""
+        "}", "Wrong max stale TTL element type");
+    invalidTest("{"
+        "\"max_stale_ttl\": -1"
+        "}", "Negative max stale TTL");
+    EXPECT_EQ(86400, cache.getMaxStaleTTL());
+}
+
+TEST_F(ResolverConfig, maxCacheMemoryConfig) {
+    bundy::cache::ResolverCache cache;
+    server.setCache(cache);
+    EXPECT_EQ(0, cache.getMemory().getLimit());
+    ConstElementPtr config(Element::fromJSON(
+                               "{ \"max_cache_memory\": 1048576 }"));
+    ConstElementPtr result(server.updateConfig(config));
+    EXPECT_EQ(result->toWire(), bundy::config::createAnswer()->toWire());
+    EXPECT_EQ(1048576, cache.getMemory().getLimit());
+
+    invalidTest("{"
+        "\"max_cache_memory\": \"error\""
+        "}", "Wrong cache memory limit element type");
+    invalidTest("{"
+        "\"max_cache_memory\": -1"
+        "}", "Negative cache memory limit");
+    EXPECT_EQ(1048576, cache.getMemory().getLimit());
+}
+
+TEST_F(ResolverConfig, statistics) {
+    // Nothing to report without a cache
+    EXPECT_TRUE(server.getStatistics()->mapValue().empty());
+
+    bundy::cache::ResolverCache cache;
+    server.setCache(cache);
+    cache.setMemoryLimit(4096);
+    const ConstElementPtr statistics(server.getStatistics());
+    EXPECT_EQ(4, statistics->mapValue().size());
+    EXPECT_EQ(0, statistics->get("cache_memory_used")->intValue());
+    EXPECT_EQ(4096, statistics->get("cache_memory_limit")->intValue());
+    EXPECT_EQ(0, statistics->get("cache_evictions")->intValue());
+    EXPECT_EQ(0, statistics->get("cache_rejections")->intValue());
+}
+
 TEST_F(ResolverConfig, defaultQueryACL) {
     // If no configuration is loaded, the default ACL should reject everything.
     EXPECT_EQ(REJECT, server.getQueryACL().execute(createRequest("192.0.2.1")));
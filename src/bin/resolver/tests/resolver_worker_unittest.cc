@@ -0,0 +1,217 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <resolver/resolver_worker.h>
+
+#include <exceptions/exceptions.h>
+
+#include <asiolink/io_service.h>
+#include <cache/resolver_cache.h>
+#include <cc/data.h>
+#include <config/ccsession.h>
+#include <dns/message.h>
+#include <dns/messagerenderer.h>
+#include <dns/name.h>
+#include <dns/opcode.h>
+#include <dns/question.h>
+#include <dns/rcode.h>
+#include <dns/rrclass.h>
+#include <dns/rrtype.h>
+#include <nsas/nameserver_address_store.h>
+#include <util/buffer.h>
+#include <util/threads/thread.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cstring>
+
+using namespace bundy::dns;
+using namespace bundy::data;
+using bundy::asiodns::DNSService;
+using bundy::asiolink::IOService;
+using bundy::resolve::ResolverInterface;
+using bundy::util::thread::Thread;
+
+namespace {
+
+// A resolver counting the lookups it is asked for.
+class CountingResolver : public ResolverInterface {
+public:
+    CountingResolver() : count_(0) {}
+    virtual void resolve(const QuestionPtr&, const CallbackPtr&) {
+        ++count_;
+    }
+    int count_;
+};
+
+QuestionPtr
+testQuestion() {
+    return (QuestionPtr(new Question(Name("example.org"), RRClass::IN(),
+                                     RRType::A())));
+}
+
+void
+registerAndResolve(ResolverDispatcher* dispatcher,
+                   ResolverInterface* resolver)
+{
+    dispatcher->setThreadResolver(resolver);
+    dispatcher->resolve(testQuestion(), ResolverInterface::CallbackPtr());
+}
+
+// The dispatcher refuses the lookups of a thread without a resolver.
+TEST(ResolverDispatcherTest, noResolver) {
+    ResolverDispatcher dispatcher;
+    EXPECT_THROW(dispatcher.resolve(testQuestion(),
+                                    ResolverInterface::CallbackPtr()),
+                 bundy::InvalidOperation);
+}
+
+// Each thread's lookups go to the resolver it registered.
+TEST(ResolverDispatcherTest, perThread) {
+    ResolverDispatcher dispatcher;
+    CountingResolver main_resolver;
+    CountingResolver thread_resolver;
+    dispatcher.setThreadResolver(&main_resolver);
+
+    Thread thread(boost::bind(&registerAndResolve, &dispatcher,
+                              &thread_resolver));
+    thread.wait();
+    EXPECT_EQ(0, main_resolver.count_);
+    EXPECT_EQ(1, thread_resolver.count_);
+
+    dispatcher.resolve(testQuestion(), ResolverInterface::CallbackPtr());
+    EXPECT_EQ(1, main_resolver.count_);
+    EXPECT_EQ(1, thread_resolver.count_);
+}
+
+class ResolverWorkerTest : public ::testing::Test {
+protected:
+    ResolverWorkerTest() :
+        dispatcher_(new ResolverDispatcher()),
+        nsas_(dispatcher_),
+        primary_(primary_io_, resolver_.getDNSLookupProvider(),
+                 resolver_.getDNSAnswerProvider())
+    {}
+
+    boost::shared_ptr<ResolverDispatcher> dispatcher_;
+    bundy::nsas::NameserverAddressStore nsas_;
+    bundy::cache::ResolverCache cache_;
+    // The main thread's resolver and service.  The primary_io_ is never
+    // run, so only the workers answer the queries.
+    Resolver resolver_;
+    IOService primary_io_;
+    DNSService primary_;
+};
+
+// The configuration is applied by the worker and its answer returned.
+TEST_F(ResolverWorkerTest, updateConfig) {
+    ResolverWorker worker(*dispatcher_, nsas_, cache_);
+    int rcode = -1;
+
+    bundy::config::parseAnswer(rcode, worker.updateConfig(Element::fromJSON(
+        "{\"forward_addresses\": [{\"address\": \"192.0.2.1\", "
+        "\"port\": 53}]}"), false));
+    EXPECT_EQ(0, rcode);
+
+    bundy::config::parseAnswer(rcode, worker.updateConfig(Element::fromJSON(
+        "{\"forward_addresses\": [{\"address\": \"bad\", \"port\": 53}]}"),
+        false));
+    EXPECT_EQ(1, rcode);
+}
+
+// The workers are started and stopped repeatedly, without servers and
+// with servers installed.
+TEST_F(ResolverWorkerTest, startStop) {
+    for (int i = 0; i < 10; ++i) {
+        ResolverWorkerPool pool(primary_, 4, *dispatcher_, nsas_, cache_);
+    }
+    for (int i = 0; i < 10; ++i) {
+        const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        ASSERT_NE(-1, fd);
+        ResolverWorkerPool pool(primary_, 4, *dispatcher_, nsas_, cache_);
+        pool.addServerUDPFromFD(fd, AF_INET);
+    }
+    primary_.clearServers();
+}
+
+// The queries received on a socket given to the pool are answered by the
+// worker threads.
+TEST_F(ResolverWorkerTest, dispatchToWorkers) {
+    ResolverWorkerPool pool(primary_, 2, *dispatcher_, nsas_, cache_);
+
+    // The server socket, on a port chosen by the system.
+    const int server_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_NE(-1, server_fd);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    ASSERT_EQ(0, bind(server_fd, reinterpret_cast<struct sockaddr*>(&addr),
+                      sizeof(addr)));
+    socklen_t addr_len = sizeof(addr);
+    ASSERT_EQ(0, getsockname(server_fd,
+                             reinterpret_cast<struct sockaddr*>(&addr),
+                             &addr_len));
+    pool.addServerUDPFromFD(server_fd, AF_INET);
+
+    const int client_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_NE(-1, client_fd);
+    struct timeval timeout = { 10, 0 };
+    ASSERT_EQ(0, setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+                            sizeof(timeout)));
+
+    // A NOTIFY is answered with NOTAUTH right away, without any upstream
+    // query.
+    for (uint16_t qid = 1; qid <= 10; ++qid) {
+        Message query(Message::RENDER);
+        query.setQid(qid);
+        query.setOpcode(Opcode::NOTIFY());
+        query.setRcode(Rcode::NOERROR());
+        query.addQuestion(Question(Name("example.org"), RRClass::IN(),
+                                   RRType::SOA()));
+        MessageRenderer renderer;
+        query.toWire(renderer);
+        ASSERT_EQ(static_cast<ssize_t>(renderer.getLength()),
+                  sendto(client_fd, renderer.getData(), renderer.getLength(),
+                         0, reinterpret_cast<struct sockaddr*>(&addr),
+                         sizeof(addr)));
+
+        uint8_t data[512];
+        const ssize_t length = recv(client_fd, data, sizeof(data), 0);
+        ASSERT_LT(0, length) << "No answer from the workers";
+        bundy::util::InputBuffer buffer(data, length);
+        Message answer(Message::PARSE);
+        answer.fromWire(buffer);
+        EXPECT_EQ(qid, answer.getQid());
+        EXPECT_EQ(Rcode::NOTAUTH(), answer.getRcode());
+    }
+    close(client_fd);
+
+    pool.clearServers();
+}
+
+}
@@ -101,6 +101,8 @@ struct IOFetchData {
     uint8_t                     staging[IOFetch::STAGING_LENGTH];
                                             ///< Temporary array for received data
     bundy::dns::qid_t             qid;         ///< The QID set in the query
+    TCPConnectionPoolPtr        pool;        ///< Pool of TCP connections
+    bool                        pooled;      ///< Query is in the pool
 
     /// \brief Constructor
     ///
@@ -150,7 +152,9 @@ struct IOFetchData {
         packet(false),
         origin(ASIODNS_UNKNOWN_ORIGIN),
         staging(),
-        qid(QidGenerator::getInstance().generateQid())
+        qid(QidGenerator::getInstance().generateQid()),
+        pool(),
+        pooled(false)
     {}
 
     // Checks if the response we received was ok;
@@ -239,6 +243,11 @@ IOFetch::getProtocol() const {
     return (data_->protocol);
 }
 
+void
+IOFetch::setConnectionPool(const TCPConnectionPoolPtr& pool) {
+    data_->pool = pool;
+}
+
 /// The function operator is implemented with the "stackless coroutine"
 /// pattern; see internal/coroutine.h for details.
 
@@ -249,6 +258,13 @@ IOFetch::operator()(asio::error_code ec, size_t length) {
         return;
     } else if (ec) {
         logIOFailure(ec);
+        if (data_->pooled) {
+            // The pool has already given up the query, and its QID may be
+            // reused by another fetch, so it's not to be cancelled.  There's
+            // no point in waiting for the timeout either.
+            data_->pooled = false;
+            stop(TIME_OUT);
+        }
         return;
     }
 
@@ -275,6 +291,25 @@ IOFetch::operator()(asio::error_code ec, size_t length) {
                 TIME_OUT));
         }
 
+        // With a connection pool, the pool takes care of the connection and
+        // of matching the response to the query.
+        if (data_->pool && data_->protocol == TCP) {
+            data_->origin = ASIODNS_READ_DATA;
+            data_->received->clear();
+            CORO_YIELD {
+                data_->qid = data_->pool->asyncQuery(
+                    data_->remote_snd->getAddress(),
+                    data_->remote_snd->getPort(), data_->msgbuf,
+                    data_->received, *this);
+                data_->pooled = true;
+            }
+            data_->pooled = false;
+            data_->cumulative = length;
+            data_->origin = ASIODNS_UNKNOWN_ORIGIN;
+            stop(SUCCESS);
+            return;
+        }
+
         // Open a connection to the target system.  For speed, if the operation
         // is synchronous (i.e. UDP operation) we bypass the yield.
         data_->origin = ASIODNS_OPEN_SOCKET;
@@ -390,6 +425,11 @@ IOFetch::stop(Result result) {
         // and cancel the timer.
         data_->socket->cancel();
         data_->socket->close();
+        if (data_->pooled) {
+            data_->pool->cancel(data_->remote_snd->getAddress(),
+                                data_->remote_snd->getPort(), data_->qid);
+            data_->pooled = false;
+        }
 
         data_->timer.cancel();
 
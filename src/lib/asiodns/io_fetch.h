@@ -26,6 +26,7 @@
 #include <asio/error_code.hpp>
 #include <asiolink/io_address.h>
 #include <asiolink/io_service.h>
+#include <asiodns/tcp_connection_pool.h>
 
 #include <util/buffer.h>
 #include <dns/question.h>
@@ -184,6 +185,16 @@ public:
     /// \return Protocol associated with this IOFetch object.
     Protocol getProtocol() const;
 
+    /// \brief Use a pool of TCP connections
+    ///
+    /// If set (before the fetch is started), a TCP fetch sends its query
+    /// over a connection of the pool instead of opening a connection of
+    /// its own.  The QID of the query may be altered by the pool.  UDP
+    /// fetches ignore the pool.
+    ///
+    /// \param pool The connection pool.
+    void setConnectionPool(const TCPConnectionPoolPtr& pool);
+
     /// \brief Coroutine entry point
     ///
     /// The operator() method is the method in which the coroutine code enters
@@ -0,0 +1,513 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <asiodns/tcp_connection_pool.h>
+#include <asiodns/logger.h>
+
+#include <exceptions/exceptions.h>
+#include <util/io_utilities.h>
+#include <util/random/qid_gen.h>
+
+#include <asio.hpp>
+#include <asio/deadline_timer.hpp>
+
+#include <asiolink/tcp_endpoint.h>
+
+#include <boost/bind.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/foreach.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <deque>
+#include <map>
+#include <utility>
+#include <vector>
+
+using namespace asio;
+using namespace bundy::asiolink;
+using namespace bundy::dns;
+using namespace bundy::util;
+using namespace bundy::util::random;
+using namespace bundy::log;
+
+namespace bundy {
+namespace asiodns {
+
+namespace {
+
+const int DBG_POOL = DBGLVL_TRACE_DETAIL;
+
+// Identification of an upstream server
+typedef std::pair<IOAddress, uint16_t> Upstream;
+
+// A query waiting for its response
+struct PendingQuery {
+    PendingQuery(const OutputBufferPtr& q, const OutputBufferPtr& r,
+                 const TCPConnectionPool::Handler& h) :
+        query(q), response(r), handler(h), resent(false)
+    {}
+    OutputBufferPtr query;
+    OutputBufferPtr response;
+    TCPConnectionPool::Handler handler;
+    bool resent;            // Has already been sent on a failed connection
+};
+
+typedef std::map<qid_t, PendingQuery> PendingMap;
+
+}
+
+class PooledConnection;
+typedef boost::shared_ptr<PooledConnection> PooledConnectionPtr;
+
+/// \brief Implementation of the pool
+class TCPConnectionPoolImpl {
+public:
+    TCPConnectionPoolImpl(IOService& service, int idle_timeout,
+                          size_t max_connections, size_t max_pipelined) :
+        service_(service), idle_timeout_(idle_timeout),
+        max_connections_(max_connections), max_pipelined_(max_pipelined)
+    {}
+
+    ~TCPConnectionPoolImpl();
+
+    // Send the query to the upstream, choosing (or opening) a connection.
+    // The QID of the query is changed if another query to the upstream
+    // uses it.
+    qid_t send(const Upstream& upstream, PendingQuery pending);
+
+    // Send the query to the upstream with the given QID, which the query
+    // already carries and no other query to the upstream uses.
+    void send(const Upstream& upstream, qid_t qid,
+              const PendingQuery& pending);
+
+    // Check if a query to the upstream uses the QID.
+    bool hasQid(const Upstream& upstream, qid_t qid) const;
+
+    // A connection to the upstream has been closed.
+    void remove(const Upstream& upstream, PooledConnection* connection);
+
+    IOService& service_;
+    const int idle_timeout_;
+    const size_t max_connections_;
+    const size_t max_pipelined_;
+    std::map<Upstream, std::vector<PooledConnectionPtr> > connections_;
+};
+
+/// \brief A connection to an upstream server
+///
+/// The connection keeps a read outstanding all the time it is open, and
+/// writes the queued queries one by one.  The asynchronous handlers keep
+/// a shared pointer to the connection, so it lives until the last of them
+/// is called, even if it has been removed from the pool before.
+class PooledConnection :
+    public boost::enable_shared_from_this<PooledConnection>
+{
+public:
+    PooledConnection(TCPConnectionPoolImpl* pool, const Upstream& upstream) :
+        pool_(pool), upstream_(upstream),
+        socket_(pool->service_.get_io_service()),
+        idle_timer_(pool->service_.get_io_service()),
+        connected_(false), closed_(false), writing_(false), reused_(false)
+    {}
+
+    // Start connecting.  Must be called right after construction (it can't
+    // be done in the constructor because of shared_from_this()).
+    void connect() {
+        LOG_DEBUG(logger, DBG_POOL, ASIODNS_TCP_POOL_CONNECT).
+            arg(upstream_.first.toText()).arg(upstream_.second);
+        socket_.async_connect(TCPEndpoint(upstream_.first,
+                                          upstream_.second).getASIOEndpoint(),
+                              boost::bind(&PooledConnection::connectHandler,
+                                          shared_from_this(), _1));
+    }
+
+    size_t getPendingCount() const {
+        return (pending_.size());
+    }
+
+    bool hasQid(qid_t qid) const {
+        return (pending_.count(qid) > 0);
+    }
+
+    // Queue the query (which already carries the given QID) for sending.
+    void send(qid_t qid, const PendingQuery& pending) {
+        idle_timer_.cancel();
+        pending_.insert(PendingMap::value_type(qid, pending));
+
+        const size_t length = pending.query->getLength();
+        OutputBufferPtr framed(new OutputBuffer(length + 2));
+        framed->writeUint16(length);
+        framed->writeData(pending.query->getData(), length);
+        write_queue_.push_back(framed);
+        if (connected_) {
+            startWrite();
+        }
+    }
+
+    bool cancel(qid_t qid) {
+        if (pending_.erase(qid) == 0) {
+            return (false);
+        }
+        if (pending_.empty()) {
+            startIdle();
+        }
+        return (true);
+    }
+
+    // Close without calling any handler, used when the pool is destroyed.
+    void detach() {
+        pool_ = NULL;
+        pending_.clear();
+        close();
+    }
+
+private:
+    void close() {
+        if (!closed_) {
+            closed_ = true;
+            asio::error_code ec;
+            socket_.close(ec);
+            idle_timer_.cancel();
+        }
+    }
+
+    void startWrite() {
+        if (writing_ || write_queue_.empty() || closed_) {
+            return;
+        }
+        writing_ = true;
+        const OutputBufferPtr& buffer(write_queue_.front());
+        async_write(socket_, asio::buffer(buffer->getData(),
+                                          buffer->getLength()),
+                    boost::bind(&PooledConnection::writeHandler,
+                                shared_from_this(), _1));
+    }
+
+    void startRead() {
+        async_read(socket_, asio::buffer(length_, sizeof(length_)),
+                   boost::bind(&PooledConnection::lengthHandler,
+                               shared_from_this(), _1));
+    }
+
+    void startIdle() {
+        idle_timer_.expires_from_now(
+            boost::posix_time::milliseconds(pool_->idle_timeout_));
+        idle_timer_.async_wait(boost::bind(&PooledConnection::idleHandler,
+                                           shared_from_this(), _1));
+    }
+
+    void connectHandler(const asio::error_code& ec) {
+        if (closed_) {
+            return;
+        }
+        if (ec) {
+            fail(ec);
+            return;
+        }
+        connected_ = true;
+        startRead();
+        startWrite();
+    }
+
+    void writeHandler(const asio::error_code& ec) {
+        writing_ = false;
+        if (closed_) {
+            return;
+        }
+        if (ec) {
+            fail(ec);
+            return;
+        }
+        write_queue_.pop_front();
+        startWrite();
+    }
+
+    void lengthHandler(const asio::error_code& ec) {
+        if (closed_) {
+            return;
+        }
+        if (ec) {
+            fail(ec);
+            return;
+        }
+        body_.resize(readUint16(length_, sizeof(length_)));
+        if (body_.size() < sizeof(qid_t)) {
+            fail(asio::error::invalid_argument);
+            return;
+        }
+        async_read(socket_, asio::buffer(&body_[0], body_.size()),
+                   boost::bind(&PooledConnection::bodyHandler,
+                               shared_from_this(), _1));
+    }
+
+    void bodyHandler(const asio::error_code& ec) {
+        if (closed_) {
+            return;
+        }
+        if (ec) {
+            fail(ec);
+            return;
+        }
+        reused_ = true;
+        startRead();
+
+        // Responses to cancelled queries are silently dropped.
+        const qid_t qid = readUint16(&body_[0], body_.size());
+        PendingMap::iterator it = pending_.find(qid);
+        if (it == pending_.end()) {
+            return;
+        }
+        const PendingQuery pending(it->second);
+        pending_.erase(it);
+        if (pending_.empty()) {
+            startIdle();
+        }
+        pending.response->clear();
+        pending.response->writeData(&body_[0], body_.size());
+        pending.handler(asio::error_code(), body_.size());
+    }
+
+    void idleHandler(const asio::error_code& ec) {
+        if (ec || closed_ || !pending_.empty()) {
+            return;
+        }
+        LOG_DEBUG(logger, DBG_POOL, ASIODNS_TCP_POOL_IDLE).
+            arg(upstream_.first.toText()).arg(upstream_.second);
+        close();
+        if (pool_ != NULL) {
+            pool_->remove(upstream_, this);
+        }
+    }
+
+    // The connection failed (or was closed by the server).
+    void fail(const asio::error_code& ec) {
+        LOG_DEBUG(logger, DBG_POOL, ASIODNS_TCP_POOL_CLOSED).
+            arg(upstream_.first.toText()).arg(upstream_.second).
+            arg(ec.message());
+        close();
+        if (pool_ == NULL) {
+            return;
+        }
+        TCPConnectionPoolImpl* pool = pool_;
+        pool_->remove(upstream_, this);
+        pool_ = NULL;
+
+        // A server may close a connection it considers idle while our
+        // queries are on the way, so give them another chance if the
+        // connection had already been used.  They keep their QID, as it
+        // is the one their owners cancel them with, so they are all sent
+        // before any handler is called (which may send new queries).
+        PendingMap pending;
+        pending.swap(pending_);
+        std::vector<PendingQuery> failed;
+        BOOST_FOREACH(PendingMap::value_type& entry, pending) {
+            if (reused_ && !entry.second.resent &&
+                !pool->hasQid(upstream_, entry.first)) {
+                entry.second.resent = true;
+                pool->send(upstream_, entry.first, entry.second);
+            } else {
+                failed.push_back(entry.second);
+            }
+        }
+        BOOST_FOREACH(const PendingQuery& query, failed) {
+            query.handler(ec, 0);
+        }
+    }
+
+    TCPConnectionPoolImpl* pool_;
+    const Upstream upstream_;
+    ip::tcp::socket socket_;
+    asio::deadline_timer idle_timer_;
+    bool connected_;
+    bool closed_;
+    bool writing_;
+    bool reused_;           // A response has been received on it
+    PendingMap pending_;
+    std::deque<OutputBufferPtr> write_queue_;
+    uint8_t length_[2];
+    std::vector<uint8_t> body_;
+};
+
+TCPConnectionPoolImpl::~TCPConnectionPoolImpl() {
+    typedef std::map<Upstream, std::vector<PooledConnectionPtr> >::value_type
+        UpstreamConnections;
+    BOOST_FOREACH(UpstreamConnections& upstream, connections_) {
+        BOOST_FOREACH(const PooledConnectionPtr& connection, upstream.second) {
+            connection->detach();
+        }
+    }
+}
+
+qid_t
+TCPConnectionPoolImpl::send(const Upstream& upstream, PendingQuery pending) {
+    // Make the QID unique among the queries outstanding to the upstream.
+    qid_t qid = readUint16(pending.query->getData(),
+                           pending.query->getLength());
+    while (hasQid(upstream, qid)) {
+        qid = QidGenerator::getInstance().generateQid();
+    }
+    pending.query->writeUint16At(qid, 0);
+    send(upstream, qid, pending);
+    return (qid);
+}
+
+void
+TCPConnectionPoolImpl::send(const Upstream& upstream, qid_t qid,
+                            const PendingQuery& pending)
+{
+    std::vector<PooledConnectionPtr>& connections = connections_[upstream];
+
+    // Use the least loaded connection, unless it is busy enough to open
+    // another one.
+    PooledConnectionPtr best;
+    BOOST_FOREACH(const PooledConnectionPtr& connection, connections) {
+        if (!best || connection->getPendingCount() < best->getPendingCount()) {
+            best = connection;
+        }
+    }
+    if (!best || (best->getPendingCount() >= max_pipelined_ &&
+                  connections.size() < max_connections_)) {
+        best.reset(new PooledConnection(this, upstream));
+        connections.push_back(best);
+        best->connect();
+    }
+    best->send(qid, pending);
+}
+
+bool
+TCPConnectionPoolImpl::hasQid(const Upstream& upstream, qid_t qid) const {
+    std::map<Upstream, std::vector<PooledConnectionPtr> >::const_iterator it =
+        connections_.find(upstream);
+    if (it == connections_.end()) {
+        return (false);
+    }
+    BOOST_FOREACH(const PooledConnectionPtr& connection, it->second) {
+        if (connection->hasQid(qid)) {
+            return (true);
+        }
+    }
+    return (false);
+}
+
+void
+TCPConnectionPoolImpl::remove(const Upstream& upstream,
+                              PooledConnection* connection)
+{
+    std::map<Upstream, std::vector<PooledConnectionPtr> >::iterator it =
+        connections_.find(upstream);
+    if (it == connections_.end()) {
+        return;
+    }
+    std::vector<PooledConnectionPtr>& connections = it->second;
+    for (std::vector<PooledConnectionPtr>::iterator c = connections.begin();
+         c != connections.end(); ++c) {
+        if (c->get() == connection) {
+            connections.erase(c);
+            break;
+        }
+    }
+    if (connections.empty()) {
+        connections_.erase(it);
+    }
+}
+
+TCPConnectionPool::TCPConnectionPool(IOService& service, int idle_timeout,
+                                     size_t max_connections,
+                                     size_t max_pipelined) :
+    impl_(new TCPConnectionPoolImpl(service, idle_timeout, max_connections,
+                                    max_pipelined))
+{}
+
+TCPConnectionPool::~TCPConnectionPool() {
+    delete impl_;
+}
+
+qid_t
+TCPConnectionPool::asyncQuery(const IOAddress& address, uint16_t port,
+                              const OutputBufferPtr& query,
+                              const OutputBufferPtr& response,
+                              const Handler& handler)
+{
+    if (query->getLength() < sizeof(qid_t)) {
+        bundy_throw(BadValue, "Query too short for a DNS message: " <<
+                    query->getLength() << " bytes");
+    }
+    return (impl_->send(Upstream(address, port),
+                        PendingQuery(query, response, handler)));
+}
+
+void
+TCPConnectionPool::cancel(const IOAddress& address, uint16_t port, qid_t qid) {
+    std::map<Upstream, std::vector<PooledConnectionPtr> >::iterator it =
+        impl_->connections_.find(Upstream(address, port));
+    if (it == impl_->connections_.end()) {
+        return;
+    }
+    BOOST_FOREACH(const PooledConnectionPtr& connection, it->second) {
+        if (connection->cancel(qid)) {
+            return;
+        }
+    }
+}
+
+size_t
+TCPConnectionPool::getConnectionCount() const {
+    size_t count = 0;
+    typedef std::map<Upstream, std::vector<PooledConnectionPtr> >::value_type
+        UpstreamConnections;
+    BOOST_FOREACH(const UpstreamConnections& upstream, impl_->connections_) {
+        count += upstream.second.size();
+    }
+    return (count);
+}
+
+size_t
+TCPConnectionPool::getPendingCount() const {
+    size_t count = 0;
+    typedef std::map<Upstream, std::vector<PooledConnectionPtr> >::value_type
+        UpstreamConnections;
+    BOOST_FOREACH(const UpstreamConnections& upstream, impl_->connections_) {
+        BOOST_FOREACH(const PooledConnectionPtr& connection, upstream.second) {
+            count += connection->getPendingCount();
+        }
+    }
+    return (count);
+}
+
+bool
+TCPConnectionPool::isSaturated() const {
+    typedef std::map<Upstream, std::vector<PooledConnectionPtr> >::value_type
+        UpstreamConnections;
+    BOOST_FOREACH(const UpstreamConnections& upstream, impl_->connections_) {
+        if (upstream.second.size() < impl_->max_connections_) {
+            continue;
+        }
+        bool full = true;
+        BOOST_FOREACH(const PooledConnectionPtr& connection, upstream.second) {
+            if (connection->getPendingCount() < impl_->max_pipelined_) {
+                full = false;
+                break;
+            }
+        }
+        if (full) {
+            return (true);
+        }
+    }
+    return (false);
+}
+
+} // namespace asiodns
+} // namespace bundy
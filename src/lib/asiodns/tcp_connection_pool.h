@@ -0,0 +1,150 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef TCP_CONNECTION_POOL_H
+#define TCP_CONNECTION_POOL_H 1
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <asio/error_code.hpp>
+#include <asiolink/io_address.h>
+#include <asiolink/io_service.h>
+
+#include <dns/message.h>
+#include <util/buffer.h>
+
+namespace bundy {
+namespace asiodns {
+
+// Forward declaration
+class TCPConnectionPoolImpl;
+
+/// \brief Pool of TCP connections to upstream servers
+///
+/// Opening a TCP connection for every upstream query costs a round trip
+/// for the handshake and an ephemeral port left in TIME_WAIT afterwards.
+/// This pool keeps the connections open and sends the queries to the
+/// same server over them (RFC 7766): several queries may be outstanding
+/// on a connection at the same time and the responses, which may come in
+/// any order, are matched to the queries by their QID.  The QID of a query
+/// is changed if another query to the same server already uses it.
+///
+/// A connection is closed when it has been idle for the configured time,
+/// or when the server closes it.  The queries that were outstanding on a
+/// reused connection closed by the server are sent once more on a new
+/// connection, as the server may have closed it before it saw them.  They
+/// keep their QID, so \c cancel() still finds them.
+///
+/// The pool is bound to one \c IOService and must only be used from the
+/// thread running it.
+class TCPConnectionPool : boost::noncopyable {
+public:
+    /// \brief Completion handler of a query
+    ///
+    /// Called with the error code and the length of the response, which
+    /// has been written to the response buffer given to \c asyncQuery().
+    typedef boost::function<void(asio::error_code, size_t)> Handler;
+
+    /// \brief Default values of the constructor parameters.
+    enum {
+        DEFAULT_IDLE_TIMEOUT = 10000,   ///< Idle timeout (ms)
+        DEFAULT_MAX_CONNECTIONS = 2,    ///< Connections per server
+        DEFAULT_MAX_PIPELINED = 32      ///< Outstanding queries per connection
+    };
+
+    /// \brief Constructor
+    ///
+    /// \param service I/O Service object to handle the connections.
+    /// \param idle_timeout Time (in ms) after which a connection without
+    ///     any outstanding query is closed.
+    /// \param max_connections Maximum number of connections opened to one
+    ///     server.
+    /// \param max_pipelined Number of outstanding queries on a connection
+    ///     above which a new connection is opened to the server (if
+    ///     \c max_connections allows it).
+    TCPConnectionPool(bundy::asiolink::IOService& service,
+                      int idle_timeout = DEFAULT_IDLE_TIMEOUT,
+                      size_t max_connections = DEFAULT_MAX_CONNECTIONS,
+                      size_t max_pipelined = DEFAULT_MAX_PIPELINED);
+
+    /// \brief Destructor
+    ///
+    /// Closes all the connections.  The handlers of the outstanding queries
+    /// are not called.
+    ~TCPConnectionPool();
+
+    /// \brief Send a query to a server
+    ///
+    /// The query is sent over an existing connection to the server if
+    /// there is one, otherwise a new connection is opened.  This method
+    /// does not call the handler itself; it is called from the event loop
+    /// once the response has been received or the connection has failed.
+    ///
+    /// \param address Address of the server.
+    /// \param port Port of the server.
+    /// \param query The query in wire format, without the length prefix.
+    ///     The QID (first two bytes) may be altered.
+    /// \param response Buffer into which the response is written.
+    /// \param handler Handler called when the query completes.
+    ///
+    /// \return The QID with which the query is sent.
+    /// \throw bundy::BadValue if the query is too short to contain a QID.
+    bundy::dns::qid_t asyncQuery(const bundy::asiolink::IOAddress& address,
+                                 uint16_t port,
+                                 const bundy::util::OutputBufferPtr& query,
+                                 const bundy::util::OutputBufferPtr& response,
+                                 const Handler& handler);
+
+    /// \brief Cancel a query
+    ///
+    /// The handler of the query will not be called; a response arriving
+    /// later is dropped.  Cancelling an unknown query is a no-op.
+    ///
+    /// \param address Address of the server.
+    /// \param port Port of the server.
+    /// \param qid The QID returned by \c asyncQuery().
+    void cancel(const bundy::asiolink::IOAddress& address, uint16_t port,
+                bundy::dns::qid_t qid);
+
+    /// \brief Number of open (or opening) connections
+    ///
+    /// Mainly useful for testing.
+    size_t getConnectionCount() const;
+
+    /// \brief Number of queries waiting for their response
+    ///
+    /// The count covers the queries queued for sending as well as the
+    /// ones already written, on all the connections.
+    size_t getPendingCount() const;
+
+    /// \brief Check if the pool can't take more queries without queueing
+    ///
+    /// This is true when the connections to one of the servers are all
+    /// open, each with \c max_pipelined outstanding queries.  The pool
+    /// still accepts queries then, but they are pipelined beyond the
+    /// limit, so the callers may want to hold the new ones back.
+    bool isSaturated() const;
+
+private:
+    TCPConnectionPoolImpl* impl_;
+};
+
+typedef boost::shared_ptr<TCPConnectionPool> TCPConnectionPoolPtr;
+
+} // namespace asiodns
+} // namespace bundy
+
+#endif // TCP_CONNECTION_POOL_H
@@ -742,6 +742,37 @@ TEST_F(IOFetchTest, TcpSendReceive8192ShortSend) {
     tcpSendReturnTest(test_data_.substr(0, 8192), true);
 }
 
+// Do the same with the query sent through a connection pool.
+TEST_F(IOFetchTest, TcpSendReceivePooled) {
+    TCPConnectionPoolPtr pool(new TCPConnectionPool(service_));
+    tcp_fetch_.setConnectionPool(pool);
+    tcpSendReturnTest(test_data_.substr(0, 8192));
+    EXPECT_EQ(1, pool->getConnectionCount());
+}
+
+TEST_F(IOFetchTest, TcpPooledTimeout) {
+    TCPConnectionPoolPtr pool(new TCPConnectionPool(service_));
+    tcp_fetch_.setConnectionPool(pool);
+    tcpSendReturnTest(test_data_.substr(0, 15), true);
+}
+
+// A query failed by the pool fails the fetch at once.
+TEST_F(IOFetchTest, TcpPooledFailure) {
+    TCPConnectionPoolPtr pool(new TCPConnectionPool(service_));
+    tcp_fetch_.setConnectionPool(pool);
+    protocol_ = IOFetch::TCP;
+    expected_ = IOFetch::TIME_OUT;
+
+    // Nothing listens on the port, so the connection is refused.
+    const boost::posix_time::ptime start =
+        boost::posix_time::microsec_clock::universal_time();
+    service_.get_io_service().post(tcp_fetch_);
+    service_.run();
+    EXPECT_TRUE(run_);
+    EXPECT_GT(boost::posix_time::milliseconds(16 * SEND_INTERVAL),
+              boost::posix_time::microsec_clock::universal_time() - start);
+}
+
 
 } // namespace asiodns
 } // namespace bundy
@@ -0,0 +1,344 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <asio.hpp>
+
+#include <exceptions/exceptions.h>
+#include <util/buffer.h>
+#include <util/io_utilities.h>
+
+#include <asiolink/io_address.h>
+#include <asiolink/io_service.h>
+#include <asiodns/tcp_connection_pool.h>
+
+#include <vector>
+
+using namespace asio;
+using namespace asio::ip;
+using namespace bundy::asiodns;
+using namespace bundy::asiolink;
+using namespace bundy::util;
+using namespace std;
+
+namespace {
+
+const char* const TEST_HOST = "127.0.0.1";
+const uint16_t TEST_PORT(5302);
+
+// A minimal DNS over TCP "server".  It accepts connections and reads the
+// queries; once it has received the expected number of them, it sends
+// them back (as their own responses) in reverse order.  If close_at_ is
+// set, it closes the connection instead of reading that query (counted
+// from the start of the test).
+class TCPConnectionPoolTest : public ::testing::Test {
+protected:
+    TCPConnectionPoolTest() :
+        acceptor_(service_.get_io_service(),
+                  tcp::endpoint(address::from_string(TEST_HOST), TEST_PORT)),
+        timer_(service_.get_io_service()),
+        accepted_(0), expected_(0), closed_(false), completed_(0),
+        close_at_(0), read_(0)
+    {
+        acceptor_.set_option(socket_base::reuse_address(true));
+        startAccept();
+    }
+
+    ~TCPConnectionPoolTest() {
+        // Make sure all the handlers are destroyed before the objects
+        // they refer to.
+        acceptor_.close();
+        if (socket_) {
+            socket_->close();
+        }
+        service_.get_io_service().reset();
+        service_.get_io_service().poll();
+    }
+
+    void startAccept() {
+        socket_.reset(new tcp::socket(service_.get_io_service()));
+        acceptor_.async_accept(*socket_,
+                               boost::bind(&TCPConnectionPoolTest::accepted,
+                                           this, _1));
+    }
+
+    void accepted(const asio::error_code& ec) {
+        if (ec) {
+            return;
+        }
+        ++accepted_;
+        startRead();
+    }
+
+    void startRead() {
+        async_read(*socket_, asio::buffer(length_, sizeof(length_)),
+                   boost::bind(&TCPConnectionPoolTest::lengthRead, this, _1));
+    }
+
+    void lengthRead(const asio::error_code& ec) {
+        if (ec) {
+            // The pool closed the connection.
+            closed_ = true;
+            service_.stop();
+            return;
+        }
+        body_.resize(readUint16(length_, sizeof(length_)));
+        async_read(*socket_, asio::buffer(&body_[0], body_.size()),
+                   boost::bind(&TCPConnectionPoolTest::bodyRead, this, _1));
+    }
+
+    void bodyRead(const asio::error_code& ec) {
+        if (ec) {
+            return;
+        }
+        if (++read_ == close_at_) {
+            socket_->close();
+            startAccept();
+            return;
+        }
+        received_.push_back(body_);
+        if (received_.size() == expected_) {
+            for (vector<vector<uint8_t> >::reverse_iterator it =
+                     received_.rbegin(); it != received_.rend(); ++it) {
+                OutputBuffer buffer(it->size() + 2);
+                buffer.writeUint16(it->size());
+                buffer.writeData(&(*it)[0], it->size());
+                asio::write(*socket_, asio::buffer(buffer.getData(),
+                                                   buffer.getLength()));
+            }
+            received_.clear();
+        }
+        startRead();
+    }
+
+    // Handler of the pooled queries
+    void completed(asio::error_code ec, size_t length) {
+        EXPECT_FALSE(ec);
+        lengths_.push_back(length);
+        if (++completed_ == expected_) {
+            service_.stop();
+        }
+    }
+
+    void timeout(const asio::error_code& ec) {
+        if (!ec) {
+            service_.stop();
+        }
+    }
+
+    // Run the service, with a safety timeout
+    void run(int timeout = 1000) {
+        timer_.expires_from_now(boost::posix_time::milliseconds(timeout));
+        timer_.async_wait(boost::bind(&TCPConnectionPoolTest::timeout, this,
+                                       _1));
+        service_.run();
+        timer_.cancel();
+        service_.get_io_service().reset();
+    }
+
+    OutputBufferPtr makeQuery(uint16_t qid, uint8_t tag) {
+        OutputBufferPtr query(new OutputBuffer(12));
+        query->writeUint16(qid);
+        for (int i = 0; i < 10; ++i) {
+            query->writeUint8(tag);
+        }
+        return (query);
+    }
+
+    TCPConnectionPool::Handler handler() {
+        return (boost::bind(&TCPConnectionPoolTest::completed, this, _1, _2));
+    }
+
+    IOService service_;
+    tcp::acceptor acceptor_;
+    asio::deadline_timer timer_;
+    boost::shared_ptr<tcp::socket> socket_;
+    uint8_t length_[2];
+    vector<uint8_t> body_;
+    vector<vector<uint8_t> > received_;
+    size_t accepted_;
+    size_t expected_;
+    bool closed_;
+    size_t completed_;
+    vector<size_t> lengths_;
+    size_t close_at_;
+    size_t read_;
+};
+
+// Several queries are sent over a single connection and the responses,
+// coming in a different order, are matched to them.
+TEST_F(TCPConnectionPoolTest, Pipelined) {
+    TCPConnectionPool pool(service_);
+    expected_ = 3;
+    vector<OutputBufferPtr> queries, responses;
+    for (uint8_t i = 0; i < expected_; ++i) {
+        queries.push_back(makeQuery(0x1000 + i, i));
+        responses.push_back(OutputBufferPtr(new OutputBuffer(0)));
+        EXPECT_EQ(0x1000 + i,
+                  pool.asyncQuery(IOAddress(TEST_HOST), TEST_PORT,
+                                  queries[i], responses[i], handler()));
+    }
+    EXPECT_EQ(1, pool.getConnectionCount());
+    run();
+
+    EXPECT_EQ(expected_, completed_);
+    EXPECT_EQ(1, accepted_);
+    for (size_t i = 0; i < expected_; ++i) {
+        ASSERT_EQ(queries[i]->getLength(), responses[i]->getLength());
+        EXPECT_EQ(0, memcmp(queries[i]->getData(), responses[i]->getData(),
+                            queries[i]->getLength()));
+    }
+
+    // The connection is reused for the next query.
+    completed_ = 0;
+    expected_ = 1;
+    EXPECT_EQ(0x2000, pool.asyncQuery(IOAddress(TEST_HOST), TEST_PORT,
+                                      makeQuery(0x2000, 9), responses[0],
+                                      handler()));
+    run();
+    EXPECT_EQ(1, completed_);
+    EXPECT_EQ(1, accepted_);
+    EXPECT_EQ(1, pool.getConnectionCount());
+}
+
+// Outstanding queries to the same server get different QIDs.
+TEST_F(TCPConnectionPoolTest, QidCollision) {
+    TCPConnectionPool pool(service_);
+    expected_ = 2;
+    OutputBufferPtr query1(makeQuery(0x1234, 1));
+    OutputBufferPtr query2(makeQuery(0x1234, 2));
+    OutputBufferPtr response1(new OutputBuffer(0));
+    OutputBufferPtr response2(new OutputBuffer(0));
+    EXPECT_EQ(0x1234, pool.asyncQuery(IOAddress(TEST_HOST), TEST_PORT,
+                                      query1, response1, handler()));
+    const uint16_t qid = pool.asyncQuery(IOAddress(TEST_HOST), TEST_PORT,
+                                         query2, response2, handler());
+    EXPECT_NE(0x1234, qid);
+    EXPECT_EQ(qid, readUint16(query2->getData(), query2->getLength()));
+    run();
+
+    EXPECT_EQ(2, completed_);
+    EXPECT_EQ(0x1234, readUint16(response1->getData(),
+                                 response1->getLength()));
+    EXPECT_EQ(qid, readUint16(response2->getData(), response2->getLength()));
+    EXPECT_EQ(1, (*response1)[2]);
+    EXPECT_EQ(2, (*response2)[2]);
+}
+
+// The handler of a cancelled query is not called.
+TEST_F(TCPConnectionPoolTest, Cancel) {
+    TCPConnectionPool pool(service_);
+    expected_ = 2;
+    OutputBufferPtr response(new OutputBuffer(0));
+    const uint16_t qid = pool.asyncQuery(IOAddress(TEST_HOST), TEST_PORT,
+                                         makeQuery(0x10, 1), response,
+                                         handler());
+    pool.asyncQuery(IOAddress(TEST_HOST), TEST_PORT, makeQuery(0x20, 2),
+                    response, handler());
+    pool.cancel(IOAddress(TEST_HOST), TEST_PORT, qid);
+    // Cancelling an unknown query is harmless.
+    pool.cancel(IOAddress(TEST_HOST), TEST_PORT, 0x30);
+    pool.cancel(IOAddress(TEST_HOST), TEST_PORT + 1, 0x20);
+    run(300);
+
+    EXPECT_EQ(1, completed_);
+    EXPECT_EQ(0x20, readUint16(response->getData(), response->getLength()));
+}
+
+// A query outstanding on a reused connection closed by the server is
+// sent again on a new connection, with the same QID.
+TEST_F(TCPConnectionPoolTest, ResendOnClose) {
+    TCPConnectionPool pool(service_);
+    expected_ = 1;
+    OutputBufferPtr response(new OutputBuffer(0));
+    pool.asyncQuery(IOAddress(TEST_HOST), TEST_PORT, makeQuery(0x10, 1),
+                    response, handler());
+    run();
+    EXPECT_EQ(1, completed_);
+
+    // The second query isn't answered, on either connection.
+    expected_ = 2;
+    close_at_ = 2;
+    const uint16_t qid = pool.asyncQuery(IOAddress(TEST_HOST), TEST_PORT,
+                                         makeQuery(0x20, 2), response,
+                                         handler());
+    run(300);
+    EXPECT_EQ(1, completed_);
+    EXPECT_EQ(2, accepted_);
+    ASSERT_EQ(1, received_.size());
+    EXPECT_EQ(qid, readUint16(&received_[0][0], received_[0].size()));
+
+    // The resent query is cancelled with the QID it was first sent with.
+    EXPECT_EQ(1, pool.getPendingCount());
+    pool.cancel(IOAddress(TEST_HOST), TEST_PORT, qid);
+    EXPECT_EQ(0, pool.getPendingCount());
+}
+
+// An idle connection is closed.
+TEST_F(TCPConnectionPoolTest, IdleTimeout) {
+    TCPConnectionPool pool(service_, 50);
+    expected_ = 1;
+    OutputBufferPtr response(new OutputBuffer(0));
+    pool.asyncQuery(IOAddress(TEST_HOST), TEST_PORT, makeQuery(0x10, 1),
+                    response, handler());
+    run();
+    EXPECT_EQ(1, completed_);
+    EXPECT_EQ(1, pool.getConnectionCount());
+
+    // Wait for the server to see the connection closed.
+    run();
+    EXPECT_TRUE(closed_);
+    EXPECT_EQ(0, pool.getConnectionCount());
+}
+
+// The pool is saturated once all the connections to a server have
+// max_pipelined outstanding queries.
+TEST_F(TCPConnectionPoolTest, Saturated) {
+    TCPConnectionPool pool(service_, 10000, 1, 2);
+    expected_ = 2;
+    OutputBufferPtr response1(new OutputBuffer(0));
+    OutputBufferPtr response2(new OutputBuffer(0));
+    EXPECT_FALSE(pool.isSaturated());
+    pool.asyncQuery(IOAddress(TEST_HOST), TEST_PORT, makeQuery(0x10, 1),
+                    response1, handler());
+    EXPECT_EQ(1, pool.getPendingCount());
+    EXPECT_FALSE(pool.isSaturated());
+    pool.asyncQuery(IOAddress(TEST_HOST), TEST_PORT, makeQuery(0x20, 2),
+                    response2, handler());
+    EXPECT_EQ(2, pool.getPendingCount());
+    EXPECT_TRUE(pool.isSaturated());
+    run();
+
+    EXPECT_EQ(2, completed_);
+    EXPECT_EQ(0, pool.getPendingCount());
+    EXPECT_FALSE(pool.isSaturated());
+}
+
+// A query too short to hold a QID is rejected.
+TEST_F(TCPConnectionPoolTest, ShortQuery) {
+    TCPConnectionPool pool(service_);
+    OutputBufferPtr query(new OutputBuffer(1));
+    query->writeUint8(0);
+    OutputBufferPtr response(new OutputBuffer(0));
+    EXPECT_THROW(pool.asyncQuery(IOAddress(TEST_HOST), TEST_PORT, query,
+                                 response, handler()), bundy::BadValue);
+    EXPECT_EQ(0, pool.getConnectionCount());
+}
+
+}
@@ -230,6 +230,11 @@ public:
     ///         network byte order
     operator uint32_t () const;
 
+    /// \brief Returns the hash value of the address
+    ///
+    /// Equal addresses have equal hash values.
+    size_t hash() const;
+
 private:
     asio::ip::address asio_address_;
 };
@@ -250,6 +255,18 @@ private:
 std::ostream&
 operator<<(std::ostream& os, const IOAddress& address);
 
+/// \brief Hash function for IOAddress, used by boost::hash.
+///
+/// It makes the \c IOAddress usable as a key of the hashed containers,
+/// e.g. the hashed indexes of boost::multi_index_container.
+///
+/// \param address The address to hash.
+/// \return The hash value of the address.
+inline size_t
+hash_value(const IOAddress& address) {
+    return (address.hash());
+}
+
 } // namespace asiolink
 } // namespace bundy
 #endif // IO_ADDRESS_H
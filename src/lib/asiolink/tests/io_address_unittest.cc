@@ -142,6 +142,20 @@ TEST(IOAddressTest, uint32) {
     EXPECT_EQ(addr3.toText(), "192.0.2.5");
 }
 
+TEST(IOAddressTest, hash) {
+    // Equal addresses have equal hash values.
+    EXPECT_EQ(IOAddress("192.0.2.5").hash(), IOAddress("192.0.2.5").hash());
+    EXPECT_EQ(IOAddress("2001:db8::1").hash(),
+              IOAddress("2001:db8::1").hash());
+    EXPECT_EQ(IOAddress("2001:db8::1").hash(),
+              hash_value(IOAddress("2001:db8::1")));
+
+    // Different addresses are very unlikely to collide.
+    EXPECT_NE(IOAddress("192.0.2.5").hash(), IOAddress("192.0.2.6").hash());
+    EXPECT_NE(IOAddress("2001:db8::1").hash(),
+              IOAddress("2001:db8::2").hash());
+}
+
 TEST(IOAddressTest, lessThanEqual) {
     IOAddress addr1("192.0.2.5");
     IOAddress addr2("192.0.2.6");
@@ -0,0 +1,368 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include "cache_memory.h"
+
+#include <algorithm>
+
+using namespace bundy::nsas;
+using bundy::util::locks::mutex;
+using bundy::util::locks::scoped_lock;
+
+namespace bundy {
+namespace cache {
+
+namespace {
+
+// Number of the rows of the sketch.
+const size_t SKETCH_DEPTH = 4;
+// The counters saturate at this value.
+const uint8_t MAX_COUNT = 15;
+// Assumed average size of an entry, to size the sketch.
+const size_t AVERAGE_ENTRY_SIZE = 256;
+const size_t MIN_SKETCH_WIDTH = 1024;
+const size_t MAX_SKETCH_WIDTH = 1 << 22;
+// The counts are halved after this many accesses per counter in a row,
+// so the old popularity fades away.
+const size_t SAMPLES_PER_COUNTER = 10;
+
+// FNV-1a of the key.
+uint32_t
+hashKey(const HashKey& key) {
+    uint32_t hash = 2166136261U;
+    for (uint32_t i = 0; i < key.keylen; ++i) {
+        hash = (hash ^ static_cast<uint8_t>(key.key[i])) * 16777619U;
+    }
+    const uint16_t code = key.class_code.getCode();
+    hash = (hash ^ (code & 0xff)) * 16777619U;
+    hash = (hash ^ (code >> 8)) * 16777619U;
+    return (hash);
+}
+
+// The shard is taken from the top bits of the hash, the sketch uses the
+// bottom ones.
+size_t
+shardOf(uint32_t hash) {
+    return ((hash >> 24) % CacheMemory::SHARDS);
+}
+
+// The shards are locked in the order of their index, by setLimit() only.
+template <typename Shard>
+void
+lockAll(Shard shards[]) {
+    for (size_t i = 0; i < CacheMemory::SHARDS; ++i) {
+        shards[i].mutex.lock();
+    }
+}
+
+template <typename Shard>
+void
+unlockAll(Shard shards[]) {
+    for (size_t i = CacheMemory::SHARDS; i > 0; --i) {
+        shards[i - 1].mutex.unlock();
+    }
+}
+
+// Sum of the (signed) counts of the shards, clamped at 0.
+template <typename Shard>
+size_t
+sumUsed(const Shard shards[]) {
+    int64_t used = 0;
+    for (size_t i = 0; i < CacheMemory::SHARDS; ++i) {
+        scoped_lock<mutex> lock(shards[i].mutex);
+        used += shards[i].used;
+    }
+    return (used > 0 ? static_cast<size_t>(used) : 0);
+}
+
+}
+
+const size_t CacheMemory::SHARDS;
+
+size_t
+CacheMemory::getShard(const HashKey& key) {
+    return (shardOf(hashKey(key)));
+}
+
+CacheMemory::CacheMemory(size_t limit) :
+    limit_(0), width_(0)
+{
+    setLimit(limit);
+}
+
+void
+CacheMemory::setLimit(size_t limit) {
+    size_t width = 0;
+    if (limit != 0) {
+        width = MIN_SKETCH_WIDTH;
+        while (width < limit / AVERAGE_ENTRY_SIZE &&
+               width < MAX_SKETCH_WIDTH) {
+            width *= 2;
+        }
+        width /= SHARDS;
+    }
+    lockAll(shards_);
+    limit_ = limit;
+    if (width != width_) {
+        width_ = width;
+        for (size_t i = 0; i < SHARDS; ++i) {
+            shards_[i].sketch.assign(SKETCH_DEPTH * width_, 0);
+            shards_[i].samples = 0;
+        }
+    }
+    unlockAll(shards_);
+}
+
+size_t
+CacheMemory::getLimit() const {
+    scoped_lock<mutex> lock(shards_[0].mutex);
+    return (limit_);
+}
+
+size_t
+CacheMemory::getUsed() const {
+    return (sumUsed(shards_));
+}
+
+uint64_t
+CacheMemory::getEvictions() const {
+    uint64_t evictions = 0;
+    for (size_t i = 0; i < SHARDS; ++i) {
+        scoped_lock<mutex> lock(shards_[i].mutex);
+        evictions += shards_[i].evictions;
+    }
+    return (evictions);
+}
+
+uint64_t
+CacheMemory::getRejections() const {
+    uint64_t rejections = 0;
+    for (size_t i = 0; i < SHARDS; ++i) {
+        scoped_lock<mutex> lock(shards_[i].mutex);
+        rejections += shards_[i].rejections;
+    }
+    return (rejections);
+}
+
+void
+CacheMemory::getCounters(const HashKey& key, size_t counters[]) const {
+    // Double hashing, the width is a power of two and the step is odd,
+    // so the counters in different rows are independent enough.
+    const uint32_t hash = hashKey(key);
+    const uint32_t step = (hash >> 16) | 1;
+    for (size_t row = 0; row < SKETCH_DEPTH; ++row) {
+        counters[row] = row * width_ + ((hash + row * step) & (width_ - 1));
+    }
+}
+
+void
+CacheMemory::recordAccess(const HashKey& key) {
+    Shard& shard = shards_[getShard(key)];
+    scoped_lock<mutex> lock(shard.mutex);
+    if (width_ == 0) {
+        return;
+    }
+    size_t counters[SKETCH_DEPTH];
+    getCounters(key, counters);
+    for (size_t row = 0; row < SKETCH_DEPTH; ++row) {
+        if (shard.sketch[counters[row]] < MAX_COUNT) {
+            ++shard.sketch[counters[row]];
+        }
+    }
+    if (++shard.samples >= SAMPLES_PER_COUNTER * width_) {
+        for (std::vector<uint8_t>::iterator it = shard.sketch.begin();
+             it != shard.sketch.end(); ++it) {
+            *it /= 2;
+        }
+        shard.samples /= 2;
+    }
+}
+
+uint32_t
+CacheMemory::getFrequency(const HashKey& key) const {
+    const Shard& shard = shards_[getShard(key)];
+    scoped_lock<mutex> lock(shard.mutex);
+    if (width_ == 0) {
+        return (0);
+    }
+    size_t counters[SKETCH_DEPTH];
+    getCounters(key, counters);
+    uint8_t frequency = MAX_COUNT;
+    for (size_t row = 0; row < SKETCH_DEPTH; ++row) {
+        frequency = std::min(frequency, shard.sketch[counters[row]]);
+    }
+    return (frequency);
+}
+
+bool
+CacheMemory::makeRoom(size_t size, const HashKey& key) {
+    Shard& shard = shards_[getShard(key)];
+    {
+        // Without a limit there's nothing to serialize.
+        scoped_lock<mutex> lock(shard.mutex);
+        if (limit_ == 0) {
+            return (true);
+        }
+    }
+    scoped_lock<mutex> eviction_lock(eviction_mutex_);
+    const size_t limit = getLimit();
+    if (limit == 0) {
+        return (true);
+    }
+    if (size > limit) {
+        scoped_lock<mutex> lock(shard.mutex);
+        ++shard.rejections;
+        return (false);
+    }
+    const uint32_t frequency = getFrequency(key);
+    while (getUsed() + size > limit) {
+        // Evict from the cache which takes the most memory.
+        CacheMemoryUser* victim = NULL;
+        size_t victim_used = 0;
+        for (std::list<CacheMemoryUser*>::const_iterator it = users_.begin();
+             it != users_.end(); ++it) {
+            const size_t used = (*it)->getMemoryUsed();
+            if (used > victim_used) {
+                victim = *it;
+                victim_used = used;
+            }
+        }
+        uint32_t victim_frequency;
+        if (victim == NULL || !victim->getOldestFrequency(victim_frequency)) {
+            // Nothing to evict (the memory is probably accounted to
+            // entries just being added), let it in.
+            break;
+        }
+        if (victim_frequency > frequency) {
+            scoped_lock<mutex> lock(shard.mutex);
+            ++shard.rejections;
+            return (false);
+        }
+        if (!victim->evictOldest()) {
+            break;
+        }
+        scoped_lock<mutex> lock(shard.mutex);
+        ++shard.evictions;
+    }
+    return (true);
+}
+
+void
+CacheMemory::charge(size_t size, const HashKey& key) {
+    Shard& shard = shards_[getShard(key)];
+    scoped_lock<mutex> lock(shard.mutex);
+    shard.used += size;
+}
+
+void
+CacheMemory::release(size_t size, const HashKey& key) {
+    Shard& shard = shards_[getShard(key)];
+    scoped_lock<mutex> lock(shard.mutex);
+    shard.used -= size;
+}
+
+void
+CacheMemory::charge(size_t size) {
+    scoped_lock<mutex> lock(shards_[0].mutex);
+    shards_[0].used += size;
+}
+
+void
+CacheMemory::release(size_t size) {
+    scoped_lock<mutex> lock(shards_[0].mutex);
+    shards_[0].used -= size;
+}
+
+void
+CacheMemory::addUser(CacheMemoryUser* user) {
+    scoped_lock<mutex> lock(eviction_mutex_);
+    users_.push_back(user);
+}
+
+void
+CacheMemory::removeUser(CacheMemoryUser* user) {
+    scoped_lock<mutex> lock(eviction_mutex_);
+    users_.remove(user);
+}
+
+CacheMemoryUser::CacheMemoryUser() {
+}
+
+CacheMemoryUser::~CacheMemoryUser() {
+    setMemory(CacheMemoryPtr());
+}
+
+void
+CacheMemoryUser::setMemory(const CacheMemoryPtr& memory) {
+    if (memory == memory_) {
+        return;
+    }
+    const CacheMemoryPtr old_memory(memory_);
+    memory_ = memory;
+    const size_t used = getMemoryUsed();
+    if (old_memory) {
+        old_memory->removeUser(this);
+        old_memory->release(used);
+    }
+    if (memory) {
+        memory->charge(used);
+        memory->addUser(this);
+    }
+}
+
+size_t
+CacheMemoryUser::getMemoryUsed() const {
+    return (sumUsed(used_));
+}
+
+void
+CacheMemoryUser::recordAccess(const HashKey& key) {
+    if (memory_) {
+        memory_->recordAccess(key);
+    }
+}
+
+bool
+CacheMemoryUser::admit(size_t size, const HashKey& key) {
+    return (!memory_ || memory_->makeRoom(size, key));
+}
+
+void
+CacheMemoryUser::chargeMemory(size_t size, const HashKey& key) {
+    UsedShard& shard = used_[CacheMemory::getShard(key)];
+    {
+        scoped_lock<mutex> lock(shard.mutex);
+        shard.used += size;
+    }
+    if (memory_) {
+        memory_->charge(size, key);
+    }
+}
+
+void
+CacheMemoryUser::releaseMemory(size_t size, const HashKey& key) {
+    UsedShard& shard = used_[CacheMemory::getShard(key)];
+    {
+        scoped_lock<mutex> lock(shard.mutex);
+        shard.used -= size;
+    }
+    if (memory_) {
+        memory_->release(size, key);
+    }
+}
+
+} // namespace cache
+} // namespace bundy
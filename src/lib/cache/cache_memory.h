@@ -0,0 +1,278 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef CACHE_MEMORY_H
+#define CACHE_MEMORY_H
+
+#include <nsas/hash_key.h>
+#include <nsas/hash_table.h>
+#include <util/locks.h>
+#include <util/lru_list.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <list>
+#include <vector>
+
+#include <stdint.h>
+
+namespace bundy {
+namespace cache {
+
+class CacheMemoryUser;
+template <typename T> class CacheEntryDeleter;
+
+/// \brief Memory budget shared by several caches
+///
+/// The caches (\c CacheMemoryUser) account the (approximate) size of
+/// their entries in bytes here.  When a new entry doesn't fit into the
+/// limit, the oldest entries of the cache taking the most memory are
+/// evicted to make room for it.
+///
+/// The new entry is not admitted if the entry to be evicted for it is
+/// used more often, so a burst of the queries for names which are never
+/// asked again doesn't flush the popular ones (this is the TinyLFU
+/// admission policy).  The frequency of the use is estimated by a
+/// count-min sketch of the accesses to the caches, which is aged by
+/// halving all the counts periodically.  Unlike in TinyLFU, the ties are
+/// won by the new entry, so with a uniform popularity the caches behave
+/// just like LRU ones.
+///
+/// The sketch and the counters are split into \c SHARDS shards by the
+/// hash of the key, each with its own lock, so the threads using
+/// different entries rarely wait for each other.  Without a limit, only
+/// the memory is accounted and no global lock is taken at all.
+///
+/// All the methods are thread safe.
+class CacheMemory : boost::noncopyable {
+public:
+    /// \brief Number of the shards of the sketch and the counters.
+    static const size_t SHARDS = 16;
+
+    /// \brief Return the shard of the key.
+    static size_t getShard(const bundy::nsas::HashKey& key);
+
+    /// \brief Constructor
+    ///
+    /// \param limit The memory limit in bytes, 0 means no limit.
+    explicit CacheMemory(size_t limit = 0);
+
+    /// \brief Set the memory limit.
+    ///
+    /// If the caches already take more memory, the limit is enforced
+    /// when the next entry is added.
+    ///
+    /// \param limit The memory limit in bytes, 0 means no limit.
+    void setLimit(size_t limit);
+
+    /// \brief Return the memory limit in bytes (0 means no limit).
+    size_t getLimit() const;
+
+    /// \brief Return the memory taken by the entries of all the caches.
+    size_t getUsed() const;
+
+    /// \brief Return the number of entries evicted because of the limit.
+    uint64_t getEvictions() const;
+
+    /// \brief Return the number of entries not admitted to the caches.
+    uint64_t getRejections() const;
+
+    /// \brief Count a use of the entry, whether it is in a cache or not.
+    ///
+    /// Does nothing when there's no limit.
+    void recordAccess(const bundy::nsas::HashKey& key);
+
+    /// \brief Return the estimated number of uses of the entry.
+    uint32_t getFrequency(const bundy::nsas::HashKey& key) const;
+
+    /// \brief Make room for a new entry.
+    ///
+    /// Evicts the oldest entries of the caches until the new entry fits
+    /// into the limit, unless they are used more often than the new entry.
+    ///
+    /// \param size Size of the new entry in bytes.
+    /// \param key Key of the new entry.
+    /// \return true if the entry is to be added, false if it is not
+    ///     admitted.
+    bool makeRoom(size_t size, const bundy::nsas::HashKey& key);
+
+    /// \brief Account memory taken by a new entry.
+    void charge(size_t size, const bundy::nsas::HashKey& key);
+
+    /// \brief Account memory freed by a removed entry.
+    void release(size_t size, const bundy::nsas::HashKey& key);
+
+    /// \brief Account memory taken by a whole cache joining the budget.
+    void charge(size_t size);
+
+    /// \brief Account memory freed by a whole cache leaving the budget.
+    void release(size_t size);
+
+    /// \brief Register a cache to evict the entries from.
+    ///
+    /// Called by \c CacheMemoryUser::setMemory().
+    void addUser(CacheMemoryUser* user);
+
+    /// \brief Unregister a cache.
+    ///
+    /// Called by \c CacheMemoryUser::setMemory().
+    void removeUser(CacheMemoryUser* user);
+
+private:
+    // The counters and the part of the sketch of the keys of one shard.
+    struct Shard {
+        Shard() : used(0), evictions(0), rejections(0), samples(0) {}
+
+        // Signed, as a whole cache may be released from another shard
+        // than the one it was charged to.
+        int64_t used;
+        uint64_t evictions;
+        uint64_t rejections;
+        // The count-min sketch, SKETCH_DEPTH rows of width_ counters.
+        std::vector<uint8_t> sketch;
+        // Accesses since the counts were halved the last time.
+        size_t samples;
+        // Protects the above.  Never held while calling the users.
+        mutable bundy::util::locks::mutex mutex;
+    };
+
+    // Positions of the counters of the key in the sketch of its shard.
+    void getCounters(const bundy::nsas::HashKey& key,
+                     size_t counters[]) const;
+
+    Shard shards_[SHARDS];
+    // The limit and the width of the sketch of each shard are changed
+    // with the locks of all the shards held, so holding any one of them
+    // is enough to read them.
+    size_t limit_;
+    size_t width_;
+    std::list<CacheMemoryUser*> users_;
+    // Serializes the evictions and protects users_.  Only taken when
+    // there's a limit (and when the users come and go).
+    bundy::util::locks::mutex eviction_mutex_;
+};
+
+typedef boost::shared_ptr<CacheMemory> CacheMemoryPtr;
+
+/// \brief Cache with entries accounted in a \c CacheMemory
+///
+/// The derived cache calls \c chargeMemory() and \c releaseMemory() as
+/// the entries are added and removed, and evicts its oldest entry when
+/// asked to.  As long as no \c CacheMemory is set, only the memory used
+/// by the cache itself is counted.
+class CacheMemoryUser : boost::noncopyable {
+public:
+    /// \brief Constructor
+    CacheMemoryUser();
+
+    /// \brief Destructor
+    ///
+    /// The derived class must call \c setMemory() with an empty pointer in
+    /// its destructor, so it's not asked to evict anything while being
+    /// destroyed.
+    virtual ~CacheMemoryUser();
+
+    /// \brief Set the memory budget the cache shares with other caches.
+    ///
+    /// The memory taken by the cache is moved from the old budget (if any)
+    /// to the new one.  The budget is read without a lock by the other
+    /// methods, so it may only be set while no other thread uses the
+    /// cache, when it's being set up or destroyed.
+    ///
+    /// \param memory The budget, or an empty pointer for none.
+    void setMemory(const CacheMemoryPtr& memory);
+
+    /// \brief Return the memory budget (may be empty).
+    const CacheMemoryPtr& getMemory() const {
+        return (memory_);
+    }
+
+    /// \brief Return the memory taken by the entries of this cache.
+    size_t getMemoryUsed() const;
+
+    /// \brief Return the estimated use count of the oldest entry.
+    ///
+    /// \param frequency Set to the count.
+    /// \return false if the cache is empty.
+    virtual bool getOldestFrequency(uint32_t& frequency) = 0;
+
+    /// \brief Remove the oldest entry.
+    ///
+    /// \return false if the cache is empty.
+    virtual bool evictOldest() = 0;
+
+protected:
+    /// \brief Count a use of an entry in the memory budget (if any).
+    void recordAccess(const bundy::nsas::HashKey& key);
+
+    /// \brief Ask the memory budget (if any) to make room for an entry.
+    ///
+    /// \return false if the entry is not to be added.
+    bool admit(size_t size, const bundy::nsas::HashKey& key);
+
+    /// \brief Account memory taken by a new entry.
+    void chargeMemory(size_t size, const bundy::nsas::HashKey& key);
+
+    /// \brief Account memory freed by a removed entry.
+    void releaseMemory(size_t size, const bundy::nsas::HashKey& key);
+
+private:
+    template <typename T> friend class CacheEntryDeleter;
+
+    // Memory taken by the entries of the keys of one shard.
+    struct UsedShard {
+        UsedShard() : used(0) {}
+
+        int64_t used;
+        mutable bundy::util::locks::mutex mutex;
+    };
+
+    CacheMemoryPtr memory_;
+    UsedShard used_[CacheMemory::SHARDS];
+};
+
+/// \brief Drop handler of the LRU lists of the caches
+///
+/// Like \c bundy::nsas::HashDeleter, it removes the dropped entry from the
+/// hash table, and it releases the memory taken by it.  The entries need
+/// the \c getSize() method.
+template <typename T>
+class CacheEntryDeleter : public bundy::util::LruList<T>::Dropped {
+public:
+    /// \brief Constructor
+    ///
+    /// \param table The hash table to remove the entries from.
+    /// \param user The cache the entries belong to.
+    CacheEntryDeleter(bundy::nsas::HashTable<T>& table,
+                      CacheMemoryUser& user) :
+        table_(table), user_(user)
+    {}
+
+    /// \brief Remove the entry from the hash table.
+    virtual void operator()(T* element) const {
+        if (table_.remove(element->hashKey())) {
+            user_.releaseMemory(element->getSize(), element->hashKey());
+        }
+    }
+
+private:
+    bundy::nsas::HashTable<T>& table_;
+    CacheMemoryUser& user_;
+};
+
+} // namespace cache
+} // namespace bundy
+
+#endif // CACHE_MEMORY_H
@@ -26,12 +26,14 @@ namespace cache {
 
 typedef pair<std::string, RRsetPtr> RRsetMapPair;
 typedef map<std::string, RRsetPtr>::iterator RRsetMapIterator;
+typedef bundy::util::locks::upgradable_mutex Mutex;
 
 bundy::dns::RRsetPtr
 LocalZoneData::lookup(const bundy::dns::Name& name,
                       const bundy::dns::RRType& type)
 {
     string key = genCacheEntryName(name, type);
+    bundy::util::locks::sharable_lock<Mutex> lock(mutex_);
     RRsetMapIterator iter = rrsets_map_.find(key);
     if (iter == rrsets_map_.end()) {
         LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_LOCALZONE_UNKNOWN).arg(key);
@@ -52,6 +54,7 @@ LocalZoneData::update(const bundy::dns::AbstractRRset& rrset) {
 
     rrsetCopy(rrset, *rrset_copy);
     RRsetPtr rrset_ptr(rrset_copy);
+    bundy::util::locks::scoped_lock<Mutex> lock(mutex_);
     rrsets_map_[key] = rrset_ptr;
 }
 
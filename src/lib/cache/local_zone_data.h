@@ -19,6 +19,7 @@
 #include <string>
 #include <boost/shared_ptr.hpp>
 #include <dns/rrset.h>
+#include <util/locks.h>
 
 namespace bundy {
 namespace cache {
@@ -55,6 +56,7 @@ public:
 
 private:
     std::map<std::string, bundy::dns::RRsetPtr> rrsets_map_; // RRsets of the zone
+    bundy::util::locks::upgradable_mutex mutex_; // Protects rrsets_map_
 };
 
 typedef boost::shared_ptr<LocalZoneData> LocalZoneDataPtr;
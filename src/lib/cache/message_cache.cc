@@ -17,7 +17,6 @@
 
 #include <nsas/nsas_entry_compare.h>
 #include <nsas/hash_table.h>
-#include <nsas/hash_deleter.h>
 #include "message_cache.h"
 #include "message_utility.h"
 #include "cache_entry_key.h"
@@ -35,17 +34,20 @@ MessageCache::MessageCache(const RRsetCachePtr& rrset_cache,
                            uint32_t cache_size, uint16_t message_class,
                            const RRsetCachePtr& negative_soa_cache):
     message_class_(message_class),
+    max_stale_ttl_(0),
     rrset_cache_(rrset_cache),
     negative_soa_cache_(negative_soa_cache),
     message_table_(new NsasEntryCompare<MessageEntry>, cache_size),
     message_lru_((3 * cache_size),
-                  new HashDeleter<MessageEntry>(message_table_))
+                  new CacheEntryDeleter<MessageEntry>(message_table_, *this))
 {
     LOG_DEBUG(logger, DBG_TRACE_BASIC, CACHE_MESSAGES_INIT).arg(cache_size).
         arg(RRClass(message_class));
 }
 
 MessageCache::~MessageCache() {
+    // Don't get asked to evict anything from now on.
+    setMemory(CacheMemoryPtr());
     // Destroy all the message entries in the cache.
     message_lru_.clear();
     LOG_DEBUG(logger, DBG_TRACE_BASIC, CACHE_MESSAGES_DEINIT);
@@ -58,28 +60,54 @@ MessageCache::lookup(const bundy::dns::Name& qname,
 {
     std::string entry_name = genCacheEntryName(qname, qtype);
     HashKey entry_key = HashKey(entry_name, RRClass(message_class_));
+    recordAccess(entry_key);
     MessageEntryPtr msg_entry = message_table_.get(entry_key);
     if(msg_entry) {
         // Check whether the message entry has expired.
-       if (msg_entry->getExpireTime() > time(NULL)) {
+        const time_t now = time(NULL);
+        if (msg_entry->getExpireTime() > now) {
             LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_MESSAGES_FOUND).
                 arg(entry_name);
             message_lru_.touch(msg_entry);
-            return (msg_entry->genMessage(time(NULL), response));
+            return (msg_entry->genMessage(now, response));
+        } else if (msg_entry->getExpireTime() + max_stale_ttl_ > now) {
+            // Keep it for stale answers, but pretend nothing was found.
+            LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_MESSAGES_STALE).
+                arg(entry_name);
+            return (false);
         } else {
             // message entry expires, remove it from hash table and lru list.
             LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_MESSAGES_EXPIRED).
                 arg(entry_name);
-            message_table_.remove(entry_key);
+            if (message_table_.remove(entry_key)) {
+                releaseMemory(msg_entry->getSize(), entry_key);
+            }
             message_lru_.remove(msg_entry);
             return (false);
-       }
+        }
     }
 
     LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_MESSAGES_UNKNOWN).arg(entry_name);
     return (false);
 }
 
+bool
+MessageCache::lookupStale(const bundy::dns::Name& qname,
+                          const bundy::dns::RRType& qtype,
+                          bundy::dns::Message& response)
+{
+    std::string entry_name = genCacheEntryName(qname, qtype);
+    HashKey entry_key = HashKey(entry_name, RRClass(message_class_));
+    MessageEntryPtr msg_entry = message_table_.get(entry_key);
+    const time_t now = time(NULL);
+    if (msg_entry && msg_entry->getExpireTime() + max_stale_ttl_ > now) {
+        LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_MESSAGES_STALE_FOUND).
+            arg(entry_name);
+        return (msg_entry->genStaleMessage(now, response));
+    }
+    return (false);
+}
+
 bool
 MessageCache::update(const Message& msg) {
     if (!canMessageBeCached(msg)){
@@ -109,14 +137,39 @@ MessageCache::update(const Message& msg) {
             arg((*iter)->getName()).arg((*iter)->getType()).
             arg((*iter)->getClass());
         message_lru_.remove(old_msg_entry);
+        if (message_table_.remove(entry_key)) {
+            releaseMemory(old_msg_entry->getSize(), entry_key);
+        }
     }
 
     MessageEntryPtr msg_entry(new MessageEntry(msg, rrset_cache_,
                                                negative_soa_cache_));
+    if (!admit(msg_entry->getSize(), entry_key)) {
+        LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_MESSAGES_NOT_ADMITTED).
+            arg((*iter)->getName()).arg((*iter)->getType()).
+            arg((*iter)->getClass());
+        return (false);
+    }
     message_lru_.add(msg_entry);
+    chargeMemory(msg_entry->getSize(), entry_key);
     return (message_table_.add(msg_entry, entry_key, true));
 }
 
+bool
+MessageCache::getOldestFrequency(uint32_t& frequency) {
+    const MessageEntryPtr oldest = message_lru_.getOldest();
+    if (!oldest || !getMemory()) {
+        return (false);
+    }
+    frequency = getMemory()->getFrequency(oldest->hashKey());
+    return (true);
+}
+
+bool
+MessageCache::evictOldest() {
+    return (message_lru_.dropOldest());
+}
+
 } // namespace cache
 } // namespace bundy
 
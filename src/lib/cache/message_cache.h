@@ -30,9 +30,13 @@ namespace cache {
 /// The object of MessageCache represents the cache for class-specific
 /// messages.
 ///
+/// The memory taken by the entries is accounted in the \c CacheMemory
+/// set by \c setMemory(), if any, and the entries may be evicted or not
+/// admitted to keep it within its limit.
+///
 /// \todo The message cache class should provide the interfaces for
 ///       loading, dumping and resizing.
-class MessageCache {
+class MessageCache : public CacheMemoryUser {
 // Noncopyable
 private:
     MessageCache(const MessageCache& source);
@@ -64,10 +68,49 @@ public:
                 const bundy::dns::RRType& qtype,
                 bundy::dns::Message& message);
 
+    /// \brief Look up message in cache, including the stale ones.
+    ///
+    /// Like \c lookup(), but a message which expired less than the
+    /// maximum stale TTL ago is used too.  The expired rrsets in the
+    /// generated message have the TTL of \c STALE_ANSWER_TTL.
+    ///
+    /// \param qname Name of the domain for which the message is being sought.
+    /// \param qtype Type of the RR for which the message is being sought.
+    /// \param message generated response message if the message entry
+    ///        can be found.
+    ///
+    /// \return return true if the message can be found in cache, or else,
+    /// return false.
+    bool lookupStale(const bundy::dns::Name& qname,
+                     const bundy::dns::RRType& qtype,
+                     bundy::dns::Message& message);
+
     /// \brief Update the message in the cache with the new one.
     /// If the message doesn't exist in the cache, it will be added
     /// directly.
+    ///
+    /// \return false if the message can't be cached or is not admitted
+    /// because of the memory limit.
     bool update(const bundy::dns::Message& msg);
+
+    /// \name Memory Budget Interfaces
+    ///
+    /// See \c CacheMemoryUser.
+    //@{
+    virtual bool getOldestFrequency(uint32_t& frequency);
+    virtual bool evictOldest();
+    //@}
+
+    /// \brief Set how long the expired entries are kept.
+    ///
+    /// The expired message entries are kept in the cache for this many
+    /// seconds, so they can be used for stale answers (RFC 8767).  0, the
+    /// default, means the entries are removed as soon as they expire.
+    ///
+    /// \param max_stale_ttl The time in seconds.
+    void setMaxStaleTTL(uint32_t max_stale_ttl) {
+        max_stale_ttl_ = max_stale_ttl;
+    }
 protected:
     /// \brief Get the hash key for the message entry in the cache.
     /// \param name query name of the message.
@@ -79,6 +122,7 @@ protected:
     // Make these variants be protected for easy unittest.
 protected:
     uint16_t message_class_; // The class of the message cache.
+    uint32_t max_stale_ttl_; // How long the expired messages are kept.
     RRsetCachePtr rrset_cache_;
     RRsetCachePtr negative_soa_cache_;
     bundy::nsas::HashTable<MessageEntry> message_table_;
@@ -86,19 +86,28 @@ MessageEntry::MessageEntry(const bundy::dns::Message& msg,
     initMessageEntry(msg);
     entry_name_ = genCacheEntryName(query_name_, query_type_);
     hash_key_ptr_ = new HashKey(entry_name_, RRClass(query_class_));
+
+    size_ = sizeof(*this) + sizeof(HashKey) + entry_name_.size() +
+        query_name_.size() + rrsets_.capacity() * sizeof(RRsetRef);
+    for (std::vector<RRsetRef>::const_iterator it = rrsets_.begin();
+         it != rrsets_.end(); ++it) {
+        size_ += it->name_.getLength() + it->name_.getLabelCount();
+    }
 }
 
 bool
 MessageEntry::getRRsetEntries(vector<RRsetEntryPtr>& rrset_entry_vec,
-                              const time_t time_now)
+                              const time_t time_now, bool stale)
 {
     uint16_t entry_count = answer_count_ + authority_count_ + additional_count_;
     rrset_entry_vec.reserve(rrset_entry_vec.size() + entry_count);
     for (int index = 0; index < entry_count; ++index) {
         RRsetCache* rrset_cache = rrsets_[index].cache_;
-        RRsetEntryPtr rrset_entry = rrset_cache->lookup(rrsets_[index].name_,
-                                                        rrsets_[index].type_);
-        if (rrset_entry && time_now < rrset_entry->getExpireTime()) {
+        RRsetEntryPtr rrset_entry = stale ?
+            rrset_cache->lookupStale(rrsets_[index].name_,
+                                     rrsets_[index].type_) :
+            rrset_cache->lookup(rrsets_[index].name_, rrsets_[index].type_);
+        if (rrset_entry && (stale || time_now < rrset_entry->getExpireTime())) {
             rrset_entry_vec.push_back(rrset_entry);
         } else {
             return (false);
@@ -111,7 +120,8 @@ MessageEntry::getRRsetEntries(vector<RRsetEntryPtr>& rrset_entry_vec,
 void
 MessageEntry::addRRset(bundy::dns::Message& message,
                        const vector<RRsetEntryPtr>& rrset_entry_vec,
-                       const bundy::dns::Message::Section& section)
+                       const bundy::dns::Message::Section& section,
+                       bool stale)
 {
     uint16_t start_index = 0;
     uint16_t end_index = answer_count_;
@@ -126,7 +136,9 @@ MessageEntry::addRRset(bundy::dns::Message& message,
     }
 
     for (uint16_t index = start_index; index < end_index; ++index) {
-        message.addRRset(section, rrset_entry_vec[index]->getRRset());
+        message.addRRset(section, stale ?
+                         rrset_entry_vec[index]->getStaleRRset() :
+                         rrset_entry_vec[index]->getRRset());
     }
 }
 
@@ -163,6 +175,27 @@ MessageEntry::genMessage(const time_t& time_now,
     }
 }
 
+bool
+MessageEntry::genStaleMessage(const time_t& time_now,
+                              bundy::dns::Message& msg)
+{
+    vector<RRsetEntryPtr> rrset_entry_vec;
+    if (!getRRsetEntries(rrset_entry_vec, time_now, true)) {
+        LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_ENTRY_MISSING_RRSET).
+            arg(entry_name_);
+        return (false);
+    }
+
+    msg.setHeaderFlag(Message::HEADERFLAG_AA, false);
+    msg.setHeaderFlag(Message::HEADERFLAG_TC, headerflag_tc_);
+
+    addRRset(msg, rrset_entry_vec, Message::SECTION_ANSWER, true);
+    addRRset(msg, rrset_entry_vec, Message::SECTION_AUTHORITY, true);
+    addRRset(msg, rrset_entry_vec, Message::SECTION_ADDITIONAL, true);
+
+    return (true);
+}
+
 RRsetTrustLevel
 MessageEntry::getRRsetTrustLevel(const Message& message,
     const bundy::dns::RRsetPtr& rrset,
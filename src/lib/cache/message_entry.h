@@ -87,6 +87,20 @@ public:
     ///         from the cached information, or else, return false.
     bool genMessage(const time_t& time_now, bundy::dns::Message& response);
 
+    /// \brief generate one dns message from the entry, even if it
+    ///        has expired.
+    ///
+    /// The expired rrsets are used as long as they are kept in the rrset
+    /// cache, with the TTL of \c STALE_ANSWER_TTL.  The expiration of the
+    /// message entry itself is not checked, that is up to the caller.
+    ///
+    /// \param time_now the time of now.
+    /// \param response generated dns message.
+    /// \return return true if the response message can be generated
+    ///         from the cached information, or else, return false.
+    bool genStaleMessage(const time_t& time_now,
+                         bundy::dns::Message& response);
+
     /// \brief Get the hash key of the message entry.
     ///
     /// \return return hash key
@@ -100,6 +114,15 @@ public:
         return (expire_time_);
     }
 
+    /// \brief Get the approximate memory taken by the entry.
+    ///
+    /// The RRsets are not included, they are accounted in the rrset cache.
+    ///
+    /// \return The size in bytes.
+    size_t getSize() const {
+        return (size_);
+    }
+
     /// \short Protected memebers, so they can be accessed by tests.
     //@{
 protected:
@@ -152,19 +175,23 @@ protected:
     /// \param rrset_entry_vec vector for rrset entries in
     ///        different sections.
     /// \param section The section to add to
+    /// \param stale Whether to add the rrsets for a stale answer.
     void addRRset(bundy::dns::Message& message,
                   const std::vector<RRsetEntryPtr>& rrset_entry_vec,
-                  const bundy::dns::Message::Section& section);
+                  const bundy::dns::Message::Section& section,
+                  bool stale = false);
 
     /// \brief Get the all the rrset entries for the message entry.
     ///
     /// \param rrset_entry_vec vector to add unexpired rrset entries to
     /// \param time_now the time of now. Used to compare with rrset
     ///        entry's expire time.
-    /// \return return false if any rrset entry has expired, true
-    ///         otherwise.
+    /// \param stale Whether the expired rrset entries still kept in
+    ///        the rrset cache can be used.
+    /// \return return false if any rrset entry has expired (or is not
+    ///         in the cache any more), true otherwise.
     bool getRRsetEntries(std::vector<RRsetEntryPtr>& rrset_entry_vec,
-                         const time_t time_now);
+                         const time_t time_now, bool stale = false);
 
     time_t expire_time_;  // Expiration time of the message.
     //@}
@@ -190,6 +217,8 @@ private:
     //TODO, there should be a better way to cache these header flags
     bool headerflag_aa_; // Whether AA bit is set.
     bool headerflag_tc_; // Whether TC bit is set.
+
+    size_t size_; // Approximate memory taken by the entry.
 };
 
 typedef boost::shared_ptr<MessageEntry> MessageEntryPtr;
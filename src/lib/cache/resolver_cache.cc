@@ -120,6 +120,39 @@ ResolverClassCache::lookup(const bundy::dns::Name& qname,
     }
 }
 
+bool
+ResolverClassCache::lookupStale(const bundy::dns::Name& qname,
+                                const bundy::dns::RRType& qtype,
+                                bundy::dns::Message& response) const
+{
+    LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_RESOLVER_STALE).
+        arg(qname).arg(qtype);
+    if (messages_cache_->lookupStale(qname, qtype, response)) {
+        return (true);
+    }
+    RRsetEntryPtr rrset_entry = rrsets_cache_->lookupStale(qname, qtype);
+    if (rrset_entry) {
+        response.addRRset(Message::SECTION_ANSWER,
+                          rrset_entry->getStaleRRset());
+        return (true);
+    }
+    return (false);
+}
+
+void
+ResolverClassCache::setMaxStaleTTL(uint32_t max_stale_ttl) {
+    messages_cache_->setMaxStaleTTL(max_stale_ttl);
+    rrsets_cache_->setMaxStaleTTL(max_stale_ttl);
+    negative_soa_cache_->setMaxStaleTTL(max_stale_ttl);
+}
+
+void
+ResolverClassCache::setMemory(const CacheMemoryPtr& memory) {
+    messages_cache_->setMemory(memory);
+    rrsets_cache_->setMemory(memory);
+    negative_soa_cache_->setMemory(memory);
+}
+
 bool
 ResolverClassCache::update(const bundy::dns::Message& msg) {
     LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_RESOLVER_UPDATE_MSG).
@@ -157,16 +190,22 @@ ResolverClassCache::update(const bundy::dns::ConstRRsetPtr& rrset_ptr) {
 }
 
 
-ResolverCache::ResolverCache()
+ResolverCache::ResolverCache() :
+    max_stale_ttl_(0),
+    memory_(new CacheMemory())
 {
     class_caches_.push_back(new ResolverClassCache(RRClass::IN()));
+    class_caches_.back()->setMemory(memory_);
 }
 
-ResolverCache::ResolverCache(std::vector<CacheSizeInfo> caches_info)
+ResolverCache::ResolverCache(std::vector<CacheSizeInfo> caches_info) :
+    max_stale_ttl_(0),
+    memory_(new CacheMemory())
 {
     for (std::vector<CacheSizeInfo>::size_type i = 0;
          i < caches_info.size(); ++i) {
         class_caches_.push_back(new ResolverClassCache(caches_info[i]));
+        class_caches_.back()->setMemory(memory_);
     }
 }
 
@@ -234,6 +273,40 @@ ResolverCache::lookupDeepestNS(const bundy::dns::Name& qname,
     return (RRsetPtr());
 }
 
+bool
+ResolverCache::lookupStale(const bundy::dns::Name& qname,
+                           const bundy::dns::RRType& qtype,
+                           const bundy::dns::RRClass& qclass,
+                           bundy::dns::Message& response) const
+{
+    if (max_stale_ttl_ == 0) {
+        return (false);
+    }
+    ResolverClassCache* cc = getClassCache(qclass);
+    if (cc) {
+        return (cc->lookupStale(qname, qtype, response));
+    } else {
+        LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_RESOLVER_UNKNOWN_CLASS_MSG).
+            arg(qclass);
+        return (false);
+    }
+}
+
+void
+ResolverCache::setMaxStaleTTL(uint32_t max_stale_ttl) {
+    max_stale_ttl_ = max_stale_ttl;
+    for (std::vector<ResolverClassCache*>::size_type i = 0;
+         i < class_caches_.size(); ++i) {
+        class_caches_[i]->setMaxStaleTTL(max_stale_ttl);
+    }
+}
+
+void
+ResolverCache::setMemoryLimit(size_t limit) {
+    LOG_DEBUG(logger, DBG_TRACE_BASIC, CACHE_RESOLVER_MEMORY_LIMIT).arg(limit);
+    memory_->setLimit(limit);
+}
+
 bool
 ResolverCache::update(const bundy::dns::Message& msg) {
     QuestionIterator iter = msg.beginQuestion();
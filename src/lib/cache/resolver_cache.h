@@ -126,6 +126,24 @@ public:
     bundy::dns::RRsetPtr lookup(const bundy::dns::Name& qname,
                               const bundy::dns::RRType& qtype) const;
 
+    /// \brief Look up data for a stale answer in cache.
+    ///
+    /// See \c ResolverCache::lookupStale().
+    bool lookupStale(const bundy::dns::Name& qname,
+                     const bundy::dns::RRType& qtype,
+                     bundy::dns::Message& response) const;
+    //@}
+
+    /// \brief Set how long the expired data is kept.
+    ///
+    /// See \c ResolverCache::setMaxStaleTTL().
+    void setMaxStaleTTL(uint32_t max_stale_ttl);
+
+    /// \brief Set the memory budget of the caches.
+    ///
+    /// See \c ResolverCache::setMemoryLimit().
+    void setMemory(const CacheMemoryPtr& memory);
+
     /// \brief Update the message in the cache with the new one.
     ///
     /// \param msg The message to update
@@ -275,8 +293,66 @@ public:
     /// is used frequently? Exact or closest enclosing ns looking up.
     bundy::dns::RRsetPtr lookupDeepestNS(const bundy::dns::Name& qname,
                               const bundy::dns::RRClass& qclass) const;
+
+    /// \brief Look up data for a stale answer in cache.
+    ///
+    /// Used when the data can't be fetched from the authoritative
+    /// servers in time (RFC 8767).  Like the message \c lookup(), but the
+    /// data which expired less than the maximum stale TTL ago is used as
+    /// well, with the TTL of \c STALE_ANSWER_TTL.  If there's no message
+    /// for the query, a single RRset is looked up and put into the answer
+    /// section.
+    ///
+    /// \param qname The query name to look up
+    /// \param qtype The query type to look up
+    /// \param qclass The query class to look up
+    /// \param response the query message (must be in RENDER mode)
+    ///        which has question section already.
+    /// \return return true if the data can be found, or else,
+    ///         return false.  It is always false when serving stale data
+    ///         is disabled.
+    bool lookupStale(const bundy::dns::Name& qname,
+                     const bundy::dns::RRType& qtype,
+                     const bundy::dns::RRClass& qclass,
+                     bundy::dns::Message& response) const;
     //@}
 
+    /// \brief Set how long the expired data is kept.
+    ///
+    /// The expired data is kept in the cache for this many seconds after
+    /// it expires, so it can be used by \c lookupStale().  0, the default,
+    /// disables serving stale data.
+    ///
+    /// \param max_stale_ttl The time in seconds.
+    void setMaxStaleTTL(uint32_t max_stale_ttl);
+
+    /// \brief Return how long the expired data is kept.
+    uint32_t getMaxStaleTTL() const {
+        return (max_stale_ttl_);
+    }
+
+    /// \brief Set the memory limit of the cache.
+    ///
+    /// The limit applies to all the message and RRset caches of all the
+    /// classes together.  The size of the cached data is accounted in
+    /// bytes (approximately, the overhead of the memory allocator is not
+    /// known).  When the limit is reached, the least recently used data is
+    /// evicted as new data is added, unless it is used more often than the
+    /// new data, in which case the new data is not cached.
+    ///
+    /// The limits on the number of the entries given in the constructor
+    /// still apply.
+    ///
+    /// \param limit The limit in bytes, 0 (the default) means no limit.
+    void setMemoryLimit(size_t limit);
+
+    /// \brief Return the memory budget of the cache.
+    ///
+    /// It provides the memory usage and the eviction statistics.
+    const CacheMemory& getMemory() const {
+        return (*memory_);
+    }
+
     /// \brief Update the message in the cache with the new one.
     ///
     /// \param msg The message to update
@@ -314,6 +390,12 @@ private:
     /// TODO: I think we can optimize for IN, and always have that
     /// one directly available, use the vector for the rest?
     std::vector<ResolverClassCache*> class_caches_;
+
+    /// How long the expired data is kept (seconds).
+    uint32_t max_stale_ttl_;
+
+    /// Memory budget shared by all the class caches.
+    CacheMemoryPtr memory_;
 };
 
 } // namespace cache
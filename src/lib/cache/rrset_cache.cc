@@ -19,7 +19,6 @@
 #include <string>
 #include <nsas/nsas_entry_compare.h>
 #include <nsas/hash_table.h>
-#include <nsas/hash_deleter.h>
 
 using namespace bundy::nsas;
 using namespace bundy::dns;
@@ -31,14 +30,21 @@ namespace cache {
 RRsetCache::RRsetCache(uint32_t cache_size,
                        uint16_t rrset_class):
     class_(rrset_class),
+    max_stale_ttl_(0),
     rrset_table_(new NsasEntryCompare<RRsetEntry>, cache_size),
     rrset_lru_((3 * cache_size),
-                  new HashDeleter<RRsetEntry>(rrset_table_))
+                  new CacheEntryDeleter<RRsetEntry>(rrset_table_, *this))
 {
     LOG_DEBUG(logger, DBG_TRACE_BASIC, CACHE_RRSET_INIT).arg(cache_size).
         arg(RRClass(rrset_class));
 }
 
+RRsetCache::~RRsetCache() {
+    // Don't get asked to evict anything from now on.
+    setMemory(CacheMemoryPtr());
+    rrset_lru_.clear(); // Clear the rrset entries in the list.
+}
+
 RRsetEntryPtr
 RRsetCache::lookup(const bundy::dns::Name& qname,
                    const bundy::dns::RRType& qtype)
@@ -46,20 +52,28 @@ RRsetCache::lookup(const bundy::dns::Name& qname,
     LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_RRSET_LOOKUP).arg(qname).
         arg(qtype).arg(RRClass(class_));
     const string entry_name = genCacheEntryName(qname, qtype);
+    const HashKey entry_key(entry_name, RRClass(class_));
+    recordAccess(entry_key);
 
-    RRsetEntryPtr entry_ptr = rrset_table_.get(HashKey(entry_name,
-                                                       RRClass(class_)));
+    RRsetEntryPtr entry_ptr = rrset_table_.get(entry_key);
     if (entry_ptr) {
-        if (entry_ptr->getExpireTime() > time(NULL)) {
+        const time_t now = time(NULL);
+        if (entry_ptr->getExpireTime() > now) {
             // Only touch the non-expired rrset entries
             rrset_lru_.touch(entry_ptr);
             return (entry_ptr);
+        } else if (entry_ptr->getExpireTime() + max_stale_ttl_ > now) {
+            // Keep it for stale answers, but pretend nothing was found.
+            LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_RRSET_STALE).arg(qname).
+                arg(qtype).arg(RRClass(class_));
         } else {
             LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_RRSET_EXPIRED).arg(qname).
                 arg(qtype).arg(RRClass(class_));
             // the rrset entry has expired, so just remove it from
             // hash table and lru list.
-            rrset_table_.remove(entry_ptr->hashKey());
+            if (rrset_table_.remove(entry_ptr->hashKey())) {
+                releaseMemory(entry_ptr->getSize(), entry_ptr->hashKey());
+            }
             rrset_lru_.remove(entry_ptr);
         }
     }
@@ -69,6 +83,20 @@ RRsetCache::lookup(const bundy::dns::Name& qname,
     return (RRsetEntryPtr());
 }
 
+RRsetEntryPtr
+RRsetCache::lookupStale(const bundy::dns::Name& qname,
+                        const bundy::dns::RRType& qtype)
+{
+    const string entry_name = genCacheEntryName(qname, qtype);
+    RRsetEntryPtr entry_ptr = rrset_table_.get(HashKey(entry_name,
+                                                       RRClass(class_)));
+    if (entry_ptr &&
+        entry_ptr->getExpireTime() + max_stale_ttl_ > time(NULL)) {
+        return (entry_ptr);
+    }
+    return (RRsetEntryPtr());
+}
+
 RRsetEntryPtr
 RRsetCache::update(const bundy::dns::AbstractRRset& rrset,
                    const RRsetTrustLevel& level)
@@ -76,10 +104,15 @@ RRsetCache::update(const bundy::dns::AbstractRRset& rrset,
     LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_RRSET_UPDATE).arg(rrset.getName()).
         arg(rrset.getType()).arg(rrset.getClass());
     // TODO: If the RRset is an NS, we should update the NSAS as well
-    // lookup first
+    // lookup first.  An expired entry kept for stale answers is replaced
+    // regardless of its trust level.
     RRsetEntryPtr entry_ptr = lookup(rrset.getName(), rrset.getType());
+    if (!entry_ptr && max_stale_ttl_ > 0) {
+        entry_ptr = lookupStale(rrset.getName(), rrset.getType());
+    }
     if (entry_ptr) {
-        if (entry_ptr->getTrustLevel() > level) {
+        if (entry_ptr->getExpireTime() > time(NULL) &&
+            entry_ptr->getTrustLevel() > level) {
             LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_RRSET_UNTRUSTED).
                 arg(rrset.getName()).arg(rrset.getType()).
                 arg(rrset.getClass());
@@ -91,15 +124,41 @@ RRsetCache::update(const bundy::dns::AbstractRRset& rrset,
                 arg(rrset.getClass());
             // Remove the old rrset entry from the lru list.
             rrset_lru_.remove(entry_ptr);
+            if (rrset_table_.remove(entry_ptr->hashKey())) {
+                releaseMemory(entry_ptr->getSize(), entry_ptr->hashKey());
+            }
         }
     }
 
     entry_ptr.reset(new RRsetEntry(rrset, level));
+    if (!admit(entry_ptr->getSize(), entry_ptr->hashKey())) {
+        // The callers still get the data, it's just not cached.
+        LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_RRSET_NOT_ADMITTED).
+            arg(rrset.getName()).arg(rrset.getType()).
+            arg(rrset.getClass());
+        return (entry_ptr);
+    }
     rrset_table_.add(entry_ptr, entry_ptr->hashKey(), true);
+    chargeMemory(entry_ptr->getSize(), entry_ptr->hashKey());
     rrset_lru_.add(entry_ptr);
     return (entry_ptr);
 }
 
+bool
+RRsetCache::getOldestFrequency(uint32_t& frequency) {
+    const RRsetEntryPtr oldest = rrset_lru_.getOldest();
+    if (!oldest || !getMemory()) {
+        return (false);
+    }
+    frequency = getMemory()->getFrequency(oldest->hashKey());
+    return (true);
+}
+
+bool
+RRsetCache::evictOldest() {
+    return (rrset_lru_.dropOldest());
+}
+
 } // namespace cache
 } // namespace bundy
 
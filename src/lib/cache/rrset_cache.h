@@ -15,6 +15,7 @@
 #ifndef RRSET_CACHE_H
 #define RRSET_CACHE_H
 
+#include <cache/cache_memory.h>
 #include <cache/rrset_entry.h>
 #include <nsas/hash_table.h>
 
@@ -29,9 +30,13 @@ class RRsetEntry;
 /// The object of RRsetCache represented the cache for class-specific
 /// RRsets.
 ///
+/// The memory taken by the entries is accounted in the \c CacheMemory
+/// set by \c setMemory(), if any, and the entries may be evicted or not
+/// admitted to keep it within its limit.
+///
 /// \todo The rrset cache class should provide the interfaces for
 ///       loading, dumping and resizing.
-class RRsetCache{
+class RRsetCache : public CacheMemoryUser {
     ///
     /// \name Constructors and Destructor
     ///
@@ -47,13 +52,15 @@ public:
     /// \param cache_size the size of rrset cache.
     /// \param rrset_class the class of rrset cache.
     RRsetCache(uint32_t cache_size, uint16_t rrset_class);
-    virtual ~RRsetCache() {
-        rrset_lru_.clear(); // Clear the rrset entries in the list.
-    }
+    virtual ~RRsetCache();
     //@}
 
     /// \brief Look up rrset in cache.
     ///
+    /// Expired entries are not returned.  They are removed from the
+    /// cache, unless they are still within the stale window (see
+    /// \c setMaxStaleTTL()).
+    ///
     /// \param qname The query name to look up
     /// \param qtype The query type 
     /// \return return the shared_ptr of rrset entry if it can be
@@ -61,6 +68,35 @@ public:
     RRsetEntryPtr lookup(const bundy::dns::Name& qname,
                          const bundy::dns::RRType& qtype);
 
+    /// \brief Look up rrset in cache, including the stale ones.
+    ///
+    /// Like \c lookup(), but an entry which expired less than the
+    /// maximum stale TTL ago is returned too.  Use
+    /// \c RRsetEntry::getStaleRRset() to get its data.
+    ///
+    /// \param qname The query name to look up
+    /// \param qtype The query type
+    /// \return return the shared_ptr of rrset entry if it can be
+    /// found in the cache, or else, return NULL.
+    RRsetEntryPtr lookupStale(const bundy::dns::Name& qname,
+                              const bundy::dns::RRType& qtype);
+
+    /// \brief Set how long the expired entries are kept.
+    ///
+    /// The expired entries are kept in the cache for this many seconds,
+    /// so they can be used for stale answers (RFC 8767).  0, the default,
+    /// means the entries are removed as soon as they expire.
+    ///
+    /// \param max_stale_ttl The time in seconds.
+    void setMaxStaleTTL(uint32_t max_stale_ttl) {
+        max_stale_ttl_ = max_stale_ttl;
+    }
+
+    /// \brief Return how long the expired entries are kept.
+    uint32_t getMaxStaleTTL() const {
+        return (max_stale_ttl_);
+    }
+
     /// \brief Update RRset Cache
     /// Update the rrset entry in the cache with the new one.
     /// If the rrset has expired or doesn't exist in the cache,
@@ -71,12 +107,23 @@ public:
     /// \param level trustworthiness of the rrset.
     /// \return return the rrset entry in the cache, it may be the
     /// new added rrset entry or existed one if it is not replaced.
+    /// If the new entry is not admitted because of the memory limit, it
+    /// is returned without being added.
     RRsetEntryPtr update(const bundy::dns::AbstractRRset& rrset,
                          const RRsetTrustLevel& level);
 
+    /// \name Memory Budget Interfaces
+    ///
+    /// See \c CacheMemoryUser.
+    //@{
+    virtual bool getOldestFrequency(uint32_t& frequency);
+    virtual bool evictOldest();
+    //@}
+
     /// \short Protected memebers, so they can be accessed by tests.
 protected:
     uint16_t class_; // The class of the rrset cache.
+    uint32_t max_stale_ttl_; // How long the expired rrsets are kept.
     bundy::nsas::HashTable<RRsetEntry> rrset_table_;
     bundy::util::LruList<RRsetEntry> rrset_lru_;
 };
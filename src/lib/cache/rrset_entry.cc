@@ -26,6 +26,30 @@ using namespace bundy::nsas;
 namespace bundy {
 namespace cache {
 
+namespace {
+
+// Approximate memory taken by an Rdata apart from its wire data (the
+// pointer in the RRset, the shared pointer's counter and the object).
+const size_t RDATA_OVERHEAD = sizeof(rdata::ConstRdataPtr) + 48;
+
+// Approximate memory taken by an RRset (and its RRSIGs).
+size_t
+rrsetSize(const AbstractRRset& rrset) {
+    size_t size = sizeof(RRset) + rrset.getName().getLength() +
+        rrset.getName().getLabelCount();
+    for (RdataIteratorPtr it = rrset.getRdataIterator(); !it->isLast();
+         it->next()) {
+        size += RDATA_OVERHEAD + it->getCurrent().getLength();
+    }
+    const RRsetPtr rrsig = rrset.getRRsig();
+    if (rrsig) {
+        size += rrsetSize(*rrsig);
+    }
+    return (size);
+}
+
+}
+
 RRsetEntry::RRsetEntry(const bundy::dns::AbstractRRset& rrset,
                        const RRsetTrustLevel& level):
     entry_name_(genCacheEntryName(rrset.getName(), rrset.getType())),
@@ -35,6 +59,7 @@ RRsetEntry::RRsetEntry(const bundy::dns::AbstractRRset& rrset,
     hash_key_(HashKey(entry_name_, rrset_->getClass()))
 {
     rrsetCopy(rrset, *(rrset_.get()));
+    size_ = sizeof(*this) + entry_name_.size() + rrsetSize(*rrset_);
 }
 
 bundy::dns::RRsetPtr
@@ -43,16 +68,29 @@ RRsetEntry::getRRset() {
     return (rrset_);
 }
 
+bundy::dns::RRsetPtr
+RRsetEntry::getStaleRRset() {
+    if (time(NULL) < expire_time_) {
+        return (getRRset());
+    }
+    RRsetPtr rrset(new RRset(rrset_->getName(), rrset_->getClass(),
+                             rrset_->getType(), RRTTL(STALE_ANSWER_TTL)));
+    rrsetCopy(*rrset_, *rrset);
+    return (rrset);
+}
+
 time_t
 RRsetEntry::getExpireTime() const {
     return (expire_time_);
 }
 
-void
+uint32_t
 RRsetEntry::updateTTL(){
+    bundy::util::locks::scoped_lock<bundy::util::locks::mutex> lock(mutex_);
+
     uint32_t oldTTL = rrset_->getTTL().getValue();
     if(oldTTL == 0) {
-        return;
+        return (oldTTL);
     }
 
     uint32_t now = time(NULL);
@@ -60,6 +98,7 @@ RRsetEntry::updateTTL(){
 
     RRTTL ttl(newTTL);
     rrset_->setTTL(ttl);
+    return (newTTL);
 }
 
 } // namespace cache
@@ -20,6 +20,7 @@
 #include <dns/rrttl.h>
 #include <nsas/nsas_entry.h>
 #include <nsas/fetchable.h>
+#include <util/locks.h>
 #include "cache_entry_key.h"
 
 namespace bundy {
@@ -54,6 +55,11 @@ enum RRsetTrustLevel {
     RRSET_TRUST_PRIM_ZONE_NONGLUE
 };
 
+/// \brief TTL of the expired RRsets in stale answers
+///
+/// RFC 8767 doesn't allow answering with TTL 0 and recommends 30 seconds.
+const uint32_t STALE_ANSWER_TTL = 30;
+
 /// \brief RRset Entry
 /// The object of RRsetEntry represents one cached RRset.
 /// Each RRset entry may be refered using shared_ptr by several message
@@ -85,6 +91,15 @@ public:
     /// \return Pointer to the generated RRset
     bundy::dns::RRsetPtr getRRset();
 
+    /// \brief Return the RRset for a stale answer
+    ///
+    /// If the entry has expired, a copy of the RRset with the TTL of
+    /// \c STALE_ANSWER_TTL is returned (the cached RRset itself has TTL
+    /// 0 by then), otherwise the same as \c getRRset().
+    ///
+    /// \return Pointer to the RRset
+    bundy::dns::RRsetPtr getStaleRRset();
+
     /// \brief Get the expiration time of the RRset.
     ///
     /// \return The expiration time of the RRset
@@ -96,8 +111,7 @@ public:
     ///
     /// \return The TTL of the RRset
     uint32_t getTTL() {
-        updateTTL();
-        return (rrset_->getTTL().getValue());
+        return (updateTTL());
     }
 
     /// \brief Get the hash key
@@ -107,6 +121,13 @@ public:
         return (hash_key_);
     }
 
+    /// \brief Get the approximate memory taken by the entry.
+    ///
+    /// \return The size in bytes.
+    size_t getSize() const {
+        return (size_);
+    }
+
     /// \brief get RRset trustworthiness
     ///
     /// \return return the trust level
@@ -115,7 +136,12 @@ public:
     }
 private:
     /// \brief Update TTL according to expiration time
-    void updateTTL();
+    ///
+    /// The RRset is shared by all the threads using the cache, so the
+    /// update is serialized by the entry's mutex.
+    ///
+    /// \return The updated TTL.
+    uint32_t updateTTL();
 
 private:
     std::string entry_name_; // The entry name for this rrset entry.
@@ -123,6 +149,8 @@ private:
     RRsetTrustLevel trust_level_; // RRset trustworthiness.
     boost::shared_ptr<bundy::dns::RRset> rrset_;
     bundy::nsas::HashKey hash_key_; // RRsetEntry hash key
+    size_t size_; // Approximate memory taken by the entry.
+    bundy::util::locks::mutex mutex_; // Protects the TTL of rrset_.
 };
 
 typedef boost::shared_ptr<RRsetEntry> RRsetEntryPtr;
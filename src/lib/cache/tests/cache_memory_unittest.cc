@@ -0,0 +1,228 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+#include <boost/lexical_cast.hpp>
+#include <gtest/gtest.h>
+#include <cache/cache_memory.h>
+#include <cache/rrset_cache.h>
+#include <dns/name.h>
+#include <dns/rdataclass.h>
+#include <dns/rrclass.h>
+#include <dns/rrtype.h>
+#include <dns/rrttl.h>
+#include <dns/rrset.h>
+
+using namespace bundy::cache;
+using namespace bundy::dns;
+using bundy::nsas::HashKey;
+using namespace std;
+
+namespace {
+
+class CacheMemoryTest : public testing::Test {
+protected:
+    CacheMemoryTest() :
+        memory_(new CacheMemory()),
+        cache1_(100, RRClass::IN().getCode()),
+        cache2_(100, RRClass::IN().getCode())
+    {
+        cache1_.setMemory(memory_);
+        cache2_.setMemory(memory_);
+    }
+
+    // Add an A RRset of the name with one address to the cache.  All the
+    // names used are of the same length, so the entries are of the same
+    // size.
+    void update(RRsetCache& cache, const string& name) {
+        RRset rrset(Name(name), RRClass::IN(), RRType::A(), RRTTL(300));
+        rrset.addRdata(rdata::in::A("192.0.2.1"));
+        cache.update(rrset, RRSET_TRUST_ANSWER_AA);
+    }
+
+    bool cached(RRsetCache& cache, const string& name) {
+        return (cache.lookup(Name(name), RRType::A()) != NULL);
+    }
+
+    // Size of one entry.
+    size_t entrySize() {
+        RRsetCache cache(1, RRClass::IN().getCode());
+        update(cache, "a0.example.com");
+        return (cache.getMemoryUsed());
+    }
+
+    CacheMemoryPtr memory_;
+    RRsetCache cache1_;
+    RRsetCache cache2_;
+};
+
+TEST_F(CacheMemoryTest, accounting) {
+    EXPECT_EQ(0, memory_->getUsed());
+    EXPECT_EQ(0, memory_->getLimit());
+
+    const size_t size = entrySize();
+    EXPECT_LT(0, size);
+
+    update(cache1_, "a1.example.com");
+    EXPECT_EQ(size, cache1_.getMemoryUsed());
+    EXPECT_EQ(size, memory_->getUsed());
+    update(cache2_, "b1.example.com");
+    EXPECT_EQ(size, cache2_.getMemoryUsed());
+    EXPECT_EQ(2 * size, memory_->getUsed());
+
+    // Replacing an entry doesn't count it twice
+    update(cache1_, "a1.example.com");
+    EXPECT_EQ(size, cache1_.getMemoryUsed());
+    EXPECT_EQ(2 * size, memory_->getUsed());
+
+    // The memory moves with the cache between the budgets
+    cache2_.setMemory(CacheMemoryPtr());
+    EXPECT_EQ(size, memory_->getUsed());
+    EXPECT_EQ(size, cache2_.getMemoryUsed());
+    cache2_.setMemory(memory_);
+    EXPECT_EQ(2 * size, memory_->getUsed());
+
+    // And is released when the cache goes away
+    {
+        RRsetCache cache(100, RRClass::IN().getCode());
+        cache.setMemory(memory_);
+        update(cache, "c1.example.com");
+        EXPECT_EQ(3 * size, memory_->getUsed());
+    }
+    EXPECT_EQ(2 * size, memory_->getUsed());
+
+    // Nothing was evicted, there's no limit
+    EXPECT_EQ(0, memory_->getEvictions());
+    EXPECT_EQ(0, memory_->getRejections());
+}
+
+TEST_F(CacheMemoryTest, eviction) {
+    const size_t size = entrySize();
+    memory_->setLimit(3 * size + size / 2);
+
+    update(cache1_, "a1.example.com");
+    update(cache1_, "a2.example.com");
+    update(cache2_, "b1.example.com");
+    EXPECT_EQ(3 * size, memory_->getUsed());
+
+    // The oldest entry of the cache taking the most memory goes away
+    update(cache2_, "b2.example.com");
+    EXPECT_EQ(3 * size, memory_->getUsed());
+    EXPECT_EQ(1, memory_->getEvictions());
+    EXPECT_EQ(size, cache1_.getMemoryUsed());
+    EXPECT_EQ(2 * size, cache2_.getMemoryUsed());
+
+    // Lowering the limit takes effect with the next update
+    memory_->setLimit(2 * size);
+    update(cache1_, "a3.example.com");
+    EXPECT_EQ(2 * size, memory_->getUsed());
+    EXPECT_EQ(3, memory_->getEvictions());
+    EXPECT_EQ(0, memory_->getRejections());
+
+    // (The lookups count as uses, so they are checked only at the end)
+    EXPECT_FALSE(cached(cache1_, "a1.example.com"));
+    EXPECT_FALSE(cached(cache1_, "a2.example.com"));
+    EXPECT_TRUE(cached(cache1_, "a3.example.com"));
+    EXPECT_FALSE(cached(cache2_, "b1.example.com"));
+    EXPECT_TRUE(cached(cache2_, "b2.example.com"));
+}
+
+TEST_F(CacheMemoryTest, shards) {
+    const size_t size = entrySize();
+    const size_t count = 10 * CacheMemory::SHARDS;
+
+    // The entries are spread over the shards, but accounted as a whole
+    vector<bool> used_shards(CacheMemory::SHARDS, false);
+    for (size_t i = 0; i < count; ++i) {
+        const string name = "a" + boost::lexical_cast<string>(i) +
+            ".example.org";
+        const size_t shard =
+            CacheMemory::getShard(HashKey(name, RRClass::IN()));
+        ASSERT_LT(shard, CacheMemory::SHARDS);
+        used_shards[shard] = true;
+        update(cache1_, name);
+    }
+    EXPECT_EQ(CacheMemory::SHARDS,
+              count_if(used_shards.begin(), used_shards.end(),
+                       bind2nd(equal_to<bool>(), true)));
+    const size_t used = cache1_.getMemoryUsed();
+    EXPECT_EQ(used, memory_->getUsed());
+
+    // The limit holds across the shards
+    memory_->setLimit(used / 2);
+    update(cache2_, "b1.example.com");
+    EXPECT_GE(used / 2, memory_->getUsed());
+    EXPECT_EQ(size, cache2_.getMemoryUsed());
+    EXPECT_LT(0, memory_->getEvictions());
+
+    // And nothing is left when the caches leave the budget
+    const size_t left = memory_->getUsed();
+    cache1_.setMemory(CacheMemoryPtr());
+    cache2_.setMemory(CacheMemoryPtr());
+    EXPECT_EQ(0, memory_->getUsed());
+    EXPECT_EQ(left, cache1_.getMemoryUsed() + cache2_.getMemoryUsed());
+}
+
+TEST_F(CacheMemoryTest, admission) {
+    const size_t size = entrySize();
+    memory_->setLimit(2 * size + size / 2);
+
+    // A popular entry is not pushed out by a name asked for once
+    update(cache1_, "a1.example.com");
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_TRUE(cached(cache1_, "a1.example.com"));
+    }
+    update(cache1_, "a2.example.com");
+    update(cache1_, "a3.example.com");
+    EXPECT_EQ(1, memory_->getRejections());
+    EXPECT_EQ(0, memory_->getEvictions());
+    EXPECT_TRUE(cached(cache1_, "a1.example.com"));
+    EXPECT_TRUE(cached(cache1_, "a2.example.com"));
+    EXPECT_FALSE(cached(cache1_, "a3.example.com"));
+    EXPECT_EQ(2 * size, memory_->getUsed());
+
+    // An entry which doesn't fit at all is never admitted
+    memory_->setLimit(size / 2);
+    update(cache2_, "b1.example.com");
+    EXPECT_EQ(2, memory_->getRejections());
+    EXPECT_FALSE(cached(cache2_, "b1.example.com"));
+}
+
+TEST_F(CacheMemoryTest, frequency) {
+    const HashKey key1("key1", 4, RRClass::IN());
+    const HashKey key2("key2", 4, RRClass::IN());
+
+    // Nothing is counted without a limit
+    memory_->recordAccess(key1);
+    EXPECT_EQ(0, memory_->getFrequency(key1));
+
+    memory_->setLimit(1 << 20);
+    for (int i = 0; i < 3; ++i) {
+        memory_->recordAccess(key1);
+    }
+    EXPECT_EQ(3, memory_->getFrequency(key1));
+    EXPECT_EQ(0, memory_->getFrequency(key2));
+
+    // The counts saturate
+    for (int i = 0; i < 100; ++i) {
+        memory_->recordAccess(key2);
+    }
+    EXPECT_EQ(15, memory_->getFrequency(key2));
+}
+
+}
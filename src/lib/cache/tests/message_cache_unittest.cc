@@ -127,6 +127,36 @@ TEST_F(MessageCacheTest, testLookup) {
     EXPECT_EQ(message_cache_->messages_count(), 2);
 }
 
+TEST_F(MessageCacheTest, testLookupStale) {
+    // Serving stale data is disabled by default.
+    updateMessageCache("message_fromWire9", message_cache_);
+    Name qname("test.example.org.");
+    EXPECT_FALSE(message_cache_->lookupStale(qname, RRType::A(),
+                                             message_render));
+
+    message_cache_->setMaxStaleTTL(3600);
+    rrset_cache_->setMaxStaleTTL(3600);
+    negative_soa_cache_->setMaxStaleTTL(3600);
+    updateMessageCache("message_fromWire9", message_cache_);
+    EXPECT_EQ(message_cache_->messages_count(), 1);
+
+    // The expired message is kept, but only looked up as stale.
+    EXPECT_FALSE(message_cache_->lookup(qname, RRType::A(), message_render));
+    EXPECT_EQ(message_cache_->messages_count(), 1);
+    EXPECT_TRUE(message_cache_->lookupStale(qname, RRType::A(),
+                                            message_render));
+    EXPECT_LT(0, message_render.getRRCount(Message::SECTION_ANSWER));
+    EXPECT_EQ(STALE_ANSWER_TTL,
+              (*message_render.beginSection(Message::SECTION_ANSWER))->
+              getTTL().getValue());
+
+    // It's gone when an RRset of it is gone.
+    rrset_cache_->removeRRsetEntry(qname, RRType::A());
+    Message message_stale(Message::RENDER);
+    EXPECT_FALSE(message_cache_->lookupStale(qname, RRType::A(),
+                                             message_stale));
+}
+
 TEST_F(MessageCacheTest, testUpdate) {
     messageFromFile(message_parse, "message_fromWire4");
     EXPECT_TRUE(message_cache_->update(message_parse));
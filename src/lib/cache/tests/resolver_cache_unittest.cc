@@ -65,6 +65,57 @@ TEST_F(ResolverCacheTest, testUpdateMessage) {
     EXPECT_FALSE(new_msg.getHeaderFlag(Message::HEADERFLAG_AA));
 }
 
+TEST_F(ResolverCacheTest, testLookupStale) {
+    Message msg(Message::PARSE);
+    messageFromFile(msg, "message_fromWire9");
+    Name qname("test.example.org.");
+
+    // Serving stale data is disabled by default.
+    EXPECT_EQ(0, cache->getMaxStaleTTL());
+    cache->update(msg);
+    msg.makeResponse();
+    EXPECT_FALSE(cache->lookupStale(qname, RRType::A(), RRClass::IN(), msg));
+
+    cache->setMaxStaleTTL(3600);
+    EXPECT_EQ(3600, cache->getMaxStaleTTL());
+    Message new_msg(Message::PARSE);
+    messageFromFile(new_msg, "message_fromWire9");
+    cache->update(new_msg);
+    new_msg.makeResponse();
+    EXPECT_FALSE(cache->lookup(qname, RRType::A(), RRClass::IN(), new_msg));
+    EXPECT_TRUE(cache->lookupStale(qname, RRType::A(), RRClass::IN(),
+                                   new_msg));
+    EXPECT_EQ(1, sectionRRsetCount(new_msg, Message::SECTION_ANSWER));
+
+    // Nothing for an unknown class.
+    EXPECT_FALSE(cache->lookupStale(qname, RRType::A(), RRClass::HS(),
+                                    new_msg));
+}
+
+TEST_F(ResolverCacheTest, testMemoryLimit) {
+    // No limit by default, but the memory is accounted
+    EXPECT_EQ(0, cache->getMemory().getLimit());
+    EXPECT_EQ(0, cache->getMemory().getUsed());
+    Message msg(Message::PARSE);
+    messageFromFile(msg, "message_fromWire3");
+    cache->update(msg);
+    const size_t used = cache->getMemory().getUsed();
+    EXPECT_LT(0, used);
+
+    // Nothing new fits into a tiny limit, so it is not cached
+    cache->setMemoryLimit(1);
+    EXPECT_EQ(1, cache->getMemory().getLimit());
+    Message new_msg(Message::PARSE);
+    messageFromFile(new_msg, "message_fromWire9");
+    cache->update(new_msg);
+    EXPECT_EQ(used, cache->getMemory().getUsed());
+    EXPECT_LT(0, cache->getMemory().getRejections());
+
+    cache->setMemoryLimit(0);
+    cache->update(new_msg);
+    EXPECT_LT(used, cache->getMemory().getUsed());
+}
+
 TEST_F(ResolverCacheTest, testUpdateRRset) {
     Message msg(Message::PARSE);
     messageFromFile(msg, "message_fromWire3");
@@ -95,6 +95,36 @@ TEST_F(RRsetCacheTest, update) {
     EXPECT_EQ(rrset_entry_ptr->getTrustLevel(), rrset_entry2_.getTrustLevel());
 }
 
+TEST_F(RRsetCacheTest, lookupStale) {
+    Name name_test("test.example.com.");
+    updateRRsetCache(cache_, name_test, 0);
+
+    // Serving stale data is disabled by default.
+    EXPECT_FALSE(cache_.lookupStale(name_test, RRType::A()));
+
+    // The expired entry is kept, but only looked up as stale.
+    cache_.setMaxStaleTTL(3600);
+    EXPECT_EQ(3600, cache_.getMaxStaleTTL());
+    updateRRsetCache(cache_, name_test, 0);
+    EXPECT_FALSE(cache_.lookup(name_test, RRType::A()));
+    RRsetEntryPtr rrset_entry_ptr = cache_.lookupStale(name_test,
+                                                       RRType::A());
+    ASSERT_TRUE(rrset_entry_ptr);
+    EXPECT_EQ(STALE_ANSWER_TTL,
+              rrset_entry_ptr->getStaleRRset()->getTTL().getValue());
+
+    // Fresh data is returned by both, with its own TTL.
+    cache_.update(rrset1_, rrset_entry1_.getTrustLevel());
+    rrset_entry_ptr = cache_.lookupStale(name_, RRType::A());
+    ASSERT_TRUE(rrset_entry_ptr);
+    EXPECT_TRUE(cache_.lookup(name_, RRType::A()));
+    EXPECT_EQ(rrset_entry_ptr->getRRset(), rrset_entry_ptr->getStaleRRset());
+
+    // An expired entry is replaced by less trusted data.
+    updateRRsetCache(cache_, name_test, 20, RRSET_TRUST_ADDITIONAL_NONAA);
+    EXPECT_TRUE(cache_.lookup(name_test, RRType::A()));
+}
+
 // Test whether the lru list in rrset cache works as expected.
 TEST_F(RRsetCacheTest, cacheLruBehavior) {
     Name name1("1.example.com.");
@@ -28,15 +28,23 @@
 #include <exceptions/exceptions.h>
 #include <util/io/pktinfo_utilities.h>
 
+#include <algorithm>
+#include <climits>
 #include <cstring>
 #include <errno.h>
 #include <fstream>
 #include <sstream>
 
 #include <arpa/inet.h>
+#include <fcntl.h>
 #include <netinet/in.h>
 #include <string.h>
 #include <sys/select.h>
+#include <unistd.h>
+
+#if defined (OS_LINUX)
+#include <sys/epoll.h>
+#endif
 
 using namespace std;
 using namespace bundy::asiolink;
@@ -222,6 +230,9 @@ void IfaceMgr::closeSockets() {
          iface != ifaces_.end(); ++iface) {
         iface->closeSockets();
     }
+    invalidateReceiveSockets();
+    queue4_.clear();
+    queue6_.clear();
 }
 
 void
@@ -230,6 +241,12 @@ IfaceMgr::closeSockets(const uint16_t family) {
          iface != ifaces_.end(); ++iface) {
         iface->closeSockets(family);
     }
+    invalidateReceiveSockets();
+    if (family == AF_INET) {
+        queue4_.clear();
+    } else {
+        queue6_.clear();
+    }
 }
 
 IfaceMgr::~IfaceMgr() {
@@ -262,6 +279,7 @@ IfaceMgr::addExternalSocket(int socketfd, SocketCallback callback) {
     x.socket_ = socketfd;
     x.callback_ = callback;
     callbacks_.push_back(x);
+    invalidateReceiveSockets();
 }
 
 void
@@ -270,6 +288,7 @@ IfaceMgr::deleteExternalSocket(int socketfd) {
          s != callbacks_.end(); ++s) {
         if (s->socket_ == socketfd) {
             callbacks_.erase(s);
+            invalidateReceiveSockets();
             return;
         }
     }
@@ -612,6 +631,7 @@ IfaceMgr::getIface(const std::string& ifname) {
 void
 IfaceMgr::clearIfaces() {
     ifaces_.clear();
+    invalidateReceiveSockets();
 }
 
 int IfaceMgr::openSocket(const std::string& ifname, const IOAddress& addr,
@@ -783,6 +803,7 @@ IfaceMgr::openSocket6(Iface& iface, const IOAddress& addr, uint16_t port,
     SocketInfo info = packet_filter6_->openSocket(iface, addr, port,
                                                   join_multicast);
     iface.addSocket(info);
+    invalidateReceiveSockets();
 
     return (info.sockfd_);
 }
@@ -796,6 +817,7 @@ IfaceMgr::openSocket4(Iface& iface, const IOAddress& addr,
     SocketInfo info = packet_filter_->openSocket(iface, addr, port,
                                                  receive_bcast, send_bcast);
     iface.addSocket(info);
+    invalidateReceiveSockets();
 
     return (info.sockfd_);
 }
@@ -833,170 +855,253 @@ IfaceMgr::receive4(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */) {
         bundy_throw(BadValue, "fractional timeout must be shorter than"
                   " one million microseconds");
     }
-    const SocketInfo* candidate = 0;
-    IfaceCollection::const_iterator iface;
-    fd_set sockets;
-    int maxfd = 0;
-
-    FD_ZERO(&sockets);
 
-    /// @todo: marginal performance optimization. We could create the set once
-    /// and then use its copy for select(). Please note that select() modifies
-    /// provided set to indicated which sockets have something to read.
-    for (iface = ifaces_.begin(); iface != ifaces_.end(); ++iface) {
+    // Return the packets received together one by one.
+    if (!queue4_.empty()) {
+        Pkt4Ptr pkt = queue4_.front();
+        queue4_.pop_front();
+        return (pkt);
+    }
 
-        const Iface::SocketCollection& socket_collection = iface->getSockets();
-        for (Iface::SocketCollection::const_iterator s = socket_collection.begin();
-             s != socket_collection.end(); ++s) {
+    if (!receive_sockets4_.valid_) {
+        updateReceiveSockets(receive_sockets4_, AF_INET);
+    }
 
-            // Only deal with IPv4 addresses.
-            if (s->addr_.isV4()) {
+    std::vector<int> ready;
+    waitForSockets(receive_sockets4_, timeout_sec, timeout_usec, ready);
+    if (ready.empty()) {
+        // nothing received and timeout has been reached
+        return (Pkt4Ptr()); // NULL
+    }
 
-                // Add this socket to listening set
-                FD_SET(s->sockfd_, &sockets);
-                if (maxfd < s->sockfd_) {
-                    maxfd = s->sockfd_;
-                }
-            }
-        }
+    // Something received over external socket
+    if (callExternalSocket(ready)) {
+        return (Pkt4Ptr());
     }
 
-    // if there are any callbacks for external sockets registered...
-    if (!callbacks_.empty()) {
-        for (SocketCallbackInfoContainer::const_iterator s = callbacks_.begin();
-             s != callbacks_.end(); ++s) {
-            FD_SET(s->socket_, &sockets);
-            if (maxfd < s->socket_) {
-                maxfd = s->socket_;
-            }
+    // Now we have the sockets, let's get some data from them!
+    for (std::vector<int>::const_iterator fd = ready.begin();
+         fd != ready.end(); ++fd) {
+        std::map<int, ReceiveSocket>::const_iterator s =
+            receive_sockets4_.sockets_.find(*fd);
+        if ((s == receive_sockets4_.sockets_.end()) || !s->second.socket_) {
+            invalidateReceiveSockets();
+            bundy_throw(SocketReadError, "received data over unknown socket");
         }
-    }
 
-    struct timeval select_timeout;
-    select_timeout.tv_sec = timeout_sec;
-    select_timeout.tv_usec = timeout_usec;
+        // Assuming that packet filter is not NULL, because its modifier
+        // checks it.
+        std::vector<Pkt4Ptr> pkts;
+        packet_filter_->receiveBatch(*s->second.iface_, *s->second.socket_,
+                                     pkts, RECEIVE_BATCH_SIZE);
+        queue4_.insert(queue4_.end(), pkts.begin(), pkts.end());
+    }
 
-    int result = select(maxfd + 1, &sockets, NULL, NULL, &select_timeout);
+    if (queue4_.empty()) {
+        return (Pkt4Ptr());
+    }
+    Pkt4Ptr pkt = queue4_.front();
+    queue4_.pop_front();
+    return (pkt);
+}
 
-    if (result == 0) {
-        // nothing received and timeout has been reached
-        return (Pkt4Ptr()); // NULL
-    } else if (result < 0) {
-        bundy_throw(SocketReadError, strerror(errno));
+Pkt6Ptr IfaceMgr::receive6(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */ ) {
+    // Sanity check for microsecond timeout.
+    if (timeout_usec >= 1000000) {
+        bundy_throw(BadValue, "fractional timeout must be shorter than"
+                  " one million microseconds");
     }
 
-    // Let's find out which socket has the data
-    for (SocketCallbackInfoContainer::iterator s = callbacks_.begin();
-         s != callbacks_.end(); ++s) {
-        if (!FD_ISSET(s->socket_, &sockets)) {
-            continue;
-        }
+    // Return the packets received together one by one.
+    if (!queue6_.empty()) {
+        Pkt6Ptr pkt = queue6_.front();
+        queue6_.pop_front();
+        return (pkt);
+    }
 
-        // something received over external socket
+    if (!receive_sockets6_.valid_) {
+        updateReceiveSockets(receive_sockets6_, AF_INET6);
+    }
 
-        // Calling the external socket's callback provides its service
-        // layer access without integrating any specific features
-        // in IfaceMgr
-        if (s->callback_) {
-            s->callback_();
-        }
+    std::vector<int> ready;
+    waitForSockets(receive_sockets6_, timeout_sec, timeout_usec, ready);
+    if (ready.empty()) {
+        // nothing received and timeout has been reached
+        return (Pkt6Ptr()); // NULL
+    }
 
-        return (Pkt4Ptr());
+    // Something received over external socket
+    if (callExternalSocket(ready)) {
+        return (Pkt6Ptr());
     }
 
-    // Let's find out which interface/socket has the data
-    for (iface = ifaces_.begin(); iface != ifaces_.end(); ++iface) {
-        const Iface::SocketCollection& socket_collection = iface->getSockets();
-        for (Iface::SocketCollection::const_iterator s = socket_collection.begin();
-             s != socket_collection.end(); ++s) {
-            if (FD_ISSET(s->sockfd_, &sockets)) {
-                candidate = &(*s);
-                break;
-            }
+    // Read a packet from each of the sockets.
+    for (std::vector<int>::const_iterator fd = ready.begin();
+         fd != ready.end(); ++fd) {
+        std::map<int, ReceiveSocket>::const_iterator s =
+            receive_sockets6_.sockets_.find(*fd);
+        if ((s == receive_sockets6_.sockets_.end()) || !s->second.socket_) {
+            invalidateReceiveSockets();
+            bundy_throw(SocketReadError, "received data over unknown socket");
         }
-        if (candidate) {
-            break;
+
+        // Assuming that packet filter is not NULL, because its modifier
+        // checks it.
+        Pkt6Ptr pkt = packet_filter6_->receive(*s->second.socket_);
+        if (pkt) {
+            queue6_.push_back(pkt);
         }
     }
 
-    if (!candidate) {
-        bundy_throw(SocketReadError, "received data over unknown socket");
+    if (queue6_.empty()) {
+        return (Pkt6Ptr());
     }
-
-    // Now we have a socket, let's get some data from it!
-    // Assuming that packet filter is not NULL, because its modifier checks it.
-    return (packet_filter_->receive(*iface, *candidate));
+    Pkt6Ptr pkt = queue6_.front();
+    queue6_.pop_front();
+    return (pkt);
 }
 
-Pkt6Ptr IfaceMgr::receive6(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */ ) {
-    // Sanity check for microsecond timeout.
-    if (timeout_usec >= 1000000) {
-        bundy_throw(BadValue, "fractional timeout must be shorter than"
-                  " one million microseconds");
+IfaceMgr::ReceiveSockets::~ReceiveSockets() {
+    if (pollfd_ >= 0) {
+        close(pollfd_);
     }
+}
 
-    const SocketInfo* candidate = 0;
-    fd_set sockets;
-    int maxfd = 0;
+void
+IfaceMgr::invalidateReceiveSockets() {
+    receive_sockets4_.valid_ = false;
+    receive_sockets6_.valid_ = false;
+}
 
-    FD_ZERO(&sockets);
+void
+IfaceMgr::updateReceiveSockets(ReceiveSockets& sockets,
+                               const uint16_t family) {
+    sockets.valid_ = false;
+    sockets.sockets_.clear();
 
-    /// @todo: marginal performance optimization. We could create the set once
-    /// and then use its copy for select(). Please note that select() modifies
-    /// provided set to indicated which sockets have something to read.
-    IfaceCollection::const_iterator iface;
-    for (iface = ifaces_.begin(); iface != ifaces_.end(); ++iface) {
+    for (IfaceCollection::const_iterator iface = ifaces_.begin();
+         iface != ifaces_.end(); ++iface) {
         const Iface::SocketCollection& socket_collection = iface->getSockets();
         for (Iface::SocketCollection::const_iterator s = socket_collection.begin();
              s != socket_collection.end(); ++s) {
+            // Only deal with the addresses of the family.
+            if ((family == AF_INET) ? s->addr_.isV4() : s->addr_.isV6()) {
+                ReceiveSocket& socket = sockets.sockets_[s->sockfd_];
+                socket.iface_ = &(*iface);
+                socket.socket_ = &(*s);
+            }
+        }
+    }
 
-            // Only deal with IPv6 addresses.
-            if (s->addr_.isV6()) {
+    // The callbacks are looked up in callbacks_, in order.
+    for (SocketCallbackInfoContainer::const_iterator s = callbacks_.begin();
+         s != callbacks_.end(); ++s) {
+        ReceiveSocket& socket = sockets.sockets_[s->socket_];
+        socket.iface_ = NULL;
+        socket.socket_ = NULL;
+    }
 
-                // Add this socket to listening set
-                FD_SET(s->sockfd_, &sockets);
-                if (maxfd < s->sockfd_) {
-                    maxfd = s->sockfd_;
-                }
+#if defined (OS_LINUX)
+    if (sockets.pollfd_ >= 0) {
+        close(sockets.pollfd_);
+    }
+    sockets.pollfd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (sockets.pollfd_ < 0) {
+        bundy_throw(SocketReadError, "failed to create epoll descriptor: "
+                  << strerror(errno));
+    }
+    for (std::map<int, ReceiveSocket>::const_iterator s =
+             sockets.sockets_.begin(); s != sockets.sockets_.end(); ++s) {
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = s->first;
+        if (epoll_ctl(sockets.pollfd_, EPOLL_CTL_ADD, s->first, &event) < 0) {
+            // The descriptors which can't be polled (EPERM) are always
+            // readable for select(), there is no point waiting on them.
+            if (errno == EPERM) {
+                continue;
             }
+            bundy_throw(SocketReadError, "failed to wait on socket "
+                      << s->first << ": " << strerror(errno));
         }
     }
+#endif
 
-    // if there are any callbacks for external sockets registered...
-    if (!callbacks_.empty()) {
-        for (SocketCallbackInfoContainer::const_iterator s = callbacks_.begin();
-             s != callbacks_.end(); ++s) {
+    sockets.valid_ = true;
+}
 
-            // Add it to the set as well
-            FD_SET(s->socket_, &sockets);
-            if (maxfd < s->socket_) {
-                maxfd = s->socket_;
+void
+IfaceMgr::waitForSockets(ReceiveSockets& sockets, uint32_t timeout_sec,
+                         uint32_t timeout_usec, std::vector<int>& ready) {
+#if defined (OS_LINUX)
+    // The timeout is rounded up to the millisecond.
+    const uint64_t timeout = static_cast<uint64_t>(timeout_sec) * 1000 +
+        (timeout_usec + 999) / 1000;
+
+    // More readable sockets than this are reported by the next call.
+    struct epoll_event events[64];
+    int result = epoll_wait(sockets.pollfd_, events,
+                            sizeof(events) / sizeof(events[0]),
+                            timeout > INT_MAX ? INT_MAX : timeout);
+    if (result < 0) {
+        bundy_throw(SocketReadError, strerror(errno));
+    }
+    if (result == 0) {
+        // Unlike select(), epoll silently drops the descriptors closed
+        // behind our back from its set.  Look for them when nothing was
+        // received, so they are reported as select() does.
+        for (std::map<int, ReceiveSocket>::const_iterator s =
+                 sockets.sockets_.begin(); s != sockets.sockets_.end(); ++s) {
+            if (fcntl(s->first, F_GETFD) < 0 && errno == EBADF) {
+                bundy_throw(SocketReadError, "socket " << s->first
+                          << " is closed");
             }
         }
     }
+    for (int i = 0; i < result; ++i) {
+        ready.push_back(events[i].data.fd);
+    }
+#else
+    fd_set fds;
+    int maxfd = 0;
+
+    FD_ZERO(&fds);
+    for (std::map<int, ReceiveSocket>::const_iterator s =
+             sockets.sockets_.begin(); s != sockets.sockets_.end(); ++s) {
+        FD_SET(s->first, &fds);
+        if (maxfd < s->first) {
+            maxfd = s->first;
+        }
+    }
 
     struct timeval select_timeout;
     select_timeout.tv_sec = timeout_sec;
     select_timeout.tv_usec = timeout_usec;
 
-    int result = select(maxfd + 1, &sockets, NULL, NULL, &select_timeout);
-
-    if (result == 0) {
-        // nothing received and timeout has been reached
-        return (Pkt6Ptr()); // NULL
-    } else if (result < 0) {
+    int result = select(maxfd + 1, &fds, NULL, NULL, &select_timeout);
+    if (result < 0) {
         bundy_throw(SocketReadError, strerror(errno));
     }
+    for (std::map<int, ReceiveSocket>::const_iterator s =
+             sockets.sockets_.begin();
+         (result > 0) && (s != sockets.sockets_.end()); ++s) {
+        if (FD_ISSET(s->first, &fds)) {
+            ready.push_back(s->first);
+        }
+    }
+#endif
+}
 
-    // Let's find out which socket has the data
+bool
+IfaceMgr::callExternalSocket(const std::vector<int>& ready) {
     for (SocketCallbackInfoContainer::iterator s = callbacks_.begin();
          s != callbacks_.end(); ++s) {
-        if (!FD_ISSET(s->socket_, &sockets)) {
+        if (std::find(ready.begin(), ready.end(), s->socket_) ==
+            ready.end()) {
             continue;
         }
 
-        // something received over external socket
-
         // Calling the external socket's callback provides its service
         // layer access without integrating any specific features
         // in IfaceMgr
@@ -1004,29 +1109,9 @@ Pkt6Ptr IfaceMgr::receive6(uint32_t timeout_sec, uint32_t timeout_usec /* = 0 */
             s->callback_();
         }
 
-        return (Pkt6Ptr());
-    }
-
-    // Let's find out which interface/socket has the data
-    for (iface = ifaces_.begin(); iface != ifaces_.end(); ++iface) {
-        const Iface::SocketCollection& socket_collection = iface->getSockets();
-        for (Iface::SocketCollection::const_iterator s = socket_collection.begin();
-             s != socket_collection.end(); ++s) {
-            if (FD_ISSET(s->sockfd_, &sockets)) {
-                candidate = &(*s);
-                break;
-            }
-        }
-        if (candidate) {
-            break;
-        }
-    }
-
-    if (!candidate) {
-        bundy_throw(SocketReadError, "received data over unknown socket");
+        return (true);
     }
-    // Assuming that packet filter is not NULL, because its modifier checks it.
-    return (packet_filter6_->receive(*candidate));
+    return (false);
 }
 
 uint16_t IfaceMgr::getSocket(const bundy::dhcp::Pkt6& pkt) {
@@ -28,7 +28,10 @@
 #include <boost/scoped_array.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include <deque>
 #include <list>
+#include <map>
+#include <vector>
 
 namespace bundy {
 
@@ -429,6 +432,9 @@ public:
     /// we don't support packets larger than 1500.
     static const uint32_t RCVBUFSIZE = 1500;
 
+    /// @brief Maximum number of packets read from a socket at once.
+    static const size_t RECEIVE_BATCH_SIZE = 32;
+
     // TODO performance improvement: we may change this into
     //      2 maps (ifindex-indexed and name-indexed) and
     //      also hide it (make it public make tests easier for now)
@@ -557,6 +563,10 @@ public:
     /// If reception is successful and all information about its sender
     /// are obtained, Pkt6 object is created and returned.
     ///
+    /// When several sockets are readable, a packet is read from each of
+    /// them and queued: the next calls return the queued packets without
+    /// waiting.  See @ref receive4 for the way the sockets are waited on.
+    ///
     /// TODO Start using select() and add timeout to be able
     /// to not wait infinitely, but rather do something useful
     /// (e.g. remove expired leases)
@@ -576,6 +586,13 @@ public:
     /// If reception is successful and all information about its sender
     /// are obtained, Pkt4 object is created and returned.
     ///
+    /// On Linux the sockets are waited on with epoll, the set of sockets is
+    /// only rebuilt when the sockets opened by the @c IfaceMgr or the
+    /// external sockets change.  Other systems use select().  All the
+    /// packets waiting on the readable sockets are read at once (up to
+    /// @c RECEIVE_BATCH_SIZE by socket) and queued: the next calls return
+    /// the queued packets without waiting.
+    ///
     /// @param timeout_sec specifies integral part of the timeout (in seconds)
     /// @param timeout_usec specifies fractional part of the timeout
     /// (in microseconds)
@@ -1041,6 +1058,65 @@ private:
                              const uint16_t port,
                              IfaceMgrErrorMsgCallback error_handler = NULL);
 
+    /// @brief A socket the receive functions wait on.
+    struct ReceiveSocket {
+        /// Interface of the socket, NULL for an external socket.
+        const Iface* iface_;
+
+        /// The socket, NULL for an external socket.
+        const SocketInfo* socket_;
+    };
+
+    /// @brief The sockets the receive functions of a family wait on.
+    struct ReceiveSockets : public boost::noncopyable {
+        /// @brief Constructor, the set must be built before use.
+        ReceiveSockets() : pollfd_(-1), valid_(false) {}
+
+        /// @brief Destructor, closes the epoll descriptor.
+        ~ReceiveSockets();
+
+        /// The sockets by descriptor.
+        std::map<int, ReceiveSocket> sockets_;
+
+        /// The epoll descriptor (Linux only).
+        int pollfd_;
+
+        /// Flag which indicates if the set matches the open sockets.
+        bool valid_;
+    };
+
+    /// @brief Marks the sets of sockets to be rebuilt.
+    ///
+    /// Called whenever the sockets or the external sockets change.
+    void invalidateReceiveSockets();
+
+    /// @brief Rebuilds a set of sockets.
+    ///
+    /// @param sockets The set.
+    /// @param family AF_INET or AF_INET6.
+    /// @throw bundy::dhcp::SocketReadError if a socket can't be waited on.
+    void updateReceiveSockets(ReceiveSockets& sockets, const uint16_t family);
+
+    /// @brief Waits for some sockets of a set to be readable.
+    ///
+    /// @param sockets The set.
+    /// @param timeout_sec integral part of the timeout (in seconds)
+    /// @param timeout_usec fractional part of the timeout (in microseconds)
+    /// @param [out] ready The readable sockets are appended here, nothing
+    ///     is appended on timeout.
+    /// @throw bundy::dhcp::SocketReadError if the wait fails.
+    void waitForSockets(ReceiveSockets& sockets, uint32_t timeout_sec,
+                        uint32_t timeout_usec, std::vector<int>& ready);
+
+    /// @brief Calls the callback of a readable external socket.
+    ///
+    /// Only the first readable socket, in the order the sockets were added,
+    /// is handled.
+    ///
+    /// @param ready The readable sockets.
+    /// @return true if a callback was called.
+    bool callExternalSocket(const std::vector<int>& ready);
+
     /// Holds instance of a class derived from PktFilter, used by the
     /// IfaceMgr to open sockets and send/receive packets through these
     /// sockets. It is possible to supply custom object using
@@ -1059,6 +1135,18 @@ private:
 
     /// @brief Contains list of callbacks for external sockets
     SocketCallbackInfoContainer callbacks_;
+
+    /// @brief The sockets @c receive4 waits on.
+    ReceiveSockets receive_sockets4_;
+
+    /// @brief The sockets @c receive6 waits on.
+    ReceiveSockets receive_sockets6_;
+
+    /// @brief The IPv4 packets received but not returned yet.
+    std::deque<Pkt4Ptr> queue4_;
+
+    /// @brief The IPv6 packets received but not returned yet.
+    std::deque<Pkt6Ptr> queue6_;
 };
 
 }; // namespace bundy::dhcp
@@ -52,6 +52,13 @@ VendorOptionDefContainers LibDHCP::vendor4_defs_;
 
 VendorOptionDefContainers LibDHCP::vendor6_defs_;
 
+namespace {
+
+// Empty container, used for the option spaces without standard definitions.
+const OptionDefContainer no_option_defs;
+
+}
+
 // Those two vendor classes are used for cable modems:
 
 /// DOCSIS3.0 compatible cable modem
@@ -216,13 +223,11 @@ size_t LibDHCP::unpackOptions6(const OptionBuffer& buf,
     size_t length = buf.size();
 
     // Get the list of standard option definitions.
-    OptionDefContainer option_defs;
-    if (option_space == "dhcp6") {
-        option_defs = LibDHCP::getOptionDefs(Option::V6);
-    }
-    // @todo Once we implement other option spaces we should add else clause
-    // here and gather option definitions for them. For now leaving option_defs
-    // empty will imply creation of generic Option.
+    // @todo Once we implement other option spaces we should gather option
+    // definitions for them. For now the other spaces have no definitions,
+    // which implies creation of generic Option.
+    const OptionDefContainer& option_defs = (option_space == "dhcp6") ?
+        LibDHCP::getOptionDefs(Option::V6) : no_option_defs;
 
     // Get the search index #1. It allows to search for option definitions
     // using option code.
@@ -313,20 +318,22 @@ size_t LibDHCP::unpackOptions6(const OptionBuffer& buf,
 size_t LibDHCP::unpackOptions4(const OptionBuffer& buf,
                                const std::string& option_space,
                                bundy::dhcp::OptionCollection& options) {
-    size_t offset = 0;
-
-    // Get the list of stdandard option definitions.
-    OptionDefContainer option_defs;
-    if (option_space == "dhcp4") {
-        option_defs = LibDHCP::getOptionDefs(Option::V4);
+    OptionPositions4 positions;
+    size_t offset = scanOptions4(buf, positions);
+
+    for (OptionPositions4::const_iterator pos = positions.begin();
+         pos != positions.end(); ++pos) {
+        OptionBufferConstIter data = buf.begin() + pos->offset_;
+        options.insert(std::make_pair(pos->type_,
+                                      unpackOption4(option_space, pos->type_,
+                                                    data, data + pos->len_)));
     }
-    // @todo Once we implement other option spaces we should add else clause
-    // here and gather option definitions for them. For now leaving option_defs
-    // empty will imply creation of generic Option.
+    return (offset);
+}
 
-    // Get the search index #1. It allows to search for option definitions
-    // using option code.
-    const OptionDefContainerTypeIndex& idx = option_defs.get<1>();
+size_t LibDHCP::scanOptions4(const OptionBuffer& buf,
+                             OptionPositions4& positions) {
+    size_t offset = 0;
 
     // The buffer being read comprises a set of options, each starting with
     // a one-byte type code and a one-byte length field.
@@ -356,43 +363,55 @@ size_t LibDHCP::unpackOptions4(const OptionBuffer& buf,
                       << "-byte long buffer.");
         }
 
-        // Get all definitions with the particular option code. Note that option code
-        // is non-unique within this container however at this point we expect
-        // to get one option definition with the particular code. If more are
-        // returned we report an error.
-        const OptionDefContainerTypeRange& range = idx.equal_range(opt_type);
-        // Get the number of returned option definitions for the option code.
-        size_t num_defs = distance(range.first, range.second);
-
-        OptionPtr opt;
-        if (num_defs > 1) {
-            // Multiple options of the same code are not supported right now!
-            bundy_throw(bundy::Unexpected, "Internal error: multiple option definitions"
-                      " for option type " << static_cast<int>(opt_type)
-                      << " returned. Currently it is not supported to initialize"
-                      << " multiple option definitions for the same option code."
-                      << " This will be supported once support for option spaces"
-                      << " is implemented");
-        } else if (num_defs == 0) {
-            opt = OptionPtr(new Option(Option::V4, opt_type,
-                                       buf.begin() + offset,
-                                       buf.begin() + offset + opt_len));
-        } else {
-            // The option definition has been found. Use it to create
-            // the option instance from the provided buffer chunk.
-            const OptionDefinitionPtr& def = *(range.first);
-            assert(def);
-            opt = def->optionFactory(Option::V4, opt_type,
-                                     buf.begin() + offset,
-                                     buf.begin() + offset + opt_len);
-        }
+        OptionPosition4 position;
+        position.type_ = opt_type;
+        position.len_ = opt_len;
+        position.offset_ = offset;
+        positions.push_back(position);
 
-        options.insert(std::make_pair(opt_type, opt));
         offset += opt_len;
     }
     return (offset);
 }
 
+OptionPtr LibDHCP::unpackOption4(const std::string& option_space,
+                                 uint8_t type, OptionBufferConstIter begin,
+                                 OptionBufferConstIter end) {
+    // Get the list of stdandard option definitions.
+    // @todo Once we implement other option spaces we should gather option
+    // definitions for them. For now the other spaces have no definitions,
+    // which implies creation of generic Option.
+    const OptionDefContainer& option_defs = (option_space == "dhcp4") ?
+        LibDHCP::getOptionDefs(Option::V4) : no_option_defs;
+
+    // Get all definitions with the particular option code. Note that option code
+    // is non-unique within this container however at this point we expect
+    // to get one option definition with the particular code. If more are
+    // returned we report an error.
+    const OptionDefContainerTypeRange& range =
+        option_defs.get<1>().equal_range(type);
+    // Get the number of returned option definitions for the option code.
+    size_t num_defs = distance(range.first, range.second);
+
+    if (num_defs > 1) {
+        // Multiple options of the same code are not supported right now!
+        bundy_throw(bundy::Unexpected, "Internal error: multiple option definitions"
+                  " for option type " << static_cast<int>(type)
+                  << " returned. Currently it is not supported to initialize"
+                  << " multiple option definitions for the same option code."
+                  << " This will be supported once support for option spaces"
+                  << " is implemented");
+    } else if (num_defs == 0) {
+        return (OptionPtr(new Option(Option::V4, type, begin, end)));
+    }
+
+    // The option definition has been found. Use it to create
+    // the option instance from the provided buffer chunk.
+    const OptionDefinitionPtr& def = *(range.first);
+    assert(def);
+    return (def->optionFactory(Option::V4, type, begin, end));
+}
+
 size_t LibDHCP::unpackVendorOptions6(const uint32_t vendor_id,
                                      const OptionBuffer& buf,
                                      bundy::dhcp::OptionCollection& options) {
@@ -587,6 +606,25 @@ LibDHCP::packOptions(bundy::util::OutputBuffer& buf,
     }
 }
 
+void
+LibDHCP::packOptions(bundy::util::OutputBuffer& buf,
+                     const OptionCollection& options,
+                     const PackedOptionCollection& packed) {
+    if (packed.empty()) {
+        packOptions(buf, options);
+        return;
+    }
+    for (OptionCollection::const_iterator it = options.begin();
+         it != options.end(); ++it) {
+        PackedOptionCollection::const_iterator data = packed.find(it->second);
+        if ((data != packed.end()) && !data->second->empty()) {
+            buf.writeData(&(*data->second)[0], data->second->size());
+        } else {
+            it->second->pack(buf);
+        }
+    }
+}
+
 void LibDHCP::OptionFactoryRegister(Option::Universe u,
                                     uint16_t opt_type,
                                     Option::Factory* factory) {
@@ -20,10 +20,28 @@
 #include <util/buffer.h>
 
 #include <iostream>
+#include <vector>
+
+#include <stdint.h>
 
 namespace bundy {
 namespace dhcp {
 
+/// @brief Position of a DHCPv4 option in a buffer of options.
+struct OptionPosition4 {
+    /// @brief Option code.
+    uint8_t type_;
+
+    /// @brief Length of the option data.
+    uint8_t len_;
+
+    /// @brief Offset of the option data in the buffer.
+    size_t offset_;
+};
+
+/// @brief Positions of the options of a buffer, in the order of the buffer.
+typedef std::vector<OptionPosition4> OptionPositions4;
+
 class LibDHCP {
 
 public:
@@ -113,6 +131,19 @@ public:
     static void packOptions(bundy::util::OutputBuffer& buf,
                             const bundy::dhcp::OptionCollection& options);
 
+    /// @brief Stores options in a buffer, copying those packed in advance.
+    ///
+    /// This is the same as the other version of this method, except that
+    /// the options found in @c packed are not packed again: their on-wire
+    /// format is copied to the buffer.
+    ///
+    /// @param buf output buffer (assembled options will be stored here)
+    /// @param options collection of options to store to
+    /// @param packed options of the collection packed in advance
+    static void packOptions(bundy::util::OutputBuffer& buf,
+                            const bundy::dhcp::OptionCollection& options,
+                            const bundy::dhcp::PackedOptionCollection& packed);
+
     /// @brief Parses provided buffer as DHCPv4 options and creates Option objects.
     ///
     /// Parses provided buffer and stores created Option objects
@@ -127,6 +158,36 @@ public:
                                  const std::string& option_space,
                                  bundy::dhcp::OptionCollection& options);
 
+    /// @brief Finds the DHCPv4 options of a buffer without parsing them.
+    ///
+    /// This is the first half of @c unpackOptions4: the option codes and
+    /// lengths are checked and the position of each option is recorded,
+    /// but no Option object is created.  The PAD options are skipped and
+    /// the scan stops at the END option.
+    ///
+    /// @param buf Buffer to be scanned.
+    /// @param positions Positions of the options are appended here.
+    /// @throw OutOfRange if an option is truncated.
+    /// @return offset to the first byte after last scanned option
+    static size_t scanOptions4(const OptionBuffer& buf,
+                               OptionPositions4& positions);
+
+    /// @brief Creates one DHCPv4 option from its data.
+    ///
+    /// This is the second half of @c unpackOptions4.  The option is created
+    /// with its standard definition if there is one, as a generic option
+    /// otherwise.
+    ///
+    /// @param option_space A name of the option space which holds definitions
+    /// of to be used to parse the option.
+    /// @param type Option code.
+    /// @param begin Beginning of the option data.
+    /// @param end End of the option data.
+    /// @throw bundy::Exception if the data doesn't match the definition.
+    static OptionPtr unpackOption4(const std::string& option_space,
+                                   uint8_t type, OptionBufferConstIter begin,
+                                   OptionBufferConstIter end);
+
     /// @brief Parses provided buffer as DHCPv6 options and creates Option objects.
     ///
     /// Parses provided buffer and stores created Option objects in options
@@ -116,7 +116,7 @@ Option::packHeader(bundy::util::OutputBuffer& buf) {
 
 void
 Option::packOptions(bundy::util::OutputBuffer& buf) {
-    LibDHCP::packOptions(buf, options_);
+    LibDHCP::packOptions(buf, options_, prepacked_options_);
 }
 
 void Option::unpack(OptionBufferConstIter begin,
@@ -187,6 +187,7 @@ OptionPtr Option::getOption(uint16_t opt_type) {
 bool Option::delOption(uint16_t opt_type) {
     bundy::dhcp::OptionCollection::iterator x = options_.find(opt_type);
     if ( x != options_.end() ) {
+        prepacked_options_.erase(x->second);
         options_.erase(x);
         return true; // delete successful
     }
@@ -241,6 +242,13 @@ void Option::addOption(OptionPtr opt) {
     options_.insert(make_pair(opt->getType(), opt));
 }
 
+void Option::addOption(const OptionPtr& opt, const OptionBufferPtr& packed) {
+    addOption(opt);
+    if (packed) {
+        prepacked_options_[opt] = packed;
+    }
+}
+
 uint8_t Option::getUint8() {
     if (data_.size() < sizeof(uint8_t) ) {
         bundy_throw(OutOfRange, "Attempt to read uint8 from option " << type_
@@ -48,6 +48,9 @@ typedef boost::shared_ptr<Option> OptionPtr;
 /// A collection of DHCP (v4 or v6) options
 typedef std::multimap<unsigned int, OptionPtr> OptionCollection;
 
+/// Options packed in advance, in on-wire format, by option
+typedef std::map<OptionPtr, OptionBufferPtr> PackedOptionCollection;
+
 /// @brief This type describes a callback function to parse options from buffer.
 ///
 /// @note The last two parameters should be specified in the callback function
@@ -247,6 +250,18 @@ public:
     /// @param opt shared pointer to a suboption that is going to be added.
     void addOption(OptionPtr opt);
 
+    /// @brief Adds a sub-option packed in advance.
+    ///
+    /// The sub-option is added as by the other version of this method,
+    /// but @ref pack copies @c packed instead of packing it again.  This
+    /// is used for the options of the configuration, which are packed
+    /// once (see @c Subnet::packOptions()): the sub-option must not be
+    /// modified afterwards.
+    ///
+    /// @param opt shared pointer to a suboption that is going to be added.
+    /// @param packed the suboption in on-wire format, may be null.
+    void addOption(const OptionPtr& opt, const OptionBufferPtr& packed);
+
     /// Returns shared_ptr to suboption of specific type
     ///
     /// @param type type of requested suboption
@@ -431,6 +446,9 @@ protected:
     /// collection for storing suboptions
     OptionCollection options_;
 
+    /// suboptions of options_ packed in advance
+    PackedOptionCollection prepacked_options_;
+
     /// Name of the option space being encapsulated by this option.
     std::string encapsulated_space_;
 
@@ -49,7 +49,8 @@ Pkt4::Pkt4(uint8_t msg_type, uint32_t transid)
       ciaddr_(DEFAULT_ADDRESS),
       yiaddr_(DEFAULT_ADDRESS),
       siaddr_(DEFAULT_ADDRESS),
-      giaddr_(DEFAULT_ADDRESS)
+      giaddr_(DEFAULT_ADDRESS),
+      lazy_options_(false)
 {
     memset(sname_, 0, MAX_SNAME_LEN);
     memset(file_, 0, MAX_FILE_LEN);
@@ -74,7 +75,8 @@ Pkt4::Pkt4(const uint8_t* data, size_t len)
       ciaddr_(DEFAULT_ADDRESS),
       yiaddr_(DEFAULT_ADDRESS),
       siaddr_(DEFAULT_ADDRESS),
-      giaddr_(DEFAULT_ADDRESS)
+      giaddr_(DEFAULT_ADDRESS),
+      lazy_options_(false)
 {
     if (len < DHCPV4_PKT_HDR_LEN) {
         bundy_throw(OutOfRange, "Truncated DHCPv4 packet (len=" << len
@@ -93,12 +95,17 @@ size_t
 Pkt4::len() {
     size_t length = DHCPV4_PKT_HDR_LEN; // DHCPv4 header
 
+    unpackLazyOptions();
+
     // ... and sum of lengths of all options
     for (OptionCollection::const_iterator it = options_.begin();
          it != options_.end();
          ++it) {
         length += (*it).second->len();
     }
+    if (packed_options_) {
+        length += packed_options_->size();
+    }
 
     return (length);
 }
@@ -152,7 +159,12 @@ Pkt4::pack() {
         // write DHCP magic cookie
         buffer_out_.writeUint32(DHCP_OPTIONS_COOKIE);
 
-        LibDHCP::packOptions(buffer_out_, options_);
+        unpackLazyOptions();
+        LibDHCP::packOptions(buffer_out_, options_, prepacked_options_);
+        if (packed_options_ && !packed_options_->empty()) {
+            buffer_out_.writeData(&(*packed_options_)[0],
+                                  packed_options_->size());
+        }
 
         // add END option that indicates end of options
         // (End option is very simple, just a 255 octet)
@@ -219,7 +231,17 @@ Pkt4::unpack() {
     // Use readVector because a function which parses option requires
     // a vector as an input.
     buffer_in.readVector(opts_buffer, opts_len);
-    if (callback_.empty()) {
+    if (callback_.empty() && lazy_options_) {
+        // Only locate the options, they are created on first access.
+        lazy_types_.reset();
+        option_positions_.clear();
+        options_buffer_.swap(opts_buffer);
+        LibDHCP::scanOptions4(options_buffer_, option_positions_);
+        for (OptionPositions4::const_iterator pos = option_positions_.begin();
+             pos != option_positions_.end(); ++pos) {
+            lazy_types_.set(pos->type_);
+        }
+    } else if (callback_.empty()) {
         LibDHCP::unpackOptions4(opts_buffer, "dhcp4", options_);
     } else {
         // The last two arguments are set to NULL because they are
@@ -284,6 +306,7 @@ Pkt4::toText() {
         << ":" << remote_port_ << ", msgtype=" << static_cast<int>(getType())
         << ", transid=0x" << hex << transid_ << dec << endl;
 
+    unpackLazyOptions();
     for (bundy::dhcp::OptionCollection::iterator opt=options_.begin();
          opt != options_.end();
          ++opt) {
@@ -442,8 +465,17 @@ Pkt4::addOption(boost::shared_ptr<Option> opt) {
     options_.insert(pair<int, boost::shared_ptr<Option> >(opt->getType(), opt));
 }
 
+void
+Pkt4::addOption(const OptionPtr& opt, const OptionBufferPtr& packed) {
+    addOption(opt);
+    if (packed) {
+        prepacked_options_[opt] = packed;
+    }
+}
+
 boost::shared_ptr<bundy::dhcp::Option>
 Pkt4::getOption(uint8_t type) const {
+    unpackLazyOptions(type);
     OptionCollection::const_iterator x = options_.find(type);
     if (x != options_.end()) {
         return (*x).second;
@@ -451,16 +483,59 @@ Pkt4::getOption(uint8_t type) const {
     return boost::shared_ptr<bundy::dhcp::Option>(); // NULL
 }
 
+const OptionCollection&
+Pkt4::getOptions() const {
+    unpackLazyOptions();
+    return (options_);
+}
+
 bool
 Pkt4::delOption(uint8_t type) {
+    unpackLazyOptions(type);
     bundy::dhcp::OptionCollection::iterator x = options_.find(type);
     if (x != options_.end()) {
+        prepacked_options_.erase(x->second);
         options_.erase(x);
         return (true); // delete successful
     }
     return (false); // can't find option to be deleted
 }
 
+void
+Pkt4::unpackLazyOptions(uint8_t type) const {
+    if (!lazy_types_.test(type)) {
+        return;
+    }
+    lazy_types_.reset(type);
+
+    // All the options of the type are created at once, so they are kept in
+    // the order of the packet.
+    for (OptionPositions4::const_iterator pos = option_positions_.begin();
+         pos != option_positions_.end(); ++pos) {
+        if (pos->type_ != type) {
+            continue;
+        }
+        OptionBufferConstIter begin = options_buffer_.begin() + pos->offset_;
+        OptionBufferConstIter end = begin + pos->len_;
+        OptionPtr opt;
+        try {
+            opt = LibDHCP::unpackOption4("dhcp4", type, begin, end);
+        } catch (const bundy::Exception&) {
+            // The packet was accepted already, keep the raw data.
+            opt.reset(new Option(Option::V4, type, begin, end));
+        }
+        options_.insert(std::make_pair(type, opt));
+    }
+}
+
+void
+Pkt4::unpackLazyOptions() const {
+    for (OptionPositions4::const_iterator pos = option_positions_.begin();
+         lazy_types_.any() && (pos != option_positions_.end()); ++pos) {
+        unpackLazyOptions(pos->type_);
+    }
+}
+
 void
 Pkt4::updateTimestamp() {
     timestamp_ = boost::posix_time::microsec_clock::universal_time();
@@ -21,10 +21,12 @@
 #include <dhcp/option.h>
 #include <dhcp/hwaddr.h>
 #include <dhcp/classify.h>
+#include <dhcp/libdhcp++.h>
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include <bitset>
 #include <iostream>
 #include <vector>
 #include <set>
@@ -85,7 +87,9 @@ public:
     /// Parses received packet, stored in on-wire format in bufferIn_.
     ///
     /// Will create a collection of option objects that will
-    /// be stored in options_ container.
+    /// be stored in options_ container.  In the lazy mode (see
+    /// @ref setLazyOptions) the options are only located, they are
+    /// created when first accessed.
     ///
     /// Method with throw exception if packet parsing fails.
     void unpack();
@@ -326,6 +330,19 @@ public:
     void
     addOption(boost::shared_ptr<Option> opt);
 
+    /// @brief Add an option packed in advance.
+    ///
+    /// The option is added as by the other version of this method, but
+    /// @ref pack copies @c packed instead of packing the option again.
+    /// This is used for the options of the configuration, which are packed
+    /// once (see @c Subnet::packOptions()): the option must not be
+    /// modified afterwards.
+    ///
+    /// @param opt option to be added
+    /// @param packed the option in on-wire format, may be null
+    void
+    addOption(const OptionPtr& opt, const OptionBufferPtr& packed);
+
     /// @brief Returns an option of specified type.
     ///
     /// @return returns option of requested type (or NULL)
@@ -333,11 +350,40 @@ public:
     boost::shared_ptr<Option>
     getOption(uint8_t opt_type) const;
 
+    /// @brief Returns all the options of the packet.
+    ///
+    /// The options of the block set with @ref setPackedOptions are not
+    /// included.
+    ///
+    /// @return The options, by type.
+    const bundy::dhcp::OptionCollection& getOptions() const;
+
     /// @brief Deletes specified option
     /// @param type option type to be deleted
     /// @return true if anything was deleted, false otherwise
     bool delOption(uint8_t type);
 
+    /// @brief Sets a block of options already in the on-wire format.
+    ///
+    /// The block is written by @ref pack after the options of the packet,
+    /// as is: the options it holds are not visible to @ref getOption.  A
+    /// server can build the options it sends to a client once and copy
+    /// them to each response.  The caller makes sure that the block and
+    /// the options of the packet don't hold options of the same type.
+    ///
+    /// @param options The options, or an empty pointer to remove them.
+    void setPackedOptions(const OptionBufferPtr& options) {
+        packed_options_ = options;
+    }
+
+    /// @brief Returns the block of options in the on-wire format.
+    ///
+    /// @return The options set with @ref setPackedOptions, or an empty
+    ///         pointer.
+    const OptionBufferPtr& getPackedOptions() const {
+        return (packed_options_);
+    }
+
     /// @brief Returns interface name.
     ///
     /// Returns interface name over which packet was received or is
@@ -512,6 +558,34 @@ public:
         callback_ = callback;
     }
 
+    /// @brief Enables or disables the lazy parsing of the options.
+    ///
+    /// In the lazy mode, @ref unpack only records the position of each
+    /// option in the packet, and the Option objects of a given type are
+    /// created by the first @ref getOption, @ref addOption or
+    /// @ref delOption of this type.  The remaining options are created
+    /// before the packet is packed or printed.  A server which looks at a
+    /// few options only doesn't create the others, e.g. the vendor
+    /// sub-options sent by the DOCSIS devices.
+    ///
+    /// The lengths of the options are checked by @ref unpack, but their
+    /// content is checked when they are created: an option which doesn't
+    /// match its definition is kept as a generic option holding the raw
+    /// data, rather than failing the caller.
+    ///
+    /// The mode doesn't apply when a callback parses the options.  It must
+    /// be set before @ref unpack, it is disabled by default.
+    ///
+    /// @param lazy true to create the options on first access.
+    void setLazyOptions(bool lazy) {
+        lazy_options_ = lazy;
+    }
+
+    /// @brief Checks if the options are parsed lazily.
+    bool getLazyOptions() const {
+        return (lazy_options_);
+    }
+
     /// @brief Update packet timestamp.
     ///
     /// Updates packet timestamp. This method is invoked
@@ -600,6 +674,15 @@ private:
                          const std::vector<uint8_t>& mac_addr,
                          HWAddrPtr& hw_addr);
 
+    /// @brief Creates the options of a type left unparsed by a lazy
+    ///        unpack.
+    ///
+    /// @param type option type
+    void unpackLazyOptions(uint8_t type) const;
+
+    /// @brief Creates all the options left unparsed by a lazy unpack.
+    void unpackLazyOptions() const;
+
 protected:
 
     /// converts DHCP message type to BOOTP op type
@@ -693,7 +776,27 @@ protected:
     /// behavior must be taken into consideration before making
     /// changes to this member such as access scope restriction or
     /// data format change etc.
-    bundy::dhcp::OptionCollection options_;
+    ///
+    /// In the lazy mode, the options not accessed yet are missing.
+    mutable bundy::dhcp::OptionCollection options_;
+
+    /// Options of the packet, as received (lazy mode).
+    OptionBuffer options_buffer_;
+
+    /// Positions of the options in @c options_buffer_ (lazy mode).
+    OptionPositions4 option_positions_;
+
+    /// Types of the options not created yet (lazy mode).
+    mutable std::bitset<256> lazy_types_;
+
+    /// Flag which indicates if the options are parsed lazily.
+    bool lazy_options_;
+
+    /// Options in the on-wire format, written after @c options_.
+    OptionBufferPtr packed_options_;
+
+    /// Options of @c options_ packed in advance.
+    PackedOptionCollection prepacked_options_;
 
     /// packet timestamp
     boost::posix_time::ptime timestamp_;
@@ -253,7 +253,7 @@ Pkt6::packUDP() {
         buffer_out_.writeUint8( (transid_) & 0xff );
 
         // the rest are options
-        LibDHCP::packOptions(buffer_out_, options_);
+        LibDHCP::packOptions(buffer_out_, options_, prepacked_options_);
     }
     catch (const Exception& e) {
        // An exception is thrown and message will be written to Logger
@@ -493,10 +493,19 @@ Pkt6::addOption(const OptionPtr& opt) {
     options_.insert(pair<int, boost::shared_ptr<Option> >(opt->getType(), opt));
 }
 
+void
+Pkt6::addOption(const OptionPtr& opt, const OptionBufferPtr& packed) {
+    addOption(opt);
+    if (packed) {
+        prepacked_options_[opt] = packed;
+    }
+}
+
 bool
 Pkt6::delOption(uint16_t type) {
     bundy::dhcp::OptionCollection::iterator x = options_.find(type);
     if (x!=options_.end()) {
+        prepacked_options_.erase(x->second);
         options_.erase(x);
         return (true); // delete successful
     }
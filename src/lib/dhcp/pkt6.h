@@ -198,6 +198,18 @@ public:
     /// @param opt option to be added.
     void addOption(const OptionPtr& opt);
 
+    /// @brief Adds an option packed in advance to this packet.
+    ///
+    /// The option is added as by the other version of this method, but
+    /// @ref pack copies @c packed instead of packing the option again.
+    /// This is used for the options of the configuration, which are packed
+    /// once (see @c Subnet::packOptions()): the option must not be
+    /// modified afterwards.
+    ///
+    /// @param opt option to be added.
+    /// @param packed the option in on-wire format, may be null.
+    void addOption(const OptionPtr& opt, const OptionBufferPtr& packed);
+
     /// @brief Returns the first option of specified type.
     ///
     /// Returns the first option of specified type. Note that in DHCPv6 several
@@ -355,6 +367,9 @@ public:
     /// data format change etc.
     bundy::dhcp::OptionCollection options_;
 
+    /// options of options_ packed in advance
+    bundy::dhcp::PackedOptionCollection prepacked_options_;
+
     /// @brief Update packet timestamp.
     ///
     /// Updates packet timestamp. This method is invoked
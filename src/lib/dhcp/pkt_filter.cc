@@ -22,6 +22,17 @@
 namespace bundy {
 namespace dhcp {
 
+size_t
+PktFilter::receiveBatch(const Iface& iface, const SocketInfo& socket_info,
+                        std::vector<Pkt4Ptr>& pkts, size_t) {
+    Pkt4Ptr pkt = receive(iface, socket_info);
+    if (!pkt) {
+        return (0);
+    }
+    pkts.push_back(pkt);
+    return (1);
+}
+
 int
 PktFilter::openFallbackSocket(const bundy::asiolink::IOAddress& addr,
                               const uint16_t port) {
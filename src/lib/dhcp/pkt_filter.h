@@ -101,6 +101,25 @@ public:
     virtual Pkt4Ptr receive(const Iface& iface,
                             const SocketInfo& socket_info) = 0;
 
+    /// @brief Receive the packets waiting on a socket.
+    ///
+    /// This method is called when the socket is readable, so at least one
+    /// packet is expected.  It reads the packets without blocking, up to
+    /// the specified count, so the packets arriving together are handled
+    /// with a single wakeup of the receiver.  The default implementation
+    /// receives one packet with @c receive.
+    ///
+    /// @param iface interface
+    /// @param socket_info structure holding socket information
+    /// @param [out] pkts The received packets are appended here.
+    /// @param max_count Maximum number of packets to receive.
+    ///
+    /// @return Number of the packets appended.
+    virtual size_t receiveBatch(const Iface& iface,
+                                const SocketInfo& socket_info,
+                                std::vector<Pkt4Ptr>& pkts,
+                                size_t max_count);
+
     /// @brief Send packet over specified socket.
     ///
     /// @param iface interface to be used to send packet
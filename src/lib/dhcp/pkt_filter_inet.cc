@@ -135,8 +135,77 @@ PktFilterInet::receive(const Iface& iface, const SocketInfo& socket_info) {
         bundy_throw(SocketReadError, "failed to receive UDP4 data");
     }
 
+    return (createPacket(iface, socket_info, buf, result, from_addr, m));
+}
+
+size_t
+PktFilterInet::receiveBatch(const Iface& iface, const SocketInfo& socket_info,
+                            std::vector<Pkt4Ptr>& pkts, size_t max_count) {
+#if defined (OS_LINUX)
+    if (max_count == 0) {
+        return (0);
+    }
+
+    batch_buf_.resize(max_count * IfaceMgr::RCVBUFSIZE);
+    batch_control_buf_.assign(max_count * control_buf_len_, 0);
+    std::vector<struct sockaddr_in> from_addrs(max_count);
+    std::vector<struct iovec> vs(max_count);
+    std::vector<struct mmsghdr> msgs(max_count);
+    memset(&from_addrs[0], 0, max_count * sizeof(from_addrs[0]));
+    memset(&msgs[0], 0, max_count * sizeof(msgs[0]));
+
+    // One message header for each packet, as in receive().
+    for (size_t i = 0; i < max_count; ++i) {
+        vs[i].iov_base = &batch_buf_[i * IfaceMgr::RCVBUFSIZE];
+        vs[i].iov_len = IfaceMgr::RCVBUFSIZE;
+        struct msghdr& m = msgs[i].msg_hdr;
+        m.msg_name = &from_addrs[i];
+        m.msg_namelen = sizeof(from_addrs[i]);
+        m.msg_iov = &vs[i];
+        m.msg_iovlen = 1;
+        m.msg_control = &batch_control_buf_[i * control_buf_len_];
+        m.msg_controllen = control_buf_len_;
+    }
+
+    // Don't wait for the batch to fill up, take what is there.
+    int result = recvmmsg(socket_info.sockfd_, &msgs[0], max_count,
+                          MSG_DONTWAIT, NULL);
+    if (result < 0) {
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+            return (0);
+        }
+        bundy_throw(SocketReadError, "failed to receive UDP4 data");
+    }
+
+    size_t count = 0;
+    std::string error;
+    for (int i = 0; i < result; ++i) {
+        try {
+            pkts.push_back(createPacket(iface, socket_info, &batch_buf_[i *
+                                        IfaceMgr::RCVBUFSIZE],
+                                        msgs[i].msg_len, from_addrs[i],
+                                        msgs[i].msg_hdr));
+            ++count;
+        } catch (const std::exception& ex) {
+            error = ex.what();
+        }
+    }
+    if ((count == 0) && !error.empty()) {
+        bundy_throw(SocketReadError, error);
+    }
+    return (count);
+#else
+    return (PktFilter::receiveBatch(iface, socket_info, pkts, max_count));
+#endif
+}
+
+Pkt4Ptr
+PktFilterInet::createPacket(const Iface& iface, const SocketInfo& socket_info,
+                            const uint8_t* buf, size_t len,
+                            const struct sockaddr_in& from_addr,
+                            struct msghdr& m) {
     // We have all data let's create Pkt4 object.
-    Pkt4Ptr pkt = Pkt4Ptr(new Pkt4(buf, result));
+    Pkt4Ptr pkt = Pkt4Ptr(new Pkt4(buf, len));
 
     pkt->updateTimestamp();
 
@@ -18,6 +18,9 @@
 #include <dhcp/pkt_filter.h>
 #include <boost/scoped_array.hpp>
 
+#include <netinet/in.h>
+#include <sys/socket.h>
+
 namespace bundy {
 namespace dhcp {
 
@@ -73,6 +76,25 @@ public:
     /// message parsing fails.
     virtual Pkt4Ptr receive(const Iface& iface, const SocketInfo& socket_info);
 
+    /// @brief Receive the packets waiting on a socket.
+    ///
+    /// On Linux, the packets are read with a single recvmmsg() call.  A
+    /// packet which can't be parsed is dropped, the exception is only
+    /// thrown if no packet could be received.
+    ///
+    /// @param iface interface
+    /// @param socket_info structure holding socket information
+    /// @param [out] pkts The received packets are appended here.
+    /// @param max_count Maximum number of packets to receive.
+    ///
+    /// @return Number of the packets appended.
+    /// @throw bundy::dhcp::SocketReadError if an error occurs during reception
+    /// of the packets.
+    virtual size_t receiveBatch(const Iface& iface,
+                                const SocketInfo& socket_info,
+                                std::vector<Pkt4Ptr>& pkts,
+                                size_t max_count);
+
     /// @brief Send packet over specified socket.
     ///
     /// @param iface interface to be used to send packet
@@ -86,10 +108,29 @@ public:
                      const Pkt4Ptr& pkt);
 
 private:
+    /// @brief Creates the packet object of received data.
+    ///
+    /// @param iface interface
+    /// @param socket_info structure holding socket information
+    /// @param buf received data
+    /// @param len length of the received data
+    /// @param from_addr sender of the data
+    /// @param m message header used to receive the data
+    ///
+    /// @return Received packet
+    Pkt4Ptr createPacket(const Iface& iface, const SocketInfo& socket_info,
+                         const uint8_t* buf, size_t len,
+                         const struct sockaddr_in& from_addr,
+                         struct msghdr& m);
+
     /// Length of the control_buf_ array.
     size_t control_buf_len_;
     /// Control buffer, used in transmission and reception.
     boost::scoped_array<char> control_buf_;
+    /// Data buffers of @c receiveBatch, used by the receiving thread only.
+    std::vector<uint8_t> batch_buf_;
+    /// Control buffers of @c receiveBatch.
+    std::vector<char> batch_control_buf_;
 };
 
 } // namespace bundy::dhcp
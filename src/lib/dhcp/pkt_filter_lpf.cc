@@ -163,6 +163,41 @@ PktFilterLPF::openSocket(const Iface& iface,
 
 Pkt4Ptr
 PktFilterLPF::receive(const Iface& iface, const SocketInfo& socket_info) {
+    drainFallbackSocket(socket_info);
+    return (readPacket(iface, socket_info, 0));
+}
+
+size_t
+PktFilterLPF::receiveBatch(const Iface& iface, const SocketInfo& socket_info,
+                           std::vector<Pkt4Ptr>& pkts, size_t max_count) {
+    drainFallbackSocket(socket_info);
+
+    // The first read doesn't block because the socket is readable, the
+    // next ones return when there is no data left.
+    size_t count = 0;
+    std::string error;
+    for (size_t i = 0; i < max_count; ++i) {
+        Pkt4Ptr pkt;
+        try {
+            pkt = readPacket(iface, socket_info, i == 0 ? 0 : MSG_DONTWAIT);
+        } catch (const std::exception& ex) {
+            error = ex.what();
+            continue;
+        }
+        if (!pkt) {
+            break;
+        }
+        pkts.push_back(pkt);
+        ++count;
+    }
+    if ((count == 0) && !error.empty()) {
+        bundy_throw(SocketReadError, error);
+    }
+    return (count);
+}
+
+void
+PktFilterLPF::drainFallbackSocket(const SocketInfo& socket_info) {
     uint8_t raw_buf[IfaceMgr::RCVBUFSIZE];
     // First let's get some data from the fallback socket. The data will be
     // discarded but we don't want the socket buffer to bloat. We get the
@@ -182,15 +217,20 @@ PktFilterLPF::receive(const Iface& iface, const SocketInfo& socket_info) {
     do {
         datalen = recv(socket_info.fallbackfd_, raw_buf, sizeof(raw_buf), 0);
     } while (datalen > 0);
+}
 
-    // Now that we finished getting data from the fallback socket, we
-    // have to get the data from the raw socket too.
-    int data_len = read(socket_info.sockfd_, raw_buf, sizeof(raw_buf));
-    // If negative value is returned by read(), it indicates that an
+Pkt4Ptr
+PktFilterLPF::readPacket(const Iface& iface, const SocketInfo& socket_info,
+                         int flags) {
+    uint8_t raw_buf[IfaceMgr::RCVBUFSIZE];
+    // Get the data from the raw socket, after the data from the fallback
+    // socket has been discarded.
+    int data_len = recv(socket_info.sockfd_, raw_buf, sizeof(raw_buf), flags);
+    // If negative value is returned by recv(), it indicates that an
     // error occured. If returned value is 0, no data was read from the
     // socket. In both cases something has gone wrong, because we expect
-    // that a chunk of data is there. We signal the lack of data by
-    // returing an empty packet.
+    // that a chunk of data is there (unless the read doesn't block). We
+    // signal the lack of data by returing an empty packet.
     if (data_len <= 0) {
         return Pkt4Ptr();
     }
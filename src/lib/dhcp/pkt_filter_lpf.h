@@ -64,6 +64,24 @@ public:
     /// @return Received packet
     virtual Pkt4Ptr receive(const Iface& iface, const SocketInfo& socket_info);
 
+    /// @brief Receive the packets waiting on a socket.
+    ///
+    /// The first packet is read as by @c receive, the next ones are read
+    /// without blocking until none is left.  A packet which can't be
+    /// decoded is dropped, the exception is only thrown if no packet could
+    /// be received.
+    ///
+    /// @param iface interface
+    /// @param socket_info structure holding socket information
+    /// @param [out] pkts The received packets are appended here.
+    /// @param max_count Maximum number of packets to receive.
+    ///
+    /// @return Number of the packets appended.
+    virtual size_t receiveBatch(const Iface& iface,
+                                const SocketInfo& socket_info,
+                                std::vector<Pkt4Ptr>& pkts,
+                                size_t max_count);
+
     /// @brief Send packet over specified socket.
     ///
     /// @param iface interface to be used to send packet
@@ -75,6 +93,22 @@ public:
     virtual int send(const Iface& iface, uint16_t sockfd,
                      const Pkt4Ptr& pkt);
 
+private:
+
+    /// @brief Discards the data received over the fallback socket.
+    ///
+    /// @param socket_info structure holding socket information
+    static void drainFallbackSocket(const SocketInfo& socket_info);
+
+    /// @brief Reads and decodes a packet from the raw socket.
+    ///
+    /// @param iface interface
+    /// @param socket_info structure holding socket information
+    /// @param flags Flags of the recv() call.
+    ///
+    /// @return Received packet, or NULL if no data could be read.
+    Pkt4Ptr readPacket(const Iface& iface, const SocketInfo& socket_info,
+                       int flags);
 };
 
 } // namespace bundy::dhcp
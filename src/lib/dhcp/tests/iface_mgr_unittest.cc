@@ -1153,13 +1153,59 @@ TEST_F(IfaceMgrTest, sendReceive4) {
 // the quick fix. We need a more elegant (config-based) solution to disable
 // this check on affected systems only. The ticket has been submited for this
 // work: http://bundy.bundy.org/ticket/2971
+//
+// On Linux, the closed descriptor is found when the wait times out, so the
+// timeout is short.
 #ifndef OS_BSD
-    EXPECT_THROW(ifacemgr->receive4(10), SocketReadError);
+    EXPECT_THROW(ifacemgr->receive4(0, 1000), SocketReadError);
 #endif
 
     EXPECT_THROW(ifacemgr->send(sendPkt), SocketWriteError);
 }
 
+// Checks that the packets waiting on a socket are all received, one by
+// one, even if they are read from the socket together.
+TEST_F(IfaceMgrTest, receiveBatch4) {
+    scoped_ptr<NakedIfaceMgr> ifacemgr(new NakedIfaceMgr());
+
+    IOAddress loAddr("127.0.0.1");
+    int socket1 = -1;
+    ASSERT_NO_THROW(
+        socket1 = ifacemgr->openSocket(LOOPBACK, loAddr,
+                                       DHCP4_SERVER_PORT + 10000);
+    );
+    ASSERT_GE(socket1, 0);
+
+    // More packets than read from the socket at once.
+    const int count = IfaceMgr::RECEIVE_BATCH_SIZE + 5;
+    for (int i = 0; i < count; ++i) {
+        Pkt4Ptr sendPkt(new Pkt4(DHCPDISCOVER, 1000 + i));
+        sendPkt->setLocalAddr(loAddr);
+        sendPkt->setLocalPort(DHCP4_SERVER_PORT + 10000 + 1);
+        sendPkt->setRemotePort(DHCP4_SERVER_PORT + 10000);
+        sendPkt->setRemoteAddr(loAddr);
+        sendPkt->setIface(string(LOOPBACK));
+        ASSERT_NO_THROW(sendPkt->pack());
+        ASSERT_NO_THROW(ifacemgr->send(sendPkt));
+    }
+
+    // The packets are received in order.
+    for (int i = 0; i < count; ++i) {
+        Pkt4Ptr rcvPkt;
+        ASSERT_NO_THROW(rcvPkt = ifacemgr->receive4(10));
+        ASSERT_TRUE(rcvPkt);
+        ASSERT_NO_THROW(rcvPkt->unpack());
+        EXPECT_EQ(1000 + i, rcvPkt->getTransid());
+    }
+
+    // Nothing more to receive.
+    Pkt4Ptr rcvPkt;
+    ASSERT_NO_THROW(rcvPkt = ifacemgr->receive4(0, 1000));
+    EXPECT_FALSE(rcvPkt);
+
+    ifacemgr->closeSockets();
+}
+
 // Verifies that it is possible to set custom packet filter object
 // to handle sockets opening and send/receive operation.
 TEST_F(IfaceMgrTest, setPacketFilter) {
@@ -537,6 +537,38 @@ TEST_F(LibDhcpTest, packOptions4) {
     EXPECT_EQ(0, memcmp(v4_opts, buf.getData(), sizeof(v4_opts)));
 }
 
+// Check that the options packed in advance are copied to the buffer.
+TEST_F(LibDhcpTest, packOptions4Prepacked) {
+    OptionPtr opt1(new Option(Option::V4, 12, OptionBuffer(3, 1)));
+    OptionPtr opt2(new Option(Option::V4, 14, OptionBuffer(2, 2)));
+    OptionPtr opt3(new Option(Option::V4, 60, OptionBuffer(1, 3)));
+
+    bundy::dhcp::OptionCollection opts;
+    opts.insert(make_pair(opt1->getType(), opt1));
+    opts.insert(make_pair(opt2->getType(), opt2));
+
+    // The on-wire format of the first option is not the one of the
+    // option, to see which one is used.
+    const uint8_t packed1[] = { 12, 3, 7, 7, 7 };
+    PackedOptionCollection packed;
+    packed[opt1].reset(new OptionBuffer(packed1, packed1 + sizeof(packed1)));
+    // This one is not in the collection.
+    packed[opt3].reset(new OptionBuffer(3, 3));
+
+    OutputBuffer buf(100);
+    ASSERT_NO_THROW(LibDHCP::packOptions(buf, opts, packed));
+    const uint8_t expected[] = { 12, 3, 7, 7, 7, 14, 2, 2, 2 };
+    ASSERT_EQ(sizeof(expected), buf.getLength());
+    EXPECT_EQ(0, memcmp(expected, buf.getData(), sizeof(expected)));
+
+    // Without them, the options are packed.
+    buf.clear();
+    ASSERT_NO_THROW(LibDHCP::packOptions(buf, opts,
+                                         PackedOptionCollection()));
+    ASSERT_EQ(sizeof(expected), buf.getLength());
+    EXPECT_EQ(1, static_cast<const uint8_t*>(buf.getData())[2]);
+}
+
 TEST_F(LibDhcpTest, unpackOptions4) {
 
     vector<uint8_t> v4packed(v4_opts, v4_opts + sizeof(v4_opts));
@@ -639,6 +671,42 @@ TEST_F(LibDhcpTest, unpackOptions4) {
 
 }
 
+// Checks that scanOptions4 finds the options without creating them, and that
+// unpackOption4 creates the options from the positions found.
+TEST_F(LibDhcpTest, scanOptions4) {
+    vector<uint8_t> v4packed(v4_opts, v4_opts + sizeof(v4_opts));
+    // The PAD options are skipped and the scan stops at the END option.
+    v4packed.insert(v4packed.begin(), DHO_PAD);
+    v4packed.push_back(DHO_END);
+    v4packed.push_back(DHO_HOST_NAME);
+
+    OptionPositions4 positions;
+    ASSERT_NO_THROW(LibDHCP::scanOptions4(v4packed, positions));
+    ASSERT_EQ(6, positions.size());
+    EXPECT_EQ(12, positions[0].type_);
+    EXPECT_EQ(3, positions[0].len_);
+    EXPECT_EQ(3, positions[0].offset_);
+    EXPECT_EQ(DHO_DHCP_AGENT_OPTIONS, positions[5].type_);
+
+    OptionPtr option = LibDHCP::unpackOption4("dhcp4", positions[0].type_,
+        v4packed.begin() + positions[0].offset_,
+        v4packed.begin() + positions[0].offset_ + positions[0].len_);
+    ASSERT_TRUE(boost::dynamic_pointer_cast<OptionString>(option));
+    EXPECT_EQ(0, memcmp(&option->getData()[0], v4_opts + 2, 3));
+
+    // Other option spaces have no definitions.
+    option = LibDHCP::unpackOption4("foo", positions[0].type_,
+        v4packed.begin() + positions[0].offset_,
+        v4packed.begin() + positions[0].offset_ + positions[0].len_);
+    EXPECT_FALSE(boost::dynamic_pointer_cast<OptionString>(option));
+
+    // Truncated options.
+    v4packed.assign(v4_opts, v4_opts + 4);
+    EXPECT_THROW(LibDHCP::scanOptions4(v4packed, positions), OutOfRange);
+    v4packed.assign(1, DHO_HOST_NAME);
+    EXPECT_THROW(LibDHCP::scanOptions4(v4packed, positions), OutOfRange);
+}
+
 TEST_F(LibDhcpTest, isStandardOption4) {
     // Get all option codes that are not occupied by standard options.
     const uint16_t unassigned_codes[] = { 84, 96, 102, 103, 104, 105, 106, 107, 108,
@@ -398,6 +398,36 @@ TEST_F(OptionTest, v6_suboptions2) {
     EXPECT_NO_THROW(opt1.reset());
 }
 
+// Check that the suboptions packed in advance are not packed again.
+TEST_F(OptionTest, v6_suboptionsPrepacked) {
+    scoped_ptr<Option> opt1(new Option(Option::V6, 65535));
+    OptionPtr opt2(new Option(Option::V6, 13));
+    OptionPtr opt3(new Option(Option::V6, 7, OptionBuffer(2, 1)));
+    // Not the on-wire format of opt3, to see which one is used.
+    const uint8_t packed3[] = { 0, 7, 0, 2, 9, 9 };
+    opt1->addOption(opt2, OptionBufferPtr());
+    opt1->addOption(opt3, OptionBufferPtr(new OptionBuffer(packed3, packed3 +
+                                                           sizeof(packed3))));
+    EXPECT_EQ(opt3, opt1->getOption(7));
+
+    const uint8_t expected[] = {
+        0xff, 0xff, 0, 10,
+        0, 7, 0, 2, 9, 9,
+        0, 13, 0, 0
+    };
+    opt1->pack(outBuf_);
+    ASSERT_EQ(sizeof(expected), outBuf_.getLength());
+    EXPECT_EQ(0, memcmp(outBuf_.getData(), expected, sizeof(expected)));
+
+    // A suboption replaced is packed.
+    EXPECT_TRUE(opt1->delOption(7));
+    opt1->addOption(opt3);
+    outBuf_.clear();
+    opt1->pack(outBuf_);
+    ASSERT_EQ(sizeof(expected), outBuf_.getLength());
+    EXPECT_EQ(1, static_cast<const uint8_t*>(outBuf_.getData())[8]);
+}
+
 TEST_F(OptionTest, v6_addgetdel) {
     for (int i = 0; i < 128; i++) {
         buf_[i] = 100 + i;
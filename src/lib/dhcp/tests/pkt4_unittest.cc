@@ -18,6 +18,7 @@
 #include <dhcp/dhcp4.h>
 #include <dhcp/libdhcp++.h>
 #include <dhcp/docsis3_option_defs.h>
+#include <dhcp/option_int.h>
 #include <dhcp/option_string.h>
 #include <dhcp/pkt4.h>
 #include <exceptions/exceptions.h>
@@ -626,6 +627,85 @@ TEST_F(Pkt4Test, options) {
     EXPECT_NO_THROW(pkt.reset());
 }
 
+// This test verifies that a block of packed options is written after the
+// options of the packet.
+TEST_F(Pkt4Test, packedOptions) {
+    // The packet holds the options of v4_opts up to the message type.
+    Pkt4 pkt(DHCPOFFER, 0);
+    pkt.addOption(OptionPtr(new Option(Option::V4, 12,
+                                       OptionBuffer(v4_opts + 2,
+                                                    v4_opts + 5))));
+    pkt.addOption(OptionPtr(new Option(Option::V4, 14,
+                                       OptionBuffer(v4_opts + 7,
+                                                    v4_opts + 10))));
+
+    // The block holds the remaining ones.
+    OptionBufferPtr block(new OptionBuffer(v4_opts + 13,
+                                           v4_opts + sizeof(v4_opts)));
+    pkt.setPackedOptions(block);
+    EXPECT_EQ(block, pkt.getPackedOptions());
+
+    // The options of the block are not known individually.
+    EXPECT_FALSE(pkt.getOption(60));
+    EXPECT_EQ(3, pkt.getOptions().size());
+    EXPECT_EQ(static_cast<size_t>(Pkt4::DHCPV4_PKT_HDR_LEN) +
+              sizeof(v4_opts), pkt.len());
+
+    ASSERT_NO_THROW(pkt.pack());
+    const OutputBuffer& buf = pkt.getBuffer();
+    ASSERT_EQ(static_cast<size_t>(Pkt4::DHCPV4_PKT_HDR_LEN) +
+              sizeof(DHCP_OPTIONS_COOKIE) + sizeof(v4_opts) + 1,
+              buf.getLength());
+    const uint8_t* ptr = static_cast<const uint8_t*>(buf.getData()) +
+        Pkt4::DHCPV4_PKT_HDR_LEN + sizeof(DHCP_OPTIONS_COOKIE);
+    EXPECT_EQ(0, memcmp(ptr, v4_opts, sizeof(v4_opts)));
+    EXPECT_EQ(DHO_END, ptr[sizeof(v4_opts)]);
+
+    // The parsed packet holds all the options.
+    Pkt4 rcvd(static_cast<const uint8_t*>(buf.getData()), buf.getLength());
+    ASSERT_NO_THROW(rcvd.unpack());
+    EXPECT_TRUE(rcvd.getOption(12));
+    EXPECT_TRUE(rcvd.getOption(60));
+    EXPECT_TRUE(rcvd.getOption(254));
+
+    // The block can be removed.
+    pkt.setPackedOptions(OptionBufferPtr());
+    ASSERT_NO_THROW(pkt.pack());
+    EXPECT_EQ(static_cast<size_t>(Pkt4::DHCPV4_PKT_HDR_LEN) +
+              sizeof(DHCP_OPTIONS_COOKIE) + 13 + 1,
+              pkt.getBuffer().getLength());
+}
+
+// This test verifies that the options packed in advance are not packed
+// again.
+TEST_F(Pkt4Test, prepackedOptions) {
+    Pkt4 pkt(DHCPOFFER, 0);
+    OptionPtr opt(new Option(Option::V4, 12, OptionBuffer(3, 1)));
+    // Not the on-wire format of the option, to see which one is used.
+    const uint8_t data[] = { 12, 3, 7, 7, 7 };
+    pkt.addOption(opt, OptionBufferPtr(new OptionBuffer(data,
+                                                        data + sizeof(data))));
+    EXPECT_EQ(opt, pkt.getOption(12));
+    EXPECT_THROW(pkt.addOption(opt, OptionBufferPtr()), BadValue);
+
+    // The options are packed in the order of their codes.
+    const size_t offset = Pkt4::DHCPV4_PKT_HDR_LEN +
+        sizeof(DHCP_OPTIONS_COOKIE);
+    ASSERT_NO_THROW(pkt.pack());
+    ASSERT_EQ(offset + sizeof(data) + 3 + 1, pkt.getBuffer().getLength());
+    EXPECT_EQ(0, memcmp(static_cast<const uint8_t*>
+                        (pkt.getBuffer().getData()) + offset,
+                        data, sizeof(data)));
+
+    // An option replaced is packed.
+    EXPECT_TRUE(pkt.delOption(12));
+    pkt.addOption(OptionPtr(new Option(Option::V4, 12, OptionBuffer(3, 1))));
+    ASSERT_NO_THROW(pkt.pack());
+    ASSERT_EQ(offset + sizeof(data) + 3 + 1, pkt.getBuffer().getLength());
+    EXPECT_EQ(1, static_cast<const uint8_t*>
+              (pkt.getBuffer().getData())[offset + 2]);
+}
+
 // This test verifies that the options are unpacked from the packet correctly.
 TEST_F(Pkt4Test, unpackOptions) {
 
@@ -693,6 +773,92 @@ TEST_F(Pkt4Test, unpackOptionsWithCallback) {
 
 }
 
+// This test verifies that the options are created on first access in the
+// lazy mode, and that the packet is the same as with the normal parsing.
+TEST_F(Pkt4Test, unpackLazyOptions) {
+    vector<uint8_t> expectedFormat = generateTestPacket2();
+
+    expectedFormat.push_back(0x63);
+    expectedFormat.push_back(0x82);
+    expectedFormat.push_back(0x53);
+    expectedFormat.push_back(0x63);
+
+    for (int i = 0; i < sizeof(v4_opts); i++) {
+        expectedFormat.push_back(v4_opts[i]);
+    }
+
+    Pkt4Ptr pkt(new Pkt4(&expectedFormat[0], expectedFormat.size()));
+    EXPECT_FALSE(pkt->getLazyOptions());
+    pkt->setLazyOptions(true);
+    ASSERT_NO_THROW(pkt->unpack());
+    verifyParsedOptions(pkt);
+
+    // The same object is returned by each access.
+    EXPECT_EQ(pkt->getOption(12), pkt->getOption(12));
+    EXPECT_FALSE(pkt->getOption(13));
+
+    // Options not accessed yet are seen by addOption() and delOption().
+    pkt.reset(new Pkt4(&expectedFormat[0], expectedFormat.size()));
+    pkt->setLazyOptions(true);
+    ASSERT_NO_THROW(pkt->unpack());
+    OptionPtr option(new Option(Option::V4, 60));
+    EXPECT_THROW(pkt->addOption(option), BadValue);
+    EXPECT_TRUE(pkt->delOption(254));
+    EXPECT_FALSE(pkt->getOption(254));
+    EXPECT_NO_THROW(pkt->addOption(OptionPtr(new Option(Option::V4, 254))));
+
+    // Options not accessed yet are packed.
+    pkt.reset(new Pkt4(&expectedFormat[0], expectedFormat.size()));
+    pkt->setLazyOptions(true);
+    ASSERT_NO_THROW(pkt->unpack());
+    Pkt4Ptr eager(new Pkt4(&expectedFormat[0], expectedFormat.size()));
+    ASSERT_NO_THROW(eager->unpack());
+    EXPECT_EQ(eager->len(), pkt->len());
+    ASSERT_NO_THROW(pkt->pack());
+    ASSERT_NO_THROW(eager->pack());
+    ASSERT_EQ(eager->getBuffer().getLength(), pkt->getBuffer().getLength());
+    EXPECT_EQ(0, memcmp(eager->getBuffer().getData(),
+                        pkt->getBuffer().getData(),
+                        pkt->getBuffer().getLength()));
+}
+
+// This test verifies that the lazy mode keeps an option which doesn't match
+// its definition as a generic option, and still checks the option lengths.
+TEST_F(Pkt4Test, unpackLazyOptionsMalformed) {
+    vector<uint8_t> expectedFormat = generateTestPacket2();
+
+    expectedFormat.push_back(0x63);
+    expectedFormat.push_back(0x82);
+    expectedFormat.push_back(0x53);
+    expectedFormat.push_back(0x63);
+
+    const uint8_t opts[] = {
+        53, 1, 1,        // Message Type
+        51, 2, 0, 1,     // Lease Time, too short
+    };
+    expectedFormat.insert(expectedFormat.end(), opts, opts + sizeof(opts));
+
+    // The normal parsing fails.
+    Pkt4Ptr pkt(new Pkt4(&expectedFormat[0], expectedFormat.size()));
+    EXPECT_THROW(pkt->unpack(), bundy::Exception);
+
+    pkt.reset(new Pkt4(&expectedFormat[0], expectedFormat.size()));
+    pkt->setLazyOptions(true);
+    ASSERT_NO_THROW(pkt->unpack());
+    OptionPtr option = pkt->getOption(DHO_DHCP_LEASE_TIME);
+    ASSERT_TRUE(option);
+    EXPECT_FALSE(boost::dynamic_pointer_cast<OptionInt<uint32_t> >(option));
+    EXPECT_EQ(2, option->getData().size());
+
+    // A truncated option makes the unpack fail.
+    expectedFormat.push_back(DHO_HOST_NAME);
+    expectedFormat.push_back(4);
+    expectedFormat.push_back('a');
+    pkt.reset(new Pkt4(&expectedFormat[0], expectedFormat.size()));
+    pkt->setLazyOptions(true);
+    EXPECT_THROW(pkt->unpack(), OutOfRange);
+}
+
 // This test verifies methods that are used for manipulating meta fields
 // i.e. fields that are not part of DHCPv4 (e.g. interface name).
 TEST_F(Pkt4Test, metaFields) {
@@ -419,6 +419,30 @@ TEST_F(Pkt6Test, addGetDelOptions) {
     EXPECT_EQ(0, options.size());
 }
 
+// Check that the options packed in advance are not packed again.
+TEST_F(Pkt6Test, prepackedOptions) {
+    Pkt6 pkt(DHCPV6_REPLY, 0x020304);
+    OptionPtr opt(new Option(Option::V6, 23, OptionBuffer(2, 1)));
+    // Not the on-wire format of the option, to see which one is used.
+    const uint8_t data[] = { 0, 23, 0, 2, 9, 9 };
+    pkt.addOption(opt, OptionBufferPtr(new OptionBuffer(data,
+                                                        data + sizeof(data))));
+    EXPECT_EQ(opt, pkt.getOption(23));
+
+    ASSERT_NO_THROW(pkt.pack());
+    ASSERT_EQ(4 + sizeof(data), pkt.getBuffer().getLength());
+    EXPECT_EQ(0, memcmp(static_cast<const uint8_t*>
+                        (pkt.getBuffer().getData()) + 4,
+                        data, sizeof(data)));
+
+    // An option replaced is packed.
+    EXPECT_TRUE(pkt.delOption(23));
+    pkt.addOption(opt);
+    ASSERT_NO_THROW(pkt.pack());
+    ASSERT_EQ(4 + sizeof(data), pkt.getBuffer().getLength());
+    EXPECT_EQ(1, static_cast<const uint8_t*>(pkt.getBuffer().getData())[8]);
+}
+
 TEST_F(Pkt6Test, Timestamp) {
     boost::scoped_ptr<Pkt6> pkt(new Pkt6(DHCPV6_SOLICIT, 0x020304));
 
@@ -18,6 +18,9 @@
 #include <asio.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 
+#include <algorithm>
+#include <vector>
+
 namespace bundy {
 namespace dhcp_ddns {
 
@@ -30,6 +33,10 @@ NameChangeProtocol stringToNcrProtocol(const std::string& protocol_str) {
         return (NCR_TCP);
     }
 
+    if (boost::iequals(protocol_str, "UNIX")) {
+        return (NCR_UNIX);
+    }
+
     bundy_throw(BadValue, "Invalid NameChangeRequest protocol:" << protocol_str);
 }
 
@@ -39,6 +46,8 @@ std::string ncrProtocolToString(NameChangeProtocol protocol) {
         return ("UDP");
     case NCR_TCP:
         return ("TCP");
+    case NCR_UNIX:
+        return ("UNIX");
     default:
         break;
     }
@@ -110,20 +119,69 @@ NameChangeListener::stopListening() {
 void
 NameChangeListener::invokeRecvHandler(const Result result,
                                       NameChangeRequestPtr& ncr) {
+    io_pending_ = false;
+    callRecvHandler(result, ncr);
+
+    // Start the next IO layer asynchronous receive.
+    continueListening();
+}
+
+void
+NameChangeListener::invokeRecvHandler(const NameChangeFormat format,
+                                      bundy::util::InputBuffer& buffer) {
+    // Unmarshal all the requests first, so the handler is called for none
+    // of them if the receive has to be restarted.
+    std::vector<NameChangeRequestPtr> ncrs;
+    try {
+        while (buffer.getPosition() < buffer.getLength()) {
+            ncrs.push_back(NameChangeRequest::fromFormat(format, buffer));
+        }
+    } catch (const NcrMessageError& ex) {
+        // The requests read so far are still passed on.
+        LOG_ERROR(dhcp_ddns_logger, DHCP_DDNS_INVALID_NCR).arg(ex.what());
+    }
+
+    if (ncrs.empty()) {
+        // Go back to listening.
+        receiveNext();
+        return;
+    }
+
+    io_pending_ = false;
+    for (std::vector<NameChangeRequestPtr>::iterator ncr = ncrs.begin();
+         ncr != ncrs.end(); ++ncr) {
+        // The handler may have stopped listening, e.g. when its queue is
+        // full.
+        if ((ncr != ncrs.begin()) && !amListening()) {
+            LOG_ERROR(dhcp_ddns_logger, DHCP_DDNS_NCR_BATCH_DROPPED)
+                      .arg(ncrs.end() - ncr);
+            break;
+        }
+        callRecvHandler(SUCCESS, *ncr);
+    }
+
+    // Start the next IO layer asynchronous receive.
+    continueListening();
+}
+
+void
+NameChangeListener::callRecvHandler(const Result result,
+                                    NameChangeRequestPtr& ncr) {
     // Call the registered application layer handler.
     // Surround the invocation with a try-catch. The invoked handler is
     // not supposed to throw, but in the event it does we will at least
     // report it.
     try {
-        io_pending_ = false;
         recv_handler_(result, ncr);
     } catch (const std::exception& ex) {
         LOG_ERROR(dhcp_ddns_logger, DHCP_DDNS_UNCAUGHT_NCR_RECV_HANDLER_ERROR)
                   .arg(ex.what());
     }
+}
 
-    // Start the next IO layer asynchronous receive.
-    // In the event the handler above intervened and decided to stop listening
+void
+NameChangeListener::continueListening() {
+    // In the event the handler intervened and decided to stop listening
     // we need to check that first.
     if (amListening()) {
         try {
@@ -138,29 +196,23 @@ NameChangeListener::invokeRecvHandler(const Result result,
             LOG_ERROR(dhcp_ddns_logger, DHCP_DDNS_NCR_RECV_NEXT_ERROR)
                       .arg(ex.what());
 
-            // Call the registered application layer handler.
-            // Surround the invocation with a try-catch. The invoked handler is
-            // not supposed to throw, but in the event it does we will at least
-            // report it.
             NameChangeRequestPtr empty;
-            try {
-                io_pending_ = false;
-                recv_handler_(ERROR, empty);
-            } catch (const std::exception& ex) {
-                LOG_ERROR(dhcp_ddns_logger,
-                          DHCP_DDNS_UNCAUGHT_NCR_RECV_HANDLER_ERROR)
-                          .arg(ex.what());
-            }
+            io_pending_ = false;
+            callRecvHandler(ERROR, empty);
         }
     }
 }
 
 //************************* NameChangeSender ******************************
 
+// Makes constants visible to Google test macros.
+const size_t NameChangeSender::MAX_BATCH_SIZE;
+
 NameChangeSender::NameChangeSender(RequestSendHandler& send_handler,
                                    size_t send_queue_max)
     : sending_(false), send_handler_(send_handler),
-      send_queue_max_(send_queue_max), io_service_(NULL) {
+      send_queue_max_(send_queue_max), ncr_to_send_(), send_batch_size_(1),
+      io_service_(NULL) {
 
     // Queue size must be big enough to hold at least 1 entry.
     setQueueMaxSize(send_queue_max);
@@ -175,6 +227,7 @@ NameChangeSender::startSending(bundy::asiolink::IOService& io_service) {
 
     // Clear send marker.
     ncr_to_send_.reset();
+    send_batch_size_ = 1;
 
     // Call implementation dependent open.
     try {
@@ -260,6 +313,7 @@ NameChangeSender::sendNext() {
     // it on the front of the queue until we successfully send it.
     if (!send_queue_.empty()) {
         ncr_to_send_ = send_queue_.front();
+        send_batch_size_ = 1;
 
        // @todo start defense timer
        // If a send were to hang and we timed it out, then timeout
@@ -273,25 +327,34 @@ NameChangeSender::sendNext() {
 void
 NameChangeSender::invokeSendHandler(const NameChangeSender::Result result) {
     // @todo reset defense timer
+    SendQueue sent;
     if (result == SUCCESS) {
-        // It shipped so pull it off the queue.
-        send_queue_.pop_front();
+        // It shipped so pull it off the queue, with the requests sent along.
+        const size_t count = std::min(send_batch_size_, send_queue_.size());
+        sent.assign(send_queue_.begin(), send_queue_.begin() + count);
+        send_queue_.erase(send_queue_.begin(), send_queue_.begin() + count);
+    } else {
+        sent.push_back(ncr_to_send_);
     }
 
     // Invoke the completion handler passing in the result and a pointer
-    // the request involved.
+    // the request involved, for each of the requests.
     // Surround the invocation with a try-catch. The invoked handler is
     // not supposed to throw, but in the event it does we will at least
     // report it.
-    try {
-        send_handler_(result, ncr_to_send_);
-    } catch (const std::exception& ex) {
-        LOG_ERROR(dhcp_ddns_logger, DHCP_DDNS_UNCAUGHT_NCR_SEND_HANDLER_ERROR)
-                  .arg(ex.what());
+    for (SendQueue::iterator ncr = sent.begin(); ncr != sent.end(); ++ncr) {
+        try {
+            send_handler_(result, *ncr);
+        } catch (const std::exception& ex) {
+            LOG_ERROR(dhcp_ddns_logger,
+                      DHCP_DDNS_UNCAUGHT_NCR_SEND_HANDLER_ERROR)
+                      .arg(ex.what());
+        }
     }
 
     // Clear the pending ncr pointer.
     ncr_to_send_.reset();
+    send_batch_size_ = 1;
 
     // Set up the next send
     try {
@@ -321,6 +384,39 @@ NameChangeSender::invokeSendHandler(const NameChangeSender::Result result) {
     }
 }
 
+size_t
+NameChangeSender::marshalRequests(const NameChangeFormat format,
+                                  bundy::util::OutputBuffer& buffer,
+                                  const size_t max_length) {
+    if (!ncr_to_send_) {
+        bundy_throw(NcrSenderError, "no request is being sent");
+    }
+
+    ncr_to_send_->toFormat(format, buffer);
+    if (buffer.getLength() > max_length) {
+        bundy_throw(NcrMessageError, "request length " << buffer.getLength()
+                  << " exceeds the maximum " << max_length);
+    }
+
+    // Only the listeners of the binary format read several requests.
+    send_batch_size_ = 1;
+    if (format == FMT_BINARY) {
+        const size_t max_count = std::min(send_queue_.size(), MAX_BATCH_SIZE);
+        while (send_batch_size_ < max_count) {
+            const size_t length = buffer.getLength();
+            send_queue_[send_batch_size_]->toFormat(format, buffer);
+            if (buffer.getLength() > max_length) {
+                // It is sent with the next batch.
+                buffer.trim(buffer.getLength() - length);
+                break;
+            }
+            ++send_batch_size_;
+        }
+    }
+
+    return (send_batch_size_);
+}
+
 void
 NameChangeSender::skipNext() {
     if (!send_queue_.empty()) {
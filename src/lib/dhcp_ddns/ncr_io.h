@@ -60,6 +60,7 @@
 #include <asiolink/io_service.h>
 #include <dhcp_ddns/ncr_msg.h>
 #include <exceptions/exceptions.h>
+#include <util/buffer.h>
 
 #include <deque>
 
@@ -67,19 +68,20 @@ namespace bundy {
 namespace dhcp_ddns {
 
 /// @brief Defines the list of socket protocols supported.
-/// Currently only UDP is implemented.
+/// Currently UDP and Unix domain datagram sockets are implemented.
 /// @todo TCP is intended to be implemented prior 1.0 release.
 /// @todo Give some thought to an ANY protocol which might try
 /// first as UDP then as TCP, etc.
 enum NameChangeProtocol {
   NCR_UDP,
-  NCR_TCP
+  NCR_TCP,
+  NCR_UNIX
 };
 
 /// @brief Function which converts labels to  NameChangeProtocol enum values.
 ///
 /// @param protocol_str text to convert to an enum.
-/// Valid string values: "UDP", "TCP"
+/// Valid string values: "UDP", "TCP", "UNIX"
 ///
 /// @return NameChangeProtocol value which maps to the given string.
 ///
@@ -169,7 +171,10 @@ public:
 /// This is done by passing in either a success status and a populated
 /// NameChangeRequest or an error status and an empty request into the
 /// listener's invokeRecvHandler method. This is the mechanism by which the
-/// listener's caller is handed inbound NCRs.
+/// listener's caller is handed inbound NCRs.  A derivation receiving several
+/// requests at once passes the raw data to the variant of invokeRecvHandler
+/// which unmarshals them, and the application layer handler is called for
+/// each of them in turn.
 class NameChangeListener {
 public:
 
@@ -273,6 +278,22 @@ protected:
     /// wise.
     void invokeRecvHandler(const Result result, NameChangeRequestPtr& ncr);
 
+    /// @brief Calls the NCR receive handler for each request in a buffer.
+    ///
+    /// The buffer holds one or more marshalled requests, one after the other,
+    /// as received from the IO source.  The handler is called with each of
+    /// them in turn, unless it stops listening, then the next receive is
+    /// started.  A request which can't be unmarshalled is logged and dropped
+    /// along with those following it, as their position is lost.  If no
+    /// request at all is found, the next receive is started without calling
+    /// the handler.  The same rules as for the other variant apply to the
+    /// handler.
+    ///
+    /// @param format is the format of the requests in the buffer
+    /// @param buffer is the buffer holding the requests
+    void invokeRecvHandler(const NameChangeFormat format,
+                           bundy::util::InputBuffer& buffer);
+
     /// @brief Abstract method which opens the IO source for reception.
     ///
     /// The derivation uses this method to perform the steps needed to
@@ -328,6 +349,18 @@ public:
     }
 
 private:
+    /// @brief Calls the NCR receive handler, logging its exceptions.
+    ///
+    /// @param result contains that receive outcome status.
+    /// @param ncr is a pointer to the received NameChangeRequest, if any.
+    void callRecvHandler(const Result result, NameChangeRequestPtr& ncr);
+
+    /// @brief Starts the next receive after the handler has been called.
+    ///
+    /// Nothing is done if the handler stopped listening.  If the receive
+    /// can't be started, the handler is called with an error.
+    void continueListening();
+
     /// @brief Sets the listening indicator to the given value.
     ///
     /// Note, this method is private as it is used the base class is solely
@@ -446,7 +479,8 @@ public:
 ///
 /// If there is not a send in progress and the send queue is not empty,
 /// the sendNext method will pass the NCR at the front of the send queue into
-/// the virtual doSend() method.
+/// the virtual doSend() method.  The derivation may send the requests which
+/// follow it in the queue along with it, see marshalRequests().
 ///
 /// The sender derivation uses this doSend() method to instigate an IO layer
 /// asynchronous send with its IO layer callback to handle send events from its
@@ -471,6 +505,9 @@ public:
     /// @brief Defines a default maximum number of entries in the send queue.
     static const size_t MAX_QUEUE_DEFAULT = 1024;
 
+    /// @brief Defines the maximum number of requests sent at once.
+    static const size_t MAX_BATCH_SIZE = 32;
+
     /// @brief Defines the outcome of an asynchronous NCR send.
     enum Result {
         SUCCESS,
@@ -596,9 +633,11 @@ protected:
     /// This is the hook by which the sender's caller's NCR send completion
     /// handler is called.  This method MUST be invoked by the derivation's
     /// implementation of doSend.   Note that if the send was a success,
-    /// the entry at the front of the queue is removed from the queue.
-    /// If not we leave it there so we can retry it.  After we invoke the
-    /// handler we clear the pending ncr value and queue up the next send.
+    /// the entry at the front of the queue is removed from the queue, along
+    /// with the entries sent with it, and the handler is called for each of
+    /// them.  If not we leave them there so we can retry them, and the
+    /// handler is called for the front entry.  After we invoke the handler we
+    /// clear the pending ncr value and queue up the next send.
     ///
     /// NOTE:
     /// The handler invoked by this method MUST NOT THROW. The handler is
@@ -618,6 +657,27 @@ protected:
     /// @param result contains that send outcome status.
     void invokeSendHandler(const NameChangeSender::Result result);
 
+    /// @brief Marshals the requests to send into a buffer.
+    ///
+    /// The request being sent, at the front of the queue, is written first.
+    /// In the binary format, the requests following it in the queue are
+    /// appended while the buffer does not exceed the given length, up to
+    /// MAX_BATCH_SIZE requests, and they are all sent at once.  In JSON, the
+    /// request is sent alone, as the older listeners read one request only.
+    /// The derivation's doSend calls this method to fill its buffer.
+    ///
+    /// @param format is the format of the requests
+    /// @param buffer is the buffer to which the requests are appended
+    /// @param max_length is the maximum length of the buffer
+    ///
+    /// @return the number of requests written.
+    ///
+    /// @throw NcrSenderError if no send is in progress, or NcrMessageError if
+    /// the request being sent can't be written within the given length.
+    size_t marshalRequests(const NameChangeFormat format,
+                           bundy::util::OutputBuffer& buffer,
+                           const size_t max_length);
+
     /// @brief Abstract method which opens the IO sink for transmission.
     ///
     /// The derivation uses this method to perform the steps needed to
@@ -774,6 +834,9 @@ private:
     /// @brief Pointer to the request which is in the process of being sent.
     NameChangeRequestPtr ncr_to_send_;
 
+    /// @brief Number of requests being sent, from the front of the queue.
+    size_t send_batch_size_;
+
     /// @brief Pointer to the IOService currently being used by the sender.
     /// @note We need to remember the io_service but we receive it by
     /// reference.  Use a raw pointer to store it.  This value should never be
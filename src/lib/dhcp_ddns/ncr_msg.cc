@@ -34,6 +34,10 @@ NameChangeFormat stringToNcrFormat(const std::string& fmt_str) {
         return FMT_JSON;
     }
 
+    if (boost::iequals(fmt_str, "BINARY")) {
+        return FMT_BINARY;
+    }
+
     bundy_throw(BadValue, "Invalid NameChangeRequest format:" << fmt_str);
 }
 
@@ -43,6 +47,10 @@ std::string ncrFormatToString(NameChangeFormat format) {
         return ("JSON");
     }
 
+    if (format == FMT_BINARY) {
+        return ("BINARY");
+    }
+
     std::ostringstream stream;
     stream  << "UNKNOWN(" << format << ")";
     return (stream.str());
@@ -209,6 +217,18 @@ operator<<(std::ostream& os, const D2Dhcid& dhcid) {
 
 /**************************** NameChangeRequest ******************************/
 
+namespace {
+
+/// @name Flags of the binary format
+//@{
+/// The request updates the forward DNS servers.
+const uint8_t BINARY_FORWARD_CHANGE = 0x01;
+/// The request updates the reverse DNS servers.
+const uint8_t BINARY_REVERSE_CHANGE = 0x02;
+//@}
+
+}
+
 NameChangeRequest::NameChangeRequest()
     : change_type_(CHG_ADD), forward_change_(false),
     reverse_change_(false), fqdn_(""), ip_io_address_("0.0.0.0"),
@@ -263,6 +283,32 @@ NameChangeRequest::fromFormat(const NameChangeFormat format,
                       << ex.what());
         }
 
+        break;
+        }
+    case FMT_BINARY: {
+        try {
+            // Get the length of the request and check it is all there.
+            size_t len = buffer.readUint16();
+            if (len > buffer.getLength() - buffer.getPosition()) {
+                bundy_throw(NcrMessageError, "fromFormat: request length "
+                          << len << " exceeds the buffer");
+            }
+
+            // Decode the request in place, then skip it whatever the
+            // fields it ends with.
+            const size_t end = buffer.getPosition() + len;
+            ncr = NameChangeRequest::fromBinary(buffer);
+            if (buffer.getPosition() > end) {
+                bundy_throw(NcrMessageError, "fromFormat: request overruns "
+                          "its length " << len);
+            }
+            buffer.setPosition(end);
+        } catch (bundy::util::InvalidBufferPosition& ex) {
+            // Read error accessing data in InputBuffer.
+            bundy_throw(NcrMessageError, "fromFormat: buffer read error: "
+                      << ex.what());
+        }
+
         break;
         }
     default:
@@ -291,6 +337,16 @@ NameChangeRequest::toFormat(const NameChangeFormat format,
         buffer.writeData(json.c_str(), length);
         break;
         }
+    case FMT_BINARY: {
+        // Reserve room for the length, which is known once the request
+        // has been written.
+        const size_t start = buffer.getLength();
+        buffer.skip(sizeof(uint16_t));
+        toBinary(buffer);
+        buffer.writeUint16At(buffer.getLength() - start - sizeof(uint16_t),
+                             start);
+        break;
+        }
     default:
         // Programmatic error, shouldn't happen.
         bundy_throw(NcrMessageError, "toFormat - invalid format");
@@ -380,6 +436,81 @@ NameChangeRequest::toJSON() const  {
     return (stream.str());
 }
 
+NameChangeRequestPtr
+NameChangeRequest::fromBinary(bundy::util::InputBuffer& buffer) {
+    NameChangeRequestPtr ncr(new NameChangeRequest());
+
+    const uint8_t change_type = buffer.readUint8();
+    if ((change_type != CHG_ADD) && (change_type != CHG_REMOVE)) {
+        bundy_throw(NcrMessageError,
+                  "Invalid data value for change_type: "
+                  << static_cast<int>(change_type));
+    }
+    ncr->setChangeType(static_cast<NameChangeType>(change_type));
+
+    const uint8_t flags = buffer.readUint8();
+    ncr->setForwardChange(flags & BINARY_FORWARD_CHANGE);
+    ncr->setReverseChange(flags & BINARY_REVERSE_CHANGE);
+
+    try {
+        ncr->fqdn_ = dns::Name(buffer).toText();
+    } catch (const std::exception& ex) {
+        bundy_throw(NcrMessageError, "Invalid FQDN value: " << ex.what());
+    }
+
+    const uint8_t address_len = buffer.readUint8();
+    if ((address_len != asiolink::V4ADDRESS_LEN) &&
+        (address_len != asiolink::V6ADDRESS_LEN)) {
+        bundy_throw(NcrMessageError, "Invalid ip address length: "
+                  << static_cast<int>(address_len));
+    }
+    uint8_t address[asiolink::V6ADDRESS_LEN];
+    buffer.readData(address, address_len);
+    ncr->ip_io_address_ = asiolink::IOAddress::
+        fromBytes(address_len == asiolink::V4ADDRESS_LEN ? AF_INET : AF_INET6,
+                  address);
+
+    std::vector<uint8_t> dhcid;
+    buffer.readVector(dhcid, buffer.readUint16());
+    ncr->dhcid_.fromBytes(dhcid);
+
+    ncr->lease_expires_on_ = buffer.readUint32();
+    ncr->lease_expires_on_ = (ncr->lease_expires_on_ << 32) |
+        buffer.readUint32();
+    ncr->setLeaseLength(buffer.readUint32());
+
+    // The fields added by later versions, if any, are ignored.
+
+    // Validate the overall content semantically.  This will throw an
+    // NcrMessageError if anything is amiss.
+    ncr->validateContent();
+
+    return (ncr);
+}
+
+void
+NameChangeRequest::toBinary(bundy::util::OutputBuffer& buffer) const {
+    buffer.writeUint8(change_type_);
+    buffer.writeUint8((forward_change_ ? BINARY_FORWARD_CHANGE : 0) |
+                      (reverse_change_ ? BINARY_REVERSE_CHANGE : 0));
+
+    // The FQDN has been validated by setFqdn.
+    dns::Name(fqdn_).toWire(buffer);
+
+    const std::vector<uint8_t> address = ip_io_address_.toBytes();
+    buffer.writeUint8(address.size());
+    buffer.writeData(&address[0], address.size());
+
+    const std::vector<uint8_t>& dhcid = dhcid_.getBytes();
+    buffer.writeUint16(dhcid.size());
+    if (!dhcid.empty()) {
+        buffer.writeData(&dhcid[0], dhcid.size());
+    }
+
+    buffer.writeUint32(lease_expires_on_ >> 32);
+    buffer.writeUint32(lease_expires_on_ & 0xffffffff);
+    buffer.writeUint32(lease_length_);
+}
 
 void
 NameChangeRequest::validateContent() {
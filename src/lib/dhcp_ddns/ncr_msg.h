@@ -67,13 +67,14 @@ enum NameChangeStatus  {
 
 /// @brief Defines the list of data wire formats supported.
 enum NameChangeFormat {
-  FMT_JSON
+  FMT_JSON,
+  FMT_BINARY
 };
 
 /// @brief Function which converts labels to  NameChangeFormat enum values.
 ///
 /// @param fmt_str text to convert to an enum.
-/// Valid string values: "JSON"
+/// Valid string values: "JSON", "BINARY"
 ///
 /// @return NameChangeFormat value which maps to the given string.
 ///
@@ -147,6 +148,13 @@ public:
     /// or there is an odd number of digits.
     void fromStr(const std::string& data);
 
+    /// @brief Sets the DHCID value to the given bytes.
+    ///
+    /// @param data is the DHCID value, as returned by getBytes().
+    void fromBytes(const std::vector<uint8_t>& data) {
+        bytes_ = data;
+    }
+
     /// @brief Sets the DHCID value based on the Client Identifier.
     ///
     /// @param clientid_data Holds the raw bytes representing client identifier.
@@ -229,9 +237,8 @@ typedef std::map<std::string, bundy::data::ConstElementPtr> ElementMap;
 /// This class is used by DHCP-DDNS clients (e.g. DHCP4, DHCP6) to
 /// request DNS updates.  Each message contains a single DNS change (either an
 /// add/update or a remove) for a single FQDN.  It provides marshalling services
-/// for moving instances to and from the wire.  Currently, the only format
-/// supported is JSON, however the class provides an interface such that other
-/// formats can be readily supported.
+/// for moving instances to and from the wire, in JSON or in a compact binary
+/// format.
 class NameChangeRequest {
 public:
     /// @brief Default Constructor.
@@ -280,7 +287,13 @@ public:
     /// is than treated as JSON which is then parsed into the data needed
     /// to create a request instance.
     ///
-    /// (NOTE currently only JSON is supported.)
+    /// BINARY: The buffer is expected to contain a two byte unsigned integer
+    /// which specifies the length of the request; followed by the request
+    /// itself, as written by toFormat().  The request is decoded without
+    /// any text conversion.
+    ///
+    /// In both formats the buffer is left positioned after the request, so
+    /// that the requests following it can be read by further calls.
     ///
     /// @param format indicates the data format to use
     /// @param buffer is the input buffer containing the marshalled request
@@ -303,7 +316,25 @@ public:
     /// the request data needed to reassemble the request on the receiving
     /// end. The JSON text in the buffer is NOT null-terminated.
     ///
-    /// (NOTE currently only JSON is supported.)
+    /// BINARY: Upon completion, the buffer will contain a two byte unsigned
+    /// integer which specifies the length of the request; followed by, in
+    /// network byte order:
+    ///
+    ///     - the change type (one byte),
+    ///     - the forward (0x01) and reverse (0x02) change flags (one byte),
+    ///     - the FQDN in DNS wire format, not compressed,
+    ///     - the length of the IP address (one byte, 4 or 16) and the
+    ///       address,
+    ///     - the length of the DHCID (two bytes) and the DHCID,
+    ///     - the lease expiration time in seconds since the epoch (eight
+    ///       bytes),
+    ///     - the lease length (four bytes).
+    ///
+    /// The data following these fields up to the given length is ignored,
+    /// so fields can be added later on without breaking the older listeners.
+    ///
+    /// In both formats the request is appended to the buffer, so several
+    /// requests can be sent in one buffer.
     ///
     /// @param format indicates the data format to use
     /// @param buffer is the output buffer to which the request should be
@@ -593,6 +624,22 @@ public:
     bool operator != (const NameChangeRequest& b);
 
 private:
+    /// @brief Creates a NameChangeRequest from its binary rendition.
+    ///
+    /// @param buffer is the input buffer, positioned after the length of
+    /// the request
+    ///
+    /// @return a pointer to the new NameChangeRequest
+    ///
+    /// @throw NcrMessageError if the request is truncated or invalid.
+    static NameChangeRequestPtr fromBinary(bundy::util::InputBuffer& buffer);
+
+    /// @brief Writes the binary rendition of the request, without its
+    /// length.
+    ///
+    /// @param buffer is the output buffer to which the request is appended
+    void toBinary(bundy::util::OutputBuffer& buffer) const;
+
     /// @brief Denotes the type of this change as either an Add or a Remove.
     NameChangeType change_type_;
 
@@ -158,36 +158,28 @@ NameChangeUDPListener::close() {
 void
 NameChangeUDPListener::receiveCompletionHandler(const bool successful,
                                                 const UDPCallback *callback) {
-    NameChangeRequestPtr ncr;
-    Result result = SUCCESS;
-
     if (successful) {
         // Make an InputBuffer from our internal array
         bundy::util::InputBuffer input_buffer(callback->getData(),
                                             callback->getBytesTransferred());
 
-        try {
-            ncr = NameChangeRequest::fromFormat(format_, input_buffer);
-        } catch (const NcrMessageError& ex) {
-            // log it and go back to listening
-            LOG_ERROR(dhcp_ddns_logger, DHCP_DDNS_INVALID_NCR).arg(ex.what());
+        // Pass the requests of the datagram to the application's handler,
+        // which also queues up the next receive.
+        // NOTE: We must call the base class, NEVER doReceive
+        invokeRecvHandler(format_, input_buffer);
+        return;
+    }
 
-            // Queue up the next recieve.
-            // NOTE: We must call the base class, NEVER doReceive
-            receiveNext();
-            return;
-        }
+    NameChangeRequestPtr ncr;
+    Result result = ERROR;
+    asio::error_code error_code = callback->getErrorCode();
+    if (error_code.value() == asio::error::operation_aborted) {
+        LOG_INFO(dhcp_ddns_logger, DHCP_DDNS_NCR_UDP_RECV_CANCELED)
+                 .arg(error_code.message());
+        result = STOPPED;
     } else {
-        asio::error_code error_code = callback->getErrorCode();
-        if (error_code.value() == asio::error::operation_aborted) {
-            LOG_INFO(dhcp_ddns_logger, DHCP_DDNS_NCR_UDP_RECV_CANCELED)
-                     .arg(error_code.message());
-            result = STOPPED;
-        } else {
-            LOG_ERROR(dhcp_ddns_logger, DHCP_DDNS_NCR_UDP_RECV_ERROR)
-                      .arg(error_code.message());
-            result = ERROR;
-        }
+        LOG_ERROR(dhcp_ddns_logger, DHCP_DDNS_NCR_UDP_RECV_ERROR)
+                  .arg(error_code.message());
     }
 
     // Call the application's registered request receive handler.
@@ -289,9 +281,10 @@ NameChangeUDPSender::close() {
 
 void
 NameChangeUDPSender::doSend(NameChangeRequestPtr& ncr) {
-    // Now use the NCR to write JSON to an output buffer.
+    // Now use the NCR, and those sent along, to write the datagram to an
+    // output buffer.
     bundy::util::OutputBuffer ncr_buffer(SEND_BUF_MAX);
-    ncr->toFormat(format_, ncr_buffer);
+    marshalRequests(format_, ncr_buffer, SEND_BUF_MAX);
 
     // Copy the wire-ized request to callback.  This way we know after
     // send completes what we sent (or attempted to send).
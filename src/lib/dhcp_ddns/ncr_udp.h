@@ -384,15 +384,13 @@ public:
     /// This method is invoked by the UPDCallback operator() implementation,
     /// passing in the boolean success indicator and pointer to itself.
     ///
-    /// If the indicator denotes success, then the method will attempt to
-    /// to construct a NameChangeRequest from the received data.  If the
-    /// construction was successful, it will send the new NCR to the
-    /// application layer by calling invokeRecvHandler() with a success
-    /// status and a pointer to the new NCR.
+    /// If the indicator denotes success, then the method will pass the
+    /// received data to invokeRecvHandler(), which constructs the
+    /// NameChangeRequests it contains and sends each of them to the
+    /// application layer.  A datagram may hold several requests.
     ///
     /// If the buffer contains invalid data such that construction fails,
-    /// the method will log the failure and then call doReceive() to start a
-    /// initiate the next receive.
+    /// the failure is logged and the next receive is initiated.
     ///
     /// If the indicator denotes failure the method will log the failure and
     /// notify the application layer by calling invokeRecvHandler() with
@@ -500,7 +498,9 @@ public:
     /// @brief Sends a given request asynchronously over the socket
     ///
     /// The given NameChangeRequest is converted to wire format and copied
-    /// into the send callback's transfer buffer.  Then the socket's
+    /// into the send callback's transfer buffer, along with the requests
+    /// following it in the queue in the binary format (see
+    /// NameChangeSender::marshalRequests()).  Then the socket's
     /// asyncSend() method is called, passing in send_callback_ member's
     /// transfer buffer as the send buffer and the send_callback_ itself
     /// as the callback object.
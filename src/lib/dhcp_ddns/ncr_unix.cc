@@ -0,0 +1,275 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcp_ddns/dhcp_ddns_log.h>
+#include <dhcp_ddns/ncr_unix.h>
+
+#include <asio/error_code.hpp>
+#include <boost/bind.hpp>
+
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace bundy {
+namespace dhcp_ddns {
+
+namespace {
+
+/// @brief Checks the path of a socket.
+///
+/// @param path the path to check
+///
+/// @throw NcrUnixError if the path is empty or too long.
+void
+checkSocketPath(const std::string& path) {
+    if (path.empty()) {
+        bundy_throw(NcrUnixError, "Unix socket path can't be empty");
+    }
+
+    if (path.size() >= sizeof(static_cast<sockaddr_un*>(0)->sun_path)) {
+        bundy_throw(NcrUnixError, "Unix socket path is too long: " << path);
+    }
+}
+
+}
+
+//*************************** NameChangeUnixListener ***********************
+
+NameChangeUnixListener::
+NameChangeUnixListener(const std::string& socket_path,
+                       const NameChangeFormat format,
+                       RequestReceiveHandler& ncr_recv_handler)
+    : NameChangeListener(ncr_recv_handler), socket_path_(socket_path),
+      format_(format), socket_(), recv_buffer_(RECV_BUF_MAX) {
+    checkSocketPath(socket_path_);
+}
+
+NameChangeUnixListener::~NameChangeUnixListener() {
+    // Clean up.
+    stopListening();
+}
+
+void
+NameChangeUnixListener::open(bundy::asiolink::IOService& io_service) {
+    // A socket file left by a previous instance prevents the bind.
+    unlink(socket_path_.c_str());
+
+    try {
+        socket_.reset(new asio::local::datagram_protocol::
+                      socket(io_service.get_io_service(),
+                             asio::local::datagram_protocol()));
+        socket_->bind(asio::local::datagram_protocol::
+                      endpoint(socket_path_));
+    } catch (asio::system_error& ex) {
+        socket_.reset();
+        bundy_throw(NcrUnixError, "unable to bind to " << socket_path_
+                  << ": " << ex.code().message());
+    }
+}
+
+void
+NameChangeUnixListener::doReceive() {
+    if (!socket_) {
+        bundy_throw(NcrUnixError, "Unix socket listener is not open");
+    }
+
+    socket_->async_receive(asio::buffer(recv_buffer_),
+                           boost::bind(&NameChangeUnixListener::
+                                       receiveCompletionHandler, this,
+                                       asio::placeholders::error,
+                                       asio::placeholders::bytes_transferred));
+}
+
+void
+NameChangeUnixListener::close() {
+    // Whether we think we are listening or not, make sure we aren't.
+    // NOTE that if there is a pending receive, it will be canceled, which
+    // WILL generate an invocation of the callback with error code of
+    // "operation aborted".
+    if (socket_) {
+        unlink(socket_path_.c_str());
+        if (socket_->is_open()) {
+            try {
+                socket_->close();
+            } catch (asio::system_error& ex) {
+                socket_.reset();
+                bundy_throw (NcrUnixError, ex.code().message());
+            }
+        }
+
+        socket_.reset();
+    }
+}
+
+void
+NameChangeUnixListener::receiveCompletionHandler(const asio::error_code&
+                                                 error_code,
+                                                 const size_t
+                                                 bytes_transferred) {
+    if (!error_code) {
+        // Pass the requests of the datagram to the application's handler,
+        // which also queues up the next receive.
+        bundy::util::InputBuffer input_buffer(&recv_buffer_[0],
+                                            bytes_transferred);
+        invokeRecvHandler(format_, input_buffer);
+        return;
+    }
+
+    NameChangeRequestPtr ncr;
+    Result result = ERROR;
+    if (error_code.value() == asio::error::operation_aborted) {
+        LOG_INFO(dhcp_ddns_logger, DHCP_DDNS_NCR_UNIX_RECV_CANCELED)
+                 .arg(error_code.message());
+        result = STOPPED;
+    } else {
+        LOG_ERROR(dhcp_ddns_logger, DHCP_DDNS_NCR_UNIX_RECV_ERROR)
+                  .arg(error_code.message());
+    }
+
+    // Call the application's registered request receive handler.
+    invokeRecvHandler(result, ncr);
+}
+
+//*************************** NameChangeUnixSender ***********************
+
+NameChangeUnixSender::
+NameChangeUnixSender(const std::string& server_path,
+                     const NameChangeFormat format,
+                     RequestSendHandler& ncr_send_handler,
+                     const size_t send_que_max)
+    : NameChangeSender(ncr_send_handler, send_que_max),
+      server_path_(server_path), format_(format), socket_(),
+      send_buffer_(SEND_BUF_MAX), watch_socket_() {
+    checkSocketPath(server_path_);
+}
+
+NameChangeUnixSender::~NameChangeUnixSender() {
+    // Clean up.
+    stopSending();
+}
+
+void
+NameChangeUnixSender::open(bundy::asiolink::IOService& io_service) {
+    try {
+        socket_.reset(new asio::local::datagram_protocol::
+                      socket(io_service.get_io_service(),
+                             asio::local::datagram_protocol()));
+    } catch (asio::system_error& ex) {
+        socket_.reset();
+        bundy_throw(NcrUnixError, ex.code().message());
+    }
+
+    watch_socket_.reset(new WatchSocket());
+}
+
+void
+NameChangeUnixSender::close() {
+    // Whether we think we are sending or not, make sure we aren't.
+    // NOTE that if there is a pending send, it will be canceled, which
+    // WILL generate an invocation of the callback with error code of
+    // "operation aborted".
+    if (socket_) {
+        if (socket_->is_open()) {
+            try {
+                socket_->close();
+            } catch (asio::system_error& ex) {
+                socket_.reset();
+                watch_socket_.reset();
+                bundy_throw (NcrUnixError, ex.code().message());
+            }
+        }
+
+        socket_.reset();
+    }
+
+    watch_socket_.reset();
+}
+
+void
+NameChangeUnixSender::doSend(NameChangeRequestPtr&) {
+    if (!socket_) {
+        bundy_throw(NcrUnixError, "Unix socket sender is not open");
+    }
+
+    // Write the request being sent, and those sent along, to the buffer
+    // which is kept until the send completes.
+    send_buffer_.clear();
+    marshalRequests(format_, send_buffer_, SEND_BUF_MAX);
+
+    socket_->async_send_to(asio::buffer(send_buffer_.getData(),
+                                        send_buffer_.getLength()),
+                           asio::local::datagram_protocol::
+                           endpoint(server_path_),
+                           boost::bind(&NameChangeUnixSender::
+                                       sendCompletionHandler, this,
+                                       asio::placeholders::error,
+                                       asio::placeholders::bytes_transferred));
+
+    // Set IO ready marker so sender activity is visible to select() or poll().
+    watch_socket_->markReady();
+}
+
+void
+NameChangeUnixSender::sendCompletionHandler(const asio::error_code& error_code,
+                                            const size_t) {
+    // Clear the IO ready marker.
+    try {
+        if (watch_socket_) {
+            watch_socket_->clearReady();
+        }
+    } catch (const std::exception& ex) {
+        // This is a programmatic error, which resurfaces as a closed fd in
+        // markReady() on the next send.  Log it and process the IO result.
+        LOG_ERROR(dhcp_ddns_logger, DHCP_DDNS_NCR_UNIX_CLEAR_READY_ERROR)
+                 .arg(ex.what());
+    }
+
+    Result result = SUCCESS;
+    if (error_code) {
+        if (error_code.value() == asio::error::operation_aborted) {
+            LOG_ERROR(dhcp_ddns_logger, DHCP_DDNS_NCR_UNIX_SEND_CANCELED)
+                      .arg(error_code.message());
+            result = STOPPED;
+        } else {
+            LOG_ERROR(dhcp_ddns_logger, DHCP_DDNS_NCR_UNIX_SEND_ERROR)
+                      .arg(error_code.message());
+            result = ERROR;
+        }
+    }
+
+    // Call the application's registered request send handler.
+    invokeSendHandler(result);
+}
+
+int
+NameChangeUnixSender::getSelectFd() {
+    if (!amSending() || !watch_socket_) {
+        bundy_throw(NotImplemented, "NameChangeUnixSender::getSelectFd"
+                                  " not in send mode");
+    }
+
+    return (watch_socket_->getSelectFd());
+}
+
+bool
+NameChangeUnixSender::ioReady() {
+    if (watch_socket_) {
+        return (watch_socket_->isReady());
+    }
+
+    return (false);
+}
+
+} // namespace bundy::dhcp_ddns
+} // namespace bundy
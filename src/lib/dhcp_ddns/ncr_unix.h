@@ -0,0 +1,274 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef NCR_UNIX_H
+#define NCR_UNIX_H
+
+/// @file ncr_unix.h
+/// @brief This file provides the Unix domain socket based IO for sending
+/// and receiving NameChangeRequests.
+///
+/// When DHCP-DDNS runs on the same host as the DHCP servers, the requests
+/// can be exchanged over a Unix domain datagram socket rather than over UDP.
+/// The listener binds the socket to a path in the file system, and the
+/// senders send their datagrams to that path.  The datagrams are never lost
+/// nor reordered by the kernel: a sender whose datagram can't be queued
+/// waits for room, and a send to a path where no listener is bound fails.
+///
+/// As with UDP, a datagram holds one request in JSON, or several requests in
+/// the binary format.
+///
+/// The listener and the sender use the asio local datagram socket directly,
+/// with their completion handlers bound as the asio callbacks: contrary to
+/// the asiolink UDP socket, nothing in this IO layer needs copyable
+/// callback objects.
+
+#include <asio.hpp>
+#include <dhcp_ddns/ncr_io.h>
+#include <dhcp_ddns/watch_socket.h>
+#include <util/buffer.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+namespace bundy {
+namespace dhcp_ddns {
+
+/// @brief Thrown when a Unix domain socket level exception occurs.
+class NcrUnixError : public bundy::Exception {
+public:
+    NcrUnixError(const char* file, size_t line, const char* what) :
+        bundy::Exception(file, line, what) { };
+};
+
+/// @brief Provides the ability to receive NameChangeRequests via a Unix
+/// domain socket.
+///
+/// This class is a derivation of the NameChangeListener which is capable of
+/// receiving NameChangeRequests through a Unix domain datagram socket.  The
+/// caller need only supply the path of the socket and a
+/// RequestReceiveHandler instance to receive NameChangeRequests
+/// asynchronously.
+///
+/// The socket file is created when the listener is opened, replacing any
+/// file left at the same path, and removed when it is closed.  The senders
+/// need the permission to write to it.
+class NameChangeUnixListener : public NameChangeListener {
+public:
+    /// @brief Defines the maximum size packet that can be received.
+    static const size_t RECV_BUF_MAX = 65535;
+
+    /// @brief Constructor
+    ///
+    /// @param socket_path is the path of the socket on which to listen
+    /// @param format is the wire format of the inbound requests
+    /// @param ncr_recv_handler the receive handler object to notify when
+    /// a receive completes.
+    ///
+    /// @throw NcrUnixError if the path is empty or too long.
+    NameChangeUnixListener(const std::string& socket_path,
+                           const NameChangeFormat format,
+                           RequestReceiveHandler& ncr_recv_handler);
+
+    /// @brief Destructor.
+    virtual ~NameChangeUnixListener();
+
+    /// @brief Opens the socket using the given IOService.
+    ///
+    /// Creates a datagram socket bound to the listener's path, that is
+    /// monitored by the given IOService instance.
+    ///
+    /// @param io_service the IOService which will monitor the socket.
+    ///
+    /// @throw NcrUnixError if the open fails.
+    virtual void open(bundy::asiolink::IOService& io_service);
+
+    /// @brief Closes the socket and removes the socket file.
+    ///
+    /// A pending read is canceled, its completion handler is called with
+    /// the "operation aborted" error.
+    ///
+    /// @throw NcrUnixError if the close fails.
+    virtual void close();
+
+    /// @brief Initiates an asynchronous read on the socket.
+    ///
+    /// @throw NcrUnixError if the socket is not open.
+    void doReceive();
+
+    /// @brief Implements the NameChangeRequest level receive completion
+    /// handler.
+    ///
+    /// On success, the received data is passed to invokeRecvHandler(),
+    /// which sends each request it contains to the application layer.  On
+    /// failure, the failure is logged and the application layer is notified
+    /// by calling invokeRecvHandler() with an error status and an empty
+    /// pointer.
+    ///
+    /// @param error_code the outcome of the receive
+    /// @param bytes_transferred the length of the datagram received
+    void receiveCompletionHandler(const asio::error_code& error_code,
+                                  const size_t bytes_transferred);
+
+    /// @brief Returns the path of the socket.
+    const std::string& getSocketPath() const {
+        return (socket_path_);
+    }
+
+private:
+    /// @brief Path of the socket on which to listen for requests.
+    std::string socket_path_;
+
+    /// @brief Wire format of the inbound requests.
+    NameChangeFormat format_;
+
+    /// @brief The listening socket.
+    boost::shared_ptr<asio::local::datagram_protocol::socket> socket_;
+
+    /// @brief The receive buffer.
+    std::vector<uint8_t> recv_buffer_;
+
+    ///
+    /// @name Copy and constructor assignment operator
+    ///
+    /// The copy constructor and assignment operator are private to avoid
+    /// potential issues with multiple listeners attempting to share sockets.
+private:
+    NameChangeUnixListener(const NameChangeUnixListener& source);
+    NameChangeUnixListener& operator=(const NameChangeUnixListener& source);
+    //@}
+};
+
+
+/// @brief Provides the ability to send NameChangeRequests via a Unix domain
+/// socket.
+///
+/// This class is a derivation of the NameChangeSender which is capable of
+/// sending NameChangeRequests through a Unix domain datagram socket.  The
+/// caller need only supply the path of the listener's socket and a
+/// RequestSendHandler instance to send NameChangeRequests asynchronously.
+class NameChangeUnixSender : public NameChangeSender {
+public:
+    /// @brief Defines the maximum size packet that can be sent.
+    static const size_t SEND_BUF_MAX = NameChangeUnixListener::RECV_BUF_MAX;
+
+    /// @brief Constructor
+    ///
+    /// @param server_path the path of the target listener's socket
+    /// @param format is the wire format of the outbound requests.
+    /// @param ncr_send_handler the send handler object to notify when
+    /// when a send completes.
+    /// @param send_que_max sets the maximum number of entries allowed in
+    /// the send queue.
+    /// It defaults to NameChangeSender::MAX_QUEUE_DEFAULT
+    ///
+    /// @throw NcrUnixError if the path is empty or too long.
+    NameChangeUnixSender(const std::string& server_path,
+                         const NameChangeFormat format,
+                         RequestSendHandler& ncr_send_handler,
+                         const size_t send_que_max =
+                         NameChangeSender::MAX_QUEUE_DEFAULT);
+
+    /// @brief Destructor
+    virtual ~NameChangeUnixSender();
+
+    /// @brief Opens the socket using the given IOService.
+    ///
+    /// Creates an unbound datagram socket, that is monitored by the given
+    /// IOService instance.  The listener does not need to be running yet.
+    ///
+    /// @param io_service the IOService which will monitor the socket.
+    ///
+    /// @throw NcrUnixError if the open fails.
+    virtual void open(bundy::asiolink::IOService& io_service);
+
+    /// @brief Closes the socket.
+    ///
+    /// A pending send is canceled, its completion handler is called with
+    /// the "operation aborted" error.
+    ///
+    /// @throw NcrUnixError if the close fails.
+    virtual void close();
+
+    /// @brief Sends a given request asynchronously over the socket
+    ///
+    /// The given NameChangeRequest is converted to wire format in the send
+    /// buffer, along with the requests following it in the queue in the
+    /// binary format (see NameChangeSender::marshalRequests()), and the
+    /// buffer is sent to the listener's socket.
+    ///
+    /// @param ncr NameChangeRequest to send.
+    virtual void doSend(NameChangeRequestPtr& ncr);
+
+    /// @brief Implements the NameChangeRequest level send completion handler.
+    ///
+    /// The outcome of the send is passed to the application layer by calling
+    /// invokeSendHandler().  Failures are logged.
+    ///
+    /// @param error_code the outcome of the send
+    /// @param bytes_transferred the length of the datagram sent
+    void sendCompletionHandler(const asio::error_code& error_code,
+                               const size_t bytes_transferred);
+
+    /// @brief Returns a file descriptor suitable for use with select
+    ///
+    /// @return Returns an "open" file descriptor which is ready while a
+    /// send is in progress.
+    ///
+    /// @throw NcrSenderError if the sender is not in send mode,
+    virtual int getSelectFd();
+
+    /// @brief Returns whether or not the sender has IO ready to process.
+    ///
+    /// @return true if the sender has at IO ready, false otherwise.
+    virtual bool ioReady();
+
+    /// @brief Returns the path of the target listener's socket.
+    const std::string& getServerPath() const {
+        return (server_path_);
+    }
+
+private:
+    /// @brief Path of the target listener's socket.
+    std::string server_path_;
+
+    /// @brief Wire format of the outbound requests.
+    NameChangeFormat format_;
+
+    /// @brief The sending socket.
+    boost::shared_ptr<asio::local::datagram_protocol::socket> socket_;
+
+    /// @brief The buffer being sent.
+    bundy::util::OutputBuffer send_buffer_;
+
+    /// @brief Pointer to WatchSocket instance supplying the "select-fd".
+    WatchSocketPtr watch_socket_;
+
+    ///
+    /// @name Copy and constructor assignment operator
+    ///
+    /// The copy constructor and assignment operator are private to avoid
+    /// potential issues with multiple senders attempting to share sockets.
+private:
+    NameChangeUnixSender(const NameChangeUnixSender& source);
+    NameChangeUnixSender& operator=(const NameChangeUnixSender& source);
+    //@}
+};
+
+} // namespace bundy::dhcp_ddns
+} // namespace bundy
+
+#endif
@@ -160,6 +160,7 @@ public:
     NameChangeListener::Result result_;
     NameChangeRequestPtr sent_ncr_;
     NameChangeRequestPtr received_ncr_;
+    std::vector<NameChangeRequestPtr> received_ncrs_;
     NameChangeListenerPtr listener_;
     bundy::asiolink::IntervalTimer test_timer_;
 
@@ -194,7 +195,11 @@ public:
         // Now use the NCR to write JSON to an output buffer.
         bundy::util::OutputBuffer ncr_buffer(1024);
         ASSERT_NO_THROW(sent_ncr_->toFormat(FMT_JSON, ncr_buffer));
+        sendBuffer(ncr_buffer);
+    }
 
+    /// @brief Sends the content of a buffer to the listener.
+    void sendBuffer(const bundy::util::OutputBuffer& ncr_buffer) {
         // Create a UDP socket through which our "sender" will send the NCR.
         asio::ip::udp::socket
             udp_socket(io_service_.get_io_service(), asio::ip::udp::v4());
@@ -222,6 +227,7 @@ public:
         // save the result and the NCR we received
         result_ = result;
         received_ncr_ = ncr;
+        received_ncrs_.push_back(ncr);
     }
     // @brief Handler invoked when test timeout is hit.
     //
@@ -269,6 +275,53 @@ TEST_F(NameChangeUDPListenerTest, basicReceivetest) {
     EXPECT_FALSE(listener_->isIoPending());
 }
 
+/// @brief Tests NameChangeUDPListener ability to receive several NCRs in
+/// one datagram.
+/// This test verifies that all the requests of a datagram are delivered, and
+/// that those preceding an invalid request are still delivered.
+TEST_F(NameChangeUDPListenerTest, multipleReceiveTest) {
+    ASSERT_NO_THROW(listener_->startListening(io_service_));
+
+    // Put all the requests in one datagram.
+    std::vector<NameChangeRequestPtr> sent_ncrs;
+    bundy::util::OutputBuffer ncr_buffer(1024);
+    int num_msgs = sizeof(valid_msgs)/sizeof(char*);
+    for (int i = 0; i < num_msgs; i++) {
+        NameChangeRequestPtr ncr;
+        ASSERT_NO_THROW(ncr = NameChangeRequest::fromJSON(valid_msgs[i]));
+        ASSERT_NO_THROW(ncr->toFormat(FMT_JSON, ncr_buffer));
+        sent_ncrs.push_back(ncr);
+    }
+    ASSERT_NO_THROW(sendBuffer(ncr_buffer));
+    EXPECT_NO_THROW(io_service_.run_one());
+
+    ASSERT_EQ(num_msgs, received_ncrs_.size());
+    for (int i = 0; i < num_msgs; i++) {
+        EXPECT_TRUE(checkSendVsReceived(sent_ncrs[i], received_ncrs_[i]));
+    }
+    EXPECT_TRUE(listener_->amListening());
+    EXPECT_TRUE(listener_->isIoPending());
+
+    // Append garbage: the valid requests are delivered, the rest dropped.
+    received_ncrs_.clear();
+    ncr_buffer.writeUint16(3);
+    ncr_buffer.writeData("{{{", 3);
+    ASSERT_NO_THROW(sent_ncrs[0]->toFormat(FMT_JSON, ncr_buffer));
+    ASSERT_NO_THROW(sendBuffer(ncr_buffer));
+    EXPECT_NO_THROW(io_service_.run_one());
+    EXPECT_EQ(num_msgs, received_ncrs_.size());
+
+    // Verify that the listener still receives.
+    received_ncrs_.clear();
+    ASSERT_NO_THROW(sendNcr(valid_msgs[0]));
+    EXPECT_NO_THROW(io_service_.run_one());
+    ASSERT_EQ(1, received_ncrs_.size());
+    EXPECT_TRUE(checkSendVsReceived(sent_ncr_, received_ncrs_[0]));
+
+    EXPECT_NO_THROW(listener_->stopListening());
+    EXPECT_NO_THROW(io_service_.run_one());
+}
+
 /// @brief A NOP derivation for constructor test purposes.
 class SimpleSendHandler : public NameChangeSender::RequestSendHandler {
 public:
@@ -535,6 +588,127 @@ TEST(NameChangeUDPSenderBasicTest, anyAddressSend) {
     EXPECT_EQ(0, sender.getQueueSize());
 }
 
+/// @brief A sender keeping the buffers sent, without doing any IO.
+class BufferSender : public NameChangeSender {
+public:
+    BufferSender(const NameChangeFormat format, const size_t max_length,
+                 RequestSendHandler& handler)
+        : NameChangeSender(handler), format_(format),
+          max_length_(max_length), buffer_(max_length) {
+    }
+
+    /// @brief Completes the send in progress.
+    void complete(const Result result) {
+        invokeSendHandler(result);
+    }
+
+    virtual int getSelectFd() {
+        return (-1);
+    }
+
+    virtual bool ioReady() {
+        return (false);
+    }
+
+    /// @brief The number of requests in each buffer sent.
+    std::vector<size_t> counts_;
+
+    NameChangeFormat format_;
+    size_t max_length_;
+    bundy::util::OutputBuffer buffer_;
+
+protected:
+    virtual void open(bundy::asiolink::IOService&) {
+    }
+
+    virtual void close() {
+    }
+
+    virtual void doSend(NameChangeRequestPtr&) {
+        buffer_.clear();
+        counts_.push_back(marshalRequests(format_, buffer_, max_length_));
+    }
+};
+
+/// @brief Tests that the requests in the binary format are sent together.
+/// This test verifies that:
+/// 1. The requests queued while a send is in progress go in the next one,
+/// up to the maximum length of the buffer and MAX_BATCH_SIZE requests.
+/// 2. The handler is called for each request when the send succeeds.
+/// 3. The requests stay queued when the send fails.
+/// 4. The requests in JSON are sent one by one.
+TEST(NameChangeSender, batchSend) {
+    bundy::asiolink::IOService io_service;
+    SimpleSendHandler ncr_handler;
+    NameChangeRequestPtr ncr;
+    ASSERT_NO_THROW(ncr = NameChangeRequest::fromJSON(valid_msgs[0]));
+    bundy::util::OutputBuffer one(1024);
+    ASSERT_NO_THROW(ncr->toFormat(FMT_BINARY, one));
+
+    // Room for three requests.
+    BufferSender sender(FMT_BINARY, 3 * one.getLength() + 1, ncr_handler);
+    ASSERT_NO_THROW(sender.startSending(io_service));
+    for (int i = 0; i < 8; i++) {
+        ASSERT_NO_THROW(sender.sendRequest(ncr));
+    }
+
+    // The first request was sent alone.
+    ASSERT_EQ(1, sender.counts_.size());
+    EXPECT_EQ(1, sender.counts_[0]);
+    EXPECT_EQ(one.getLength(), sender.buffer_.getLength());
+
+    // A failure leaves the request queued.
+    sender.complete(NameChangeSender::ERROR);
+    EXPECT_EQ(1, ncr_handler.error_count_);
+    EXPECT_EQ(8, sender.getQueueSize());
+
+    // The next requests are sent three by three.
+    ASSERT_EQ(2, sender.counts_.size());
+    EXPECT_EQ(3, sender.counts_[1]);
+    EXPECT_EQ(3 * one.getLength(), sender.buffer_.getLength());
+    sender.complete(NameChangeSender::SUCCESS);
+    EXPECT_EQ(3, ncr_handler.pass_count_);
+    EXPECT_EQ(5, sender.getQueueSize());
+
+    sender.complete(NameChangeSender::SUCCESS);
+    sender.complete(NameChangeSender::SUCCESS);
+    EXPECT_EQ(8, ncr_handler.pass_count_);
+    EXPECT_EQ(0, sender.getQueueSize());
+    ASSERT_EQ(4, sender.counts_.size());
+    EXPECT_EQ(2, sender.counts_[3]);
+    EXPECT_FALSE(sender.isSendInProgress());
+
+    // Check the buffer holds the requests.
+    bundy::util::InputBuffer input_buffer(sender.buffer_.getData(),
+                                        sender.buffer_.getLength());
+    for (int i = 0; i < 2; i++) {
+        NameChangeRequestPtr ncr2;
+        ASSERT_NO_THROW(ncr2 = NameChangeRequest::fromFormat(FMT_BINARY,
+                                                             input_buffer));
+        EXPECT_TRUE(checkSendVsReceived(ncr, ncr2));
+    }
+
+    // No more than MAX_BATCH_SIZE requests are sent at once.
+    BufferSender large_sender(FMT_BINARY, 65535, ncr_handler);
+    ASSERT_NO_THROW(large_sender.startSending(io_service));
+    for (int i = 0; i < NameChangeSender::MAX_BATCH_SIZE + 2; i++) {
+        ASSERT_NO_THROW(large_sender.sendRequest(ncr));
+    }
+    large_sender.complete(NameChangeSender::SUCCESS);
+    ASSERT_EQ(2, large_sender.counts_.size());
+    EXPECT_EQ(NameChangeSender::MAX_BATCH_SIZE, large_sender.counts_[1]);
+
+    // The requests in JSON are sent one by one.
+    BufferSender json_sender(FMT_JSON, 65535, ncr_handler);
+    ASSERT_NO_THROW(json_sender.startSending(io_service));
+    for (int i = 0; i < 3; i++) {
+        ASSERT_NO_THROW(json_sender.sendRequest(ncr));
+    }
+    json_sender.complete(NameChangeSender::SUCCESS);
+    ASSERT_EQ(2, json_sender.counts_.size());
+    EXPECT_EQ(1, json_sender.counts_[1]);
+}
+
 /// @brief Test the NameChangeSender::assumeQueue method.
 TEST(NameChangeSender, assumeQueue) {
     bundy::asiolink::IOAddress ip_address(TEST_ADDRESS);
@@ -608,8 +782,8 @@ TEST(NameChangeSender, assumeQueue) {
 /// It derives from both the receive and send handler classes and contains
 /// and instance of UDP listener and UDP sender.
 class NameChangeUDPTest : public virtual ::testing::Test,
-                          NameChangeListener::RequestReceiveHandler,
-                          NameChangeSender::RequestSendHandler {
+                          public NameChangeListener::RequestReceiveHandler,
+                          public NameChangeSender::RequestSendHandler {
 public:
     bundy::asiolink::IOService io_service_;
     NameChangeListener::Result recv_result_;
@@ -724,6 +898,44 @@ TEST_F (NameChangeUDPTest, roundTripTest) {
     EXPECT_FALSE(sender_->amSending());
 }
 
+/// @brief Uses a sender and listener to test UDP-based NCR delivery in the
+/// binary format, with several requests per datagram.
+TEST_F (NameChangeUDPTest, binaryRoundTripTest) {
+    bundy::asiolink::IOAddress addr(TEST_ADDRESS);
+    listener_.reset(new NameChangeUDPListener(addr, LISTENER_PORT,
+                                              FMT_BINARY, *this, true));
+    sender_.reset(new NameChangeUDPSender(addr, SENDER_PORT, addr,
+                                          LISTENER_PORT, FMT_BINARY, *this,
+                                          100, true));
+    ASSERT_NO_THROW(listener_->startListening(io_service_));
+    ASSERT_NO_THROW(sender_->startSending(io_service_));
+
+    // The first request is sent alone, the others together.
+    const int num_msgs = 50;
+    int num_valid = sizeof(valid_msgs)/sizeof(char*);
+    for (int i = 0; i < num_msgs; i++) {
+        NameChangeRequestPtr ncr;
+        ASSERT_NO_THROW(ncr = NameChangeRequest::
+                        fromJSON(valid_msgs[i % num_valid]));
+        sender_->sendRequest(ncr);
+    }
+
+    // Execute callbacks until we have sent and received all of messages.
+    while (sender_->getQueueSize() > 0 || (received_ncrs_.size() < num_msgs)) {
+        EXPECT_NO_THROW(io_service_.run_one());
+    }
+
+    ASSERT_EQ(num_msgs, sent_ncrs_.size());
+    ASSERT_EQ(num_msgs, received_ncrs_.size());
+    for (int i = 0; i < num_msgs; i++) {
+        EXPECT_TRUE (checkSendVsReceived(sent_ncrs_[i], received_ncrs_[i]));
+    }
+
+    EXPECT_NO_THROW(listener_->stopListening());
+    EXPECT_NO_THROW(io_service_.run_one());
+    EXPECT_NO_THROW(sender_->stopSending());
+}
+
 // Tests error handling of a failure to mark the watch socket ready, when
 // sendRequestt() is called.
 TEST(NameChangeUDPSenderBasicTest, watchClosedBeforeSendRequest) {
@@ -586,6 +586,88 @@ TEST(NameChangeRequestTest, toFromBufferTest) {
     ASSERT_EQ(final_str, msg_str);
 }
 
+/// @brief Tests converting to and from the binary format.
+/// This test verifies that:
+/// 1. Valid requests, IPv4 and IPv6, survive the round trip.
+/// 2. Several requests written to the same buffer are read back in turn.
+/// 3. The bytes of a request beyond its known fields are skipped.
+TEST(NameChangeRequestTest, toFromBinaryTest) {
+    bundy::util::OutputBuffer output_buffer(1024);
+    std::vector<NameChangeRequestPtr> ncrs;
+    int num_msgs = sizeof(valid_msgs)/sizeof(char*);
+    for (int i = 0; i < num_msgs; i++) {
+        NameChangeRequestPtr ncr;
+        ASSERT_NO_THROW(ncr = NameChangeRequest::fromJSON(valid_msgs[i]));
+        ncr->setReverseChange(true);
+        ASSERT_NO_THROW(ncr->toFormat(FMT_BINARY, output_buffer));
+        ncrs.push_back(ncr);
+    }
+
+    // A longer request, as written by a later version.
+    const size_t extended = output_buffer.getLength();
+    ASSERT_NO_THROW(ncrs[0]->toFormat(FMT_BINARY, output_buffer));
+    output_buffer.writeUint32(0xdeadbeef);
+    const uint16_t length = (output_buffer[extended] << 8) +
+        output_buffer[extended + 1];
+    output_buffer.writeUint16At(length + sizeof(uint32_t), extended);
+    ncrs.push_back(ncrs[0]);
+
+    // The binary rendition is more compact than JSON.
+    bundy::util::OutputBuffer json_buffer(1024);
+    ASSERT_NO_THROW(ncrs[0]->toFormat(FMT_JSON, json_buffer));
+    EXPECT_LT(extended / num_msgs, json_buffer.getLength() / 2);
+
+    bundy::util::InputBuffer input_buffer(output_buffer.getData(),
+                                        output_buffer.getLength());
+    for (int i = 0; i < ncrs.size(); i++) {
+        NameChangeRequestPtr ncr;
+        ASSERT_NO_THROW(ncr = NameChangeRequest::fromFormat(FMT_BINARY,
+                                                            input_buffer));
+        ASSERT_TRUE(ncr);
+        EXPECT_TRUE(*ncr == *ncrs[i]) << "message idx: " << i;
+        EXPECT_EQ(ncrs[i]->toJSON(), ncr->toJSON());
+    }
+    EXPECT_EQ(input_buffer.getLength(), input_buffer.getPosition());
+}
+
+/// @brief Tests a variety of invalid binary renditions.
+TEST(NameChangeRequestTest, invalidBinaryChecks) {
+    NameChangeRequestPtr ncr;
+    ASSERT_NO_THROW(ncr = NameChangeRequest::fromJSON(valid_msgs[0]));
+    bundy::util::OutputBuffer valid(1024);
+    ASSERT_NO_THROW(ncr->toFormat(FMT_BINARY, valid));
+    const uint8_t* data = static_cast<const uint8_t*>(valid.getData());
+
+    // Truncated.
+    for (size_t len = 0; len < valid.getLength(); ++len) {
+        bundy::util::InputBuffer input_buffer(data, len);
+        EXPECT_THROW(NameChangeRequest::fromFormat(FMT_BINARY, input_buffer),
+                     NcrMessageError) << "length: " << len;
+    }
+
+    // The offset of the change type, the flags and the address length.
+    const size_t change_type = 2;
+    const size_t flags = 3;
+    const size_t address_len = flags + 1 +
+        dns::Name(ncr->getFqdn()).getLength();
+    const struct {
+        size_t offset;
+        uint8_t value;
+    } invalid[] = {
+        { change_type, 2 },   // Unknown change type.
+        { flags, 0 },         // Neither forward nor reverse.
+        { address_len, 5 },   // Bad address length.
+        { 1, 8 }              // Length shorter than the fields.
+    };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i) {
+        std::vector<uint8_t> bytes(data, data + valid.getLength());
+        bytes[invalid[i].offset] = invalid[i].value;
+        bundy::util::InputBuffer input_buffer(&bytes[0], bytes.size());
+        EXPECT_THROW(NameChangeRequest::fromFormat(FMT_BINARY, input_buffer),
+                     NcrMessageError) << "invalid idx: " << i;
+    }
+}
+
 /// @brief Tests ip address modification and validation
 TEST(NameChangeRequestTest, ipAddresses) {
     NameChangeRequest ncr;
@@ -612,9 +694,12 @@ TEST(NameChangeRequestTest, ipAddresses) {
 TEST(NameChangeFormatTest, formatEnumConversion){
     ASSERT_EQ(stringToNcrFormat("JSON"), dhcp_ddns::FMT_JSON);
     ASSERT_EQ(stringToNcrFormat("jSoN"), dhcp_ddns::FMT_JSON);
+    ASSERT_EQ(stringToNcrFormat("BINARY"), dhcp_ddns::FMT_BINARY);
+    ASSERT_EQ(stringToNcrFormat("binary"), dhcp_ddns::FMT_BINARY);
     ASSERT_THROW(stringToNcrFormat("bogus"), bundy::BadValue);
 
     ASSERT_EQ(ncrFormatToString(dhcp_ddns::FMT_JSON), "JSON");
+    ASSERT_EQ(ncrFormatToString(dhcp_ddns::FMT_BINARY), "BINARY");
 }
 
 /// @brief Tests conversion of NameChangeProtocol between enum and strings.
@@ -623,10 +708,13 @@ TEST(NameChangeProtocolTest, protocolEnumConversion){
     ASSERT_EQ(stringToNcrProtocol("udP"), dhcp_ddns::NCR_UDP);
     ASSERT_EQ(stringToNcrProtocol("TCP"), dhcp_ddns::NCR_TCP);
     ASSERT_EQ(stringToNcrProtocol("Tcp"), dhcp_ddns::NCR_TCP);
+    ASSERT_EQ(stringToNcrProtocol("UNIX"), dhcp_ddns::NCR_UNIX);
+    ASSERT_EQ(stringToNcrProtocol("unix"), dhcp_ddns::NCR_UNIX);
     ASSERT_THROW(stringToNcrProtocol("bogus"), bundy::BadValue);
 
     ASSERT_EQ(ncrProtocolToString(dhcp_ddns::NCR_UDP), "UDP");
     ASSERT_EQ(ncrProtocolToString(dhcp_ddns::NCR_TCP), "TCP");
+    ASSERT_EQ(ncrProtocolToString(dhcp_ddns::NCR_UNIX), "UNIX");
 }
 
 } // end of anonymous namespace
@@ -0,0 +1,252 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <asiolink/interval_timer.h>
+#include <dhcp_ddns/ncr_unix.h>
+#include <test_utils.h>
+
+#include <boost/bind.hpp>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace bundy;
+using namespace bundy::dhcp_ddns;
+
+namespace {
+
+/// @brief Defines a list of valid JSON NameChangeRequest test messages.
+const char *valid_msgs[] =
+{
+    // Valid Add.
+     "{"
+     " \"change_type\" : 0 , "
+     " \"forward_change\" : true , "
+     " \"reverse_change\" : false , "
+     " \"fqdn\" : \"walah.walah.com\" , "
+     " \"ip_address\" : \"192.168.2.1\" , "
+     " \"dhcid\" : \"010203040A7F8E3D\" , "
+     " \"lease_expires_on\" : \"20130121132405\" , "
+     " \"lease_length\" : 1300 "
+     "}",
+    // Valid Remove.
+     "{"
+     " \"change_type\" : 1 , "
+     " \"forward_change\" : true , "
+     " \"reverse_change\" : true , "
+     " \"fqdn\" : \"walah.walah.com\" , "
+     " \"ip_address\" : \"192.168.2.1\" , "
+     " \"dhcid\" : \"010203040A7F8E3D\" , "
+     " \"lease_expires_on\" : \"20130121132405\" , "
+     " \"lease_length\" : 1300 "
+     "}",
+     // Valid Add with IPv6 address
+     "{"
+     " \"change_type\" : 0 , "
+     " \"forward_change\" : true , "
+     " \"reverse_change\" : false , "
+     " \"fqdn\" : \"walah.walah.com\" , "
+     " \"ip_address\" : \"fe80::2acf:e9ff:fe12:e56f\" , "
+     " \"dhcid\" : \"010203040A7F8E3D\" , "
+     " \"lease_expires_on\" : \"20130121132405\" , "
+     " \"lease_length\" : 1300 "
+     "}"
+};
+
+/// @brief Returns the path of the test socket.
+std::string
+testSocketPath() {
+    return (std::string(TEST_DATA_BUILDDIR) + "/ncr-test.sock");
+}
+
+/// @brief Returns true if a file exists.
+bool
+fileExists(const std::string& path) {
+    struct stat st;
+    return (stat(path.c_str(), &st) == 0);
+}
+
+/// @brief Tests the constructors of the Unix socket listener and sender.
+/// This test verifies that the socket path must be neither empty nor too
+/// long, and that it is kept.
+TEST(NameChangeUnixBasicTest, constructionTests) {
+    NameChangeListener::RequestReceiveHandler* recv_handler = NULL;
+    NameChangeSender::RequestSendHandler* send_handler = NULL;
+    const std::string long_path(200, 'x');
+
+    EXPECT_THROW(NameChangeUnixListener("", FMT_BINARY, *recv_handler),
+                 NcrUnixError);
+    EXPECT_THROW(NameChangeUnixListener(long_path, FMT_BINARY, *recv_handler),
+                 NcrUnixError);
+    EXPECT_THROW(NameChangeUnixSender("", FMT_BINARY, *send_handler),
+                 NcrUnixError);
+    EXPECT_THROW(NameChangeUnixSender(long_path, FMT_BINARY, *send_handler),
+                 NcrUnixError);
+
+    NameChangeUnixListener listener(testSocketPath(), FMT_BINARY,
+                                    *recv_handler);
+    EXPECT_EQ(testSocketPath(), listener.getSocketPath());
+    EXPECT_FALSE(listener.amListening());
+
+    NameChangeUnixSender sender(testSocketPath(), FMT_BINARY, *send_handler);
+    EXPECT_EQ(testSocketPath(), sender.getServerPath());
+    EXPECT_FALSE(sender.amSending());
+}
+
+/// @brief Text fixture that allows testing a listener and sender together
+/// over a Unix domain socket.
+class NameChangeUnixTest : public virtual ::testing::Test,
+                           public NameChangeListener::RequestReceiveHandler,
+                           public NameChangeSender::RequestSendHandler {
+public:
+    bundy::asiolink::IOService io_service_;
+    std::vector<NameChangeListener::Result> recv_results_;
+    std::vector<NameChangeSender::Result> send_results_;
+    std::vector<NameChangeRequestPtr> sent_ncrs_;
+    std::vector<NameChangeRequestPtr> received_ncrs_;
+    bundy::asiolink::IntervalTimer test_timer_;
+
+    /// @brief Constructor
+    ///
+    /// Sets the test timer to abort the test if it runs too long.
+    NameChangeUnixTest() : io_service_(), test_timer_(io_service_) {
+        unlink(testSocketPath().c_str());
+        test_timer_.setup(boost::bind(&NameChangeUnixTest::testTimeoutHandler,
+                                      this), 5000);
+    }
+
+    ~NameChangeUnixTest() {
+        unlink(testSocketPath().c_str());
+    }
+
+    /// @brief Implements the receive result handler.
+    virtual void operator ()(const NameChangeListener::Result result,
+                             NameChangeRequestPtr& ncr) {
+        recv_results_.push_back(result);
+        if (ncr) {
+            received_ncrs_.push_back(ncr);
+        }
+    }
+
+    /// @brief Implements the send completion handler.
+    virtual void operator ()(const NameChangeSender::Result result,
+                             NameChangeRequestPtr& ncr) {
+        send_results_.push_back(result);
+        if (result == NameChangeSender::SUCCESS) {
+            sent_ncrs_.push_back(ncr);
+        }
+    }
+
+    /// @brief Handler invoked when test timeout is hit.
+    ///
+    /// This callback stops all running (hanging) tasks on IO service.
+    void testTimeoutHandler() {
+        io_service_.stop();
+        FAIL() << "Test timeout hit.";
+    }
+};
+
+/// @brief Uses a sender and listener to test the delivery of requests over
+/// a Unix domain socket, in each format.
+TEST_F(NameChangeUnixTest, roundTripTest) {
+    const NameChangeFormat formats[] = { FMT_BINARY, FMT_JSON };
+    int num_valid = sizeof(valid_msgs)/sizeof(char*);
+    for (int f = 0; f < 2; ++f) {
+        SCOPED_TRACE(ncrFormatToString(formats[f]));
+        sent_ncrs_.clear();
+        received_ncrs_.clear();
+
+        NameChangeUnixListener listener(testSocketPath(), formats[f], *this);
+        NameChangeUnixSender sender(testSocketPath(), formats[f], *this);
+        ASSERT_NO_THROW(listener.startListening(io_service_));
+        EXPECT_TRUE(fileExists(testSocketPath()));
+        ASSERT_NO_THROW(sender.startSending(io_service_));
+
+        const int num_msgs = 20;
+        for (int i = 0; i < num_msgs; i++) {
+            NameChangeRequestPtr ncr;
+            ASSERT_NO_THROW(ncr = NameChangeRequest::
+                            fromJSON(valid_msgs[i % num_valid]));
+            ASSERT_NO_THROW(sender.sendRequest(ncr));
+        }
+
+        // Execute callbacks until we have sent and received all of messages.
+        while (sender.getQueueSize() > 0 ||
+               (received_ncrs_.size() < num_msgs)) {
+            ASSERT_NO_THROW(io_service_.run_one());
+        }
+
+        ASSERT_EQ(num_msgs, sent_ncrs_.size());
+        ASSERT_EQ(num_msgs, received_ncrs_.size());
+        for (int i = 0; i < num_msgs; i++) {
+            EXPECT_TRUE(*sent_ncrs_[i] == *received_ncrs_[i]);
+        }
+
+        EXPECT_NO_THROW(sender.stopSending());
+        EXPECT_NO_THROW(listener.stopListening());
+        EXPECT_NO_THROW(io_service_.run_one());
+        EXPECT_FALSE(listener.amListening());
+
+        // The socket file is removed.
+        EXPECT_FALSE(fileExists(testSocketPath()));
+    }
+}
+
+/// @brief Verifies that a send fails when no listener is bound to the path,
+/// and that the request stays queued to be sent again.
+TEST_F(NameChangeUnixTest, noListenerTest) {
+    NameChangeUnixSender sender(testSocketPath(), FMT_BINARY, *this);
+    ASSERT_NO_THROW(sender.startSending(io_service_));
+
+    NameChangeRequestPtr ncr;
+    ASSERT_NO_THROW(ncr = NameChangeRequest::fromJSON(valid_msgs[0]));
+    ASSERT_NO_THROW(sender.sendRequest(ncr));
+    EXPECT_TRUE(sender.ioReady());
+    ASSERT_NO_THROW(io_service_.run_one());
+
+    ASSERT_EQ(1, send_results_.size());
+    EXPECT_EQ(NameChangeSender::ERROR, send_results_[0]);
+    EXPECT_EQ(1, sender.getQueueSize());
+    EXPECT_TRUE(sender.isSendInProgress());
+
+    EXPECT_NO_THROW(sender.stopSending());
+}
+
+/// @brief Verifies that the listener replaces a socket file left behind.
+TEST_F(NameChangeUnixTest, staleSocketTest) {
+    {
+        NameChangeUnixListener listener(testSocketPath(), FMT_BINARY, *this);
+        ASSERT_NO_THROW(listener.startListening(io_service_));
+        // Leave the file behind, as a crash would.
+        ASSERT_EQ(0, link(testSocketPath().c_str(),
+                          (testSocketPath() + ".bak").c_str()));
+        EXPECT_NO_THROW(listener.stopListening());
+        EXPECT_NO_THROW(io_service_.run_one());
+        ASSERT_EQ(0, rename((testSocketPath() + ".bak").c_str(),
+                            testSocketPath().c_str()));
+    }
+    ASSERT_TRUE(fileExists(testSocketPath()));
+
+    NameChangeUnixListener listener(testSocketPath(), FMT_BINARY, *this);
+    EXPECT_NO_THROW(listener.startListening(io_service_));
+    EXPECT_TRUE(listener.amListening());
+    EXPECT_NO_THROW(listener.stopListening());
+}
+
+} // end of anonymous namespace
@@ -12,19 +12,34 @@
 // OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
+#include <dhcp/option_data_types.h>
+#include <dhcp_ddns/ncr_msg.h>
 #include <dhcpsrv/alloc_engine.h>
+#include <dhcpsrv/cfgmgr.h>
 #include <dhcpsrv/dhcpsrv_log.h>
 #include <dhcpsrv/lease_mgr_factory.h>
 
 #include <hooks/server_hooks.h>
 #include <hooks/hooks_manager.h>
 
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <algorithm>
 #include <cstring>
+#include <ctime>
+#include <limits>
+#include <set>
 #include <vector>
 #include <string.h>
+#include <unistd.h>
 
 using namespace bundy::asiolink;
 using namespace bundy::hooks;
+using namespace bundy::dhcp;
+using namespace bundy::dhcp_ddns;
+using boost::posix_time::microsec_clock;
+using boost::posix_time::ptime;
+using bundy::util::thread::Mutex;
 
 namespace {
 
@@ -33,12 +48,16 @@ struct AllocEngineHooks {
     int hook_index_lease4_select_; ///< index for "lease4_receive" hook point
     int hook_index_lease4_renew_;  ///< index for "lease4_renew" hook point
     int hook_index_lease6_select_; ///< index for "lease6_receive" hook point
+    int hook_index_lease4_expire_; ///< index for "lease4_expire" hook point
+    int hook_index_lease6_expire_; ///< index for "lease6_expire" hook point
 
     /// Constructor that registers hook points for AllocationEngine
     AllocEngineHooks() {
         hook_index_lease4_select_ = HooksManager::registerHook("lease4_select");
         hook_index_lease4_renew_  = HooksManager::registerHook("lease4_renew");
         hook_index_lease6_select_ = HooksManager::registerHook("lease6_select");
+        hook_index_lease4_expire_ = HooksManager::registerHook("lease4_expire");
+        hook_index_lease6_expire_ = HooksManager::registerHook("lease6_expire");
     }
 };
 
@@ -48,6 +67,176 @@ struct AllocEngineHooks {
 // module is called.
 AllocEngineHooks Hooks;
 
+/// Largest offset in a pool, the larger ones saturate to it
+const uint64_t MAX_OFFSET = std::numeric_limits<uint64_t>::max();
+
+/// @brief Splits an address into two 64-bit halves.
+void
+toHalves(const IOAddress& addr, uint64_t& high, uint64_t& low) {
+    const std::vector<uint8_t>& bytes = addr.toBytes();
+    const size_t split = bytes.size() > 8 ? bytes.size() - 8 : 0;
+    high = low = 0;
+    for (size_t i = 0; i < split; ++i) {
+        high = (high << 8) | bytes[i];
+    }
+    for (size_t i = split; i < bytes.size(); ++i) {
+        low = (low << 8) | bytes[i];
+    }
+}
+
+/// @brief Returns the number of the bits below the delegated prefixes of a
+/// pool (0 for the address pools).
+unsigned int
+poolShift(const PoolPtr& pool) {
+    if (pool->getType() == Lease::TYPE_PD) {
+        Pool6Ptr pool6 = boost::dynamic_pointer_cast<Pool6>(pool);
+        if (pool6) {
+            return (128 - pool6->getLength());
+        }
+    }
+    return (0);
+}
+
+/// @brief Returns the position of an address (or prefix) in a pool.
+///
+/// The positions which don't fit 64 bits saturate to MAX_OFFSET.
+uint64_t
+poolOffset(const PoolPtr& pool, const IOAddress& addr) {
+    uint64_t high, low, first_high, first_low;
+    toHalves(addr, high, low);
+    toHalves(pool->getFirstAddress(), first_high, first_low);
+    high -= first_high + (low < first_low ? 1 : 0);
+    low -= first_low;
+    const unsigned int shift = poolShift(pool);
+    if (shift >= 64) {
+        return (high >> (shift - 64));
+    } else if (shift > 0) {
+        if ((high >> shift) != 0) {
+            return (MAX_OFFSET);
+        }
+        return ((high << (64 - shift)) | (low >> shift));
+    }
+    return (high != 0 ? MAX_OFFSET : low);
+}
+
+/// @brief Returns the number of the addresses (or prefixes) in a pool,
+/// saturated to MAX_OFFSET.
+uint64_t
+poolCapacity(const PoolPtr& pool) {
+    const uint64_t last = poolOffset(pool, pool->getLastAddress());
+    return (last == MAX_OFFSET ? MAX_OFFSET : last + 1);
+}
+
+/// @brief Returns the address (or prefix) at a position in a pool.
+IOAddress
+poolAddress(const PoolPtr& pool, uint64_t offset) {
+    uint64_t high, low;
+    toHalves(pool->getFirstAddress(), high, low);
+    const unsigned int shift = poolShift(pool);
+    uint64_t add_high = 0, add_low = offset;
+    if (shift >= 64) {
+        add_high = offset << (shift - 64);
+        add_low = 0;
+    } else if (shift > 0) {
+        add_high = offset >> (64 - shift);
+        add_low = offset << shift;
+    }
+    low += add_low;
+    high += add_high + (low < add_low ? 1 : 0);
+
+    if (pool->getFirstAddress().isV4()) {
+        return (IOAddress(static_cast<uint32_t>(low)));
+    }
+    uint8_t packed[V6ADDRESS_LEN];
+    for (int i = 0; i < 8; ++i) {
+        packed[7 - i] = static_cast<uint8_t>(high >> (8 * i));
+        packed[15 - i] = static_cast<uint8_t>(low >> (8 * i));
+    }
+    return (IOAddress::fromBytes(AF_INET6, packed));
+}
+
+/// @brief Returns the position of the first clear bit at or after the
+/// offset, wrapping around the end.
+///
+/// The bits past the capacity are ignored.  There must be a clear bit.
+uint64_t
+findFree(const std::vector<uint64_t>& bitmap, uint64_t capacity,
+         uint64_t offset) {
+    const size_t words = bitmap.size();
+    size_t word = offset / 64;
+    // The bits before the offset are checked last, after wrapping around.
+    uint64_t used = bitmap[word] | ((1ULL << (offset % 64)) - 1);
+    for (size_t i = 0; i <= words; ++i) {
+        if (word == words - 1 && capacity % 64 != 0) {
+            used |= ~((1ULL << (capacity % 64)) - 1);
+        }
+        if (~used != 0) {
+            unsigned int bit = 0;
+            while (used & (1ULL << bit)) {
+                ++bit;
+            }
+            return (word * 64 + bit);
+        }
+        word = (word + 1) % words;
+        used = bitmap[word];
+    }
+    bundy_throw(bundy::Unexpected, "No free address in the pool bitmap");
+}
+
+/// @brief Computes the DHCID of an IPv4 lease, from the client identifier
+/// or the hardware address.
+D2Dhcid
+computeDhcid(const Lease4& lease, const std::vector<uint8_t>& fqdn_wire) {
+    if (lease.client_id_) {
+        return (D2Dhcid(lease.client_id_->getClientId(), fqdn_wire));
+    }
+    HWAddrPtr hwaddr(new HWAddr(lease.hwaddr_, HTYPE_ETHER));
+    return (D2Dhcid(hwaddr, fqdn_wire));
+}
+
+/// @brief Computes the DHCID of an IPv6 lease, from the DUID.
+D2Dhcid
+computeDhcid(const Lease6& lease, const std::vector<uint8_t>& fqdn_wire) {
+    if (!lease.duid_) {
+        bundy_throw(bundy::BadValue, "the lease has no DUID");
+    }
+    return (D2Dhcid(*lease.duid_, fqdn_wire));
+}
+
+/// @brief Asks bundy-dhcp-ddns to remove the DNS records of a reclaimed
+/// lease, if any were added for it.
+template <typename LeaseType>
+void
+queueRemovalRequest(const LeaseType& lease) {
+    if ((!lease.fqdn_fwd_ && !lease.fqdn_rev_) || lease.hostname_.empty()) {
+        return;
+    }
+    D2ClientMgr& d2_mgr = CfgMgr::instance().getD2ClientMgr();
+    if (!d2_mgr.ddnsEnabled() || !d2_mgr.amSending()) {
+        return;
+    }
+
+    try {
+        // The DHCID is computed from the hostname in the canonical wire
+        // format (RFC4701, section 3.5).
+        std::vector<uint8_t> fqdn_wire;
+        OptionDataTypeUtil::writeFqdn(lease.hostname_, fqdn_wire, true);
+        NameChangeRequestPtr ncr(new NameChangeRequest(CHG_REMOVE,
+                                                       lease.fqdn_fwd_,
+                                                       lease.fqdn_rev_,
+                                                       lease.hostname_,
+                                                       lease.addr_.toText(),
+                                                       computeDhcid(lease,
+                                                                    fqdn_wire),
+                                                       lease.getExpirationTime(),
+                                                       lease.valid_lft_));
+        d2_mgr.sendRequest(ncr);
+    } catch (const bundy::Exception& ex) {
+        LOG_ERROR(dhcpsrv_logger, DHCPSRV_RECLAIM_DDNS_FAIL)
+            .arg(lease.addr_.toText()).arg(ex.what());
+    }
+}
+
 }; // anonymous namespace
 
 namespace bundy {
@@ -146,6 +335,7 @@ bundy::asiolink::IOAddress
 AllocEngine::IterativeAllocator::pickAddress(const SubnetPtr& subnet,
                                              const DuidPtr&,
                                              const IOAddress&) {
+    Mutex::Locker lock(mutex_);
 
     // Is this prefix allocation?
     bool prefix = pool_type_ == Lease::TYPE_PD;
@@ -217,30 +407,255 @@ AllocEngine::IterativeAllocator::pickAddress(const SubnetPtr& subnet,
     return (next);
 }
 
+AllocEngine::IndexedAllocator::IndexedAllocator(Lease::Type lease_type)
+    :IterativeAllocator(lease_type) {
+}
+
+bundy::asiolink::IOAddress
+AllocEngine::IndexedAllocator::pickAddress(const SubnetPtr& subnet,
+                                           const DuidPtr& duid,
+                                           const IOAddress& hint) {
+    const LeaseIndex* index =
+        LeaseMgrFactory::instance().getLeaseIndex(pool_type_);
+    if (!index) {
+        return (IterativeAllocator::pickAddress(subnet, duid, hint));
+    }
+
+    {
+        Mutex::Locker lock(mutex_);
+
+        const PoolCollection& pools = subnet->getPools(pool_type_);
+        if (pools.empty()) {
+            bundy_throw(AllocFailed, "No pools defined in selected subnet");
+        }
+
+        // Start right after the last allocated address, in the pool it
+        // belongs to (or at the beginning of the first pool).
+        const IOAddress last = subnet->getLastAllocated(pool_type_);
+        size_t first_pool = 0;
+        IOAddress start = pools[0]->getFirstAddress();
+        for (size_t i = 0; i < pools.size(); ++i) {
+            if (!pools[i]->inRange(last)) {
+                continue;
+            }
+            first_pool = i;
+            if (pool_type_ == Lease::TYPE_PD) {
+                Pool6Ptr pool6 = boost::dynamic_pointer_cast<Pool6>(pools[i]);
+                if (!pool6) {
+                    bundy_throw(Unexpected, "Wrong type of pool: "
+                                << pools[i]->toText() << " is not Pool6");
+                }
+                start = increasePrefix(last, pool6->getLength());
+            } else {
+                start = increaseAddress(last);
+            }
+            if (!pools[i]->inRange(start)) {
+                first_pool = (i + 1) % pools.size();
+                start = pools[first_pool]->getFirstAddress();
+            }
+            break;
+        }
+
+        // Walk the pools once, the first one twice (the part before the
+        // start is searched at the end).
+        IOAddress candidate("::");
+        for (size_t i = 0; i <= pools.size(); ++i) {
+            const PoolPtr& pool = pools[(first_pool + i) % pools.size()];
+            const IOAddress from = i == 0 ? start : pool->getFirstAddress();
+            if (index->findFree(from, pool->getLastAddress(), candidate)) {
+                subnet->setLastAllocated(pool_type_, candidate);
+                return (candidate);
+            }
+        }
+
+        // The pools are full, reuse the lease which expired first.
+        const time_t now = time(NULL);
+        for (size_t i = 0; i < pools.size(); ++i) {
+            if (index->findExpired(pools[i]->getFirstAddress(),
+                                   pools[i]->getLastAddress(), now,
+                                   candidate)) {
+                return (candidate);
+            }
+        }
+    }
+
+    // Nothing free according to the index, let the engine probe the pools.
+    return (IterativeAllocator::pickAddress(subnet, duid, hint));
+}
+
 AllocEngine::HashedAllocator::HashedAllocator(Lease::Type lease_type)
     :Allocator(lease_type) {
-    bundy_throw(NotImplemented, "Hashed allocator is not implemented");
 }
 
+uint64_t
+AllocEngine::HashedAllocator::hashDuid(const DuidPtr& duid) {
+    uint64_t hash = 14695981039346656037ULL;
+    if (duid) {
+        const std::vector<uint8_t>& data = duid->getDuid();
+        for (size_t i = 0; i < data.size(); ++i) {
+            hash ^= data[i];
+            hash *= 1099511628211ULL;
+        }
+    }
+    return (hash);
+}
 
 bundy::asiolink::IOAddress
-AllocEngine::HashedAllocator::pickAddress(const SubnetPtr&,
-                                          const DuidPtr&,
-                                          const IOAddress&) {
-    bundy_throw(NotImplemented, "Hashed allocator is not implemented");
+AllocEngine::HashedAllocator::pickAddress(const SubnetPtr& subnet,
+                                          const DuidPtr& duid,
+                                          const IOAddress& hint) {
+    const PoolCollection& pools = subnet->getPools(pool_type_);
+
+    if (pools.empty()) {
+        bundy_throw(AllocFailed, "No pools defined in selected subnet");
+    }
+
+    // If the hint is in a pool, continue with the address after it.
+    for (size_t i = 0; i < pools.size(); ++i) {
+        if (pools[i]->inRange(hint)) {
+            const uint64_t offset = poolOffset(pools[i], hint);
+            if (offset < poolCapacity(pools[i]) - 1) {
+                return (poolAddress(pools[i], offset + 1));
+            }
+            return (pools[(i + 1) % pools.size()]->getFirstAddress());
+        }
+    }
+
+    // Otherwise find the position given by the hash.  The capacities
+    // saturate, so the positions in huge pools are not all reachable,
+    // which doesn't matter.
+    uint64_t total = 0;
+    for (size_t i = 0; i < pools.size(); ++i) {
+        const uint64_t capacity = poolCapacity(pools[i]);
+        total = (capacity > MAX_OFFSET - total) ? MAX_OFFSET :
+            total + capacity;
+    }
+    uint64_t position = hashDuid(duid) % total;
+    for (size_t i = 0; i < pools.size(); ++i) {
+        const uint64_t capacity = poolCapacity(pools[i]);
+        if (position < capacity) {
+            return (poolAddress(pools[i], position));
+        }
+        position -= capacity;
+    }
+    // Not reached, the total is at most the sum of the capacities.
+    return (pools[0]->getFirstAddress());
 }
 
 AllocEngine::RandomAllocator::RandomAllocator(Lease::Type lease_type)
-    :Allocator(lease_type) {
-    bundy_throw(NotImplemented, "Random allocator is not implemented");
+    :Allocator(lease_type), generator_(time(NULL) ^ getpid()) {
 }
 
+uint64_t
+AllocEngine::RandomAllocator::random() {
+    const uint64_t high = generator_();
+    return ((high << 32) | generator_());
+}
+
+AllocEngine::RandomAllocator::PoolState&
+AllocEngine::RandomAllocator::getState(const PoolPtr& pool) {
+    std::map<uint32_t, PoolState>::iterator it = pools_.find(pool->getId());
+    if (it != pools_.end()) {
+        return (it->second);
+    }
+
+    // A new pool means the configuration has changed, so this is a good
+    // time to forget the pools which are gone.
+    for (it = pools_.begin(); it != pools_.end(); ) {
+        if (it->second.pool_.expired()) {
+            pools_.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+
+    PoolState& state = pools_[pool->getId()];
+    state.pool_ = pool;
+    state.capacity_ = poolCapacity(pool);
+    state.used_ = 0;
+    if (state.capacity_ <= MAX_BITMAP_SIZE) {
+        state.bitmap_.resize((state.capacity_ + 63) / 64);
+    }
+    return (state);
+}
 
 bundy::asiolink::IOAddress
-AllocEngine::RandomAllocator::pickAddress(const SubnetPtr&,
+AllocEngine::RandomAllocator::pickAddress(const SubnetPtr& subnet,
                                           const DuidPtr&,
                                           const IOAddress&) {
-    bundy_throw(NotImplemented, "Random allocator is not implemented");
+    Mutex::Locker lock(mutex_);
+
+    const PoolCollection& pools = subnet->getPools(pool_type_);
+
+    if (pools.empty()) {
+        bundy_throw(AllocFailed, "No pools defined in selected subnet");
+    }
+
+    // Pick a pool with the probability given by its free addresses.  The
+    // sizes of the large IPv6 pools don't fit any integer, so the weights
+    // are computed in floating point.
+    std::vector<double> free(pools.size());
+    double total = 0;
+    for (size_t i = 0; i < pools.size(); ++i) {
+        const PoolState& state = getState(pools[i]);
+        free[i] = static_cast<double>(state.capacity_ - state.used_);
+        total += free[i];
+    }
+    if (total == 0) {
+        // Everything was seen used.  Some of the leases have probably been
+        // released or expired meanwhile, so start learning again.
+        for (size_t i = 0; i < pools.size(); ++i) {
+            PoolState& state = getState(pools[i]);
+            std::fill(state.bitmap_.begin(), state.bitmap_.end(), 0);
+            state.used_ = 0;
+            free[i] = static_cast<double>(state.capacity_);
+            total += free[i];
+        }
+    }
+    double point = total * (random() >> 11) / 9007199254740992.0;
+    size_t pool = 0;
+    for (size_t i = 0; i < pools.size(); ++i) {
+        if (free[i] > 0) {
+            pool = i;
+            if (point < free[i]) {
+                break;
+            }
+            point -= free[i];
+        }
+    }
+
+    // Pick a random position in the pool and take the first free address
+    // from there.
+    const PoolState& state = getState(pools[pool]);
+    uint64_t offset = random() % state.capacity_;
+    if (!state.bitmap_.empty()) {
+        offset = findFree(state.bitmap_, state.capacity_, offset);
+    }
+    return (poolAddress(pools[pool], offset));
+}
+
+void
+AllocEngine::RandomAllocator::addressUsed(const SubnetPtr& subnet,
+                                          const IOAddress& addr) {
+    Mutex::Locker lock(mutex_);
+
+    const PoolCollection& pools = subnet->getPools(pool_type_);
+    for (size_t i = 0; i < pools.size(); ++i) {
+        if (pools[i]->inRange(addr)) {
+            PoolState& state = getState(pools[i]);
+            if (state.bitmap_.empty()) {
+                return;
+            }
+            const uint64_t offset = poolOffset(pools[i], addr);
+            uint64_t& word = state.bitmap_[offset / 64];
+            const uint64_t bit = 1ULL << (offset % 64);
+            if (!(word & bit)) {
+                word |= bit;
+                ++state.used_;
+            }
+            return;
+        }
+    }
 }
 
 
@@ -262,6 +677,9 @@ AllocEngine::AllocEngine(AllocType engine_type, unsigned int attempts,
     case ALLOC_RANDOM:
         allocators_[basic_type] = AllocatorPtr(new RandomAllocator(basic_type));
         break;
+    case ALLOC_INDEXED:
+        allocators_[basic_type] = AllocatorPtr(new IndexedAllocator(basic_type));
+        break;
     default:
         bundy_throw(BadValue, "Invalid/unsupported allocation algorithm");
     }
@@ -282,6 +700,10 @@ AllocEngine::AllocEngine(AllocType engine_type, unsigned int attempts,
             allocators_[Lease::TYPE_TA] = AllocatorPtr(new RandomAllocator(Lease::TYPE_TA));
             allocators_[Lease::TYPE_PD] = AllocatorPtr(new RandomAllocator(Lease::TYPE_PD));
             break;
+        case ALLOC_INDEXED:
+            allocators_[Lease::TYPE_TA] = AllocatorPtr(new IndexedAllocator(Lease::TYPE_TA));
+            allocators_[Lease::TYPE_PD] = AllocatorPtr(new IndexedAllocator(Lease::TYPE_PD));
+            break;
         default:
             bundy_throw(BadValue, "Invalid/unsupported allocation algorithm");
         }
@@ -365,8 +787,14 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
                     collection.push_back(lease);
                     return (collection);
                 }
-            } else {
-                if (lease->expired()) {
+            } else if (lease->expired()) {
+                // Make sure no other thread is reusing the lease meanwhile.
+                ResourceLocks::Locker lock(address_locks_, hint.toBytes(),
+                                           false);
+                if (lock.locked()) {
+                    lease = LeaseMgrFactory::instance().getLease6(type, hint);
+                }
+                if (lock.locked() && lease && lease->expired()) {
                     // Copy an existing, expired lease so as it can be returned
                     // to the caller.
                     Lease6Ptr old_lease(new Lease6(*lease));
@@ -384,7 +812,6 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
                     collection.push_back(lease);
                     return (collection);
                 }
-
             }
         }
 
@@ -404,9 +831,15 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
         // left), but this has one major problem. We exactly control allocation
         // moment, but we currently do not control expiration time at all
 
+        // The address the allocator picked previously is passed to it, so
+        // the allocators picking the addresses in a sequence can continue
+        // it.  The client's hint, tried above, is not: the sequence
+        // starts where the allocator chooses.
+        IOAddress last("::");
         unsigned int i = attempts_;
         do {
-            IOAddress candidate = allocator->pickAddress(subnet, duid, hint);
+            IOAddress candidate = allocator->pickAddress(subnet, duid, last);
+            last = candidate;
 
             /// @todo: check if the address is reserved once we have host support
             /// implemented
@@ -444,8 +877,16 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
                 // Although the address was free just microseconds ago, it may have
                 // been taken just now. If the lease insertion fails, we continue
                 // allocation attempts.
-            } else {
-                if (existing->expired()) {
+            } else if (existing->expired()) {
+                // Make sure no other thread is reusing the lease meanwhile,
+                // otherwise try another candidate.
+                ResourceLocks::Locker lock(address_locks_,
+                                           candidate.toBytes(), false);
+                if (lock.locked()) {
+                    existing = LeaseMgrFactory::instance().getLease6(type,
+                                                                     candidate);
+                }
+                if (lock.locked() && existing && existing->expired()) {
                     // Copy an existing, expired lease so as it can be returned
                     // to the caller.
                     Lease6Ptr old_lease(new Lease6(*existing));
@@ -461,6 +902,9 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
                 }
             }
 
+            // The candidate is in use (or was just taken by someone else).
+            allocator->addressUsed(subnet, candidate);
+
             // Continue trying allocation until we run out of attempts
             // (or attempts are set to 0, which means infinite)
             --i;
@@ -565,8 +1009,14 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
                 if (lease) {
                     return (lease);
                 }
-            } else {
-                if (existing->expired()) {
+            } else if (existing->expired()) {
+                // Make sure no other thread is reusing the lease meanwhile.
+                ResourceLocks::Locker lock(address_locks_, hint.toBytes(),
+                                           false);
+                if (lock.locked()) {
+                    existing = LeaseMgrFactory::instance().getLease4(hint);
+                }
+                if (lock.locked() && existing && existing->expired()) {
                     // Save the old lease, before reusing it.
                     old_lease.reset(new Lease4(*existing));
                     return (reuseExpiredLease(existing, subnet, clientid, hwaddr,
@@ -574,7 +1024,6 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
                                               hostname, callout_handle,
                                               fake_allocation));
                 }
-
             }
         }
 
@@ -594,9 +1043,23 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
         // left), but this has one major problem. We exactly control allocation
         // moment, but we currently do not control expiration time at all
 
+        // The allocators picking the address by the client identity need
+        // the hardware address when the client sent no client identifier.
+        DuidPtr client_key = clientid;
+        if (!client_key && !hwaddr->hwaddr_.empty()) {
+            client_key.reset(new DUID(hwaddr->hwaddr_));
+        }
+
+        // The address the allocator picked previously is passed to it, so
+        // the allocators picking the addresses in a sequence can continue
+        // it.  The client's hint, tried above, is not: the sequence
+        // starts where the allocator chooses.
+        IOAddress last("0.0.0.0");
         unsigned int i = attempts_;
         do {
-            IOAddress candidate = allocator->pickAddress(subnet, clientid, hint);
+            IOAddress candidate = allocator->pickAddress(subnet, client_key,
+                                                         last);
+            last = candidate;
 
             /// @todo: check if the address is reserved once we have host support
             /// implemented
@@ -616,8 +1079,15 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
                 // Although the address was free just microseconds ago, it may have
                 // been taken just now. If the lease insertion fails, we continue
                 // allocation attempts.
-            } else {
-                if (existing->expired()) {
+            } else if (existing->expired()) {
+                // Make sure no other thread is reusing the lease meanwhile,
+                // otherwise try another candidate.
+                ResourceLocks::Locker lock(address_locks_,
+                                           candidate.toBytes(), false);
+                if (lock.locked()) {
+                    existing = LeaseMgrFactory::instance().getLease4(candidate);
+                }
+                if (lock.locked() && existing && existing->expired()) {
                     // Save old lease before reusing it.
                     old_lease.reset(new Lease4(*existing));
                     return (reuseExpiredLease(existing, subnet, clientid, hwaddr,
@@ -627,6 +1097,9 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
                 }
             }
 
+            // The candidate is in use (or was just taken by someone else).
+            allocator->addressUsed(subnet, candidate);
+
             // Continue trying allocation until we run out of attempts
             // (or attempts are set to 0, which means infinite)
             --i;
@@ -793,6 +1266,7 @@ Lease6Ptr AllocEngine::reuseExpiredLease(Lease6Ptr& expired,
     if (!fake_allocation) {
         // for REQUEST we do update the lease
         LeaseMgrFactory::instance().updateLease6(expired);
+        getAllocator(expired->type_)->addressUsed(subnet, expired->addr_);
     }
 
     // We do nothing for SOLICIT. We'll just update database when
@@ -874,6 +1348,7 @@ Lease4Ptr AllocEngine::reuseExpiredLease(Lease4Ptr& expired,
     if (!fake_allocation) {
         // for REQUEST we do update the lease
         LeaseMgrFactory::instance().updateLease4(expired);
+        getAllocator(Lease::TYPE_V4)->addressUsed(subnet, expired->addr_);
     }
 
     // We do nothing for SOLICIT. We'll just update database when
@@ -946,7 +1421,7 @@ Lease6Ptr AllocEngine::createLease6(const Subnet6Ptr& subnet,
         bool status = LeaseMgrFactory::instance().addLease(lease);
 
         if (status) {
-
+            getAllocator(type)->addressUsed(subnet, addr);
             return (lease);
         } else {
             // One of many failures with LeaseMgr (e.g. lost connection to the
@@ -1042,6 +1517,7 @@ Lease4Ptr AllocEngine::createLease4(const SubnetPtr& subnet,
         // That is a real (REQUEST) allocation
         bool status = LeaseMgrFactory::instance().addLease(lease);
         if (status) {
+            getAllocator(Lease::TYPE_V4)->addressUsed(subnet, addr);
             return (lease);
         } else {
             // One of many failures with LeaseMgr (e.g. lost connection to the
@@ -1088,6 +1564,167 @@ AllocEngine::updateFqdnData(const Lease6Collection& leases,
     return (updated_leases);
 }
 
+size_t
+AllocEngine::reclaimExpiredLeases4(size_t max_leases, uint32_t timeout) {
+    return (reclaimLeases<Lease4Collection>(&LeaseMgr::getExpiredLeases4,
+                                            max_leases, timeout));
+}
+
+size_t
+AllocEngine::reclaimExpiredLeases6(size_t max_leases, uint32_t timeout) {
+    return (reclaimLeases<Lease6Collection>(&LeaseMgr::getExpiredLeases6,
+                                            max_leases, timeout));
+}
+
+template <typename LeaseCollection>
+size_t
+AllocEngine::reclaimLeases(void (LeaseMgr::*get_expired)(LeaseCollection&,
+                                                         size_t) const,
+                           size_t max_leases, uint32_t timeout) {
+    const ptime start = microsec_clock::universal_time();
+    CalloutHandlePtr callout_handle;
+    size_t reclaimed = 0;
+    // The leases left alone (skipped by the callouts, being reused...) stay
+    // at the head of the expiration index.  They are fetched again with
+    // the next leases until max_leases are reclaimed, but only looked at
+    // once.
+    std::set<IOAddress> kept;
+    for (;;) {
+        const size_t limit = (max_leases > 0 ?
+                              kept.size() + max_leases - reclaimed : 0);
+        LeaseCollection expired;
+        (LeaseMgrFactory::instance().*get_expired)(expired, limit);
+        for (typename LeaseCollection::const_iterator lease = expired.begin();
+             lease != expired.end(); ++lease) {
+            if (kept.count((*lease)->addr_) > 0) {
+                continue;
+            }
+            const int64_t elapsed =
+                (microsec_clock::universal_time() - start).total_milliseconds();
+            if (timeout > 0 && elapsed >= timeout) {
+                LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
+                          DHCPSRV_RECLAIM_TIMEOUT).arg(elapsed).arg(reclaimed);
+                return (reclaimed);
+            }
+            if (reclaimLease(*lease, callout_handle)) {
+                ++reclaimed;
+            } else {
+                kept.insert((*lease)->addr_);
+            }
+        }
+        // Done when all the expired leases were fetched or the budget
+        // is spent.
+        if (max_leases == 0 || expired.size() < limit ||
+            reclaimed >= max_leases) {
+            break;
+        }
+    }
+
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_RECLAIM_COMPLETE)
+        .arg(reclaimed)
+        .arg((microsec_clock::universal_time() - start).total_milliseconds());
+    return (reclaimed);
+}
+
+bool
+AllocEngine::reclaimLease(const Lease4Ptr& expired,
+                          CalloutHandlePtr& callout_handle) {
+    // A client may be taking the lease over at the same time, it is
+    // reclaimed next time if still expired.
+    ResourceLocks::Locker lock(address_locks_, expired->addr_.toBytes(),
+                               false);
+    if (!lock.locked()) {
+        return (false);
+    }
+    // The lease may have been renewed or reused since it was fetched.
+    Lease4Ptr lease = LeaseMgrFactory::instance().getLease4(expired->addr_);
+    // The fixed leases are kept after they expire.
+    if (!lease || !lease->expired() || lease->fixed_) {
+        return (false);
+    }
+
+    if (HooksManager::calloutsPresent(Hooks.hook_index_lease4_expire_)) {
+        if (!callout_handle) {
+            callout_handle = HooksManager::createCalloutHandle();
+        }
+        callout_handle->deleteAllArguments();
+        callout_handle->setArgument("lease4", lease);
+        HooksManager::callCallouts(Hooks.hook_index_lease4_expire_,
+                                   *callout_handle);
+
+        // Callouts decided to skip the next processing step. The next
+        // processing step would be to delete the lease, so skip at this
+        // stage means "the callouts take care of the lease".
+        if (callout_handle->getSkip()) {
+            LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_HOOKS,
+                      DHCPSRV_HOOK_LEASE4_EXPIRE_SKIP)
+                .arg(lease->addr_.toText());
+            return (false);
+        }
+    }
+
+    try {
+        if (!LeaseMgrFactory::instance().deleteLease(lease->addr_)) {
+            return (false);
+        }
+    } catch (const std::exception& ex) {
+        LOG_ERROR(dhcpsrv_logger, DHCPSRV_RECLAIM_FAIL)
+            .arg(lease->addr_.toText()).arg(ex.what());
+        return (false);
+    }
+    queueRemovalRequest(*lease);
+    return (true);
+}
+
+bool
+AllocEngine::reclaimLease(const Lease6Ptr& expired,
+                          CalloutHandlePtr& callout_handle) {
+    // A client may be taking the lease over at the same time, it is
+    // reclaimed next time if still expired.
+    ResourceLocks::Locker lock(address_locks_, expired->addr_.toBytes(),
+                               false);
+    if (!lock.locked()) {
+        return (false);
+    }
+    // The lease may have been renewed or reused since it was fetched.
+    Lease6Ptr lease = LeaseMgrFactory::instance().getLease6(expired->type_,
+                                                            expired->addr_);
+    // The fixed leases are kept after they expire.
+    if (!lease || !lease->expired() || lease->fixed_) {
+        return (false);
+    }
+
+    if (HooksManager::calloutsPresent(Hooks.hook_index_lease6_expire_)) {
+        if (!callout_handle) {
+            callout_handle = HooksManager::createCalloutHandle();
+        }
+        callout_handle->deleteAllArguments();
+        callout_handle->setArgument("lease6", lease);
+        HooksManager::callCallouts(Hooks.hook_index_lease6_expire_,
+                                   *callout_handle);
+
+        // Skip means "the callouts take care of the lease".
+        if (callout_handle->getSkip()) {
+            LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_HOOKS,
+                      DHCPSRV_HOOK_LEASE6_EXPIRE_SKIP)
+                .arg(lease->addr_.toText());
+            return (false);
+        }
+    }
+
+    try {
+        if (!LeaseMgrFactory::instance().deleteLease(lease->addr_)) {
+            return (false);
+        }
+    } catch (const std::exception& ex) {
+        LOG_ERROR(dhcpsrv_logger, DHCPSRV_RECLAIM_FAIL)
+            .arg(lease->addr_.toText()).arg(ex.what());
+        return (false);
+    }
+    queueRemovalRequest(*lease);
+    return (true);
+}
+
 AllocEngine::AllocatorPtr AllocEngine::getAllocator(Lease::Type type) {
     std::map<Lease::Type, AllocatorPtr>::const_iterator alloc = allocators_.find(type);
 
@@ -20,12 +20,17 @@
 #include <dhcp/hwaddr.h>
 #include <dhcpsrv/subnet.h>
 #include <dhcpsrv/lease_mgr.h>
+#include <dhcpsrv/resource_locks.h>
 #include <hooks/callout_handle.h>
+#include <util/threads/sync.h>
 
 #include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
 #include <boost/noncopyable.hpp>
+#include <boost/random/mersenne_twister.hpp>
 
 #include <map>
+#include <vector>
 
 namespace bundy {
 namespace dhcp {
@@ -80,13 +85,30 @@ protected:
         ///
         /// @param subnet next address will be returned from pool of that subnet
         /// @param duid Client's DUID
-        /// @param hint client's hint
+        /// @param hint the address picked previously for this client, or
+        ///        the unspecified address (0.0.0.0 or ::) on the first call
         ///
         /// @return the next address
         virtual bundy::asiolink::IOAddress
         pickAddress(const SubnetPtr& subnet, const DuidPtr& duid,
                     const bundy::asiolink::IOAddress& hint) = 0;
 
+        /// @brief records that an address is in use
+        ///
+        /// AllocEngine calls it for the picked addresses it found leased
+        /// and for the addresses it allocated, so the allocators keeping
+        /// track of the free addresses don't pick them again. The default
+        /// implementation does nothing.
+        ///
+        /// @param subnet subnet the address belongs to
+        /// @param addr the address (or prefix) in use
+        virtual void
+        addressUsed(const SubnetPtr& subnet,
+                    const bundy::asiolink::IOAddress& addr) {
+            static_cast<void>(subnet);
+            static_cast<void>(addr);
+        }
+
         /// @brief Default constructor.
         ///
         /// Specifies which type of leases this allocator will assign
@@ -113,6 +135,9 @@ protected:
     /// a pool iteratively, one after another. Once the last address is reached,
     /// it starts allocating from the beginning of the first pool (i.e. it loops
     /// over).
+    ///
+    /// The position in the pools is kept in the subnet and advanced under
+    /// a lock, so the allocator can be used by several threads.
     class IterativeAllocator : public Allocator {
     public:
 
@@ -157,11 +182,50 @@ protected:
         static bundy::asiolink::IOAddress
         increasePrefix(const bundy::asiolink::IOAddress& prefix,
                        const uint8_t prefix_len);
+
+        /// @brief Protects the last allocated addresses of the subnets
+        bundy::util::thread::Mutex mutex_;
+    };
+
+    /// @brief Address/prefix allocator that uses the index of the lease manager
+    ///
+    /// The allocator asks the lease index (see @c LeaseMgr::getLeaseIndex)
+    /// for the first free address in the pools after the last allocated one,
+    /// so it returns the same addresses as @c IterativeAllocator without
+    /// probing the leased ones.  When the pools are full, the lease which
+    /// expired first is returned, so it can be reused.
+    ///
+    /// If the lease manager keeps no index, or the index knows about no free
+    /// or expired lease, the allocator works as @c IterativeAllocator.
+    class IndexedAllocator : public IterativeAllocator {
+    public:
+
+        /// @brief default constructor
+        /// @param type - specifies allocation type
+        IndexedAllocator(Lease::Type type);
+
+        /// @brief returns the next free address from pools in a subnet
+        ///
+        /// @param subnet next address will be returned from pool of that subnet
+        /// @param duid Client's DUID (ignored)
+        /// @param hint client's hint (ignored)
+        /// @return the next free address (or the expired one)
+        virtual bundy::asiolink::IOAddress
+            pickAddress(const SubnetPtr& subnet,
+                        const DuidPtr& duid,
+                        const bundy::asiolink::IOAddress& hint);
     };
 
     /// @brief Address/prefix allocator that gets an address based on a hash
     ///
-    /// @todo: This is a skeleton class for now and is missing implementation.
+    /// The address is picked at a position in the pools given by a hash of
+    /// the client's DUID (or client identifier), so a client gets the same
+    /// address each time it is free.  The hash doesn't depend on the
+    /// platform or on the server instance, so the address is also kept
+    /// across restarts.  When the address is taken, the following ones are
+    /// probed one after another (wrapping around the end of the last pool).
+    ///
+    /// The allocator keeps no state, so it can be used by several threads.
     class HashedAllocator : public Allocator {
     public:
 
@@ -171,7 +235,10 @@ protected:
 
         /// @brief returns an address based on hash calculated from client's DUID.
         ///
-        /// @todo: Implement this method
+        /// If the hint is in one of the pools, the address following it is
+        /// returned.  This continues the probing when the previously picked
+        /// address is passed as the hint, the engine never passes the
+        /// client's own hint.
         ///
         /// @param subnet an address will be picked from pool of that subnet
         /// @param duid Client's DUID
@@ -180,22 +247,41 @@ protected:
         virtual bundy::asiolink::IOAddress pickAddress(const SubnetPtr& subnet,
                                                      const DuidPtr& duid,
                                                      const bundy::asiolink::IOAddress& hint);
+
+        /// @brief Computes the hash of the DUID used to pick the address
+        ///
+        /// It is a 64-bit FNV-1a hash of the DUID contents.
+        ///
+        /// @param duid Client's DUID (may be NULL)
+        /// @return the hash
+        static uint64_t hashDuid(const DuidPtr& duid);
     };
 
     /// @brief Random allocator that picks address randomly
     ///
-    /// @todo: This is a skeleton class for now and is missing implementation.
+    /// The allocator keeps a bitmap of the addresses it knows to be in use
+    /// for every pool of up to @c MAX_BITMAP_SIZE addresses (or prefixes).
+    /// A pool is picked with the probability given by the number of its
+    /// free addresses and a free address is then picked in it at random,
+    /// so the addresses found leased are not probed again.
+    ///
+    /// The bitmaps are filled by @c addressUsed(), they don't learn when a
+    /// lease is released or expires.  When all the addresses of the pools
+    /// are marked, the bitmaps are cleared and the learning starts again.
+    /// Larger pools have no bitmap, the addresses are picked from the whole
+    /// pool (which is usually sparsely used anyway).
     class RandomAllocator : public Allocator {
     public:
 
-        /// @brief default constructor (does nothing)
+        /// @brief Maximum size of a pool tracked by a bitmap
+        static const uint64_t MAX_BITMAP_SIZE = 1 << 24;
+
+        /// @brief default constructor
         /// @param type - specifies allocation type
         RandomAllocator(Lease::Type type);
 
         /// @brief returns an random address from pool of specified subnet
         ///
-        /// @todo: Implement this method
-        ///
         /// @param subnet an address will be picked from pool of that subnet
         /// @param duid Client's DUID (ignored)
         /// @param hint the last address that was picked (ignored)
@@ -203,6 +289,46 @@ protected:
         virtual bundy::asiolink::IOAddress
         pickAddress(const SubnetPtr& subnet, const DuidPtr& duid,
                     const bundy::asiolink::IOAddress& hint);
+
+        /// @brief marks the address as used in the bitmap of its pool
+        ///
+        /// @param subnet subnet the address belongs to
+        /// @param addr the address (or prefix) in use
+        virtual void
+        addressUsed(const SubnetPtr& subnet,
+                    const bundy::asiolink::IOAddress& addr);
+
+    protected:
+
+        /// @brief Addresses known to be in use in one pool
+        struct PoolState {
+            /// @brief The pool, used to drop the state of removed pools
+            boost::weak_ptr<Pool> pool_;
+            /// @brief Number of the addresses (or prefixes) in the pool
+            uint64_t capacity_;
+            /// @brief Number of the addresses marked as used
+            uint64_t used_;
+            /// @brief The bitmap (empty for the large pools)
+            std::vector<uint64_t> bitmap_;
+        };
+
+        /// @brief Returns the state of a pool, creating it if needed
+        ///
+        /// @param pool the pool
+        /// @return the state (valid until the mutex is released)
+        PoolState& getState(const PoolPtr& pool);
+
+        /// @brief Returns a random 64-bit number
+        uint64_t random();
+
+        /// @brief State of the pools, indexed by the pool id
+        std::map<uint32_t, PoolState> pools_;
+
+        /// @brief The random number generator
+        boost::mt19937 generator_;
+
+        /// @brief Protects the state and the generator
+        bundy::util::thread::Mutex mutex_;
     };
 
     public:
@@ -211,7 +337,8 @@ protected:
     typedef enum {
         ALLOC_ITERATIVE, // iterative - one address after another
         ALLOC_HASHED,    // hashed - client's DUID/client-id is hashed
-        ALLOC_RANDOM     // random - an address is randomly selected
+        ALLOC_RANDOM,    // random - an address is randomly selected
+        ALLOC_INDEXED    // indexed - the next free address in the lease index
     } AllocType;
 
 
@@ -354,6 +481,47 @@ protected:
                     const bundy::hooks::CalloutHandlePtr& callout_handle,
                     Lease6Collection& old_leases);
 
+    /// @brief Reclaims the expired IPv4 leases.
+    ///
+    /// Expired leases are otherwise only reused when the allocator happens
+    /// to pick their addresses.  This method deletes them from the lease
+    /// database, the lease which expired first first, so their addresses are
+    /// free again and the database doesn't grow with stale leases.  It is
+    /// meant to be called periodically by the server.
+    ///
+    /// The expired leases are fetched with a single query using the
+    /// expiration time index of the backend.  For each of them the callouts
+    /// installed on lease4_expire are called, and if none set the skip flag
+    /// the lease is deleted and, if DNS updates were performed for it, a
+    /// request to remove the DNS records is sent to bundy-dhcp-ddns.  The
+    /// leases being reused by a client at the same time and the fixed
+    /// leases are left alone.
+    ///
+    /// The leases which are not deleted, e.g. because a callout set the
+    /// skip flag, don't count in @c max_leases: more expired leases are
+    /// fetched past them, so they don't hold the reclamation of the others.
+    /// They are looked at again each time until they are deleted, or
+    /// extended, by the callouts.
+    ///
+    /// The reclamation stops when it takes longer than the timeout, so the
+    /// time taken from the packet processing is bounded.  The leases left
+    /// are reclaimed the next time.
+    ///
+    /// @param max_leases Maximum number of the leases reclaimed, 0 for all.
+    /// @param timeout Maximum time in milliseconds, 0 for no limit.
+    /// @return The number of the leases reclaimed.
+    size_t reclaimExpiredLeases4(size_t max_leases, uint32_t timeout);
+
+    /// @brief Reclaims the expired IPv6 leases.
+    ///
+    /// Same as @c reclaimExpiredLeases4, for the leases of all types.  The
+    /// callouts installed on lease6_expire are called for each lease.
+    ///
+    /// @param max_leases Maximum number of the leases reclaimed, 0 for all.
+    /// @param timeout Maximum time in milliseconds, 0 for no limit.
+    /// @return The number of the leases reclaimed.
+    size_t reclaimExpiredLeases6(size_t max_leases, uint32_t timeout);
+
     /// @brief returns allocator for a given pool type
     /// @param type type of pool (V4, IA, TA or PD)
     /// @throw BadValue if allocator for a given type is missing
@@ -496,6 +664,36 @@ private:
                                 const bundy::hooks::CalloutHandlePtr& callout_handle,
                                 bool fake_allocation = false);
 
+    /// @brief Reclaims the expired leases.
+    ///
+    /// @param get_expired The @c LeaseMgr method returning the expired
+    ///        leases, the first expired first.
+    /// @param max_leases Maximum number of the leases reclaimed, 0 for all.
+    /// @param timeout Maximum time in milliseconds, 0 for no limit.
+    /// @return The number of the leases reclaimed.
+    template <typename LeaseCollection>
+    size_t reclaimLeases(void (LeaseMgr::*get_expired)(LeaseCollection&,
+                                                       size_t) const,
+                         size_t max_leases, uint32_t timeout);
+
+    /// @brief Reclaims an expired IPv4 lease.
+    ///
+    /// @param expired The expired lease.
+    /// @param callout_handle The callout handle for lease4_expire, created
+    ///        when first needed.
+    /// @return true if the lease was deleted.
+    bool reclaimLease(const Lease4Ptr& expired,
+                      bundy::hooks::CalloutHandlePtr& callout_handle);
+
+    /// @brief Reclaims an expired IPv6 lease.
+    ///
+    /// @param expired The expired lease.
+    /// @param callout_handle The callout handle for lease6_expire, created
+    ///        when first needed.
+    /// @return true if the lease was deleted.
+    bool reclaimLease(const Lease6Ptr& expired,
+                      bundy::hooks::CalloutHandlePtr& callout_handle);
+
     /// @brief Updates FQDN data for a collection of leases.
     ///
     /// @param leases Collection of leases for which FQDN data should be
@@ -527,6 +725,12 @@ private:
     /// @brief number of attempts before we give up lease allocation (0=unlimited)
     unsigned int attempts_;
 
+    /// @brief Addresses of the expired leases being reused
+    ///
+    /// When the packets are processed by several threads, two clients could
+    /// otherwise take over the same expired lease at the same time.
+    ResourceLocks address_locks_;
+
     // hook name indexes (used in hooks callouts)
     int hook_index_lease4_select_; ///< index for lease4_select hook
     int hook_index_lease6_select_; ///< index for lease6_select hook
@@ -0,0 +1,618 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <bench/benchmark.h>
+
+#include <asiolink/io_address.h>
+#include <dhcp/dhcp4.h>
+#include <dhcp/duid.h>
+#include <dhcp/hwaddr.h>
+#include <dhcpsrv/alloc_engine.h>
+#include <dhcpsrv/lease_mgr.h>
+#include <dhcpsrv/lease_mgr_factory.h>
+#include <dhcpsrv/pool.h>
+#include <dhcpsrv/subnet.h>
+#include <exceptions/exceptions.h>
+#include <log/logger_support.h>
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace bundy;
+using namespace bundy::asiolink;
+using namespace bundy::bench;
+using namespace bundy::dhcp;
+
+namespace {
+
+/// @brief One workload of the benchmark.
+///
+/// Its @c run() performs the operation once and records how long it took,
+/// so the latency percentiles can be printed along with the throughput
+/// computed by @c BenchMark.  The operation is given the number of the
+/// iteration.
+class LeaseOps {
+public:
+    /// @brief The benchmarked operation.
+    typedef boost::function<void(uint32_t)> Operation;
+
+    /// @brief Constructor.
+    ///
+    /// @param name Name of the workload printed with the results.
+    /// @param operation Operation to perform at each iteration.
+    /// @param iterations Number of iterations, to reserve the latencies.
+    LeaseOps(const string& name, const Operation& operation,
+             uint32_t iterations) :
+        name_(name), operation_(operation), iteration_(0)
+    {
+        latencies_.reserve(iterations);
+    }
+
+    /// @brief Performs the operation once.
+    unsigned int run() {
+        struct timespec before, after;
+        clock_gettime(CLOCK_MONOTONIC, &before);
+        operation_(iteration_++);
+        clock_gettime(CLOCK_MONOTONIC, &after);
+        latencies_.push_back((after.tv_sec - before.tv_sec) * 1000000000ULL +
+                             after.tv_nsec - before.tv_nsec);
+        return (1);
+    }
+
+    /// @brief Returns the name of the workload.
+    const string& getName() const {
+        return (name_);
+    }
+
+    /// @brief Prints the latency percentiles in microseconds.
+    void printLatencies() {
+        if (latencies_.empty()) {
+            return;
+        }
+        sort(latencies_.begin(), latencies_.end());
+        // The percentiles in per mille, with their names.
+        static const size_t percentiles[] = { 500, 900, 990, 999 };
+        static const char* const names[] = { "50%", "90%", "99%", "99.9%" };
+        cout << "  latency (us):";
+        for (size_t i = 0; i < sizeof(percentiles) / sizeof(size_t); ++i) {
+            const size_t index =
+                min(latencies_.size() - 1,
+                    latencies_.size() * percentiles[i] / 1000);
+            cout << " " << names[i] << " " << latencies_[index] / 1000.0;
+        }
+        cout << ", max " << latencies_.back() / 1000.0 << endl;
+    }
+
+private:
+    string name_;
+    Operation operation_;
+    uint32_t iteration_;
+    vector<uint64_t> latencies_;
+};
+
+}
+
+namespace bundy {
+namespace bench {
+template<>
+void
+BenchMark<LeaseOps>::printResult() const {
+    cout.precision(6);
+    cout << target_->getName() << ": " << getIteration()
+         << " operations in " << fixed << getDuration() << "s";
+    cout.precision(2);
+    cout << " (" << fixed << getIterationPerSecond() << " ops/s)" << endl;
+    target_->printLatencies();
+}
+}
+}
+
+namespace {
+
+/// @brief Runs the workloads on the lease database.
+///
+/// The leases of the clients 0 to @c leases - 1 are first added to the
+/// database, with addresses in the second half of the pool.  The lookups,
+/// updates and renewals then pick the clients at random, and the new
+/// allocations take the addresses from the first half of the pool.  At
+/// the end, all the leases are deleted so the database is left empty.
+///
+/// The derived classes implement the operations for the DHCPv4 and the
+/// DHCPv6 leases.
+class LeaseBench {
+public:
+    /// @brief Constructor.
+    ///
+    /// @param leases Number of leases added to the database.
+    /// @param operations Number of operations of each workload.
+    /// @param lookups Percentage of lookups in the mixed workload.
+    /// @param hits Percentage of the lookups finding a lease.
+    LeaseBench(uint32_t leases, uint32_t operations, uint32_t lookups,
+               uint32_t hits) :
+        leases_(leases), operations_(operations), lookups_(lookups),
+        hits_(hits)
+    {}
+
+    /// @brief Destructor.
+    virtual ~LeaseBench() {}
+
+    /// @brief Runs all the workloads in order.
+    void run() {
+        runOps("insert", boost::bind(&LeaseBench::insert, this, _1), leases_);
+        runOps("get by address",
+               boost::bind(&LeaseBench::getByAddress, this,
+                           boost::bind(&LeaseBench::pickLookup, this)),
+               operations_);
+        runOps("get by client",
+               boost::bind(&LeaseBench::getByClient, this,
+                           boost::bind(&LeaseBench::pickLookup, this)),
+               operations_);
+        runOps("update",
+               boost::bind(&LeaseBench::update, this,
+                           boost::bind(&LeaseBench::pickClient, this)),
+               operations_);
+        runOps("mixed", boost::bind(&LeaseBench::mixed, this, _1),
+               operations_);
+        runOps("allocate (renew)",
+               boost::bind(&LeaseBench::allocate, this,
+                           boost::bind(&LeaseBench::pickClient, this)),
+               operations_);
+        runOps("allocate (new)",
+               boost::bind(&LeaseBench::allocateNew, this, _1), operations_);
+        runOps("delete", boost::bind(&LeaseBench::removeLease, this, _1),
+               leases_ + allocated_.size());
+    }
+
+protected:
+    /// @brief Adds the lease of the client.
+    virtual void insert(uint32_t client) = 0;
+
+    /// @brief Looks up the lease by the address of the client.
+    virtual void getByAddress(uint32_t client) = 0;
+
+    /// @brief Looks up the lease by the identifier of the client.
+    virtual void getByClient(uint32_t client) = 0;
+
+    /// @brief Extends the lease of the client.
+    virtual void update(uint32_t client) = 0;
+
+    /// @brief Asks the allocation engine for a lease for the client.
+    ///
+    /// @return Address allocated.
+    virtual IOAddress allocate(uint32_t client) = 0;
+
+    /// @brief Deletes the lease for the address.
+    virtual void remove(const IOAddress& address) = 0;
+
+    /// @brief Returns the address leased to a client inserted.
+    virtual IOAddress getAddress(uint32_t client) const = 0;
+
+    /// @brief Throws if the database is not empty.
+    void checkInsert(bool inserted, uint32_t client) const {
+        if (!inserted) {
+            bundy_throw(Unexpected, "failed to add the lease for "
+                        << getAddress(client)
+                        << ", the database must be empty");
+        }
+    }
+
+    /// @brief Number of leases added to the database.
+    const uint32_t leases_;
+
+private:
+    /// @brief Runs one workload.
+    void runOps(const string& name, const LeaseOps::Operation& operation,
+                uint32_t iterations) {
+        LeaseOps ops(name, operation, iterations);
+        BenchMark<LeaseOps>(iterations, ops, true);
+    }
+
+    /// @brief Picks a client for a lookup, with the hit ratio.
+    ///
+    /// The missed clients never had a lease.
+    uint32_t pickLookup() {
+        if (static_cast<uint32_t>(random() % 100) < hits_) {
+            return (pickClient());
+        }
+        return (leases_ + random() % leases_);
+    }
+
+    /// @brief Picks one of the clients inserted.
+    uint32_t pickClient() {
+        return (random() % leases_);
+    }
+
+    /// @brief Looks up or updates a lease, with the lookup ratio.
+    void mixed(uint32_t) {
+        if (static_cast<uint32_t>(random() % 100) < lookups_) {
+            getByAddress(pickLookup());
+        } else {
+            update(pickClient());
+        }
+    }
+
+    /// @brief Allocates a lease to a new client.
+    ///
+    /// The clients are numbered after the missed ones.
+    void allocateNew(uint32_t iteration) {
+        allocated_.push_back(allocate(2 * leases_ + iteration));
+    }
+
+    /// @brief Deletes the leases inserted, then the leases allocated.
+    void removeLease(uint32_t iteration) {
+        if (iteration < leases_) {
+            remove(getAddress(iteration));
+        } else {
+            remove(allocated_[iteration - leases_]);
+        }
+    }
+
+    const uint32_t operations_;
+    const uint32_t lookups_;
+    const uint32_t hits_;
+    vector<IOAddress> allocated_;
+};
+
+/// @brief Appends the number of the client to an identifier.
+void
+appendClient(vector<uint8_t>& data, uint32_t client) {
+    data.push_back(client >> 24);
+    data.push_back(client >> 16);
+    data.push_back(client >> 8);
+    data.push_back(client);
+}
+
+/// @brief Valid lifetime of the leases.
+const uint32_t VALID_LIFETIME = 4000;
+
+/// @brief DHCPv4 workloads.
+///
+/// The subnet is 10.0.0.0/8, with the pool covering it all.
+class LeaseBench4 : public LeaseBench {
+public:
+    /// @brief Constructor.
+    ///
+    /// @param alloc_type Allocator of the allocation engine.
+    LeaseBench4(uint32_t leases, uint32_t operations, uint32_t lookups,
+                uint32_t hits, AllocEngine::AllocType alloc_type) :
+        LeaseBench(leases, operations, lookups, hits),
+        subnet_(new Subnet4(IOAddress("10.0.0.0"), 8, 1000, 2000,
+                            VALID_LIFETIME)),
+        engine_(alloc_type, 100, false)
+    {
+        subnet_->addPool(Pool4Ptr(new Pool4(IOAddress("10.0.0.0"), 8)));
+    }
+
+protected:
+    virtual void insert(uint32_t client) {
+        const vector<uint8_t> hwaddr = getHWAddr(client);
+        const vector<uint8_t> clientid = getClientId(client);
+        Lease4Ptr lease(new Lease4(getAddress(client), &hwaddr[0],
+                                   hwaddr.size(), &clientid[0],
+                                   clientid.size(), VALID_LIFETIME, 1000,
+                                   2000, time(NULL), subnet_->getID()));
+        checkInsert(LeaseMgrFactory::instance().addLease(lease), client);
+        inserted_.push_back(lease);
+    }
+
+    virtual void getByAddress(uint32_t client) {
+        LeaseMgrFactory::instance().getLease4(getAddress(client));
+    }
+
+    virtual void getByClient(uint32_t client) {
+        LeaseMgrFactory::instance().getLease4(HWAddr(getHWAddr(client),
+                                                     HTYPE_ETHER),
+                                              subnet_->getID());
+    }
+
+    virtual void update(uint32_t client) {
+        inserted_[client]->cltt_ = time(NULL);
+        LeaseMgrFactory::instance().updateLease4(inserted_[client]);
+    }
+
+    virtual IOAddress allocate(uint32_t client) {
+        const vector<uint8_t> clientid = getClientId(client);
+        Lease4Ptr old_lease;
+        Lease4Ptr lease =
+            engine_.allocateLease4(subnet_,
+                                   ClientIdPtr(new ClientId(clientid)),
+                                   HWAddrPtr(new HWAddr(getHWAddr(client),
+                                                        HTYPE_ETHER)),
+                                   IOAddress("0.0.0.0"), false, false, "",
+                                   false, hooks::CalloutHandlePtr(),
+                                   old_lease);
+        if (!lease) {
+            bundy_throw(Unexpected, "failed to allocate a lease to client "
+                        << client);
+        }
+        return (lease->addr_);
+    }
+
+    virtual void remove(const IOAddress& address) {
+        LeaseMgrFactory::instance().deleteLease(address);
+    }
+
+    /// @brief Returns 10.128.0.0 + client.
+    virtual IOAddress getAddress(uint32_t client) const {
+        return (IOAddress(0x0a800000 + client));
+    }
+
+private:
+    /// @brief Returns the hardware address of the client.
+    vector<uint8_t> getHWAddr(uint32_t client) const {
+        vector<uint8_t> hwaddr(2);
+        hwaddr[0] = 0x08;
+        appendClient(hwaddr, client);
+        return (hwaddr);
+    }
+
+    /// @brief Returns the client identifier of the client.
+    vector<uint8_t> getClientId(uint32_t client) const {
+        vector<uint8_t> clientid = getHWAddr(client);
+        clientid.insert(clientid.begin(), HTYPE_ETHER);
+        return (clientid);
+    }
+
+    Subnet4Ptr subnet_;
+    AllocEngine engine_;
+    vector<Lease4Ptr> inserted_;
+};
+
+/// @brief DHCPv6 workloads.
+///
+/// The subnet is 2001:db8::/64, with the pool covering it all.  The
+/// clients have one IA_NA each.
+class LeaseBench6 : public LeaseBench {
+public:
+    /// @brief Constructor.
+    ///
+    /// @param alloc_type Allocator of the allocation engine.
+    LeaseBench6(uint32_t leases, uint32_t operations, uint32_t lookups,
+                uint32_t hits, AllocEngine::AllocType alloc_type) :
+        LeaseBench(leases, operations, lookups, hits),
+        subnet_(new Subnet6(IOAddress("2001:db8::"), 64, 1000, 2000,
+                            3000, VALID_LIFETIME)),
+        engine_(alloc_type, 100, true)
+    {
+        subnet_->addPool(Pool6Ptr(new Pool6(Lease::TYPE_NA,
+                                            IOAddress("2001:db8::"), 64)));
+    }
+
+protected:
+    virtual void insert(uint32_t client) {
+        Lease6Ptr lease(new Lease6(Lease::TYPE_NA, getAddress(client),
+                                   getDuid(client), IAID, 3000,
+                                   VALID_LIFETIME, 1000, 2000,
+                                   subnet_->getID()));
+        checkInsert(LeaseMgrFactory::instance().addLease(lease), client);
+        inserted_.push_back(lease);
+    }
+
+    virtual void getByAddress(uint32_t client) {
+        LeaseMgrFactory::instance().getLease6(Lease::TYPE_NA,
+                                              getAddress(client));
+    }
+
+    virtual void getByClient(uint32_t client) {
+        LeaseMgrFactory::instance().getLeases6(Lease::TYPE_NA,
+                                               *getDuid(client), IAID,
+                                               subnet_->getID());
+    }
+
+    virtual void update(uint32_t client) {
+        inserted_[client]->cltt_ = time(NULL);
+        LeaseMgrFactory::instance().updateLease6(inserted_[client]);
+    }
+
+    virtual IOAddress allocate(uint32_t client) {
+        Lease6Collection old_leases;
+        Lease6Collection leases =
+            engine_.allocateLeases6(subnet_, getDuid(client), IAID,
+                                    IOAddress("::"), Lease::TYPE_NA,
+                                    false, false, "", false,
+                                    hooks::CalloutHandlePtr(), old_leases);
+        if (leases.empty()) {
+            bundy_throw(Unexpected, "failed to allocate a lease to client "
+                        << client);
+        }
+        return (leases[0]->addr_);
+    }
+
+    virtual void remove(const IOAddress& address) {
+        LeaseMgrFactory::instance().deleteLease(address);
+    }
+
+    /// @brief Returns 2001:db8::8000:0:0 + client.
+    virtual IOAddress getAddress(uint32_t client) const {
+        vector<uint8_t> addr(12);
+        addr[0] = 0x20;
+        addr[1] = 0x01;
+        addr[2] = 0x0d;
+        addr[3] = 0xb8;
+        addr[10] = 0x80;
+        appendClient(addr, client);
+        return (IOAddress::fromBytes(AF_INET6, &addr[0]));
+    }
+
+private:
+    /// @brief Returns the DUID-LL of the client.
+    DuidPtr getDuid(uint32_t client) const {
+        vector<uint8_t> duid(6);
+        duid[1] = 3;
+        duid[3] = 1;
+        duid[4] = 0x08;
+        appendClient(duid, client);
+        return (DuidPtr(new DUID(duid)));
+    }
+
+    /// @brief IAID of the IA_NA of the clients.
+    static const uint32_t IAID = 1;
+
+    Subnet6Ptr subnet_;
+    AllocEngine engine_;
+    vector<Lease6Ptr> inserted_;
+};
+
+void
+usage() {
+    cerr << "Usage: lease_mgr_bench [-6] [-d dbaccess] [-n leases]"
+         << " [-i operations]" << endl
+         << "                       [-l lookups] [-r hits] [-a allocator]"
+         << " [-s seed]" << endl;
+    cerr << "  -6: benchmark the DHCPv6 leases instead of the DHCPv4 ones"
+         << endl;
+    cerr << "  -d dbaccess: lease database access string (default "
+         << "\"type=memfile persist=false\")" << endl;
+    cerr << "  -n leases: number of leases in the database (default 10000)"
+         << endl;
+    cerr << "  -i operations: number of operations of each workload "
+         << "(default 10000)" << endl;
+    cerr << "  -l lookups: percentage of lookups in the mixed workload, "
+         << "the others are updates (default 80)" << endl;
+    cerr << "  -r hits: percentage of lookups finding a lease (default 90)"
+         << endl;
+    cerr << "  -a allocator: iterative (default), hashed, random or indexed"
+         << endl;
+    cerr << "  -s seed: seed picking the clients (default current time)"
+         << endl;
+    exit(1);
+}
+
+uint32_t
+getNumber(const char* option, const char* value, uint32_t max) {
+    uint32_t number = 0;
+    try {
+        number = boost::lexical_cast<uint32_t>(value);
+    } catch (const boost::bad_lexical_cast&) {
+        cerr << "Failed to parse " << option << ": [" << value << "]" << endl;
+        usage();
+    }
+    if (number > max) {
+        cerr << option << " must not exceed " << max << endl;
+        usage();
+    }
+    return (number);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    bool v6 = false;
+    string dbaccess = "type=memfile persist=false";
+    uint32_t leases = 10000;
+    uint32_t operations = 10000;
+    uint32_t lookups = 80;
+    uint32_t hits = 90;
+    AllocEngine::AllocType alloc_type = AllocEngine::ALLOC_ITERATIVE;
+    uint32_t seed = time(NULL);
+
+    int ch;
+    while ((ch = getopt(argc, argv, "6d:n:i:l:r:a:s:")) != -1) {
+        switch (ch) {
+        case '6':
+            v6 = true;
+            break;
+        case 'd':
+            dbaccess = optarg;
+            break;
+        case 'n':
+            // The addresses of the leases inserted and missed must fit
+            // in the second half of the IPv4 pool.
+            leases = getNumber("number of leases", optarg, 1 << 22);
+            break;
+        case 'i':
+            operations = getNumber("number of operations", optarg, 1 << 22);
+            break;
+        case 'l':
+            lookups = getNumber("percentage of lookups", optarg, 100);
+            break;
+        case 'r':
+            hits = getNumber("percentage of hits", optarg, 100);
+            break;
+        case 'a':
+            if (strcmp(optarg, "iterative") == 0) {
+                alloc_type = AllocEngine::ALLOC_ITERATIVE;
+            } else if (strcmp(optarg, "hashed") == 0) {
+                alloc_type = AllocEngine::ALLOC_HASHED;
+            } else if (strcmp(optarg, "random") == 0) {
+                alloc_type = AllocEngine::ALLOC_RANDOM;
+            } else if (strcmp(optarg, "indexed") == 0) {
+                alloc_type = AllocEngine::ALLOC_INDEXED;
+            } else {
+                cerr << "Unknown allocator: [" << optarg << "]" << endl;
+                usage();
+            }
+            break;
+        case 's':
+            seed = getNumber("seed", optarg,
+                             numeric_limits<uint32_t>::max());
+            break;
+        case '?':
+        default:
+            usage();
+        }
+    }
+    if (argc > optind || leases == 0) {
+        usage();
+    }
+
+    bundy::log::initLogger("lease_mgr_bench", bundy::log::WARN);
+    srandom(seed);
+
+    cout << "Parameters:" << endl;
+    cout << "  Leases: " << leases << " (DHCPv" << (v6 ? 6 : 4) << ")"
+         << endl;
+    cout << "  Operations: " << operations << endl;
+    cout << "  Lookups in mixed workload: " << lookups << "%" << endl;
+    cout << "  Lookup hits: " << hits << "%" << endl;
+    cout << "  Seed: " << seed << endl;
+
+    try {
+        // The memfile backend needs to know which leases it holds.
+        LeaseMgrFactory::create(dbaccess + (v6 ? " universe=6" :
+                                            " universe=4"));
+        cout << "  Database: " << LeaseMgrFactory::instance().getType()
+             << " (" << LeaseMgrFactory::instance().getName() << ")"
+             << endl;
+
+        if (v6) {
+            LeaseBench6(leases, operations, lookups, hits, alloc_type).run();
+        } else {
+            LeaseBench4(leases, operations, lookups, hits, alloc_type).run();
+        }
+        LeaseMgrFactory::destroy();
+    } catch (const std::exception& ex) {
+        cerr << "Benchmark failed: " << ex.what() << endl;
+        return (1);
+    }
+
+    return (0);
+}
@@ -18,20 +18,66 @@
 #include <hooks/hooks_manager.h>
 #include <hooks/callout_handle.h>
 
+#include <boost/noncopyable.hpp>
+
+#include <pthread.h>
+
 namespace bundy {
 namespace dhcp {
 
+/// @brief Per-thread storage of the packet and its CalloutHandle
+///
+/// Used by @c getCalloutHandle(), so each of the threads processing the
+/// packets has the handle of its own packet.  The storage of a thread is
+/// freed when the thread exits.
+///
+/// @tparam T Type of the pointer to the packet.
+template <typename T>
+class CalloutHandleSlots : public boost::noncopyable {
+public:
+    /// @brief The stored data of one thread.
+    struct Slot {
+        T pointer;                              ///< Pointer to last packet seen
+        bundy::hooks::CalloutHandlePtr handle;  ///< Pointer to stored handle
+    };
+
+    /// @brief Constructor.
+    CalloutHandleSlots() {
+        pthread_key_create(&key_, destroySlot);
+    }
+
+    /// @brief Return the data of the calling thread.
+    Slot& get() {
+        Slot* slot = static_cast<Slot*>(pthread_getspecific(key_));
+        if (!slot) {
+            slot = new Slot();
+            pthread_setspecific(key_, slot);
+        }
+        return (*slot);
+    }
+
+private:
+    /// @brief Free the data of an exiting thread.
+    static void destroySlot(void* slot) {
+        delete static_cast<Slot*>(slot);
+    }
+
+    pthread_key_t key_;
+};
+
 /// @brief CalloutHandle Store
 ///
 /// When using the Hooks Framework, there is a need to associate an
 /// bundy::hooks::CalloutHandle object with each request passing through the
 /// server.  For the DHCP servers, the association is provided by this function.
 ///
-/// The DHCP servers process a single request at a time. At points where the
-/// CalloutHandle is required, the pointer to the current request (packet) is
-/// passed to this function.  If the request is a new one, a pointer to
+/// Each thread of the DHCP servers processes a single request at a time. At
+/// points where the CalloutHandle is required, the pointer to the current
+/// request (packet) is passed to this function.  If the request is a new one, a pointer to
 /// the request is stored, a new CalloutHandle is allocated (and stored) and
-/// a pointer to the latter object returned to the caller.  If the request
+/// a pointer to the latter object returned to the caller.  The handle of the
+/// previous request is reused (after being reset) for the new one if nothing
+/// else holds it, see @c HooksManager::recycleCalloutHandle().  If the request
 /// matches the one stored, the pointer to the stored CalloutHandle is
 /// returned.
 ///
@@ -40,10 +86,8 @@ namespace dhcp {
 /// CalloutHandle.  As the stored pointers are shared pointers, clearing them
 /// removes one reference that keeps the pointed-to objects in existence.
 ///
-/// @note If the behaviour of the server changes so that multiple packets can
-///       be active at the same time, this simplistic approach will no longer
-///       be adequate and a more complicated structure (such as a map) will
-///       be needed.
+/// The pointers are stored separately for every thread, so the packets
+/// processed by different threads at the same time don't share a handle.
 ///
 /// @param pktptr Pointer to the packet being processed.  This is typically a
 ///        Pkt4Ptr or Pkt6Ptr object.  An empty pointer is passed to clear
@@ -58,9 +102,10 @@ template <typename T>
 bundy::hooks::CalloutHandlePtr getCalloutHandle(const T& pktptr) {
 
     // Stored data is declared static, so is initialized when first accessed
-    static T stored_pointer;                // Pointer to last packet seen
-    static bundy::hooks::CalloutHandlePtr stored_handle;
-                                            // Pointer to stored handle
+    static CalloutHandleSlots<T> slots;
+    typename CalloutHandleSlots<T>::Slot& slot = slots.get();
+    T& stored_pointer = slot.pointer;
+    bundy::hooks::CalloutHandlePtr& stored_handle = slot.handle;
 
     if (pktptr) {
 
@@ -69,10 +114,12 @@ bundy::hooks::CalloutHandlePtr getCalloutHandle(const T& pktptr) {
         if (pktptr != stored_pointer) {
 
             // Not seen before, so store the pointer passed to us and get a new
-            // CalloutHandle.  (The latter operation frees and probably deletes
-            // (depending on other pointers) the stored one.)
+            // CalloutHandle.  (The latter operation resets the stored one if
+            // it can be reused, or frees and probably deletes it, depending
+            // on other pointers.)
             stored_pointer = pktptr;
-            stored_handle = bundy::hooks::HooksManager::createCalloutHandle();
+            stored_handle =
+                bundy::hooks::HooksManager::recycleCalloutHandle(stored_handle);
         }
         
     } else {
@@ -133,21 +133,13 @@ CfgMgr::getSubnet6(const std::string& iface,
         return (Subnet6Ptr());
     }
 
-    // If there is more than one, we need to choose the proper one
-    for (Subnet6Collection::iterator subnet = subnets6_.begin();
-         subnet != subnets6_.end(); ++subnet) {
-
-        // If client is rejected because of not meeting client class criteria...
-        if (!(*subnet)->clientSupported(classes)) {
-            continue;
-        }
-
-        if (iface == (*subnet)->getIface()) {
-            LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
-                      DHCPSRV_CFGMGR_SUBNET6_IFACE)
-                .arg((*subnet)->toText()).arg(iface);
-            return (*subnet);
-        }
+    const size_t position = subnets6_index_.findByIface(iface, classes);
+    if (position != SubnetIndex::NOT_FOUND) {
+        const Subnet6Ptr& subnet = subnets6_[position];
+        LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
+                  DHCPSRV_CFGMGR_SUBNET6_IFACE)
+            .arg(subnet->toText()).arg(iface);
+        return (subnet);
     }
     return (Subnet6Ptr());
 }
@@ -157,29 +149,23 @@ CfgMgr::getSubnet6(const bundy::asiolink::IOAddress& hint,
                    const bundy::dhcp::ClientClasses& classes,
                    const bool relay) {
 
-    // If there is more than one, we need to choose the proper one
-    for (Subnet6Collection::iterator subnet = subnets6_.begin();
-         subnet != subnets6_.end(); ++subnet) {
-
-        // If client is rejected because of not meeting client class criteria...
-        if (!(*subnet)->clientSupported(classes)) {
-            continue;
-        }
+    const size_t position = subnets6_index_.findByAddress(hint, classes,
+                                                          relay);
+    if (position != SubnetIndex::NOT_FOUND) {
+        const Subnet6Ptr& subnet = subnets6_[position];
 
         // If the hint is a relay address, and there is relay info specified
-        // for this subnet and those two match, then use this subnet.
-        if (relay && ((*subnet)->getRelayInfo().addr_ == hint) ) {
+        // for this subnet and those two match, then this subnet was selected
+        // for its relay.
+        if (relay && (subnet->getRelayInfo().addr_ == hint)) {
             LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
                       DHCPSRV_CFGMGR_SUBNET6_RELAY)
-                .arg((*subnet)->toText()).arg(hint.toText());
-            return (*subnet);
-        }
-
-        if ((*subnet)->inRange(hint)) {
+                .arg(subnet->toText()).arg(hint.toText());
+        } else {
             LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_SUBNET6)
-                      .arg((*subnet)->toText()).arg(hint.toText());
-            return (*subnet);
+                .arg(subnet->toText()).arg(hint.toText());
         }
+        return (subnet);
     }
 
     // sorry, we don't support that subnet
@@ -194,23 +180,14 @@ Subnet6Ptr CfgMgr::getSubnet6(OptionPtr iface_id_option,
         return (Subnet6Ptr());
     }
 
-    // Let's iterate over all subnets and for those that have interface-id
-    // defined, check if the interface-id is equal to what we are looking for
-    for (Subnet6Collection::iterator subnet = subnets6_.begin();
-         subnet != subnets6_.end(); ++subnet) {
-
-        // If client is rejected because of not meeting client class criteria...
-        if (!(*subnet)->clientSupported(classes)) {
-            continue;
-        }
-
-        if ( (*subnet)->getInterfaceId() &&
-             ((*subnet)->getInterfaceId()->equal(iface_id_option))) {
-            LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
-                      DHCPSRV_CFGMGR_SUBNET6_IFACE_ID)
-                .arg((*subnet)->toText());
-            return (*subnet);
-        }
+    const size_t position =
+        subnets6_index_.findByInterfaceId(iface_id_option, classes);
+    if (position != SubnetIndex::NOT_FOUND) {
+        const Subnet6Ptr& subnet = subnets6_[position];
+        LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
+                  DHCPSRV_CFGMGR_SUBNET6_IFACE_ID)
+            .arg(subnet->toText());
+        return (subnet);
     }
     return (Subnet6Ptr());
 }
@@ -225,39 +202,33 @@ void CfgMgr::addSubnet6(const Subnet6Ptr& subnet) {
     }
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_ADD_SUBNET6)
               .arg(subnet->toText());
+    subnet->packOptions();
     subnets6_.push_back(subnet);
+    subnets6_index_.add(subnet, subnet->getInterfaceId());
 }
 
 Subnet4Ptr
 CfgMgr::getSubnet4(const bundy::asiolink::IOAddress& hint,
                    const bundy::dhcp::ClientClasses& classes,
                    bool relay) const {
-    // Iterate over existing subnets to find a suitable one for the
-    // given address.
-    for (Subnet4Collection::const_iterator subnet = subnets4_.begin();
-         subnet != subnets4_.end(); ++subnet) {
-
-        // If client is rejected because of not meeting client class criteria...
-        if (!(*subnet)->clientSupported(classes)) {
-            continue;
-        }
+    const size_t position = subnets4_index_.findByAddress(hint, classes,
+                                                          relay);
+    if (position != SubnetIndex::NOT_FOUND) {
+        const Subnet4Ptr& subnet = subnets4_[position];
 
         // If the hint is a relay address, and there is relay info specified
-        // for this subnet and those two match, then use this subnet.
-        if (relay && ((*subnet)->getRelayInfo().addr_ == hint) ) {
+        // for this subnet and those two match, then this subnet was selected
+        // for its relay.
+        if (relay && (subnet->getRelayInfo().addr_ == hint)) {
             LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
                       DHCPSRV_CFGMGR_SUBNET4_RELAY)
-                .arg((*subnet)->toText()).arg(hint.toText());
-            return (*subnet);
-        }
-
-        // Let's check if the client belongs to the given subnet
-        if ((*subnet)->inRange(hint)) {
+                .arg(subnet->toText()).arg(hint.toText());
+        } else {
             LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
                       DHCPSRV_CFGMGR_SUBNET4)
-                      .arg((*subnet)->toText()).arg(hint.toText());
-            return (*subnet);
+                .arg(subnet->toText()).arg(hint.toText());
         }
+        return (subnet);
     }
 
     // sorry, we don't support that subnet
@@ -292,7 +263,10 @@ void CfgMgr::addSubnet4(const Subnet4Ptr& subnet) {
     }
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_ADD_SUBNET4)
               .arg(subnet->toText());
+    subnet->packOptions();
     subnets4_.push_back(subnet);
+    subnets4_index_.add(subnet);
+    ++subnets4_generation_;
 }
 
 void CfgMgr::deleteOptionDefs() {
@@ -302,11 +276,31 @@ void CfgMgr::deleteOptionDefs() {
 void CfgMgr::deleteSubnets4() {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_DELETE_SUBNET4);
     subnets4_.clear();
+    subnets4_index_.clear();
+    ++subnets4_generation_;
 }
 
 void CfgMgr::deleteSubnets6() {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE, DHCPSRV_CFGMGR_DELETE_SUBNET6);
     subnets6_.clear();
+    subnets6_index_.clear();
+}
+
+void CfgMgr::reindexSubnets4() {
+    subnets4_index_.clear();
+    for (Subnet4Collection::const_iterator subnet = subnets4_.begin();
+         subnet != subnets4_.end(); ++subnet) {
+        subnets4_index_.add(*subnet);
+    }
+    ++subnets4_generation_;
+}
+
+void CfgMgr::reindexSubnets6() {
+    subnets6_index_.clear();
+    for (Subnet6Collection::const_iterator subnet = subnets6_.begin();
+         subnet != subnets6_.end(); ++subnet) {
+        subnets6_index_.add(*subnet, (*subnet)->getInterfaceId());
+    }
 }
 
 
@@ -387,24 +381,12 @@ CfgMgr::isIfaceListedActive(const std::string& iface) const {
 
 bool
 CfgMgr::isDuplicate(const Subnet4& subnet) const {
-    for (Subnet4Collection::const_iterator subnet_it = subnets4_.begin();
-         subnet_it != subnets4_.end(); ++subnet_it) {
-        if ((*subnet_it)->getID() == subnet.getID()) {
-            return (true);
-        }
-    }
-    return (false);
+    return (subnets4_index_.hasId(subnet.getID()));
 }
 
 bool
 CfgMgr::isDuplicate(const Subnet6& subnet) const {
-    for (Subnet6Collection::const_iterator subnet_it = subnets6_.begin();
-         subnet_it != subnets6_.end(); ++subnet_it) {
-        if ((*subnet_it)->getID() == subnet.getID()) {
-            return (true);
-        }
-    }
-    return (false);
+    return (subnets6_index_.hasId(subnet.getID()));
 }
 
 
@@ -438,7 +420,7 @@ CfgMgr::getD2ClientMgr() {
 }
 
 CfgMgr::CfgMgr()
-    : datadir_(DHCP_DATA_DIR),
+    : subnets4_generation_(0), datadir_(DHCP_DATA_DIR),
       all_ifaces_active_(false), echo_v4_client_id_(true),
       d2_client_mgr_() {
     // DHCP_DATA_DIR must be set set with -DDHCP_DATA_DIR="..." in Makefile.am
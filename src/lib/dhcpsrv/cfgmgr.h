@@ -24,6 +24,7 @@
 #include <dhcpsrv/option_space_container.h>
 #include <dhcpsrv/pool.h>
 #include <dhcpsrv/subnet.h>
+#include <dhcpsrv/subnet_index.h>
 #include <util/buffer.h>
 
 #include <boost/shared_ptr.hpp>
@@ -226,6 +227,8 @@ public:
 
     /// @brief adds an IPv6 subnet
     ///
+    /// The options of the subnet are packed (see @c Subnet::packOptions()).
+    ///
     /// @param subnet new subnet to be added.
     void addSubnet6(const Subnet6Ptr& subnet);
 
@@ -249,6 +252,13 @@ public:
     /// completely new?
     void deleteSubnets6();
 
+    /// @brief Rebuilds the index of the IPv6 subnets.
+    ///
+    /// The relay address, the interface name and the interface-id of the
+    /// subnets are indexed when the subnets are added.  This must be
+    /// called if they are changed afterwards.
+    void reindexSubnets6();
+
     /// @brief returns const reference to all subnets6
     ///
     /// This is used in a hook (subnet4_select), where the hook is able
@@ -311,6 +321,10 @@ public:
                           const bundy::dhcp::ClientClasses& classes) const;
 
     /// @brief adds a subnet4
+    ///
+    /// The options of the subnet are packed (see @c Subnet::packOptions()).
+    ///
+    /// @param subnet new subnet to be added.
     void addSubnet4(const Subnet4Ptr& subnet);
 
     /// @brief removes all IPv4 subnets
@@ -325,6 +339,23 @@ public:
     /// completely new?
     void deleteSubnets4();
 
+    /// @brief Rebuilds the index of the IPv4 subnets.
+    ///
+    /// The relay addresses of the subnets are indexed when the subnets are
+    /// added.  This must be called if they are changed afterwards.
+    void reindexSubnets4();
+
+    /// @brief Returns the generation of the IPv4 subnets.
+    ///
+    /// The generation changes whenever IPv4 subnets are added, deleted
+    /// or reindexed, i.e. on every reconfiguration.  The servers check it
+    /// to tell if what they derived from the subnets is still valid.
+    ///
+    /// @return The generation of the IPv4 subnets.
+    uint32_t getSubnets4Generation() const {
+        return (subnets4_generation_);
+    }
+
 
     /// @brief returns path do the data directory
     ///
@@ -435,20 +466,25 @@ protected:
 
     /// @brief a container for IPv6 subnets.
     ///
-    /// That is a simple vector of pointers. It does not make much sense to
-    /// optimize access time (e.g. using a map), because typical search
-    /// pattern will use calling inRange() method on each subnet until
-    /// a match is found.
+    /// That is a simple vector of pointers, in the order of the
+    /// configuration.  The subnets are selected with @c subnets6_index_.
     Subnet6Collection subnets6_;
 
     /// @brief a container for IPv4 subnets.
     ///
-    /// That is a simple vector of pointers. It does not make much sense to
-    /// optimize access time (e.g. using a map), because typical search
-    /// pattern will use calling inRange() method on each subnet until
-    /// a match is found.
+    /// That is a simple vector of pointers, in the order of the
+    /// configuration.  The subnets are selected with @c subnets4_index_.
     Subnet4Collection subnets4_;
 
+    /// @brief Index of the IPv6 subnets, by position in @c subnets6_.
+    SubnetIndex subnets6_index_;
+
+    /// @brief Index of the IPv4 subnets, by position in @c subnets4_.
+    SubnetIndex subnets4_index_;
+
+    /// @brief Generation of the IPv4 subnets.
+    uint32_t subnets4_generation_;
+
 private:
 
     /// @brief Checks if the specified interface is listed as active.
@@ -0,0 +1,125 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcpsrv/cfgmgr.h>
+#include <dhcpsrv/client_cache.h>
+
+using namespace bundy::util::thread;
+
+namespace bundy {
+namespace dhcp {
+
+ClientCache4::ClientCache4(size_t max_size) :
+    max_size_(max_size)
+{
+}
+
+void
+ClientCache4::setMaxSize(size_t max_size) {
+    Mutex::Locker lock(mutex_);
+    max_size_ = max_size;
+    trim();
+}
+
+size_t
+ClientCache4::getMaxSize() const {
+    Mutex::Locker lock(mutex_);
+    return (max_size_);
+}
+
+size_t
+ClientCache4::getSize() const {
+    Mutex::Locker lock(mutex_);
+    return (items_.size());
+}
+
+bool
+ClientCache4::get(const Key& key, const std::vector<uint8_t>& signature,
+                  ClientCacheEntry4& entry) {
+    Mutex::Locker lock(mutex_);
+    std::map<Key, Item>::iterator item = items_.find(key);
+    if (item == items_.end()) {
+        return (false);
+    }
+    if (item->second.generation_ !=
+        CfgMgr::instance().getSubnets4Generation()) {
+        uses_.erase(item->second.use_);
+        items_.erase(item);
+        return (false);
+    }
+    if (item->second.entry_.signature_ != signature) {
+        return (false);
+    }
+
+    uses_.splice(uses_.begin(), uses_, item->second.use_);
+    entry = item->second.entry_;
+    return (true);
+}
+
+void
+ClientCache4::add(const Key& key, const ClientCacheEntry4& entry) {
+    Mutex::Locker lock(mutex_);
+    if (max_size_ == 0) {
+        return;
+    }
+
+    std::map<Key, Item>::iterator item = items_.find(key);
+    if (item == items_.end()) {
+        item = items_.insert(std::make_pair(key, Item())).first;
+        uses_.push_front(key);
+    } else {
+        uses_.splice(uses_.begin(), uses_, item->second.use_);
+    }
+    item->second.entry_ = entry;
+    item->second.generation_ = CfgMgr::instance().getSubnets4Generation();
+    item->second.use_ = uses_.begin();
+    trim();
+}
+
+void
+ClientCache4::update(const Key& key, const Lease4Ptr& lease) {
+    Mutex::Locker lock(mutex_);
+    std::map<Key, Item>::iterator item = items_.find(key);
+    if (item != items_.end()) {
+        item->second.entry_.lease_ = lease;
+    }
+}
+
+void
+ClientCache4::remove(const Key& key) {
+    Mutex::Locker lock(mutex_);
+    std::map<Key, Item>::iterator item = items_.find(key);
+    if (item != items_.end()) {
+        uses_.erase(item->second.use_);
+        items_.erase(item);
+    }
+}
+
+void
+ClientCache4::clear() {
+    Mutex::Locker lock(mutex_);
+    items_.clear();
+    uses_.clear();
+}
+
+void
+ClientCache4::trim() {
+    while (items_.size() > max_size_) {
+        items_.erase(uses_.back());
+        uses_.pop_back();
+    }
+}
+
+} // namespace bundy::dhcp
+} // namespace bundy
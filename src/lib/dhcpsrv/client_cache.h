@@ -0,0 +1,144 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef CLIENT_CACHE_H
+#define CLIENT_CACHE_H
+
+#include <dhcp/option.h>
+#include <dhcpsrv/lease.h>
+#include <dhcpsrv/subnet.h>
+#include <util/threads/sync.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <list>
+#include <map>
+#include <vector>
+
+#include <stdint.h>
+
+namespace bundy {
+namespace dhcp {
+
+/// @brief What a DHCPv4 server keeps about a client to renew its lease.
+struct ClientCacheEntry4 {
+    /// @brief The subnet selected for the client.
+    Subnet4Ptr subnet_;
+
+    /// @brief The lease of the client, as last written to the database.
+    Lease4Ptr lease_;
+
+    /// @brief The options sent to the client, in the on-wire format.
+    OptionBufferPtr options_;
+
+    /// @brief What the response to the client depends on in its query.
+    ///
+    /// The server builds it from the query, the entry is only used for a
+    /// query with the same signature.
+    std::vector<uint8_t> signature_;
+};
+
+/// @brief Cache of the DHCPv4 clients, to renew their leases quickly.
+///
+/// Most of the requests a server receives are renewals, for which it
+/// selects the same subnet, finds the same lease and sends the same options
+/// again.  This class keeps them for the clients recently served, by
+/// hardware address, so the server can renew the lease with a single
+/// update of the lease database.
+///
+/// The entries are only valid for the configuration in force when they
+/// were added: they are dropped when the IPv4 subnets change (see
+/// @c CfgMgr::getSubnets4Generation()).  When the cache is full, the
+/// entry used the least recently is dropped.  The cache is safe to use by
+/// several threads.
+class ClientCache4 : public boost::noncopyable {
+public:
+    /// @brief Key of the entries, the hardware address of the client.
+    typedef std::vector<uint8_t> Key;
+
+    /// @brief Constructor.
+    ///
+    /// @param max_size Maximum number of entries, 0 to disable the cache.
+    ClientCache4(size_t max_size = 0);
+
+    /// @brief Sets the maximum number of entries.
+    ///
+    /// The entries used the least recently are dropped if there are more.
+    ///
+    /// @param max_size Maximum number of entries, 0 to disable the cache.
+    void setMaxSize(size_t max_size);
+
+    /// @brief Returns the maximum number of entries.
+    size_t getMaxSize() const;
+
+    /// @brief Returns the number of entries.
+    size_t getSize() const;
+
+    /// @brief Finds the entry of a client.
+    ///
+    /// An entry added for another configuration is dropped.
+    ///
+    /// @param key The hardware address of the client.
+    /// @param signature The signature of the client's query.
+    /// @param [out] entry The entry found.
+    /// @return true if there is an entry with the same signature.
+    bool get(const Key& key, const std::vector<uint8_t>& signature,
+             ClientCacheEntry4& entry);
+
+    /// @brief Adds or replaces the entry of a client.
+    ///
+    /// Nothing happens if the cache is disabled.
+    ///
+    /// @param key The hardware address of the client.
+    /// @param entry The entry.
+    void add(const Key& key, const ClientCacheEntry4& entry);
+
+    /// @brief Updates the lease of the entry of a client.
+    ///
+    /// Nothing happens if there is no entry for the client.
+    ///
+    /// @param key The hardware address of the client.
+    /// @param lease The lease as written to the database.
+    void update(const Key& key, const Lease4Ptr& lease);
+
+    /// @brief Removes the entry of a client, if any.
+    ///
+    /// @param key The hardware address of the client.
+    void remove(const Key& key);
+
+    /// @brief Removes all the entries.
+    void clear();
+
+private:
+    /// @brief Entry and when it was added.
+    struct Item {
+        ClientCacheEntry4 entry_;
+        uint32_t generation_;
+        std::list<Key>::iterator use_;
+    };
+
+    /// @brief Drops the entries used the least recently above the maximum.
+    void trim();
+
+    std::map<Key, Item> items_;
+    /// @brief The keys, from the most recently used.
+    std::list<Key> uses_;
+    size_t max_size_;
+    mutable bundy::util::thread::Mutex mutex_;
+};
+
+} // namespace bundy::dhcp
+} // namespace bundy
+
+#endif // CLIENT_CACHE_H
@@ -33,6 +33,7 @@ const bool D2ClientConfig::DFT_OVERRIDE_CLIENT_UPDATE = false;
 const bool D2ClientConfig::DFT_REPLACE_CLIENT_NAME = false;
 const char *D2ClientConfig::DFT_GENERATED_PREFIX = "myhost";
 const char *D2ClientConfig::DFT_QUALIFYING_SUFFIX = "example.com";
+const char *D2ClientConfig::DFT_SERVER_SOCKET = "";
 
 D2ClientConfig::D2ClientConfig(const  bool enable_updates,
                                const bundy::asiolink::IOAddress& server_ip,
@@ -46,10 +47,12 @@ D2ClientConfig::D2ClientConfig(const  bool enable_updates,
                                const bool override_client_update,
                                const bool replace_client_name,
                                const std::string& generated_prefix,
-                               const std::string& qualifying_suffix)
+                               const std::string& qualifying_suffix,
+                               const std::string& server_socket)
     : enable_updates_(enable_updates),
     server_ip_(server_ip),
     server_port_(server_port),
+    server_socket_(server_socket),
     ncr_protocol_(ncr_protocol),
     ncr_format_(ncr_format),
     always_include_fqdn_(always_include_fqdn),
@@ -65,6 +68,7 @@ D2ClientConfig::D2ClientConfig()
     : enable_updates_(false),
       server_ip_(bundy::asiolink::IOAddress("0.0.0.0")),
       server_port_(0),
+      server_socket_(DFT_SERVER_SOCKET),
       ncr_protocol_(dhcp_ddns::NCR_UDP),
       ncr_format_(dhcp_ddns::FMT_JSON),
       always_include_fqdn_(false),
@@ -85,18 +89,17 @@ D2ClientConfig::enableUpdates(bool enable) {
 
 void
 D2ClientConfig::validateContents() {
-    if (ncr_format_ != dhcp_ddns::FMT_JSON) {
-        bundy_throw(D2ClientError, "D2ClientConfig: NCR Format:"
-                    << dhcp_ddns::ncrFormatToString(ncr_format_)
-                    << " is not yet supported");
-    }
-
-    if (ncr_protocol_ != dhcp_ddns::NCR_UDP) {
+    if (ncr_protocol_ == dhcp_ddns::NCR_TCP) {
         bundy_throw(D2ClientError, "D2ClientConfig: NCR Protocol:"
                     << dhcp_ddns::ncrProtocolToString(ncr_protocol_)
                     << " is not yet supported");
     }
 
+    if ((ncr_protocol_ == dhcp_ddns::NCR_UNIX) && server_socket_.empty()) {
+        bundy_throw(D2ClientError, "D2ClientConfig: the server socket"
+                    " path can't be empty with the UNIX protocol");
+    }
+
     /// @todo perhaps more validation we should do yet?
     /// Are there any invalid combinations of options we need to test against?
 }
@@ -106,6 +109,7 @@ D2ClientConfig::operator == (const D2ClientConfig& other) const {
     return ((enable_updates_ == other.enable_updates_) &&
             (server_ip_ == other.server_ip_) &&
             (server_port_ == other.server_port_) &&
+            (server_socket_ == other.server_socket_) &&
             (ncr_protocol_ == other.ncr_protocol_) &&
             (ncr_format_ == other.ncr_format_) &&
             (always_include_fqdn_ == other.always_include_fqdn_) &&
@@ -129,6 +133,7 @@ D2ClientConfig::toText() const {
     if (enable_updates_) {
         stream << ", server_ip: " << server_ip_.toText()
                << ", server_port: " << server_port_
+               << ", server_socket: " << server_socket_
                << ", ncr_protocol: " << ncr_protocol_
                << ", ncr_format: " << ncr_format_
                << ", always_include_fqdn: " << (always_include_fqdn_ ?
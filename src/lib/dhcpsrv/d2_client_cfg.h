@@ -70,6 +70,7 @@ public:
     static const bool DFT_REPLACE_CLIENT_NAME;
     static const char *DFT_GENERATED_PREFIX;
     static const char *DFT_QUALIFYING_SUFFIX;
+    static const char *DFT_SERVER_SOCKET;
 
     /// @brief Constructor
     ///
@@ -77,9 +78,9 @@ public:
     /// @param server_ip IP address of the bundy-dhcp-ddns server (IPv4 or IPv6)
     /// @param server_port IP port of the bundy-dhcp-ddns server
     /// @param ncr_protocol Socket protocol to use with bundy-dhcp-ddns
-    /// Currently only UDP is supported.
-    /// @param ncr_format Format of the bundy-dhcp-ddns requests.
-    /// Currently only JSON format is supported.
+    /// Currently UDP and UNIX are supported.
+    /// @param ncr_format Format of the bundy-dhcp-ddns requests, JSON or
+    /// BINARY.
     /// @param always_include_fqdn Enables always including the FQDN option in
     /// DHCP responses.
     /// @param override_no_update Enables updates, even if clients request no
@@ -90,6 +91,8 @@ public:
     /// supplied by the client with a generated name.
     /// @param generated_prefix Prefix to use when generating domain-names.
     /// @param  qualifying_suffix Suffix to use to qualify partial domain-names.
+    /// @param server_socket Path of the bundy-dhcp-ddns Unix socket, used
+    /// instead of the IP address and port when the protocol is UNIX.
     ///
     /// @throw D2ClientError if given an invalid protocol or format.
     D2ClientConfig(const bool enable_updates,
@@ -102,7 +105,8 @@ public:
                    const bool override_client_update,
                    const bool replace_client_name,
                    const std::string& generated_prefix,
-                   const std::string& qualifying_suffix);
+                   const std::string& qualifying_suffix,
+                   const std::string& server_socket = DFT_SERVER_SOCKET);
 
     /// @brief Default constructor
     /// The default constructor creates an instance that has updates disabled.
@@ -126,6 +130,11 @@ public:
         return(server_port_);
     }
 
+    /// @brief Return the path of the bundy-dhcp-ddns Unix socket.
+    const std::string& getServerSocket() const {
+        return(server_socket_);
+    }
+
     /// @brief Return the socket protocol to use with bundy-dhcp-ddns.
     const dhcp_ddns::NameChangeProtocol& getNcrProtocol() const {
          return(ncr_protocol_);
@@ -202,12 +211,14 @@ private:
     /// @brief IP port of the bundy-dhcp-ddns server.
     size_t server_port_;
 
+    /// @brief Path of the bundy-dhcp-ddns Unix socket.
+    std::string server_socket_;
+
     /// @brief The socket protocol to use with bundy-dhcp-ddns.
-    /// Currently only UDP is supported.
+    /// Currently UDP and UNIX are supported.
     dhcp_ddns::NameChangeProtocol ncr_protocol_;
 
     /// @brief Format of the bundy-dhcp-ddns requests.
-    /// Currently only JSON format is supported.
     dhcp_ddns::NameChangeFormat ncr_format_;
 
     /// @brief Should Kea always include the FQDN option in its response.
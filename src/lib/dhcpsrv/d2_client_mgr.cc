@@ -14,6 +14,7 @@
 
 #include <dhcp/iface_mgr.h>
 #include <dhcp_ddns/ncr_udp.h>
+#include <dhcp_ddns/ncr_unix.h>
 #include <dhcpsrv/d2_client_mgr.h>
 #include <dhcpsrv/dhcpsrv_log.h>
 
@@ -22,6 +23,8 @@
 #include <string>
 
 using namespace std;
+using bundy::util::locks::recursive_mutex;
+using bundy::util::locks::scoped_lock;
 
 namespace bundy {
 namespace dhcp {
@@ -38,6 +41,7 @@ D2ClientMgr::~D2ClientMgr(){
 
 void
 D2ClientMgr::suspendUpdates() {
+    scoped_lock<recursive_mutex> lock(mutex_);
     if (ddnsEnabled()) {
         /// @todo For now we will disable updates and stop sending.
         /// This at least provides a means to shut it off if there are errors.
@@ -51,6 +55,7 @@ D2ClientMgr::suspendUpdates() {
 
 void
 D2ClientMgr::setD2ClientConfig(D2ClientConfigPtr& new_config) {
+    scoped_lock<recursive_mutex> lock(mutex_);
     if (!new_config) {
         bundy_throw(D2ClientError,
                   "D2ClientMgr cannot set DHCP-DDNS configuration to NULL.");
@@ -85,6 +90,14 @@ D2ClientMgr::setD2ClientConfig(D2ClientConfigPtr& new_config) {
                                                 *this, queue_max));
                 break;
                 }
+            case dhcp_ddns::NCR_UNIX: {
+                uint32_t queue_max = 1024;
+                new_sender.reset(new dhcp_ddns::NameChangeUnixSender(
+                                                new_config->getServerSocket(),
+                                                new_config->getNcrFormat(),
+                                                *this, queue_max));
+                break;
+                }
             default:
                 // In theory you can't get here.
                 bundy_throw(D2ClientError, "Invalid sender Protocol: "
@@ -204,6 +217,7 @@ D2ClientMgr::qualifyName(const std::string& partial_name) const {
 
 void
 D2ClientMgr::startSender(D2ClientErrorHandler error_handler) {
+    scoped_lock<recursive_mutex> lock(mutex_);
     if (amSending()) {
         return;
     }
@@ -219,6 +233,7 @@ D2ClientMgr::startSender(D2ClientErrorHandler error_handler) {
 void
 D2ClientMgr::startSender(D2ClientErrorHandler error_handler,
                          bundy::asiolink::IOService& io_service) {
+    scoped_lock<recursive_mutex> lock(mutex_);
     if (amSending()) {
         return;
     }
@@ -248,11 +263,13 @@ D2ClientMgr::startSender(D2ClientErrorHandler error_handler,
 
 bool
 D2ClientMgr::amSending() const {
+    scoped_lock<recursive_mutex> lock(mutex_);
     return (name_change_sender_ && name_change_sender_->amSending());
 }
 
 void
 D2ClientMgr::stopSender() {
+    scoped_lock<recursive_mutex> lock(mutex_);
     /// Unregister sender's select-fd.
     if (registered_select_fd_ != dhcp_ddns::WatchSocket::INVALID_SOCKET) {
         IfaceMgr::instance().deleteExternalSocket(registered_select_fd_);
@@ -268,6 +285,7 @@ D2ClientMgr::stopSender() {
 
 void
 D2ClientMgr::sendRequest(dhcp_ddns::NameChangeRequestPtr& ncr) {
+    scoped_lock<recursive_mutex> lock(mutex_);
     if (!amSending()) {
         // This is programmatic error so bust them for it.
         bundy_throw(D2ClientError, "D2ClientMgr::sendRequest not in send mode");
@@ -302,6 +320,7 @@ D2ClientMgr::invokeClientErrorHandler(const dhcp_ddns::NameChangeSender::
 
 size_t
 D2ClientMgr::getQueueSize() const {
+    scoped_lock<recursive_mutex> lock(mutex_);
     if (!name_change_sender_) {
         bundy_throw(D2ClientError, "D2ClientMgr::getQueueSize sender is null");
     }
@@ -311,6 +330,7 @@ D2ClientMgr::getQueueSize() const {
 
 size_t
 D2ClientMgr::getQueueMaxSize() const {
+    scoped_lock<recursive_mutex> lock(mutex_);
     if (!name_change_sender_) {
         bundy_throw(D2ClientError, "D2ClientMgr::getQueueMaxSize sender is null");
     }
@@ -322,6 +342,7 @@ D2ClientMgr::getQueueMaxSize() const {
 
 const dhcp_ddns::NameChangeRequestPtr&
 D2ClientMgr::peekAt(const size_t index) const {
+    scoped_lock<recursive_mutex> lock(mutex_);
     if (!name_change_sender_) {
         bundy_throw(D2ClientError, "D2ClientMgr::peekAt sender is null");
     }
@@ -331,6 +352,7 @@ D2ClientMgr::peekAt(const size_t index) const {
 
 void
 D2ClientMgr::clearQueue() {
+    scoped_lock<recursive_mutex> lock(mutex_);
     if (!name_change_sender_) {
         bundy_throw(D2ClientError, "D2ClientMgr::clearQueue sender is null");
     }
@@ -341,6 +363,7 @@ D2ClientMgr::clearQueue() {
 void
 D2ClientMgr::operator()(const dhcp_ddns::NameChangeSender::Result result,
                         dhcp_ddns::NameChangeRequestPtr& ncr) {
+    scoped_lock<recursive_mutex> lock(mutex_);
     if (result == dhcp_ddns::NameChangeSender::SUCCESS) {
         LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
                   DHCPSRV_DHCP_DDNS_NCR_SENT).arg(ncr->toText());
@@ -351,6 +374,7 @@ D2ClientMgr::operator()(const dhcp_ddns::NameChangeSender::Result result,
 
 int
 D2ClientMgr::getSelectFd() {
+    scoped_lock<recursive_mutex> lock(mutex_);
     if (!amSending()) {
         bundy_throw (D2ClientError, "D2ClientMgr::getSelectFd "
                    " not in send mode");
@@ -361,6 +385,7 @@ D2ClientMgr::getSelectFd() {
 
 void
 D2ClientMgr::runReadyIO() {
+    scoped_lock<recursive_mutex> lock(mutex_);
     if (!name_change_sender_) {
         // This should never happen.
         bundy_throw(D2ClientError, "D2ClientMgr::runReadyIO"
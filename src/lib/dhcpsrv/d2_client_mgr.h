@@ -23,6 +23,7 @@
 #include <dhcp_ddns/ncr_io.h>
 #include <dhcpsrv/d2_client_cfg.h>
 #include <exceptions/exceptions.h>
+#include <util/locks.h>
 
 #include <boost/shared_ptr.hpp>
 #include <boost/noncopyable.hpp>
@@ -425,6 +426,13 @@ private:
 
     /// @brief Remembers the select-fd registered with IfaceMgr.
     int registered_select_fd_;
+
+    /// @brief Serializes the access to the sender.
+    ///
+    /// The requests are sent by the threads processing the packets, while
+    /// the completions are handled by the main thread.  The lock is
+    /// recursive, as the error handler may suspend the updates.
+    mutable bundy::util::locks::recursive_mutex mutex_;
 };
 
 template <class T>
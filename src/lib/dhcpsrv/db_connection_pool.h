@@ -0,0 +1,195 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef DB_CONNECTION_POOL_H
+#define DB_CONNECTION_POOL_H
+
+#include <exceptions/exceptions.h>
+#include <util/threads/sync.h>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+namespace bundy {
+namespace dhcp {
+
+/// @brief Pool of the connections to a database.
+///
+/// The SQL lease managers open several connections to the database, so
+/// the packets processed by the worker threads of the servers don't wait
+/// for each other's round trips.  Each call of the lease manager takes a
+/// free connection with a @c DbConnectionPool::Locker and returns it when
+/// done; the calls wait when all the connections are in use.
+///
+/// The database servers flush the commits of the concurrent transactions
+/// to the disk together, so a pool of connections also batches the disk
+/// writes of the leases of the packets processed at the same time.
+///
+/// @tparam Connection Type holding the connection and everything bound to
+///     it (prepared statements, exchange objects).  Its static
+///     @c initThread() is called in the thread taking a connection, before
+///     the connection is taken, to prepare the thread for the use of the
+///     database client library.
+template <typename Connection>
+class DbConnectionPool : public boost::noncopyable {
+public:
+    /// @brief Pointer to a connection.
+    typedef boost::shared_ptr<Connection> ConnectionPtr;
+
+    /// @brief Holds a connection of the pool while in scope.
+    class Locker : public boost::noncopyable {
+    public:
+        /// @brief Constructor, waits for a free connection.
+        ///
+        /// @param pool The pool to take the connection from.
+        /// @throw Whatever @c Connection::initThread() throws.
+        explicit Locker(DbConnectionPool& pool) :
+            pool_(pool), connection_(acquire(pool))
+        {}
+
+        /// @brief Destructor, returns the connection to the pool.
+        ~Locker() {
+            pool_.release(connection_);
+        }
+
+        /// @brief Returns the connection held.
+        Connection& operator*() const {
+            return (*connection_);
+        }
+
+        /// @brief Returns the connection held.
+        Connection* operator->() const {
+            return (connection_);
+        }
+
+    private:
+        /// @brief Prepares the thread and takes a free connection.
+        static Connection* acquire(DbConnectionPool& pool) {
+            Connection::initThread();
+            return (pool.acquire());
+        }
+
+        DbConnectionPool& pool_;
+        Connection* connection_;
+    };
+
+    /// @brief Constructor, creates an empty pool.
+    DbConnectionPool() {}
+
+    /// @brief Adds a connection to the pool.
+    ///
+    /// @param connection The connection, it must not be NULL.
+    void add(const ConnectionPtr& connection) {
+        if (!connection) {
+            bundy_throw(BadValue, "NULL connection added to the pool");
+        }
+        bundy::util::thread::Mutex::Locker lock(mutex_);
+        connections_.push_back(connection);
+        free_.push_back(connection.get());
+        cond_.signal();
+    }
+
+    /// @brief Removes all the connections from the pool.
+    ///
+    /// The connections are closed unless they are held elsewhere.  None of
+    /// them may be in use.
+    void clear() {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
+        free_.clear();
+        connections_.clear();
+    }
+
+    /// @brief Returns all the connections of the pool.
+    ///
+    /// They may be in use by other threads.
+    const std::vector<ConnectionPtr>& getConnections() const {
+        return (connections_);
+    }
+
+    /// @brief Returns the number of the connections of the pool.
+    size_t size() const {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
+        return (connections_.size());
+    }
+
+    /// @brief Returns the number of the connections not in use.
+    size_t getFreeCount() const {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
+        return (free_.size());
+    }
+
+    /// @brief Returns the size of the pool set by the lease manager
+    ///        parameters.
+    ///
+    /// The size is set by the "connections" parameter, it is 1 by default.
+    ///
+    /// @param value Value of the parameter, empty if not specified.
+    /// @throw BadValue if the value is not a positive number.
+    static size_t parseSize(const std::string& value) {
+        if (value.empty()) {
+            return (1);
+        }
+        int size = 0;
+        try {
+            size = boost::lexical_cast<int>(value);
+        } catch (const boost::bad_lexical_cast&) {
+            // Handled below
+        }
+        if (size <= 0) {
+            bundy_throw(BadValue, "invalid value 'connections=" << value
+                      << "'");
+        }
+        return (size);
+    }
+
+private:
+    /// @brief Takes a free connection, waits for one if none is free.
+    Connection* acquire() {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
+        while (free_.empty()) {
+            cond_.wait(mutex_);
+        }
+        Connection* connection = free_.back();
+        free_.pop_back();
+        return (connection);
+    }
+
+    /// @brief Returns a connection to the pool.
+    void release(Connection* connection) {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
+        free_.push_back(connection);
+        cond_.signal();
+    }
+
+    /// @brief All the connections.
+    std::vector<ConnectionPtr> connections_;
+
+    /// @brief The connections not in use.
+    std::vector<Connection*> free_;
+
+    /// @brief Protects the list of the free connections.
+    mutable bundy::util::thread::Mutex mutex_;
+
+    /// @brief Wakes the threads waiting for a connection up.
+    bundy::util::thread::CondVar cond_;
+};
+
+} // namespace bundy::dhcp
+} // namespace bundy
+
+#endif // DB_CONNECTION_POOL_H
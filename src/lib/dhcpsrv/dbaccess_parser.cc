@@ -18,6 +18,7 @@
 #include <dhcpsrv/lease_mgr_factory.h>
 
 #include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
 
 #include <map>
 #include <string>
@@ -57,14 +58,25 @@ DbAccessParser::build(bundy::data::ConstElementPtr config_value) {
 
     // 3. Update the copy with the passed keywords.
     BOOST_FOREACH(ConfigPair param, config_value->mapValue()) {
-        // The persist parameter is the only boolean parameter at the
-        // moment. It needs special handling.
-        if (param.first != "persist") {
-            values_copy[param.first] = param.second->stringValue();
-
-        } else {
+        // The persist and async-commit parameters are the only boolean
+        // parameters and the lfc-interval, sync-interval and connections
+        // the only integer ones at the moment. They need special handling.
+        if ((param.first == "persist") || (param.first == "async-commit")) {
             values_copy[param.first] = (param.second->boolValue() ?
                                         "true" : "false");
+
+        } else if ((param.first == "lfc-interval") ||
+                   (param.first == "sync-interval") ||
+                   (param.first == "connections")) {
+            const int64_t interval = param.second->intValue();
+            if (interval < 0 || interval > 0xffffffffLL) {
+                bundy_throw(BadValue, "invalid value of the " << param.first
+                          << ": " << interval);
+            }
+            values_copy[param.first] = boost::lexical_cast<string>(interval);
+
+        } else {
+            values_copy[param.first] = param.second->stringValue();
         }
     }
 
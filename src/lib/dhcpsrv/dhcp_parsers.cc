@@ -1281,6 +1281,10 @@ D2ClientConfigParser::build(bundy::data::ConstElementPtr client_config) {
     uint32_t server_port = uint32_values_->getOptionalParam("server-port",
                                                              D2ClientConfig::
                                                              DFT_SERVER_PORT);
+    std::string server_socket = string_values_->
+                                getOptionalParam("server-socket",
+                                                 D2ClientConfig::
+                                                 DFT_SERVER_SOCKET);
     dhcp_ddns::NameChangeProtocol ncr_protocol
         = dhcp_ddns::stringToNcrProtocol(string_values_->
                                          getOptionalParam("ncr-protocol",
@@ -1328,7 +1332,8 @@ D2ClientConfigParser::build(bundy::data::ConstElementPtr client_config) {
                                                   override_client_update,
                                                   replace_client_name,
                                                   generated_prefix,
-                                                  qualifying_suffix));
+                                                  qualifying_suffix,
+                                                  server_socket));
 }
 
 bundy::dhcp::ParserPtr
@@ -1337,6 +1342,7 @@ D2ClientConfigParser::createConfigParser(const std::string& config_id) {
     if (config_id.compare("server-port") == 0) {
         parser = new Uint32Parser(config_id, uint32_values_);
     } else if ((config_id.compare("server-ip") == 0) ||
+        (config_id.compare("server-socket") == 0) ||
         (config_id.compare("ncr-protocol") == 0) ||
         (config_id.compare("ncr-format") == 0) ||
         (config_id.compare("generated-prefix") == 0) ||
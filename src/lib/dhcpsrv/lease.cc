@@ -50,10 +50,13 @@ Lease::typeToText(Lease::Type type) {
 }
 
 bool Lease::expired() const {
+    return (getExpirationTime() < time(NULL));
+}
 
+int64_t
+Lease::getExpirationTime() const {
     // Let's use int64 to avoid problems with negative/large uint32 values
-    int64_t expire_time = cltt_ + valid_lft_;
-    return (expire_time < time(NULL));
+    return (static_cast<int64_t>(cltt_) + valid_lft_);
 }
 
 bool
@@ -141,6 +141,11 @@ struct Lease {
     /// @return true if the lease is expired
     bool expired() const;
 
+    /// @brief Returns the time when the lease expires.
+    ///
+    /// @return The client last transmission time plus the valid lifetime.
+    int64_t getExpirationTime() const;
+
     /// @brief Returns true if the other lease has equal FQDN data.
     ///
     /// @param other Lease which FQDN data is to be compared with our lease.
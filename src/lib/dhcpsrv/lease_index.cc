@@ -0,0 +1,236 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcpsrv/lease_index.h>
+
+#include <vector>
+
+using namespace bundy::asiolink;
+using bundy::util::thread::Mutex;
+
+namespace bundy {
+namespace dhcp {
+
+namespace {
+
+typedef LeaseIndex::Key Key;
+
+Key
+toKey(const IOAddress& addr) {
+    const std::vector<uint8_t>& bytes = addr.toBytes();
+    const size_t split = bytes.size() > 8 ? bytes.size() - 8 : 0;
+    Key key(0, 0);
+    for (size_t i = 0; i < split; ++i) {
+        key.first = (key.first << 8) | bytes[i];
+    }
+    for (size_t i = split; i < bytes.size(); ++i) {
+        key.second = (key.second << 8) | bytes[i];
+    }
+    return (key);
+}
+
+IOAddress
+toAddress(const Key& key, const IOAddress& family) {
+    if (family.isV4()) {
+        return (IOAddress(static_cast<uint32_t>(key.second)));
+    }
+    uint8_t packed[16];
+    for (int i = 0; i < 8; ++i) {
+        packed[7 - i] = static_cast<uint8_t>(key.first >> (8 * i));
+        packed[15 - i] = static_cast<uint8_t>(key.second >> (8 * i));
+    }
+    return (IOAddress::fromBytes(AF_INET6, packed));
+}
+
+Key
+next(const Key& key) {
+    return (Key(key.first + (key.second == ~0ULL ? 1 : 0), key.second + 1));
+}
+
+Key
+prev(const Key& key) {
+    return (Key(key.first - (key.second == 0 ? 1 : 0), key.second - 1));
+}
+
+// The last address of the prefix starting with the key.
+Key
+lastInPrefix(const Key& key, unsigned int bits) {
+    if (bits >= 128) {
+        return (Key(~0ULL, ~0ULL));
+    } else if (bits >= 64) {
+        const uint64_t mask = bits == 64 ? 0 : (~0ULL >> (128 - bits));
+        return (Key(key.first | mask, ~0ULL));
+    }
+    const uint64_t mask = bits == 0 ? 0 : (~0ULL >> (64 - bits));
+    return (Key(key.first, key.second | mask));
+}
+
+}
+
+LeaseIndex::LeaseIndex() {
+}
+
+void
+LeaseIndex::add(const IOAddress& addr, uint8_t prefix_len, time_t expire) {
+    Mutex::Locker lock(mutex_);
+
+    const Key start = toKey(addr);
+    const unsigned int addr_len = addr.isV4() ? 32 : 128;
+    const Key end = lastInPrefix(start, prefix_len < addr_len ?
+                                 addr_len - prefix_len : 0);
+
+    std::map<Key, std::pair<Key, time_t> >::iterator lease =
+        leases_.find(start);
+    if (lease != leases_.end()) {
+        // Just an update of the expiration time.
+        expiration_.erase(std::make_pair(lease->second.second, start));
+        lease->second.second = expire;
+        expiration_.insert(std::make_pair(expire, start));
+        return;
+    }
+    leases_.insert(std::make_pair(start, std::make_pair(end, expire)));
+    expiration_.insert(std::make_pair(expire, start));
+    cover(start, end);
+}
+
+void
+LeaseIndex::remove(const IOAddress& addr) {
+    Mutex::Locker lock(mutex_);
+
+    std::map<Key, std::pair<Key, time_t> >::iterator lease =
+        leases_.find(toKey(addr));
+    if (lease == leases_.end()) {
+        return;
+    }
+    expiration_.erase(std::make_pair(lease->second.second, lease->first));
+    uncover(lease->first, lease->second.first);
+    leases_.erase(lease);
+}
+
+void
+LeaseIndex::clear() {
+    Mutex::Locker lock(mutex_);
+
+    leases_.clear();
+    intervals_.clear();
+    expiration_.clear();
+}
+
+bool
+LeaseIndex::findFree(const IOAddress& first, const IOAddress& last,
+                     IOAddress& addr) const {
+    Mutex::Locker lock(mutex_);
+
+    const Key start = toKey(first);
+    const Key end = toKey(last);
+
+    // Find the interval which could cover the start.
+    std::map<Key, Key>::const_iterator it = intervals_.upper_bound(start);
+    if (it == intervals_.begin()) {
+        addr = first;
+        return (true);
+    }
+    --it;
+    if (it->second < start) {
+        addr = first;
+        return (true);
+    }
+    // The intervals are merged, so the address after this one is free
+    // (unless it is past the range, or past the end of the address space).
+    if (it->second < end) {
+        addr = toAddress(next(it->second), first);
+        return (true);
+    }
+    return (false);
+}
+
+bool
+LeaseIndex::findExpired(const IOAddress& first, const IOAddress& last,
+                        time_t now, IOAddress& addr) const {
+    Mutex::Locker lock(mutex_);
+
+    const Key start = toKey(first);
+    const Key end = toKey(last);
+
+    for (std::set<std::pair<time_t, Key> >::const_iterator it =
+             expiration_.begin();
+         it != expiration_.end() && it->first < now; ++it) {
+        if (!(it->second < start) && !(end < it->second)) {
+            addr = toAddress(it->second, first);
+            return (true);
+        }
+    }
+    return (false);
+}
+
+size_t
+LeaseIndex::getLeaseCount() const {
+    Mutex::Locker lock(mutex_);
+    return (leases_.size());
+}
+
+void
+LeaseIndex::cover(const Key& start, const Key& end) {
+    const Key min(0, 0);
+    const Key max(~0ULL, ~0ULL);
+    Key new_start = start;
+    Key new_end = end;
+
+    // Merge with the interval before, if it touches (or overlaps) this one.
+    std::map<Key, Key>::iterator it = intervals_.upper_bound(start);
+    if (it != intervals_.begin()) {
+        std::map<Key, Key>::iterator before = it;
+        --before;
+        if (start == min || !(before->second < prev(start))) {
+            new_start = before->first;
+            if (new_end < before->second) {
+                new_end = before->second;
+            }
+            intervals_.erase(before);
+        }
+    }
+    // And with the ones after it.
+    while (it != intervals_.end() &&
+           (end == max || !(next(end) < it->first))) {
+        if (new_end < it->second) {
+            new_end = it->second;
+        }
+        intervals_.erase(it++);
+    }
+    intervals_[new_start] = new_end;
+}
+
+void
+LeaseIndex::uncover(const Key& start, const Key& end) {
+    std::map<Key, Key>::iterator it = intervals_.upper_bound(start);
+    if (it == intervals_.begin()) {
+        return;
+    }
+    --it;
+    if (it->second < start) {
+        return;
+    }
+    const Key interval_start = it->first;
+    const Key interval_end = it->second;
+    intervals_.erase(it);
+    if (interval_start < start) {
+        intervals_[interval_start] = prev(start);
+    }
+    if (end < interval_end) {
+        intervals_[next(end)] = interval_end;
+    }
+}
+
+} // namespace bundy::dhcp
+} // namespace bundy
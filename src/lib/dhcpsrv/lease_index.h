@@ -0,0 +1,128 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef LEASE_INDEX_H
+#define LEASE_INDEX_H
+
+#include <asiolink/io_address.h>
+#include <util/threads/sync.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <map>
+#include <set>
+#include <utility>
+
+#include <stdint.h>
+#include <time.h>
+
+namespace bundy {
+namespace dhcp {
+
+/// @brief Index of the leased addresses, used to find the free ones.
+///
+/// The lease managers which have all the leases at hand keep one index for
+/// each lease type up to date as the leases are added, updated and
+/// deleted.  The allocation engine then finds a free address in a pool
+/// without probing the addresses one by one.
+///
+/// The leased addresses (and prefixes) are kept as a set of disjoint
+/// intervals, so the first free address in a range is found with a single
+/// lookup: it is either the start of the range, or the address right after
+/// the interval covering the start.  The expiration times of the leases are
+/// kept in order as well, so an expired lease to reuse is found without
+/// walking the leases still valid.
+///
+/// The leases are expected not to overlap (the prefixes delegated from one
+/// pool are all of the same length).  The index is safe to use by several
+/// threads.
+class LeaseIndex : public boost::noncopyable {
+public:
+    /// @brief Constructor, creates an empty index.
+    LeaseIndex();
+
+    /// @brief Adds a lease, or updates its expiration time.
+    ///
+    /// @param addr The leased address, or the first address of the prefix.
+    /// @param prefix_len Length of the prefix, 32 or 128 for an address.
+    /// @param expire Time when the lease expires.
+    void add(const bundy::asiolink::IOAddress& addr, uint8_t prefix_len,
+             time_t expire);
+
+    /// @brief Removes a lease.
+    ///
+    /// Nothing happens if there is no such lease.
+    ///
+    /// @param addr The leased address (or prefix).
+    void remove(const bundy::asiolink::IOAddress& addr);
+
+    /// @brief Removes all the leases.
+    void clear();
+
+    /// @brief Finds the first address which is not leased in a range.
+    ///
+    /// @param first The first address of the range.
+    /// @param last The last address of the range.
+    /// @param [out] addr The free address.
+    /// @return true if there is a free address in the range.
+    bool findFree(const bundy::asiolink::IOAddress& first,
+                  const bundy::asiolink::IOAddress& last,
+                  bundy::asiolink::IOAddress& addr) const;
+
+    /// @brief Finds the lease in a range which expired first.
+    ///
+    /// The leases expired in other ranges are walked over, so the time it
+    /// takes depends on the number of the expired leases which haven't been
+    /// reused or removed yet.
+    ///
+    /// @param first The first address of the range.
+    /// @param last The last address of the range.
+    /// @param now The current time, the leases expiring before are found.
+    /// @param [out] addr The address (or prefix) of the expired lease.
+    /// @return true if there is an expired lease in the range.
+    bool findExpired(const bundy::asiolink::IOAddress& first,
+                     const bundy::asiolink::IOAddress& last, time_t now,
+                     bundy::asiolink::IOAddress& addr) const;
+
+    /// @brief Returns the number of the leases in the index.
+    size_t getLeaseCount() const;
+
+    /// @brief An address as a 128-bit number (the high and the low half).
+    typedef std::pair<uint64_t, uint64_t> Key;
+
+private:
+    /// @brief Marks the interval as leased, merging it with the neighbours.
+    void cover(const Key& start, const Key& end);
+
+    /// @brief Marks the interval as free, splitting the covering interval.
+    void uncover(const Key& start, const Key& end);
+
+    /// @brief The leases, the first address mapped to the last address of
+    /// the lease and the expiration time.
+    std::map<Key, std::pair<Key, time_t> > leases_;
+
+    /// @brief The leased intervals, the first address mapped to the last.
+    std::map<Key, Key> intervals_;
+
+    /// @brief The leases ordered by the expiration time.
+    std::set<std::pair<time_t, Key> > expiration_;
+
+    /// @brief Protects the index.
+    mutable bundy::util::thread::Mutex mutex_;
+};
+
+} // namespace bundy::dhcp
+} // namespace bundy
+
+#endif // LEASE_INDEX_H
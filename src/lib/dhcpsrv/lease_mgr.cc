@@ -40,6 +40,15 @@ std::string LeaseMgr::getParameter(const std::string& name) const {
     return (param->second);
 }
 
+const LeaseIndex*
+LeaseMgr::getLeaseIndex(Lease::Type) const {
+    return (NULL);
+}
+
+void
+LeaseMgr::sync() {
+}
+
 Lease6Ptr
 LeaseMgr::getLease6(Lease::Type type, const DUID& duid,
                     uint32_t iaid, SubnetID subnet_id) const {
@@ -20,6 +20,7 @@
 #include <dhcp/option.h>
 #include <dhcp/hwaddr.h>
 #include <dhcpsrv/lease.h>
+#include <dhcpsrv/lease_index.h>
 #include <dhcpsrv/subnet.h>
 #include <exceptions/exceptions.h>
 
@@ -298,6 +299,29 @@ public:
     Lease6Ptr getLease6(Lease::Type type, const DUID& duid,
                         uint32_t iaid, SubnetID subnet_id) const;
 
+    /// @brief Returns the expired IPv4 leases.
+    ///
+    /// The leases are returned in the order of their expiration time, the
+    /// lease which expired first comes first.  The backends keep the leases
+    /// indexed by the expiration time, so the leases still valid are not
+    /// walked over.  The fixed leases are returned as well, it is up to the
+    /// caller to keep them.
+    ///
+    /// @param [out] expired Collection the expired leases are appended to.
+    /// @param max_leases Maximum number of the leases returned, 0 for all.
+    virtual void getExpiredLeases4(Lease4Collection& expired,
+                                   size_t max_leases) const = 0;
+
+    /// @brief Returns the expired IPv6 leases.
+    ///
+    /// The leases of all types are returned in the order of their
+    /// expiration time (see @c getExpiredLeases4).
+    ///
+    /// @param [out] expired Collection the expired leases are appended to.
+    /// @param max_leases Maximum number of the leases returned, 0 for all.
+    virtual void getExpiredLeases6(Lease6Collection& expired,
+                                   size_t max_leases) const = 0;
+
     /// @brief Updates IPv4 lease.
     ///
     /// @param lease4 The lease to be updated.
@@ -368,6 +392,16 @@ public:
     /// support transactions, this is a no-op.
     virtual void rollback() = 0;
 
+    /// @brief Waits until the changes made so far are durable.
+    ///
+    /// The servers call this before sending a response, so the leases
+    /// given to the client are not lost if the server crashes.  The
+    /// backends which store each change durably before returning don't
+    /// need to do anything, which is the default.
+    ///
+    /// @throw DbOperationError if the changes couldn't be stored.
+    virtual void sync();
+
     /// @todo: Add host management here
     /// As host reservation is outside of scope for 2012, support for hosts
     /// is currently postponed.
@@ -375,6 +409,17 @@ public:
     /// @brief returns value of the parameter
     virtual std::string getParameter(const std::string& name) const;
 
+    /// @brief Returns the index of the leased addresses.
+    ///
+    /// The backends which have all the leases at hand keep an index of
+    /// the leased addresses for each lease type, so the allocation engine
+    /// can find the free ones quickly (see @c LeaseIndex).  The other
+    /// backends return NULL.
+    ///
+    /// @param type Type of the leases.
+    /// @return The index, or NULL if the backend doesn't keep one.
+    virtual const LeaseIndex* getLeaseIndex(Lease::Type type) const;
+
 private:
     /// @brief list of parameters passed in dbconfig
     ///
@@ -17,12 +17,146 @@
 #include <dhcpsrv/memfile_lease_mgr.h>
 #include <exceptions/exceptions.h>
 
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <map>
+
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace bundy::dhcp;
+using bundy::asiolink::IOAddress;
+using bundy::util::thread::Mutex;
+using bundy::util::thread::Thread;
+
+namespace {
+
+/// @brief Checks if the file exists.
+bool
+fileExists(const std::string& file_name) {
+    struct stat st;
+    return (stat(file_name.c_str(), &st) == 0);
+}
+
+/// @brief Renames the lease file to the input of the cleanup and opens
+/// a new lease file.
+///
+/// Nothing is done if the input of an interrupted cleanup exists.  The
+/// records buffered for the group commit are flushed to the disk before
+/// the file is closed.
+template<typename LeaseFileType>
+void
+rotateLeaseFile(boost::shared_ptr<LeaseFileType>& lease_file) {
+    const std::string file_name = lease_file->getFilename();
+    const std::string input =
+        Memfile_LeaseMgr::appendSuffix(file_name, Memfile_LeaseMgr::FILE_INPUT);
+    if (fileExists(input)) {
+        return;
+    }
+
+    const bool buffered = lease_file->isBuffered();
+    if (buffered) {
+        lease_file->sync();
+    }
+    lease_file->close();
+    if (rename(file_name.c_str(), input.c_str()) != 0) {
+        const int error = errno;
+        lease_file->open();
+        bundy_throw(DbOperationError, "unable to rename the lease file "
+                  << file_name << " to " << input << ": "
+                  << strerror(error));
+    }
+    lease_file.reset(new LeaseFileType(file_name));
+    lease_file->open();
+    lease_file->setBuffered(buffered);
+}
+
+/// @brief Reads the leases from a lease file to a map (if it exists).
+template<typename LeaseFileType, typename LeasePtrType>
+void
+readLeaseFile(const std::string& file_name,
+              std::map<IOAddress, LeasePtrType>& leases) {
+    if (!fileExists(file_name)) {
+        return;
+    }
+
+    LeaseFileType lease_file(file_name);
+    lease_file.open();
+    LeasePtrType lease;
+    do {
+        if (!lease_file.next(lease)) {
+            bundy_throw(DbOperationError, "Failed to parse the lease in"
+                      " the lease file " << file_name << ": "
+                      << lease_file.getReadMsg());
+        }
+        if (lease) {
+            if (lease->valid_lft_ == 0) {
+                leases.erase(lease->addr_);
+            } else {
+                leases[lease->addr_] = lease;
+            }
+        }
+    } while (lease);
+    lease_file.close();
+}
+
+/// @brief Writes the leases from the input and previous files to the
+/// previous file, then removes the input.
+///
+/// @return Number of the leases written.
+template<typename LeaseFileType, typename LeasePtrType>
+size_t
+compactLeaseFile(const std::string& file_name) {
+    const std::string input =
+        Memfile_LeaseMgr::appendSuffix(file_name, Memfile_LeaseMgr::FILE_INPUT);
+    const std::string previous =
+        Memfile_LeaseMgr::appendSuffix(file_name,
+                                       Memfile_LeaseMgr::FILE_PREVIOUS);
+    const std::string output =
+        Memfile_LeaseMgr::appendSuffix(file_name,
+                                       Memfile_LeaseMgr::FILE_OUTPUT);
+    if (!fileExists(input)) {
+        return (0);
+    }
+
+    std::map<IOAddress, LeasePtrType> leases;
+    readLeaseFile<LeaseFileType>(previous, leases);
+    readLeaseFile<LeaseFileType>(input, leases);
+
+    LeaseFileType output_file(output);
+    output_file.recreate();
+    for (typename std::map<IOAddress, LeasePtrType>::const_iterator lease =
+             leases.begin(); lease != leases.end(); ++lease) {
+        output_file.append(*lease->second);
+    }
+    output_file.close();
+
+    // The input is still there when the rename succeeds, so the leases
+    // are recovered whatever step fails.
+    if (rename(output.c_str(), previous.c_str()) != 0) {
+        bundy_throw(DbOperationError, "unable to rename " << output << " to "
+                  << previous << ": " << strerror(errno));
+    }
+    if (unlink(input.c_str()) != 0) {
+        bundy_throw(DbOperationError, "unable to remove " << input << ": "
+                  << strerror(errno));
+    }
+    return (leases.size());
+}
+
+}
 
 Memfile_LeaseMgr::Memfile_LeaseMgr(const ParameterMap& parameters)
-    : LeaseMgr(parameters) {
+    : LeaseMgr(parameters), lfc_interval_(0), lfc_stop_(false),
+      sync_interval_(0), appended_(0), synced_(0), failed_(0),
+      sync_writers_(0), sync_stop_(false) {
     // Check the universe and use v4 file or v6 file.
     std::string universe = getParameter("universe");
     if (universe == "4") {
@@ -48,9 +182,73 @@ Memfile_LeaseMgr::Memfile_LeaseMgr(const ParameterMap& parameters)
     if (!persistLeases(V4) && !persistLeases(V6)) {
         LOG_WARN(dhcpsrv_logger, DHCPSRV_MEMFILE_NO_STORAGE);
     }
+
+    std::string lfc_interval;
+    try {
+        lfc_interval = getParameter("lfc-interval");
+    } catch (const Exception&) {
+        // The periodic cleanup is disabled by default.
+    }
+    if (!lfc_interval.empty()) {
+        try {
+            lfc_interval_ = boost::lexical_cast<uint32_t>(lfc_interval);
+        } catch (const boost::bad_lexical_cast&) {
+            bundy_throw(bundy::BadValue, "invalid value 'lfc-interval="
+                      << lfc_interval << "'");
+        }
+    }
+    if (lfc_interval_ > 0 && (persistLeases(V4) || persistLeases(V6))) {
+        LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_SETUP).arg(lfc_interval_);
+        lfc_thread_.reset(new Thread(boost::bind(&Memfile_LeaseMgr::lfcRun,
+                                                 this)));
+    }
+
+    std::string sync_interval;
+    try {
+        sync_interval = getParameter("sync-interval");
+    } catch (const Exception&) {
+        // The group commit is disabled by default.
+    }
+    if (!sync_interval.empty()) {
+        try {
+            sync_interval_ = boost::lexical_cast<uint32_t>(sync_interval);
+        } catch (const boost::bad_lexical_cast&) {
+            bundy_throw(bundy::BadValue, "invalid value 'sync-interval="
+                      << sync_interval << "'");
+        }
+    }
+    if (sync_interval_ > 0 && (persistLeases(V4) || persistLeases(V6))) {
+        LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_SYNC_SETUP)
+            .arg(sync_interval_);
+        if (lease_file4_) {
+            lease_file4_->setBuffered(true);
+        } else {
+            lease_file6_->setBuffered(true);
+        }
+        sync_thread_.reset(new Thread(boost::bind(&Memfile_LeaseMgr::syncRun,
+                                                  this)));
+    }
 }
 
 Memfile_LeaseMgr::~Memfile_LeaseMgr() {
+    if (lfc_thread_) {
+        {
+            Mutex::Locker lock(lfc_mutex_);
+            lfc_stop_ = true;
+            lfc_cond_.signal();
+        }
+        lfc_thread_->wait();
+        lfc_thread_.reset();
+    }
+    if (sync_thread_) {
+        {
+            Mutex::Locker lock(sync_mutex_);
+            sync_stop_ = true;
+            sync_cond_.signal();
+        }
+        sync_thread_->wait();
+        sync_thread_.reset();
+    }
     if (lease_file4_) {
         lease_file4_->close();
         lease_file4_.reset();
@@ -66,19 +264,33 @@ Memfile_LeaseMgr::addLease(const Lease4Ptr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_ADD_ADDR4).arg(lease->addr_.toText());
 
-    if (getLease4(lease->addr_)) {
+    Mutex::Locker lock(mutex_);
+    if (storage4_.find(lease->addr_) != storage4_.end()) {
         // there is a lease with specified address already
         return (false);
     }
 
-    // Try to write a lease to disk first. If this fails, the lease will
-    // not be inserted to the memory and the disk and in-memory data will
-    // remain consistent.
-    if (persistLeases(V4)) {
-        lease_file4_->append(*lease);
+    // Insert the lease in memory first.  The insertion fails if another
+    // lease has the same hardware address and subnet, and then nothing is
+    // written to disk.
+    const std::pair<Lease4Storage::iterator, bool> inserted =
+        storage4_.insert(lease);
+    if (!inserted.second) {
+        return (false);
     }
 
-    storage4_.insert(lease);
+    // If writing the lease to disk fails, the lease is removed from the
+    // memory, so the disk and in-memory data remain consistent.
+    if (persistLeases(V4)) {
+        try {
+            lease_file4_->append(*lease);
+        } catch (...) {
+            storage4_.erase(inserted.first);
+            throw;
+        }
+        ++appended_;
+    }
+    indexLease(*lease);
     return (true);
 }
 
@@ -87,19 +299,33 @@ Memfile_LeaseMgr::addLease(const Lease6Ptr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_ADD_ADDR6).arg(lease->addr_.toText());
 
-    if (getLease6(lease->type_, lease->addr_)) {
+    Mutex::Locker lock(mutex_);
+    if (storage6_.find(lease->addr_) != storage6_.end()) {
         // there is a lease with specified address already
         return (false);
     }
 
-    // Try to write a lease to disk first. If this fails, the lease will
-    // not be inserted to the memory and the disk and in-memory data will
-    // remain consistent.
-    if (persistLeases(V6)) {
-        lease_file6_->append(*lease);
+    // Insert the lease in memory first.  The insertion fails if another
+    // lease has the same DUID, IAID and subnet, and then nothing is
+    // written to disk.
+    const std::pair<Lease6Storage::iterator, bool> inserted =
+        storage6_.insert(lease);
+    if (!inserted.second) {
+        return (false);
     }
 
-    storage6_.insert(lease);
+    // If writing the lease to disk fails, the lease is removed from the
+    // memory, so the disk and in-memory data remain consistent.
+    if (persistLeases(V6)) {
+        try {
+            lease_file6_->append(*lease);
+        } catch (...) {
+            storage6_.erase(inserted.first);
+            throw;
+        }
+        ++appended_;
+    }
+    indexLease(*lease);
     return (true);
 }
 
@@ -107,6 +333,7 @@ Lease4Ptr
 Memfile_LeaseMgr::getLease4(const bundy::asiolink::IOAddress& addr) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_ADDR4).arg(addr.toText());
+    Mutex::Locker lock(mutex_);
 
     typedef Lease4Storage::nth_index<0>::type SearchIndex;
     const SearchIndex& idx = storage4_.get<0>();
@@ -122,16 +349,17 @@ Lease4Collection
 Memfile_LeaseMgr::getLease4(const HWAddr& hwaddr) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_HWADDR).arg(hwaddr.toText());
-    typedef Lease4Storage::nth_index<0>::type SearchIndex;
-    Lease4Collection collection;
-    const SearchIndex& idx = storage4_.get<0>();
-    for(SearchIndex::const_iterator lease = idx.begin();
-        lease != idx.end(); ++lease) {
+    Mutex::Locker lock(mutex_);
 
-        // Every Lease4 has a hardware address, so we can compare it
-        if ((*lease)->hwaddr_ == hwaddr.hwaddr_) {
-            collection.push_back((*lease));
-        }
+    // We are going to use index #4 of the multi index container.
+    typedef Lease4Storage::nth_index<4>::type SearchIndex;
+    Lease4Collection collection;
+    const SearchIndex& idx = storage4_.get<4>();
+    std::pair<SearchIndex::const_iterator, SearchIndex::const_iterator> l =
+        idx.equal_range(hwaddr.hwaddr_);
+    for (SearchIndex::const_iterator lease = l.first; lease != l.second;
+         ++lease) {
+        collection.push_back(Lease4Ptr(new Lease4(**lease)));
     }
 
     return (collection);
@@ -142,6 +370,7 @@ Memfile_LeaseMgr::getLease4(const HWAddr& hwaddr, SubnetID subnet_id) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_SUBID_HWADDR).arg(subnet_id)
         .arg(hwaddr.toText());
+    Mutex::Locker lock(mutex_);
 
     // We are going to use index #1 of the multi index container.
     // We define SearchIndex locally in this function because
@@ -165,17 +394,19 @@ Lease4Collection
 Memfile_LeaseMgr::getLease4(const ClientId& client_id) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_CLIENTID).arg(client_id.toText());
-    typedef Memfile_LeaseMgr::Lease4Storage::nth_index<0>::type SearchIndex;
-    Lease4Collection collection;
-    const SearchIndex& idx = storage4_.get<0>();
-    for(SearchIndex::const_iterator lease = idx.begin();
-        lease != idx.end(); ++ lease) {
+    Mutex::Locker lock(mutex_);
 
-        // client-id is not mandatory in DHCPv4. There can be a lease that does
-        // not have a client-id. Dereferencing null pointer would be a bad thing
-        if((*lease)->client_id_ && *(*lease)->client_id_ == client_id) {
-            collection.push_back((*lease));
-        }
+    // We are going to use index #5 of the multi index container.  The
+    // leases without client-id are indexed with the empty vector, which
+    // no valid client-id matches.
+    typedef Lease4Storage::nth_index<5>::type SearchIndex;
+    Lease4Collection collection;
+    const SearchIndex& idx = storage4_.get<5>();
+    std::pair<SearchIndex::const_iterator, SearchIndex::const_iterator> l =
+        idx.equal_range(client_id.getClientId());
+    for (SearchIndex::const_iterator lease = l.first; lease != l.second;
+         ++lease) {
+        collection.push_back(Lease4Ptr(new Lease4(**lease)));
     }
 
     return (collection);
@@ -189,6 +420,7 @@ Memfile_LeaseMgr::getLease4(const ClientId& client_id,
               DHCPSRV_MEMFILE_GET_CLIENTID_HWADDR_SUBID).arg(client_id.toText())
                                                         .arg(hwaddr.toText())
                                                         .arg(subnet_id);
+    Mutex::Locker lock(mutex_);
 
     // We are going to use index #3 of the multi index container.
     // We define SearchIndex locally in this function because
@@ -207,7 +439,7 @@ Memfile_LeaseMgr::getLease4(const ClientId& client_id,
     }
 
     // Lease was found. Return it to the caller.
-    return (*lease);
+    return (Lease4Ptr(new Lease4(**lease)));
 }
 
 Lease4Ptr
@@ -216,6 +448,7 @@ Memfile_LeaseMgr::getLease4(const ClientId& client_id,
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_SUBID_CLIENTID).arg(subnet_id)
               .arg(client_id.toText());
+    Mutex::Locker lock(mutex_);
 
     // We are going to use index #2 of the multi index container.
     // We define SearchIndex locally in this function because
@@ -239,6 +472,7 @@ Memfile_LeaseMgr::getLease6(Lease::Type /* not used yet */,
                             const bundy::asiolink::IOAddress& addr) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_ADDR6).arg(addr.toText());
+    Mutex::Locker lock(mutex_);
 
     Lease6Storage::iterator l = storage6_.find(addr);
     if (l == storage6_.end()) {
@@ -249,14 +483,26 @@ Memfile_LeaseMgr::getLease6(Lease::Type /* not used yet */,
 }
 
 Lease6Collection
-Memfile_LeaseMgr::getLeases6(Lease::Type /* not used yet */,
-                            const DUID& duid, uint32_t iaid) const {
+Memfile_LeaseMgr::getLeases6(Lease::Type type,
+                             const DUID& duid, uint32_t iaid) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_IAID_DUID).arg(iaid).arg(duid.toText());
+    Mutex::Locker lock(mutex_);
 
-    /// @todo Not implemented.
+    // We are going to use index #2 of the multi index container.
+    typedef Lease6Storage::nth_index<2>::type SearchIndex;
+    const SearchIndex& idx = storage6_.get<2>();
+    std::pair<SearchIndex::const_iterator, SearchIndex::const_iterator> l =
+        idx.equal_range(boost::make_tuple(duid.getDuid(), iaid));
+    Lease6Collection collection;
+    for (SearchIndex::const_iterator lease = l.first; lease != l.second;
+         ++lease) {
+        if ((*lease)->type_ == type) {
+            collection.push_back(Lease6Ptr(new Lease6(**lease)));
+        }
+    }
 
-    return (Lease6Collection());
+    return (collection);
 }
 
 Lease6Collection
@@ -266,6 +512,7 @@ Memfile_LeaseMgr::getLeases6(Lease::Type /* not used yet */,
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_GET_IAID_SUBID_DUID)
               .arg(iaid).arg(subnet_id).arg(duid.toText());
+    Mutex::Locker lock(mutex_);
 
     // We are going to use index #1 of the multi index container.
     // We define SearchIndex locally in this function because
@@ -288,10 +535,51 @@ Memfile_LeaseMgr::getLeases6(Lease::Type /* not used yet */,
     return (collection);
 }
 
+void
+Memfile_LeaseMgr::getExpiredLeases4(Lease4Collection& expired,
+                                    size_t max_leases) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MEMFILE_GET_EXPIRED4).arg(max_leases);
+    const int64_t now = time(NULL);
+    Mutex::Locker lock(mutex_);
+
+    // We are going to use index #6, ordered by the expiration time.
+    typedef Lease4Storage::nth_index<6>::type SearchIndex;
+    const SearchIndex& idx = storage4_.get<6>();
+    const SearchIndex::const_iterator end = idx.lower_bound(now);
+    size_t count = 0;
+    for (SearchIndex::const_iterator lease = idx.begin();
+         lease != end && (max_leases == 0 || count < max_leases);
+         ++lease, ++count) {
+        expired.push_back(Lease4Ptr(new Lease4(**lease)));
+    }
+}
+
+void
+Memfile_LeaseMgr::getExpiredLeases6(Lease6Collection& expired,
+                                    size_t max_leases) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MEMFILE_GET_EXPIRED6).arg(max_leases);
+    const int64_t now = time(NULL);
+    Mutex::Locker lock(mutex_);
+
+    // We are going to use index #3, ordered by the expiration time.
+    typedef Lease6Storage::nth_index<3>::type SearchIndex;
+    const SearchIndex& idx = storage6_.get<3>();
+    const SearchIndex::const_iterator end = idx.lower_bound(now);
+    size_t count = 0;
+    for (SearchIndex::const_iterator lease = idx.begin();
+         lease != end && (max_leases == 0 || count < max_leases);
+         ++lease, ++count) {
+        expired.push_back(Lease6Ptr(new Lease6(**lease)));
+    }
+}
+
 void
 Memfile_LeaseMgr::updateLease4(const Lease4Ptr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_UPDATE_ADDR4).arg(lease->addr_.toText());
+    Mutex::Locker lock(mutex_);
 
     Lease4Storage::iterator lease_it = storage4_.find(lease->addr_);
     if (lease_it == storage4_.end()) {
@@ -299,20 +587,37 @@ Memfile_LeaseMgr::updateLease4(const Lease4Ptr& lease) {
                   << lease->addr_ << " - no such lease");
     }
 
-    // Try to write a lease to disk first. If this fails, the lease will
-    // not be inserted to the memory and the disk and in-memory data will
-    // remain consistent.
-    if (persistLeases(V4)) {
-        lease_file4_->append(*lease);
+    // Update the lease in memory first.  The replacement fails if another
+    // lease has the same hardware address and subnet, and then nothing is
+    // written to disk.  The lease is replaced with a copy rather than
+    // modified in place, so the container moves it to the right place in
+    // its indexes.
+    const Lease4Ptr old_lease = *lease_it;
+    if (!storage4_.replace(lease_it, Lease4Ptr(new Lease4(*lease)))) {
+        bundy_throw(DbOperationError, "failed to update the lease with"
+                  " address " << lease->addr_ << " - another lease has"
+                  " the same hardware address and subnet");
     }
 
-    **lease_it = *lease;
+    // If writing the lease to disk fails, the old lease is put back, so
+    // the disk and in-memory data remain consistent.
+    if (persistLeases(V4)) {
+        try {
+            lease_file4_->append(*lease);
+        } catch (...) {
+            storage4_.replace(lease_it, old_lease);
+            throw;
+        }
+        ++appended_;
+    }
+    indexLease(*lease);
 }
 
 void
 Memfile_LeaseMgr::updateLease6(const Lease6Ptr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_UPDATE_ADDR6).arg(lease->addr_.toText());
+    Mutex::Locker lock(mutex_);
 
     Lease6Storage::iterator lease_it = storage6_.find(lease->addr_);
     if (lease_it == storage6_.end()) {
@@ -320,20 +625,37 @@ Memfile_LeaseMgr::updateLease6(const Lease6Ptr& lease) {
                   << lease->addr_ << " - no such lease");
     }
 
-    // Try to write a lease to disk first. If this fails, the lease will
-    // not be inserted to the memory and the disk and in-memory data will
-    // remain consistent.
-    if (persistLeases(V6)) {
-        lease_file6_->append(*lease);
+    // Update the lease in memory first.  The replacement fails if another
+    // lease has the same DUID, IAID and subnet, and then nothing is
+    // written to disk.  The lease is replaced with a copy rather than
+    // modified in place, so the container moves it to the right place in
+    // its indexes.
+    const Lease6Ptr old_lease = *lease_it;
+    if (!storage6_.replace(lease_it, Lease6Ptr(new Lease6(*lease)))) {
+        bundy_throw(DbOperationError, "failed to update the lease with"
+                  " address " << lease->addr_ << " - another lease has"
+                  " the same DUID, IAID and subnet");
     }
 
-    **lease_it = *lease;
+    // If writing the lease to disk fails, the old lease is put back, so
+    // the disk and in-memory data remain consistent.
+    if (persistLeases(V6)) {
+        try {
+            lease_file6_->append(*lease);
+        } catch (...) {
+            storage6_.replace(lease_it, old_lease);
+            throw;
+        }
+        ++appended_;
+    }
+    indexLease(*lease);
 }
 
 bool
 Memfile_LeaseMgr::deleteLease(const bundy::asiolink::IOAddress& addr) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MEMFILE_DELETE_ADDR).arg(addr.toText());
+    Mutex::Locker lock(mutex_);
     if (addr.isV4()) {
         // v4 lease
         Lease4Storage::iterator l = storage4_.find(addr);
@@ -349,7 +671,9 @@ Memfile_LeaseMgr::deleteLease(const bundy::asiolink::IOAddress& addr) {
                 // removed.
                 lease_copy.valid_lft_ = 0;
                 lease_file4_->append(lease_copy);
+                ++appended_;
             }
+            index_[Lease::TYPE_V4].remove(addr);
             storage4_.erase(l);
             return (true);
         }
@@ -369,8 +693,10 @@ Memfile_LeaseMgr::deleteLease(const bundy::asiolink::IOAddress& addr) {
                 lease_copy.valid_lft_ = 0;
                 lease_copy.preferred_lft_ = 0;
                 lease_file6_->append(lease_copy);
+                ++appended_;
             }
 
+            index_[(*l)->type_].remove(addr);
             storage6_.erase(l);
             return (true);
         }
@@ -384,6 +710,28 @@ Memfile_LeaseMgr::getDescription() const {
                         "purpose is to test abstract lease manager API."));
 }
 
+const LeaseIndex*
+Memfile_LeaseMgr::getLeaseIndex(Lease::Type type) const {
+    if (type > Lease::TYPE_V4) {
+        bundy_throw(BadValue, "invalid lease type " << static_cast<int>(type));
+    }
+    return (&index_[type]);
+}
+
+void
+Memfile_LeaseMgr::indexLease(const Lease4& lease) {
+    index_[Lease::TYPE_V4].add(lease.addr_, 32,
+                               lease.cltt_ + lease.valid_lft_);
+}
+
+void
+Memfile_LeaseMgr::indexLease(const Lease6& lease) {
+    index_[lease.type_].add(lease.addr_,
+                            lease.type_ == Lease::TYPE_PD ?
+                            lease.prefixlen_ : 128,
+                            lease.cltt_ + lease.valid_lft_);
+}
+
 void
 Memfile_LeaseMgr::commit() {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL, DHCPSRV_MEMFILE_COMMIT);
@@ -395,6 +743,88 @@ Memfile_LeaseMgr::rollback() {
               DHCPSRV_MEMFILE_ROLLBACK);
 }
 
+void
+Memfile_LeaseMgr::sync() {
+    if (!sync_thread_) {
+        return;
+    }
+
+    uint64_t written;
+    {
+        Mutex::Locker lock(mutex_);
+        written = appended_;
+        ++sync_writers_;
+    }
+
+    Mutex::Locker lock(sync_mutex_);
+    while (synced_ < written && failed_ < written) {
+        bool alone;
+        {
+            Mutex::Locker lock(mutex_);
+            alone = (sync_writers_ == 1);
+        }
+        // Alone (e.g. the packets are processed by a single thread), the
+        // caller flushes the file right away: waiting for the interval
+        // would batch nothing.  Otherwise the flush done by the group
+        // commit thread serves all the writers in flight, and the caller
+        // flushes the file itself if the interval elapsed without one.
+        if (alone || !synced_cond_.timedWait(sync_mutex_, sync_interval_)) {
+            syncLeaseFile();
+        }
+    }
+
+    {
+        Mutex::Locker lock(mutex_);
+        --sync_writers_;
+    }
+    if (synced_ < written) {
+        bundy_throw(DbOperationError, "failed to flush the lease file to"
+                  " the disk");
+    }
+}
+
+void
+Memfile_LeaseMgr::syncRun() {
+    Mutex::Locker lock(sync_mutex_);
+    while (!sync_stop_) {
+        sync_cond_.timedWait(sync_mutex_, sync_interval_);
+        syncLeaseFile();
+    }
+}
+
+void
+Memfile_LeaseMgr::syncLeaseFile() {
+    uint64_t written = 0;
+    try {
+        {
+            // The records are written to the file with the leases locked,
+            // the slow part is done without blocking the other threads.
+            Mutex::Locker lock(mutex_);
+            written = appended_;
+            if (written == synced_) {
+                return;
+            }
+            if (lease_file4_) {
+                lease_file4_->flush();
+            } else {
+                lease_file6_->flush();
+            }
+        }
+        // The lease file is only replaced with sync_mutex_ locked.
+        if (lease_file4_) {
+            lease_file4_->sync();
+        } else {
+            lease_file6_->sync();
+        }
+        synced_ = written;
+
+    } catch (const std::exception& ex) {
+        LOG_ERROR(dhcpsrv_logger, DHCPSRV_MEMFILE_SYNC_FAIL).arg(ex.what());
+        failed_ = written;
+    }
+    synced_cond_.broadcast();
+}
+
 std::string
 Memfile_LeaseMgr::getDefaultLeaseFilePath(Universe u) const {
     std::ostringstream s;
@@ -425,6 +855,83 @@ Memfile_LeaseMgr::persistLeases(Universe u) const {
     return (u == V6 && lease_file6_);
 }
 
+std::string
+Memfile_LeaseMgr::appendSuffix(const std::string& file_name,
+                               const LFCFileType file_type) {
+    switch (file_type) {
+    case FILE_INPUT:
+        return (file_name + ".1");
+    case FILE_PREVIOUS:
+        return (file_name + ".2");
+    case FILE_OUTPUT:
+        return (file_name + ".output");
+    default:
+        ;
+    }
+    return (file_name);
+}
+
+void
+Memfile_LeaseMgr::lfcExecute() {
+    Mutex::Locker lock(lfc_mutex_);
+    lfcCompact();
+}
+
+void
+Memfile_LeaseMgr::lfcRun() {
+    // The timeout of the wait is in milliseconds.
+    const unsigned int timeout =
+        std::min(lfc_interval_, static_cast<uint32_t>(UINT_MAX / 1000)) * 1000;
+
+    Mutex::Locker lock(lfc_mutex_);
+    while (!lfc_stop_) {
+        if (lfc_cond_.timedWait(lfc_mutex_, timeout)) {
+            // Woken up, most likely to exit.
+            continue;
+        }
+        try {
+            lfcCompact();
+        } catch (const std::exception& ex) {
+            LOG_ERROR(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_FAIL).arg(ex.what());
+        }
+    }
+}
+
+void
+Memfile_LeaseMgr::lfcCompact() {
+    // Only this function replaces the lease file, so it can be looked at
+    // without locking the leases.
+    const Universe u = persistLeases(V4) ? V4 : V6;
+    if (!persistLeases(u)) {
+        return;
+    }
+    const std::string file_name = getLeaseFilePath(u);
+    LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_START).arg(file_name);
+
+    size_t count = 0;
+    try {
+        {
+            Mutex::Locker sync_lock(sync_mutex_);
+            Mutex::Locker lock(mutex_);
+            if (u == V4) {
+                rotateLeaseFile(lease_file4_);
+            } else {
+                rotateLeaseFile(lease_file6_);
+            }
+        }
+        if (u == V4) {
+            count = compactLeaseFile<CSVLeaseFile4, Lease4Ptr>(file_name);
+        } else {
+            count = compactLeaseFile<CSVLeaseFile6, Lease6Ptr>(file_name);
+        }
+    } catch (const bundy::util::CSVFileError& ex) {
+        bundy_throw(DbOperationError, "cleanup of the lease file " << file_name
+                  << " failed: " << ex.what());
+    }
+    LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_COMPLETE).arg(file_name)
+        .arg(count);
+}
+
 std::string
 Memfile_LeaseMgr::initLeaseFilePath(Universe u) {
     std::string persist_val;
@@ -468,16 +975,33 @@ Memfile_LeaseMgr::load4() {
     // Remove existing leases (if any). We will recreate them based on the
     // data on disk.
     storage4_.clear();
+    index_[Lease::TYPE_V4].clear();
+
+    // The files left by the lease file cleanup hold the older records.
+    const LFCFileType older[] = { FILE_PREVIOUS, FILE_INPUT };
+    for (int i = 0; i < 2; ++i) {
+        CSVLeaseFile4 lease_file(appendSuffix(lease_file4_->getFilename(),
+                                              older[i]));
+        if (fileExists(lease_file.getFilename())) {
+            lease_file.open();
+            loadLeaseFile4(lease_file);
+            lease_file.close();
+        }
+    }
+    loadLeaseFile4(*lease_file4_);
+}
 
+void
+Memfile_LeaseMgr::loadLeaseFile4(CSVLeaseFile4& lease_file) {
     Lease4Ptr lease;
     do {
         /// @todo Currently we stop parsing on first failure. It is possible
         /// that only one (or a few) leases are bad, so in theory we could
         /// continue parsing but that would require some error counters to
         /// prevent endless loops. That is enhancement for later time.
-        if (!lease_file4_->next(lease)) {
-            bundy_throw(DbOperationError, "Failed to parse the DHCPv6 lease in"
-                      " the lease file: " << lease_file4_->getReadMsg());
+        if (!lease_file.next(lease)) {
+            bundy_throw(DbOperationError, "Failed to parse the DHCPv4 lease in"
+                      " the lease file: " << lease_file.getReadMsg());
         }
         // If we got the lease, we update the internal container holding
         // leases. Otherwise, we reached the end of file and we leave.
@@ -500,17 +1024,28 @@ Memfile_LeaseMgr::loadLease4(Lease4Ptr& lease) {
         // We use valid lifetime of 0 to indicate that lease should
         // be removed.
         if (lease->valid_lft_ > 0) {
-           storage4_.insert(lease);
-       }
+            if (!storage4_.insert(lease).second) {
+                bundy_throw(DbOperationError, "failed to load the lease with"
+                          " address " << lease->addr_ << " - another lease"
+                          " has the same hardware address and subnet");
+            }
+            indexLease(*lease);
+        }
     } else {
         // We use valid lifetime of 0 to indicate that the lease is
         // to be removed. In such case, erase the lease.
         if (lease->valid_lft_ == 0) {
+            index_[Lease::TYPE_V4].remove(lease->addr_);
             storage4_.erase(lease_it);
 
         } else {
             // Update existing lease.
-            **lease_it = *lease;
+            if (!storage4_.replace(lease_it, lease)) {
+                bundy_throw(DbOperationError, "failed to load the lease with"
+                          " address " << lease->addr_ << " - another lease"
+                          " has the same hardware address and subnet");
+            }
+            indexLease(*lease);
         }
     }
 }
@@ -529,16 +1064,35 @@ Memfile_LeaseMgr::load6() {
     // Remove existing leases (if any). We will recreate them based on the
     // data on disk.
     storage6_.clear();
+    index_[Lease::TYPE_NA].clear();
+    index_[Lease::TYPE_TA].clear();
+    index_[Lease::TYPE_PD].clear();
+
+    // The files left by the lease file cleanup hold the older records.
+    const LFCFileType older[] = { FILE_PREVIOUS, FILE_INPUT };
+    for (int i = 0; i < 2; ++i) {
+        CSVLeaseFile6 lease_file(appendSuffix(lease_file6_->getFilename(),
+                                              older[i]));
+        if (fileExists(lease_file.getFilename())) {
+            lease_file.open();
+            loadLeaseFile6(lease_file);
+            lease_file.close();
+        }
+    }
+    loadLeaseFile6(*lease_file6_);
+}
 
+void
+Memfile_LeaseMgr::loadLeaseFile6(CSVLeaseFile6& lease_file) {
     Lease6Ptr lease;
     do {
         /// @todo Currently we stop parsing on first failure. It is possible
         /// that only one (or a few) leases are bad, so in theory we could
         /// continue parsing but that would require some error counters to
         /// prevent endless loops. That is enhancement for later time.
-        if (!lease_file6_->next(lease)) {
+        if (!lease_file.next(lease)) {
             bundy_throw(DbOperationError, "Failed to parse the DHCPv6 lease in"
-                      " the lease file: " << lease_file6_->getReadMsg());
+                      " the lease file: " << lease_file.getReadMsg());
         }
         // If we got the lease, we update the internal container holding
         // leases. Otherwise, we reached the end of file and we leave.
@@ -562,17 +1116,28 @@ Memfile_LeaseMgr::loadLease6(Lease6Ptr& lease) {
         // We use valid lifetime of 0 to indicate that lease should
         // be removed.
         if (lease->valid_lft_ > 0) {
-            storage6_.insert(lease);
-       }
+            if (!storage6_.insert(lease).second) {
+                bundy_throw(DbOperationError, "failed to load the lease with"
+                          " address " << lease->addr_ << " - another lease"
+                          " has the same DUID, IAID and subnet");
+            }
+            indexLease(*lease);
+        }
     } else {
         // We use valid lifetime of 0 to indicate that the lease is
         // to be removed. In such case, erase the lease.
         if (lease->valid_lft_ == 0) {
+            index_[(*lease_it)->type_].remove(lease->addr_);
             storage6_.erase(lease_it);
 
         } else {
             // Update existing lease.
-            **lease_it = *lease;
+            if (!storage6_.replace(lease_it, lease)) {
+                bundy_throw(DbOperationError, "failed to load the lease with"
+                          " address " << lease->addr_ << " - another lease"
+                          " has the same DUID, IAID and subnet");
+            }
+            indexLease(*lease);
         }
     }
 
@@ -19,12 +19,17 @@
 #include <dhcpsrv/csv_lease_file4.h>
 #include <dhcpsrv/csv_lease_file6.h>
 #include <dhcpsrv/lease_mgr.h>
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
 
+#include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/indexed_by.hpp>
+#include <boost/multi_index/mem_fun.hpp>
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/composite_key.hpp>
+#include <boost/scoped_ptr.hpp>
 
 namespace bundy {
 namespace dhcp {
@@ -68,6 +73,36 @@ namespace dhcp {
 /// is not specified, the default location in the installation
 /// directory is used: var/bundy/kea-leases4.csv and
 /// var/bundy/kea-leases6.csv.
+///
+/// As the lease file holds the whole history of the leases, it is compacted
+/// by the Lease File Cleanup (LFC) from time to time.  The "lfc-interval"
+/// parameter specifies the interval in seconds (0, the default, disables
+/// the periodic cleanup).  The cleanup renames the lease file to the file
+/// with the ".1" suffix and opens a new lease file, which is the only part
+/// done with the leases locked.  It then writes the leases found in the
+/// ".2" (the result of the previous cleanup) and ".1" files to the file with
+/// the ".output" suffix, which is renamed to ".2" when complete.  The ".1"
+/// file is removed in the end.  At startup, the leases are read from the
+/// ".2", ".1" and the lease file in this order, so the leases are recovered
+/// whenever the cleanup is interrupted.
+///
+/// By default each record is flushed to the lease file when written, but
+/// not to the disk.  The "sync-interval" parameter (in milliseconds) enables
+/// the group commit: the records are buffered and a thread writes them and
+/// flushes the file to the disk once per interval.  The @c sync method waits
+/// until the records written so far are on the disk, so the servers hold
+/// the responses until the leases in them are durable.  A thread calling
+/// @c sync while no other one is waiting flushes the file itself, so a
+/// server processing the packets one after another is not slowed down by
+/// the interval.  When several threads process the packets, one disk
+/// flush serves all those waiting.
+///
+/// The public methods are serialized with a mutex, so the backend can be
+/// used by several threads processing packets at the same time.  The
+/// leases returned are copies of the stored ones.
+///
+/// The leased addresses of each type are also kept in a @c LeaseIndex,
+/// which the allocation engine uses to find the free ones.
 class Memfile_LeaseMgr : public LeaseMgr {
 public:
 
@@ -82,6 +117,14 @@ public:
         V6
     };
 
+    /// @brief Types of the lease files used by the Lease File Cleanup
+    enum LFCFileType {
+        FILE_CURRENT,  ///< The file the leases are written to
+        FILE_INPUT,    ///< The file being compacted (".1")
+        FILE_PREVIOUS, ///< The result of the previous cleanup (".2")
+        FILE_OUTPUT    ///< The file being written by the cleanup (".output")
+    };
+
     /// @brief The sole lease manager constructor
     ///
     /// dbconfig is a generic way of passing parameters. Parameters
@@ -92,17 +135,23 @@ public:
     ///        concerned with the database.
     Memfile_LeaseMgr(const ParameterMap& parameters);
 
-    /// @brief Destructor (closes file)
+    /// @brief Destructor (stops the cleanup and closes file)
     virtual ~Memfile_LeaseMgr();
 
     /// @brief Adds an IPv4 lease.
     ///
     /// @param lease lease to be added
+    ///
+    /// @return false if a lease with the same address, or with the same
+    /// hardware address and subnet, already exists.
     virtual bool addLease(const Lease4Ptr& lease);
 
     /// @brief Adds an IPv6 lease.
     ///
     /// @param lease lease to be added
+    ///
+    /// @return false if a lease with the same address, or with the same
+    /// DUID, IAID and subnet, already exists.
     virtual bool addLease(const Lease6Ptr& lease);
 
     /// @brief Returns existing IPv4 lease for specified IPv4 address.
@@ -190,9 +239,10 @@ public:
     virtual Lease6Ptr getLease6(Lease::Type type,
                                 const bundy::asiolink::IOAddress& addr) const;
 
-    /// @brief Returns existing IPv6 lease for a given DUID+IA combination
+    /// @brief Returns existing IPv6 leases for a given DUID+IA combination
     ///
-    /// @todo Not implemented yet
+    /// This function returns copies of the leases. The modification in the
+    /// returned leases does not affect the instances held in the storage.
     ///
     /// @param type specifies lease type: (NA, TA or PD)
     /// @param duid client DUID
@@ -216,6 +266,24 @@ public:
     virtual Lease6Collection getLeases6(Lease::Type type, const DUID& duid,
                                         uint32_t iaid, SubnetID subnet_id) const;
 
+    /// @brief Returns the expired IPv4 leases.
+    ///
+    /// The leases are found walking the expiration time index from the
+    /// start, so the time it takes depends on the number of the leases
+    /// returned only.
+    ///
+    /// @param [out] expired Collection the expired leases are appended to.
+    /// @param max_leases Maximum number of the leases returned, 0 for all.
+    virtual void getExpiredLeases4(Lease4Collection& expired,
+                                   size_t max_leases) const;
+
+    /// @brief Returns the expired IPv6 leases.
+    ///
+    /// @param [out] expired Collection the expired leases are appended to.
+    /// @param max_leases Maximum number of the leases returned, 0 for all.
+    virtual void getExpiredLeases6(Lease6Collection& expired,
+                                   size_t max_leases) const;
+
     /// @brief Updates IPv4 lease.
     ///
     /// @warning This function does not validate the pointer to the lease.
@@ -224,6 +292,9 @@ public:
     /// @param lease4 The lease to be updated.
     ///
     /// If no such lease is present, an exception will be thrown.
+    ///
+    /// @throw DbOperationError if another lease has the same
+    /// hardware address and subnet.
     virtual void updateLease4(const Lease4Ptr& lease4);
 
     /// @brief Updates IPv6 lease.
@@ -234,6 +305,9 @@ public:
     /// @param lease6 The lease to be updated.
     ///
     /// If no such lease is present, an exception will be thrown.
+    ///
+    /// @throw DbOperationError if another lease has the same
+    /// DUID, IAID and subnet.
     virtual void updateLease6(const Lease6Ptr& lease6);
 
     /// @brief Deletes a lease.
@@ -289,6 +363,30 @@ public:
     /// support transactions, this is a no-op.
     virtual void rollback();
 
+    /// @brief Waits until the lease records written so far are on the disk.
+    ///
+    /// It returns immediately unless the group commit is enabled by the
+    /// "sync-interval" parameter.  If no other thread is waiting, the file
+    /// is flushed right away, otherwise the flush is shared with them.
+    ///
+    /// @throw DbOperationError if the records couldn't be written.
+    virtual void sync();
+
+    /// @brief Returns the interval of the group commit in milliseconds.
+    ///
+    /// The value of 0 means that the records are not flushed to the disk.
+    uint32_t getSyncInterval() const {
+        return (sync_interval_);
+    }
+
+    /// @brief Returns the index of the leased addresses.
+    ///
+    /// The backend keeps the index up to date for all the lease types.
+    ///
+    /// @param type Type of the leases.
+    /// @return The index.
+    virtual const LeaseIndex* getLeaseIndex(Lease::Type type) const;
+
     /// @brief Returns default path to the lease file.
     ///
     /// @param u Universe (V4 or V6).
@@ -315,6 +413,32 @@ public:
     /// server shut down.
     bool persistLeases(Universe u) const;
 
+    /// @brief Returns the name of a lease file used by the cleanup.
+    ///
+    /// @param file_name The name of the lease file.
+    /// @param file_type The type of the file.
+    /// @return The name with the suffix of the file type.
+    static std::string appendSuffix(const std::string& file_name,
+                                    const LFCFileType file_type);
+
+    /// @brief Returns the interval of the Lease File Cleanup in seconds.
+    ///
+    /// The value of 0 means that the cleanup is not run periodically.
+    uint32_t getLFCInterval() const {
+        return (lfc_interval_);
+    }
+
+    /// @brief Runs the Lease File Cleanup.
+    ///
+    /// The lease file is compacted as described in the class documentation.
+    /// The leases are locked only while the lease file is rotated, so the
+    /// backend can be used by other threads during the cleanup.  If the
+    /// file with the ".1" suffix is left by the interrupted cleanup, it
+    /// is compacted first and the lease file is rotated the next time.
+    ///
+    /// @throw bundy::DbOperationError if the cleanup failed.
+    void lfcExecute();
+
 protected:
 
     /// @brief Load all DHCPv4 leases from the file.
@@ -326,6 +450,14 @@ protected:
     /// file.
     void load4();
 
+    /// @brief Loads all DHCPv4 leases from an open lease file.
+    ///
+    /// @param lease_file The lease file.
+    ///
+    /// @throw bundy::DbOperationError If failed to read a lease from the lease
+    /// file.
+    void loadLeaseFile4(CSVLeaseFile4& lease_file);
+
     /// @brief Loads a single DHCPv4 lease from the file.
     ///
     /// This method reads a single lease record from the lease file. If the
@@ -337,6 +469,9 @@ protected:
     /// database, the existing lease is removed.
     ///
     /// @param lease Pointer to the lease read from the lease file.
+    ///
+    /// @throw DbOperationError if another lease has the same
+    /// hardware address and subnet.
     void loadLease4(Lease4Ptr& lease);
 
     /// @brief Load all DHCPv6 leases from the file.
@@ -348,6 +483,14 @@ protected:
     /// file.
     void load6();
 
+    /// @brief Loads all DHCPv6 leases from an open lease file.
+    ///
+    /// @param lease_file The lease file.
+    ///
+    /// @throw bundy::DbOperationError If failed to read a lease from the lease
+    /// file.
+    void loadLeaseFile6(CSVLeaseFile6& lease_file);
+
     /// @brief Loads a single DHCPv6 lease from the file.
     ///
     /// This method reads a single lease record from the lease file. If the
@@ -359,8 +502,21 @@ protected:
     /// database, the existing lease is removed.
     ///
     /// @param lease Pointer to the lease read from the lease file.
+    ///
+    /// @throw DbOperationError if another lease has the same
+    /// DUID, IAID and subnet.
     void loadLease6(Lease6Ptr& lease);
 
+    /// @brief Adds an IPv4 lease to the index, or updates it there.
+    ///
+    /// @param lease The lease.
+    void indexLease(const Lease4& lease);
+
+    /// @brief Adds an IPv6 lease to the index, or updates it there.
+    ///
+    /// @param lease The lease.
+    void indexLease(const Lease6& lease);
+
     /// @brief Initialize the location of the lease file.
     ///
     /// This method uses the parameters passed as a map to the constructor to
@@ -380,21 +536,49 @@ protected:
     /// argument to this function.
     std::string initLeaseFilePath(Universe u);
 
+    /// @brief Runs the Lease File Cleanup periodically.
+    ///
+    /// This is the main function of the cleanup thread.  It runs until
+    /// the backend is destroyed.
+    void lfcRun();
+
+    /// @brief Runs the cleanup of the lease files in use.
+    ///
+    /// The caller must hold @c lfc_mutex_.
+    void lfcCompact();
+
+    /// @brief Flushes the lease file to the disk periodically.
+    ///
+    /// This is the main function of the group commit thread.  It runs until
+    /// the backend is destroyed.
+    void syncRun();
+
+    /// @brief Flushes the lease file to the disk and wakes up the threads
+    /// waiting in @c sync.
+    ///
+    /// The caller must hold @c sync_mutex_.
+    void syncLeaseFile();
+
     // This is a multi-index container, which holds elements that can
-    // be accessed using different search indexes.
+    // be accessed using different search indexes.  All the lookups done
+    // by the lease manager are exact matches, so the indexes are hashed:
+    // with many leases in memory a lookup costs a hash computation and a
+    // bucket walk instead of a tree descent with a cache miss per level.
+    // The only ordered index is the expiration time, walked from the start
+    // to find the expired leases.
     typedef boost::multi_index_container<
         // It holds pointers to Lease6 objects.
         Lease6Ptr,
         boost::multi_index::indexed_by<
             // Specification of the first index starts here.
-            // This index sorts leases by IPv6 addresses represented as
+            // This index finds leases by IPv6 addresses represented as
             // IOAddress objects.
-            boost::multi_index::ordered_unique<
+            boost::multi_index::hashed_unique<
                 boost::multi_index::member<Lease, bundy::asiolink::IOAddress, &Lease::addr_>
             >,
 
             // Specification of the second index starts here.
-            boost::multi_index::ordered_unique<
+            boost::multi_index::hashed_unique<
                 // This is a composite index that will be used to search for
                 // the lease using three attributes: DUID, IAID, Subnet Id.
                 boost::multi_index::composite_key<
@@ -408,28 +592,48 @@ protected:
                     boost::multi_index::member<Lease6, uint32_t, &Lease6::iaid_>,
                     boost::multi_index::member<Lease, SubnetID, &Lease::subnet_id_>
                 >
+            >,
+
+            // Specification of the third index starts here.
+            boost::multi_index::hashed_non_unique<
+                // This is a composite index that will be used to search for
+                // the leases of an IA in all subnets: DUID and IAID.
+                boost::multi_index::composite_key<
+                    Lease6,
+                    boost::multi_index::const_mem_fun<Lease6, const std::vector<uint8_t>&,
+                                                      &Lease6::getDuidVector>,
+                    boost::multi_index::member<Lease6, uint32_t, &Lease6::iaid_>
+                >
+            >,
+
+            // Specification of the fourth index starts here.
+            // This index orders the leases by the expiration time.
+            boost::multi_index::ordered_non_unique<
+                boost::multi_index::const_mem_fun<Lease, int64_t,
+                                                  &Lease::getExpirationTime>
             >
         >
      > Lease6Storage; // Specify the type name of this container.
 
     // This is a multi-index container, which holds elements that can
-    // be accessed using different search indexes.
+    // be accessed using different search indexes.  The indexes are hashed
+    // for the same reason as the indexes of the Lease6Storage.
     typedef boost::multi_index_container<
         // It holds pointers to Lease4 objects.
         Lease4Ptr,
         // Specification of search indexes starts here.
         boost::multi_index::indexed_by<
             // Specification of the first index starts here.
-            // This index sorts leases by IPv4 addresses represented as
+            // This index finds leases by IPv4 addresses represented as
             // IOAddress objects.
-            boost::multi_index::ordered_unique<
+            boost::multi_index::hashed_unique<
                 // The IPv4 address are held in addr_ members that belong to
                 // Lease class.
                 boost::multi_index::member<Lease, bundy::asiolink::IOAddress, &Lease::addr_>
             >,
 
             // Specification of the second index starts here.
-            boost::multi_index::ordered_unique<
+            boost::multi_index::hashed_unique<
                 // This is a composite index that combines two attributes of the
                 // Lease4 object: hardware address and subnet id.
                 boost::multi_index::composite_key<
@@ -447,7 +651,7 @@ protected:
             >,
 
             // Specification of the third index starts here.
-            boost::multi_index::ordered_non_unique<
+            boost::multi_index::hashed_non_unique<
                 // This is a composite index that uses two values to search for a
                 // lease: client id and subnet id.
                 boost::multi_index::composite_key<
@@ -462,7 +666,7 @@ protected:
             >,
 
             // Specification of the fourth index starts here.
-            boost::multi_index::ordered_non_unique<
+            boost::multi_index::hashed_non_unique<
                 // This is a composite index that uses two values to search for a
                 // lease: client id and subnet id.
                 boost::multi_index::composite_key<
@@ -478,6 +682,29 @@ protected:
                     // The subnet id is accessed through the subnet_id_ member.
                     boost::multi_index::member<Lease, SubnetID, &Lease::subnet_id_>
                 >
+            >,
+
+            // Specification of the fifth index starts here.
+            // This index finds the leases of a hardware address in all
+            // subnets.
+            boost::multi_index::hashed_non_unique<
+                boost::multi_index::member<Lease4, std::vector<uint8_t>,
+                                           &Lease4::hwaddr_>
+            >,
+
+            // Specification of the sixth index starts here.
+            // This index finds the leases of a client id in all subnets.
+            // The leases without the client id share one (empty) key.
+            boost::multi_index::hashed_non_unique<
+                boost::multi_index::const_mem_fun<Lease4, const std::vector<uint8_t>&,
+                                                  &Lease4::getClientIdVector>
+            >,
+
+            // Specification of the seventh index starts here.
+            // This index orders the leases by the expiration time.
+            boost::multi_index::ordered_non_unique<
+                boost::multi_index::const_mem_fun<Lease, int64_t,
+                                                  &Lease::getExpirationTime>
             >
         >
     > Lease4Storage; // Specify the type name for this container.
@@ -488,12 +715,68 @@ protected:
     /// @brief stores IPv6 leases
     Lease6Storage storage6_;
 
+    /// @brief Indexes of the leased addresses, one for each lease type
+    LeaseIndex index_[Lease::TYPE_V4 + 1];
+
     /// @brief Holds the pointer to the DHCPv4 lease file IO.
     boost::shared_ptr<CSVLeaseFile4> lease_file4_;
 
     /// @brief Holds the pointer to the DHCPv6 lease file IO.
     boost::shared_ptr<CSVLeaseFile6> lease_file6_;
 
+    /// @brief Protects the storage and the lease files.
+    mutable bundy::util::thread::Mutex mutex_;
+
+    /// @brief Interval of the Lease File Cleanup in seconds
+    uint32_t lfc_interval_;
+
+    /// @brief Serializes the cleanups and protects @c lfc_stop_
+    bundy::util::thread::Mutex lfc_mutex_;
+
+    /// @brief Wakes the cleanup thread up when the backend is destroyed
+    bundy::util::thread::CondVar lfc_cond_;
+
+    /// @brief Tells the cleanup thread to exit
+    bool lfc_stop_;
+
+    /// @brief The thread running the cleanup periodically
+    boost::scoped_ptr<bundy::util::thread::Thread> lfc_thread_;
+
+    /// @brief Interval of the group commit in milliseconds
+    uint32_t sync_interval_;
+
+    /// @brief Number of the records written to the lease file
+    ///
+    /// It is protected by @c mutex_.
+    uint64_t appended_;
+
+    /// @brief Number of the records known to be on the disk
+    uint64_t synced_;
+
+    /// @brief Number of the records which failed to be flushed to the disk
+    uint64_t failed_;
+
+    /// @brief Number of the threads waiting in @c sync
+    ///
+    /// It is protected by @c mutex_.
+    size_t sync_writers_;
+
+    /// @brief Protects the group commit state, held while flushing the file
+    ///
+    /// When both are locked, it is locked before @c mutex_.
+    bundy::util::thread::Mutex sync_mutex_;
+
+    /// @brief Wakes the group commit thread up when the backend is destroyed
+    bundy::util::thread::CondVar sync_cond_;
+
+    /// @brief Wakes up the threads waiting for the records to be flushed
+    bundy::util::thread::CondVar synced_cond_;
+
+    /// @brief Tells the group commit thread to exit
+    bool sync_stop_;
+
+    /// @brief The thread flushing the lease file periodically
+    boost::scoped_ptr<bundy::util::thread::Thread> sync_thread_;
 };
 
 }; // end of bundy::dhcp namespace
@@ -20,13 +20,17 @@
 #include <dhcpsrv/dhcpsrv_log.h>
 #include <dhcpsrv/mysql_lease_mgr.h>
 
+#include <util/threads/sync.h>
+
 #include <boost/static_assert.hpp>
 #include <mysqld_error.h>
 
 #include <iostream>
 #include <iomanip>
+#include <limits>
 #include <sstream>
 #include <string>
+#include <pthread.h>
 #include <time.h>
 
 using namespace bundy;
@@ -145,6 +149,13 @@ TaggedStatement tagged_statements[] = {
                         "fqdn_fwd, fqdn_rev, hostname "
                             "FROM lease4 "
                             "WHERE client_id = ? AND subnet_id = ?"},
+    {MySqlLeaseMgr::GET_LEASE4_EXPIRE,
+                    "SELECT address, hwaddr, client_id, "
+                        "valid_lifetime, expire, subnet_id, "
+                        "fqdn_fwd, fqdn_rev, hostname "
+                            "FROM lease4 "
+                            "WHERE expire < ? "
+                            "ORDER BY expire LIMIT ?"},
     {MySqlLeaseMgr::GET_LEASE4_HWADDR,
                     "SELECT address, hwaddr, client_id, "
                         "valid_lifetime, expire, subnet_id, "
@@ -179,6 +190,14 @@ TaggedStatement tagged_statements[] = {
                             "FROM lease6 "
                             "WHERE duid = ? AND iaid = ? AND subnet_id = ? "
                             "AND lease_type = ?"},
+    {MySqlLeaseMgr::GET_LEASE6_EXPIRE,
+                    "SELECT address, duid, valid_lifetime, "
+                        "expire, subnet_id, pref_lifetime, "
+                        "lease_type, iaid, prefix_len, "
+                        "fqdn_fwd, fqdn_rev, hostname "
+                            "FROM lease6 "
+                            "WHERE expire < ? "
+                            "ORDER BY expire LIMIT ?"},
     {MySqlLeaseMgr::GET_VERSION,
                     "SELECT version, minor FROM schema_version"},
     {MySqlLeaseMgr::INSERT_LEASE4,
@@ -209,6 +228,77 @@ TaggedStatement tagged_statements[] = {
     {MySqlLeaseMgr::NUM_STATEMENTS, NULL}
 };
 
+// The MySQL client library must be initialized in every thread using it
+// (mysql_thread_init()), and released by these threads when they exit
+// (mysql_thread_end()): mysql_library_end() waits for them otherwise.  The
+// thread initializing the library itself needs nothing more.
+
+/// @brief State of the library, protected by its mutex.
+struct LibraryState {
+    LibraryState() : initialized(false), threads(0) {}
+    bundy::util::thread::Mutex mutex;
+    bool initialized;
+    pthread_t library_thread;   ///< Thread which initialized the library
+    size_t threads;             ///< Other threads using the library
+};
+
+LibraryState&
+getLibraryState() {
+    static LibraryState state;
+    return (state);
+}
+
+// Values of the per-thread key: the thread initialized the library, or
+// called mysql_thread_init().
+char library_thread_marker;
+char thread_marker;
+
+pthread_once_t thread_key_once = PTHREAD_ONCE_INIT;
+pthread_key_t thread_key;
+
+// Called when a thread which has set the key exits.
+void
+endThread(void* marker) {
+    if (marker == &thread_marker) {
+        mysql_thread_end();
+        LibraryState& state = getLibraryState();
+        bundy::util::thread::Mutex::Locker lock(state.mutex);
+        --state.threads;
+    }
+}
+
+void
+createThreadKey() {
+    pthread_key_create(&thread_key, endThread);
+}
+
+// Initialize the library, unless it is already.  mysql_init() would do
+// it implicitly, but not in a thread safe way.
+void
+initLibrary() {
+    LibraryState& state = getLibraryState();
+    bundy::util::thread::Mutex::Locker lock(state.mutex);
+    if (!state.initialized) {
+        if (mysql_library_init(0, NULL, NULL) != 0) {
+            bundy_throw(DbOpenError, "unable to initialize MySQL");
+        }
+        state.initialized = true;
+        state.library_thread = pthread_self();
+    }
+}
+
+// Release the library, unless threads still use it (they usually outlive
+// the lease manager).  It is then released when the process exits.
+void
+endLibrary() {
+    LibraryState& state = getLibraryState();
+    bundy::util::thread::Mutex::Locker lock(state.mutex);
+    if (state.initialized && state.threads == 0) {
+        mysql_library_end();
+        state.initialized = false;
+    }
+}
+
 };  // Anonymous namespace
 
 
@@ -1099,35 +1189,14 @@ private:
     MYSQL_STMT*     statement_;     ///< Statement for which results are freed
 };
 
-// MySqlLeaseMgr Constructor and Destructor
-
-MySqlLeaseMgr::MySqlLeaseMgr(const LeaseMgr::ParameterMap& parameters)
-    : LeaseMgr(parameters) {
+// MySqlConnection Constructor and Destructor
 
-    // Open the database.
-    openDatabase();
-
-    // Enable autocommit.  To avoid a flush to disk on every commit, the global
-    // parameter innodb_flush_log_at_trx_commit should be set to 2.  This will
-    // cause the changes to be written to the log, but flushed to disk in the
-    // background every second.  Setting the parameter to that value will speed
-    // up the system, but at the risk of losing data if the system crashes.
-    my_bool result = mysql_autocommit(mysql_, 1);
-    if (result != 0) {
-        bundy_throw(DbOperationError, mysql_error(mysql_));
-    }
-
-    // Prepare all statements likely to be used.
-    prepareStatements();
-
-    // Create the exchange objects for use in exchanging data between the
-    // program and the database.
-    exchange4_.reset(new MySqlLease4Exchange());
-    exchange6_.reset(new MySqlLease6Exchange());
+MySqlConnection::MySqlConnection()
+    : exchange4_(new MySqlLease4Exchange()),
+      exchange6_(new MySqlLease6Exchange()) {
 }
 
-
-MySqlLeaseMgr::~MySqlLeaseMgr() {
+MySqlConnection::~MySqlConnection() {
     // Free up the prepared statements, ignoring errors. (What would we do
     // about them? We're destroying this object and are not really concerned
     // with errors on a database connection that is about to go away.)
@@ -1142,6 +1211,87 @@ MySqlLeaseMgr::~MySqlLeaseMgr() {
     // closed in the destructor of the mysql_ member variable.
 }
 
+void
+MySqlConnection::initThread() {
+    pthread_once(&thread_key_once, createThreadKey);
+    if (pthread_getspecific(thread_key) != NULL) {
+        return;
+    }
+    LibraryState& state = getLibraryState();
+    bundy::util::thread::Mutex::Locker lock(state.mutex);
+    if (state.initialized &&
+        pthread_equal(pthread_self(), state.library_thread)) {
+        pthread_setspecific(thread_key, &library_thread_marker);
+        return;
+    }
+    if (mysql_thread_init() != 0) {
+        bundy_throw(DbOperationError,
+                    "unable to initialize MySQL in the thread");
+    }
+    ++state.threads;
+    pthread_setspecific(thread_key, &thread_marker);
+}
+
+// MySqlLeaseMgr Constructor and Destructor
+
+MySqlLeaseMgr::MySqlLeaseMgr(const LeaseMgr::ParameterMap& parameters)
+    : LeaseMgr(parameters) {
+    string connections;
+    try {
+        connections = getParameter("connections");
+    } catch (...) {
+        // No pool size.  Fine, we'll open a single connection
+    }
+    const size_t pool_size = ConnectionPool::parseSize(connections);
+
+    // The commit mode of InnoDB is global (innodb_flush_log_at_trx_commit),
+    // it can't be changed for the connections of this server only.
+    string async_commit;
+    try {
+        async_commit = getParameter("async-commit");
+    } catch (...) {
+        // No async-commit.  Fine, the commits are synchronous
+    }
+    if (!async_commit.empty() && (async_commit != "false")) {
+        bundy_throw(BadValue, "invalid value 'async-commit=" << async_commit
+                  << "': set innodb_flush_log_at_trx_commit on the MySQL "
+                  "server instead");
+    }
+
+    initLibrary();
+    for (size_t i = 0; i < pool_size; ++i) {
+        ConnectionPool::ConnectionPtr connection(new MySqlConnection());
+
+        // Open the database.
+        openDatabase(*connection);
+
+        // Enable autocommit.  To avoid a flush to disk on every commit, the
+        // global parameter innodb_flush_log_at_trx_commit should be set to 2.
+        // This will cause the changes to be written to the log, but flushed
+        // to disk in the background every second.  Setting the parameter to
+        // that value will speed up the system, but at the risk of losing data
+        // if the system crashes.
+        my_bool result = mysql_autocommit(connection->mysql_, 1);
+        if (result != 0) {
+            bundy_throw(DbOperationError, mysql_error(connection->mysql_));
+        }
+
+        // Prepare all statements likely to be used.
+        prepareStatements(*connection);
+
+        pool_.add(connection);
+    }
+}
+
+
+MySqlLeaseMgr::~MySqlLeaseMgr() {
+    // Close all the connections before releasing the library.
+    pool_.clear();
+
+    // The library itself shouldn't be needed anymore
+    endLibrary();
+}
+
 
 // Time conversion methods.
 //
@@ -1202,7 +1352,8 @@ MySqlLeaseMgr::convertFromDatabaseTime(const MYSQL_TIME& expire,
 // Open the database using the parameters passed to the constructor.
 
 void
-MySqlLeaseMgr::openDatabase() {
+MySqlLeaseMgr::openDatabase(MySqlConnection& connection) {
+    MYSQL* mysql = connection.mysql_;
 
     // Set up the values of the parameters
     const char* host = "localhost";
@@ -1248,10 +1399,10 @@ MySqlLeaseMgr::openDatabase() {
     // disconnect from the database.  This option causes it to automatically
     // reconnect when another operation is about to be done.
     my_bool auto_reconnect = MLM_TRUE;
-    int result = mysql_options(mysql_, MYSQL_OPT_RECONNECT, &auto_reconnect);
+    int result = mysql_options(mysql, MYSQL_OPT_RECONNECT, &auto_reconnect);
     if (result != 0) {
         bundy_throw(DbOpenError, "unable to set auto-reconnect option: " <<
-                  mysql_error(mysql_));
+                  mysql_error(mysql));
     }
 
     // Set SQL mode options for the connection:  SQL mode governs how what
@@ -1259,10 +1410,10 @@ MySqlLeaseMgr::openDatabase() {
     // invalid data.  We want to ensure we get the strictest behavior and
     // to reject invalid data with an error.
     const char *sql_mode = "SET SESSION sql_mode ='STRICT_ALL_TABLES'";
-    result = mysql_options(mysql_, MYSQL_INIT_COMMAND, sql_mode);
+    result = mysql_options(mysql, MYSQL_INIT_COMMAND, sql_mode);
     if (result != 0) {
         bundy_throw(DbOpenError, "unable to set SQL mode options: " <<
-                  mysql_error(mysql_));
+                  mysql_error(mysql));
     }
 
     // Open the database.
@@ -1275,10 +1426,10 @@ MySqlLeaseMgr::openDatabase() {
     // This makes it hard to distinguish whether the UPDATE changed no rows
     // because no row matching the WHERE clause was found, or because a
     // row was found but no data was altered.
-    MYSQL* status = mysql_real_connect(mysql_, host, user, password, name,
+    MYSQL* status = mysql_real_connect(mysql, host, user, password, name,
                                        0, NULL, CLIENT_FOUND_ROWS);
-    if (status != mysql_) {
-        bundy_throw(DbOpenError, mysql_error(mysql_));
+    if (status != mysql) {
+        bundy_throw(DbOpenError, mysql_error(mysql));
     }
 }
 
@@ -1290,10 +1441,13 @@ MySqlLeaseMgr::openDatabase() {
 // class destructor explicitly destroys them.
 
 void
-MySqlLeaseMgr::prepareStatement(StatementIndex index, const char* text) {
+MySqlLeaseMgr::prepareStatement(MySqlConnection& connection,
+                                StatementIndex index, const char* text) {
+    std::vector<MYSQL_STMT*>& statements = connection.statements_;
+
     // Validate that there is space for the statement in the statements array
     // and that nothing has been placed there before.
-    if ((index >= statements_.size()) || (statements_[index] != NULL)) {
+    if ((index >= statements.size()) || (statements[index] != NULL)) {
         bundy_throw(InvalidParameter, "invalid prepared statement index (" <<
                   static_cast<int>(index) << ") or indexed prepared " <<
                   "statement is not null");
@@ -1301,32 +1455,33 @@ MySqlLeaseMgr::prepareStatement(StatementIndex index, const char* text) {
 
     // All OK, so prepare the statement
     text_statements_[index] = std::string(text);
-    statements_[index] = mysql_stmt_init(mysql_);
-    if (statements_[index] == NULL) {
+    statements[index] = mysql_stmt_init(connection.mysql_);
+    if (statements[index] == NULL) {
         bundy_throw(DbOperationError, "unable to allocate MySQL prepared "
-                  "statement structure, reason: " << mysql_error(mysql_));
+                  "statement structure, reason: " <<
+                  mysql_error(connection.mysql_));
     }
 
-    int status = mysql_stmt_prepare(statements_[index], text, strlen(text));
+    int status = mysql_stmt_prepare(statements[index], text, strlen(text));
     if (status != 0) {
         bundy_throw(DbOperationError, "unable to prepare MySQL statement <" <<
-                  text << ">, reason: " << mysql_error(mysql_));
+                  text << ">, reason: " << mysql_error(connection.mysql_));
     }
 }
 
 
 void
-MySqlLeaseMgr::prepareStatements() {
+MySqlLeaseMgr::prepareStatements(MySqlConnection& connection) {
     // Allocate space for all statements
-    statements_.clear();
-    statements_.resize(NUM_STATEMENTS, NULL);
+    connection.statements_.clear();
+    connection.statements_.resize(NUM_STATEMENTS, NULL);
 
     text_statements_.clear();
     text_statements_.resize(NUM_STATEMENTS, std::string(""));
 
     // Created the MySQL prepared statements for each DML statement.
     for (int i = 0; tagged_statements[i].text != NULL; ++i) {
-        prepareStatement(tagged_statements[i].index,
+        prepareStatement(connection, tagged_statements[i].index,
                          tagged_statements[i].text);
     }
 }
@@ -1336,24 +1491,26 @@ MySqlLeaseMgr::prepareStatements() {
 // statement, then call common code to execute the statement.
 
 bool
-MySqlLeaseMgr::addLeaseCommon(StatementIndex stindex,
+MySqlLeaseMgr::addLeaseCommon(MySqlConnection& connection,
+                              StatementIndex stindex,
                               std::vector<MYSQL_BIND>& bind) {
 
     // Bind the parameters to the statement
-    int status = mysql_stmt_bind_param(statements_[stindex], &bind[0]);
-    checkError(status, stindex, "unable to bind parameters");
+    int status = mysql_stmt_bind_param(connection.statements_[stindex],
+                                       &bind[0]);
+    checkError(connection, status, stindex, "unable to bind parameters");
 
     // Execute the statement
-    status = mysql_stmt_execute(statements_[stindex]);
+    status = mysql_stmt_execute(connection.statements_[stindex]);
     if (status != 0) {
 
         // Failure: check for the special case of duplicate entry.  If this is
         // the case, we return false to indicate that the row was not added.
         // Otherwise we throw an exception.
-        if (mysql_errno(mysql_) == ER_DUP_ENTRY) {
+        if (mysql_errno(connection.mysql_) == ER_DUP_ENTRY) {
             return (false);
         }
-        checkError(status, stindex, "unable to execute");
+        checkError(connection, status, stindex, "unable to execute");
     }
 
     // Insert succeeded
@@ -1364,12 +1521,14 @@ bool
 MySqlLeaseMgr::addLease(const Lease4Ptr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_ADD_ADDR4).arg(lease->addr_.toText());
+    ConnectionPool::Locker connection(pool_);
 
     // Create the MYSQL_BIND array for the lease
-    std::vector<MYSQL_BIND> bind = exchange4_->createBindForSend(lease);
+    std::vector<MYSQL_BIND> bind =
+        connection->exchange4_->createBindForSend(lease);
 
     // ... and drop to common code.
-    return (addLeaseCommon(INSERT_LEASE4, bind));
+    return (addLeaseCommon(*connection, INSERT_LEASE4, bind));
 }
 
 bool
@@ -1377,12 +1536,14 @@ MySqlLeaseMgr::addLease(const Lease6Ptr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_ADD_ADDR6).arg(lease->addr_.toText())
               .arg(lease->type_);
+    ConnectionPool::Locker connection(pool_);
 
     // Create the MYSQL_BIND array for the lease
-    std::vector<MYSQL_BIND> bind = exchange6_->createBindForSend(lease);
+    std::vector<MYSQL_BIND> bind =
+        connection->exchange6_->createBindForSend(lease);
 
     // ... and drop to common code.
-    return (addLeaseCommon(INSERT_LEASE6, bind));
+    return (addLeaseCommon(*connection, INSERT_LEASE6, bind));
 }
 
 // Extraction of leases from the database.
@@ -1411,37 +1572,42 @@ MySqlLeaseMgr::addLease(const Lease6Ptr& lease) {
 // holding zero or one leases into an appropriate Lease object.
 
 template <typename Exchange, typename LeaseCollection>
-void MySqlLeaseMgr::getLeaseCollection(StatementIndex stindex,
+void MySqlLeaseMgr::getLeaseCollection(MySqlConnection& connection,
+                                       StatementIndex stindex,
                                        MYSQL_BIND* bind,
                                        Exchange& exchange,
                                        LeaseCollection& result,
                                        bool single) const {
 
     // Bind the selection parameters to the statement
-    int status = mysql_stmt_bind_param(statements_[stindex], bind);
-    checkError(status, stindex, "unable to bind WHERE clause parameter");
+    int status = mysql_stmt_bind_param(connection.statements_[stindex], bind);
+    checkError(connection, status, stindex,
+               "unable to bind WHERE clause parameter");
 
     // Set up the MYSQL_BIND array for the data being returned and bind it to
     // the statement.
     std::vector<MYSQL_BIND> outbind = exchange->createBindForReceive();
-    status = mysql_stmt_bind_result(statements_[stindex], &outbind[0]);
-    checkError(status, stindex, "unable to bind SELECT clause parameters");
+    status = mysql_stmt_bind_result(connection.statements_[stindex],
+                                    &outbind[0]);
+    checkError(connection, status, stindex,
+               "unable to bind SELECT clause parameters");
 
     // Execute the statement
-    status = mysql_stmt_execute(statements_[stindex]);
-    checkError(status, stindex, "unable to execute");
+    status = mysql_stmt_execute(connection.statements_[stindex]);
+    checkError(connection, status, stindex, "unable to execute");
 
     // Ensure that all the lease information is retrieved in one go to avoid
     // overhead of going back and forth between client and server.
-    status = mysql_stmt_store_result(statements_[stindex]);
-    checkError(status, stindex, "unable to set up for storing all results");
+    status = mysql_stmt_store_result(connection.statements_[stindex]);
+    checkError(connection, status, stindex,
+               "unable to set up for storing all results");
 
     // Set up the fetch "release" object to release resources associated
     // with the call to mysql_stmt_fetch when this method exits, then
     // retrieve the data.
-    MySqlFreeResult fetch_release(statements_[stindex]);
+    MySqlFreeResult fetch_release(connection.statements_[stindex]);
     int count = 0;
-    while ((status = mysql_stmt_fetch(statements_[stindex])) == 0) {
+    while ((status = mysql_stmt_fetch(connection.statements_[stindex])) == 0) {
         try {
             result.push_back(exchange->getLeaseData());
 
@@ -1461,7 +1627,7 @@ void MySqlLeaseMgr::getLeaseCollection(StatementIndex stindex,
     // How did the fetch end?
     if (status == 1) {
         // Error - unable to fetch results
-        checkError(status, stindex, "unable to fetch results");
+        checkError(connection, status, stindex, "unable to fetch results");
     } else if (status == MYSQL_DATA_TRUNCATED) {
         // Data truncated - throw an exception indicating what was at fault
         bundy_throw(DataTruncated, text_statements_[stindex]
@@ -1471,7 +1637,8 @@ void MySqlLeaseMgr::getLeaseCollection(StatementIndex stindex,
 }
 
 
-void MySqlLeaseMgr::getLease(StatementIndex stindex, MYSQL_BIND* bind,
+void MySqlLeaseMgr::getLease(MySqlConnection& connection,
+                             StatementIndex stindex, MYSQL_BIND* bind,
                              Lease4Ptr& result) const {
     // Create appropriate collection object and get all leases matching
     // the selection criteria.  The "single" paraeter is true to indicate
@@ -1479,7 +1646,8 @@ void MySqlLeaseMgr::getLease(StatementIndex stindex, MYSQL_BIND* bind,
     // matching records are found: this particular method is called when only
     // one or zero matches is expected.
     Lease4Collection collection;
-    getLeaseCollection(stindex, bind, exchange4_, collection, true);
+    getLeaseCollection(connection, stindex, bind, connection.exchange4_,
+                       collection, true);
 
     // Return single record if present, else clear the lease.
     if (collection.empty()) {
@@ -1490,7 +1658,8 @@ void MySqlLeaseMgr::getLease(StatementIndex stindex, MYSQL_BIND* bind,
 }
 
 
-void MySqlLeaseMgr::getLease(StatementIndex stindex, MYSQL_BIND* bind,
+void MySqlLeaseMgr::getLease(MySqlConnection& connection,
+                             StatementIndex stindex, MYSQL_BIND* bind,
                              Lease6Ptr& result) const {
     // Create appropriate collection object and get all leases matching
     // the selection criteria.  The "single" paraeter is true to indicate
@@ -1498,7 +1667,8 @@ void MySqlLeaseMgr::getLease(StatementIndex stindex, MYSQL_BIND* bind,
     // matching records are found: this particular method is called when only
     // one or zero matches is expected.
     Lease6Collection collection;
-    getLeaseCollection(stindex, bind, exchange6_, collection, true);
+    getLeaseCollection(connection, stindex, bind, connection.exchange6_,
+                       collection, true);
 
     // Return single record if present, else clear the lease.
     if (collection.empty()) {
@@ -1516,6 +1686,7 @@ Lease4Ptr
 MySqlLeaseMgr::getLease4(const bundy::asiolink::IOAddress& addr) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_GET_ADDR4).arg(addr.toText());
+    ConnectionPool::Locker connection(pool_);
 
     // Set up the WHERE clause value
     MYSQL_BIND inbind[1];
@@ -1528,7 +1699,7 @@ MySqlLeaseMgr::getLease4(const bundy::asiolink::IOAddress& addr) const {
 
     // Get the data
     Lease4Ptr result;
-    getLease(GET_LEASE4_ADDR, inbind, result);
+    getLease(*connection, GET_LEASE4_ADDR, inbind, result);
 
     return (result);
 }
@@ -1538,6 +1709,7 @@ Lease4Collection
 MySqlLeaseMgr::getLease4(const HWAddr& hwaddr) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_GET_HWADDR).arg(hwaddr.toText());
+    ConnectionPool::Locker connection(pool_);
 
     // Set up the WHERE clause value
     MYSQL_BIND inbind[1];
@@ -1558,7 +1730,7 @@ MySqlLeaseMgr::getLease4(const HWAddr& hwaddr) const {
 
     // Get the data
     Lease4Collection result;
-    getLeaseCollection(GET_LEASE4_HWADDR, inbind, result);
+    getLeaseCollection(*connection, GET_LEASE4_HWADDR, inbind, result);
 
     return (result);
 }
@@ -1569,6 +1741,7 @@ MySqlLeaseMgr::getLease4(const HWAddr& hwaddr, SubnetID subnet_id) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_GET_SUBID_HWADDR)
         .arg(subnet_id).arg(hwaddr.toText());
+    ConnectionPool::Locker connection(pool_);
 
     // Set up the WHERE clause value
     MYSQL_BIND inbind[2];
@@ -1593,7 +1766,7 @@ MySqlLeaseMgr::getLease4(const HWAddr& hwaddr, SubnetID subnet_id) const {
 
     // Get the data
     Lease4Ptr result;
-    getLease(GET_LEASE4_HWADDR_SUBID, inbind, result);
+    getLease(*connection, GET_LEASE4_HWADDR_SUBID, inbind, result);
 
     return (result);
 }
@@ -1603,6 +1776,7 @@ Lease4Collection
 MySqlLeaseMgr::getLease4(const ClientId& clientid) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_GET_CLIENTID).arg(clientid.toText());
+    ConnectionPool::Locker connection(pool_);
 
     // Set up the WHERE clause value
     MYSQL_BIND inbind[1];
@@ -1617,7 +1791,7 @@ MySqlLeaseMgr::getLease4(const ClientId& clientid) const {
 
     // Get the data
     Lease4Collection result;
-    getLeaseCollection(GET_LEASE4_CLIENTID, inbind, result);
+    getLeaseCollection(*connection, GET_LEASE4_CLIENTID, inbind, result);
 
     return (result);
 }
@@ -1637,6 +1811,7 @@ MySqlLeaseMgr::getLease4(const ClientId& clientid, SubnetID subnet_id) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_GET_SUBID_CLIENTID)
               .arg(subnet_id).arg(clientid.toText());
+    ConnectionPool::Locker connection(pool_);
 
     // Set up the WHERE clause value
     MYSQL_BIND inbind[2];
@@ -1655,7 +1830,7 @@ MySqlLeaseMgr::getLease4(const ClientId& clientid, SubnetID subnet_id) const {
 
     // Get the data
     Lease4Ptr result;
-    getLease(GET_LEASE4_CLIENTID_SUBID, inbind, result);
+    getLease(*connection, GET_LEASE4_CLIENTID_SUBID, inbind, result);
 
     return (result);
 }
@@ -1667,6 +1842,7 @@ MySqlLeaseMgr::getLease6(Lease::Type lease_type,
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_GET_ADDR6).arg(addr.toText())
               .arg(lease_type);
+    ConnectionPool::Locker connection(pool_);
 
     // Set up the WHERE clause value
     MYSQL_BIND inbind[2];
@@ -1688,7 +1864,7 @@ MySqlLeaseMgr::getLease6(Lease::Type lease_type,
     inbind[1].is_unsigned = MLM_TRUE;
 
     Lease6Ptr result;
-    getLease(GET_LEASE6_ADDR, inbind, result);
+    getLease(*connection, GET_LEASE6_ADDR, inbind, result);
 
     return (result);
 }
@@ -1700,6 +1876,7 @@ MySqlLeaseMgr::getLeases6(Lease::Type lease_type,
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_GET_IAID_DUID).arg(iaid).arg(duid.toText())
               .arg(lease_type);
+    ConnectionPool::Locker connection(pool_);
 
     // Set up the WHERE clause value
     MYSQL_BIND inbind[3];
@@ -1737,7 +1914,7 @@ MySqlLeaseMgr::getLeases6(Lease::Type lease_type,
 
     // ... and get the data
     Lease6Collection result;
-    getLeaseCollection(GET_LEASE6_DUID_IAID, inbind, result);
+    getLeaseCollection(*connection, GET_LEASE6_DUID_IAID, inbind, result);
 
     return (result);
 }
@@ -1750,6 +1927,7 @@ MySqlLeaseMgr::getLeases6(Lease::Type lease_type,
               DHCPSRV_MYSQL_GET_IAID_SUBID_DUID)
               .arg(iaid).arg(subnet_id).arg(duid.toText())
               .arg(lease_type);
+    ConnectionPool::Locker connection(pool_);
 
     // Set up the WHERE clause value
     MYSQL_BIND inbind[4];
@@ -1782,31 +1960,83 @@ MySqlLeaseMgr::getLeases6(Lease::Type lease_type,
 
     // ... and get the data
     Lease6Collection result;
-    getLeaseCollection(GET_LEASE6_DUID_IAID_SUBID, inbind, result);
+    getLeaseCollection(*connection, GET_LEASE6_DUID_IAID_SUBID, inbind,
+                       result);
 
     return (result);
 }
 
+void
+MySqlLeaseMgr::getExpiredLeases4(Lease4Collection& expired,
+                                 size_t max_leases) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MYSQL_GET_EXPIRED4).arg(max_leases);
+    ConnectionPool::Locker connection(pool_);
+
+    MYSQL_BIND inbind[2];
+    memset(inbind, 0, sizeof(inbind));
+    MYSQL_TIME now;
+    uint64_t limit;
+    bindExpiredParameters(inbind, now, limit, max_leases);
+
+    getLeaseCollection(*connection, GET_LEASE4_EXPIRE, inbind, expired);
+}
+
+void
+MySqlLeaseMgr::getExpiredLeases6(Lease6Collection& expired,
+                                 size_t max_leases) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MYSQL_GET_EXPIRED6).arg(max_leases);
+    ConnectionPool::Locker connection(pool_);
+
+    MYSQL_BIND inbind[2];
+    memset(inbind, 0, sizeof(inbind));
+    MYSQL_TIME now;
+    uint64_t limit;
+    bindExpiredParameters(inbind, now, limit, max_leases);
+
+    getLeaseCollection(*connection, GET_LEASE6_EXPIRE, inbind, expired);
+}
+
+void
+MySqlLeaseMgr::bindExpiredParameters(MYSQL_BIND* inbind, MYSQL_TIME& now,
+                                     uint64_t& limit, size_t max_leases) {
+    // The leases which expired before the current time...
+    convertToDatabaseTime(time(NULL), 0, now);
+    inbind[0].buffer_type = MYSQL_TYPE_TIMESTAMP;
+    inbind[0].buffer = reinterpret_cast<char*>(&now);
+    inbind[0].buffer_length = sizeof(now);
+
+    // ... and at most max_leases of them.
+    limit = (max_leases == 0 ? std::numeric_limits<uint64_t>::max() :
+             max_leases);
+    inbind[1].buffer_type = MYSQL_TYPE_LONGLONG;
+    inbind[1].buffer = reinterpret_cast<char*>(&limit);
+    inbind[1].is_unsigned = MLM_TRUE;
+}
+
 // Update lease methods.  These comprise common code that handles the actual
 // update, and type-specific methods that set up the parameters for the prepared
 // statement depending on the type of lease.
 
 template <typename LeasePtr>
 void
-MySqlLeaseMgr::updateLeaseCommon(StatementIndex stindex, MYSQL_BIND* bind,
+MySqlLeaseMgr::updateLeaseCommon(MySqlConnection& connection,
+                                 StatementIndex stindex, MYSQL_BIND* bind,
                                  const LeasePtr& lease) {
 
     // Bind the parameters to the statement
-    int status = mysql_stmt_bind_param(statements_[stindex], bind);
-    checkError(status, stindex, "unable to bind parameters");
+    int status = mysql_stmt_bind_param(connection.statements_[stindex], bind);
+    checkError(connection, status, stindex, "unable to bind parameters");
 
     // Execute
-    status = mysql_stmt_execute(statements_[stindex]);
-    checkError(status, stindex, "unable to execute");
+    status = mysql_stmt_execute(connection.statements_[stindex]);
+    checkError(connection, status, stindex, "unable to execute");
 
     // See how many rows were affected.  The statement should only update a
     // single row.
-    int affected_rows = mysql_stmt_affected_rows(statements_[stindex]);
+    int affected_rows =
+        mysql_stmt_affected_rows(connection.statements_[stindex]);
     if (affected_rows == 0) {
         bundy_throw(NoSuchLease, "unable to update lease for address " <<
                   lease->addr_ << " as it does not exist");
@@ -1821,13 +2051,15 @@ MySqlLeaseMgr::updateLeaseCommon(StatementIndex stindex, MYSQL_BIND* bind,
 
 void
 MySqlLeaseMgr::updateLease4(const Lease4Ptr& lease) {
+    ConnectionPool::Locker connection(pool_);
     const StatementIndex stindex = UPDATE_LEASE4;
 
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_UPDATE_ADDR4).arg(lease->addr_.toText());
 
     // Create the MYSQL_BIND array for the data being updated
-    std::vector<MYSQL_BIND> bind = exchange4_->createBindForSend(lease);
+    std::vector<MYSQL_BIND> bind =
+        connection->exchange4_->createBindForSend(lease);
 
     // Set up the WHERE clause and append it to the MYSQL_BIND array
     MYSQL_BIND where;
@@ -1840,12 +2072,13 @@ MySqlLeaseMgr::updateLease4(const Lease4Ptr& lease) {
     bind.push_back(where);
 
     // Drop to common update code
-    updateLeaseCommon(stindex, &bind[0], lease);
+    updateLeaseCommon(*connection, stindex, &bind[0], lease);
 }
 
 
 void
 MySqlLeaseMgr::updateLease6(const Lease6Ptr& lease) {
+    ConnectionPool::Locker connection(pool_);
     const StatementIndex stindex = UPDATE_LEASE6;
 
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
@@ -1853,7 +2086,8 @@ MySqlLeaseMgr::updateLease6(const Lease6Ptr& lease) {
               .arg(lease->type_);
 
     // Create the MYSQL_BIND array for the data being updated
-    std::vector<MYSQL_BIND> bind = exchange6_->createBindForSend(lease);
+    std::vector<MYSQL_BIND> bind =
+        connection->exchange6_->createBindForSend(lease);
 
     // Set up the WHERE clause value
     MYSQL_BIND where;
@@ -1871,7 +2105,7 @@ MySqlLeaseMgr::updateLease6(const Lease6Ptr& lease) {
     bind.push_back(where);
 
     // Drop to common update code
-    updateLeaseCommon(stindex, &bind[0], lease);
+    updateLeaseCommon(*connection, stindex, &bind[0], lease);
 }
 
 // Delete lease methods.  Similar to other groups of methods, these comprise
@@ -1880,19 +2114,21 @@ MySqlLeaseMgr::updateLease6(const Lease6Ptr& lease) {
 // handles the common processing.
 
 bool
-MySqlLeaseMgr::deleteLeaseCommon(StatementIndex stindex, MYSQL_BIND* bind) {
+MySqlLeaseMgr::deleteLeaseCommon(MySqlConnection& connection,
+                                 StatementIndex stindex, MYSQL_BIND* bind) {
 
     // Bind the input parameters to the statement
-    int status = mysql_stmt_bind_param(statements_[stindex], bind);
-    checkError(status, stindex, "unable to bind WHERE clause parameter");
+    int status = mysql_stmt_bind_param(connection.statements_[stindex], bind);
+    checkError(connection, status, stindex,
+               "unable to bind WHERE clause parameter");
 
     // Execute
-    status = mysql_stmt_execute(statements_[stindex]);
-    checkError(status, stindex, "unable to execute");
+    status = mysql_stmt_execute(connection.statements_[stindex]);
+    checkError(connection, status, stindex, "unable to execute");
 
     // See how many rows were affected.  Note that the statement may delete
     // multiple rows.
-    return (mysql_stmt_affected_rows(statements_[stindex]) > 0);
+    return (mysql_stmt_affected_rows(connection.statements_[stindex]) > 0);
 }
 
 
@@ -1900,6 +2136,7 @@ bool
 MySqlLeaseMgr::deleteLease(const bundy::asiolink::IOAddress& addr) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_MYSQL_DELETE_ADDR).arg(addr.toText());
+    ConnectionPool::Locker connection(pool_);
 
     // Set up the WHERE clause value
     MYSQL_BIND inbind[1];
@@ -1912,7 +2149,7 @@ MySqlLeaseMgr::deleteLease(const bundy::asiolink::IOAddress& addr) {
         inbind[0].buffer = reinterpret_cast<char*>(&addr4);
         inbind[0].is_unsigned = MLM_TRUE;
 
-        return (deleteLeaseCommon(DELETE_LEASE4, inbind));
+        return (deleteLeaseCommon(*connection, DELETE_LEASE4, inbind));
 
     } else {
         std::string addr6 = addr.toText();
@@ -1925,7 +2162,7 @@ MySqlLeaseMgr::deleteLease(const bundy::asiolink::IOAddress& addr) {
         inbind[0].buffer_length = addr6_length;
         inbind[0].length = &addr6_length;
 
-        return (deleteLeaseCommon(DELETE_LEASE6, inbind));
+        return (deleteLeaseCommon(*connection, DELETE_LEASE6, inbind));
     }
 }
 
@@ -1951,6 +2188,7 @@ MySqlLeaseMgr::getDescription() const {
 
 std::pair<uint32_t, uint32_t>
 MySqlLeaseMgr::getVersion() const {
+    ConnectionPool::Locker connection(pool_);
     const StatementIndex stindex = GET_VERSION;
 
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
@@ -1960,11 +2198,11 @@ MySqlLeaseMgr::getVersion() const {
     uint32_t    minor;      // Minor version number
 
     // Execute the prepared statement
-    int status = mysql_stmt_execute(statements_[stindex]);
+    int status = mysql_stmt_execute(connection->statements_[stindex]);
     if (status != 0) {
         bundy_throw(DbOperationError, "unable to execute <"
                   << text_statements_[stindex] << "> - reason: " <<
-                  mysql_error(mysql_));
+                  mysql_error(connection->mysql_));
     }
 
     // Bind the output of the statement to the appropriate variables.
@@ -1981,19 +2219,19 @@ MySqlLeaseMgr::getVersion() const {
     bind[1].buffer = &minor;
     bind[1].buffer_length = sizeof(minor);
 
-    status = mysql_stmt_bind_result(statements_[stindex], bind);
+    status = mysql_stmt_bind_result(connection->statements_[stindex], bind);
     if (status != 0) {
         bundy_throw(DbOperationError, "unable to bind result set: " <<
-                  mysql_error(mysql_));
+                  mysql_error(connection->mysql_));
     }
 
     // Fetch the data and set up the "release" object to release associated
     // resources when this method exits then retrieve the data.
-    MySqlFreeResult fetch_release(statements_[stindex]);
-    status = mysql_stmt_fetch(statements_[stindex]);
+    MySqlFreeResult fetch_release(connection->statements_[stindex]);
+    status = mysql_stmt_fetch(connection->statements_[stindex]);
     if (status != 0) {
         bundy_throw(DbOperationError, "unable to obtain result set: " <<
-                  mysql_error(mysql_));
+                  mysql_error(connection->mysql_));
     }
 
     return (std::make_pair(major, minor));
@@ -2003,8 +2241,10 @@ MySqlLeaseMgr::getVersion() const {
 void
 MySqlLeaseMgr::commit() {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL, DHCPSRV_MYSQL_COMMIT);
-    if (mysql_commit(mysql_) != 0) {
-        bundy_throw(DbOperationError, "commit failed: " << mysql_error(mysql_));
+    ConnectionPool::Locker connection(pool_);
+    if (mysql_commit(connection->mysql_) != 0) {
+        bundy_throw(DbOperationError, "commit failed: " <<
+                  mysql_error(connection->mysql_));
     }
 }
 
@@ -2012,8 +2252,10 @@ MySqlLeaseMgr::commit() {
 void
 MySqlLeaseMgr::rollback() {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL, DHCPSRV_MYSQL_ROLLBACK);
-    if (mysql_rollback(mysql_) != 0) {
-        bundy_throw(DbOperationError, "rollback failed: " << mysql_error(mysql_));
+    ConnectionPool::Locker connection(pool_);
+    if (mysql_rollback(connection->mysql_) != 0) {
+        bundy_throw(DbOperationError, "rollback failed: " <<
+                  mysql_error(connection->mysql_));
     }
 }
 
@@ -16,6 +16,7 @@
 #define MYSQL_LEASE_MGR_H
 
 #include <dhcp/hwaddr.h>
+#include <dhcpsrv/db_connection_pool.h>
 #include <dhcpsrv/lease_mgr.h>
 
 #include <boost/scoped_ptr.hpp>
@@ -54,13 +55,13 @@ public:
 
     /// @brief Destructor
     ///
-    /// Frees up resources allocated by the initialization of MySql.
+    /// Closes the connection.  The library itself is released by the lease
+    /// manager, once all its connections are closed (and no other thread
+    /// uses the library).
     ~MySqlHolder() {
         if (mysql_ != NULL) {
             mysql_close(mysql_);
         }
-        // The library itself shouldn't be needed anymore
-        mysql_library_end();
     }
 
     /// @brief Conversion Operator
@@ -86,12 +87,51 @@ const uint32_t CURRENT_VERSION_MINOR = 0;
 class MySqlLease4Exchange;
 class MySqlLease6Exchange;
 
+/// @brief A connection to the MySQL database
+///
+/// The prepared statements belong to the connection they were prepared on,
+/// so they are held here along with the exchange objects, and the
+/// connections of the pool can be used in parallel.
+struct MySqlConnection : public boost::noncopyable {
+    /// @brief Constructor, creates the exchange objects.
+    ///
+    /// @throw DbOpenError Unable to initialize MySql handle.
+    MySqlConnection();
+
+    /// @brief Destructor, frees the prepared statements.
+    ///
+    /// The connection is closed by the destructor of the holder.
+    ~MySqlConnection();
+
+    /// @brief Prepares the calling thread for the use of the library.
+    ///
+    /// Called by the pool before the thread takes a connection.  The MySQL
+    /// client library must be initialized in each thread using it: this is
+    /// done on the first call in a thread, and the library is released by
+    /// the thread when it exits.
+    ///
+    /// @throw DbOperationError Unable to initialize the thread.
+    static void initThread();
+
+    MySqlHolder mysql_;                         ///< MySQL context
+    std::vector<MYSQL_STMT*> statements_;       ///< Prepared statements
+
+    /// The exchange objects are used for transfer of data to/from the
+    /// database.
+    boost::scoped_ptr<MySqlLease4Exchange> exchange4_; ///< Exchange object
+    boost::scoped_ptr<MySqlLease6Exchange> exchange6_; ///< Exchange object
+};
+
 
 /// @brief MySQL Lease Manager
 ///
 /// This class provides the \ref bundy::dhcp::LeaseMgr interface to the MySQL
 /// database.  Use of this backend presupposes that a MySQL database is
 /// available and that the Kea schema has been created within it.
+///
+/// The backend opens a pool of connections to the database.  Each call
+/// uses one connection of the pool, so as many calls run in parallel as
+/// there are connections.
 
 class MySqlLeaseMgr : public LeaseMgr {
 public:
@@ -103,6 +143,11 @@ public:
     /// - host - Host to which to connect (optional, defaults to "localhost")
     /// - user - Username under which to connect (optional)
     /// - password - Password for "user" on the database (optional)
+    /// - connections - Number of the connections to open (optional,
+    ///   defaults to 1)
+    /// - async-commit - Only "false" is accepted: MySQL has no per-session
+    ///   asynchronous commit, set innodb_flush_log_at_trx_commit on the
+    ///   server instead.
     ///
     /// If the database is successfully opened, the version number in the
     /// schema_version table will be checked against hard-coded value in
@@ -117,6 +162,7 @@ public:
     /// @throw bundy::dhcp::DbOpenError Error opening the database
     /// @throw bundy::dhcp::DbOperationError An operation on the open database has
     ///        failed.
+    /// @throw bundy::BadValue Invalid value of a parameter.
     MySqlLeaseMgr(const ParameterMap& parameters);
 
     /// @brief Destructor (closes database)
@@ -314,6 +360,32 @@ public:
     virtual Lease6Collection getLeases6(Lease::Type type, const DUID& duid,
                                         uint32_t iaid, SubnetID subnet_id) const;
 
+    /// @brief Returns the expired IPv4 leases.
+    ///
+    /// The leases are selected using the index on the expire column.
+    ///
+    /// @param [out] expired Collection the expired leases are appended to.
+    /// @param max_leases Maximum number of the leases returned, 0 for all.
+    ///
+    /// @throw bundy::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    virtual void getExpiredLeases4(Lease4Collection& expired,
+                                   size_t max_leases) const;
+
+    /// @brief Returns the expired IPv6 leases.
+    ///
+    /// The leases are selected using the index on the expire column.
+    ///
+    /// @param [out] expired Collection the expired leases are appended to.
+    /// @param max_leases Maximum number of the leases returned, 0 for all.
+    ///
+    /// @throw bundy::BadValue record retrieved from database had an invalid
+    ///        lease type field.
+    /// @throw bundy::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    virtual void getExpiredLeases6(Lease6Collection& expired,
+                                   size_t max_leases) const;
+
     /// @brief Updates IPv4 lease.
     ///
     /// Updates the record of the lease in the database (as identified by the
@@ -458,11 +530,13 @@ public:
         GET_LEASE4_ADDR,            // Get lease4 by address
         GET_LEASE4_CLIENTID,        // Get lease4 by client ID
         GET_LEASE4_CLIENTID_SUBID,  // Get lease4 by client ID & subnet ID
+        GET_LEASE4_EXPIRE,          // Get expired lease4
         GET_LEASE4_HWADDR,          // Get lease4 by HW address
         GET_LEASE4_HWADDR_SUBID,    // Get lease4 by HW address & subnet ID
         GET_LEASE6_ADDR,            // Get lease6 by address
         GET_LEASE6_DUID_IAID,       // Get lease6 by DUID and IAID
         GET_LEASE6_DUID_IAID_SUBID, // Get lease6 by DUID, IAID and subnet ID
+        GET_LEASE6_EXPIRE,          // Get expired lease6
         GET_VERSION,                // Obtain version number
         INSERT_LEASE4,              // Add entry to lease4 table
         INSERT_LEASE6,              // Add entry to lease6 table
@@ -471,12 +545,21 @@ public:
         NUM_STATEMENTS              // Number of statements
     };
 
+    /// @brief Returns the number of the connections to the database.
+    size_t getConnectionCount() const {
+        return (pool_.size());
+    }
+
 private:
+    /// @brief The pool of the connections
+    typedef DbConnectionPool<MySqlConnection> ConnectionPool;
+
     /// @brief Prepare Single Statement
     ///
     /// Creates a prepared statement from the text given and adds it to the
-    /// statements_ vector at the given index.
+    /// statements_ vector of the connection at the given index.
     ///
+    /// @param connection The connection to prepare the statement on
     /// @param index Index into the statements_ vector into which the text
     ///        should be placed.  The vector must be big enough for the index
     ///        to be valid, else an exception will be thrown.
@@ -485,27 +568,32 @@ private:
     /// @throw bundy::dhcp::DbOperationError An operation on the open database has
     ///        failed.
     /// @throw bundy::InvalidParameter 'index' is not valid for the vector.
-    void prepareStatement(StatementIndex index, const char* text);
+    void prepareStatement(MySqlConnection& connection, StatementIndex index,
+                          const char* text);
 
     /// @brief Prepare statements
     ///
     /// Creates the prepared statements for all of the SQL statements used
     /// by the MySQL backend.
     ///
+    /// @param connection The connection to prepare the statements on
+    ///
     /// @throw bundy::dhcp::DbOperationError An operation on the open database has
     ///        failed.
     /// @throw bundy::InvalidParameter 'index' is not valid for the vector.  This
     ///        represents an internal error within the code.
-    void prepareStatements();
+    void prepareStatements(MySqlConnection& connection);
 
     /// @brief Open Database
     ///
     /// Opens the database using the information supplied in the parameters
     /// passed to the constructor.
     ///
+    /// @param connection The connection to open
+    ///
     /// @throw NoDatabaseName Mandatory database name not given
     /// @throw DbOpenError Error opening the database
-    void openDatabase();
+    void openDatabase(MySqlConnection& connection);
 
     /// @brief Add Lease Common Code
     ///
@@ -513,6 +601,7 @@ private:
     /// of the addLease method.  It binds the contents of the lease object to
     /// the prepared statement and adds it to the database.
     ///
+    /// @param connection Connection to use
     /// @param stindex Index of statemnent being executed
     /// @param bind MYSQL_BIND array that has been created for the type
     ///        of lease in question.
@@ -522,13 +611,15 @@ private:
     ///
     /// @throw bundy::dhcp::DbOperationError An operation on the open database has
     ///        failed.
-    bool addLeaseCommon(StatementIndex stindex, std::vector<MYSQL_BIND>& bind);
+    bool addLeaseCommon(MySqlConnection& connection, StatementIndex stindex,
+                        std::vector<MYSQL_BIND>& bind);
 
     /// @brief Get Lease Collection Common Code
     ///
     /// This method performs the common actions for obtaining multiple leases
     /// from the database.
     ///
+    /// @param connection Connection to use
     /// @param stindex Index of statement being executed
     /// @param bind MYSQL_BIND array for input parameters
     /// @param exchange Exchange object to use
@@ -545,7 +636,8 @@ private:
     /// @throw bundy::dhcp::MultipleRecords Multiple records were retrieved
     ///        from the database where only one was expected.
     template <typename Exchange, typename LeaseCollection>
-    void getLeaseCollection(StatementIndex stindex, MYSQL_BIND* bind,
+    void getLeaseCollection(MySqlConnection& connection,
+                            StatementIndex stindex, MYSQL_BIND* bind,
                             Exchange& exchange, LeaseCollection& result,
                             bool single = false) const;
 
@@ -554,6 +646,7 @@ private:
     /// Gets a collection of Lease4 objects.  This is just an interface to
     /// the get lease collection common code.
     ///
+    /// @param connection Connection to use
     /// @param stindex Index of statement being executed
     /// @param bind MYSQL_BIND array for input parameters
     /// @param lease LeaseCollection object returned.  Note that any leases in
@@ -565,9 +658,11 @@ private:
     ///        failed.
     /// @throw bundy::dhcp::MultipleRecords Multiple records were retrieved
     ///        from the database where only one was expected.
-    void getLeaseCollection(StatementIndex stindex, MYSQL_BIND* bind,
+    void getLeaseCollection(MySqlConnection& connection,
+                            StatementIndex stindex, MYSQL_BIND* bind,
                             Lease4Collection& result) const {
-        getLeaseCollection(stindex, bind, exchange4_, result);
+        getLeaseCollection(connection, stindex, bind, connection.exchange4_,
+                           result);
     }
 
     /// @brief Get Lease Collection
@@ -575,6 +670,7 @@ private:
     /// Gets a collection of Lease6 objects.  This is just an interface to
     /// the get lease collection common code.
     ///
+    /// @param connection Connection to use
     /// @param stindex Index of statement being executed
     /// @param bind MYSQL_BIND array for input parameters
     /// @param lease LeaseCollection object returned.  Note that any existing
@@ -585,9 +681,11 @@ private:
     ///        failed.
     /// @throw bundy::dhcp::MultipleRecords Multiple records were retrieved
     ///        from the database where only one was expected.
-    void getLeaseCollection(StatementIndex stindex, MYSQL_BIND* bind,
+    void getLeaseCollection(MySqlConnection& connection,
+                            StatementIndex stindex, MYSQL_BIND* bind,
                             Lease6Collection& result) const {
-        getLeaseCollection(stindex, bind, exchange6_, result);
+        getLeaseCollection(connection, stindex, bind, connection.exchange6_,
+                           result);
     }
 
     /// @brief Get Lease4 Common Code
@@ -596,11 +694,12 @@ private:
     /// methods.  It acts as an interface to the getLeaseCollection() method,
     /// but retrieveing only a single lease.
     ///
+    /// @param connection Connection to use
     /// @param stindex Index of statement being executed
     /// @param bind MYSQL_BIND array for input parameters
     /// @param lease Lease4 object returned
-    void getLease(StatementIndex stindex, MYSQL_BIND* bind,
-                  Lease4Ptr& result) const;
+    void getLease(MySqlConnection& connection, StatementIndex stindex,
+                  MYSQL_BIND* bind, Lease4Ptr& result) const;
 
     /// @brief Get Lease6 Common Code
     ///
@@ -608,11 +707,22 @@ private:
     /// methods.  It acts as an interface to the getLeaseCollection() method,
     /// but retrieveing only a single lease.
     ///
+    /// @param connection Connection to use
     /// @param stindex Index of statement being executed
     /// @param bind MYSQL_BIND array for input parameters
     /// @param lease Lease6 object returned
-    void getLease(StatementIndex stindex, MYSQL_BIND* bind,
-                   Lease6Ptr& result) const;
+    void getLease(MySqlConnection& connection, StatementIndex stindex,
+                  MYSQL_BIND* bind, Lease6Ptr& result) const;
+
+    /// @brief Sets up the parameters selecting the expired leases
+    ///
+    /// @param inbind MYSQL_BIND array of the two parameters
+    /// @param now Storage for the current time, bound to the first one
+    /// @param limit Storage for the maximum number of the leases, bound
+    ///        to the second one
+    /// @param max_leases Maximum number of the leases, 0 for all
+    static void bindExpiredParameters(MYSQL_BIND* inbind, MYSQL_TIME& now,
+                                      uint64_t& limit, size_t max_leases);
 
     /// @brief Update lease common code
     ///
@@ -620,6 +730,7 @@ private:
     /// to the prepared statement, executes it, then checks how many rows
     /// were affected.
     ///
+    /// @param connection Connection to use
     /// @param stindex Index of prepared statement to be executed
     /// @param bind Array of MYSQL_BIND objects representing the parameters.
     ///        (Note that the number is determined by the number of parameters
@@ -631,7 +742,8 @@ private:
     /// @throw bundy::dhcp::DbOperationError An operation on the open database has
     ///        failed.
     template <typename LeasePtr>
-    void updateLeaseCommon(StatementIndex stindex, MYSQL_BIND* bind,
+    void updateLeaseCommon(MySqlConnection& connection,
+                           StatementIndex stindex, MYSQL_BIND* bind,
                            const LeasePtr& lease);
 
     /// @brief Delete lease common code
@@ -640,6 +752,7 @@ private:
     /// to the prepared statement, executes the statement and checks to
     /// see how many rows were deleted.
     ///
+    /// @param connection Connection to use
     /// @param stindex Index of prepared statement to be executed
     /// @param bind Array of MYSQL_BIND objects representing the parameters.
     ///        (Note that the number is determined by the number of parameters
@@ -650,7 +763,8 @@ private:
     ///
     /// @throw bundy::dhcp::DbOperationError An operation on the open database has
     ///        failed.
-    bool deleteLeaseCommon(StatementIndex stindex, MYSQL_BIND* bind);
+    bool deleteLeaseCommon(MySqlConnection& connection,
+                           StatementIndex stindex, MYSQL_BIND* bind);
 
     /// @brief Check Error and Throw Exception
     ///
@@ -658,33 +772,29 @@ private:
     /// indicates an error.  This inline function conceals a lot of error
     /// checking/exception-throwing code.
     ///
+    /// @param connection Connection the statement was run on
     /// @param status Status code: non-zero implies an error
     /// @param index Index of statement that caused the error
     /// @param what High-level description of the error
     ///
     /// @throw bundy::dhcp::DbOperationError An operation on the open database has
     ///        failed.
-    inline void checkError(int status, StatementIndex index,
-                           const char* what) const {
+    inline void checkError(const MySqlConnection& connection, int status,
+                           StatementIndex index, const char* what) const {
         if (status != 0) {
             bundy_throw(DbOperationError, what << " for <" <<
                       text_statements_[index] << ">, reason: " <<
-                      mysql_error(mysql_) << " (error code " <<
-                      mysql_errno(mysql_) << ")");
+                      mysql_error(connection.mysql_) << " (error code " <<
+                      mysql_errno(connection.mysql_) << ")");
         }
     }
 
     // Members
 
-    /// The exchange objects are used for transfer of data to/from the database.
-    /// They are pointed-to objects as the contents may change in "const" calls,
-    /// while the rest of this object does not.  (At alternative would be to
-    /// declare them as "mutable".)
-    boost::scoped_ptr<MySqlLease4Exchange> exchange4_; ///< Exchange object
-    boost::scoped_ptr<MySqlLease6Exchange> exchange6_; ///< Exchange object
-    MySqlHolder mysql_;
-    std::vector<MYSQL_STMT*> statements_;       ///< Prepared statements
     std::vector<std::string> text_statements_;  ///< Raw text of statements
+
+    /// The connections are taken from the pool in "const" calls as well.
+    mutable ConnectionPool pool_;
 };
 
 }; // end of bundy::dhcp namespace
@@ -24,6 +24,7 @@
 
 #include <iostream>
 #include <iomanip>
+#include <limits>
 #include <sstream>
 #include <string>
 #include <time.h>
@@ -92,6 +93,14 @@ TaggedStatement tagged_statements[] = {
      "valid_lifetime, extract(epoch from expire)::bigint, subnet_id, fqdn_fwd, fqdn_rev, hostname "
      "FROM lease4 "
      "WHERE client_id = $1 AND subnet_id = $2"},
+    {PgSqlLeaseMgr::GET_LEASE4_EXPIRE, 2,
+        { 20, 20 },
+        "get_lease4_expire",
+     "SELECT address, hwaddr, client_id, "
+     "valid_lifetime, extract(epoch from expire)::bigint, subnet_id, fqdn_fwd, fqdn_rev, hostname "
+     "FROM lease4 "
+     "WHERE expire < to_timestamp($1) "
+     "ORDER BY expire LIMIT $2"},
     {PgSqlLeaseMgr::GET_LEASE4_HWADDR, 1,
          { 17 },
          "get_lease4_hwaddr",
@@ -130,6 +139,15 @@ TaggedStatement tagged_statements[] = {
      "lease_type, iaid, prefix_len, fqdn_fwd, fqdn_rev, hostname "
      "FROM lease6 "
      "WHERE lease_type = $1 AND duid = $2 AND iaid = $3 AND subnet_id = $4"},
+    {PgSqlLeaseMgr::GET_LEASE6_EXPIRE, 2,
+        { 20, 20 },
+        "get_lease6_expire",
+     "SELECT address, duid, valid_lifetime, "
+     "extract(epoch from expire)::bigint, subnet_id, pref_lifetime, "
+     "lease_type, iaid, prefix_len, fqdn_fwd, fqdn_rev, hostname "
+     "FROM lease6 "
+     "WHERE expire < to_timestamp($1) "
+     "ORDER BY expire LIMIT $2"},
     {PgSqlLeaseMgr::GET_VERSION, 0,
         { 0 },
      "get_version",
@@ -569,14 +587,12 @@ private:
     unsigned long   duid_length_;
 };
 
-PgSqlLeaseMgr::PgSqlLeaseMgr(const LeaseMgr::ParameterMap& parameters)
-    : LeaseMgr(parameters), exchange4_(new PgSqlLease4Exchange()),
-    exchange6_(new PgSqlLease6Exchange()), conn_(NULL) {
-    openDatabase();
-    prepareStatements();
+PgSqlConnection::PgSqlConnection()
+    : conn_(NULL), exchange4_(new PgSqlLease4Exchange()),
+      exchange6_(new PgSqlLease6Exchange()) {
 }
 
-PgSqlLeaseMgr::~PgSqlLeaseMgr() {
+PgSqlConnection::~PgSqlConnection() {
     if (conn_) {
         // Deallocate the prepared queries.
         PGresult* r = PQexec(conn_, "DEALLOCATE all");
@@ -592,13 +608,48 @@ PgSqlLeaseMgr::~PgSqlLeaseMgr() {
     }
 }
 
-void PgSqlLeaseMgr::prepareStatements() {
+PgSqlLeaseMgr::PgSqlLeaseMgr(const LeaseMgr::ParameterMap& parameters)
+    : LeaseMgr(parameters) {
+    string connections;
+    try {
+        connections = getParameter("connections");
+    } catch (...) {
+        // No pool size. Fine, we'll open a single connection
+    }
+    const size_t pool_size = ConnectionPool::parseSize(connections);
+
+    string async_commit_value;
+    try {
+        async_commit_value = getParameter("async-commit");
+    } catch (...) {
+        // No async-commit. Fine, the commits are synchronous
+    }
+    if (!async_commit_value.empty() && (async_commit_value != "true") &&
+        (async_commit_value != "false")) {
+        bundy_throw(BadValue, "invalid value 'async-commit="
+                  << async_commit_value << "'");
+    }
+    const bool async_commit = (async_commit_value == "true");
+
+    for (size_t i = 0; i < pool_size; ++i) {
+        ConnectionPool::ConnectionPtr connection(new PgSqlConnection());
+        openDatabase(*connection, async_commit);
+        prepareStatements(*connection);
+        pool_.add(connection);
+    }
+}
+
+PgSqlLeaseMgr::~PgSqlLeaseMgr() {
+    // The connections are closed by the destructor of the pool.
+}
+
+void PgSqlLeaseMgr::prepareStatements(PgSqlConnection& connection) {
     statements_.clear();
     statements_.resize(NUM_STATEMENTS, PgSqlStatementBind());
 
     for(int i = 0; tagged_statements[i].text != NULL; ++ i) {
         // Prepare all statements queries with all known fields datatype
-        PGresult* r = PQprepare(conn_, tagged_statements[i].name,
+        PGresult* r = PQprepare(connection.conn_, tagged_statements[i].name,
                                 tagged_statements[i].text,
                                 tagged_statements[i].nbparams,
                                 tagged_statements[i].types);
@@ -608,7 +659,7 @@ void PgSqlLeaseMgr::prepareStatements() {
             bundy_throw(DbOperationError,
                       "unable to prepare PostgreSQL statement: "
                       << tagged_statements[i].text << ", reason: "
-                      << PQerrorMessage(conn_));
+                      << PQerrorMessage(connection.conn_));
         }
 
         statements_[i].stmt_name = tagged_statements[i].name;
@@ -618,7 +669,7 @@ void PgSqlLeaseMgr::prepareStatements() {
 }
 
 void
-PgSqlLeaseMgr::openDatabase() {
+PgSqlLeaseMgr::openDatabase(PgSqlConnection& connection, bool async_commit) {
     string dbconnparameters;
     string shost = "localhost";
     try {
@@ -654,37 +705,52 @@ PgSqlLeaseMgr::openDatabase() {
         bundy_throw(NoDatabaseName, "must specify a name for the database");
     }
 
-    conn_ = PQconnectdb(dbconnparameters.c_str());
-    if (conn_ == NULL) {
+    PGconn* conn = PQconnectdb(dbconnparameters.c_str());
+    if (conn == NULL) {
         bundy_throw(DbOpenError, "could not allocate connection object");
     }
 
-    if (PQstatus(conn_) != CONNECTION_OK) {
+    if (PQstatus(conn) != CONNECTION_OK) {
         // If we have a connection object, we have to call finish
         // to release it, but grab the error message first.
-        std::string error_message = PQerrorMessage(conn_);
-        PQfinish(conn_);
-        conn_ = NULL;
+        std::string error_message = PQerrorMessage(conn);
+        PQfinish(conn);
         bundy_throw(DbOpenError, error_message);
     }
+    connection.conn_ = conn;
+
+    if (async_commit) {
+        // The commit returns before the transaction is flushed to the disk,
+        // the server flushes the transactions of all the connections
+        // together shortly after.
+        PGresult* r = PQexec(conn, "SET synchronous_commit TO OFF");
+        if (PQresultStatus(r) != PGRES_COMMAND_OK) {
+            PQclear(r);
+            bundy_throw(DbOpenError, "unable to set the asynchronous commit: "
+                      << PQerrorMessage(conn));
+        }
+        PQclear(r);
+    }
 }
 
 bool
-PgSqlLeaseMgr::addLeaseCommon(StatementIndex stindex,
+PgSqlLeaseMgr::addLeaseCommon(PgSqlConnection& connection,
+                              StatementIndex stindex,
                               BindParams& params) {
     vector<const char *> out_values;
     vector<int> out_lengths;
     vector<int> out_formats;
     convertToQuery(params, out_values, out_lengths, out_formats);
 
-    PGresult * r = PQexecPrepared(conn_, statements_[stindex].stmt_name,
+    PGresult * r = PQexecPrepared(connection.conn_,
+                                  statements_[stindex].stmt_name,
                                   statements_[stindex].stmt_nbparams,
                                   &out_values[0], &out_lengths[0],
                                   &out_formats[0], 0);
 
     int s = PQresultStatus(r);
     if (s != PGRES_COMMAND_OK) {
-        const char * errorMsg = PQerrorMessage(conn_);
+        const char * errorMsg = PQerrorMessage(connection.conn_);
         PQclear(r);
 
         /// @todo - ok, do we have to rely on error message text??
@@ -709,22 +775,25 @@ bool
 PgSqlLeaseMgr::addLease(const Lease4Ptr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_ADD_ADDR4).arg(lease->addr_.toText());
-    BindParams params = exchange4_->createBindForSend(lease);
+    ConnectionPool::Locker connection(pool_);
+    BindParams params = connection->exchange4_->createBindForSend(lease);
 
-    return (addLeaseCommon(INSERT_LEASE4, params));
+    return (addLeaseCommon(*connection, INSERT_LEASE4, params));
 }
 
 bool
 PgSqlLeaseMgr::addLease(const Lease6Ptr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_ADD_ADDR6).arg(lease->addr_.toText());
-    BindParams params = exchange6_->createBindForSend(lease);
+    ConnectionPool::Locker connection(pool_);
+    BindParams params = connection->exchange6_->createBindForSend(lease);
 
-    return (addLeaseCommon(INSERT_LEASE6, params));
+    return (addLeaseCommon(*connection, INSERT_LEASE6, params));
 }
 
 template <typename Exchange, typename LeaseCollection>
-void PgSqlLeaseMgr::getLeaseCollection(StatementIndex stindex,
+void PgSqlLeaseMgr::getLeaseCollection(PgSqlConnection& connection,
+                                       StatementIndex stindex,
                                        BindParams & params,
                                        Exchange& exchange,
                                        LeaseCollection& result,
@@ -737,11 +806,12 @@ void PgSqlLeaseMgr::getLeaseCollection(StatementIndex stindex,
     vector<int> out_formats;
     convertToQuery(params, out_values, out_lengths, out_formats);
 
-    PGresult* r = PQexecPrepared(conn_, statements_[stindex].stmt_name,
+    PGresult* r = PQexecPrepared(connection.conn_,
+                       statements_[stindex].stmt_name,
                        statements_[stindex].stmt_nbparams, &out_values[0],
                        &out_lengths[0], &out_formats[0], 0);
 
-    checkStatementError(r, stindex);
+    checkStatementError(connection, r, stindex);
 
     int lines = PQntuples(r);
     if (single && lines > 1) {
@@ -759,15 +829,16 @@ void PgSqlLeaseMgr::getLeaseCollection(StatementIndex stindex,
 }
 
 void
-PgSqlLeaseMgr::getLease(StatementIndex stindex, BindParams & params,
-                             Lease4Ptr& result) const {
+PgSqlLeaseMgr::getLease(PgSqlConnection& connection, StatementIndex stindex,
+                        BindParams & params, Lease4Ptr& result) const {
     // Create appropriate collection object and get all leases matching
     // the selection criteria.  The "single" paraeter is true to indicate
     // that the called method should throw an exception if multiple
     // matching records are found: this particular method is called when only
     // one or zero matches is expected.
     Lease4Collection collection;
-    getLeaseCollection(stindex, params, exchange4_, collection, true);
+    getLeaseCollection(connection, stindex, params, connection.exchange4_,
+                       collection, true);
 
     // Return single record if present, else clear the lease.
     if (collection.empty()) {
@@ -778,15 +849,16 @@ PgSqlLeaseMgr::getLease(StatementIndex stindex, BindParams & params,
 }
 
 void
-PgSqlLeaseMgr::getLease(StatementIndex stindex, BindParams & params,
-                             Lease6Ptr& result) const {
+PgSqlLeaseMgr::getLease(PgSqlConnection& connection, StatementIndex stindex,
+                        BindParams & params, Lease6Ptr& result) const {
     // Create appropriate collection object and get all leases matching
     // the selection criteria.  The "single" paraeter is true to indicate
     // that the called method should throw an exception if multiple
     // matching records are found: this particular method is called when only
     // one or zero matches is expected.
     Lease6Collection collection;
-    getLeaseCollection(stindex, params, exchange6_, collection, true);
+    getLeaseCollection(connection, stindex, params, connection.exchange6_,
+                       collection, true);
 
     // Return single record if present, else clear the lease.
     if (collection.empty()) {
@@ -800,6 +872,7 @@ Lease4Ptr
 PgSqlLeaseMgr::getLease4(const bundy::asiolink::IOAddress& addr) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_GET_ADDR4).arg(addr.toText());
+    ConnectionPool::Locker connection(pool_);
 
     // Set up the WHERE clause value
     BindParams inparams;
@@ -810,7 +883,7 @@ PgSqlLeaseMgr::getLease4(const bundy::asiolink::IOAddress& addr) const {
 
     // Get the data
     Lease4Ptr result;
-    getLease(GET_LEASE4_ADDR, inparams, result);
+    getLease(*connection, GET_LEASE4_ADDR, inparams, result);
 
     return (result);
 }
@@ -819,6 +892,7 @@ Lease4Collection
 PgSqlLeaseMgr::getLease4(const HWAddr& hwaddr) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_GET_HWADDR).arg(hwaddr.toText());
+    ConnectionPool::Locker connection(pool_);
 
     // Set up the WHERE clause value
     BindParams inparams;
@@ -831,7 +905,7 @@ PgSqlLeaseMgr::getLease4(const HWAddr& hwaddr) const {
 
     // Get the data
     Lease4Collection result;
-    getLeaseCollection(GET_LEASE4_HWADDR, inparams, result);
+    getLeaseCollection(*connection, GET_LEASE4_HWADDR, inparams, result);
 
     return (result);
 }
@@ -841,6 +915,7 @@ PgSqlLeaseMgr::getLease4(const HWAddr& hwaddr, SubnetID subnet_id) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_GET_SUBID_HWADDR)
               .arg(subnet_id).arg(hwaddr.toText());
+    ConnectionPool::Locker connection(pool_);
 
     // Set up the WHERE clause value
     BindParams inparams;
@@ -857,7 +932,7 @@ PgSqlLeaseMgr::getLease4(const HWAddr& hwaddr, SubnetID subnet_id) const {
 
     // Get the data
     Lease4Ptr result;
-    getLease(GET_LEASE4_HWADDR_SUBID, inparams, result);
+    getLease(*connection, GET_LEASE4_HWADDR_SUBID, inparams, result);
 
     return (result);
 }
@@ -866,6 +941,7 @@ Lease4Collection
 PgSqlLeaseMgr::getLease4(const ClientId& clientid) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_GET_CLIENTID).arg(clientid.toText());
+    ConnectionPool::Locker connection(pool_);
 
     // Set up the WHERE clause value
     BindParams inparams;
@@ -875,7 +951,7 @@ PgSqlLeaseMgr::getLease4(const ClientId& clientid) const {
 
     // Get the data
     Lease4Collection result;
-    getLeaseCollection(GET_LEASE4_CLIENTID, inparams, result);
+    getLeaseCollection(*connection, GET_LEASE4_CLIENTID, inparams, result);
 
     return (result);
 }
@@ -885,6 +961,7 @@ PgSqlLeaseMgr::getLease4(const ClientId& clientid, SubnetID subnet_id) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_GET_SUBID_CLIENTID)
               .arg(subnet_id).arg(clientid.toText());
+    ConnectionPool::Locker connection(pool_);
 
     // Set up the WHERE clause value
     BindParams inparams;
@@ -898,7 +975,7 @@ PgSqlLeaseMgr::getLease4(const ClientId& clientid, SubnetID subnet_id) const {
 
     // Get the data
     Lease4Ptr result;
-    getLease(GET_LEASE4_CLIENTID_SUBID, inparams, result);
+    getLease(*connection, GET_LEASE4_CLIENTID_SUBID, inparams, result);
 
     return (result);
 }
@@ -918,6 +995,7 @@ PgSqlLeaseMgr::getLease6(Lease::Type lease_type,
                          const bundy::asiolink::IOAddress& addr) const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL, DHCPSRV_PGSQL_GET_ADDR6)
               .arg(addr.toText()).arg(lease_type);
+    ConnectionPool::Locker connection(pool_);
 
     // Set up the WHERE clause value
     BindParams inparams;
@@ -932,7 +1010,7 @@ PgSqlLeaseMgr::getLease6(Lease::Type lease_type,
 
     // ... and get the data
     Lease6Ptr result;
-    getLease(GET_LEASE6_ADDR, inparams, result);
+    getLease(*connection, GET_LEASE6_ADDR, inparams, result);
 
     return (result);
 }
@@ -943,6 +1021,7 @@ PgSqlLeaseMgr::getLeases6(Lease::Type type, const DUID& duid,
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_GET_IAID_DUID)
               .arg(iaid).arg(duid.toText()).arg(type);
+    ConnectionPool::Locker connection(pool_);
 
     // Set up the WHERE clause value
     BindParams inparams;
@@ -963,7 +1042,7 @@ PgSqlLeaseMgr::getLeases6(Lease::Type type, const DUID& duid,
 
     // ... and get the data
     Lease6Collection result;
-    getLeaseCollection(GET_LEASE6_DUID_IAID, inparams, result);
+    getLeaseCollection(*connection, GET_LEASE6_DUID_IAID, inparams, result);
 
     return (result);
 }
@@ -974,6 +1053,7 @@ PgSqlLeaseMgr::getLeases6(Lease::Type lease_type, const DUID& duid,
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_GET_IAID_SUBID_DUID)
               .arg(iaid).arg(subnet_id).arg(duid.toText()).arg(lease_type);
+    ConnectionPool::Locker connection(pool_);
 
     // Set up the WHERE clause value
     BindParams inparams;
@@ -1002,14 +1082,60 @@ PgSqlLeaseMgr::getLeases6(Lease::Type lease_type, const DUID& duid,
 
     // ... and get the data
     Lease6Collection result;
-    getLeaseCollection(GET_LEASE6_DUID_IAID_SUBID, inparams, result);
+    getLeaseCollection(*connection, GET_LEASE6_DUID_IAID_SUBID, inparams, result);
 
     return (result);
 }
 
+void
+PgSqlLeaseMgr::getExpiredLeases4(Lease4Collection& expired,
+                                 size_t max_leases) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_PGSQL_GET_EXPIRED4).arg(max_leases);
+    ConnectionPool::Locker connection(pool_);
+
+    BindParams inparams;
+    setExpiredParameters(inparams, max_leases);
+
+    getLeaseCollection(*connection, GET_LEASE4_EXPIRE, inparams, expired);
+}
+
+void
+PgSqlLeaseMgr::getExpiredLeases6(Lease6Collection& expired,
+                                 size_t max_leases) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_PGSQL_GET_EXPIRED6).arg(max_leases);
+    ConnectionPool::Locker connection(pool_);
+
+    BindParams inparams;
+    setExpiredParameters(inparams, max_leases);
+
+    getLeaseCollection(*connection, GET_LEASE6_EXPIRE, inparams, expired);
+}
+
+void
+PgSqlLeaseMgr::setExpiredParameters(BindParams& params, size_t max_leases) {
+    // The leases which expired before the current time, in seconds since
+    // the epoch...
+    ostringstream tmp;
+    tmp << static_cast<int64_t>(time(NULL));
+    params.push_back(PgSqlParam(tmp.str()));
+    tmp.str("");
+    tmp.clear();
+
+    // ... and at most max_leases of them.
+    if (max_leases == 0) {
+        tmp << std::numeric_limits<int64_t>::max();
+    } else {
+        tmp << static_cast<uint64_t>(max_leases);
+    }
+    params.push_back(PgSqlParam(tmp.str()));
+}
+
 template <typename LeasePtr>
 void
-PgSqlLeaseMgr::updateLeaseCommon(StatementIndex stindex, BindParams & params,
+PgSqlLeaseMgr::updateLeaseCommon(PgSqlConnection& connection,
+                                 StatementIndex stindex, BindParams & params,
                                  const LeasePtr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_ADD_ADDR4).arg(statements_[stindex].stmt_name);
@@ -1019,10 +1145,11 @@ PgSqlLeaseMgr::updateLeaseCommon(StatementIndex stindex, BindParams & params,
     vector<int> formats_;
     convertToQuery(params, params_, lengths_, formats_);
 
-    PGresult * r = PQexecPrepared(conn_, statements_[stindex].stmt_name,
+    PGresult * r = PQexecPrepared(connection.conn_,
+                                  statements_[stindex].stmt_name,
                                   statements_[stindex].stmt_nbparams,
                                   &params_[0], &lengths_[0], &formats_[0], 0);
-    checkStatementError(r, stindex);
+    checkStatementError(connection, r, stindex);
 
     int affected_rows = boost::lexical_cast<int>(PQcmdTuples(r));
     PQclear(r);
@@ -1046,6 +1173,7 @@ PgSqlLeaseMgr::updateLeaseCommon(StatementIndex stindex, BindParams & params,
 
 void
 PgSqlLeaseMgr::updateLease4(const Lease4Ptr& lease) {
+    ConnectionPool::Locker connection(pool_);
     const StatementIndex stindex = UPDATE_LEASE4;
 
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
@@ -1053,44 +1181,47 @@ PgSqlLeaseMgr::updateLease4(const Lease4Ptr& lease) {
 
     // Create the BIND array for the data being updated
     ostringstream tmp;
-    BindParams params = exchange4_->createBindForSend(lease);
+    BindParams params = connection->exchange4_->createBindForSend(lease);
 
     // Set up the WHERE clause and append it to the SQL_BIND array
     tmp << static_cast<uint32_t>(lease->addr_);
     params.push_back(PgSqlParam(tmp.str()));
 
     // Drop to common update code
-    updateLeaseCommon(stindex, params, lease);
+    updateLeaseCommon(*connection, stindex, params, lease);
 }
 
 void
 PgSqlLeaseMgr::updateLease6(const Lease6Ptr& lease) {
+    ConnectionPool::Locker connection(pool_);
     const StatementIndex stindex = UPDATE_LEASE6;
 
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_UPDATE_ADDR6).arg(lease->addr_.toText());
 
     // Create the BIND array for the data being updated
-    BindParams params = exchange6_->createBindForSend(lease);
+    BindParams params = connection->exchange6_->createBindForSend(lease);
 
     // Set up the WHERE clause and append it to the BIND array
     params.push_back(PgSqlParam(lease->addr_.toText()));
 
     // Drop to common update code
-    updateLeaseCommon(stindex, params, lease);
+    updateLeaseCommon(*connection, stindex, params, lease);
 }
 
 bool
-PgSqlLeaseMgr::deleteLeaseCommon(StatementIndex stindex, BindParams & params) {
+PgSqlLeaseMgr::deleteLeaseCommon(PgSqlConnection& connection,
+                                 StatementIndex stindex, BindParams & params) {
     vector<const char *> params_;
     vector<int> lengths_;
     vector<int> formats_;
     convertToQuery(params, params_, lengths_, formats_);
 
-    PGresult * r = PQexecPrepared(conn_, statements_[stindex].stmt_name,
+    PGresult * r = PQexecPrepared(connection.conn_,
+                                  statements_[stindex].stmt_name,
                                   statements_[stindex].stmt_nbparams,
                                   &params_[0], &lengths_[0], &formats_[0], 0);
-    checkStatementError(r, stindex);
+    checkStatementError(connection, r, stindex);
     int affected_rows = boost::lexical_cast<int>(PQcmdTuples(r));
     PQclear(r);
 
@@ -1101,6 +1232,7 @@ bool
 PgSqlLeaseMgr::deleteLease(const bundy::asiolink::IOAddress& addr) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_DELETE_ADDR).arg(addr.toText());
+    ConnectionPool::Locker connection(pool_);
 
     // Set up the WHERE clause value
     BindParams inparams;
@@ -1109,11 +1241,11 @@ PgSqlLeaseMgr::deleteLease(const bundy::asiolink::IOAddress& addr) {
         ostringstream tmp;
         tmp << static_cast<uint32_t>(addr);
         inparams.push_back(PgSqlParam(tmp.str()));
-        return (deleteLeaseCommon(DELETE_LEASE4, inparams));
+        return (deleteLeaseCommon(*connection, DELETE_LEASE4, inparams));
     }
 
     inparams.push_back(PgSqlParam(addr.toText()));
-    return (deleteLeaseCommon(DELETE_LEASE6, inparams));
+    return (deleteLeaseCommon(*connection, DELETE_LEASE6, inparams));
 }
 
 string
@@ -1128,14 +1260,15 @@ PgSqlLeaseMgr::getName() const {
 }
 
 void
-PgSqlLeaseMgr::checkStatementError(PGresult* r, StatementIndex index) const {
+PgSqlLeaseMgr::checkStatementError(const PgSqlConnection& connection,
+                                   PGresult* r, StatementIndex index) const {
     int s = PQresultStatus(r);
     if (s != PGRES_COMMAND_OK && s != PGRES_TUPLES_OK) {
         PQclear(r);
 
         bundy_throw(DbOperationError, "Statement exec faild:" << " for: " <<
                   statements_[index].stmt_name << ", reason: " <<
-                  PQerrorMessage(conn_));
+                  PQerrorMessage(connection.conn_));
     }
 }
 
@@ -1165,9 +1298,11 @@ pair<uint32_t, uint32_t>
 PgSqlLeaseMgr::getVersion() const {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
               DHCPSRV_PGSQL_GET_VERSION);
+    ConnectionPool::Locker connection(pool_);
 
-    PGresult* r = PQexecPrepared(conn_, "get_version", 0, NULL, NULL, NULL, 0);
-    checkStatementError(r, GET_VERSION);
+    PGresult* r = PQexecPrepared(connection->conn_, "get_version", 0, NULL,
+                                 NULL, NULL, 0);
+    checkStatementError(*connection, r, GET_VERSION);
 
     istringstream tmp;
     uint32_t version;
@@ -1188,9 +1323,11 @@ PgSqlLeaseMgr::getVersion() const {
 void
 PgSqlLeaseMgr::commit() {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL, DHCPSRV_PGSQL_COMMIT);
-    PGresult * r = PQexec(conn_, "COMMIT");
+    ConnectionPool::Locker connection(pool_);
+    PGresult * r = PQexec(connection->conn_, "COMMIT");
     if (PQresultStatus(r) != PGRES_COMMAND_OK) {
-        bundy_throw(DbOperationError, "commit failed: " << PQerrorMessage(conn_));
+        bundy_throw(DbOperationError, "commit failed: "
+                  << PQerrorMessage(connection->conn_));
     }
 
     PQclear(r);
@@ -1199,10 +1336,11 @@ PgSqlLeaseMgr::commit() {
 void
 PgSqlLeaseMgr::rollback() {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL, DHCPSRV_PGSQL_ROLLBACK);
-    PGresult * r = PQexec(conn_, "ROLLBACK");
+    ConnectionPool::Locker connection(pool_);
+    PGresult * r = PQexec(connection->conn_, "ROLLBACK");
     if (PQresultStatus(r) != PGRES_COMMAND_OK) {
         bundy_throw(DbOperationError, "rollback failed: "
-                                    << PQerrorMessage(conn_));
+                                    << PQerrorMessage(connection->conn_));
     }
 
     PQclear(r);
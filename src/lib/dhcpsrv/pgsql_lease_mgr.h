@@ -16,6 +16,7 @@
 #define PGSQL_LEASE_MGR_H
 
 #include <dhcp/hwaddr.h>
+#include <dhcpsrv/db_connection_pool.h>
 #include <dhcpsrv/lease_mgr.h>
 
 #include <boost/scoped_ptr.hpp>
@@ -71,6 +72,34 @@ struct PgSqlStatementBind {
 class PgSqlLease4Exchange;
 class PgSqlLease6Exchange;
 
+/// @brief A connection to the PostgreSQL database
+///
+/// It holds the exchange objects used with the connection, so that the
+/// connections of the pool can be used in parallel.  The same statements
+/// are prepared on every connection.
+struct PgSqlConnection : public boost::noncopyable {
+    /// @brief Constructor, creates the exchange objects.
+    PgSqlConnection();
+
+    /// @brief Destructor, deallocates the prepared statements and closes
+    ///        the connection.
+    ~PgSqlConnection();
+
+    /// @brief Prepares the calling thread for the use of the library.
+    ///
+    /// Called by the pool before the thread takes a connection.  libpq
+    /// needs no initialization in the threads.
+    static void initThread() {}
+
+    /// PostgreSQL connection handle
+    PGconn* conn_;
+
+    /// The exchange objects are used for transfer of data to/from the
+    /// database.
+    boost::scoped_ptr<PgSqlLease4Exchange> exchange4_; ///< Exchange object
+    boost::scoped_ptr<PgSqlLease6Exchange> exchange6_; ///< Exchange object
+};
+
 /// Defines PostgreSQL backend version: 1.0
 const uint32_t PG_CURRENT_VERSION = 1;
 const uint32_t PG_CURRENT_MINOR = 0;
@@ -80,6 +109,10 @@ const uint32_t PG_CURRENT_MINOR = 0;
 /// This class provides the \ref bundy::dhcp::LeaseMgr interface to the PostgreSQL
 /// database.  Use of this backend presupposes that a PostgreSQL database is
 /// available and that the Kea schema has been created within it.
+///
+/// The backend opens a pool of connections to the database.  Each call
+/// uses one connection of the pool, so as many calls run in parallel as
+/// there are connections.
 class PgSqlLeaseMgr : public LeaseMgr {
 public:
 
@@ -91,6 +124,13 @@ public:
     /// - host - Host to which to connect (optional, defaults to "localhost")
     /// - user - Username under which to connect (optional)
     /// - password - Password for "user" on the database (optional)
+    /// - connections - Number of the connections to open (optional,
+    ///   defaults to 1)
+    /// - async-commit - If "true", the transactions are committed without
+    ///   waiting for the disk (optional, defaults to "false").  The leases
+    ///   written during the last few hundred milliseconds before a crash of
+    ///   the database server may be lost, but the database stays
+    ///   consistent.
     ///
     /// If the database is successfully opened, the version number in the
     /// schema_version table will be checked against hard-coded value in
@@ -105,6 +145,7 @@ public:
     /// @throw bundy::dhcp::DbOpenError Error opening the database
     /// @throw bundy::dhcp::DbOperationError An operation on the open database has
     ///        failed.
+    /// @throw bundy::BadValue Invalid value of a parameter.
     PgSqlLeaseMgr(const ParameterMap& parameters);
 
     /// @brief Destructor (closes database)
@@ -290,6 +331,32 @@ public:
     virtual Lease6Collection getLeases6(Lease::Type type, const DUID& duid,
                                         uint32_t iaid, SubnetID subnet_id) const;
 
+    /// @brief Returns the expired IPv4 leases.
+    ///
+    /// The leases are selected using the index on the expire column.
+    ///
+    /// @param [out] expired Collection the expired leases are appended to.
+    /// @param max_leases Maximum number of the leases returned, 0 for all.
+    ///
+    /// @throw bundy::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    virtual void getExpiredLeases4(Lease4Collection& expired,
+                                   size_t max_leases) const;
+
+    /// @brief Returns the expired IPv6 leases.
+    ///
+    /// The leases are selected using the index on the expire column.
+    ///
+    /// @param [out] expired Collection the expired leases are appended to.
+    /// @param max_leases Maximum number of the leases returned, 0 for all.
+    ///
+    /// @throw bundy::BadValue record retrieved from database had an invalid
+    ///        lease type field.
+    /// @throw bundy::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    virtual void getExpiredLeases6(Lease6Collection& expired,
+                                   size_t max_leases) const;
+
     /// @brief Updates IPv4 lease.
     ///
     /// Updates the record of the lease in the database (as identified by the
@@ -382,11 +449,13 @@ public:
         GET_LEASE4_ADDR,            // Get lease4 by address
         GET_LEASE4_CLIENTID,        // Get lease4 by client ID
         GET_LEASE4_CLIENTID_SUBID,  // Get lease4 by client ID & subnet ID
+        GET_LEASE4_EXPIRE,          // Get expired lease4
         GET_LEASE4_HWADDR,          // Get lease4 by HW address
         GET_LEASE4_HWADDR_SUBID,    // Get lease4 by HW address & subnet ID
         GET_LEASE6_ADDR,            // Get lease6 by address
         GET_LEASE6_DUID_IAID,       // Get lease6 by DUID and IAID
         GET_LEASE6_DUID_IAID_SUBID, // Get lease6 by DUID, IAID and subnet ID
+        GET_LEASE6_EXPIRE,          // Get expired lease6
         GET_VERSION,                // Obtain version number
         INSERT_LEASE4,              // Add entry to lease4 table
         INSERT_LEASE6,              // Add entry to lease6 table
@@ -395,27 +464,39 @@ public:
         NUM_STATEMENTS              // Number of statements
     };
 
+    /// @brief Returns the number of the connections to the database.
+    size_t getConnectionCount() const {
+        return (pool_.size());
+    }
+
 private:
+    /// @brief The pool of the connections
+    typedef DbConnectionPool<PgSqlConnection> ConnectionPool;
 
     /// @brief Prepare statements
     ///
     /// Creates the prepared statements for all of the SQL statements used
     /// by the PostgreSQL backend.
     ///
+    /// @param connection The connection to prepare the statements on
+    ///
     /// @throw bundy::dhcp::DbOperationError An operation on the open database has
     ///        failed.
     /// @throw bundy::InvalidParameter 'index' is not valid for the vector.  This
     ///        represents an internal error within the code.
-    void prepareStatements();
+    void prepareStatements(PgSqlConnection& connection);
 
     /// @brief Open Database
     ///
     /// Opens the database using the information supplied in the parameters
     /// passed to the constructor.
     ///
+    /// @param connection The connection to open
+    /// @param async_commit If true, sets the asynchronous commit mode
+    ///
     /// @throw NoDatabaseName Mandatory database name not given
     /// @throw DbOpenError Error opening the database
-    void openDatabase();
+    void openDatabase(PgSqlConnection& connection, bool async_commit);
 
     /// @brief Add Lease Common Code
     ///
@@ -423,6 +504,7 @@ private:
     /// of the addLease method.  It binds the contents of the lease object to
     /// the prepared statement and adds it to the database.
     ///
+    /// @param connection Connection to use
     /// @param stindex Index of statemnent being executed
     /// @param bind MYSQL_BIND array that has been created for the type
     ///        of lease in question.
@@ -432,13 +514,15 @@ private:
     ///
     /// @throw bundy::dhcp::DbOperationError An operation on the open database has
     ///        failed.
-    bool addLeaseCommon(StatementIndex stindex, BindParams& params);
+    bool addLeaseCommon(PgSqlConnection& connection, StatementIndex stindex,
+                        BindParams& params);
 
     /// @brief Get Lease Collection Common Code
     ///
     /// This method performs the common actions for obtaining multiple leases
     /// from the database.
     ///
+    /// @param connection Connection to use
     /// @param stindex Index of statement being executed
     /// @param params PostgreSQL parameters for the query
     /// @param exchange Exchange object to use
@@ -455,7 +539,8 @@ private:
     /// @throw bundy::dhcp::MultipleRecords Multiple records were retrieved
     ///        from the database where only one was expected.
     template <typename Exchange, typename LeaseCollection>
-    void getLeaseCollection(StatementIndex stindex, BindParams& params,
+    void getLeaseCollection(PgSqlConnection& connection,
+                            StatementIndex stindex, BindParams& params,
                             Exchange& exchange, LeaseCollection& result,
                             bool single = false) const;
 
@@ -464,6 +549,7 @@ private:
     /// Gets a collection of Lease4 objects.  This is just an interface to
     /// the get lease collection common code.
     ///
+    /// @param connection Connection to use
     /// @param stindex Index of statement being executed
     /// @param params PostgreSQL parameters for the query
     /// @param lease LeaseCollection object returned.  Note that any leases in
@@ -475,9 +561,11 @@ private:
     ///        failed.
     /// @throw bundy::dhcp::MultipleRecords Multiple records were retrieved
     ///        from the database where only one was expected.
-    void getLeaseCollection(StatementIndex stindex, BindParams& params,
+    void getLeaseCollection(PgSqlConnection& connection,
+                            StatementIndex stindex, BindParams& params,
                             Lease4Collection& result) const {
-        getLeaseCollection(stindex, params, exchange4_, result);
+        getLeaseCollection(connection, stindex, params, connection.exchange4_,
+                           result);
     }
 
     /// @brief Get Lease6 Collection
@@ -485,6 +573,7 @@ private:
     /// Gets a collection of Lease6 objects.  This is just an interface to
     /// the get lease collection common code.
     ///
+    /// @param connection Connection to use
     /// @param stindex Index of statement being executed
     /// @param params PostgreSQL parameters for the query
     /// @param lease LeaseCollection object returned.  Note that any existing
@@ -495,9 +584,11 @@ private:
     ///        failed.
     /// @throw bundy::dhcp::MultipleRecords Multiple records were retrieved
     ///        from the database where only one was expected.
-    void getLeaseCollection(StatementIndex stindex, BindParams& params,
+    void getLeaseCollection(PgSqlConnection& connection,
+                            StatementIndex stindex, BindParams& params,
                             Lease6Collection& result) const {
-        getLeaseCollection(stindex, params, exchange6_, result);
+        getLeaseCollection(connection, stindex, params, connection.exchange6_,
+                           result);
     }
 
     /// @brief Checks result of the r object
@@ -505,11 +596,13 @@ private:
     /// Checks status of the operation passed as first argument and throws
     /// DbOperationError with details if it is non-success.
     ///
+    /// @param connection Connection the operation was run on
     /// @param r result of the last PostgreSQL operation
     /// @param index will be used to print out compiled statement name
     ///
     /// @throw bundy::dhcp::DbOperationError Detailed PostgreSQL failure
-    inline void checkStatementError(PGresult* r, StatementIndex index) const;
+    inline void checkStatementError(const PgSqlConnection& connection,
+                                    PGresult* r, StatementIndex index) const;
 
     /// @brief Converts query parameters to format accepted by PostgreSQL
     ///
@@ -530,11 +623,12 @@ private:
     /// methods.  It acts as an interface to the getLeaseCollection() method,
     /// but retrieveing only a single lease.
     ///
+    /// @param connection Connection to use
     /// @param stindex Index of statement being executed
     /// @param BindParams PostgreSQL array for input parameters
     /// @param lease Lease4 object returned
-    void getLease(StatementIndex stindex, BindParams& params,
-                  Lease4Ptr& result) const;
+    void getLease(PgSqlConnection& connection, StatementIndex stindex,
+                  BindParams& params, Lease4Ptr& result) const;
 
     /// @brief Get Lease6 Common Code
     ///
@@ -542,11 +636,19 @@ private:
     /// methods.  It acts as an interface to the getLeaseCollection() method,
     /// but retrieveing only a single lease.
     ///
+    /// @param connection Connection to use
     /// @param stindex Index of statement being executed
     /// @param BindParams PostgreSQL array for input parameters
     /// @param lease Lease6 object returned
-    void getLease(StatementIndex stindex, BindParams& params,
-                  Lease6Ptr& result) const;
+    void getLease(PgSqlConnection& connection, StatementIndex stindex,
+                  BindParams& params, Lease6Ptr& result) const;
+
+    /// @brief Sets up the parameters selecting the expired leases
+    ///
+    /// @param params The parameters, the current time and the maximum
+    ///        number of the leases are appended to it
+    /// @param max_leases Maximum number of the leases, 0 for all
+    static void setExpiredParameters(BindParams& params, size_t max_leases);
 
 
     /// @brief Update lease common code
@@ -555,6 +657,7 @@ private:
     /// to the prepared statement, executes it, then checks how many rows
     /// were affected.
     ///
+    /// @param connection Connection to use
     /// @param stindex Index of prepared statement to be executed
     /// @param BindParams Array of PostgreSQL objects representing the parameters.
     ///        (Note that the number is determined by the number of parameters
@@ -566,7 +669,8 @@ private:
     /// @throw bundy::dhcp::DbOperationError An operation on the open database has
     ///        failed.
     template <typename LeasePtr>
-    void updateLeaseCommon(StatementIndex stindex, BindParams& params,
+    void updateLeaseCommon(PgSqlConnection& connection,
+                           StatementIndex stindex, BindParams& params,
                            const LeasePtr& lease);
 
     /// @brief Delete lease common code
@@ -575,6 +679,7 @@ private:
     /// to the prepared statement, executes the statement and checks to
     /// see how many rows were deleted.
     ///
+    /// @param connection Connection to use
     /// @param stindex Index of prepared statement to be executed
     /// @param BindParams Array of PostgreSQL objects representing the parameters.
     ///        (Note that the number is determined by the number of parameters
@@ -585,20 +690,16 @@ private:
     ///
     /// @throw bundy::dhcp::DbOperationError An operation on the open database has
     ///        failed.
-    bool deleteLeaseCommon(StatementIndex stindex, BindParams& params);
+    bool deleteLeaseCommon(PgSqlConnection& connection,
+                           StatementIndex stindex, BindParams& params);
 
-    /// The exchange objects are used for transfer of data to/from the database.
-    /// They are pointed-to objects as the contents may change in "const" calls,
-    /// while the rest of this object does not.  (At alternative would be to
-    /// declare them as "mutable".)
-    boost::scoped_ptr<PgSqlLease4Exchange> exchange4_; ///< Exchange object
-    boost::scoped_ptr<PgSqlLease6Exchange> exchange6_; ///< Exchange object
-
-    /// A vector of compiled SQL statements
+    /// A vector of compiled SQL statements, they have the same names on
+    /// all the connections
     std::vector<PgSqlStatementBind> statements_;
 
-    /// PostgreSQL connection handle
-    PGconn* conn_;
+    /// The connections to the database.  The pool is mutable as a
+    /// connection is taken from it in "const" calls too.
+    mutable ConnectionPool pool_;
 };
 
 }; // end of bundy::dhcp namespace
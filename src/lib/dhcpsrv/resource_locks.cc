@@ -0,0 +1,68 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcpsrv/resource_locks.h>
+
+using namespace bundy::util::thread;
+
+namespace bundy {
+namespace dhcp {
+
+ResourceLocks::Locker::Locker(ResourceLocks& locks, const Key& key,
+                              bool block) :
+    locks_(locks), key_(key), locked_(locks.lock(key, block))
+{
+}
+
+ResourceLocks::Locker::~Locker() {
+    if (locked_) {
+        locks_.unlock(key_);
+    }
+}
+
+bool
+ResourceLocks::isLocked(const Key& key) const {
+    Mutex::Locker lock(mutex_);
+    return (locked_.count(key) > 0);
+}
+
+size_t
+ResourceLocks::getLockedCount() const {
+    Mutex::Locker lock(mutex_);
+    return (locked_.size());
+}
+
+bool
+ResourceLocks::lock(const Key& key, bool block) {
+    Mutex::Locker lock(mutex_);
+    while (locked_.count(key) > 0) {
+        if (!block) {
+            return (false);
+        }
+        cond_.wait(mutex_);
+    }
+    locked_.insert(key);
+    return (true);
+}
+
+void
+ResourceLocks::unlock(const Key& key) {
+    Mutex::Locker lock(mutex_);
+    locked_.erase(key);
+    // Several threads may be waiting for different keys.
+    cond_.broadcast();
+}
+
+} // namespace bundy::dhcp
+} // namespace bundy
@@ -0,0 +1,95 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef RESOURCE_LOCKS_H
+#define RESOURCE_LOCKS_H
+
+#include <util/threads/sync.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <set>
+#include <vector>
+
+#include <stdint.h>
+
+namespace bundy {
+namespace dhcp {
+
+/// @brief Set of locks on resources identified by binary keys.
+///
+/// The packets of different clients are processed in parallel by the
+/// servers, but two packets of the same client must not be, as they would
+/// race for the client's leases.  Similarly, two clients must not take over
+/// the same expired lease at the same time.  This class holds a lock for
+/// every client (or address) being worked with.  The keys are the client
+/// identifiers (or the addresses) in the binary form.
+///
+/// Only the keys locked at the moment are kept, so the memory taken is
+/// proportional to the number of the threads, not the clients.
+class ResourceLocks : public boost::noncopyable {
+public:
+    /// @brief Key identifying a resource.
+    typedef std::vector<uint8_t> Key;
+
+    /// @brief Holds a lock on a resource while in scope.
+    class Locker : public boost::noncopyable {
+    public:
+        /// @brief Constructor, locks the resource.
+        ///
+        /// @param locks The set of locks.
+        /// @param key Key of the resource.
+        /// @param block If true, waits for the resource to be released
+        ///     by other threads, otherwise gives up right away (check it
+        ///     with @c locked()).
+        Locker(ResourceLocks& locks, const Key& key, bool block = true);
+
+        /// @brief Destructor, releases the resource.
+        ~Locker();
+
+        /// @brief Returns true if the lock was acquired.
+        bool locked() const {
+            return (locked_);
+        }
+
+    private:
+        ResourceLocks& locks_;
+        const Key key_;
+        bool locked_;
+    };
+
+    /// @brief Returns true if the resource is locked by any thread.
+    bool isLocked(const Key& key) const;
+
+    /// @brief Returns the number of the resources locked.
+    size_t getLockedCount() const;
+
+private:
+    /// @brief Lock the resource.
+    ///
+    /// @return false if not blocking and the resource is locked already.
+    bool lock(const Key& key, bool block);
+
+    /// @brief Release the resource.
+    void unlock(const Key& key);
+
+    std::set<Key> locked_;
+    mutable bundy::util::thread::Mutex mutex_;
+    bundy::util::thread::CondVar cond_;
+};
+
+} // namespace bundy::dhcp
+} // namespace bundy
+
+#endif // RESOURCE_LOCKS_H
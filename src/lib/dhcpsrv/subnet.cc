@@ -24,6 +24,40 @@ using namespace bundy::asiolink;
 namespace bundy {
 namespace dhcp {
 
+namespace {
+
+// Stores the on-wire format of the options of all the option spaces in
+// their descriptors.
+template<typename Selector>
+void
+packOptionSpaces(OptionSpaceContainer<Subnet::OptionContainer,
+                 Subnet::OptionDescriptor, Selector>& spaces) {
+    const std::list<Selector>& names = spaces.getOptionSpaceNames();
+    for (typename std::list<Selector>::const_iterator name = names.begin();
+         name != names.end(); ++name) {
+        Subnet::OptionContainerPtr options = spaces.getItems(*name);
+        for (Subnet::OptionContainer::iterator desc = options->begin();
+             desc != options->end(); ++desc) {
+            if (!desc->option) {
+                continue;
+            }
+            util::OutputBuffer buf(0);
+            try {
+                desc->option->pack(buf);
+            } catch (const Exception&) {
+                continue;
+            }
+            const uint8_t* data = static_cast<const uint8_t*>(buf.getData());
+            Subnet::OptionDescriptor packed(*desc);
+            packed.packed.reset(new OptionBuffer(data, data +
+                                                 buf.getLength()));
+            options->replace(desc, packed);
+        }
+    }
+}
+
+} // end of anonymous namespace
+
 // This is an initial value of subnet-id. See comments in subnet.h for details.
 SubnetID Subnet::static_id_ = 1;
 
@@ -157,6 +191,12 @@ void Subnet::delVendorOptions() {
     vendor_option_spaces_.clearItems();
 }
 
+void
+Subnet::packOptions() {
+    packOptionSpaces(option_spaces_);
+    packOptionSpaces(vendor_option_spaces_);
+}
+
 bundy::asiolink::IOAddress Subnet::getLastAllocated(Lease::Type type) const {
     // check if the type is valid (and throw if it isn't)
     checkType(type);
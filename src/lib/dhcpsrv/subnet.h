@@ -66,6 +66,8 @@ public:
         /// Persistent flag, if true option is always sent to the client,
         /// if false option is sent to the client on request.
         bool persistent;
+        /// Option in on-wire format, set by @c Subnet::packOptions().
+        OptionBufferPtr packed;
 
         /// @brief Constructor.
         ///
@@ -217,6 +219,17 @@ public:
     /// @brief Deletes all vendor options configured for the subnet.
     void delVendorOptions();
 
+    /// @brief Packs the options configured for the subnet.
+    ///
+    /// The on-wire format of each option is stored in its descriptor, so
+    /// the servers copy it to the responses instead of packing the option
+    /// for each of them.  It is called when the subnet is added to the
+    /// configuration (see @c CfgMgr::addSubnet4()): the options added
+    /// afterwards are packed for each response, and the options must not
+    /// be modified afterwards.  An option which can't be packed is left
+    /// as is.
+    void packOptions();
+
     /// @brief checks if the specified address is in pools
     ///
     /// Note the difference between inSubnet() and inPool(). For a given
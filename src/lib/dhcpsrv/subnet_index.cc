@@ -0,0 +1,157 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcpsrv/subnet_index.h>
+
+using namespace bundy::asiolink;
+
+namespace bundy {
+namespace dhcp {
+
+const size_t SubnetIndex::NOT_FOUND;
+
+SubnetIndex::SubnetIndex() {
+}
+
+void
+SubnetIndex::add(const SubnetPtr& subnet, const OptionPtr& interface_id) {
+    const size_t position = subnets_.size();
+    subnets_.push_back(subnet);
+    ids_.insert(subnet->getID());
+
+    const std::pair<IOAddress, uint8_t> prefix = subnet->get();
+    PrefixMaps& prefixes = prefix.first.isV4() ? prefixes4_ : prefixes6_;
+    prefixes[prefix.second][toKey(prefix.first, prefix.second)]
+        .push_back(position);
+
+    relays_[subnet->getRelayInfo().addr_].push_back(position);
+
+    const std::string iface = subnet->getIface();
+    if (!iface.empty()) {
+        ifaces_[iface].push_back(position);
+    }
+
+    if (interface_id) {
+        interface_ids_[std::make_pair(interface_id->getType(),
+                                      interface_id->getData())]
+            .push_back(position);
+    }
+}
+
+void
+SubnetIndex::clear() {
+    subnets_.clear();
+    prefixes4_.clear();
+    prefixes6_.clear();
+    relays_.clear();
+    ifaces_.clear();
+    interface_ids_.clear();
+    ids_.clear();
+}
+
+size_t
+SubnetIndex::findByAddress(const IOAddress& addr,
+                           const ClientClasses& classes, bool relay) const {
+    size_t found = NOT_FOUND;
+
+    if (relay) {
+        boost::unordered_map<IOAddress, Positions>::const_iterator it =
+            relays_.find(addr);
+        if (it != relays_.end()) {
+            found = findSupported(it->second, classes);
+        }
+    }
+
+    // Look the address up with each prefix length in use.  The subnets may
+    // overlap, so all the lengths are checked and the first subnet of the
+    // configuration wins.
+    const PrefixMaps& prefixes = addr.isV4() ? prefixes4_ : prefixes6_;
+    for (PrefixMaps::const_iterator len = prefixes.begin();
+         len != prefixes.end(); ++len) {
+        PrefixMap::const_iterator it = len->second.find(toKey(addr,
+                                                              len->first));
+        if (it != len->second.end()) {
+            const size_t position = findSupported(it->second, classes,
+                                                  found);
+            if (position < found) {
+                found = position;
+            }
+        }
+    }
+    return (found);
+}
+
+size_t
+SubnetIndex::findByIface(const std::string& iface,
+                         const ClientClasses& classes) const {
+    boost::unordered_map<std::string, Positions>::const_iterator it =
+        ifaces_.find(iface);
+    return (it == ifaces_.end() ? NOT_FOUND :
+            findSupported(it->second, classes));
+}
+
+size_t
+SubnetIndex::findByInterfaceId(const OptionPtr& interface_id,
+                               const ClientClasses& classes) const {
+    if (!interface_id) {
+        return (NOT_FOUND);
+    }
+    boost::unordered_map<std::pair<uint16_t, OptionBuffer>,
+                         Positions>::const_iterator it =
+        interface_ids_.find(std::make_pair(interface_id->getType(),
+                                           interface_id->getData()));
+    return (it == interface_ids_.end() ? NOT_FOUND :
+            findSupported(it->second, classes));
+}
+
+SubnetIndex::Key
+SubnetIndex::toKey(const IOAddress& addr, uint8_t prefix_len) {
+    const std::vector<uint8_t>& bytes = addr.toBytes();
+    const size_t split = bytes.size() > 8 ? bytes.size() - 8 : 0;
+    Key key(0, 0);
+    for (size_t i = 0; i < split; ++i) {
+        key.first = (key.first << 8) | bytes[i];
+    }
+    for (size_t i = split; i < bytes.size(); ++i) {
+        key.second = (key.second << 8) | bytes[i];
+    }
+
+    // Clear the bits past the prefix.
+    const unsigned int addr_len = bytes.size() * 8;
+    const unsigned int host_len = prefix_len < addr_len ?
+        addr_len - prefix_len : 0;
+    if (host_len >= 64) {
+        key.second = 0;
+        key.first &= (host_len >= 128) ? 0 : (~0ULL << (host_len - 64));
+    } else if (host_len > 0) {
+        key.second &= ~0ULL << host_len;
+    }
+    return (key);
+}
+
+size_t
+SubnetIndex::findSupported(const Positions& positions,
+                           const ClientClasses& classes,
+                           size_t limit) const {
+    for (Positions::const_iterator it = positions.begin();
+         (it != positions.end()) && (*it < limit); ++it) {
+        if (subnets_[*it]->clientSupported(classes)) {
+            return (*it);
+        }
+    }
+    return (NOT_FOUND);
+}
+
+} // namespace bundy::dhcp
+} // namespace bundy
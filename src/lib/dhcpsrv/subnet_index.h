@@ -0,0 +1,158 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef SUBNET_INDEX_H
+#define SUBNET_INDEX_H
+
+#include <asiolink/io_address.h>
+#include <dhcp/classify.h>
+#include <dhcp/option.h>
+#include <dhcpsrv/subnet.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+namespace bundy {
+namespace dhcp {
+
+/// @brief Index of the configured subnets, used to select the subnet of a
+///        packet.
+///
+/// The configuration manager keeps one index for the IPv4 subnets and one
+/// for the IPv6 subnets, next to the lists of the subnets.  The subnets are
+/// identified by their position in the list, and the lookups return the
+/// first subnet of the list which matches the criteria and supports the
+/// client classes, exactly as a scan of the list would.
+///
+/// The subnets are hashed by their prefix, with one hash table for each
+/// prefix length in use, so an address is matched with a lookup for each
+/// distinct prefix length rather than a check of each subnet.  The relay
+/// addresses, the interface names and the interface-ids of the subnets have
+/// a hash table each.
+///
+/// The relay information, the interface name and the interface-id are read
+/// when the subnet is added: if they change later, the index must be
+/// rebuilt.
+class SubnetIndex : public boost::noncopyable {
+public:
+    /// @brief Position returned when no subnet matches.
+    static const size_t NOT_FOUND = static_cast<size_t>(-1);
+
+    /// @brief Constructor, creates an empty index.
+    SubnetIndex();
+
+    /// @brief Adds a subnet at the end of the list.
+    ///
+    /// @param subnet The subnet.
+    /// @param interface_id Interface-id of the subnet, only IPv6 subnets
+    ///     have one.
+    void add(const SubnetPtr& subnet,
+             const OptionPtr& interface_id = OptionPtr());
+
+    /// @brief Removes all the subnets.
+    void clear();
+
+    /// @brief Checks if a subnet with the given id was added.
+    bool hasId(SubnetID id) const {
+        return (ids_.count(id) > 0);
+    }
+
+    /// @brief Finds the subnet of an address.
+    ///
+    /// @param addr The address.
+    /// @param classes Classes the client belongs to.
+    /// @param relay If true, the address is the address of a relay and the
+    ///     subnets with this relay address match as well.
+    /// @return Position of the subnet, or @c NOT_FOUND.
+    size_t findByAddress(const bundy::asiolink::IOAddress& addr,
+                         const ClientClasses& classes, bool relay) const;
+
+    /// @brief Finds the subnet reachable over an interface.
+    ///
+    /// @param iface Name of the interface.
+    /// @param classes Classes the client belongs to.
+    /// @return Position of the subnet, or @c NOT_FOUND.
+    size_t findByIface(const std::string& iface,
+                       const ClientClasses& classes) const;
+
+    /// @brief Finds the subnet with an interface-id.
+    ///
+    /// @param interface_id The interface-id option sent by the relay.
+    /// @param classes Classes the client belongs to.
+    /// @return Position of the subnet, or @c NOT_FOUND.
+    size_t findByInterfaceId(const OptionPtr& interface_id,
+                             const ClientClasses& classes) const;
+
+private:
+    /// @brief Address (or prefix) as a pair of 64-bit integers.
+    typedef std::pair<uint64_t, uint64_t> Key;
+
+    /// @brief Positions of the subnets, in increasing order.
+    typedef std::vector<size_t> Positions;
+
+    /// @brief Subnets with the same prefix length, hashed by prefix.
+    typedef boost::unordered_map<Key, Positions> PrefixMap;
+
+    /// @brief Hash tables of the prefixes, by prefix length.
+    typedef std::map<uint8_t, PrefixMap> PrefixMaps;
+
+    /// @brief Returns the address masked to the given prefix length.
+    static Key toKey(const bundy::asiolink::IOAddress& addr,
+                     uint8_t prefix_len);
+
+    /// @brief Returns the first subnet supporting the classes.
+    ///
+    /// @param positions The candidate subnets.
+    /// @param classes Classes the client belongs to.
+    /// @param limit Only the subnets before this position are checked.
+    /// @return Position of the subnet, or @c NOT_FOUND.
+    size_t findSupported(const Positions& positions,
+                         const ClientClasses& classes,
+                         size_t limit = NOT_FOUND) const;
+
+    /// @brief All the subnets, in the order of the configuration.
+    std::vector<SubnetPtr> subnets_;
+
+    /// @brief The IPv4 subnets.
+    PrefixMaps prefixes4_;
+
+    /// @brief The IPv6 subnets.
+    PrefixMaps prefixes6_;
+
+    /// @brief The subnets by relay address.
+    boost::unordered_map<bundy::asiolink::IOAddress, Positions> relays_;
+
+    /// @brief The subnets by interface name.
+    boost::unordered_map<std::string, Positions> ifaces_;
+
+    /// @brief The subnets by interface-id (option type and data).
+    boost::unordered_map<std::pair<uint16_t, OptionBuffer>,
+                         Positions> interface_ids_;
+
+    /// @brief The identifiers of the subnets.
+    boost::unordered_set<SubnetID> ids_;
+};
+
+} // namespace bundy::dhcp
+} // namespace bundy
+
+#endif // SUBNET_INDEX_H
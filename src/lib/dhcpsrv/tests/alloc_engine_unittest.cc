@@ -29,6 +29,7 @@
 #include <hooks/callout_manager.h>
 #include <hooks/hooks_manager.h>
 
+#include <boost/lexical_cast.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <gtest/gtest.h>
@@ -64,6 +65,9 @@ public:
     // Expose internal classes for testing purposes
     using AllocEngine::Allocator;
     using AllocEngine::IterativeAllocator;
+    using AllocEngine::HashedAllocator;
+    using AllocEngine::RandomAllocator;
+    using AllocEngine::IndexedAllocator;
     using AllocEngine::getAllocator;
 
     /// @brief IterativeAllocator with internal methods exposed
@@ -470,9 +474,13 @@ public:
 TEST_F(AllocEngine6Test, constructor) {
     boost::scoped_ptr<AllocEngine> x;
 
-    // Hashed and random allocators are not supported yet
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5)), NotImplemented);
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5)), NotImplemented);
+    // All the allocators are supported
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5)));
+    EXPECT_TRUE(x->getAllocator(Lease::TYPE_PD));
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5)));
+    EXPECT_TRUE(x->getAllocator(Lease::TYPE_PD));
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_INDEXED, 5)));
+    EXPECT_TRUE(x->getAllocator(Lease::TYPE_PD));
 
     ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE, 100, true)));
 
@@ -586,6 +594,146 @@ TEST_F(AllocEngine6Test, IterativeAllocator) {
     }
 }
 
+// This test verifies that the hashed allocator picks an address in the pool
+// depending on the DUID only, and continues after the hint.
+TEST_F(AllocEngine6Test, HashedAllocator) {
+    NakedAllocEngine::HashedAllocator alloc(Lease::TYPE_NA);
+
+    const IOAddress first = alloc.pickAddress(subnet_, duid_, IOAddress("::"));
+    EXPECT_TRUE(subnet_->inPool(Lease::TYPE_NA, first));
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(first, alloc.pickAddress(subnet_, duid_, IOAddress("::")));
+    }
+
+    // Some other DUID gets some other address.  (The particular DUIDs
+    // used here don't collide.)
+    DuidPtr other(new DUID(vector<uint8_t>(8, 0x43)));
+    EXPECT_NE(first, alloc.pickAddress(subnet_, other, IOAddress("::")));
+
+    // The pool is 2001:db8:1::10 - 2001:db8:1::20, the address after the
+    // hint is returned and the last one wraps around.
+    EXPECT_EQ("2001:db8:1::16", alloc.pickAddress(subnet_, duid_,
+              IOAddress("2001:db8:1::15")).toText());
+    EXPECT_EQ("2001:db8:1::10", alloc.pickAddress(subnet_, duid_,
+              IOAddress("2001:db8:1::20")).toText());
+
+    // Following the hints, all the addresses are visited
+    std::set<IOAddress> seen;
+    IOAddress last = first;
+    for (int i = 0; i < 17; ++i) {
+        seen.insert(last);
+        last = alloc.pickAddress(subnet_, duid_, last);
+    }
+    EXPECT_EQ(17, seen.size());
+    EXPECT_EQ(first, last);
+}
+
+// This test verifies that the hashed allocator steps over the prefixes
+TEST_F(AllocEngine6Test, HashedAllocatorPrefix) {
+    NakedAllocEngine::HashedAllocator alloc(Lease::TYPE_PD);
+
+    subnet_.reset(new Subnet6(IOAddress("2001:db8::"), 32, 1, 2, 3, 4));
+    subnet_->addPool(Pool6Ptr(new Pool6(Lease::TYPE_PD, IOAddress("2001:db8::"),
+                                        56, 60)));
+    subnet_->addPool(Pool6Ptr(new Pool6(Lease::TYPE_PD,
+                                        IOAddress("2001:db8:2::"), 56, 64)));
+
+    const IOAddress first = alloc.pickAddress(subnet_, duid_, IOAddress("::"));
+    EXPECT_TRUE(subnet_->inPool(Lease::TYPE_PD, first));
+
+    EXPECT_EQ("2001:db8:0:10::", alloc.pickAddress(subnet_, duid_,
+              IOAddress("2001:db8::")).toText());
+    // From the end of the first pool to the second one
+    EXPECT_EQ("2001:db8:2::", alloc.pickAddress(subnet_, duid_,
+              IOAddress("2001:db8:0:f0::")).toText());
+    EXPECT_EQ("2001:db8:2:ab::", alloc.pickAddress(subnet_, duid_,
+              IOAddress("2001:db8:2:aa::")).toText());
+    EXPECT_EQ("2001:db8::", alloc.pickAddress(subnet_, duid_,
+              IOAddress("2001:db8:2:ff::")).toText());
+
+    // Huge pools work as well
+    subnet_->delPools(Lease::TYPE_NA);
+    subnet_->addPool(Pool6Ptr(new Pool6(Lease::TYPE_NA,
+                                        IOAddress("2001:db8:1::"), 48)));
+    NakedAllocEngine::HashedAllocator alloc_na(Lease::TYPE_NA);
+    EXPECT_TRUE(subnet_->inPool(Lease::TYPE_NA,
+                alloc_na.pickAddress(subnet_, duid_, IOAddress("::"))));
+    EXPECT_EQ("2001:db8:1::1:0:0", alloc_na.pickAddress(subnet_, duid_,
+              IOAddress("2001:db8:1::ffff:ffff")).toText());
+}
+
+// This test verifies that the random allocator picks addresses in the pool
+// and doesn't pick the ones in use.
+TEST_F(AllocEngine6Test, RandomAllocator) {
+    NakedAllocEngine::RandomAllocator alloc(Lease::TYPE_NA);
+
+    // 17 addresses in the pool, pick the 16 the random way, so the last
+    // one has to be the one left.
+    std::set<IOAddress> used;
+    for (int i = 0; i < 16; ++i) {
+        IOAddress candidate = alloc.pickAddress(subnet_, duid_, IOAddress("::"));
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_NA, candidate));
+        EXPECT_TRUE(used.insert(candidate).second);
+        alloc.addressUsed(subnet_, candidate);
+    }
+    IOAddress last = alloc.pickAddress(subnet_, duid_, IOAddress("::"));
+    EXPECT_TRUE(subnet_->inPool(Lease::TYPE_NA, last));
+    EXPECT_TRUE(used.find(last) == used.end());
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(last, alloc.pickAddress(subnet_, duid_, IOAddress("::")));
+    }
+
+    // When all are used, everything is available again
+    alloc.addressUsed(subnet_, last);
+    used.clear();
+    for (int i = 0; i < 1000; ++i) {
+        used.insert(alloc.pickAddress(subnet_, duid_, IOAddress("::")));
+    }
+    EXPECT_EQ(17, used.size());
+}
+
+// This test verifies that the random allocator picks the prefixes in all
+// the pools.
+TEST_F(AllocEngine6Test, RandomAllocatorPrefix) {
+    NakedAllocEngine::RandomAllocator alloc(Lease::TYPE_PD);
+
+    subnet_.reset(new Subnet6(IOAddress("2001:db8::"), 32, 1, 2, 3, 4));
+    subnet_->addPool(Pool6Ptr(new Pool6(Lease::TYPE_PD, IOAddress("2001:db8::"),
+                                        56, 60)));
+    subnet_->addPool(Pool6Ptr(new Pool6(Lease::TYPE_PD,
+                                        IOAddress("2001:db8:1::"), 48, 48)));
+
+    // 16 + 1 prefixes
+    std::set<IOAddress> used;
+    for (int i = 0; i < 17; ++i) {
+        IOAddress candidate = alloc.pickAddress(subnet_, duid_, IOAddress("::"));
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_PD, candidate));
+        EXPECT_TRUE(used.insert(candidate).second);
+        alloc.addressUsed(subnet_, candidate);
+    }
+    EXPECT_TRUE(used.find(IOAddress("2001:db8:1::")) != used.end());
+    EXPECT_TRUE(used.find(IOAddress("2001:db8:0:f0::")) != used.end());
+}
+
+// This test checks that the indexed allocator skips the delegated prefixes.
+TEST_F(AllocEngine6Test, IndexedAllocatorPrefix) {
+    NakedAllocEngine::IndexedAllocator alloc(Lease::TYPE_PD);
+
+    Lease6Ptr lease(new Lease6(Lease::TYPE_PD, IOAddress("2001:db8:1::"),
+                               duid_, iaid_, 501, 502, 503, 504,
+                               subnet_->getID(), 64));
+    ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+    lease.reset(new Lease6(Lease::TYPE_PD, IOAddress("2001:db8:1:2::"),
+                           duid_, iaid_ + 1, 501, 502, 503, 504,
+                           subnet_->getID(), 64));
+    ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+
+    EXPECT_EQ("2001:db8:1:1::",
+              alloc.pickAddress(subnet_, duid_, IOAddress("::")).toText());
+    EXPECT_EQ("2001:db8:1:3::",
+              alloc.pickAddress(subnet_, duid_, IOAddress("::")).toText());
+}
+
 TEST_F(AllocEngine6Test, IterativeAllocatorAddrStep) {
     NakedAllocEngine::NakedIterativeAllocator alloc(Lease::TYPE_NA);
 
@@ -985,6 +1133,38 @@ TEST_F(AllocEngine6Test, requestReuseExpiredLease6) {
     detailCompareLease(lease, from_mgr);
 }
 
+// This test checks that the expired leases are reclaimed, the one which
+// expired first first, and the valid ones are kept.
+TEST_F(AllocEngine6Test, reclaimExpiredLeases6) {
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE, 100)));
+    ASSERT_TRUE(engine);
+
+    // Three expired leases, the later ones expired first, and a valid one.
+    vector<IOAddress> addrs;
+    for (int i = 0; i < 4; ++i) {
+        addrs.push_back(IOAddress("2001:db8:1::" +
+                                  boost::lexical_cast<string>(i + 10)));
+        Lease6Ptr lease(new Lease6(Lease::TYPE_NA, addrs[i], duid_, iaid_ + i,
+                                   501, 502, 503, 504, subnet_->getID(), 0));
+        lease->valid_lft_ = 495;
+        lease->cltt_ = time(NULL) - (i < 3 ? 500 + 10 * i : 100);
+        ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+    }
+
+    // At most one lease is reclaimed: the one which expired first.
+    EXPECT_EQ(1, engine->reclaimExpiredLeases6(1, 0));
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease6(Lease::TYPE_NA, addrs[0]));
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease6(Lease::TYPE_NA, addrs[2]));
+
+    // Then the others, except the valid lease.
+    EXPECT_EQ(2, engine->reclaimExpiredLeases6(0, 1000));
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease6(Lease::TYPE_NA, addrs[0]));
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease6(Lease::TYPE_NA, addrs[1]));
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease6(Lease::TYPE_NA, addrs[3]));
+    EXPECT_EQ(0, engine->reclaimExpiredLeases6(0, 0));
+}
+
 // --- IPv4 ---
 
 // This test checks if the v4 Allocation Engine can be instantiated, parses
@@ -992,11 +1172,16 @@ TEST_F(AllocEngine6Test, requestReuseExpiredLease6) {
 TEST_F(AllocEngine4Test, constructor) {
     boost::scoped_ptr<AllocEngine> x;
 
-    // Hashed and random allocators are not supported yet
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5, false)),
-                 NotImplemented);
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5, false)),
-                 NotImplemented);
+    // All the allocators are supported
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5,
+                                            false)));
+    EXPECT_TRUE(x->getAllocator(Lease::TYPE_V4));
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5,
+                                            false)));
+    EXPECT_TRUE(x->getAllocator(Lease::TYPE_V4));
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_INDEXED, 5,
+                                            false)));
+    EXPECT_TRUE(x->getAllocator(Lease::TYPE_V4));
 
     // Create V4 (ipv6=false) Allocation Engine that will try at most
     // 100 attempts to pick up a lease
@@ -1254,6 +1439,151 @@ TEST_F(AllocEngine4Test, IterativeAllocator) {
 }
 
 
+// This test verifies that the hashed allocator picks the address depending
+// on the client identifier.
+TEST_F(AllocEngine4Test, HashedAllocator) {
+    NakedAllocEngine::HashedAllocator alloc(Lease::TYPE_V4);
+
+    const IOAddress first = alloc.pickAddress(subnet_, clientid_,
+                                              IOAddress("0.0.0.0"));
+    EXPECT_TRUE(subnet_->inPool(Lease::TYPE_V4, first));
+    EXPECT_EQ(first, alloc.pickAddress(subnet_, clientid_,
+                                       IOAddress("0.0.0.0")));
+    EXPECT_EQ("192.0.2.101", alloc.pickAddress(subnet_, clientid_,
+              IOAddress("192.0.2.100")).toText());
+    EXPECT_EQ("192.0.2.100", alloc.pickAddress(subnet_, clientid_,
+              IOAddress("192.0.2.109")).toText());
+}
+
+// This test checks that the engine with the hashed allocator allocates the
+// address given by the client identifier when the hint is leased.
+TEST_F(AllocEngine4Test, allocateHashedTakenHint) {
+    NakedAllocEngine::HashedAllocator alloc(Lease::TYPE_V4);
+    const IOAddress hashed = alloc.pickAddress(subnet_, clientid_,
+                                               IOAddress("0.0.0.0"));
+    ASSERT_TRUE(subnet_->inPool(Lease::TYPE_V4, hashed));
+
+    // Some other client leases an address of the pool which is neither
+    // the hashed one nor the one before it, so the address after the hint
+    // is not the hashed one either.
+    IOAddress hint = pool_->getFirstAddress();
+    while (hint == hashed ||
+           alloc.pickAddress(subnet_, clientid_, hint) == hashed) {
+        hint = alloc.pickAddress(subnet_, clientid_, hint);
+    }
+    const uint8_t hwaddr[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe };
+    Lease4Ptr taken(new Lease4(hint, hwaddr, sizeof(hwaddr), 0, 0, 501, 502,
+                               503, time(NULL), subnet_->getID()));
+    ASSERT_TRUE(LeaseMgrFactory::instance().addLease(taken));
+
+    AllocEngine engine(AllocEngine::ALLOC_HASHED, 100, false);
+    Lease4Ptr lease = engine.allocateLease4(subnet_, clientid_, hwaddr_, hint,
+                                            false, false, "", false,
+                                            CalloutHandlePtr(), old_lease_);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(hashed, lease->addr_);
+}
+
+// This test verifies that the random allocator picks the free addresses
+TEST_F(AllocEngine4Test, RandomAllocator) {
+    NakedAllocEngine::RandomAllocator alloc(Lease::TYPE_V4);
+
+    alloc.addressUsed(subnet_, IOAddress("192.0.2.100"));
+    alloc.addressUsed(subnet_, IOAddress("192.0.2.105"));
+    // Out of the pool, ignored
+    alloc.addressUsed(subnet_, IOAddress("192.0.2.1"));
+
+    std::set<IOAddress> seen;
+    for (int i = 0; i < 1000; ++i) {
+        IOAddress candidate = alloc.pickAddress(subnet_, clientid_,
+                                                IOAddress("0.0.0.0"));
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_V4, candidate));
+        seen.insert(candidate);
+    }
+    EXPECT_EQ(8, seen.size());
+    EXPECT_TRUE(seen.find(IOAddress("192.0.2.100")) == seen.end());
+    EXPECT_TRUE(seen.find(IOAddress("192.0.2.105")) == seen.end());
+}
+
+// This test checks that the indexed allocator skips the leased addresses
+// and returns the expired lease when the pool is full.
+TEST_F(AllocEngine4Test, IndexedAllocator) {
+    NakedAllocEngine::IndexedAllocator alloc(Lease::TYPE_V4);
+    uint8_t hwaddr[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe };
+    const uint8_t clientid[] = { 1, 2, 3, 4 };
+    const time_t now = time(NULL);
+
+    // Lease 192.0.2.100 - 192.0.2.104, the first lease has expired.
+    for (uint32_t i = 0; i < 5; ++i) {
+        hwaddr[0] = i;
+        Lease4Ptr lease(new Lease4(IOAddress(0xc0000264 + i), hwaddr,
+                                   sizeof(hwaddr), clientid, sizeof(clientid),
+                                   501, 502, 503, now, subnet_->getID()));
+        if (i == 0) {
+            lease->cltt_ = now - 500;
+            lease->valid_lft_ = 495;
+        }
+        ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+    }
+
+    // The free addresses are returned one after another.
+    EXPECT_EQ("192.0.2.105",
+              alloc.pickAddress(subnet_, clientid_, IOAddress("0.0.0.0")).toText());
+    EXPECT_EQ("192.0.2.106",
+              alloc.pickAddress(subnet_, clientid_, IOAddress("0.0.0.0")).toText());
+
+    // Lease the rest of the pool, the expired lease is returned then.
+    for (uint32_t i = 5; i < 10; ++i) {
+        hwaddr[0] = i;
+        Lease4Ptr lease(new Lease4(IOAddress(0xc0000264 + i), hwaddr,
+                                   sizeof(hwaddr), clientid, sizeof(clientid),
+                                   501, 502, 503, now, subnet_->getID()));
+        ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+    }
+    EXPECT_EQ("192.0.2.100",
+              alloc.pickAddress(subnet_, clientid_, IOAddress("0.0.0.0")).toText());
+
+    // A released address is found, even before the last allocated one.
+    ASSERT_TRUE(LeaseMgrFactory::instance().deleteLease(IOAddress("192.0.2.102")));
+    EXPECT_EQ("192.0.2.102",
+              alloc.pickAddress(subnet_, clientid_, IOAddress("0.0.0.0")).toText());
+}
+
+// This test checks that the engine with the hashed, random and indexed
+// allocators allocates the whole pool.
+TEST_F(AllocEngine4Test, allocateAllHashedRandom) {
+    const AllocEngine::AllocType types[] = { AllocEngine::ALLOC_HASHED,
+                                             AllocEngine::ALLOC_RANDOM,
+                                             AllocEngine::ALLOC_INDEXED };
+    for (int t = 0; t < 3; ++t) {
+        SCOPED_TRACE(t);
+        factory_.create("type=memfile universe=4 persist=false");
+        AllocEngine engine(types[t], 100, false);
+
+        std::set<IOAddress> allocated;
+        for (uint8_t i = 0; i < 10; ++i) {
+            ClientIdPtr clientid(new ClientId(vector<uint8_t>(8, i)));
+            hwaddr_->hwaddr_[0] = i;
+            Lease4Ptr lease = engine.allocateLease4(subnet_, clientid,
+                                                    hwaddr_,
+                                                    IOAddress("0.0.0.0"),
+                                                    false, false, "", false,
+                                                    CalloutHandlePtr(),
+                                                    old_lease_);
+            ASSERT_TRUE(lease);
+            EXPECT_TRUE(allocated.insert(lease->addr_).second);
+        }
+
+        // The pool is exhausted now
+        ClientIdPtr clientid(new ClientId(vector<uint8_t>(8, 0xff)));
+        hwaddr_->hwaddr_[0] = 0xff;
+        EXPECT_FALSE(engine.allocateLease4(subnet_, clientid, hwaddr_,
+                                           IOAddress("0.0.0.0"), false, false,
+                                           "", false, CalloutHandlePtr(),
+                                           old_lease_));
+    }
+}
+
 // This test verifies that the iterative allocator really walks over all addresses
 // in all pools in specified subnet. It also must not pick the same address twice
 // unless it runs out of pool space and must start over.
@@ -1556,6 +1886,39 @@ TEST_F(AllocEngine4Test, renewLease4) {
     detailCompareLease(lease, from_mgr);
 }
 
+// This test checks that the expired leases are reclaimed, the one which
+// expired first first, and the valid ones are kept.
+TEST_F(AllocEngine4Test, reclaimExpiredLeases4) {
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE,
+                                                 100, false)));
+    ASSERT_TRUE(engine);
+
+    // Three expired leases, the later ones expired first, and a valid one.
+    vector<IOAddress> addrs;
+    for (int i = 0; i < 4; ++i) {
+        addrs.push_back(IOAddress("192.0.2." +
+                                  boost::lexical_cast<string>(i + 100)));
+        uint8_t hwaddr[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe, static_cast<uint8_t>(i) };
+        const time_t cltt = time(NULL) - (i < 3 ? 500 + 10 * i : 100);
+        Lease4Ptr lease(new Lease4(addrs[i], hwaddr, sizeof(hwaddr), 0, 0,
+                                   495, 100, 200, cltt, subnet_->getID()));
+        ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+    }
+
+    // At most one lease is reclaimed: the one which expired first.
+    EXPECT_EQ(1, engine->reclaimExpiredLeases4(1, 0));
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease4(addrs[0]));
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease4(addrs[2]));
+
+    // Then the others, except the valid lease.
+    EXPECT_EQ(2, engine->reclaimExpiredLeases4(0, 1000));
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease4(addrs[0]));
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease4(addrs[1]));
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease4(addrs[3]));
+    EXPECT_EQ(0, engine->reclaimExpiredLeases4(0, 0));
+}
+
 /// @brief helper class used in Hooks testing in AllocEngine6
 ///
 /// It features a couple of callout functions and buffers to store
@@ -1798,6 +2161,8 @@ public:
     virtual ~HookAllocEngine4Test() {
         HooksManager::preCalloutsLibraryHandle().deregisterAllCallouts(
             "lease4_select");
+        HooksManager::preCalloutsLibraryHandle().deregisterAllCallouts(
+            "lease4_expire");
     }
 
     /// @brief clears out buffers, so callouts can store received arguments
@@ -1827,6 +2192,25 @@ public:
         return (0);
     }
 
+    /// callback that records the expired lease and keeps it
+    static int
+    lease4_expire_skip_callout(CalloutHandle& callout_handle) {
+        callback_name_ = string("lease4_expire");
+        callout_handle.getArgument("lease4", callback_lease4_);
+        callback_argument_names_ = callout_handle.getArgumentNames();
+        callout_handle.setSkip(true);
+        return (0);
+    }
+
+    /// callback that keeps the expired lease of 192.0.2.105 only
+    static int
+    lease4_expire_skip_one_callout(CalloutHandle& callout_handle) {
+        Lease4Ptr lease;
+        callout_handle.getArgument("lease4", lease);
+        callout_handle.setSkip(lease->addr_ == IOAddress("192.0.2.105"));
+        return (0);
+    }
+
     /// callback that overrides the lease with different values
     static int
     lease4_select_different_callout(CalloutHandle& callout_handle) {
@@ -2001,4 +2385,84 @@ TEST_F(HookAllocEngine4Test, change_lease4_select) {
     EXPECT_EQ(valid_override_, from_mgr->valid_lft_);
 }
 
+// This test checks that the lease4_expire callouts are called for the
+// expired leases and can keep them.
+TEST_F(HookAllocEngine4Test, lease4_expire) {
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE,
+                                                 100, false)));
+    ASSERT_TRUE(engine);
+
+    vector<string> libraries; // no libraries at this time
+    HooksManager::loadLibraries(libraries);
+    EXPECT_NO_THROW(HooksManager::preCalloutsLibraryHandle().registerCallout(
+                        "lease4_expire", lease4_expire_skip_callout));
+
+    IOAddress addr("192.0.2.105");
+    uint8_t hwaddr[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe };
+    Lease4Ptr lease(new Lease4(addr, hwaddr, sizeof(hwaddr), 0, 0, 495, 100,
+                               200, time(NULL) - 500, subnet_->getID()));
+    ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+
+    // The callout set the skip flag, so the lease is kept.
+    EXPECT_EQ(0, engine->reclaimExpiredLeases4(0, 0));
+    EXPECT_EQ("lease4_expire", callback_name_);
+    ASSERT_TRUE(callback_lease4_);
+    EXPECT_EQ(addr, callback_lease4_->addr_);
+    ASSERT_EQ(1, callback_argument_names_.size());
+    EXPECT_EQ("lease4", callback_argument_names_[0]);
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease4(addr));
+
+    // Without the callout, the lease is reclaimed.
+    HooksManager::preCalloutsLibraryHandle().deregisterAllCallouts(
+        "lease4_expire");
+    EXPECT_EQ(1, engine->reclaimExpiredLeases4(0, 0));
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease4(addr));
+}
+
+// This test checks that the leases kept by the lease4_expire callouts
+// don't hold the reclamation of the leases which expired after them.
+TEST_F(HookAllocEngine4Test, lease4_expireSkipped) {
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE,
+                                                 100, false)));
+    ASSERT_TRUE(engine);
+
+    vector<string> libraries; // no libraries at this time
+    HooksManager::loadLibraries(libraries);
+    EXPECT_NO_THROW(HooksManager::preCalloutsLibraryHandle().registerCallout(
+                        "lease4_expire", lease4_expire_skip_one_callout));
+
+    // The lease kept by the callout expired first.
+    const IOAddress kept_addr("192.0.2.105");
+    const IOAddress addr1("192.0.2.106");
+    const IOAddress addr2("192.0.2.107");
+    uint8_t hwaddr[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe };
+    Lease4Ptr lease(new Lease4(kept_addr, hwaddr, sizeof(hwaddr), 0, 0, 100,
+                               50, 75, time(NULL) - 500, subnet_->getID()));
+    ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+    hwaddr[5] = 0xff;
+    lease.reset(new Lease4(addr1, hwaddr, sizeof(hwaddr), 0, 0, 100, 50, 75,
+                           time(NULL) - 400, subnet_->getID()));
+    ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+    hwaddr[5] = 0xfd;
+    lease.reset(new Lease4(addr2, hwaddr, sizeof(hwaddr), 0, 0, 100, 50, 75,
+                           time(NULL) - 300, subnet_->getID()));
+    ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+
+    // One lease is reclaimed each time, past the kept one.
+    EXPECT_EQ(1, engine->reclaimExpiredLeases4(1, 0));
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease4(kept_addr));
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease4(addr1));
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease4(addr2));
+
+    EXPECT_EQ(1, engine->reclaimExpiredLeases4(1, 0));
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease4(kept_addr));
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease4(addr2));
+
+    // Only the kept lease is left.
+    EXPECT_EQ(0, engine->reclaimExpiredLeases4(1, 0));
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease4(kept_addr));
+}
+
 }; // End of anonymous namespace
@@ -102,6 +102,34 @@ TEST(CalloutHandleStoreTest, StoreRetrieve) {
     EXPECT_EQ(1, pktptr_2.use_count());
 }
 
+// Check that the handle of the previous packet is reused for a new one when
+// nothing else holds it.
+
+TEST(CalloutHandleStoreTest, Recycle) {
+    Pkt4Ptr pktptr_1(new Pkt4(DHCPDISCOVER, 1234));
+    Pkt4Ptr pktptr_2(new Pkt4(DHCPDISCOVER, 5678));
+    Pkt4Ptr pktptr_3(new Pkt4(DHCPDISCOVER, 9012));
+
+    CalloutHandlePtr chptr = getCalloutHandle(pktptr_1);
+    ASSERT_TRUE(chptr);
+    chptr->setArgument("query4", pktptr_1);
+    CalloutHandle* const saved = chptr.get();
+    chptr.reset();
+
+    // The handle is reset for the new packet.
+    chptr = getCalloutHandle(pktptr_2);
+    EXPECT_EQ(saved, chptr.get());
+    EXPECT_TRUE(chptr->getArgumentNames().empty());
+    EXPECT_EQ(1, pktptr_1.use_count());
+
+    // The handle is held here, so another one is used for the next packet.
+    CalloutHandlePtr chptr_3 = getCalloutHandle(pktptr_3);
+    EXPECT_NE(saved, chptr_3.get());
+
+    // Clear the stored pointers.
+    chptr = getCalloutHandle(Pkt4Ptr());
+}
+
 // The followings is a trival test to check that if the template function
 // is referred to in a separate compilation unit, only one copy of the static
 // objects stored in it are returned.  (For a change, we'll use a Pkt6 as the
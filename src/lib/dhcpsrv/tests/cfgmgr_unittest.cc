@@ -418,6 +418,32 @@ TEST_F(CfgMgrTest, subnet4) {
     EXPECT_FALSE(cfg_mgr.getSubnet4(IOAddress("192.0.2.85"), classify_));
 }
 
+// This test verifies that the generation of the IPv4 subnets changes with
+// the subnets.
+TEST_F(CfgMgrTest, subnets4Generation) {
+    CfgMgr& cfg_mgr = CfgMgr::instance();
+    uint32_t generation = cfg_mgr.getSubnets4Generation();
+    EXPECT_EQ(generation, cfg_mgr.getSubnets4Generation());
+
+    cfg_mgr.addSubnet4(Subnet4Ptr(new Subnet4(IOAddress("192.0.2.0"), 26,
+                                              1, 2, 3)));
+    EXPECT_NE(generation, cfg_mgr.getSubnets4Generation());
+    generation = cfg_mgr.getSubnets4Generation();
+
+    cfg_mgr.reindexSubnets4();
+    EXPECT_NE(generation, cfg_mgr.getSubnets4Generation());
+    generation = cfg_mgr.getSubnets4Generation();
+
+    cfg_mgr.deleteSubnets4();
+    EXPECT_NE(generation, cfg_mgr.getSubnets4Generation());
+    generation = cfg_mgr.getSubnets4Generation();
+
+    // The IPv6 subnets don't change it.
+    cfg_mgr.addSubnet6(Subnet6Ptr(new Subnet6(IOAddress("2001:db8::"), 48,
+                                              1, 2, 3, 4)));
+    EXPECT_EQ(generation, cfg_mgr.getSubnets4Generation());
+}
+
 // This test verifies if the configuration manager is able to hold subnets with
 // their classifier information and return proper subnets, based on those
 // classes.
@@ -496,6 +522,7 @@ TEST_F(CfgMgrTest, subnet4RelayOverride) {
     subnet1->setRelayInfo(IOAddress("10.0.0.1"));
     subnet2->setRelayInfo(IOAddress("10.0.0.2"));
     subnet3->setRelayInfo(IOAddress("10.0.0.3"));
+    cfg_mgr.reindexSubnets4();
 
     // And try again. This time relay-info is there and should match.
     EXPECT_EQ(subnet1, cfg_mgr.getSubnet4(IOAddress("10.0.0.1"), classify_, true));
@@ -532,6 +559,7 @@ TEST_F(CfgMgrTest, subnet6RelayOverride) {
     subnet1->setRelayInfo(IOAddress("2001:db8:ff::1"));
     subnet2->setRelayInfo(IOAddress("2001:db8:ff::2"));
     subnet3->setRelayInfo(IOAddress("2001:db8:ff::3"));
+    cfg_mgr.reindexSubnets6();
 
     // And try again. This time relay-info is there and should match.
     EXPECT_EQ(subnet1, cfg_mgr.getSubnet6(IOAddress("2001:db8:ff::1"), classify_, true));
@@ -0,0 +1,157 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <dhcpsrv/cfgmgr.h>
+#include <dhcpsrv/client_cache.h>
+
+#include <gtest/gtest.h>
+
+using namespace bundy;
+using namespace bundy::asiolink;
+using namespace bundy::dhcp;
+
+namespace {
+
+// Key made of a single byte.
+ClientCache4::Key
+makeKey(uint8_t value) {
+    return (ClientCache4::Key(6, value));
+}
+
+// Entry for a lease of the given address.
+ClientCacheEntry4
+makeEntry(const std::string& addr, uint8_t signature) {
+    ClientCacheEntry4 entry;
+    entry.subnet_.reset(new Subnet4(IOAddress("192.0.2.0"), 24, 1, 2, 3));
+    entry.lease_.reset(new Lease4());
+    entry.lease_->addr_ = IOAddress(addr);
+    entry.options_.reset(new OptionBuffer(3, signature));
+    entry.signature_.assign(2, signature);
+    return (entry);
+}
+
+class ClientCache4Test : public ::testing::Test {
+public:
+    ClientCache4Test() {
+        CfgMgr::instance().deleteSubnets4();
+    }
+
+    ~ClientCache4Test() {
+        CfgMgr::instance().deleteSubnets4();
+    }
+};
+
+// Checks the entries are found by key and signature.
+TEST_F(ClientCache4Test, basic) {
+    ClientCache4 cache(10);
+    EXPECT_EQ(10, cache.getMaxSize());
+    EXPECT_EQ(0, cache.getSize());
+
+    ClientCacheEntry4 entry;
+    EXPECT_FALSE(cache.get(makeKey(1), std::vector<uint8_t>(2, 1), entry));
+
+    cache.add(makeKey(1), makeEntry("192.0.2.1", 1));
+    cache.add(makeKey(2), makeEntry("192.0.2.2", 2));
+    EXPECT_EQ(2, cache.getSize());
+
+    ASSERT_TRUE(cache.get(makeKey(1), std::vector<uint8_t>(2, 1), entry));
+    EXPECT_EQ("192.0.2.1", entry.lease_->addr_.toText());
+    EXPECT_EQ(OptionBuffer(3, 1), *entry.options_);
+    ASSERT_TRUE(cache.get(makeKey(2), std::vector<uint8_t>(2, 2), entry));
+    EXPECT_EQ("192.0.2.2", entry.lease_->addr_.toText());
+
+    // The signature must be the same.
+    EXPECT_FALSE(cache.get(makeKey(1), std::vector<uint8_t>(2, 2), entry));
+    EXPECT_FALSE(cache.get(makeKey(1), std::vector<uint8_t>(3, 1), entry));
+    EXPECT_EQ(2, cache.getSize());
+
+    // The lease can be updated.
+    Lease4Ptr lease(new Lease4(*entry.lease_));
+    lease->cltt_ = 1000;
+    cache.update(makeKey(2), lease);
+    ASSERT_TRUE(cache.get(makeKey(2), std::vector<uint8_t>(2, 2), entry));
+    EXPECT_EQ(lease, entry.lease_);
+
+    // An entry can be replaced.
+    cache.add(makeKey(1), makeEntry("192.0.2.3", 3));
+    EXPECT_EQ(2, cache.getSize());
+    EXPECT_FALSE(cache.get(makeKey(1), std::vector<uint8_t>(2, 1), entry));
+    ASSERT_TRUE(cache.get(makeKey(1), std::vector<uint8_t>(2, 3), entry));
+    EXPECT_EQ("192.0.2.3", entry.lease_->addr_.toText());
+
+    cache.remove(makeKey(1));
+    EXPECT_FALSE(cache.get(makeKey(1), std::vector<uint8_t>(2, 3), entry));
+    EXPECT_EQ(1, cache.getSize());
+    // Removing or updating a missing entry does nothing.
+    cache.remove(makeKey(1));
+    cache.update(makeKey(1), lease);
+    EXPECT_EQ(1, cache.getSize());
+
+    cache.clear();
+    EXPECT_EQ(0, cache.getSize());
+}
+
+// Checks nothing is kept when the cache is disabled.
+TEST_F(ClientCache4Test, disabled) {
+    ClientCache4 cache;
+    EXPECT_EQ(0, cache.getMaxSize());
+    cache.add(makeKey(1), makeEntry("192.0.2.1", 1));
+    EXPECT_EQ(0, cache.getSize());
+}
+
+// Checks the entries used the least recently are dropped.
+TEST_F(ClientCache4Test, maxSize) {
+    ClientCache4 cache(3);
+    ClientCacheEntry4 entry;
+    cache.add(makeKey(1), makeEntry("192.0.2.1", 1));
+    cache.add(makeKey(2), makeEntry("192.0.2.2", 2));
+    cache.add(makeKey(3), makeEntry("192.0.2.3", 3));
+
+    // The first client is used again, so the second one is dropped.
+    ASSERT_TRUE(cache.get(makeKey(1), std::vector<uint8_t>(2, 1), entry));
+    cache.add(makeKey(4), makeEntry("192.0.2.4", 4));
+    EXPECT_EQ(3, cache.getSize());
+    EXPECT_TRUE(cache.get(makeKey(1), std::vector<uint8_t>(2, 1), entry));
+    EXPECT_FALSE(cache.get(makeKey(2), std::vector<uint8_t>(2, 2), entry));
+    EXPECT_TRUE(cache.get(makeKey(3), std::vector<uint8_t>(2, 3), entry));
+    EXPECT_TRUE(cache.get(makeKey(4), std::vector<uint8_t>(2, 4), entry));
+
+    // Reducing the size drops the entries used the least recently.
+    cache.setMaxSize(1);
+    EXPECT_EQ(1, cache.getSize());
+    EXPECT_TRUE(cache.get(makeKey(4), std::vector<uint8_t>(2, 4), entry));
+}
+
+// Checks the entries are dropped when the subnets change.
+TEST_F(ClientCache4Test, reconfiguration) {
+    ClientCache4 cache(10);
+    ClientCacheEntry4 entry;
+    cache.add(makeKey(1), makeEntry("192.0.2.1", 1));
+    ASSERT_TRUE(cache.get(makeKey(1), std::vector<uint8_t>(2, 1), entry));
+
+    const uint32_t generation = CfgMgr::instance().getSubnets4Generation();
+    CfgMgr::instance().addSubnet4(entry.subnet_);
+    EXPECT_NE(generation, CfgMgr::instance().getSubnets4Generation());
+
+    EXPECT_FALSE(cache.get(makeKey(1), std::vector<uint8_t>(2, 1), entry));
+    EXPECT_EQ(0, cache.getSize());
+
+    // The entries added for the new configuration are valid.
+    cache.add(makeKey(1), makeEntry("192.0.2.1", 1));
+    EXPECT_TRUE(cache.get(makeKey(1), std::vector<uint8_t>(2, 1), entry));
+}
+
+} // end of anonymous namespace
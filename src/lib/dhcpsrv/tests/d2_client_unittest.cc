@@ -107,6 +107,39 @@ TEST(D2ClientConfigTest, constructorsAndAccessors) {
                                                        qualifying_suffix)),
                  D2ClientError);
 
+    // Verify that the UNIX protocol requires the path of the socket.
+    ASSERT_THROW(d2_client_config.reset(new
+                                        D2ClientConfig(enable_updates,
+                                                       server_ip,
+                                                       server_port,
+                                                       dhcp_ddns::NCR_UNIX,
+                                                       dhcp_ddns::FMT_BINARY,
+                                                       always_include_fqdn,
+                                                       override_no_update,
+                                                       override_client_update,
+                                                       replace_client_name,
+                                                       generated_prefix,
+                                                       qualifying_suffix,
+                                                       "")),
+                 D2ClientError);
+
+    ASSERT_NO_THROW(d2_client_config.reset(new
+                                           D2ClientConfig(enable_updates,
+                                                          server_ip,
+                                                          server_port,
+                                                          dhcp_ddns::NCR_UNIX,
+                                                          dhcp_ddns::FMT_BINARY,
+                                                          always_include_fqdn,
+                                                          override_no_update,
+                                                         override_client_update,
+                                                          replace_client_name,
+                                                          generated_prefix,
+                                                          qualifying_suffix,
+                                                          "/tmp/d2.sock")));
+    EXPECT_EQ("/tmp/d2.sock", d2_client_config->getServerSocket());
+    EXPECT_EQ(dhcp_ddns::NCR_UNIX, d2_client_config->getNcrProtocol());
+    EXPECT_EQ(dhcp_ddns::FMT_BINARY, d2_client_config->getNcrFormat());
+
     /// @todo if additional validation is added to ctor, this test needs to
     /// expand accordingly.
 }
@@ -226,6 +259,16 @@ TEST(D2ClientConfigTest, equalityOperator) {
     ASSERT_TRUE(test_config);
     EXPECT_FALSE(*ref_config == *test_config);
     EXPECT_TRUE(*ref_config != *test_config);
+
+    // Check a configuration that differs only by server_socket.
+    ASSERT_NO_THROW(test_config.reset(new D2ClientConfig(true,
+                    ref_address, 477,
+                    dhcp_ddns::NCR_UDP, dhcp_ddns::FMT_JSON,
+                    true, true, true, true,
+                    "pre-fix", "suf-fix", "/tmp/d2.sock")));
+    ASSERT_TRUE(test_config);
+    EXPECT_FALSE(*ref_config == *test_config);
+    EXPECT_TRUE(*ref_config != *test_config);
 }
 
 /// @brief Checks the D2ClientMgr constructor.
@@ -284,6 +327,22 @@ TEST(D2ClientMgr, validConfig) {
     EXPECT_NE(*original_config, *updated_config);
 }
 
+/// @brief Checks that D2ClientMgr can send to a Unix socket.
+TEST(D2ClientMgr, unixConfig) {
+    D2ClientMgrPtr d2_client_mgr;
+    ASSERT_NO_THROW(d2_client_mgr.reset(new D2ClientMgr()));
+
+    D2ClientConfigPtr new_cfg;
+    ASSERT_NO_THROW(new_cfg.reset(new D2ClientConfig(true,
+                                  bundy::asiolink::IOAddress("127.0.0.1"), 477,
+                                  dhcp_ddns::NCR_UNIX, dhcp_ddns::FMT_BINARY,
+                                  true, true, true, true,
+                                  "pre-fix", "suf-fix", "/tmp/d2.sock")));
+    ASSERT_NO_THROW(d2_client_mgr->setD2ClientConfig(new_cfg));
+    EXPECT_TRUE(d2_client_mgr->ddnsEnabled());
+    EXPECT_EQ(*new_cfg, *d2_client_mgr->getD2ClientConfig());
+}
+
 
 /// @brief Tests that analyzeFqdn detects invalid combination of both the
 /// client S and N flags set to true.
@@ -0,0 +1,131 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <dhcpsrv/db_connection_pool.h>
+#include <util/threads/thread.h>
+
+#include <boost/bind.hpp>
+#include <gtest/gtest.h>
+
+#include <set>
+
+#include <unistd.h>
+
+using namespace bundy;
+using namespace bundy::dhcp;
+using namespace bundy::util::thread;
+
+namespace {
+
+/// @brief A fake connection, counts its users.
+struct TestConnection {
+    TestConnection() : users_(0), max_users_(0) {}
+    static void initThread() {
+        ++thread_inits_;
+    }
+    int users_;
+    int max_users_;
+    static int thread_inits_;
+};
+
+int TestConnection::thread_inits_ = 0;
+
+typedef DbConnectionPool<TestConnection> TestPool;
+
+// Checks the parsing of the "connections" parameter.
+TEST(DbConnectionPoolTest, parseSize) {
+    EXPECT_EQ(1, TestPool::parseSize(""));
+    EXPECT_EQ(1, TestPool::parseSize("1"));
+    EXPECT_EQ(16, TestPool::parseSize("16"));
+    EXPECT_THROW(TestPool::parseSize("0"), BadValue);
+    EXPECT_THROW(TestPool::parseSize("-1"), BadValue);
+    EXPECT_THROW(TestPool::parseSize("many"), BadValue);
+}
+
+// Checks that the connections are taken and returned by the lockers.
+TEST(DbConnectionPoolTest, locker) {
+    TestPool pool;
+    EXPECT_THROW(pool.add(TestPool::ConnectionPtr()), BadValue);
+    pool.add(TestPool::ConnectionPtr(new TestConnection()));
+    pool.add(TestPool::ConnectionPtr(new TestConnection()));
+    EXPECT_EQ(2, pool.size());
+    EXPECT_EQ(2, pool.getFreeCount());
+
+    {
+        // The thread is prepared each time it takes a connection.
+        TestConnection::thread_inits_ = 0;
+        TestPool::Locker first(pool);
+        EXPECT_EQ(1, pool.getFreeCount());
+        EXPECT_EQ(1, TestConnection::thread_inits_);
+        TestPool::Locker second(pool);
+        EXPECT_EQ(0, pool.getFreeCount());
+        EXPECT_EQ(2, TestConnection::thread_inits_);
+
+        // Each locker holds a different connection.
+        EXPECT_NE(&*first, &*second);
+        std::set<TestConnection*> held;
+        held.insert(&*first);
+        held.insert(second.operator->());
+        EXPECT_EQ(2, held.size());
+    }
+    EXPECT_EQ(2, pool.getFreeCount());
+
+    pool.clear();
+    EXPECT_EQ(0, pool.size());
+    EXPECT_EQ(0, pool.getFreeCount());
+}
+
+/// @brief Uses a connection of the pool for a while.
+void
+useConnection(TestPool* pool, Mutex* mutex) {
+    for (int i = 0; i < 20; ++i) {
+        TestPool::Locker connection(*pool);
+        {
+            Mutex::Locker lock(*mutex);
+            if (++connection->users_ > connection->max_users_) {
+                connection->max_users_ = connection->users_;
+            }
+        }
+        usleep(100);
+        Mutex::Locker lock(*mutex);
+        --connection->users_;
+    }
+}
+
+// Checks that the threads wait for a free connection and never share one.
+TEST(DbConnectionPoolTest, threads) {
+    TestPool pool;
+    pool.add(TestPool::ConnectionPtr(new TestConnection()));
+    pool.add(TestPool::ConnectionPtr(new TestConnection()));
+
+    Mutex mutex;
+    std::vector<boost::shared_ptr<Thread> > threads;
+    for (int i = 0; i < 8; ++i) {
+        threads.push_back(boost::shared_ptr<Thread>(
+            new Thread(boost::bind(&useConnection, &pool, &mutex))));
+    }
+    for (int i = 0; i < threads.size(); ++i) {
+        threads[i]->wait();
+    }
+
+    EXPECT_EQ(2, pool.getFreeCount());
+    for (int i = 0; i < pool.getConnections().size(); ++i) {
+        EXPECT_EQ(0, pool.getConnections()[i]->users_);
+        EXPECT_EQ(1, pool.getConnections()[i]->max_users_);
+    }
+}
+
+}
@@ -87,10 +87,15 @@ public:
             }
 
             // Add the keyword and value - make sure that they are quoted.
-            // The only parameter which is not quoted is persist as it
-            // is a boolean value.
+            // The only parameters which are not quoted are persist and
+            // async-commit as they are boolean values and lfc-interval,
+            // sync-interval and connections as they are integers.
             result += quote + keyval[i] + quote + colon + space;
-            if (std::string(keyval[i]) != "persist") {
+            if ((std::string(keyval[i]) != "persist") &&
+                (std::string(keyval[i]) != "async-commit") &&
+                (std::string(keyval[i]) != "lfc-interval") &&
+                (std::string(keyval[i]) != "sync-interval") &&
+                (std::string(keyval[i]) != "connections")) {
                 result += quote + keyval[i + 1] + quote;
             } else {
                 result += keyval[i + 1];
@@ -281,6 +286,82 @@ TEST_F(DbAccessParserTest, persistV6Memfile) {
                       config, Option::V6);
 }
 
+// Check that the parser accepts the interval of the lease file cleanup.
+TEST_F(DbAccessParserTest, lfcIntervalMemfile) {
+    const char* config[] = {"type", "memfile",
+                            "lfc-interval", "3600",
+                            NULL};
+
+    string json_config = toJson(config);
+    ConstElementPtr json_elements = Element::fromJSON(json_config);
+    EXPECT_TRUE(json_elements);
+
+    TestDbAccessParser parser("lease-database", ParserContext(Option::V4));
+    EXPECT_NO_THROW(parser.build(json_elements));
+
+    checkAccessString("Valid memfile", parser.getDbAccessParameters(),
+                      config);
+
+    // Negative interval is rejected.
+    const char* bad_config[] = {"type", "memfile",
+                                "lfc-interval", "-1",
+                                NULL};
+    json_elements = Element::fromJSON(toJson(bad_config));
+    EXPECT_THROW(parser.build(json_elements), BadValue);
+}
+
+// Check that the parser accepts the interval of the group commit.
+TEST_F(DbAccessParserTest, syncIntervalMemfile) {
+    const char* config[] = {"type", "memfile",
+                            "sync-interval", "5",
+                            NULL};
+
+    string json_config = toJson(config);
+    ConstElementPtr json_elements = Element::fromJSON(json_config);
+    EXPECT_TRUE(json_elements);
+
+    TestDbAccessParser parser("lease-database", ParserContext(Option::V6));
+    EXPECT_NO_THROW(parser.build(json_elements));
+
+    checkAccessString("Valid memfile", parser.getDbAccessParameters(),
+                      config, Option::V6);
+
+    // Negative interval is rejected.
+    const char* bad_config[] = {"type", "memfile",
+                                "sync-interval", "-5",
+                                NULL};
+    json_elements = Element::fromJSON(toJson(bad_config));
+    EXPECT_THROW(parser.build(json_elements), BadValue);
+}
+
+// Check that the parser accepts the size of the connection pool and the
+// commit mode of the SQL backends.
+TEST_F(DbAccessParserTest, connectionsPostgresql) {
+    const char* config[] = {"type",         "postgresql",
+                            "name",         "keatest",
+                            "connections",  "8",
+                            "async-commit", "true",
+                            NULL};
+
+    string json_config = toJson(config);
+    ConstElementPtr json_elements = Element::fromJSON(json_config);
+    EXPECT_TRUE(json_elements);
+
+    TestDbAccessParser parser("lease-database", ParserContext(Option::V4));
+    EXPECT_NO_THROW(parser.build(json_elements));
+
+    checkAccessString("Valid PostgreSQL", parser.getDbAccessParameters(),
+                      config);
+
+    // Negative pool size is rejected.
+    const char* bad_config[] = {"type",        "postgresql",
+                                "name",        "keatest",
+                                "connections", "-2",
+                                NULL};
+    json_elements = Element::fromJSON(toJson(bad_config));
+    EXPECT_THROW(parser.build(json_elements), BadValue);
+}
+
 // Check that the parser works with a valid MySQL configuration
 TEST_F(DbAccessParserTest, validTypeMysql) {
     const char* config[] = {"type",     "mysql",
@@ -793,6 +793,26 @@ TEST_F(ParseConfigTest, validD2Config) {
     EXPECT_FALSE(d2_client_config->getReplaceClientName());
     EXPECT_EQ("", d2_client_config->getGeneratedPrefix());
     EXPECT_EQ("", d2_client_config->getQualifyingSuffix());
+
+    // A configuration sending the requests in binary over a Unix socket.
+    std::string config_str3 =
+        "{ \"dhcp-ddns\" :"
+        "    {"
+        "     \"enable-updates\" : true, "
+        "     \"server-socket\" : \"/tmp/bundy-dhcp-ddns.sock\", "
+        "     \"ncr-protocol\" : \"UNIX\", "
+        "     \"ncr-format\" : \"BINARY\" "
+        "    }"
+        "}";
+
+    rcode = parseConfiguration(config_str3);
+    ASSERT_TRUE(rcode == 0) << error_text_;
+    ASSERT_NO_THROW(d2_client_config = CfgMgr::instance().getD2ClientConfig());
+    ASSERT_TRUE(d2_client_config);
+    EXPECT_TRUE(d2_client_config->getEnableUpdates());
+    EXPECT_EQ("/tmp/bundy-dhcp-ddns.sock", d2_client_config->getServerSocket());
+    EXPECT_EQ(dhcp_ddns::NCR_UNIX, d2_client_config->getNcrProtocol());
+    EXPECT_EQ(dhcp_ddns::FMT_BINARY, d2_client_config->getNcrFormat());
 }
 
 /// @brief Checks that D2 client can be configured with enable flag of
@@ -924,6 +944,14 @@ TEST_F(ParseConfigTest, invalidD2Config) {
         "     \"qualifying-suffix\" : \"test.suffix.\" "
         "    }"
         "}",
+        // Unix socket without a path
+        "{ \"dhcp-ddns\" :"
+        "    {"
+        "     \"enable-updates\" : true, "
+        "     \"ncr-protocol\" : \"UNIX\", "
+        "     \"ncr-format\" : \"BINARY\" "
+        "    }"
+        "}",
         // Unknown format
         "{ \"dhcp-ddns\" :"
         "    {"
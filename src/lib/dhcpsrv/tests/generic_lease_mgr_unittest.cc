@@ -1507,6 +1507,99 @@ GenericLeaseMgrTest::testRecreateLease6() {
 }
 
 
+void
+GenericLeaseMgrTest::testGetExpiredLeases4() {
+    vector<Lease4Ptr> leases = createLeases4();
+
+    // The even leases expired, the later ones first, the odd ones are valid.
+    const time_t now = time(NULL);
+    vector<IOAddress> expected;
+    for (size_t i = 0; i < leases.size(); ++i) {
+        leases[i]->valid_lft_ = 1000;
+        if (i % 2 == 0) {
+            leases[i]->cltt_ = now - 1000 - 10 * (i + 1);
+            expected.insert(expected.begin(), leases[i]->addr_);
+        } else {
+            leases[i]->cltt_ = now;
+        }
+        ASSERT_TRUE(lmptr_->addLease(leases[i]));
+    }
+    lmptr_->commit();
+
+    // All the expired leases are returned, the one which expired first
+    // comes first.
+    Lease4Collection expired;
+    lmptr_->getExpiredLeases4(expired, 0);
+    ASSERT_EQ(expected.size(), expired.size());
+    for (size_t i = 0; i < expired.size(); ++i) {
+        EXPECT_EQ(expected[i], expired[i]->addr_);
+        EXPECT_TRUE(expired[i]->expired());
+    }
+
+    // The number of the leases can be limited.
+    expired.clear();
+    lmptr_->getExpiredLeases4(expired, 2);
+    ASSERT_EQ(2, expired.size());
+    EXPECT_EQ(expected[0], expired[0]->addr_);
+    EXPECT_EQ(expected[1], expired[1]->addr_);
+
+    // A lease renewed is no longer expired.
+    Lease4Ptr renewed = expired[0];
+    renewed->cltt_ = now;
+    lmptr_->updateLease4(renewed);
+    expired.clear();
+    lmptr_->getExpiredLeases4(expired, 0);
+    ASSERT_EQ(expected.size() - 1, expired.size());
+    EXPECT_EQ(expected[1], expired[0]->addr_);
+}
+
+void
+GenericLeaseMgrTest::testGetExpiredLeases6() {
+    vector<Lease6Ptr> leases = createLeases6();
+
+    // The even leases expired, the later ones first, the odd ones are valid.
+    const time_t now = time(NULL);
+    vector<IOAddress> expected;
+    for (size_t i = 0; i < leases.size(); ++i) {
+        leases[i]->valid_lft_ = 1000;
+        if (i % 2 == 0) {
+            leases[i]->cltt_ = now - 1000 - 10 * (i + 1);
+            expected.insert(expected.begin(), leases[i]->addr_);
+        } else {
+            leases[i]->cltt_ = now;
+        }
+        ASSERT_TRUE(lmptr_->addLease(leases[i]));
+    }
+    lmptr_->commit();
+
+    // All the expired leases are returned, the one which expired first
+    // comes first.
+    Lease6Collection expired;
+    lmptr_->getExpiredLeases6(expired, 0);
+    ASSERT_EQ(expected.size(), expired.size());
+    for (size_t i = 0; i < expired.size(); ++i) {
+        EXPECT_EQ(expected[i], expired[i]->addr_);
+        EXPECT_TRUE(expired[i]->expired());
+    }
+
+    // The number of the leases can be limited.
+    expired.clear();
+    lmptr_->getExpiredLeases6(expired, 2);
+    ASSERT_EQ(2, expired.size());
+    EXPECT_EQ(expected[0], expired[0]->addr_);
+    EXPECT_EQ(expected[1], expired[1]->addr_);
+
+    // A lease renewed is no longer expired.
+    Lease6Ptr renewed = expired[0];
+    renewed->cltt_ = now;
+    lmptr_->updateLease6(renewed);
+    expired.clear();
+    lmptr_->getExpiredLeases6(expired, 0);
+    ASSERT_EQ(expected.size() - 1, expired.size());
+    EXPECT_EQ(expected[1], expired[0]->addr_);
+}
+
+
 }; // namespace test
 }; // namespace dhcp
 }; // namespace bundy
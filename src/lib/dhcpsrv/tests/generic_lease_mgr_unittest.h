@@ -245,6 +245,18 @@ public:
     /// persistent storage has been updated as expected.
     void testRecreateLease6();
 
+    /// @brief Checks that the expired DHCPv4 leases are returned.
+    ///
+    /// Adds leases of which half expired, at different times, and checks
+    /// they are returned in the order of their expiration, up to the
+    /// maximum.  A lease renewed is no longer returned.
+    void testGetExpiredLeases4();
+
+    /// @brief Checks that the expired DHCPv6 leases are returned.
+    ///
+    /// Same as @c testGetExpiredLeases4 for DHCPv6 leases.
+    void testGetExpiredLeases6();
+
     /// @brief String forms of IPv4 addresses
     std::vector<std::string>  straddress4_;
 
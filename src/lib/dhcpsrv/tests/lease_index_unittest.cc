@@ -0,0 +1,152 @@
+// Copyright (C) 2013-2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <asiolink/io_address.h>
+#include <dhcpsrv/lease_index.h>
+#include <gtest/gtest.h>
+
+using namespace bundy;
+using namespace bundy::asiolink;
+using namespace bundy::dhcp;
+
+namespace {
+
+// Checks that the free addresses are found around the leased ones.
+TEST(LeaseIndexTest, findFree4) {
+    LeaseIndex index;
+    IOAddress addr("0.0.0.0");
+
+    // Empty index, the first address is free.
+    ASSERT_TRUE(index.findFree(IOAddress("192.0.2.10"),
+                               IOAddress("192.0.2.20"), addr));
+    EXPECT_EQ("192.0.2.10", addr.toText());
+
+    index.add(IOAddress("192.0.2.10"), 32, 100);
+    index.add(IOAddress("192.0.2.12"), 32, 100);
+    index.add(IOAddress("192.0.2.11"), 32, 100);
+    EXPECT_EQ(3, index.getLeaseCount());
+
+    ASSERT_TRUE(index.findFree(IOAddress("192.0.2.10"),
+                               IOAddress("192.0.2.20"), addr));
+    EXPECT_EQ("192.0.2.13", addr.toText());
+    ASSERT_TRUE(index.findFree(IOAddress("192.0.2.9"),
+                               IOAddress("192.0.2.20"), addr));
+    EXPECT_EQ("192.0.2.9", addr.toText());
+
+    // The whole range is leased.
+    EXPECT_FALSE(index.findFree(IOAddress("192.0.2.10"),
+                                IOAddress("192.0.2.12"), addr));
+
+    // Removing the lease splits the leased interval.
+    index.remove(IOAddress("192.0.2.11"));
+    EXPECT_EQ(2, index.getLeaseCount());
+    ASSERT_TRUE(index.findFree(IOAddress("192.0.2.10"),
+                               IOAddress("192.0.2.12"), addr));
+    EXPECT_EQ("192.0.2.11", addr.toText());
+    ASSERT_TRUE(index.findFree(IOAddress("192.0.2.12"),
+                               IOAddress("192.0.2.20"), addr));
+    EXPECT_EQ("192.0.2.13", addr.toText());
+
+    // Removing the unknown lease does nothing.
+    index.remove(IOAddress("192.0.2.50"));
+    EXPECT_EQ(2, index.getLeaseCount());
+
+    index.clear();
+    EXPECT_EQ(0, index.getLeaseCount());
+    ASSERT_TRUE(index.findFree(IOAddress("192.0.2.10"),
+                               IOAddress("192.0.2.20"), addr));
+    EXPECT_EQ("192.0.2.10", addr.toText());
+}
+
+// Checks the edges of the address space.
+TEST(LeaseIndexTest, findFreeEdges) {
+    LeaseIndex index;
+    IOAddress addr("::");
+
+    index.add(IOAddress("255.255.255.255"), 32, 100);
+    index.add(IOAddress("255.255.255.254"), 32, 100);
+    EXPECT_FALSE(index.findFree(IOAddress("255.255.255.254"),
+                                IOAddress("255.255.255.255"), addr));
+
+    index.add(IOAddress("::"), 128, 100);
+    index.add(IOAddress("::ffff:ffff:ffff:ffff"), 128, 100);
+    index.add(IOAddress("::1:0:0:0:0"), 128, 100);
+    ASSERT_TRUE(index.findFree(IOAddress("::"), IOAddress("::ffff"), addr));
+    EXPECT_EQ("::1", addr.toText());
+    // The carry to the high half of the address.
+    EXPECT_FALSE(index.findFree(IOAddress("::ffff:ffff:ffff:ffff"),
+                                IOAddress("::1:0:0:0:0"), addr));
+    index.remove(IOAddress("::1:0:0:0:0"));
+    ASSERT_TRUE(index.findFree(IOAddress("::ffff:ffff:ffff:ffff"),
+                               IOAddress("::1:0:0:0:0"), addr));
+    EXPECT_EQ("0:0:0:1::", addr.toText());
+}
+
+// Checks that the prefixes cover all their addresses.
+TEST(LeaseIndexTest, findFreePrefix) {
+    LeaseIndex index;
+    IOAddress addr("::");
+
+    index.add(IOAddress("2001:db8:1::"), 64, 100);
+    index.add(IOAddress("2001:db8:1:1::"), 64, 100);
+    ASSERT_TRUE(index.findFree(IOAddress("2001:db8:1::"),
+                               IOAddress("2001:db8:1:ff:ffff:ffff:ffff:ffff"),
+                               addr));
+    EXPECT_EQ("2001:db8:1:2::", addr.toText());
+
+    // Prefixes longer than 64 bits.
+    index.add(IOAddress("2001:db8:2::"), 120, 100);
+    ASSERT_TRUE(index.findFree(IOAddress("2001:db8:2::"),
+                               IOAddress("2001:db8:2::ffff"), addr));
+    EXPECT_EQ("2001:db8:2::100", addr.toText());
+
+    index.remove(IOAddress("2001:db8:1::"));
+    ASSERT_TRUE(index.findFree(IOAddress("2001:db8:1::"),
+                               IOAddress("2001:db8:1:ff:ffff:ffff:ffff:ffff"),
+                               addr));
+    EXPECT_EQ("2001:db8:1::", addr.toText());
+}
+
+// Checks that the lease which expired first is found.
+TEST(LeaseIndexTest, findExpired) {
+    LeaseIndex index;
+    IOAddress addr("0.0.0.0");
+
+    index.add(IOAddress("192.0.2.10"), 32, 300);
+    index.add(IOAddress("192.0.2.11"), 32, 200);
+    index.add(IOAddress("192.0.2.12"), 32, 400);
+    index.add(IOAddress("192.0.3.1"), 32, 100);
+
+    EXPECT_FALSE(index.findExpired(IOAddress("192.0.2.0"),
+                                   IOAddress("192.0.2.255"), 200, addr));
+    ASSERT_TRUE(index.findExpired(IOAddress("192.0.2.0"),
+                                  IOAddress("192.0.2.255"), 500, addr));
+    EXPECT_EQ("192.0.2.11", addr.toText());
+
+    // Renewing the lease updates its expiration time.
+    index.add(IOAddress("192.0.2.11"), 32, 1000);
+    EXPECT_EQ(4, index.getLeaseCount());
+    ASSERT_TRUE(index.findExpired(IOAddress("192.0.2.0"),
+                                  IOAddress("192.0.2.255"), 500, addr));
+    EXPECT_EQ("192.0.2.10", addr.toText());
+
+    index.remove(IOAddress("192.0.2.10"));
+    index.remove(IOAddress("192.0.2.12"));
+    EXPECT_FALSE(index.findExpired(IOAddress("192.0.2.0"),
+                                   IOAddress("192.0.2.255"), 500, addr));
+}
+
+} // end of anonymous namespace
@@ -173,6 +173,18 @@ public:
         return (leases6_);
     }
 
+    /// @brief Returns the expired IPv4 leases.
+    ///
+    /// @param expired ignored
+    /// @param max_leases ignored
+    virtual void getExpiredLeases4(Lease4Collection&, size_t) const {}
+
+    /// @brief Returns the expired IPv6 leases.
+    ///
+    /// @param expired ignored
+    /// @param max_leases ignored
+    virtual void getExpiredLeases6(Lease6Collection&, size_t) const {}
+
     /// @brief Updates IPv4 lease.
     ///
     /// @param lease4 The lease to be updated.
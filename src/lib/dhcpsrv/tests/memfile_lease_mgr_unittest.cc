@@ -25,9 +25,14 @@
 #include <dhcpsrv/tests/generic_lease_mgr_unittest.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
 #include <sstream>
 
+#include <time.h>
+#include <unistd.h>
+
 using namespace std;
 using namespace bundy;
 using namespace bundy::asiolink;
@@ -204,6 +209,194 @@ TEST_F(MemfileLeaseMgrTest, persistLeases) {
 }
 
 
+// Checks the names of the files used by the lease file cleanup.
+TEST_F(MemfileLeaseMgrTest, appendSuffix) {
+    EXPECT_EQ("leases4.csv",
+              Memfile_LeaseMgr::appendSuffix("leases4.csv",
+                                             Memfile_LeaseMgr::FILE_CURRENT));
+    EXPECT_EQ("leases4.csv.1",
+              Memfile_LeaseMgr::appendSuffix("leases4.csv",
+                                             Memfile_LeaseMgr::FILE_INPUT));
+    EXPECT_EQ("leases4.csv.2",
+              Memfile_LeaseMgr::appendSuffix("leases4.csv",
+                                             Memfile_LeaseMgr::FILE_PREVIOUS));
+    EXPECT_EQ("leases4.csv.output",
+              Memfile_LeaseMgr::appendSuffix("leases4.csv",
+                                             Memfile_LeaseMgr::FILE_OUTPUT));
+}
+
+// Checks that the lease file cleanup compacts the lease file and that the
+// leases are recovered from the files it leaves, also when interrupted.
+TEST_F(MemfileLeaseMgrTest, lfcExecute4) {
+    LeaseFileIO input(getLeaseFilePath("leasefile4_0.csv.1"));
+    LeaseFileIO previous(getLeaseFilePath("leasefile4_0.csv.2"));
+    LeaseFileIO output(getLeaseFilePath("leasefile4_0.csv.output"));
+
+    startBackend(V4);
+    std::vector<Lease4Ptr> leases = createLeases4();
+    ASSERT_TRUE(lmptr_->addLease(leases[1]));
+    ASSERT_TRUE(lmptr_->addLease(leases[2]));
+    ASSERT_TRUE(lmptr_->addLease(leases[3]));
+    ASSERT_TRUE(lmptr_->deleteLease(leases[3]->addr_));
+    leases[1]->valid_lft_ += 100;
+    ASSERT_NO_THROW(lmptr_->updateLease4(leases[1]));
+
+    Memfile_LeaseMgr* mgr = dynamic_cast<Memfile_LeaseMgr*>(lmptr_);
+    ASSERT_TRUE(mgr);
+    ASSERT_NO_THROW(mgr->lfcExecute());
+
+    // The compacted file holds the header and the two leases, the new
+    // lease file only the header.
+    EXPECT_FALSE(input.exists());
+    EXPECT_FALSE(output.exists());
+    std::string contents = previous.readFile();
+    EXPECT_EQ(3, std::count(contents.begin(), contents.end(), '\n'));
+    contents = io4_.readFile();
+    EXPECT_EQ(1, std::count(contents.begin(), contents.end(), '\n'));
+
+    // The backend is still writing to the lease file.
+    ASSERT_TRUE(lmptr_->addLease(leases[4]));
+
+    reopen(V4);
+    Lease4Ptr lease = lmptr_->getLease4(leases[1]->addr_);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(leases[1]->valid_lft_, lease->valid_lft_);
+    EXPECT_TRUE(lmptr_->getLease4(leases[2]->addr_));
+    EXPECT_FALSE(lmptr_->getLease4(leases[3]->addr_));
+    EXPECT_TRUE(lmptr_->getLease4(leases[4]->addr_));
+
+    // Pretend the cleanup has been interrupted after rotating the file.
+    LeaseMgrFactory::destroy();
+    ASSERT_EQ(0, rename(previous.testfile_.c_str(), input.testfile_.c_str()));
+    startBackend(V4);
+    EXPECT_TRUE(lmptr_->getLease4(leases[1]->addr_));
+    EXPECT_TRUE(lmptr_->getLease4(leases[4]->addr_));
+
+    // The interrupted cleanup is completed, the lease file is left alone.
+    mgr = dynamic_cast<Memfile_LeaseMgr*>(lmptr_);
+    ASSERT_TRUE(mgr);
+    ASSERT_NO_THROW(mgr->lfcExecute());
+    EXPECT_FALSE(input.exists());
+    contents = previous.readFile();
+    EXPECT_EQ(3, std::count(contents.begin(), contents.end(), '\n'));
+    contents = io4_.readFile();
+    EXPECT_EQ(2, std::count(contents.begin(), contents.end(), '\n'));
+
+    // And the next one compacts all the leases.
+    ASSERT_NO_THROW(mgr->lfcExecute());
+    contents = previous.readFile();
+    EXPECT_EQ(4, std::count(contents.begin(), contents.end(), '\n'));
+
+    reopen(V4);
+    EXPECT_TRUE(lmptr_->getLease4(leases[1]->addr_));
+    EXPECT_TRUE(lmptr_->getLease4(leases[2]->addr_));
+    EXPECT_TRUE(lmptr_->getLease4(leases[4]->addr_));
+}
+
+// Checks that the DHCPv6 lease file is compacted too.
+TEST_F(MemfileLeaseMgrTest, lfcExecute6) {
+    LeaseFileIO previous(getLeaseFilePath("leasefile6_0.csv.2"));
+
+    startBackend(V6);
+    std::vector<Lease6Ptr> leases = createLeases6();
+    ASSERT_TRUE(lmptr_->addLease(leases[1]));
+    ASSERT_TRUE(lmptr_->addLease(leases[2]));
+    ASSERT_TRUE(lmptr_->deleteLease(leases[2]->addr_));
+
+    Memfile_LeaseMgr* mgr = dynamic_cast<Memfile_LeaseMgr*>(lmptr_);
+    ASSERT_TRUE(mgr);
+    ASSERT_NO_THROW(mgr->lfcExecute());
+    std::string contents = previous.readFile();
+    EXPECT_EQ(2, std::count(contents.begin(), contents.end(), '\n'));
+
+    reopen(V6);
+    EXPECT_TRUE(lmptr_->getLease6(leases[1]->type_, leases[1]->addr_));
+    EXPECT_FALSE(lmptr_->getLease6(leases[2]->type_, leases[2]->addr_));
+}
+
+// Checks that the cleanup is run periodically when configured.
+TEST_F(MemfileLeaseMgrTest, lfcInterval) {
+    LeaseFileIO previous(getLeaseFilePath("leasefile4_0.csv.2"));
+
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "4";
+    pmap["name"] = getLeaseFilePath("leasefile4_0.csv");
+    pmap["lfc-interval"] = "bogus";
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr;
+    EXPECT_THROW(lease_mgr.reset(new Memfile_LeaseMgr(pmap)), bundy::BadValue);
+
+    pmap["lfc-interval"] = "1";
+    ASSERT_NO_THROW(lease_mgr.reset(new Memfile_LeaseMgr(pmap)));
+    EXPECT_EQ(1, lease_mgr->getLFCInterval());
+    std::vector<Lease4Ptr> leases = createLeases4();
+    ASSERT_TRUE(lease_mgr->addLease(leases[1]));
+
+    for (int i = 0; i < 50 && !previous.exists(); ++i) {
+        usleep(100000);
+    }
+    EXPECT_TRUE(previous.exists());
+    EXPECT_TRUE(lease_mgr->getLease4(leases[1]->addr_));
+
+    // The destructor stops the cleanup thread.
+    lease_mgr.reset();
+}
+
+// Checks that the group commit flushes the lease records written.
+TEST_F(MemfileLeaseMgrTest, syncInterval) {
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "6";
+    pmap["name"] = getLeaseFilePath("leasefile6_0.csv");
+    pmap["sync-interval"] = "bogus";
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr;
+    EXPECT_THROW(lease_mgr.reset(new Memfile_LeaseMgr(pmap)), bundy::BadValue);
+
+    pmap["sync-interval"] = "10";
+    ASSERT_NO_THROW(lease_mgr.reset(new Memfile_LeaseMgr(pmap)));
+    EXPECT_EQ(10, lease_mgr->getSyncInterval());
+
+    // Nothing to wait for yet.
+    EXPECT_NO_THROW(lease_mgr->sync());
+
+    std::vector<Lease6Ptr> leases = createLeases6();
+    ASSERT_TRUE(lease_mgr->addLease(leases[1]));
+    ASSERT_TRUE(lease_mgr->addLease(leases[2]));
+
+    // Once sync returns the records are in the file.
+    ASSERT_NO_THROW(lease_mgr->sync());
+    const std::string contents = io6_.readFile();
+    EXPECT_NE(std::string::npos, contents.find(leases[1]->addr_.toText()));
+    EXPECT_NE(std::string::npos, contents.find(leases[2]->addr_.toText()));
+
+    // The destructor stops the group commit thread.
+    lease_mgr.reset();
+}
+
+// Checks that a single writer flushes the records itself rather than
+// waiting for the group commit thread.
+TEST_F(MemfileLeaseMgrTest, syncAlone) {
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "6";
+    pmap["name"] = getLeaseFilePath("leasefile6_0.csv");
+    // Far longer than the test may take.
+    pmap["sync-interval"] = "100000";
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr;
+    ASSERT_NO_THROW(lease_mgr.reset(new Memfile_LeaseMgr(pmap)));
+
+    std::vector<Lease6Ptr> leases = createLeases6();
+    for (int i = 1; i < 4; ++i) {
+        ASSERT_TRUE(lease_mgr->addLease(leases[i]));
+        const time_t start = time(NULL);
+        ASSERT_NO_THROW(lease_mgr->sync());
+        EXPECT_GE(1, time(NULL) - start);
+        const std::string contents = io6_.readFile();
+        EXPECT_NE(std::string::npos,
+                  contents.find(leases[i]->addr_.toText()));
+    }
+
+    // The destructor stops the group commit thread.
+    lease_mgr.reset();
+}
+
 // Checks that adding/getting/deleting a Lease6 object works.
 TEST_F(MemfileLeaseMgrTest, addGetDelete6) {
     startBackend(V6);
@@ -221,6 +414,28 @@ TEST_F(MemfileLeaseMgrTest, basicLease4) {
     testBasicLease4();
 }
 
+// Checks that the lease index is kept up to date with the leases.
+TEST_F(MemfileLeaseMgrTest, leaseIndex) {
+    startBackend(V4);
+    const LeaseIndex* index = lmptr_->getLeaseIndex(Lease::TYPE_V4);
+    ASSERT_TRUE(index);
+
+    std::vector<Lease4Ptr> leases = createLeases4();
+    ASSERT_TRUE(lmptr_->addLease(leases[1]));
+    ASSERT_TRUE(lmptr_->addLease(leases[2]));
+    EXPECT_EQ(2, index->getLeaseCount());
+    EXPECT_EQ(0, lmptr_->getLeaseIndex(Lease::TYPE_NA)->getLeaseCount());
+
+    IOAddress addr("0.0.0.0");
+    EXPECT_FALSE(index->findFree(leases[1]->addr_, leases[1]->addr_, addr));
+    ASSERT_TRUE(lmptr_->deleteLease(leases[1]->addr_));
+    EXPECT_EQ(1, index->getLeaseCount());
+    EXPECT_TRUE(index->findFree(leases[1]->addr_, leases[1]->addr_, addr));
+
+    EXPECT_THROW(lmptr_->getLeaseIndex(static_cast<Lease::Type>(10)),
+                 bundy::BadValue);
+}
+
 /// @todo Write more memfile tests
 
 // Simple test about lease4 retrieval through client id method
@@ -317,18 +532,13 @@ TEST_F(MemfileLeaseMgrTest, basicLease6) {
 ///
 /// Adds leases to the database and checks that they can be accessed via
 /// a combination of DUID and IAID.
-/// @todo: test disabled, because Memfile_LeaseMgr::getLeases6(Lease::Type,
-/// const DUID& duid, uint32_t iaid) const is not implemented yet.
-TEST_F(MemfileLeaseMgrTest, DISABLED_getLeases6DuidIaid) {
+TEST_F(MemfileLeaseMgrTest, getLeases6DuidIaid) {
     startBackend(V6);
     testGetLeases6DuidIaid();
 }
 
 // Check that the system can cope with a DUID of allowed size.
-
-/// @todo: test disabled, because Memfile_LeaseMgr::getLeases6(Lease::Type,
-/// const DUID& duid, uint32_t iaid) const is not implemented yet.
-TEST_F(MemfileLeaseMgrTest, DISABLED_getLeases6DuidSize) {
+TEST_F(MemfileLeaseMgrTest, getLeases6DuidSize) {
     startBackend(V6);
     testGetLeases6DuidSize();
 }
@@ -384,6 +594,69 @@ TEST_F(MemfileLeaseMgrTest, DISABLED_updateLease6) {
     testUpdateLease6();
 }
 
+// Checks that a DHCPv4 lease colliding with another one on the hardware
+// address and subnet is refused before it is written to the lease file,
+// and that such a lease file is not loaded.
+TEST_F(MemfileLeaseMgrTest, conflictingLease4) {
+    startBackend(V4);
+    std::vector<Lease4Ptr> leases = createLeases4();
+    ASSERT_TRUE(lmptr_->addLease(leases[1]));
+    ASSERT_TRUE(lmptr_->addLease(leases[2]));
+    const std::string contents = io4_.readFile();
+
+    // Lease 3 has the hardware address and subnet of lease 1.
+    leases[3]->subnet_id_ = leases[1]->subnet_id_;
+    EXPECT_FALSE(lmptr_->addLease(leases[3]));
+
+    Lease4Ptr lease(new Lease4(*leases[2]));
+    lease->hwaddr_ = leases[1]->hwaddr_;
+    EXPECT_THROW(lmptr_->updateLease4(lease), DbOperationError);
+    EXPECT_EQ(contents, io4_.readFile());
+    lease = lmptr_->getLease4(leases[2]->addr_);
+    ASSERT_TRUE(lease);
+    EXPECT_TRUE(lease->hwaddr_ == leases[2]->hwaddr_);
+    EXPECT_FALSE(lmptr_->getLease4(leases[3]->addr_));
+
+    LeaseMgrFactory::destroy();
+    io4_.writeFile("address,hwaddr,client_id,valid_lifetime,expire,subnet_id,"
+                   "fqdn_fwd,fqdn_rev,hostname\n"
+                   "192.0.2.1,06:07:08:09:0a:bc,,200,200,8,1,1,\n"
+                   "192.0.2.2,06:07:08:09:0a:bc,,200,200,8,1,1,\n");
+    EXPECT_THROW(LeaseMgrFactory::create(getConfigString(V4)),
+                 DbOperationError);
+}
+
+// Checks that a DHCPv6 lease colliding with another one on the DUID, IAID
+// and subnet is refused before it is written to the lease file, and that
+// such a lease file is not loaded.
+TEST_F(MemfileLeaseMgrTest, conflictingLease6) {
+    startBackend(V6);
+    std::vector<Lease6Ptr> leases = createLeases6();
+    ASSERT_TRUE(lmptr_->addLease(leases[1]));
+    ASSERT_TRUE(lmptr_->addLease(leases[2]));
+    const std::string contents = io6_.readFile();
+
+    Lease6Ptr lease(new Lease6(*leases[2]));
+    lease->duid_ = leases[1]->duid_;
+    lease->iaid_ = leases[1]->iaid_;
+    EXPECT_THROW(lmptr_->updateLease6(lease), DbOperationError);
+    EXPECT_EQ(contents, io6_.readFile());
+    lease = lmptr_->getLease6(leases[2]->type_, leases[2]->addr_);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(leases[2]->iaid_, lease->iaid_);
+
+    LeaseMgrFactory::destroy();
+    io6_.writeFile("address,duid,valid_lifetime,expire,subnet_id,"
+                   "pref_lifetime,lease_type,iaid,prefix_len,fqdn_fwd,"
+                   "fqdn_rev,hostname\n"
+                   "2001:db8:1::1,00:01:02:03:04:05:06:0a:0b:0c:0d:0e:0f,"
+                   "200,200,8,100,0,7,0,1,1,\n"
+                   "2001:db8:1::2,00:01:02:03:04:05:06:0a:0b:0c:0d:0e:0f,"
+                   "200,200,8,100,0,7,0,1,1,\n");
+    EXPECT_THROW(LeaseMgrFactory::create(getConfigString(V6)),
+                 DbOperationError);
+}
+
 /// @brief DHCPv4 Lease recreation tests
 ///
 /// Checks that the lease can be created, deleted and recreated with
@@ -404,6 +677,20 @@ TEST_F(MemfileLeaseMgrTest, testRecreateLease6) {
     testRecreateLease6();
 }
 
+/// @brief Checks that the expired DHCPv4 leases are returned in the order
+/// of their expiration.
+TEST_F(MemfileLeaseMgrTest, getExpiredLeases4) {
+    startBackend(V4);
+    testGetExpiredLeases4();
+}
+
+/// @brief Checks that the expired DHCPv6 leases are returned in the order
+/// of their expiration.
+TEST_F(MemfileLeaseMgrTest, getExpiredLeases6) {
+    startBackend(V6);
+    testGetExpiredLeases6();
+}
+
 // The following tests are not applicable for memfile. When adding
 // new tests to the list here, make sure to provide brief explanation
 // why they are not applicable:
@@ -257,6 +257,40 @@ TEST(MySqlOpenTest, OpenDatabase) {
     destroySchema();
 }
 
+/// @brief Check that several connections can be opened
+///
+/// The leases written on one connection of the pool are visible on the
+/// others.
+TEST(MySqlOpenTest, ConnectionPool) {
+    destroySchema();
+    createSchema();
+
+    ASSERT_NO_THROW(LeaseMgrFactory::create(validConnectionString() +
+                                            " connections=4"));
+    MySqlLeaseMgr* lease_mgr =
+        dynamic_cast<MySqlLeaseMgr*>(&LeaseMgrFactory::instance());
+    ASSERT_TRUE(lease_mgr);
+    EXPECT_EQ(4, lease_mgr->getConnectionCount());
+
+    Lease4Ptr lease(new Lease4(IOAddress("192.0.2.1"), NULL, 0, NULL, 0,
+                               100, 50, 75, time(NULL), 1));
+    lease->hwaddr_.assign(6, 1);
+    EXPECT_TRUE(lease_mgr->addLease(lease));
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(lease_mgr->getLease4(lease->addr_));
+    }
+    LeaseMgrFactory::destroy();
+
+    // The pool must not be empty.
+    EXPECT_THROW(LeaseMgrFactory::create(validConnectionString() +
+                                         " connections=0"), BadValue);
+    // The commit mode is set on the server only.
+    EXPECT_THROW(LeaseMgrFactory::create(validConnectionString() +
+                                         " async-commit=true"), BadValue);
+
+    destroySchema();
+}
+
 /// @brief Check the getType() method
 ///
 /// getType() returns a string giving the type of the backend, which should
@@ -506,4 +540,16 @@ TEST_F(MySqlLeaseMgrTest, testRecreateLease6) {
     testRecreateLease6();
 }
 
+/// @brief Checks that the expired DHCPv4 leases are returned in the order
+/// of their expiration.
+TEST_F(MySqlLeaseMgrTest, getExpiredLeases4) {
+    testGetExpiredLeases4();
+}
+
+/// @brief Checks that the expired DHCPv6 leases are returned in the order
+/// of their expiration.
+TEST_F(MySqlLeaseMgrTest, getExpiredLeases6) {
+    testGetExpiredLeases6();
+}
+
 }; // Of anonymous namespace
@@ -0,0 +1,88 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <dhcpsrv/resource_locks.h>
+#include <util/threads/thread.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+
+#include <unistd.h>
+
+using namespace bundy;
+using namespace bundy::dhcp;
+using namespace bundy::util::thread;
+
+namespace {
+
+// Key made of a single byte.
+ResourceLocks::Key
+makeKey(uint8_t value) {
+    return (ResourceLocks::Key(1, value));
+}
+
+// Locks the key, checks nobody else holds it and increments the counter.
+void
+lockAndCount(ResourceLocks* locks, uint8_t value, int* counter,
+             int* holders) {
+    for (int i = 0; i < 100; ++i) {
+        ResourceLocks::Locker lock(*locks, makeKey(value));
+        ASSERT_TRUE(lock.locked());
+        EXPECT_EQ(0, (*holders)++);
+        ++*counter;
+        --*holders;
+    }
+}
+
+// Checks the locks are held and released with the lockers.
+TEST(ResourceLocksTest, basic) {
+    ResourceLocks locks;
+    EXPECT_EQ(0, locks.getLockedCount());
+    {
+        ResourceLocks::Locker lock1(locks, makeKey(1));
+        EXPECT_TRUE(lock1.locked());
+        EXPECT_TRUE(locks.isLocked(makeKey(1)));
+        EXPECT_FALSE(locks.isLocked(makeKey(2)));
+
+        // A different key can be locked at the same time.
+        ResourceLocks::Locker lock2(locks, makeKey(2), false);
+        EXPECT_TRUE(lock2.locked());
+        EXPECT_EQ(2, locks.getLockedCount());
+
+        // The same one can't.
+        ResourceLocks::Locker lock3(locks, makeKey(1), false);
+        EXPECT_FALSE(lock3.locked());
+        EXPECT_EQ(2, locks.getLockedCount());
+    }
+    EXPECT_EQ(0, locks.getLockedCount());
+    EXPECT_FALSE(locks.isLocked(makeKey(1)));
+}
+
+// Checks the threads locking the same key exclude each other.
+TEST(ResourceLocksTest, threads) {
+    ResourceLocks locks;
+    int counter = 0;
+    int holders = 0;
+    Thread thread1(boost::bind(lockAndCount, &locks, 1, &counter, &holders));
+    Thread thread2(boost::bind(lockAndCount, &locks, 1, &counter, &holders));
+    thread1.wait();
+    thread2.wait();
+    EXPECT_EQ(200, counter);
+    EXPECT_EQ(0, locks.getLockedCount());
+}
+
+} // end of anonymous namespace
@@ -0,0 +1,147 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <asiolink/io_address.h>
+#include <dhcp/dhcp6.h>
+#include <dhcpsrv/subnet_index.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace bundy;
+using namespace bundy::asiolink;
+using namespace bundy::dhcp;
+
+namespace {
+
+// Checks that the addresses are matched with the subnets of all the
+// prefix lengths, the first subnet of the configuration winning.
+TEST(SubnetIndexTest, findByAddress4) {
+    SubnetIndex index;
+    ClientClasses classes;
+
+    index.add(Subnet4Ptr(new Subnet4(IOAddress("192.0.2.0"), 26, 1, 2, 3)));
+    index.add(Subnet4Ptr(new Subnet4(IOAddress("192.0.2.64"), 26, 1, 2, 3)));
+    // Overlaps both the previous ones.
+    index.add(Subnet4Ptr(new Subnet4(IOAddress("192.0.2.0"), 24, 1, 2, 3)));
+    index.add(Subnet4Ptr(new Subnet4(IOAddress("10.0.0.0"), 8, 1, 2, 3)));
+
+    EXPECT_EQ(0, index.findByAddress(IOAddress("192.0.2.0"), classes, false));
+    EXPECT_EQ(0, index.findByAddress(IOAddress("192.0.2.63"), classes,
+                                     false));
+    EXPECT_EQ(1, index.findByAddress(IOAddress("192.0.2.64"), classes,
+                                     false));
+    EXPECT_EQ(2, index.findByAddress(IOAddress("192.0.2.200"), classes,
+                                     false));
+    EXPECT_EQ(3, index.findByAddress(IOAddress("10.255.0.1"), classes,
+                                     false));
+    EXPECT_EQ(SubnetIndex::NOT_FOUND,
+              index.findByAddress(IOAddress("192.0.3.1"), classes, false));
+
+    // The IPv6 addresses are never in the IPv4 subnets.
+    EXPECT_EQ(SubnetIndex::NOT_FOUND,
+              index.findByAddress(IOAddress("::c000:201"), classes, false));
+
+    index.clear();
+    EXPECT_EQ(SubnetIndex::NOT_FOUND,
+              index.findByAddress(IOAddress("192.0.2.0"), classes, false));
+}
+
+// Checks that the client classes and the relay addresses are taken into
+// account.
+TEST(SubnetIndexTest, relayAndClasses4) {
+    SubnetIndex index;
+    ClientClasses classes;
+
+    Subnet4Ptr subnet1(new Subnet4(IOAddress("192.0.2.0"), 24, 1, 2, 3));
+    subnet1->allowClientClass("foo");
+    Subnet4Ptr subnet2(new Subnet4(IOAddress("192.0.2.0"), 25, 1, 2, 3));
+    Subnet4Ptr subnet3(new Subnet4(IOAddress("198.51.100.0"), 24, 1, 2, 3));
+    subnet3->setRelayInfo(IOAddress("192.0.2.1"));
+    index.add(subnet1);
+    index.add(subnet2);
+    index.add(subnet3);
+
+    // The first subnet doesn't serve the client.
+    EXPECT_EQ(1, index.findByAddress(IOAddress("192.0.2.1"), classes, false));
+    classes.insert("foo");
+    EXPECT_EQ(0, index.findByAddress(IOAddress("192.0.2.1"), classes, false));
+
+    // The relay address of the third subnet is in the other subnets, the
+    // first one matching wins.
+    EXPECT_EQ(0, index.findByAddress(IOAddress("192.0.2.1"), classes, true));
+    classes.clear();
+    EXPECT_EQ(1, index.findByAddress(IOAddress("192.0.2.1"), classes, true));
+    subnet2->allowClientClass("bar");
+    EXPECT_EQ(2, index.findByAddress(IOAddress("192.0.2.1"), classes, true));
+    EXPECT_EQ(SubnetIndex::NOT_FOUND,
+              index.findByAddress(IOAddress("192.0.2.1"), classes, false));
+}
+
+// Checks the lookups of the IPv6 subnets.
+TEST(SubnetIndexTest, find6) {
+    SubnetIndex index;
+    ClientClasses classes;
+
+    Subnet6Ptr subnet1(new Subnet6(IOAddress("2001:db8:1::"), 48, 1, 2, 3,
+                                   4));
+    subnet1->setIface("eth0");
+    Subnet6Ptr subnet2(new Subnet6(IOAddress("2001:db8:1:2::"), 64, 1, 2, 3,
+                                   4));
+    Subnet6Ptr subnet3(new Subnet6(IOAddress("2001:db8:1:2:3::"), 80, 1, 2,
+                                   3, 4));
+    Subnet6Ptr subnet4(new Subnet6(IOAddress("::"), 0, 1, 2, 3, 4));
+    subnet4->setIface("eth1");
+    OptionPtr ifaceid(new Option(Option::V6, D6O_INTERFACE_ID,
+                                 OptionBuffer(4, 1)));
+    index.add(subnet3);
+    index.add(subnet2, ifaceid);
+    index.add(subnet1);
+    index.add(subnet4);
+
+    EXPECT_EQ(0, index.findByAddress(IOAddress("2001:db8:1:2:3::1"),
+                                     classes, false));
+    EXPECT_EQ(1, index.findByAddress(IOAddress("2001:db8:1:2:4::1"),
+                                     classes, false));
+    EXPECT_EQ(2, index.findByAddress(IOAddress("2001:db8:1:3::1"),
+                                     classes, false));
+    EXPECT_EQ(3, index.findByAddress(IOAddress("3000::1"), classes, false));
+    EXPECT_EQ(SubnetIndex::NOT_FOUND,
+              index.findByAddress(IOAddress("192.0.2.1"), classes, false));
+
+    EXPECT_EQ(2, index.findByIface("eth0", classes));
+    EXPECT_EQ(3, index.findByIface("eth1", classes));
+    EXPECT_EQ(SubnetIndex::NOT_FOUND, index.findByIface("eth2", classes));
+
+    // The option type is compared too.
+    EXPECT_EQ(1, index.findByInterfaceId(OptionPtr(
+        new Option(Option::V6, D6O_INTERFACE_ID, OptionBuffer(4, 1))),
+                                         classes));
+    EXPECT_EQ(SubnetIndex::NOT_FOUND, index.findByInterfaceId(OptionPtr(
+        new Option(Option::V6, D6O_INTERFACE_ID, OptionBuffer(4, 2))),
+                                         classes));
+    EXPECT_EQ(SubnetIndex::NOT_FOUND, index.findByInterfaceId(OptionPtr(
+        new Option(Option::V6, D6O_SUBSCRIBER_ID, OptionBuffer(4, 1))),
+                                         classes));
+    EXPECT_EQ(SubnetIndex::NOT_FOUND,
+              index.findByInterfaceId(OptionPtr(), classes));
+
+    EXPECT_TRUE(index.hasId(subnet1->getID()));
+    index.clear();
+    EXPECT_FALSE(index.hasId(subnet1->getID()));
+}
+
+}
@@ -911,6 +911,34 @@ TEST(Subnet6Test, addVendorOptions) {
 
 
 // This test verifies that inRange() and inPool() methods work properly.
+// This test verifies that the options are packed in their descriptors.
+TEST(Subnet6Test, packOptions) {
+    Subnet6Ptr subnet(new Subnet6(IOAddress("2001:db8:1::"), 56, 1, 2, 3, 4));
+    OptionPtr option(new Option(Option::V6, 100, OptionBuffer(2, 0xFF)));
+    subnet->addOption(option, false, "dhcp6");
+    OptionPtr vendor_option(new Option(Option::V6, 101, OptionBuffer(1, 1)));
+    subnet->addVendorOption(vendor_option, false, 12345678);
+    EXPECT_FALSE(subnet->getOptionDescriptor("dhcp6", 100).packed);
+
+    subnet->packOptions();
+    Subnet::OptionDescriptor desc = subnet->getOptionDescriptor("dhcp6", 100);
+    EXPECT_EQ(option, desc.option);
+    ASSERT_TRUE(desc.packed);
+    const uint8_t expected[] = { 0, 100, 0, 2, 0xFF, 0xFF };
+    EXPECT_EQ(OptionBuffer(expected, expected + sizeof(expected)),
+              *desc.packed);
+
+    desc = subnet->getVendorOptionDescriptor(12345678, 101);
+    EXPECT_EQ(vendor_option, desc.option);
+    ASSERT_TRUE(desc.packed);
+    EXPECT_EQ(5, desc.packed->size());
+
+    // The options added afterwards are not packed.
+    subnet->addOption(OptionPtr(new Option(Option::V6, 102)), false, "dhcp6");
+    EXPECT_FALSE(subnet->getOptionDescriptor("dhcp6", 102).packed);
+    EXPECT_TRUE(subnet->getOptionDescriptor("dhcp6", 100).packed);
+}
+
 TEST(Subnet6Test, inRangeinPool) {
     Subnet6Ptr subnet(new Subnet6(IOAddress("2001:db8::"), 32, 1, 2, 3, 4));
 
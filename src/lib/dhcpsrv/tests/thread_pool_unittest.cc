@@ -0,0 +1,206 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <dhcpsrv/thread_pool.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+
+#include <unistd.h>
+
+using namespace bundy;
+using namespace bundy::dhcp;
+using namespace bundy::util::thread;
+
+namespace {
+
+/// @brief Test fixture class for @c ThreadPool.
+///
+/// Provides the tasks run by the pool: one counting the runs and one
+/// blocking until it is released by the test.
+class ThreadPoolTest : public ::testing::Test {
+public:
+    /// @brief Constructor.
+    ThreadPoolTest() : count_(0), running_(0), blocked_(0), released_(false) {
+    }
+
+    /// @brief Task counting its runs.
+    void count() {
+        Mutex::Locker lock(mutex_);
+        ++count_;
+    }
+
+    /// @brief Task blocking until @c release() is called.
+    void block() {
+        Mutex::Locker lock(mutex_);
+        ++blocked_;
+        cond_.broadcast();
+        while (!released_) {
+            cond_.wait(mutex_);
+        }
+        ++count_;
+    }
+
+    /// @brief Wait until the given number of @c block() tasks started.
+    void waitBlocked(size_t blocked) {
+        Mutex::Locker lock(mutex_);
+        while (blocked_ < blocked) {
+            cond_.wait(mutex_);
+        }
+    }
+
+    /// @brief Let the @c block() tasks complete.
+    void release() {
+        Mutex::Locker lock(mutex_);
+        released_ = true;
+        cond_.broadcast();
+    }
+
+    /// @brief Task checking that no other one runs at the same time.
+    void exclusive() {
+        {
+            Mutex::Locker lock(mutex_);
+            ++running_;
+            EXPECT_EQ(1, running_);
+        }
+        usleep(1000);
+        Mutex::Locker lock(mutex_);
+        --running_;
+        ++count_;
+    }
+
+    /// @brief Return the number of the tasks run.
+    size_t getCount() {
+        Mutex::Locker lock(mutex_);
+        return (count_);
+    }
+
+    size_t count_;
+    size_t running_;
+    size_t blocked_;
+    bool released_;
+    Mutex mutex_;
+    CondVar cond_;
+};
+
+// Without the threads the tasks are run right away.
+TEST_F(ThreadPoolTest, noThreads) {
+    ThreadPool pool;
+    EXPECT_EQ(0, pool.getThreadCount());
+    EXPECT_TRUE(pool.add(boost::bind(&ThreadPoolTest::count, this)));
+    EXPECT_EQ(1, getCount());
+    EXPECT_EQ(0, pool.getQueueSize());
+
+    // Stopping the pool without the threads does nothing.
+    EXPECT_NO_THROW(pool.stop());
+}
+
+// The tasks are all run by the threads and stopping the pool completes
+// the queued ones.
+TEST_F(ThreadPoolTest, threads) {
+    ThreadPool pool;
+    pool.start(4);
+    EXPECT_EQ(4, pool.getThreadCount());
+    EXPECT_THROW(pool.start(2), bundy::InvalidOperation);
+
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(pool.add(boost::bind(&ThreadPoolTest::count, this)));
+    }
+    pool.stop();
+    EXPECT_EQ(0, pool.getThreadCount());
+    EXPECT_EQ(100, getCount());
+    EXPECT_EQ(0, pool.getDropped());
+
+    // The pool can be started again.
+    pool.start(2);
+    EXPECT_TRUE(pool.add(boost::bind(&ThreadPoolTest::count, this)));
+    pool.stop();
+    EXPECT_EQ(101, getCount());
+}
+
+// The tasks are dropped when the queue is full.
+TEST_F(ThreadPoolTest, queueFull) {
+    ThreadPool pool(2);
+    EXPECT_EQ(2, pool.getMaxQueueSize());
+    pool.start(1);
+
+    // Keep the only thread busy.
+    ASSERT_TRUE(pool.add(boost::bind(&ThreadPoolTest::block, this)));
+    waitBlocked(1);
+
+    EXPECT_TRUE(pool.add(boost::bind(&ThreadPoolTest::count, this)));
+    EXPECT_TRUE(pool.add(boost::bind(&ThreadPoolTest::count, this)));
+    EXPECT_EQ(2, pool.getQueueSize());
+    EXPECT_FALSE(pool.add(boost::bind(&ThreadPoolTest::count, this)));
+    EXPECT_EQ(1, pool.getDropped());
+
+    release();
+    pool.stop();
+    EXPECT_EQ(3, getCount());
+}
+
+// No task runs while the pool is paused.
+TEST_F(ThreadPoolTest, pause) {
+    ThreadPool pool;
+    pool.start(2);
+    {
+        ThreadPool::Pause pause(pool);
+        for (int i = 0; i < 10; ++i) {
+            EXPECT_TRUE(pool.add(boost::bind(&ThreadPoolTest::count, this)));
+        }
+        usleep(10000);
+        EXPECT_EQ(0, getCount());
+        EXPECT_EQ(10, pool.getQueueSize());
+    }
+    pool.stop();
+    EXPECT_EQ(10, getCount());
+}
+
+// Pausing waits for the running tasks to complete.
+TEST_F(ThreadPoolTest, pauseWaits) {
+    ThreadPool pool;
+    pool.start(2);
+    ASSERT_TRUE(pool.add(boost::bind(&ThreadPoolTest::block, this)));
+    ASSERT_TRUE(pool.add(boost::bind(&ThreadPoolTest::block, this)));
+    waitBlocked(2);
+
+    // Release the tasks only after the pause had a chance to start
+    // waiting for them.
+    ThreadPool release_pool;
+    release_pool.start(1);
+    ASSERT_TRUE(release_pool.add(boost::bind(usleep, 10000)));
+    ASSERT_TRUE(release_pool.add(boost::bind(&ThreadPoolTest::release, this)));
+    {
+        ThreadPool::Pause pause(pool);
+        EXPECT_EQ(2, getCount());
+    }
+    pool.stop();
+    release_pool.stop();
+}
+
+// A single thread runs the tasks one at a time.
+TEST_F(ThreadPoolTest, singleThread) {
+    ThreadPool pool;
+    pool.start(1);
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(pool.add(boost::bind(&ThreadPoolTest::exclusive, this)));
+    }
+    pool.stop();
+    EXPECT_EQ(10, getCount());
+}
+
+} // end of anonymous namespace
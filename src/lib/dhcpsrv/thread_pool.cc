@@ -0,0 +1,159 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcpsrv/thread_pool.h>
+
+#include <boost/bind.hpp>
+
+using namespace bundy::util::thread;
+
+namespace bundy {
+namespace dhcp {
+
+ThreadPool::Pause::Pause(ThreadPool& pool) :
+    pool_(pool)
+{
+    pool_.pause();
+}
+
+ThreadPool::Pause::~Pause() {
+    pool_.resume();
+}
+
+ThreadPool::ThreadPool(size_t queue_size) :
+    max_queue_size_(queue_size), busy_(0), paused_(0), stopping_(false),
+    dropped_(0)
+{
+}
+
+ThreadPool::~ThreadPool() {
+    stop();
+}
+
+void
+ThreadPool::start(size_t threads) {
+    Mutex::Locker lock(mutex_);
+    if (!threads_.empty()) {
+        bundy_throw(InvalidOperation, "the threads are already running");
+    }
+    stopping_ = false;
+    for (size_t i = 0; i < threads; ++i) {
+        threads_.push_back(boost::shared_ptr<Thread>(
+            new Thread(boost::bind(&ThreadPool::run, this))));
+    }
+}
+
+void
+ThreadPool::stop() {
+    {
+        Mutex::Locker lock(mutex_);
+        if (threads_.empty()) {
+            return;
+        }
+        stopping_ = true;
+        work_cond_.broadcast();
+    }
+    // The threads complete the queued tasks before they exit.
+    for (size_t i = 0; i < threads_.size(); ++i) {
+        threads_[i]->wait();
+    }
+    Mutex::Locker lock(mutex_);
+    threads_.clear();
+    stopping_ = false;
+}
+
+bool
+ThreadPool::add(const Task& task) {
+    {
+        Mutex::Locker lock(mutex_);
+        if (!threads_.empty()) {
+            if (queue_.size() >= max_queue_size_) {
+                ++dropped_;
+                return (false);
+            }
+            queue_.push_back(task);
+            work_cond_.signal();
+            return (true);
+        }
+    }
+    task();
+    return (true);
+}
+
+size_t
+ThreadPool::getThreadCount() const {
+    Mutex::Locker lock(mutex_);
+    return (threads_.size());
+}
+
+size_t
+ThreadPool::getQueueSize() const {
+    Mutex::Locker lock(mutex_);
+    return (queue_.size());
+}
+
+uint64_t
+ThreadPool::getDropped() const {
+    Mutex::Locker lock(mutex_);
+    return (dropped_);
+}
+
+void
+ThreadPool::run() {
+    for (;;) {
+        Task task;
+        {
+            Mutex::Locker lock(mutex_);
+            while (paused_ > 0 || (queue_.empty() && !stopping_)) {
+                work_cond_.wait(mutex_);
+            }
+            if (queue_.empty()) {
+                // Stopping and nothing left to do.
+                return;
+            }
+            task = queue_.front();
+            queue_.pop_front();
+            ++busy_;
+        }
+        try {
+            task();
+        } catch (...) {
+            // The tasks are expected to handle their errors, but one
+            // slipping through must not take the thread down.
+        }
+        Mutex::Locker lock(mutex_);
+        --busy_;
+        idle_cond_.broadcast();
+    }
+}
+
+void
+ThreadPool::pause() {
+    Mutex::Locker lock(mutex_);
+    ++paused_;
+    while (busy_ > 0) {
+        idle_cond_.wait(mutex_);
+    }
+}
+
+void
+ThreadPool::resume() {
+    Mutex::Locker lock(mutex_);
+    if (--paused_ == 0) {
+        work_cond_.broadcast();
+    }
+}
+
+} // namespace bundy::dhcp
+} // namespace bundy
@@ -0,0 +1,155 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <exceptions/exceptions.h>
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <deque>
+#include <vector>
+
+#include <stdint.h>
+
+namespace bundy {
+namespace dhcp {
+
+/// @brief Pool of threads processing tasks from a bounded queue.
+///
+/// The DHCP servers use it to process the received packets in several
+/// threads, while the main thread keeps receiving the packets (and handles
+/// the configuration and commands).  Each packet is one task.
+///
+/// The queue is bounded: when the threads don't keep up with the incoming
+/// packets, the new ones are dropped rather than piling up, as the clients
+/// would retransmit them anyway by the time they got processed.
+///
+/// Until the threads are started (and after they are stopped) the tasks
+/// are run right away by the thread adding them, so a server with no
+/// worker threads behaves exactly as before.
+///
+/// The main thread can pause the processing with @c ThreadPool::Pause,
+/// which waits for the tasks being run to complete and holds the others
+/// back.  It is used while the configuration is being changed.
+class ThreadPool : public boost::noncopyable {
+public:
+    /// @brief Task to be run by the threads.
+    typedef boost::function<void()> Task;
+
+    /// @brief Default maximum number of the queued tasks.
+    static const size_t DEFAULT_QUEUE_SIZE = 1024;
+
+    /// @brief Pauses the processing of the tasks while in scope.
+    ///
+    /// The constructor waits until no task is being run and no other task
+    /// is started until the object is destroyed.  The tasks can still be
+    /// added to the queue meanwhile.  It must not be used from within a
+    /// task.
+    class Pause : public boost::noncopyable {
+    public:
+        /// @brief Constructor.
+        ///
+        /// @param pool The pool to pause.
+        explicit Pause(ThreadPool& pool);
+
+        /// @brief Destructor, resumes the processing.
+        ~Pause();
+
+    private:
+        ThreadPool& pool_;
+    };
+
+    /// @brief Constructor.
+    ///
+    /// No threads are started.
+    ///
+    /// @param queue_size Maximum number of the tasks waiting in the queue.
+    explicit ThreadPool(size_t queue_size = DEFAULT_QUEUE_SIZE);
+
+    /// @brief Destructor, stops the threads.
+    ~ThreadPool();
+
+    /// @brief Start the threads.
+    ///
+    /// @param threads Number of the threads, 0 keeps running the tasks
+    ///     right away.
+    /// @throw bundy::InvalidOperation if the threads are running already.
+    void start(size_t threads);
+
+    /// @brief Stop the threads.
+    ///
+    /// The tasks already in the queue are completed first.  It does nothing
+    /// if the threads are not running.
+    void stop();
+
+    /// @brief Add a task.
+    ///
+    /// If no threads are running, the task is run before this method
+    /// returns.
+    ///
+    /// @param task The task to run.
+    /// @return false if the queue is full and the task was dropped.
+    bool add(const Task& task);
+
+    /// @brief Return the number of the running threads.
+    size_t getThreadCount() const;
+
+    /// @brief Return the number of the tasks waiting in the queue.
+    size_t getQueueSize() const;
+
+    /// @brief Return the maximum number of the tasks in the queue.
+    size_t getMaxQueueSize() const {
+        return (max_queue_size_);
+    }
+
+    /// @brief Return the number of the tasks dropped because the queue was
+    /// full.
+    uint64_t getDropped() const;
+
+private:
+    /// @brief Main function of the threads.
+    void run();
+
+    /// @brief Wait until no task is being run and hold the others back.
+    void pause();
+
+    /// @brief Resume the processing after @c pause().
+    void resume();
+
+    const size_t max_queue_size_;
+    std::deque<Task> queue_;
+    std::vector<boost::shared_ptr<bundy::util::thread::Thread> > threads_;
+    /// Number of the tasks being run.
+    size_t busy_;
+    /// Number of the active @c Pause objects.
+    size_t paused_;
+    bool stopping_;
+    uint64_t dropped_;
+    mutable bundy::util::thread::Mutex mutex_;
+    /// Signalled when there is a task to run (or the threads are to stop).
+    bundy::util::thread::CondVar work_cond_;
+    /// Signalled when a task completes.
+    bundy::util::thread::CondVar idle_cond_;
+};
+
+} // namespace bundy::dhcp
+} // namespace bundy
+
+#endif // THREAD_POOL_H
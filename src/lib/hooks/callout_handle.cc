@@ -17,6 +17,7 @@
 #include <hooks/library_handle.h>
 #include <hooks/server_hooks.h>
 
+#include <algorithm>
 #include <string>
 #include <utility>
 #include <vector>
@@ -72,14 +73,32 @@ vector<string>
 CalloutHandle::getArgumentNames() const {
 
     vector<string> names;
-    for (ElementCollection::const_iterator i = arguments_.begin();
+    for (ArgumentCollection::const_iterator i = arguments_.begin();
          i != arguments_.end(); ++i) {
-        names.push_back(i->first);
+        if (!i->second.empty()) {
+            names.push_back(i->first);
+        }
     }
 
+    // Keep the names sorted, as they were when held in a map.
+    sort(names.begin(), names.end());
     return (names);
 }
 
+// Reset the handle for a new packet.
+
+void
+CalloutHandle::reset() {
+    manager_->callCallouts(ServerHooks::CONTEXT_DESTROY, *this);
+
+    // The argument names are kept for the next packet.
+    deleteAllArguments();
+    context_collection_.clear();
+    skip_ = false;
+
+    manager_->callCallouts(ServerHooks::CONTEXT_CREATE, *this);
+}
+
 // Return the library handle allowing the callout to access the CalloutManager
 // registration/deregistration functions.
 
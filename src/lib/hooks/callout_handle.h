@@ -23,6 +23,7 @@
 
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace bundy {
@@ -55,6 +56,7 @@ public:
 // Forward declaration of the library handle and related collection classes.
 
 class CalloutManager;
+class HooksManager;
 class LibraryHandle;
 class LibraryManagerCollection;
 
@@ -87,6 +89,9 @@ class LibraryManagerCollection;
 ///   case, only functions registered by functions in the same library as the
 ///   callout doing the deregistration can be removed: callouts registered by
 ///   other libraries cannot be modified.
+///
+/// A server processing many packets does not need to create a handle for
+/// each of them: see @ref HooksManager::recycleCalloutHandle().
 
 class CalloutHandle {
 public:
@@ -96,6 +101,14 @@ public:
     /// corresponding value associated with it.
     typedef std::map<std::string, boost::any> ElementCollection;
 
+    /// Typedef for the collection of arguments, a name/value table.  The
+    /// callouts of a hook get only a few arguments, which are found faster
+    /// in a vector than in a map.  A deleted argument keeps its entry, with
+    /// an empty value, so setting the arguments again for the next packet
+    /// does not allocate anything.
+    typedef std::vector<std::pair<std::string, boost::any> >
+        ArgumentCollection;
+
     /// Typedef to allow abbreviations in specifications when accessing
     /// context.  The ElementCollection is the name/value collection for
     /// a particular context.  The "int" corresponds to the index of an
@@ -145,7 +158,12 @@ public:
     /// @param value Value to set.  That can be of any data type.
     template <typename T>
     void setArgument(const std::string& name, T value) {
-        arguments_[name] = value;
+        boost::any* element = findArgument(name);
+        if (element) {
+            *element = value;
+        } else {
+            arguments_.push_back(std::make_pair(name, boost::any(value)));
+        }
     }
 
     /// @brief Get argument
@@ -162,19 +180,20 @@ public:
     ///        the variable provided to receive the value.
     template <typename T>
     void getArgument(const std::string& name, T& value) const {
-        ElementCollection::const_iterator element_ptr = arguments_.find(name);
-        if (element_ptr == arguments_.end()) {
+        const boost::any* element =
+            const_cast<CalloutHandle*>(this)->findArgument(name);
+        if (!element || element->empty()) {
             bundy_throw(NoSuchArgument, "unable to find argument with name " <<
                       name);
         }
 
-        value = boost::any_cast<T>(element_ptr->second);
+        value = boost::any_cast<T>(*element);
     }
 
     /// @brief Get argument names
     ///
     /// Returns a vector holding the names of arguments in the argument
-    /// vector.
+    /// vector, in alphabetical order.
     ///
     /// @return Vector of strings reflecting argument names.
     std::vector<std::string> getArgumentNames() const;
@@ -189,7 +208,10 @@ public:
     ///
     /// @param name Name of the element in the argument list to set.
     void deleteArgument(const std::string& name) {
-        static_cast<void>(arguments_.erase(name));
+        boost::any* element = findArgument(name);
+        if (element) {
+            boost::any().swap(*element);
+        }
     }
 
     /// @brief Delete all arguments
@@ -199,7 +221,10 @@ public:
     /// N.B. If any elements are raw pointers, the pointed-to data is NOT
     /// deleted by this method.
     void deleteAllArguments() {
-        arguments_.clear();
+        for (ArgumentCollection::iterator i = arguments_.begin();
+             i != arguments_.end(); ++i) {
+            boost::any().swap(i->second);
+        }
     }
 
     /// @brief Set skip flag
@@ -319,6 +344,33 @@ public:
     std::string getHookName() const;
 
 private:
+    /// The hooks manager reuses the handles, see reset().
+    friend class HooksManager;
+
+    /// @brief Find an argument
+    ///
+    /// @param name Name of the argument.
+    ///
+    /// @return Pointer to the value of the argument (which is empty if the
+    ///         argument was deleted), null if there is no entry for it.
+    boost::any* findArgument(const std::string& name) {
+        for (ArgumentCollection::iterator i = arguments_.begin();
+             i != arguments_.end(); ++i) {
+            if (i->first == name) {
+                return (&i->second);
+            }
+        }
+        return (NULL);
+    }
+
+    /// @brief Reset the handle for a new packet
+    ///
+    /// Brings the handle in the state of a new one: calls the callouts on
+    /// the "context_destroy" hook, deletes the arguments and the context,
+    /// clears the "skip" flag and calls the callouts on the "context_create"
+    /// hook.
+    void reset();
+
     /// @brief Check index
     ///
     /// Gets the current library index, throwing an exception if it is not set
@@ -363,7 +415,7 @@ private:
     boost::shared_ptr<LibraryManagerCollection> lm_collection_;
 
     /// Collection of arguments passed to the callouts
-    ElementCollection arguments_;
+    ArgumentCollection arguments_;
 
     /// Context collection - there is one entry per library context.
     ContextCollection context_collection_;
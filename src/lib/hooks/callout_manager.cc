@@ -17,6 +17,7 @@
 #include <hooks/hooks_log.h>
 #include <hooks/pointer_converter.h>
 
+#include <boost/shared_ptr.hpp>
 #include <boost/static_assert.hpp>
 
 #include <algorithm>
@@ -25,6 +26,7 @@
 #include <utility>
 
 using namespace std;
+using namespace bundy::util::thread;
 
 namespace bundy {
 namespace hooks {
@@ -32,7 +34,6 @@ namespace hooks {
 // Constructor
 CalloutManager::CalloutManager(int num_libraries)
     : server_hooks_(ServerHooks::getServerHooks()),
-      current_hook_(-1), current_library_(-1),
       hook_vector_(ServerHooks::getServerHooks().getCount()),
       library_handle_(this), pre_library_handle_(this, 0),
       post_library_handle_(this, INT_MAX), num_libraries_(num_libraries)
@@ -41,6 +42,56 @@ CalloutManager::CalloutManager(int num_libraries)
         bundy_throw(bundy::BadValue, "number of libraries passed to the "
                   "CalloutManager must be >= 0");
     }
+    if (pthread_key_create(&key_, NULL) != 0) {
+        bundy_throw(bundy::Unexpected, "unable to create the key of the "
+                    "CalloutManager thread states");
+    }
+}
+
+// Destructor.  The states are not freed by the threads (the key has no
+// destructor) as they may exit after the manager is destroyed.
+
+CalloutManager::~CalloutManager() {
+    pthread_key_delete(key_);
+    for (vector<ThreadState*>::iterator i = thread_states_.begin();
+         i != thread_states_.end(); ++i) {
+        delete *i;
+    }
+}
+
+// Return the indexes of the calling thread, creating them if needed.
+
+CalloutManager::ThreadState&
+CalloutManager::getThreadState() {
+    ThreadState* state = static_cast<ThreadState*>(pthread_getspecific(key_));
+    if (!state) {
+        state = new ThreadState();
+        state->hook_ = -1;
+        state->library_ = -1;
+        Mutex::Locker lock(mutex_);
+        thread_states_.push_back(state);
+        pthread_setspecific(key_, state);
+    }
+    return (*state);
+}
+
+// Snapshot of the callouts of a hook.
+
+CalloutManager::CalloutVectorPtr
+CalloutManager::getCallouts(int hook_index) const {
+    return (boost::atomic_load(&hook_vector_[hook_index]));
+}
+
+// Publish new callouts for a hook.  The readers holding the previous
+// vector keep using it until they are done.
+
+void
+CalloutManager::setCallouts(int hook_index, const CalloutVector& callouts) {
+    CalloutVectorPtr published;
+    if (!callouts.empty()) {
+        published.reset(new CalloutVector(callouts));
+    }
+    boost::atomic_store(&hook_vector_[hook_index], published);
 }
 
 // Check that the index of a library is valid.  It can range from 1 - n
@@ -64,35 +115,40 @@ CalloutManager::checkLibraryIndex(int library_index) const {
 
 void
 CalloutManager::registerCallout(const std::string& name, CalloutPtr callout) {
+    const int current_library = getLibraryIndex();
+
     // Note the registration.
     LOG_DEBUG(hooks_logger, HOOKS_DBG_CALLS, HOOKS_CALLOUT_REGISTRATION)
-        .arg(current_library_).arg(name);
+        .arg(current_library).arg(name);
 
     // Sanity check that the current library index is set to a valid value.
-    checkLibraryIndex(current_library_);
+    checkLibraryIndex(current_library);
 
     // Get the index associated with this hook (validating the name in the
     // process).
     int hook_index = server_hooks_.getIndex(name);
 
+    // Work on a copy of the callouts, which replaces them when done.
+    Mutex::Locker lock(mutex_);
+    CalloutVector callouts;
+    CalloutVectorPtr current = getCallouts(hook_index);
+    if (current) {
+        callouts = *current;
+    }
+
     // Iterate through the callout vector for the hook from start to end,
     // looking for the first entry where the library index is greater than
     // the present index.
-    for (CalloutVector::iterator i = hook_vector_[hook_index].begin();
-         i != hook_vector_[hook_index].end(); ++i) {
-        if (i->first > current_library_) {
-            // Found an element whose library index number is greater than the
-            // current index, so insert the new element ahead of this one.
-            hook_vector_[hook_index].insert(i, make_pair(current_library_,
-                                                         callout));
-            return;
-        }
+    CalloutVector::iterator i = callouts.begin();
+    while ((i != callouts.end()) && (i->first <= current_library)) {
+        ++i;
     }
 
-    // Reached the end of the vector, so there is no element in the (possibly
-    // empty) set of callouts with a library index greater than the current
-    // library index.  Inset the callout at the end of the list.
-    hook_vector_[hook_index].push_back(make_pair(current_library_, callout));
+    // Insert the new element ahead of the element found, or at the end of
+    // the (possibly empty) vector if there is no element with a library
+    // index greater than the current library index.
+    callouts.insert(i, make_pair(current_library, callout));
+    setCallouts(hook_index, callouts);
 }
 
 // Check if callouts are present for a given hook index.
@@ -105,8 +161,9 @@ CalloutManager::calloutsPresent(int hook_index) const {
                   " is not valid for the list of registered hooks");
     }
 
-    // Valid, so are there any callouts associated with that hook?
-    return (!hook_vector_[hook_index].empty());
+    // Valid, so are there any callouts associated with that hook?  (The
+    // vector is never empty when present.)
+    return (static_cast<bool>(getCallouts(hook_index)));
 }
 
 // Call all the callouts for a given hook.
@@ -119,80 +176,87 @@ CalloutManager::callCallouts(int hook_index, CalloutHandle& callout_handle) {
     // any state from the previous call of callCallouts().
     callout_handle.setSkip(false);
 
-    // Only initialize and iterate if there are callouts present.  This check
-    // also catches the case of an invalid index.
-    if (calloutsPresent(hook_index)) {
-
-        // Set the current hook index.  This is used should a callout wish to
-        // determine to what hook it is attached.
-        current_hook_ = hook_index;
-
-        // Duplicate the callout vector for this hook and work through that.
-        // This step is needed because we allow dynamic registration and
-        // deregistration of callouts.  If a callout attached to a hook modified
-        // the list of callouts on that hook, the underlying CalloutVector would
-        // change and potentially affect the iteration through that vector.
-        CalloutVector callouts(hook_vector_[hook_index]);
-
-        // Call all the callouts.
-        for (CalloutVector::const_iterator i = callouts.begin();
-             i != callouts.end(); ++i) {
-            // In case the callout tries to register or deregister a callout,
-            // set the current library index to the index associated with the
-            // library that registered the callout being called.
-            current_library_ = i->first;
-
-            // Call the callout
-            try {
-                int status = (*i->second)(callout_handle);
-                if (status == 0) {
-                    LOG_DEBUG(hooks_logger, HOOKS_DBG_EXTENDED_CALLS,
-                              HOOKS_CALLOUT_CALLED).arg(current_library_)
-                        .arg(server_hooks_.getName(current_hook_))
-                        .arg(PointerConverter(i->second).dlsymPtr());
-                } else {
-                    LOG_ERROR(hooks_logger, HOOKS_CALLOUT_ERROR)
-                        .arg(current_library_)
-                        .arg(server_hooks_.getName(current_hook_))
-                        .arg(PointerConverter(i->second).dlsymPtr());
-                }
-            } catch (const std::exception& e) {
-                // Any exception, not just ones based on bundy::Exception
-                LOG_ERROR(hooks_logger, HOOKS_CALLOUT_EXCEPTION)
-                    .arg(current_library_)
-                    .arg(server_hooks_.getName(current_hook_))
-                    .arg(PointerConverter(i->second).dlsymPtr())
-                    .arg(e.what());
-            }
+    // Take a snapshot of the callouts for this hook and work through that.
+    // We allow dynamic registration and deregistration of callouts: if a
+    // callout attached to a hook modifies the list of callouts on that
+    // hook, a new vector is published and the snapshot is not affected.
+    // Only initialize and iterate if there are callouts present.  The check
+    // of the presence also catches the case of an invalid index.
+    if (!calloutsPresent(hook_index)) {
+        return;
+    }
+    const CalloutVectorPtr callouts = getCallouts(hook_index);
+    if (!callouts) {
+        return;
+    }
 
+    // Set the current hook index.  This is used should a callout wish to
+    // determine to what hook it is attached.
+    ThreadState& state = getThreadState();
+    state.hook_ = hook_index;
+
+    // Call all the callouts.
+    for (CalloutVector::const_iterator i = callouts->begin();
+         i != callouts->end(); ++i) {
+        // In case the callout tries to register or deregister a callout,
+        // set the current library index to the index associated with the
+        // library that registered the callout being called.
+        state.library_ = i->first;
+
+        // Call the callout
+        try {
+            int status = (*i->second)(callout_handle);
+            if (status == 0) {
+                LOG_DEBUG(hooks_logger, HOOKS_DBG_EXTENDED_CALLS,
+                          HOOKS_CALLOUT_CALLED).arg(i->first)
+                    .arg(server_hooks_.getName(hook_index))
+                    .arg(PointerConverter(i->second).dlsymPtr());
+            } else {
+                LOG_ERROR(hooks_logger, HOOKS_CALLOUT_ERROR)
+                    .arg(i->first)
+                    .arg(server_hooks_.getName(hook_index))
+                    .arg(PointerConverter(i->second).dlsymPtr());
+            }
+        } catch (const std::exception& e) {
+            // Any exception, not just ones based on bundy::Exception
+            LOG_ERROR(hooks_logger, HOOKS_CALLOUT_EXCEPTION)
+                .arg(i->first)
+                .arg(server_hooks_.getName(hook_index))
+                .arg(PointerConverter(i->second).dlsymPtr())
+                .arg(e.what());
         }
-
-        // Reset the current hook and library indexs to an invalid value to
-        // catch any programming errors.
-        current_hook_ = -1;
-        current_library_ = -1;
     }
+
+    // Reset the current hook and library indexs to an invalid value to
+    // catch any programming errors.
+    state.hook_ = -1;
+    state.library_ = -1;
 }
 
 // Deregister a callout registered by the current library on a particular hook.
 
 bool
 CalloutManager::deregisterCallout(const std::string& name, CalloutPtr callout) {
+    const int current_library = getLibraryIndex();
+
     // Sanity check that the current library index is set to a valid value.
-    checkLibraryIndex(current_library_);
+    checkLibraryIndex(current_library);
 
     // Get the index associated with this hook (validating the name in the
     // process).
     int hook_index = server_hooks_.getIndex(name);
 
+    // Work on a copy of the callouts, which replaces them if changed.
+    Mutex::Locker lock(mutex_);
+    CalloutVectorPtr current = getCallouts(hook_index);
+    if (!current) {
+        return (false);
+    }
+    CalloutVector callouts(*current);
+
     /// Construct a CalloutEntry matching the current library and the callout
     /// we want to remove.
-    CalloutEntry target(current_library_, callout);
-
-    /// To decide if any entries were removed, we'll record the initial size
-    /// of the callout vector for the hook, and compare it with the size after
-    /// the removal.
-    size_t initial_size = hook_vector_[hook_index].size();
+    CalloutEntry target(current_library, callout);
 
     // The next bit is standard STL (see "Item 33" in "Effective STL" by
     // Scott Meyers).
@@ -203,17 +267,16 @@ CalloutManager::deregisterCallout(const std::string& name, CalloutPtr callout) {
     // is equal to the value of the passed callout.)  The erase() call
     // removes everything from that element to the end of the vector, i.e.
     // all the matching elements.
-    hook_vector_[hook_index].erase(remove_if(hook_vector_[hook_index].begin(),
-                                             hook_vector_[hook_index].end(),
-                                             bind1st(equal_to<CalloutEntry>(),
-                                                     target)),
-                                   hook_vector_[hook_index].end());
+    callouts.erase(remove_if(callouts.begin(), callouts.end(),
+                             bind1st(equal_to<CalloutEntry>(), target)),
+                   callouts.end());
 
     // Return an indication of whether anything was removed.
-    bool removed = initial_size != hook_vector_[hook_index].size();
+    bool removed = current->size() != callouts.size();
     if (removed) {
+        setCallouts(hook_index, callouts);
         LOG_DEBUG(hooks_logger, HOOKS_DBG_EXTENDED_CALLS,
-                  HOOKS_CALLOUT_DEREGISTERED).arg(current_library_).arg(name);
+                  HOOKS_CALLOUT_DEREGISTERED).arg(current_library).arg(name);
     }
 
     return (removed);
@@ -223,32 +286,35 @@ CalloutManager::deregisterCallout(const std::string& name, CalloutPtr callout) {
 
 bool
 CalloutManager::deregisterAllCallouts(const std::string& name) {
+    const int current_library = getLibraryIndex();
 
     // Get the index associated with this hook (validating the name in the
     // process).
     int hook_index = server_hooks_.getIndex(name);
 
+    // Work on a copy of the callouts, which replaces them if changed.
+    Mutex::Locker lock(mutex_);
+    CalloutVectorPtr current = getCallouts(hook_index);
+    if (!current) {
+        return (false);
+    }
+    CalloutVector callouts(*current);
+
     /// Construct a CalloutEntry matching the current library (the callout
     /// pointer is NULL as we are not checking that).
-    CalloutEntry target(current_library_, NULL);
-
-    /// To decide if any entries were removed, we'll record the initial size
-    /// of the callout vector for the hook, and compare it with the size after
-    /// the removal.
-    size_t initial_size = hook_vector_[hook_index].size();
+    CalloutEntry target(current_library, NULL);
 
     // Remove all callouts matching this library.
-    hook_vector_[hook_index].erase(remove_if(hook_vector_[hook_index].begin(),
-                                             hook_vector_[hook_index].end(),
-                                             bind1st(CalloutLibraryEqual(),
-                                                     target)),
-                                   hook_vector_[hook_index].end());
+    callouts.erase(remove_if(callouts.begin(), callouts.end(),
+                             bind1st(CalloutLibraryEqual(), target)),
+                   callouts.end());
 
     // Return an indication of whether anything was removed.
-    bool removed = initial_size != hook_vector_[hook_index].size();
+    bool removed = current->size() != callouts.size();
     if (removed) {
+        setCallouts(hook_index, callouts);
         LOG_DEBUG(hooks_logger, HOOKS_DBG_EXTENDED_CALLS,
-                  HOOKS_ALL_CALLOUTS_DEREGISTERED).arg(current_library_)
+                  HOOKS_ALL_CALLOUTS_DEREGISTERED).arg(current_library)
                                                 .arg(name);
     }
 
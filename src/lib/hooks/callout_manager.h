@@ -18,12 +18,17 @@
 #include <exceptions/exceptions.h>
 #include <hooks/library_handle.h>
 #include <hooks/server_hooks.h>
+#include <util/threads/sync.h>
 
+#include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
 
 #include <climits>
 #include <map>
 #include <string>
+#include <vector>
+
+#include <pthread.h>
 
 namespace bundy {
 namespace hooks {
@@ -108,8 +113,17 @@ public:
 /// they use a LibraryHandle object.  This contains an internal pointer to
 /// the CalloutManager, but provides a restricted interface.  In that way,
 /// callouts are unable to affect callouts supplied by other libraries.
-
-class CalloutManager {
+///
+/// The callouts can be called by several threads at the same time.  The
+/// callouts of a hook are kept in a vector that is never modified once
+/// published: registering or deregistering a callout builds a new vector
+/// and replaces the pointer to it atomically, so callCallouts() works
+/// through a snapshot of the callouts without taking a lock (and without
+/// copying them).  A hook without callouts has a null pointer, so checking
+/// it costs a single pointer load.  The current hook and library indexes
+/// are kept separately for each thread.
+
+class CalloutManager : public boost::noncopyable {
 private:
 
     // Private typedefs
@@ -123,6 +137,16 @@ private:
     /// associated with a given hook.
     typedef std::vector<CalloutEntry> CalloutVector;
 
+    /// Pointer to the callouts of a hook, null if there are none.  The
+    /// vector pointed to is never modified.
+    typedef boost::shared_ptr<const CalloutVector> CalloutVectorPtr;
+
+    /// The current hook and library indexes of a thread.
+    struct ThreadState {
+        int hook_;      ///< Current hook index
+        int library_;   ///< Current library index
+    };
+
 public:
 
     /// @brief Constructor
@@ -135,11 +159,16 @@ public:
     /// @throw bundy::BadValue if the number of libraries is less than 0,
     CalloutManager(int num_libraries = 0);
 
+    /// @brief Destructor
+    ///
+    /// Frees the current indexes kept for the threads.
+    ~CalloutManager();
+
     /// @brief Register a callout on a hook for the current library
     ///
     /// Registers a callout function for the current library with a given hook
-    /// (the index of the "current library" being given by the current_library_
-    /// member).  The callout is added to the end of the callouts for this
+    /// (the index of the "current library" being given by getLibraryIndex()).
+    /// The callout is added to the end of the callouts for this
     /// library that are associated with that hook.
     ///
     /// @param name Name of the hook to which the callout is added.
@@ -153,8 +182,8 @@ public:
     /// @brief De-Register a callout on a hook for the current library
     ///
     /// Searches through the functions registered by the the current library
-    /// (the index of the "current library" being given by the current_library_
-    /// member) with the named hook and removes all entries matching the
+    /// (the index of the "current library" being given by getLibraryIndex())
+    /// with the named hook and removes all entries matching the
     /// callout.
     ///
     /// @param name Name of the hook from which the callout is removed.
@@ -171,7 +200,7 @@ public:
     ///
     /// Removes all callouts associated with a given hook that were registered
     /// by the current library (the index of the "current library" being given
-    /// by the current_library_ member).
+    /// by getLibraryIndex()).
     ///
     /// @param name Name of the hook from which the callouts are removed.
     ///
@@ -195,7 +224,9 @@ public:
     /// @brief Calls the callouts for a given hook
     ///
     /// Iterates through the libray handles and calls the callouts associated
-    /// with the given hook index.
+    /// with the given hook index.  The callouts called are the ones
+    /// registered when the call starts: a callout registered or deregistered
+    /// by one of them takes effect on the next call.
     ///
     /// @note This method invalidates the current library index set with
     ///       setLibraryIndex().
@@ -210,7 +241,8 @@ public:
     /// Made available during callCallouts, this is the index of the hook
     /// on which callouts are being called.
     int getHookIndex() const {
-        return (current_hook_);
+        const ThreadState* state = findThreadState();
+        return (state ? state->hook_ : -1);
     }
 
     /// @brief Get number of libraries
@@ -234,9 +266,13 @@ public:
     /// @note The value set by this method is lost after a call to
     ///       callCallouts.
     ///
+    /// @note The index is kept for each thread: the value returned is the
+    ///       one of the calling thread.
+    ///
     /// @return Current library index.
     int getLibraryIndex() const {
-        return (current_library_);
+        const ThreadState* state = findThreadState();
+        return (state ? state->library_ : -1);
     }
 
     /// @brief Set current library index
@@ -255,7 +291,7 @@ public:
     /// @throw NoSuchLibrary if the index is not valid.
     void setLibraryIndex(int library_index) {
         checkLibraryIndex(library_index);
-        current_library_ = library_index;
+        getThreadState().library_ = library_index;
     }
 
     /// @defgroup calloutManagerLibraryHandles Callout manager library handles
@@ -319,6 +355,35 @@ private:
     /// @throw NoSuchLibrary Library index is not valid.
     void checkLibraryIndex(int library_index) const;
 
+    /// @brief Return the current indexes of the calling thread
+    ///
+    /// @return Pointer to the indexes, null if the thread has none yet.
+    const ThreadState* findThreadState() const {
+        return (static_cast<const ThreadState*>(pthread_getspecific(key_)));
+    }
+
+    /// @brief Return the current indexes of the calling thread
+    ///
+    /// The indexes are created (both invalid) if the thread has none yet.
+    ///
+    /// @return Reference to the indexes of the calling thread.
+    ThreadState& getThreadState();
+
+    /// @brief Return the callouts of a hook
+    ///
+    /// @param hook_index Index of the hook, which must be valid.
+    ///
+    /// @return Snapshot of the callouts, null if there are none.
+    CalloutVectorPtr getCallouts(int hook_index) const;
+
+    /// @brief Replace the callouts of a hook
+    ///
+    /// Must be called with the mutex held.
+    ///
+    /// @param hook_index Index of the hook, which must be valid.
+    /// @param callouts New callouts of the hook (can be empty).
+    void setCallouts(int hook_index, const CalloutVector& callouts);
+
     /// @brief Compare two callout entries for library equality
     ///
     /// This is used in callout removal code when all callouts on a hook for a
@@ -345,20 +410,24 @@ private:
     /// a reference instead of accessing the singleton within the code.
     ServerHooks& server_hooks_;
 
-    /// Current hook.  When a call is made to callCallouts, this holds the
-    /// index of the current hook.  It is set to an invalid value (-1)
-    /// otherwise.
-    int current_hook_;
+    /// Key of the current indexes of the threads (ThreadState).  When a call
+    /// is made to callCallouts, the hook index is that of the current hook
+    /// and the library index that of the library of the callout being
+    /// called; they are invalid (-1) otherwise.  The library index indicates
+    /// which library the callout registration methods act for.
+    pthread_key_t key_;
+
+    /// The indexes created for the threads, freed with the manager.
+    std::vector<ThreadState*> thread_states_;
 
-    /// Current library index.  When a call is made to any of the callout
-    /// registration methods, this variable indicates the index of the user
-    /// library that should be associated with the call.
-    int current_library_;
+    /// Vector of pointers to callout vectors.  There is one entry in this
+    /// outer vector for each hook, pointing to a vector with one entry for
+    /// each callout registered for that hook (or null if there is none).
+    /// The pointers are accessed atomically.
+    std::vector<CalloutVectorPtr> hook_vector_;
 
-    /// Vector of callout vectors.  There is one entry in this outer vector for
-    /// each hook. Each element is itself a vector, with one entry for each
-    /// callout registered for that hook.
-    std::vector<CalloutVector> hook_vector_;
+    /// Serializes the changes of the callouts and of thread_states_.
+    bundy::util::thread::Mutex mutex_;
 
     /// LibraryHandle object user by the callout to access the callout
     /// registration methods on this CalloutManager object.  The object is set
@@ -131,6 +131,28 @@ HooksManager::createCalloutHandle() {
     return (getHooksManager().createCalloutHandleInternal());
 }
 
+// Reuse a callout handle if it is not shared and was created for the
+// current set of libraries, otherwise create a new one.
+
+boost::shared_ptr<CalloutHandle>
+HooksManager::recycleCalloutHandleInternal(
+    const boost::shared_ptr<CalloutHandle>& handle) {
+    conditionallyInitialize();
+    if (handle && handle.unique() &&
+        (handle->manager_ == callout_manager_) &&
+        (handle->lm_collection_ == lm_collection_)) {
+        handle->reset();
+        return (handle);
+    }
+    return (createCalloutHandleInternal());
+}
+
+boost::shared_ptr<CalloutHandle>
+HooksManager::recycleCalloutHandle(
+    const boost::shared_ptr<CalloutHandle>& handle) {
+    return (getHooksManager().recycleCalloutHandleInternal(handle));
+}
+
 // Get the list of the names of loaded libraries.
 
 std::vector<std::string>
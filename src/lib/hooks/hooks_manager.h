@@ -153,6 +153,24 @@ public:
     /// @return Shared pointer to a CalloutHandle object.
     static boost::shared_ptr<CalloutHandle> createCalloutHandle();
 
+    /// @brief Return callout handle, reusing a previous one
+    ///
+    /// Returns a callout handle for a new request, like createCalloutHandle(),
+    /// but reuses the handle of a previous request if possible: if nothing
+    /// else holds it and the libraries were not reloaded since it was
+    /// created.  The handle is then reset: the callouts on the
+    /// "context_destroy" and "context_create" hooks are called and the
+    /// arguments and context are deleted, so it is the same as a new one
+    /// for the callouts.  This saves the allocation of the handle and its
+    /// arguments for each request.
+    ///
+    /// @param handle Handle of the previous request (can be null).
+    ///
+    /// @return Shared pointer to a CalloutHandle object, which is the one
+    ///         passed or a new one.
+    static boost::shared_ptr<CalloutHandle>
+    recycleCalloutHandle(const boost::shared_ptr<CalloutHandle>& handle);
+
     /// @brief Register Hook
     ///
     /// This is just a convenience shell around the ServerHooks::registerHook()
@@ -257,6 +275,15 @@ private:
     /// @return Shared pointer to a CalloutHandle object.
     boost::shared_ptr<CalloutHandle> createCalloutHandleInternal();
 
+    /// @brief Return callout handle, reusing a previous one
+    ///
+    /// @param handle Handle of the previous request (can be null).
+    ///
+    /// @return Shared pointer to a CalloutHandle object.
+    boost::shared_ptr<CalloutHandle>
+    recycleCalloutHandleInternal(const boost::shared_ptr<CalloutHandle>&
+                                 handle);
+
     /// @brief Return pre-callouts library handle
     ///
     /// @return Reference to library handle associated with pre-library callout
@@ -21,6 +21,10 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 using namespace bundy::hooks;
 using namespace std;
 
@@ -305,6 +309,42 @@ TEST_F(CalloutHandleTest, DeleteAllArguments) {
     EXPECT_THROW(handle.getArgument("two", value), NoSuchArgument);
     EXPECT_THROW(handle.getArgument("three", value), NoSuchArgument);
     EXPECT_THROW(handle.getArgument("four", value), NoSuchArgument);
+    EXPECT_TRUE(handle.getArgumentNames().empty());
+}
+
+// Test that the arguments can be set again after being deleted.
+
+TEST_F(CalloutHandleTest, SetArgumentAfterDelete) {
+    CalloutHandle handle(getCalloutManager());
+    int value;
+
+    handle.setArgument("one", static_cast<int>(1));
+    handle.setArgument("two", static_cast<int>(2));
+    handle.deleteAllArguments();
+
+    // Only the arguments set again are present, with their new value
+    // (which may be of another type).
+    handle.setArgument("two", string("two"));
+    handle.setArgument("three", static_cast<int>(3));
+    EXPECT_THROW(handle.getArgument("one", value), NoSuchArgument);
+    string text;
+    handle.getArgument("two", text);
+    EXPECT_EQ("two", text);
+    handle.getArgument("three", value);
+    EXPECT_EQ(3, value);
+
+    vector<string> names = handle.getArgumentNames();
+    sort(names.begin(), names.end());
+    ASSERT_EQ(2, names.size());
+    EXPECT_EQ("three", names[0]);
+    EXPECT_EQ("two", names[1]);
+
+    // Deleting an argument which was deleted already does nothing.
+    handle.deleteArgument("one");
+    handle.deleteArgument("two");
+    handle.deleteArgument("two");
+    EXPECT_THROW(handle.getArgument("two", text), NoSuchArgument);
+    EXPECT_EQ(1, handle.getArgumentNames().size());
 }
 
 // Test the "skip" flag.
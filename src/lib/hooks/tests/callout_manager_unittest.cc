@@ -17,7 +17,9 @@
 #include <hooks/callout_manager.h>
 #include <hooks/library_handle.h>
 #include <hooks/server_hooks.h>
+#include <util/threads/thread.h>
 
+#include <boost/bind.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <gtest/gtest.h>
 
@@ -225,6 +227,29 @@ TEST_F(CalloutManagerTest, CheckLibraryIndex) {
     EXPECT_THROW(getCalloutManager()->setLibraryIndex(11), NoSuchLibrary);
 }
 
+// Thread checking the current library index is its own.
+void
+checkThreadLibraryIndex(CalloutManager* manager, int* index) {
+    *index = manager->getLibraryIndex();
+    manager->setLibraryIndex(5);
+}
+
+// Check that the current library index is kept for each thread.
+
+TEST_F(CalloutManagerTest, LibraryIndexPerThread) {
+    getCalloutManager()->setLibraryIndex(3);
+
+    int index = 0;
+    bundy::util::thread::Thread
+        thread(boost::bind(checkThreadLibraryIndex,
+                           getCalloutManager().get(), &index));
+    thread.wait();
+
+    // The thread had no index, and the index it set does not change ours.
+    EXPECT_EQ(-1, index);
+    EXPECT_EQ(3, getCalloutManager()->getLibraryIndex());
+}
+
 // Check that we can only register callouts on valid hook names.
 
 TEST_F(CalloutManagerTest, ValidHookNames) {
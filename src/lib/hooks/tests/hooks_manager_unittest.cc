@@ -388,6 +388,72 @@ TEST_F(HooksManagerTest, NoLibrariesCallCallouts) {
     executeCallCallouts(-1, 3, -1, 22, -1, 83, -1);
 }
 
+// Callouts counting the creations and destructions of the contexts.
+
+int contexts_created = 0;
+int contexts_destroyed = 0;
+
+int
+countContextCreate(CalloutHandle&) {
+    ++contexts_created;
+    return (0);
+}
+
+int
+countContextDestroy(CalloutHandle&) {
+    ++contexts_destroyed;
+    return (0);
+}
+
+// Check that a callout handle which is not shared is reused, looking like
+// a new one to the callouts.
+
+TEST_F(HooksManagerTest, RecycleCalloutHandle) {
+    HooksManager::preCalloutsLibraryHandle().registerCallout("context_create",
+                                                             countContextCreate);
+    HooksManager::preCalloutsLibraryHandle().registerCallout("context_destroy",
+                                                             countContextDestroy);
+    contexts_created = 0;
+    contexts_destroyed = 0;
+
+    // Without a previous handle, a new one is created.
+    CalloutHandlePtr handle =
+        HooksManager::recycleCalloutHandle(CalloutHandlePtr());
+    ASSERT_TRUE(handle);
+    EXPECT_EQ(1, contexts_created);
+    handle->setArgument("result", static_cast<int>(1));
+    handle->setSkip(true);
+
+    // The handle is reused if nothing else holds it.
+    CalloutHandle* const saved = handle.get();
+    handle = HooksManager::recycleCalloutHandle(handle);
+    EXPECT_EQ(saved, handle.get());
+    EXPECT_EQ(2, contexts_created);
+    EXPECT_EQ(1, contexts_destroyed);
+    int result = 0;
+    EXPECT_THROW(handle->getArgument("result", result), NoSuchArgument);
+    EXPECT_TRUE(handle->getArgumentNames().empty());
+    EXPECT_FALSE(handle->getSkip());
+
+    // A handle held elsewhere is not.
+    CalloutHandlePtr other = handle;
+    handle = HooksManager::recycleCalloutHandle(handle);
+    EXPECT_NE(saved, handle.get());
+    EXPECT_EQ(saved, other.get());
+    EXPECT_EQ(3, contexts_created);
+    EXPECT_EQ(1, contexts_destroyed);
+    other.reset();
+    EXPECT_EQ(2, contexts_destroyed);
+
+    // Nor is a handle created for libraries which were unloaded since.
+    HooksManager::unloadLibraries();
+    CalloutHandle* const previous = handle.get();
+    handle = HooksManager::recycleCalloutHandle(handle);
+    EXPECT_NE(previous, handle.get());
+    EXPECT_EQ(3, contexts_created);
+    EXPECT_EQ(3, contexts_destroyed);
+}
+
 // Test the encapsulation of the ServerHooks::registerHook() method.
 
 TEST_F(HooksManagerTest, RegisterHooks) {
@@ -15,6 +15,7 @@
 #include <config.h>
 
 #include <stdlib.h>
+#include <pthread.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <unistd.h>             // for some IPC/network system calls
@@ -22,6 +23,7 @@
 
 #include <boost/lexical_cast.hpp>
 #include <boost/bind.hpp>
+#include <boost/enable_shared_from_this.hpp>
 
 #include <dns/question.h>
 #include <dns/message.h>
@@ -139,9 +141,10 @@ RecursiveQuery::RecursiveQuery(DNSServiceBase& dns_service,
     nsas_(nsas), cache_(cache),
     upstream_(new AddressVector(upstream)),
     upstream_root_(new AddressVector(upstream_root)),
-    test_server_("", 0),
+    test_server_("", 0), upstream_port_(53),
     query_timeout_(query_timeout), client_timeout_(client_timeout),
-    lookup_timeout_(lookup_timeout), retries_(retries), rtt_recorder_()
+    lookup_timeout_(lookup_timeout), retries_(retries), rtt_recorder_(),
+    tcp_pool_()
 {
 }
 
@@ -153,6 +156,22 @@ RecursiveQuery::setTestServer(const std::string& address, uint16_t port) {
     test_server_.second = port;
 }
 
+// Set the port of the authoritative servers - only used for benchmarks.
+void
+RecursiveQuery::setUpstreamPort(uint16_t port) {
+    upstream_port_ = port;
+}
+
+// The pool is created on first use, as the IOService of the DNS service
+// may not be available yet when this object is constructed.
+const TCPConnectionPoolPtr&
+RecursiveQuery::getTCPConnectionPool() {
+    if (!tcp_pool_) {
+        tcp_pool_.reset(new TCPConnectionPool(dns_service_.getIOService()));
+    }
+    return (tcp_pool_);
+}
+
 // Set the RTT recorder - only used for testing
 void
 RecursiveQuery::setRttRecorder(boost::shared_ptr<RttRecorder>& recorder) {
@@ -171,11 +190,30 @@ typedef std::pair<std::string, uint16_t> addr_t;
  */
 class RunningQuery : public IOFetch::Callback, public AbstractRunningQuery {
 
-class ResolverNSASCallback : public bundy::nsas::AddressRequestCallback {
+// The NSAS may be shared between several resolver threads, each running
+// its own IOService, and the thread that completes an address lookup
+// invokes every callback waiting for the zone.  A callback coming from
+// a thread other than the one the query belongs to is therefore not
+// run directly but posted to the query's IOService; the query detaches
+// itself from the callback before it is deleted so a late delivery is
+// simply dropped.
+class ResolverNSASCallback : public bundy::nsas::AddressRequestCallback,
+    public boost::enable_shared_from_this<ResolverNSASCallback>
+{
 public:
-    ResolverNSASCallback(RunningQuery* rq) : rq_(rq) {}
+    ResolverNSASCallback(RunningQuery* rq, IOService& io) :
+        rq_(rq), io_(io), owner_(pthread_self())
+    {}
 
     void success(const bundy::nsas::NameserverAddress& address) {
+        if (!pthread_equal(pthread_self(), owner_)) {
+            io_.post(boost::bind(&ResolverNSASCallback::success,
+                                 shared_from_this(), address));
+            return;
+        }
+        if (rq_ == NULL) {
+            return;
+        }
         // Success callback, send query to found namesever
         LOG_DEBUG(bundy::resolve::logger, RESLIB_DBG_CB, RESLIB_RUNQ_SUCCESS)
                   .arg(address.getAddress().toText());
@@ -184,16 +222,32 @@ public:
     }
 
     void unreachable() {
+        if (!pthread_equal(pthread_self(), owner_)) {
+            io_.post(boost::bind(&ResolverNSASCallback::unreachable,
+                                 shared_from_this()));
+            return;
+        }
+        if (rq_ == NULL) {
+            return;
+        }
         // Nameservers unreachable: drop query or send servfail?
         LOG_DEBUG(bundy::resolve::logger, RESLIB_DBG_CB, RESLIB_RUNQ_FAIL);
         rq_->nsasCallbackCalled();
-        rq_->makeSERVFAIL();
+        rq_->makeFailureAnswer();
         rq_->callCallback(true);
         rq_->stop();
     }
 
+    // Called by the query when it is about to be deleted.  Must be
+    // called in the owner thread.
+    void detach() {
+        rq_ = NULL;
+    }
+
 private:
     RunningQuery* rq_;
+    IOService& io_;
+    const pthread_t owner_;
 };
 
 
@@ -214,6 +268,10 @@ private:
     // other servers if the port is non-zero.
     std::pair<std::string, uint16_t> test_server_;
 
+    // Port of the authoritative servers (53 unless a benchmark says
+    // otherwise).
+    uint16_t upstream_port_;
+
     // Buffer to store the intermediate results.
     OutputBufferPtr buffer_;
 
@@ -305,6 +363,9 @@ private:
     // sent to this object as well as being used to update the NSAS.
     boost::shared_ptr<RttRecorder> rtt_recorder_;
 
+    // Pool of TCP connections to the upstream servers.
+    TCPConnectionPoolPtr tcp_pool_;
+
     // perform a single lookup; first we check the cache to see
     // if we have a response for our query stored already. if
     // so, call handlerecursiveresponse(), if not, we call send()
@@ -349,12 +410,14 @@ private:
                 test_server_.first,
                 test_server_.second, buffer_, this,
                 query_timeout_, edns_);
+            query.setConnectionPool(tcp_pool_);
             io_.get_io_service().post(query);
         } else {
             IOFetch query(protocol_, io_, question_,
                 current_ns_address.getAddress(),
-                53, buffer_, this,
+                upstream_port_, buffer_, this,
                 query_timeout_, edns_);
+            query.setConnectionPool(tcp_pool_);
             io_.get_io_service().post(query);
         }
     }
@@ -374,6 +437,7 @@ private:
                 test_server_.first,
                 test_server_.second, buffer_, this,
                 query_timeout_, edns_);
+            query.setConnectionPool(tcp_pool_);
             io_.get_io_service().post(query);
 
         } else {
@@ -570,7 +634,14 @@ SERVFAIL:
             if (logger.isDebugEnabled()) {
                 reportResponseClassifierError(category, incoming.getRcode());
             }
-            makeSERVFAIL();
+            // Only a server failure upstream is answered with stale data,
+            // not a broken response.
+            if (category == bundy::resolve::ResponseClassifier::RCODE &&
+                incoming.getRcode() == Rcode::SERVFAIL()) {
+                makeFailureAnswer();
+            } else {
+                makeSERVFAIL();
+            }
             return (true);
         }
 
@@ -670,19 +741,22 @@ public:
         const Question& question,
         MessagePtr answer_message,
         std::pair<std::string, uint16_t>& test_server,
+        uint16_t upstream_port,
         OutputBufferPtr buffer,
         bundy::resolve::ResolverInterface::CallbackPtr cb,
         int query_timeout, int client_timeout, int lookup_timeout,
         unsigned retries,
         bundy::nsas::NameserverAddressStore& nsas,
         bundy::cache::ResolverCache& cache,
-        boost::shared_ptr<RttRecorder>& recorder)
+        boost::shared_ptr<RttRecorder>& recorder,
+        const TCPConnectionPoolPtr& tcp_pool)
         :
         io_(io),
         question_(question),
         query_message_(),
         answer_message_(answer_message),
         test_server_(test_server),
+        upstream_port_(upstream_port),
         buffer_(buffer),
         resolvercallback_(cb),
         protocol_(IOFetch::UDP),
@@ -699,10 +773,11 @@ public:
         nsas_callback_(),
         nsas_callback_out_(false),
         outstanding_events_(0),
-        rtt_recorder_(recorder)
+        rtt_recorder_(recorder),
+        tcp_pool_(tcp_pool)
     {
         // Set here to avoid using "this" in initializer list.
-        nsas_callback_.reset(new ResolverNSASCallback(this));
+        nsas_callback_.reset(new ResolverNSASCallback(this, io_));
 
         // Setup the timer to stop trying (lookup_timeout)
         if (lookup_timeout >= 0) {
@@ -729,7 +804,7 @@ public:
     // not been called, call it now. Then stop.
     void lookupTimeout() {
         if (!callback_called_) {
-            makeSERVFAIL();
+            makeFailureAnswer();
             callCallback(true);
         }
         assert(outstanding_events_ > 0);
@@ -741,7 +816,7 @@ public:
     // not been called, call it now. But do not stop.
     void clientTimeout() {
         if (!callback_called_) {
-            makeSERVFAIL();
+            makeFailureAnswer();
             callCallback(true);
         }
         assert(outstanding_events_ > 0);
@@ -796,6 +871,7 @@ public:
         if (outstanding_events_ > 0) {
             return;
         } else {
+            nsas_callback_->detach();
             delete this;
         }
     }
@@ -879,7 +955,11 @@ public:
                 current_ns_address.updateRTT(bundy::nsas::AddressEntry::UNREACHABLE);
             }
             if (!callback_called_) {
-                makeSERVFAIL();
+                if (result == IOFetch::TIME_OUT) {
+                    makeFailureAnswer();
+                } else {
+                    makeSERVFAIL();
+                }
                 callCallback(true);
             }
             stop();
@@ -893,6 +973,34 @@ public:
             bundy::resolve::makeErrorMessage(answer_message_, Rcode::SERVFAIL());
         }
     }
+
+    // We failed to get the answer in time, or the servers failed to give
+    // it (SERVFAIL).  If the cache keeps expired data, answer with it
+    // (RFC 8767), otherwise SERVFAIL.  Only positive answers are served
+    // stale, as the cache doesn't keep the rcode.  Other errors (broken
+    // responses, CNAME loops) are answered with makeSERVFAIL() directly.
+    void makeFailureAnswer() {
+        if (!answer_message_ || cache_.getMaxStaleTTL() == 0 ||
+            answer_message_->beginQuestion() ==
+            answer_message_->endQuestion()) {
+            makeSERVFAIL();
+            return;
+        }
+        // Any partial answer (e.g. the CNAMEs followed so far) is replaced
+        // by what the cache has for the original question.
+        bundy::resolve::makeErrorMessage(answer_message_, Rcode::NOERROR());
+        const Question& question = **answer_message_->beginQuestion();
+        if (cache_.lookupStale(question.getName(), question.getType(),
+                               question.getClass(), *answer_message_) &&
+            answer_message_->getRRCount(Message::SECTION_ANSWER) > 0) {
+            LOG_DEBUG(bundy::resolve::logger, RESLIB_DBG_RESULTS,
+                      RESLIB_STALE_ANSWER).arg(questionText(question));
+            answer_message_->setOpcode(Opcode::QUERY());
+            answer_message_->setHeaderFlag(Message::HEADERFLAG_QR);
+        } else {
+            makeSERVFAIL();
+        }
+    }
 };
 
 class ForwardQuery : public IOFetch::Callback, public AbstractRunningQuery {
@@ -935,6 +1043,9 @@ private:
     // don't call back a second time later
     bool callback_called_;
 
+    // Pool of TCP connections to the upstream servers.
+    TCPConnectionPoolPtr tcp_pool_;
+
     // send the query to the server.
     void send(IOFetch::Protocol protocol = IOFetch::UDP) {
         const int uc = upstream_->size();
@@ -953,6 +1064,7 @@ private:
             upstream_->at(serverIndex).first,
             upstream_->at(serverIndex).second,
             buffer_, this, query_timeout_);
+        query.setConnectionPool(tcp_pool_);
 
         io_.get_io_service().post(query);
     }
@@ -964,7 +1076,8 @@ public:
         boost::shared_ptr<AddressVector> upstream,
         OutputBufferPtr buffer,
         bundy::resolve::ResolverInterface::CallbackPtr cb,
-        int query_timeout, int client_timeout, int lookup_timeout) :
+        int query_timeout, int client_timeout, int lookup_timeout,
+        const TCPConnectionPoolPtr& tcp_pool) :
         io_(io),
         query_message_(query_message),
         answer_message_(answer_message),
@@ -975,7 +1088,8 @@ public:
         client_timer(io.get_io_service()),
         lookup_timer(io.get_io_service()),
         outstanding_events_(0),
-        callback_called_(false)
+        callback_called_(false),
+        tcp_pool_(tcp_pool)
     {
         // Setup the timer to stop trying (lookup_timeout)
         if (lookup_timeout >= 0) {
@@ -1119,10 +1233,11 @@ RecursiveQuery::resolve(const QuestionPtr& question,
             LOG_DEBUG(bundy::resolve::logger, RESLIB_DBG_TRACE, RESLIB_RECQ_CACHE_NO_FIND)
                       .arg(questionText(*question)).arg(1);
             return (new RunningQuery(io, *question, answer_message,
-                                     test_server_, buffer, callback,
+                                     test_server_, upstream_port_, buffer, callback,
                                      query_timeout_, client_timeout_,
                                      lookup_timeout_, retries_, nsas_,
-                                     cache_, rtt_recorder_));
+                                     cache_, rtt_recorder_,
+                                     getTCPConnectionPool()));
         }
     }
     return (NULL);
@@ -1182,9 +1297,11 @@ RecursiveQuery::resolve(const Question& question,
             LOG_DEBUG(bundy::resolve::logger, RESLIB_DBG_TRACE, RESLIB_RECQ_CACHE_NO_FIND)
                       .arg(questionText(question)).arg(2);
             return (new RunningQuery(io, question, answer_message,
-                                     test_server_, buffer, crs, query_timeout_,
+                                     test_server_, upstream_port_, buffer, crs,
+                                     query_timeout_,
                                      client_timeout_, lookup_timeout_, retries_,
-                                     nsas_, cache_, rtt_recorder_));
+                                     nsas_, cache_, rtt_recorder_,
+                                     getTCPConnectionPool()));
         }
     }
     return (NULL);
@@ -1218,7 +1335,8 @@ RecursiveQuery::forward(ConstMessagePtr query_message,
     // It will delete itself when it is done
     return (new ForwardQuery(io, query_message, answer_message,
                              upstream_, buffer, callback, query_timeout_,
-                             client_timeout_, lookup_timeout_));
+                             client_timeout_, lookup_timeout_,
+                             getTCPConnectionPool()));
 }
 
 } // namespace asiodns
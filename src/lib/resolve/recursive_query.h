@@ -18,6 +18,7 @@
 #include <util/buffer.h>
 #include <asiodns/dns_service.h>
 #include <asiodns/dns_server.h>
+#include <asiodns/tcp_connection_pool.h>
 #include <nsas/nameserver_address_store.h>
 #include <cache/resolver_cache.h>
 
@@ -208,7 +209,21 @@ public:
     /// \param port Port number of the test server
     void setTestServer(const std::string& address, uint16_t port);
 
+    /// \brief Set the port of the authoritative servers
+    ///
+    /// The addresses of the authoritative servers come from the NSAS
+    /// and the queries are sent to port 53 on them.  This method changes
+    /// the port, so a resolver can be run against a simulated hierarchy
+    /// of servers that can't bind port 53 (see the resolver benchmark).
+    /// It is not meant for production use.
+    ///
+    /// \param port Port number the queries are sent to.
+    void setUpstreamPort(uint16_t port);
+
 private:
+    /// \brief Return the pool of TCP connections, creating it if needed.
+    const TCPConnectionPoolPtr& getTCPConnectionPool();
+
     DNSServiceBase& dns_service_;
     bundy::nsas::NameserverAddressStore& nsas_;
     bundy::cache::ResolverCache& cache_;
@@ -217,11 +232,13 @@ private:
     boost::shared_ptr<std::vector<std::pair<std::string, uint16_t> > >
         upstream_root_;
     std::pair<std::string, uint16_t> test_server_;
+    uint16_t upstream_port_;
     int query_timeout_;
     int client_timeout_;
     int lookup_timeout_;
     unsigned retries_;
     boost::shared_ptr<RttRecorder>  rtt_recorder_;  ///< Round-trip time recorder
+    TCPConnectionPoolPtr tcp_pool_; ///< Connections for TCP upstream queries
 };
 
 }      // namespace asiodns
@@ -17,6 +17,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/time.h>
+#include <unistd.h>
 
 #include <cstring>
 
@@ -37,10 +38,15 @@
 #include <util/buffer.h>
 #include <util/unittests/resolver.h>
 #include <dns/message.h>
+#include <dns/messagerenderer.h>
+#include <dns/opcode.h>
 #include <dns/rdataclass.h>
+#include <dns/rrset.h>
+#include <dns/rrttl.h>
 
 #include <nsas/nameserver_address_store.h>
 #include <cache/resolver_cache.h>
+#include <cache/rrset_entry.h>
 #include <resolve/resolve.h>
 
 // IMPORTANT: We shouldn't directly use ASIO definitions in this test.
@@ -337,6 +343,12 @@ protected:
         dns_service_.reset(new DNSService(io_service_, callback_.get(), NULL));
     }
 
+    // Resolve the question of the stale answer tests, with the test socket
+    // as the upstream server.  The server answers with the given data (its
+    // QID is set to the one of the query), or doesn't answer at all if
+    // the data is empty.  Returns the answer given to the client.
+    MessagePtr resolveStale(vector<uint8_t> reply);
+
     // Run a simple server test, on either IPv4 or IPv6, and over either
     // UDP or TCP.  Calls the sendUDP() or sendTCP() methods, which will
     // start the IO Service queue.  The UDPServer or TCPServer that was
@@ -1000,6 +1012,168 @@ TEST_F(RecursiveQueryTest, CachedNS) {
         "It does not ask NSAS anything, how does it know where to send?";
 }
 
+// Resolver callback of the stale answer tests, keeping the answer.
+class StaleAnswerCallback :
+        public bundy::resolve::ResolverInterface::Callback {
+public:
+    StaleAnswerCallback(IOService& io_service) : io_service_(io_service) {}
+
+    void success(const bundy::dns::MessagePtr response) {
+        answer_ = response;
+        io_service_.stop();
+    }
+
+    void failure() {
+        io_service_.stop();
+    }
+
+    IOService& io_service_;
+    MessagePtr answer_;
+};
+
+MessagePtr
+RecursiveQueryTest::resolveStale(vector<uint8_t> reply) {
+    setDNSService();
+    sock_.reset(createTestSocket());
+
+    // No retry, and the client timer is longer than the query timeout.
+    const vector<pair<string, uint16_t> > empty_vector;
+    RecursiveQuery rq(*dns_service_, *nsas_, cache_, empty_vector,
+                      empty_vector, 100, 2000, 3000, 0);
+    rq.setTestServer(TEST_IPV4_ADDR,
+                     boost::lexical_cast<uint16_t>(TEST_CLIENT_PORT));
+    boost::shared_ptr<StaleAnswerCallback> callback(
+        new StaleAnswerCallback(io_service_));
+    running_query_ = rq.resolve(QuestionPtr(new Question(
+                                    Name("www.example.org"), RRClass::IN(),
+                                    RRType::A())), callback);
+
+    if (!reply.empty()) {
+        // Send the query, then answer it (see recvUDP()).
+        io_service_.run_one();
+        io_service_.run_one();
+        const struct timeval timeo = { 10, 0 };
+        EXPECT_EQ(0, setsockopt(sock_.s_, SOL_SOCKET, SO_RCVTIMEO, &timeo,
+                                sizeof(timeo)));
+        uint8_t query[512];
+        struct sockaddr_storage from;
+        socklen_t from_len = sizeof(from);
+        const int length = recvfrom(sock_.s_, query, sizeof(query), 0,
+                                    reinterpret_cast<struct sockaddr*>(&from),
+                                    &from_len);
+        EXPECT_LE(2, length);
+        if (length >= 2) {
+            reply[0] = query[0];
+            reply[1] = query[1];
+            EXPECT_EQ(static_cast<int>(reply.size()),
+                      sendto(sock_.s_, &reply[0], reply.size(), 0,
+                             reinterpret_cast<struct sockaddr*>(&from),
+                             from_len));
+        }
+    }
+    io_service_.run();
+    return (callback->answer_);
+}
+
+// Put an answer to the question of the stale answer tests in the cache.
+// It expires right away.  (The RRsets given to the cache directly are
+// local zone data, which doesn't expire, so it is a message from the
+// wire.)
+void
+addExpiredAnswer(bundy::cache::ResolverCache& cache) {
+    Message response(Message::RENDER);
+    response.setHeaderFlag(Message::HEADERFLAG_QR);
+    response.setHeaderFlag(Message::HEADERFLAG_AA);
+    response.setOpcode(Opcode::QUERY());
+    response.setRcode(Rcode::NOERROR());
+    response.addQuestion(Question(Name("www.example.org"), RRClass::IN(),
+                                  RRType::A()));
+    RRsetPtr rrset(new RRset(Name("www.example.org"), RRClass::IN(),
+                             RRType::A(), RRTTL(0)));
+    rrset->addRdata(rdata::in::A("192.0.2.1"));
+    response.addRRset(Message::SECTION_ANSWER, rrset);
+    MessageRenderer renderer;
+    response.toWire(renderer);
+
+    InputBuffer buffer(renderer.getData(), renderer.getLength());
+    Message parsed(Message::PARSE);
+    parsed.fromWire(buffer);
+    ASSERT_TRUE(cache.update(parsed));
+}
+
+// The expired answer is served when the server doesn't answer.
+TEST_F(RecursiveQueryTest, staleAnswerOnTimeout) {
+    cache_.setMaxStaleTTL(3600);
+    addExpiredAnswer(cache_);
+
+    const MessagePtr answer(resolveStale(vector<uint8_t>()));
+    ASSERT_TRUE(answer);
+    EXPECT_EQ(Rcode::NOERROR(), answer->getRcode());
+    ASSERT_EQ(1, answer->getRRCount(Message::SECTION_ANSWER));
+    const RRsetPtr rrset(*answer->beginSection(Message::SECTION_ANSWER));
+    EXPECT_EQ(Name("www.example.org"), rrset->getName());
+    EXPECT_EQ(RRTTL(bundy::cache::STALE_ANSWER_TTL), rrset->getTTL());
+}
+
+// The expired answer is served when the server fails.
+TEST_F(RecursiveQueryTest, staleAnswerOnServfail) {
+    cache_.setMaxStaleTTL(3600);
+    addExpiredAnswer(cache_);
+
+    Message reply(Message::RENDER);
+    reply.setQid(0);
+    reply.setHeaderFlag(Message::HEADERFLAG_QR);
+    reply.setOpcode(Opcode::QUERY());
+    reply.setRcode(Rcode::SERVFAIL());
+    reply.addQuestion(Question(Name("www.example.org"), RRClass::IN(),
+                               RRType::A()));
+    MessageRenderer renderer;
+    reply.toWire(renderer);
+    const uint8_t* data = static_cast<const uint8_t*>(renderer.getData());
+
+    const MessagePtr answer(resolveStale(vector<uint8_t>(
+        data, data + renderer.getLength())));
+    ASSERT_TRUE(answer);
+    EXPECT_EQ(Rcode::NOERROR(), answer->getRcode());
+    EXPECT_EQ(1, answer->getRRCount(Message::SECTION_ANSWER));
+}
+
+// A broken response is not answered with the expired answer.
+TEST_F(RecursiveQueryTest, noStaleAnswerOnProtocolError) {
+    cache_.setMaxStaleTTL(3600);
+    addExpiredAnswer(cache_);
+
+    // A response header announcing a question which is not there.
+    const uint8_t header[] = { 0, 0, 0x80, 0, 0, 1, 0, 0, 0, 0, 0, 0 };
+    const MessagePtr answer(resolveStale(vector<uint8_t>(
+        header, header + sizeof(header))));
+    ASSERT_TRUE(answer);
+    EXPECT_EQ(Rcode::SERVFAIL(), answer->getRcode());
+    EXPECT_EQ(0, answer->getRRCount(Message::SECTION_ANSWER));
+}
+
+// The answer which expired more than max_stale_ttl ago is not served.
+TEST_F(RecursiveQueryTest, staleAnswerExpired) {
+    cache_.setMaxStaleTTL(1);
+    addExpiredAnswer(cache_);
+    sleep(2);
+
+    const MessagePtr answer(resolveStale(vector<uint8_t>()));
+    ASSERT_TRUE(answer);
+    EXPECT_EQ(Rcode::SERVFAIL(), answer->getRcode());
+    EXPECT_EQ(0, answer->getRRCount(Message::SECTION_ANSWER));
+}
+
+// No expired answer is served when serving stale data is disabled.
+TEST_F(RecursiveQueryTest, staleAnswerDisabled) {
+    addExpiredAnswer(cache_);
+
+    const MessagePtr answer(resolveStale(vector<uint8_t>()));
+    ASSERT_TRUE(answer);
+    EXPECT_EQ(Rcode::SERVFAIL(), answer->getRcode());
+    EXPECT_EQ(0, answer->getRRCount(Message::SECTION_ANSWER));
+}
+
 // TODO: add tests that check whether the cache is updated on succesfull
 // responses, and not updated on failures.
 
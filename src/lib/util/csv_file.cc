@@ -16,9 +16,14 @@
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/constants.hpp>
 #include <boost/algorithm/string/split.hpp>
+#include <cerrno>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 
+#include <fcntl.h>
+#include <unistd.h>
+
 namespace bundy {
 namespace util {
 
@@ -80,7 +85,7 @@ CSVRow::checkIndex(const size_t at) const {
 }
 
 CSVFile::CSVFile(const std::string& filename)
-    : filename_(filename), fs_(), cols_(0), read_msg_() {
+    : filename_(filename), fs_(), cols_(0), read_msg_(), buffered_(false) {
 }
 
 CSVFile::~CSVFile() {
@@ -103,6 +108,28 @@ CSVFile::flush() const {
     fs_->flush();
 }
 
+void
+CSVFile::sync() const {
+    flush();
+    // Any descriptor of the file can be used to flush its data to the disk.
+    const int fd = ::open(filename_.c_str(), O_WRONLY);
+    if (fd < 0) {
+        bundy_throw(CSVFileError, "unable to open '" << filename_
+                  << "' to flush it to the disk: " << strerror(errno));
+    }
+#ifdef OS_LINUX
+    const int result = fdatasync(fd);
+#else
+    const int result = fsync(fd);
+#endif
+    const int error = errno;
+    ::close(fd);
+    if (result != 0) {
+        bundy_throw(CSVFileError, "unable to flush '" << filename_
+                  << "' to the disk: " << strerror(error));
+    }
+}
+
 void
 CSVFile::addColumn(const std::string& col_name) {
     // It is not allowed to add a new column when file is open.
@@ -146,7 +173,10 @@ CSVFile::append(const CSVRow& row) const {
     fs_->clear();
 
     std::string text = row.render();
-    *fs_ << text << std::endl;
+    *fs_ << text << '\n';
+    if (!buffered_) {
+        fs_->flush();
+    }
     if (!fs_->good()) {
         fs_->clear();
         bundy_throw(CSVFileError, "failed to write CSV row '"
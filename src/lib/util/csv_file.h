@@ -273,6 +273,11 @@ std::ostream& operator<<(std::ostream& os, const CSVRow& row);
 /// immediately written into it. The header consists of the column names
 /// specified with the @c addColumn function. The subsequent rows are written
 /// into this file by calling @c append.
+///
+/// Each row appended is flushed to the file by default.  When the file is
+/// set to buffered mode with @c setBuffered, the rows are kept in the stream
+/// buffer until @c flush or @c sync is called, so a batch of rows can be
+/// written (and flushed to the disk) at once.
 class CSVFile {
 public:
 
@@ -309,6 +314,25 @@ public:
     /// @brief Flushes a file.
     void flush() const;
 
+    /// @brief Flushes a file and waits until its data are on the disk.
+    ///
+    /// @throw CSVFileError if the file is not open or the data couldn't be
+    /// written to the disk.
+    void sync() const;
+
+    /// @brief Enables or disables the buffered mode.
+    ///
+    /// @param buffered true if the rows appended shouldn't be flushed to
+    /// the file until @c flush or @c sync is called.
+    void setBuffered(const bool buffered) {
+        buffered_ = buffered;
+    }
+
+    /// @brief Checks if the file is in the buffered mode.
+    bool isBuffered() const {
+        return (buffered_);
+    }
+
     /// @brief Returns the number of columns in the file.
     size_t getColumnCount() const {
         return (cols_.size());
@@ -469,6 +493,9 @@ private:
 
     /// @brief Holds last error during row reading or validation.
     std::string read_msg_;
+
+    /// @brief Indicates if the rows appended are flushed on demand only.
+    bool buffered_;
 };
 
 } // namespace bundy::util
@@ -12,50 +12,186 @@
 // OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
-/// This file (right now) provides dummy locks
-/// It also contains code to use boost/threads locks:
+/// This file provides the locks used by the data structures which may be
+/// shared between the threads of a multi-threaded server (the nameserver
+/// address store and the resolver cache, for example).
 ///
+/// The interface mimics (a very minimal subset of) the boost::interprocess
+/// locks, which were originally planned to be used here.  They are thin
+/// wrappers around the POSIX thread primitives, so the code using them must
+/// be compiled and linked with the multithreading flags.
 ///
-/// All locks are dummy classes that don't actually do anything. At this moment,
-/// only the very minimal set of methods that we actually use is defined.
-///
-/// Note that we need to include <config.h> in our .cc files for that
-/// to be set. we might want to enfore this at compile time with a check
-/// (TODO)
+/// Only the very minimal set of methods that we actually use is defined.
 
 #ifndef LOCKS
 #define LOCKS
 
+#include <boost/noncopyable.hpp>
+
+#include <pthread.h>
+#include <cassert>
+#include <new>
+
 namespace bundy {
 namespace util {
 namespace locks {
 
-class mutex {
+/// \brief Non-recursive exclusive mutex.
+class mutex : boost::noncopyable {
+public:
+    mutex() {
+        init(PTHREAD_MUTEX_DEFAULT);
+    }
+
+    ~mutex() {
+        pthread_mutex_destroy(&mutex_);
+    }
+
+    void lock() {
+        const int result = pthread_mutex_lock(&mutex_);
+        assert(result == 0);
+        static_cast<void>(result);
+    }
+
+    void unlock() {
+        const int result = pthread_mutex_unlock(&mutex_);
+        assert(result == 0);
+        static_cast<void>(result);
+    }
+
+    /// \brief Shared lock, which is the same as the exclusive one here.
+    void lock_sharable() {
+        lock();
+    }
+
+    void unlock_sharable() {
+        unlock();
+    }
+
+protected:
+    /// \brief Constructor for derived classes of other mutex types.
+    ///
+    /// \param type One of the PTHREAD_MUTEX_* types.
+    explicit mutex(int type) {
+        init(type);
+    }
+
+private:
+    void init(int type) {
+        pthread_mutexattr_t attributes;
+        if (pthread_mutexattr_init(&attributes) != 0) {
+            throw std::bad_alloc();
+        }
+        const int result =
+            (pthread_mutexattr_settype(&attributes, type) == 0) ?
+            pthread_mutex_init(&mutex_, &attributes) : -1;
+        pthread_mutexattr_destroy(&attributes);
+        if (result != 0) {
+            throw std::bad_alloc();
+        }
+    }
+
+    pthread_mutex_t mutex_;
 };
 
-class recursive_mutex {
+/// \brief Mutex which may be locked repeatedly by the thread holding it.
+class recursive_mutex : public mutex {
+public:
+    recursive_mutex() : mutex(PTHREAD_MUTEX_RECURSIVE) {}
 };
 
-class upgradable_mutex {
+/// \brief Reader-writer mutex.
+///
+/// It can be held by many readers (\c sharable_lock) at once, or by a single
+/// writer (\c scoped_lock).
+class upgradable_mutex : boost::noncopyable {
+public:
+    upgradable_mutex() {
+        if (pthread_rwlock_init(&rwlock_, NULL) != 0) {
+            throw std::bad_alloc();
+        }
+    }
+
+    ~upgradable_mutex() {
+        pthread_rwlock_destroy(&rwlock_);
+    }
+
+    void lock() {
+        const int result = pthread_rwlock_wrlock(&rwlock_);
+        assert(result == 0);
+        static_cast<void>(result);
+    }
+
+    void unlock() {
+        const int result = pthread_rwlock_unlock(&rwlock_);
+        assert(result == 0);
+        static_cast<void>(result);
+    }
+
+    void lock_sharable() {
+        const int result = pthread_rwlock_rdlock(&rwlock_);
+        assert(result == 0);
+        static_cast<void>(result);
+    }
+
+    void unlock_sharable() {
+        unlock();
+    }
+
+private:
+    pthread_rwlock_t rwlock_;
 };
 
+/// \brief Holds a shared lock on the mutex for the lifetime of the object.
 template <typename T>
-class sharable_lock {
+class sharable_lock : boost::noncopyable {
 public:
-    sharable_lock(T) {}
+    sharable_lock(T& mutex) : mutex_(mutex) {
+        mutex_.lock_sharable();
+    }
+
+    ~sharable_lock() {
+        mutex_.unlock_sharable();
+    }
+
+private:
+    T& mutex_;
 };
 
+/// \brief Holds an exclusive lock on the mutex.
+///
+/// The lock is acquired on construction and released on destruction, unless
+/// it was released earlier by \c unlock().
 template <typename T>
-class scoped_lock {
+class scoped_lock : boost::noncopyable {
 public:
-    scoped_lock(T) {}
+    scoped_lock(T& mutex) : mutex_(mutex), locked_(false) {
+        lock();
+    }
 
     // We need to define this explicitly.  Some versions of clang++ would
     // complain about this otherwise.  See Trac ticket #2340
-    ~scoped_lock() {}
+    ~scoped_lock() {
+        if (locked_) {
+            mutex_.unlock();
+        }
+    }
+
+    void lock() {
+        assert(!locked_);
+        mutex_.lock();
+        locked_ = true;
+    }
+
+    void unlock() {
+        assert(locked_);
+        mutex_.unlock();
+        locked_ = false;
+    }
 
-    void lock() {}
-    void unlock() {}
+private:
+    T& mutex_;
+    bool locked_;
 };
 
 } // namespace locks
@@ -109,6 +109,22 @@ public:
     /// \param element Reference to the element to touch.
     virtual void touch(boost::shared_ptr<T>& element);
 
+    /// \brief Return the Oldest Element
+    ///
+    /// \return The least recently used element (the one which would be
+    /// dropped next), or an empty pointer if the list is empty.
+    virtual boost::shared_ptr<T> getOldest();
+
+    /// \brief Drop the Oldest Element
+    ///
+    /// Drops the least recently used element from the list, running the
+    /// drop handler on it (if there is one) as if it dropped off the end of
+    /// a full list.  This allows the owner of the list to limit it by
+    /// something else than the number of the elements.
+    ///
+    /// \return false if the list is empty, true otherwise.
+    virtual bool dropOldest();
+
     /// \brief Drop All the Elements in the List .
     ///
     /// All the elements will be dropped from the list container, and their
@@ -181,7 +197,10 @@ void LruList<T>::add(boost::shared_ptr<T>& element) {
                 (*dropped_)(lru_.begin()->get());
             }
 
-            // ... and get rid of it from the list
+            // ... and get rid of it from the list.  The element may still
+            // be referenced elsewhere, so make sure a later remove() or
+            // touch() on it won't use the stale iterator.
+            (*lru_.begin())->invalidateIterator();
             lru_.pop_front();
             --count_;
         }
@@ -199,16 +218,17 @@ void LruList<T>::add(boost::shared_ptr<T>& element) {
 template <typename T>
 void LruList<T>::remove(boost::shared_ptr<T>& element) {
 
+    // Protect list against concurrent access.  The lock must be taken
+    // before the validity of the element's iterator is checked, as another
+    // thread may be removing or touching the same element.
+    locks::scoped_lock<locks::mutex> lock(mutex_);
+
     // An element can only be removed it its internal pointer is valid.
     // If it is, the pointer can be used to access the list because no matter
     // what other elements are added or removed, the pointer remains valid.
     //
     // If the pointer is not valid, this is a no-op.
     if (element->iteratorValid()) {
-
-        // Is valid, so protect list against concurrent access
-        locks::scoped_lock<locks::mutex> lock(mutex_);
-
         lru_.erase(element->getLruIterator());  // Remove element from list
         element->invalidateIterator();          // Invalidate pointer
         --count_;                               // One less element
@@ -219,12 +239,12 @@ void LruList<T>::remove(boost::shared_ptr<T>& element) {
 template <typename T>
 void LruList<T>::touch(boost::shared_ptr<T>& element) {
 
+    // Protect list against concurrent access
+    locks::scoped_lock<locks::mutex> lock(mutex_);
+
     // As before, if the pointer is not valid, this is a no-op.
     if (element->iteratorValid()) {
 
-        // Protect list against concurrent access
-        locks::scoped_lock<locks::mutex> lock(mutex_);
-
         // Move the element to the end of the list.
         lru_.splice(lru_.end(), lru_, element->getLruIterator());
 
@@ -235,6 +255,40 @@ void LruList<T>::touch(boost::shared_ptr<T>& element) {
     }
 }
 
+// Get the element at the front of the list
+template <typename T>
+boost::shared_ptr<T> LruList<T>::getOldest() {
+
+    // Protect list against concurrent access
+    locks::scoped_lock<locks::mutex> lock(mutex_);
+
+    if (lru_.empty()) {
+        return (boost::shared_ptr<T>());
+    }
+    return (lru_.front());
+}
+
+// Drop the element at the front of the list
+template <typename T>
+bool LruList<T>::dropOldest() {
+
+    // Protect list against concurrent access
+    locks::scoped_lock<locks::mutex> lock(mutex_);
+
+    if (lru_.empty()) {
+        return (false);
+    }
+
+    // The same as dropping an element off a full list in add().
+    if (dropped_) {
+        (*dropped_)(lru_.begin()->get());
+    }
+    (*lru_.begin())->invalidateIterator();
+    lru_.pop_front();
+    --count_;
+    return (true);
+}
+
 // Clear the list-  when done, the size of list will be 0.
 template <typename T>
 void LruList<T>::clear() {
@@ -244,11 +298,12 @@ void LruList<T>::clear() {
     // ... and update the count while we have the mutex.
     count_ = 0;
     typename std::list<boost::shared_ptr<T> >::iterator iter;
-    if (dropped_) {
-        for (iter = lru_.begin(); iter != lru_.end(); ++iter) {
+    for (iter = lru_.begin(); iter != lru_.end(); ++iter) {
+        if (dropped_) {
             // Call the drop handler.
             (*dropped_)(iter->get());
         }
+        (*iter)->invalidateIterator();
     }
 
     lru_.clear();
@@ -367,6 +367,33 @@ TEST_F(CSVFileTest, recreate) {
               readFile());
 }
 
+// This test checks that the rows appended to the buffered file are written
+// when the file is synced.
+TEST_F(CSVFileTest, bufferedSync) {
+    boost::scoped_ptr<CSVFile> csv(new CSVFile(testfile_));
+    csv->addColumn("animal");
+    csv->addColumn("color");
+    ASSERT_NO_THROW(csv->recreate());
+    EXPECT_FALSE(csv->isBuffered());
+    csv->setBuffered(true);
+    EXPECT_TRUE(csv->isBuffered());
+
+    CSVRow row(2);
+    row.writeAt(0, "dog");
+    row.writeAt(1, "grey");
+    ASSERT_NO_THROW(csv->append(row));
+    // The row is still in the buffer.
+    EXPECT_EQ("animal,color\n", readFile());
+
+    ASSERT_NO_THROW(csv->sync());
+    EXPECT_EQ("animal,color\n"
+              "dog,grey\n",
+              readFile());
+
+    csv->close();
+    EXPECT_THROW(csv->sync(), CSVFileError);
+}
+
 // This test checks that the error is reported when the size of the row being
 // read doesn't match the number of columns of the CSV file.
 TEST_F(CSVFileTest, validate) {
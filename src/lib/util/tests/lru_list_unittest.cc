@@ -364,6 +364,33 @@ TEST_F(LruListTest, Dropped) {
 // Clear functor tests: tests whether all the elements in
 // the list are dropped properly and the size of list is
 // set to 0.
+// Dropping the oldest entry explicitly
+TEST_F(LruListTest, DropOldest) {
+
+    LruList<TestEntry> lru(3, new Dropped());
+    EXPECT_FALSE(lru.getOldest());
+    EXPECT_FALSE(lru.dropOldest());
+
+    lru.add(entry1_);
+    lru.add(entry2_);
+    lru.add(entry3_);
+    lru.touch(entry1_);
+    EXPECT_EQ(entry2_, lru.getOldest());
+
+    // The handler runs, as when the entry drops off a full list.
+    EXPECT_TRUE(lru.dropOldest());
+    EXPECT_EQ(2, lru.size());
+    EXPECT_NE(0, (entry2_->getCode() & 0x8000));
+    EXPECT_FALSE(entry2_->iteratorValid());
+    EXPECT_EQ(entry3_, lru.getOldest());
+
+    EXPECT_TRUE(lru.dropOldest());
+    EXPECT_TRUE(lru.dropOldest());
+    EXPECT_EQ(0, lru.size());
+    EXPECT_NE(0, (entry1_->getCode() & 0x8000));
+    EXPECT_FALSE(lru.dropOldest());
+}
+
 TEST_F(LruListTest, Clear) {
     // Create an object with an expiration handler.
     LruList<TestEntry> lru(3, new Dropped());
@@ -390,6 +417,33 @@ TEST_F(LruListTest, Clear) {
     EXPECT_EQ(0, lru.size());
 }
 
+// Check that entries dropped from the list (by the size limit or by
+// clearing it) can still be removed or touched without effect.
+TEST_F(LruListTest, DroppedEntries) {
+    LruList<TestEntry> lru(2);
+
+    lru.add(entry1_);
+    lru.add(entry2_);
+    lru.add(entry3_);   // Drops entry 1
+    EXPECT_EQ(2, lru.size());
+    EXPECT_FALSE(entry1_->iteratorValid());
+
+    lru.remove(entry1_);
+    lru.touch(entry1_);
+    EXPECT_EQ(2, lru.size());
+    EXPECT_EQ(1, entry1_.use_count());
+
+    lru.clear();
+    EXPECT_FALSE(entry2_->iteratorValid());
+    EXPECT_FALSE(entry3_->iteratorValid());
+
+    lru.remove(entry2_);
+    lru.touch(entry3_);
+    EXPECT_EQ(0, lru.size());
+    EXPECT_EQ(1, entry2_.use_count());
+    EXPECT_EQ(1, entry3_.use_count());
+}
+
 // Miscellaneous tests - pathological conditions
 TEST_F(LruListTest, Miscellaneous) {
 
@@ -24,6 +24,7 @@
 #include <cassert>
 
 #include <pthread.h>
+#include <sys/time.h>
 
 using std::auto_ptr;
 
@@ -246,6 +247,35 @@ CondVar::wait(Mutex& mutex) {
     }
 }
 
+bool
+CondVar::timedWait(Mutex& mutex, unsigned int timeout) {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    struct timespec deadline;
+    deadline.tv_sec = now.tv_sec + timeout / 1000;
+    deadline.tv_nsec = now.tv_usec * 1000 + (timeout % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        ++deadline.tv_sec;
+        deadline.tv_nsec -= 1000000000;
+    }
+#ifdef ENABLE_DEBUG
+    mutex.preUnlockAction(true);    // Only in debug mode
+    const int result = pthread_cond_timedwait(&impl_->cond_,
+                                              &mutex.impl_->mutex, &deadline);
+    mutex.postLockAction();     // Only in debug mode
+#else
+    const int result = pthread_cond_timedwait(&impl_->cond_,
+                                              &mutex.impl_->mutex, &deadline);
+#endif
+    if (result == ETIMEDOUT) {
+        return (false);
+    } else if (result != 0) {
+        bundy_throw(bundy::BadValue, "pthread_cond_timedwait failed "
+                  "unexpectedly: " << std::strerror(result));
+    }
+    return (true);
+}
+
 void
 CondVar::signal() {
     const int result = pthread_cond_signal(&impl_->cond_);
@@ -255,6 +285,14 @@ CondVar::signal() {
     assert(result == 0);
 }
 
+void
+CondVar::broadcast() {
+    const int result = pthread_cond_broadcast(&impl_->cond_);
+
+    // Like pthread_cond_signal(), it can only fail if cond_ is invalid.
+    assert(result == 0);
+}
+
 }
 }
 }
@@ -194,11 +194,10 @@ private:
 /// Note that \c mutex passed to the \c wait() method must be the same one
 /// used to construct the \c locker.
 ///
-/// Right now there is no equivalent to pthread_cond_broadcast() or
-/// pthread_cond_timedwait() in this class, because this class is meant
-/// for internal development of BUNDY and we don't need these at the
-/// moment.  If and when we need these interfaces they can be added at that
-/// point.
+/// Right now there is no equivalent to pthread_cond_timedwait() in this
+/// class, because this class is meant for internal development of BUNDY
+/// and we don't need it at the moment.  If and when we need this interface
+/// it can be added at that point.
 ///
 /// \note This class is defined as a friend class of \c Mutex and directly
 /// refers to and modifies private internals of the \c Mutex class.  It breaks
@@ -240,6 +239,19 @@ public:
     /// \param mutex A \c Mutex object to be released on wait().
     void wait(Mutex& mutex);
 
+    /// \brief Wait on the condition variable for a limited time.
+    ///
+    /// This method works like \c wait(), but it gives up waiting when
+    /// the timeout elapses (like \c pthread_cond_timedwait()).
+    ///
+    /// \throw bundy::InvalidOperation mutex isn't locked
+    /// \throw bundy::BadValue mutex is not a valid \c Mutex object
+    ///
+    /// \param mutex A \c Mutex object to be released on wait().
+    /// \param timeout The maximum time to wait, in milliseconds.
+    /// \return false if the timeout elapsed, true otherwise.
+    bool timedWait(Mutex& mutex, unsigned int timeout);
+
     /// \brief Unblock a thread waiting for the condition variable.
     ///
     /// This method wakes one of other threads (if any) waiting on this object
@@ -248,6 +260,15 @@ public:
     /// This method never throws; if some unexpected low level error happens
     /// it terminates the program.
     void signal();
+
+    /// \brief Unblock all threads waiting for the condition variable.
+    ///
+    /// This method works like \c pthread_cond_broadcast().  It wakes all
+    /// the threads (if any) waiting on this object via the \c wait() call.
+    ///
+    /// This method never throws; if some unexpected low level error happens
+    /// it terminates the program.
+    void broadcast();
 private:
     class Impl;
     Impl* impl_;
@@ -170,9 +170,49 @@ TEST_F(CondVarTest, badWait) {
 
 #endif // ENABLE_DEBUG
 
+// Same as multiWaits, but both threads are woken up at once.
+TEST_F(CondVarTest, broadcast) {
+    boost::scoped_ptr<Mutex::Locker> locker(new Mutex::Locker(mutex_));
+    CondVar condvar2;
+    int shared_var = 0;
+    Thread t1(boost::bind(&signalAndWait, &condvar_, &condvar2, &mutex_,
+                          &shared_var));
+    Thread t2(boost::bind(&signalAndWait, &condvar_, &condvar2, &mutex_,
+                          &shared_var));
+
+    while (shared_var < 2 && !do_exit) {
+        condvar2.wait(mutex_);
+    }
+    ASSERT_FALSE(do_exit);
+    ASSERT_EQ(2, shared_var);
+
+    locker.reset();
+    condvar_.broadcast();
+    t1.wait();
+    t2.wait();
+    EXPECT_EQ(4, shared_var);
+}
+
+// The timed wait gives up when nobody signals, and returns when signalled.
+TEST_F(CondVarTest, timedWait) {
+    Mutex::Locker locker(mutex_);
+    EXPECT_FALSE(condvar_.timedWait(mutex_, 10));
+
+    if (!bundy::util::unittests::runningOnValgrind()) {
+        int shared_var = 0;
+        Thread t(boost::bind(&ringSignal, &condvar_, &mutex_, &shared_var));
+        while (shared_var == 0 && !do_exit) {
+            condvar_.timedWait(mutex_, 5000);
+        }
+        t.wait();
+        EXPECT_EQ(1, shared_var);
+    }
+}
+
 TEST_F(CondVarTest, emptySignal) {
-    // It's okay to call signal when no one waits.
+    // It's okay to call signal or broadcast when no one waits.
     EXPECT_NO_THROW(condvar_.signal());
+    EXPECT_NO_THROW(condvar_.broadcast());
 }
 
 }
@@ -0,0 +1,144 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <gtest/gtest.h>
+
+#include <util/locks.h>
+#include <util/threads/thread.h>
+#include <util/unittests/check_valgrind.h>
+
+#include <boost/bind.hpp>
+#include <unistd.h>
+
+// Tests of the locks of util/locks.h, which protect the data structures
+// shared by the threads of the resolver.
+
+using namespace bundy::util::locks;
+using bundy::util::thread::Thread;
+
+namespace {
+
+// As in the tests of the Mutex (see lock_unittest.cc), two threads
+// increment a double, which is not done atomically, under the lock.
+const size_t iterations = 100000;
+
+template <typename MutexType>
+void
+performIncrement(volatile double* canary, volatile bool* ready_me,
+                 volatile bool* ready_other, MutexType* mutex)
+{
+    // Loosely (busy) wait for the other thread so both will start
+    // approximately at the same time.
+    *ready_me = true;
+    while (!*ready_other) {}
+
+    for (size_t i = 0; i < iterations; ++i) {
+        scoped_lock<MutexType> lock(*mutex);
+        *canary += 1;
+    }
+}
+
+template <typename MutexType>
+void
+swarm() {
+    double canary = 0;
+    MutexType mutex;
+    bool ready1 = false;
+    bool ready2 = false;
+    Thread t1(boost::bind(&performIncrement<MutexType>, &canary, &ready1,
+                          &ready2, &mutex));
+    Thread t2(boost::bind(&performIncrement<MutexType>, &canary, &ready2,
+                          &ready1, &mutex));
+    t1.wait();
+    t2.wait();
+    EXPECT_EQ(iterations * 2, canary) << "Threads are badly synchronized";
+}
+
+TEST(LocksTest, mutexSwarm) {
+    if (!bundy::util::unittests::runningOnValgrind()) {
+        swarm<mutex>();
+    }
+}
+
+TEST(LocksTest, recursiveMutexSwarm) {
+    if (!bundy::util::unittests::runningOnValgrind()) {
+        swarm<recursive_mutex>();
+    }
+}
+
+TEST(LocksTest, upgradableMutexSwarm) {
+    if (!bundy::util::unittests::runningOnValgrind()) {
+        swarm<upgradable_mutex>();
+    }
+}
+
+// The scoped lock can be released and taken again.
+TEST(LocksTest, scopedLockUnlock) {
+    mutex m;
+    scoped_lock<mutex> lock(m);
+    lock.unlock();
+    // Another lock succeeds, it would block forever otherwise.
+    {
+        scoped_lock<mutex> other(m);
+    }
+    lock.lock();
+}
+
+// The thread holding the recursive mutex can lock it again.
+TEST(LocksTest, recursiveMutexRelock) {
+    recursive_mutex m;
+    scoped_lock<recursive_mutex> lock1(m);
+    scoped_lock<recursive_mutex> lock2(m);
+    sharable_lock<recursive_mutex> lock3(m);
+}
+
+void
+takeSharable(upgradable_mutex* m, volatile bool* done) {
+    sharable_lock<upgradable_mutex> lock(*m);
+    *done = true;
+}
+
+void
+takeExclusive(upgradable_mutex* m, volatile bool* done) {
+    scoped_lock<upgradable_mutex> lock(*m);
+    *done = true;
+}
+
+// Several readers hold the upgradable mutex at once.
+TEST(LocksTest, upgradableMutexReaders) {
+    upgradable_mutex m;
+    sharable_lock<upgradable_mutex> lock(m);
+    bool done = false;
+    Thread thread(boost::bind(&takeSharable, &m, &done));
+    thread.wait();
+    EXPECT_TRUE(done);
+}
+
+// The writer waits for the readers to release the upgradable mutex.
+TEST(LocksTest, upgradableMutexWriter) {
+    upgradable_mutex m;
+    bool done = false;
+    m.lock_sharable();
+    Thread thread(boost::bind(&takeExclusive, &m, &done));
+    // Give the writer some time, it must keep waiting.
+    usleep(100000);
+    EXPECT_FALSE(done);
+    m.unlock_sharable();
+    thread.wait();
+    EXPECT_TRUE(done);
+}
+
+}
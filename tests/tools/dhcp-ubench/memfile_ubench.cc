@@ -14,29 +14,61 @@
 
 #include <sstream>
 #include <iostream>
-#include <map>
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
 #include "memfile_ubench.h"
 
 using namespace std;
 
+/// The lease storage indexes are hashed, like the ones of the memfile
+/// backend of the DHCP servers.  Define MEMFILE_ORDERED_INDEX (e.g. with
+/// "make MEMFILE_CFLAGS=-DMEMFILE_ORDERED_INDEX") to use ordered (tree)
+/// indexes instead and compare.
+#ifdef MEMFILE_ORDERED_INDEX
+#define MEMFILE_UNIQUE_INDEX boost::multi_index::ordered_unique
+#define MEMFILE_NON_UNIQUE_INDEX boost::multi_index::ordered_non_unique
+#else
+#define MEMFILE_UNIQUE_INDEX boost::multi_index::hashed_unique
+#define MEMFILE_NON_UNIQUE_INDEX boost::multi_index::hashed_non_unique
+#endif
+
 
 /// @brief In-memory + lease file database implementation
 ///
 /// This is a simplified in-memory database that mimics ISC DHCP4 implementation.
-/// It uses STL and boost: std::map for storage, boost::shared ptr for memory
+/// It uses boost: multi_index_container for storage, shared ptr for memory
 /// management. It does use C file operations (fopen, fwrite, etc.), because
 /// C++ streams does not offer any easy way to flush their contents, like
 /// fflush() and fsync() does.
 ///
-/// IPv4 address is used as a key in the hash.
+/// The leases are found by IPv4 address, hardware address and client
+/// identifier, as the allocation engine does.
 class memfile_LeaseMgr {
 public:
 
-    /// A hash table for Lease4 leases.
-    typedef std::map<uint32_t /* addr */, Lease4Ptr /* lease info */> IPv4Hash;
+    /// A hash table for Lease4 leases, indexed by the address (0), the
+    /// hardware address (1) and the client identifier (2).
+    typedef boost::multi_index_container<
+        Lease4Ptr,
+        boost::multi_index::indexed_by<
+            MEMFILE_UNIQUE_INDEX<
+                boost::multi_index::member<Lease4, uint32_t, &Lease4::addr>
+            >,
+            MEMFILE_NON_UNIQUE_INDEX<
+                boost::multi_index::member<Lease4, std::vector<uint8_t>,
+                                           &Lease4::hwaddr>
+            >,
+            MEMFILE_NON_UNIQUE_INDEX<
+                boost::multi_index::member<Lease4, std::vector<uint8_t>,
+                                           &Lease4::client_id>
+            >
+        >
+    > IPv4Hash;
 
     /// An iterator for Lease4 hash table.
-    typedef std::map<uint32_t, Lease4Ptr>::iterator leaseIt;
+    typedef IPv4Hash::iterator leaseIt;
 
     /// @brief The sole memfile lease manager constructor
     ///
@@ -59,6 +91,20 @@ public:
     /// @return smart pointer to the lease (or NULL if lease is not found)
     Lease4Ptr getLease(uint32_t addr);
 
+    /// @brief returns existing lease by hardware address
+    ///
+    /// @param hwaddr hardware address of the searched lease
+    ///
+    /// @return smart pointer to the lease (or NULL if lease is not found)
+    Lease4Ptr getLeaseByHWAddr(const std::vector<uint8_t>& hwaddr);
+
+    /// @brief returns existing lease by client identifier
+    ///
+    /// @param client_id client identifier of the searched lease
+    ///
+    /// @return smart pointer to the lease (or NULL if lease is not found)
+    Lease4Ptr getLeaseByClientId(const std::vector<uint8_t>& client_id);
+
     /// @brief Simplified lease update.
     ///
     /// Searches for a lease and then updates its client last transmission
@@ -141,7 +187,7 @@ bool memfile_LeaseMgr::addLease(Lease4Ptr lease) {
         // there is such an address already in the hash
         return false;
     }
-    ip4Hash_.insert(pair<uint32_t, Lease4Ptr>(lease->addr, lease));
+    ip4Hash_.insert(lease);
     lease->hostname = "add";
     writeLease(lease);
     return (true);
@@ -150,7 +196,29 @@ bool memfile_LeaseMgr::addLease(Lease4Ptr lease) {
 Lease4Ptr memfile_LeaseMgr::getLease(uint32_t addr) {
     leaseIt x = ip4Hash_.find(addr);
     if (x != ip4Hash_.end()) {
-        return x->second; // found
+        return *x; // found
+    }
+
+    // not found
+    return Lease4Ptr();
+}
+
+Lease4Ptr memfile_LeaseMgr::getLeaseByHWAddr(const std::vector<uint8_t>& hwaddr) {
+    IPv4Hash::nth_index<1>::type& idx = ip4Hash_.get<1>();
+    IPv4Hash::nth_index<1>::type::iterator x = idx.find(hwaddr);
+    if (x != idx.end()) {
+        return *x; // found
+    }
+
+    // not found
+    return Lease4Ptr();
+}
+
+Lease4Ptr memfile_LeaseMgr::getLeaseByClientId(const std::vector<uint8_t>& client_id) {
+    IPv4Hash::nth_index<2>::type& idx = ip4Hash_.get<2>();
+    IPv4Hash::nth_index<2>::type::iterator x = idx.find(client_id);
+    if (x != idx.end()) {
+        return *x; // found
     }
 
     // not found
@@ -160,10 +228,11 @@ Lease4Ptr memfile_LeaseMgr::getLease(uint32_t addr) {
 Lease4Ptr memfile_LeaseMgr::updateLease(uint32_t addr, uint32_t new_cltt) {
     leaseIt x = ip4Hash_.find(addr);
     if (x != ip4Hash_.end()) {
-        x->second->cltt = new_cltt;
-        x->second->hostname = "update";
-        writeLease(x->second);
-        return x->second;
+        // None of the indexed fields is modified.
+        (*x)->cltt = new_cltt;
+        (*x)->hostname = "update";
+        writeLease(*x);
+        return *x;
     }
     return Lease4Ptr();
 }
@@ -171,14 +240,24 @@ Lease4Ptr memfile_LeaseMgr::updateLease(uint32_t addr, uint32_t new_cltt) {
 bool memfile_LeaseMgr::deleteLease(uint32_t addr) {
     leaseIt x = ip4Hash_.find(addr);
     if (x != ip4Hash_.end()) {
-        x->second->hostname = "delete";
-        writeLease(x->second);
+        (*x)->hostname = "delete";
+        writeLease(*x);
         ip4Hash_.erase(x);
         return true;
     }
     return false;
 }
 
+/// @brief Returns a copy of the identifier with the address in its last
+///        bytes, so every lease gets a different hwaddr and client-id.
+static vector<uint8_t> makeUnique(const vector<uint8_t>& id, uint32_t addr) {
+    vector<uint8_t> unique(id);
+    for (size_t i = 0; i < sizeof(addr) && i < unique.size(); ++i) {
+        unique[unique.size() - 1 - i] = (addr >> (8 * i)) & 0xff;
+    }
+    return (unique);
+}
+
 memfile_uBenchmark::memfile_uBenchmark(const string& filename,
                                        uint32_t num_iterations,
                                        bool sync,
@@ -234,14 +313,18 @@ void memfile_uBenchmark::createLease4Test() {
     }
     vector<uint8_t> client_id(client_id_tmp, client_id_tmp + client_id_len - 1);
 
+    // Kept for the search benchmark.
+    hwaddr_ = hwaddr;
+    client_id_ = client_id;
+
     for (uint32_t i = 0; i < num_; ++i) {
 
         cltt++;
 
         Lease4Ptr lease = boost::shared_ptr<Lease4>(new Lease4());
         lease->addr = addr;
-        lease->hwaddr = hwaddr;
-        lease->client_id = client_id;
+        lease->hwaddr = makeUnique(hwaddr, addr);
+        lease->client_id = makeUnique(client_id, addr);
         lease->valid_lft = valid_lft;
         lease->recycle_time = recycle_time;
         lease->cltt = cltt;
@@ -271,6 +354,8 @@ void memfile_uBenchmark::searchLease4Test() {
 
     cout << "RETRIEVE: ";
 
+    struct timespec ts[5];
+    ts[0] = getTime();
     for (uint32_t i = 0; i < num_; i++) {
         uint32_t x = BASE_ADDR4 + random() % int(num_ / hitratio_);
 
@@ -279,8 +364,38 @@ void memfile_uBenchmark::searchLease4Test() {
             cout << (lease?".":"X");
         }
     }
+    ts[1] = getTime();
+
+    // The same lookups by the hardware address and the client identifier,
+    // the keys are prepared beforehand so only the lookups are measured.
+    vector<vector<uint8_t> > hwaddrs;
+    vector<vector<uint8_t> > client_ids;
+    for (uint32_t i = 0; i < num_; i++) {
+        uint32_t x = BASE_ADDR4 + random() % int(num_ / hitratio_);
+        hwaddrs.push_back(makeUnique(hwaddr_, x));
+        client_ids.push_back(makeUnique(client_id_, x));
+    }
+
+    ts[2] = getTime();
+    for (uint32_t i = 0; i < num_; i++) {
+        Lease4Ptr lease = leaseMgr_->getLeaseByHWAddr(hwaddrs[i]);
+        if (verbose_) {
+            cout << (lease?".":"X");
+        }
+    }
+    ts[3] = getTime();
+    for (uint32_t i = 0; i < num_; i++) {
+        Lease4Ptr lease = leaseMgr_->getLeaseByClientId(client_ids[i]);
+        if (verbose_) {
+            cout << (lease?".":"X");
+        }
+    }
+    ts[4] = getTime();
 
     cout << endl;
+    printClock("Search leases4 by address", num_, ts[0], ts[1]);
+    printClock("Search leases4 by hwaddr", num_, ts[2], ts[3]);
+    printClock("Search leases4 by client-id", num_, ts[3], ts[4]);
 }
 
 void memfile_uBenchmark::updateLease4Test() {
@@ -335,7 +450,11 @@ void memfile_uBenchmark::deleteLease4Test() {
 }
 
 void memfile_uBenchmark::printInfo() {
-    cout << "Memory db (using std::map) + write-only file." << endl;
+#ifdef MEMFILE_ORDERED_INDEX
+    cout << "Memory db (using ordered indexes) + write-only file." << endl;
+#else
+    cout << "Memory db (using hashed indexes) + write-only file." << endl;
+#endif
 }
 
 
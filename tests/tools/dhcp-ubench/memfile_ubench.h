@@ -50,8 +50,8 @@ class memfile_LeaseMgr;
 /// That is a specific backend implementation. See \ref uBenchmark class for
 /// detailed explanation of its operations. This class uses custom in-memory
 /// pseudo-database and external write-only lease file. That approach simulates
-/// modernized model of ISC DHCP4. It uses standard STL maps together with
-/// shared_ptr from boost library. The "database" is implemented in the Lease
+/// modernized model of ISC DHCP4. It uses boost::multi_index_container with
+/// hashed indexes together with shared_ptr from boost library. The "database" is implemented in the Lease
 /// Manager (see \ref LeaseMgr in memfile_ubench.cc). All lease changes are
 /// appended to the end of the file, speeding up the process.
 class memfile_uBenchmark: public uBenchmark {
@@ -70,7 +70,7 @@ public:
     virtual void printInfo();
 
     /// @brief Spawns lease manager that create empty lease file, initializes
-    ///        empty STL maps.
+    ///        empty lease storage.
     virtual void connect();
 
     /// @brief Delete lease manager that closes lease file.
@@ -83,7 +83,9 @@ public:
 
     /// @brief Searches for existing leases.
     ///
-    /// See uBenchmark::searchLease4Test() for detailed explanation.
+    /// See uBenchmark::searchLease4Test() for detailed explanation.  The
+    /// leases are also searched by the hardware address and the client
+    /// identifier, the times of the three kinds of lookups are printed.
     virtual void searchLease4Test();
 
     /// @brief Updates existing leases.
@@ -98,6 +100,13 @@ public:
 
 protected:
 
-    /// Lease Manager (concrete backend implementation, based on STL maps)
+    /// Lease Manager (concrete backend implementation, based on
+    /// boost::multi_index_container)
     memfile_LeaseMgr * leaseMgr_;
+
+    /// Hardware address the ones of the leases are derived from
+    std::vector<uint8_t> hwaddr_;
+
+    /// Client identifier the ones of the leases are derived from
+    std::vector<uint8_t> client_id_;
 };
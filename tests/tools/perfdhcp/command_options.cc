@@ -115,6 +115,10 @@ CommandOptions::reset() {
     rate_ = 0;
     renew_rate_ = 0;
     release_rate_ = 0;
+    rebind_rate_ = 0;
+    decline_rate_ = 0;
+    reboot_rate_ = 0;
+    threads_num_ = 1;
     report_delay_ = 0;
     clients_num_ = 0;
     mac_template_.assign(mac, mac + 6);
@@ -212,7 +216,7 @@ CommandOptions::initialize(int argc, char** argv, bool print_cmd_line) {
     // In this section we collect argument values from command line
     // they will be tuned and validated elsewhere
     while((opt = getopt(argc, argv, "hv46r:t:R:b:n:p:d:D:l:P:a:L:"
-                        "s:iBc1T:X:O:E:S:I:x:w:e:f:F:")) != -1) {
+                        "s:iBc1T:X:O:E:S:I:x:w:e:f:F:g:j:k:K:")) != -1) {
         stream << " -" << static_cast<char>(opt);
         if (optarg) {
             stream << " " << optarg;
@@ -314,6 +318,11 @@ CommandOptions::initialize(int argc, char** argv, bool print_cmd_line) {
                                             " positive integer");
             break;
 
+        case 'g':
+            threads_num_ = positiveInteger("number of threads: -g<threads>"
+                                           " must be a positive integer");
+            break;
+
         case 'h':
             usage();
             return (true);
@@ -322,6 +331,24 @@ CommandOptions::initialize(int argc, char** argv, bool print_cmd_line) {
             exchange_mode_ = DO_SA;
             break;
 
+        case 'j':
+            rebind_rate_ = positiveInteger("value of the rebind rate:"
+                                           " -j<rebind-rate> must be a"
+                                           " positive integer");
+            break;
+
+        case 'k':
+            decline_rate_ = positiveInteger("value of the decline rate:"
+                                            " -k<decline-rate> must be a"
+                                            " positive integer");
+            break;
+
+        case 'K':
+            reboot_rate_ = positiveInteger("value of the reboot rate:"
+                                           " -K<reboot-rate> must be a"
+                                           " positive integer");
+            break;
+
         case 'I':
             rip_offset_ = positiveInteger("value of ip address offset:"
                                           " -I<value> must be a"
@@ -695,10 +722,6 @@ CommandOptions::validate() const {
           "-B is not compatible with IPv6 (-6)");
     check((getIpVersion() != 6) && (isRapidCommit() != 0),
           "-6 (IPv6) must be set to use -c");
-    check((getIpVersion() != 6) && (getRenewRate() !=0),
-          "-f<renew-rate> may be used with -6 (IPv6) only");
-    check((getIpVersion() != 6) && (getReleaseRate() != 0),
-          "-F<release-rate> may be used with -6 (IPv6) only");
     check((getExchangeMode() == DO_SA) && (getNumRequests().size() > 1),
           "second -n<num-request> is not compatible with -i");
     check((getIpVersion() == 4) && !getLeaseType().is(LeaseType::ADDRESS),
@@ -730,6 +753,12 @@ CommandOptions::validate() const {
           "-f<renew-rate> is not compatible with -i");
     check((getExchangeMode() == DO_SA) && (getReleaseRate() != 0),
           "-F<release-rate> is not compatible with -i");
+    check((getExchangeMode() == DO_SA) && (getRebindRate() != 0),
+          "-j<rebind-rate> is not compatible with -i");
+    check((getExchangeMode() == DO_SA) && (getDeclineRate() != 0),
+          "-k<decline-rate> is not compatible with -i");
+    check((getExchangeMode() == DO_SA) && (getRebootRate() != 0),
+          "-K<reboot-rate> is not compatible with -i");
     check((getExchangeMode() != DO_SA) && (isRapidCommit() != 0),
           "-i must be set to use -c");
     check((getRate() == 0) && (getReportDelay() != 0),
@@ -741,16 +770,44 @@ CommandOptions::validate() const {
     check((getRate() == 0) &&
           ((getMaxDrop().size() > 0) || getMaxDropPercentage().size() > 0),
           "-r<rate> must be set to use -D<max-drop>");
-    check((getRate() != 0) && (getRenewRate() + getReleaseRate() > getRate()),
-          "The sum of Renew rate (-f<renew-rate>) and Release rate"
-          " (-F<release-rate>) must not be greater than the exchange"
-          " rate specified as -r<rate>");
+    check((getRate() != 0) && (getLeaseMessagesRate() > getRate()),
+          "The sum of Renew rate (-f<renew-rate>), Release rate"
+          " (-F<release-rate>), Rebind rate (-j<rebind-rate>), Decline rate"
+          " (-k<decline-rate>) and reboot rate (-K<reboot-rate>) must not be"
+          " greater than the exchange rate specified as -r<rate>");
     check((getRate() == 0) && (getRenewRate() != 0),
           "Renew rate specified as -f<renew-rate> must not be specified"
           " when -r<rate> parameter is not specified");
     check((getRate() == 0) && (getReleaseRate() != 0),
           "Release rate specified as -F<release-rate> must not be specified"
           " when -r<rate> parameter is not specified");
+    check((getRate() == 0) && (getRebindRate() != 0),
+          "Rebind rate specified as -j<rebind-rate> must not be specified"
+          " when -r<rate> parameter is not specified");
+    check((getRate() == 0) && (getDeclineRate() != 0),
+          "Decline rate specified as -k<decline-rate> must not be specified"
+          " when -r<rate> parameter is not specified");
+    check((getRate() == 0) && (getRebootRate() != 0),
+          "Reboot rate specified as -K<reboot-rate> must not be specified"
+          " when -r<rate> parameter is not specified");
+    // Each thread simulates its own clients and sends its share of
+    // the messages of each type.
+    check((getThreadsNum() > 1) && (getClientsNum() < getThreadsNum()),
+          "-R<range> must not be lower than the number of threads"
+          " specified as -g<threads>");
+    check((getThreadsNum() > 1) && (getRate() != 0) &&
+          (getRate() < getThreadsNum()),
+          "-r<rate> must not be lower than the number of threads"
+          " specified as -g<threads>");
+    const int lease_rates[] = { getRenewRate(), getReleaseRate(),
+                                getRebindRate(), getDeclineRate(),
+                                getRebootRate() };
+    for (size_t i = 0; i < sizeof(lease_rates) / sizeof(lease_rates[0]); ++i) {
+        check((lease_rates[i] != 0) && (lease_rates[i] < getThreadsNum()),
+              "-f<renew-rate>, -F<release-rate>, -j<rebind-rate>,"
+              " -k<decline-rate> and -K<reboot-rate> must not be lower than"
+              " the number of threads specified as -g<threads>");
+    }
     check((getTemplateFiles().size() < getTransactionIdOffset().size()),
           "-T<template-file> must be set to use -X<xid-offset>");
     check((getTemplateFiles().size() < getRandomOffset().size()),
@@ -834,6 +891,18 @@ CommandOptions::printCommandLine() const {
     if (getReleaseRate() != 0) {
         std::cout << "release-rate[1/s]=" << getReleaseRate() << std::endl;
     }
+    if (getRebindRate() != 0) {
+        std::cout << "rebind-rate[1/s]=" << getRebindRate() << std::endl;
+    }
+    if (getDeclineRate() != 0) {
+        std::cout << "decline-rate[1/s]=" << getDeclineRate() << std::endl;
+    }
+    if (getRebootRate() != 0) {
+        std::cout << "reboot-rate[1/s]=" << getRebootRate() << std::endl;
+    }
+    if (getThreadsNum() > 1) {
+        std::cout << "threads=" << getThreadsNum() << std::endl;
+    }
     if (report_delay_ != 0) {
         std::cout << "report[s]=" << report_delay_ << std::endl;
     }
@@ -917,7 +986,9 @@ void
 CommandOptions::usage() const {
     std::cout <<
         "perfdhcp [-hv] [-4|-6] [-e<lease-type>] [-r<rate>] [-f<renew-rate>]\n"
-        "         [-F<release-rate>] [-t<report>] [-R<range>] [-b<base>]\n"
+        "         [-F<release-rate>] [-j<rebind-rate>] [-k<decline-rate>]\n"
+        "         [-K<reboot-rate>] [-g<threads>] [-t<report>] [-R<range>]\n"
+        "         [-b<base>]\n"
         "         [-n<num-request>] [-p<test-period>] [-d<drop-time>]\n"
         "         [-D<max-drop>] [-l<local-addr|interface>] [-P<preload>]\n"
         "         [-a<aggressivity>] [-L<local-port>] [-s<seed>] [-i] [-B]\n"
@@ -967,6 +1038,10 @@ CommandOptions::usage() const {
         "-E<time-offset>: Offset of the (DHCPv4) secs field / (DHCPv6)\n"
         "    elapsed-time option in the (second/request) template.\n"
         "    The value 0 disables it.\n"
+        "-g<threads>: Number of threads generating the traffic.  Each thread\n"
+        "    simulates its own share of the clients and sends its share of the\n"
+        "    messages at its share of the rates.  The default is 1, which\n"
+        "    sends all messages from the main thread.\n"
         "-h: Print this help.\n"
         "-i: Do only the initial part of an exchange: DO or SA, depending on\n"
         "    whether -6 is given.\n"
@@ -1003,6 +1078,7 @@ CommandOptions::usage() const {
         "    keyletters are:\n"
         "   * 'a': print the decoded command line arguments\n"
         "   * 'e': print the exit reason\n"
+        "   * 'h': when finished, print the histograms of the delays\n"
         "   * 'i': print rate processing details\n"
         "   * 's': print first server-id\n"
         "   * 't': when finished, print timers of all successful exchanges\n"
@@ -1014,19 +1090,21 @@ CommandOptions::usage() const {
         "\n"
         "DHCPv6 only options:\n"
         "-c: Add a rapid commit option (exchanges will be SA).\n"
-        "-f<renew-rate>: Rate at which IPv6 Renew requests are sent to\n"
-        "    a server. This value is only valid when used in conjunction with\n"
-        "    the exchange rate (given by -r<rate>).  Furthermore the sum of\n"
-        "    this value and the release-rate (given by -F<rate) must be equal\n"
-        "    to or less than the exchange rate.\n"
-        "-F<release-rate>: Rate at which IPv6 Release requests are sent to\n"
-        "    a server. This value is only valid when used in conjunction with\n"
-        "    the exchange rate (given by -r<rate>).  Furthermore the sum of\n"
-        "    this value and the renew-rate (given by -f<rate) must be equal\n"
-        "    to or less than the exchange rate.\n"
         "\n"
         "The remaining options are used only in conjunction with -r:\n"
         "\n"
+        "-f<renew-rate>: Rate at which Renew requests (DHCPREQUEST from the\n"
+        "    renewing clients for DHCPv4) are sent to a server.\n"
+        "-F<release-rate>: Rate at which Release requests are sent to a server.\n"
+        "-j<rebind-rate>: Rate at which Rebind requests (DHCPREQUEST from the\n"
+        "    rebinding clients for DHCPv4) are sent to a server.\n"
+        "-k<decline-rate>: Rate at which Decline requests are sent to a server.\n"
+        "-K<reboot-rate>: Rate at which the clients verify their lease after a\n"
+        "    reboot: DHCPREQUEST from the INIT-REBOOT state for DHCPv4, Confirm\n"
+        "    for DHCPv6.\n"
+        "    These messages are sent on behalf of the clients which have\n"
+        "    acquired a lease.  The sum of the rates given by -f, -F, -j, -k and\n"
+        "    -K must be equal to or less than the exchange rate.\n"
         "-D<max-drop>: Abort the test if more than <max-drop> requests have\n"
         "    been dropped.  Use -D0 to abort if even a single request has been\n"
         "    dropped.  If <max-drop> includes the suffix '%', it specifies a\n"
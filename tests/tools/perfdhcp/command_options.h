@@ -155,16 +155,49 @@ public:
     /// \return exchange rate per second.
     int getRate() const { return rate_; }
 
-    /// \brief Returns a rate at which DHCPv6 Renew messages are sent.
+    /// \brief Returns a rate at which Renew messages are sent.
     ///
-    /// \return A rate at which IPv6 Renew messages are sent.
+    /// \return A rate at which DHCPv6 Renew or renewing DHCPv4 Request
+    /// messages are sent.
     int getRenewRate() const { return (renew_rate_); }
 
-    /// \brief Returns a rate at which DHCPv6 Release messages are sent.
+    /// \brief Returns a rate at which Release messages are sent.
     ///
-    /// \return A rate at which DHCPv6 Release messages are sent.
+    /// \return A rate at which DHCPv4 or DHCPv6 Release messages are sent.
     int getReleaseRate() const { return (release_rate_); }
 
+    /// \brief Returns a rate at which Rebind messages are sent.
+    ///
+    /// \return A rate at which DHCPv6 Rebind or rebinding DHCPv4 Request
+    /// messages are sent.
+    int getRebindRate() const { return (rebind_rate_); }
+
+    /// \brief Returns a rate at which Decline messages are sent.
+    ///
+    /// \return A rate at which DHCPv4 or DHCPv6 Decline messages are sent.
+    int getDeclineRate() const { return (decline_rate_); }
+
+    /// \brief Returns a rate at which rebooting clients send messages.
+    ///
+    /// \return A rate at which DHCPv6 Confirm or INIT-REBOOT DHCPv4 Request
+    /// messages are sent.
+    int getRebootRate() const { return (reboot_rate_); }
+
+    /// \brief Returns the sum of the rates of the messages sent for the
+    /// leases acquired.
+    ///
+    /// \return The sum of the Renew, Rebind, Release, Decline and reboot
+    /// rates.
+    int getLeaseMessagesRate() const {
+        return (renew_rate_ + rebind_rate_ + release_rate_ + decline_rate_ +
+                reboot_rate_);
+    }
+
+    /// \brief Returns the number of generator threads.
+    ///
+    /// \return number of threads sending the messages.
+    int getThreadsNum() const { return (threads_num_); }
+
     /// \brief Returns delay between two performance reports.
     ///
     /// \return delay between two consecutive performance reports.
@@ -471,10 +504,18 @@ private:
     LeaseType lease_type_;
     /// Rate in exchange per second
     int rate_;
-    /// A rate at which DHCPv6 Renew messages are sent.
+    /// A rate at which Renew messages are sent.
     int renew_rate_;
-    /// A rate at which DHCPv6 Release messages are sent.
+    /// A rate at which Release messages are sent.
     int release_rate_;
+    /// A rate at which Rebind messages are sent.
+    int rebind_rate_;
+    /// A rate at which Decline messages are sent.
+    int decline_rate_;
+    /// A rate at which rebooting clients send messages.
+    int reboot_rate_;
+    /// Number of generator threads.
+    int threads_num_;
     /// Delay between generation of two consecutive
     /// performance reports
     int report_delay_;
@@ -18,6 +18,7 @@
 #include <dhcp/pkt4.h>
 #include <dhcp/pkt6.h>
 #include <exceptions/exceptions.h>
+#include <util/threads/sync.h>
 
 #include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
@@ -30,6 +31,7 @@
 
 #include <iostream>
 #include <map>
+#include <vector>
 
 
 namespace bundy {
@@ -125,7 +127,13 @@ public:
         XCHG_SA,  ///< DHCPv6 SOLICIT-ADVERTISE
         XCHG_RR,  ///< DHCPv6 REQUEST-REPLY
         XCHG_RN,  ///< DHCPv6 RENEW-REPLY
-        XCHG_RL   ///< DHCPv6 RELEASE-REPLY
+        XCHG_RL,  ///< DHCPv6 RELEASE-REPLY
+        XCHG_RNA, ///< DHCPv4 REQUEST-ACK from a renewing client
+        XCHG_RBA, ///< DHCPv4 REQUEST-ACK from a rebinding client
+        XCHG_IRA, ///< DHCPv4 REQUEST-ACK from a rebooting client
+        XCHG_RB,  ///< DHCPv6 REBIND-REPLY
+        XCHG_DC,  ///< DHCPv6 DECLINE-REPLY
+        XCHG_CN   ///< DHCPv6 CONFIRM-REPLY
     };
 
     /// \brief Exchange Statistics.
@@ -138,6 +146,47 @@ public:
     class ExchangeStats {
     public:
 
+        /// \brief Number of buckets of the delay histogram.
+        ///
+        /// Delays below 8 microseconds have one bucket per microsecond.
+        /// Above, each power of two of microseconds is split in 8 buckets,
+        /// so as the width of a bucket is at most 1/8 of its lower bound.
+        /// The last bucket also holds the delays above 4.5 hours.
+        static const size_t HISTOGRAM_BUCKETS = 256;
+
+        /// \brief Return the histogram bucket of a delay.
+        ///
+        /// \param usec delay in microseconds.
+        /// \return index of the bucket holding the delay.
+        static size_t delayToBucket(uint64_t usec) {
+            if (usec < 8) {
+                return (static_cast<size_t>(usec));
+            }
+            size_t exp = 0;
+            while (usec >= 16) {
+                usec >>= 1;
+                ++exp;
+            }
+            const size_t bucket = 8 + exp * 8 + static_cast<size_t>(usec - 8);
+            return (bucket < HISTOGRAM_BUCKETS ? bucket :
+                    HISTOGRAM_BUCKETS - 1);
+        }
+
+        /// \brief Return the lowest delay held by a histogram bucket.
+        ///
+        /// The delays held by the bucket are lower than the lowest delay
+        /// of the next bucket.
+        ///
+        /// \param bucket index of the bucket.
+        /// \return lowest delay of the bucket in microseconds.
+        static uint64_t bucketToDelay(const size_t bucket) {
+            if (bucket < 8) {
+                return (bucket);
+            }
+            return (static_cast<uint64_t>(8 + (bucket - 8) % 8) <<
+                    ((bucket - 8) / 8));
+        }
+
         /// \brief Hash transaction id of the packet.
         ///
         /// Function hashes transaction id of the packet. Hashing is
@@ -280,6 +329,7 @@ public:
               max_delay_(0.),
               sum_delay_(0.),
               sum_delay_squared_(0.),
+              delay_histogram_(HISTOGRAM_BUCKETS, 0),
               orphans_(0),
               collected_(0),
               unordered_lookup_size_sum_(0),
@@ -370,6 +420,10 @@ public:
             // mean delays.
             sum_delay_ += delta;
             sum_delay_squared_ += delta * delta;
+            // Count the delay in the histogram the percentiles are
+            // computed from.
+            ++delay_histogram_[delayToBucket(period.length().
+                                             total_microseconds())];
         }
 
         /// \brief Match received packet with the corresponding sent packet.
@@ -543,6 +597,44 @@ public:
                         getAvgDelay() * getAvgDelay()));
         }
 
+        /// \brief Return a percentile of the packet delays.
+        ///
+        /// The percentile is computed from the delay histogram: the value
+        /// returned is the upper bound of the bucket holding the given
+        /// percentile of the delays, which exceeds the exact value by 1/8
+        /// at most.  It is kept within the minimum and maximum delays.
+        ///
+        /// \param percentile percentile of the delays, e.g. 99 or 99.9.
+        ///
+        /// \throw bundy::InvalidOperation if no packets for this exchange
+        /// have been received yet.
+        /// \throw bundy::BadValue if the percentile is not within (0, 100].
+        /// \return the delay below which the percentile of the delays is.
+        double getDelayPercentile(const double percentile) const {
+            if ((percentile <= 0.) || (percentile > 100.)) {
+                bundy_throw(BadValue, "percentile " << percentile
+                            << " is not within (0, 100]");
+            }
+            uint64_t total = 0;
+            for (size_t i = 0; i < delay_histogram_.size(); ++i) {
+                total += delay_histogram_[i];
+            }
+            if (total == 0) {
+                bundy_throw(InvalidOperation, "no packets received");
+            }
+            const double rank = total * percentile / 100.;
+            uint64_t count = 0;
+            size_t bucket = 0;
+            for (; bucket < delay_histogram_.size() - 1; ++bucket) {
+                count += delay_histogram_[bucket];
+                if (count >= rank) {
+                    break;
+                }
+            }
+            const double delay = bucketToDelay(bucket + 1) / 1e6;
+            return (std::max(getMinDelay(), std::min(delay, getMaxDelay())));
+        }
+
         /// \brief Return number of orphant packets.
         ///
         /// Method returns number of received packets that had no matching
@@ -664,12 +756,42 @@ public:
                      << "max delay: " << getMaxDelay() * 1e3 << " ms" << endl
                      << "std deviation: " << getStdDevDelay() * 1e3 << " ms"
                      << endl
+                     << "50th percentile delay: "
+                     << getDelayPercentile(50.) * 1e3 << " ms" << endl
+                     << "90th percentile delay: "
+                     << getDelayPercentile(90.) * 1e3 << " ms" << endl
+                     << "99th percentile delay: "
+                     << getDelayPercentile(99.) * 1e3 << " ms" << endl
+                     << "99.9th percentile delay: "
+                     << getDelayPercentile(99.9) * 1e3 << " ms" << endl
                      << "collected packets: " << getCollectedNum() << endl;
             } catch (const Exception& e) {
                 cout << "Delay summary unavailable! No packets received." << endl;
             }
         }
 
+        /// \brief Print the delay histogram.
+        ///
+        /// Method prints the range of delays and the number of packets of
+        /// each non-empty bucket of the delay histogram.
+        void printDelayHistogram() const {
+            using namespace std;
+            bool empty = true;
+            for (size_t i = 0; i < delay_histogram_.size(); ++i) {
+                if (delay_histogram_[i] == 0) {
+                    continue;
+                }
+                empty = false;
+                cout << fixed << setprecision(3)
+                     << bucketToDelay(i) / 1e3 << " - "
+                     << bucketToDelay(i + 1) / 1e3 << " ms: "
+                     << delay_histogram_[i] << endl;
+            }
+            if (empty) {
+                cout << "Unavailable! No packets received." << endl;
+            }
+        }
+
         //// \brief Print timestamps for sent and received packets.
         ///
         /// Method prints timestamps for all sent and received packets for
@@ -806,6 +928,10 @@ public:
         double sum_delay_squared_;     ///< Squared sum of delays between
                                        ///< sent and recived packets.
 
+        /// Number of delays between sent and received packets in each
+        /// bucket, see \ref delayToBucket.
+        std::vector<uint64_t> delay_histogram_;
+
         uint64_t orphans_;   ///< Number of orphant received packets.
 
         uint64_t collected_; ///< Number of garbage collected packets.
@@ -854,7 +980,8 @@ public:
     StatsMgr(const bool archive_enabled = false) :
         exchanges_(),
         archive_enabled_(archive_enabled),
-        boot_time_(boost::posix_time::microsec_clock::universal_time()) {
+        boot_time_(boost::posix_time::microsec_clock::universal_time()),
+        mutex_() {
     }
 
     /// \brief Specify new exchange type.
@@ -869,6 +996,7 @@ public:
     /// \throw bundy::BadValue if exchange of specified type exists.
     void addExchangeStats(const ExchangeType xchg_type,
                           const double drop_time = -1) {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
         if (exchanges_.find(xchg_type) != exchanges_.end()) {
             bundy_throw(BadValue, "Exchange of specified type already added.");
         }
@@ -890,6 +1018,7 @@ public:
     /// \return true if the \ref ExchangeStats object has been added for a
     /// specified exchange type.
     bool hasExchangeStats(const ExchangeType xchg_type) const {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
         return (exchanges_.find(xchg_type) != exchanges_.end());
     }
 
@@ -902,6 +1031,7 @@ public:
     /// \param long_name name of the counter presented in the log file.
     void addCustomCounter(const std::string& short_name,
                           const std::string& long_name) {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
         if (custom_counters_.find(short_name) != custom_counters_.end()) {
             bundy_throw(BadValue,
                       "Custom counter " << short_name << " already added.");
@@ -914,6 +1044,7 @@ public:
     ///
     // \return true, if packet drops occured.
     bool droppedPackets() const {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
         for (ExchangesMapIterator it = exchanges_.begin();
              it != exchanges_.end();
              ++it) {
@@ -932,12 +1063,8 @@ public:
     /// The short counter name has to be used to access counter.
     /// \return pointer to specified counter object.
     CustomCounterPtr getCounter(const std::string& counter_key) {
-        CustomCountersMapIterator it = custom_counters_.find(counter_key);
-        if (it == custom_counters_.end()) {
-            bundy_throw(BadValue,
-                      "Custom counter " << counter_key << "does not exist");
-        }
-        return(it->second);
+        bundy::util::thread::Mutex::Locker lock(mutex_);
+        return (findCounter(counter_key));
     }
 
     /// \brief Increment specified counter.
@@ -949,7 +1076,8 @@ public:
     /// \return pointer to specified counter after incrementation.
     const CustomCounter& incrementCounter(const std::string& counter_key,
                                           const uint64_t value = 1) {
-        CustomCounterPtr counter = getCounter(counter_key);
+        bundy::util::thread::Mutex::Locker lock(mutex_);
+        CustomCounterPtr counter = findCounter(counter_key);
         *counter += value;
         return (*counter);
     }
@@ -966,6 +1094,7 @@ public:
     /// packet is null.
     void passSentPacket(const ExchangeType xchg_type,
                         const boost::shared_ptr<T>& packet) {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
         ExchangeStatsPtr xchg_stats = getExchangeStats(xchg_type);
         xchg_stats->appendSent(packet);
     }
@@ -986,6 +1115,7 @@ public:
     boost::shared_ptr<T>
     passRcvdPacket(const ExchangeType xchg_type,
                    const boost::shared_ptr<T>& packet) {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
         ExchangeStatsPtr xchg_stats = getExchangeStats(xchg_type);
         boost::shared_ptr<T> sent_packet
             = xchg_stats->matchPackets(packet);
@@ -1008,6 +1138,7 @@ public:
     /// \throw bundy::BadValue if invalid exchange type specified.
     /// \return minimum delay between packets.
     double getMinDelay(const ExchangeType xchg_type) const {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
         ExchangeStatsPtr xchg_stats = getExchangeStats(xchg_type);
         return(xchg_stats->getMinDelay());
     }
@@ -1021,6 +1152,7 @@ public:
     /// \throw bundy::BadValue if invalid exchange type specified.
     /// \return maximum delay between packets.
     double getMaxDelay(const ExchangeType xchg_type) const {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
         ExchangeStatsPtr xchg_stats = getExchangeStats(xchg_type);
         return(xchg_stats->getMaxDelay());
     }
@@ -1032,6 +1164,7 @@ public:
     ///
     /// \return average packet delay.
     double getAvgDelay(const ExchangeType xchg_type) const {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
         ExchangeStatsPtr xchg_stats = getExchangeStats(xchg_type);
         return(xchg_stats->getAvgDelay());
     }
@@ -1043,10 +1176,28 @@ public:
     ///
     /// \return standard deviation of packet delay.
     double getStdDevDelay(const ExchangeType xchg_type) const {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
         ExchangeStatsPtr xchg_stats = getExchangeStats(xchg_type);
         return(xchg_stats->getStdDevDelay());
     }
 
+    /// \brief Return a percentile of the packet delays.
+    ///
+    /// Method returns a percentile of the packet delays for specified
+    /// exchange type, see \ref ExchangeStats::getDelayPercentile.
+    ///
+    /// \param xchg_type exchange type.
+    /// \param percentile percentile of the delays, e.g. 99 or 99.9.
+    /// \throw bundy::BadValue if invalid exchange type or percentile
+    /// specified.
+    /// \return the delay below which the percentile of the delays is.
+    double getDelayPercentile(const ExchangeType xchg_type,
+                              const double percentile) const {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
+        ExchangeStatsPtr xchg_stats = getExchangeStats(xchg_type);
+        return(xchg_stats->getDelayPercentile(percentile));
+    }
+
     /// \brief Return number of orphant packets.
     ///
     /// Method returns number of orphant packets for specified
@@ -1056,6 +1207,7 @@ public:
     /// \throw bundy::BadValue if invalid exchange type specified.
     /// \return number of orphant packets so far.
     uint64_t getOrphans(const ExchangeType xchg_type) const {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
         ExchangeStatsPtr xchg_stats = getExchangeStats(xchg_type);
         return(xchg_stats->getOrphans());
     }
@@ -1070,6 +1222,7 @@ public:
     /// \throw bundy::BadValue if invalid exchange type specified.
     /// \return average unordered lookup set size.
     double getAvgUnorderedLookupSetSize(const ExchangeType xchg_type) const {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
         ExchangeStatsPtr xchg_stats = getExchangeStats(xchg_type);
         return(xchg_stats->getAvgUnorderedLookupSetSize());
     }
@@ -1085,6 +1238,7 @@ public:
     /// \throw bundy::BadValue if invalid exchange type specified.
     /// \return number of unordered lookups.
     uint64_t getUnorderedLookups(const ExchangeType xchg_type) const {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
         ExchangeStatsPtr xchg_stats = getExchangeStats(xchg_type);
         return(xchg_stats->getUnorderedLookups());
     }
@@ -1101,6 +1255,7 @@ public:
     /// \throw bundy::BadValue if invalid exchange type specified.
     /// \return number of ordered lookups.
     uint64_t getOrderedLookups(const ExchangeType xchg_type) const {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
         ExchangeStatsPtr xchg_stats = getExchangeStats(xchg_type);
         return(xchg_stats->getOrderedLookups());
     }
@@ -1114,6 +1269,7 @@ public:
     /// \throw bundy::BadValue if invalid exchange type specified.
     /// \return number of sent packets.
     uint64_t getSentPacketsNum(const ExchangeType xchg_type) const {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
         ExchangeStatsPtr xchg_stats = getExchangeStats(xchg_type);
         return(xchg_stats->getSentPacketsNum());
     }
@@ -1127,6 +1283,7 @@ public:
     /// \throw bundy::BadValue if invalid exchange type specified.
     /// \return number of received packets.
     uint64_t getRcvdPacketsNum(const ExchangeType xchg_type) const {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
         ExchangeStatsPtr xchg_stats = getExchangeStats(xchg_type);
         return(xchg_stats->getRcvdPacketsNum());
     }
@@ -1140,6 +1297,7 @@ public:
     /// \throw bundy::BadValue if invalid exchange type specified.
     /// \return number of dropped packets.
     uint64_t getDroppedPacketsNum(const ExchangeType xchg_type) const {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
         ExchangeStatsPtr xchg_stats = getExchangeStats(xchg_type);
         return(xchg_stats->getDroppedPacketsNum());
     }
@@ -1155,6 +1313,7 @@ public:
     /// \throw bundy::BadValue if invalid exchange type specified.
     /// \return number of garbage collected packets.
     uint64_t getCollectedNum(const ExchangeType xchg_type) const {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
         ExchangeStatsPtr xchg_stats = getExchangeStats(xchg_type);
         return(xchg_stats->getCollectedNum());
     }
@@ -1195,6 +1354,18 @@ public:
             return("RENEW-REPLY");
         case XCHG_RL:
             return("RELEASE-REPLY");
+        case XCHG_RNA:
+            return("RENEW-ACK");
+        case XCHG_RBA:
+            return("REBIND-ACK");
+        case XCHG_IRA:
+            return("INIT-REBOOT-ACK");
+        case XCHG_RB:
+            return("REBIND-REPLY");
+        case XCHG_DC:
+            return("DECLINE-REPLY");
+        case XCHG_CN:
+            return("CONFIRM-REPLY");
         default:
             return("Unknown exchange type");
         }
@@ -1214,6 +1385,7 @@ public:
     /// \throw bundy::InvalidOperation if no exchange type added to
     /// track statistics.
      void printStats() const {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
         if (exchanges_.empty()) {
             bundy_throw(bundy::InvalidOperation,
                       "no exchange type added for tracking");
@@ -1237,6 +1409,7 @@ public:
     /// Statistics includes sent, received and dropped packets
     /// counters.
     void printIntermediateStats() const {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
         std::ostringstream stream_sent;
         std::ostringstream stream_rcvd;
         std::ostringstream stream_drops;
@@ -1269,6 +1442,7 @@ public:
     /// \throw bundy::InvalidOperation if no exchange type added to
     /// track statistics or packets archive mode is disabled.
     void printTimestamps() const {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
         if (exchanges_.empty()) {
             bundy_throw(bundy::InvalidOperation,
                       "no exchange type added for tracking");
@@ -1285,6 +1459,29 @@ public:
         }
     }
 
+    /// \brief Print the delay histograms.
+    ///
+    /// Method prints the delay histograms of all exchange types.
+    ///
+    /// \throw bundy::InvalidOperation if no exchange type added to
+    /// track statistics.
+    void printDelayHistograms() const {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
+        if (exchanges_.empty()) {
+            bundy_throw(bundy::InvalidOperation,
+                      "no exchange type added for tracking");
+        }
+        for (ExchangesMapIterator it = exchanges_.begin();
+             it != exchanges_.end();
+             ++it) {
+            std::cout << "***Delay histogram for: "
+                      << exchangeToString(it->first)
+                      << "***" << std::endl;
+            it->second->printDelayHistogram();
+            std::cout << std::endl;
+        }
+    }
+
     /// \brief Print names and values of custom counters.
     ///
     /// Method prints names and values of custom counters. Custom counters
@@ -1292,6 +1489,7 @@ public:
     ///
     /// \throw bundy::InvalidOperation if no custom counters added for tracking.
     void printCustomCounters() const {
+        bundy::util::thread::Mutex::Locker lock(mutex_);
         if (custom_counters_.empty()) {
             bundy_throw(bundy::InvalidOperation, "no custom counters specified");
         }
@@ -1322,6 +1520,22 @@ private:
         return(xchg_stats);
     }
 
+    /// \brief Return specified counter.
+    ///
+    /// The caller must hold the lock of the statistics.
+    ///
+    /// \param counter_key key poiting to the counter in the counters map.
+    /// \throw bundy::BadValue if the counter does not exist.
+    /// \return pointer to specified counter object.
+    CustomCounterPtr findCounter(const std::string& counter_key) const {
+        CustomCountersMapIterator it = custom_counters_.find(counter_key);
+        if (it == custom_counters_.end()) {
+            bundy_throw(BadValue,
+                      "Custom counter " << counter_key << "does not exist");
+        }
+        return(it->second);
+    }
+
     ExchangesMap exchanges_;            ///< Map of exchange types.
     CustomCountersMap custom_counters_; ///< Map with custom counters.
 
@@ -1336,6 +1550,10 @@ private:
     bool archive_enabled_;
 
     boost::posix_time::ptime boot_time_; ///< Time when test is started.
+
+    /// Serializes the accesses to the statistics by the generator
+    /// threads, see \ref TestControl.
+    mutable bundy::util::thread::Mutex mutex_;
 };
 
 } // namespace perfdhcp
@@ -19,12 +19,14 @@
 #include <dhcp/iface_mgr.h>
 #include <dhcp/dhcp4.h>
 #include <dhcp/option6_ia.h>
+#include <util/threads/thread.h>
 #include <util/unittests/check_valgrind.h>
 #include "test_control.h"
 #include "command_options.h"
 #include "perf_pkt4.h"
 #include "perf_pkt6.h"
 
+#include <cstring>
 #include <fstream>
 #include <stdio.h>
 #include <stdlib.h>
@@ -32,7 +34,10 @@
 #include <unistd.h>
 #include <signal.h>
 #include <sys/wait.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
 
+#include <boost/bind.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
 using namespace std;
@@ -44,6 +49,41 @@ using namespace bundy::asiolink;
 namespace bundy {
 namespace perfdhcp {
 
+namespace {
+
+/// Messages sent for the leases, in the order in which they are sent.
+const TestControl::LeaseMessage lease_messages[] = {
+    TestControl::LEASE_RENEW,
+    TestControl::LEASE_REBIND,
+    TestControl::LEASE_REBOOT,
+    TestControl::LEASE_RELEASE,
+    TestControl::LEASE_DECLINE
+};
+
+/// Number of the messages sent for the leases.
+const size_t lease_messages_num =
+    sizeof(lease_messages) / sizeof(lease_messages[0]);
+
+/// \brief Returns the type of the DHCPv6 message sent for a lease.
+uint16_t
+leaseMessageToType6(const TestControl::LeaseMessage msg) {
+    switch (msg) {
+    case TestControl::LEASE_RENEW:
+        return (DHCPV6_RENEW);
+    case TestControl::LEASE_REBIND:
+        return (DHCPV6_REBIND);
+    case TestControl::LEASE_REBOOT:
+        return (DHCPV6_CONFIRM);
+    case TestControl::LEASE_RELEASE:
+        return (DHCPV6_RELEASE);
+    default:
+        ;
+    }
+    return (DHCPV6_DECLINE);
+}
+
+}
+
 bool TestControl::interrupted_ = false;
 
 TestControl::TestControlSocket::TestControlSocket(const int socket) :
@@ -93,10 +133,44 @@ TestControl::instance() {
     return (test_control);
 }
 
-TestControl::TestControl() {
+TestControl::TestControl()
+    : generator_(false), thread_index_(0), send_socket_(-1),
+      stopping_(false) {
     reset();
 }
 
+TestControl::TestControl(const int thread_index)
+    : generator_(true), thread_index_(thread_index), send_socket_(-1),
+      stopping_(false) {
+    CommandOptions& options = CommandOptions::instance();
+    const int threads_num = options.getThreadsNum();
+    setRateControls(threads_num, thread_index);
+    last_report_ = microsec_clock::universal_time();
+    last_clean_ = last_report_;
+
+    // The main thread routes the server's responses to the generators by
+    // their transaction ids: each generator uses those equal to its index
+    // modulo the number of generators, above the ones used by the preload.
+    const uint32_t transid_start =
+        (options.getPreload() / threads_num + 1) * threads_num + thread_index;
+    setTransidGenerator(NumberGeneratorPtr(
+        new SequentialGenerator(options.getIpVersion() == 4 ?
+                                0xFFFFFFFF : 0x00FFFFFF,
+                                transid_start, threads_num)));
+    // Each generator simulates its own share of the clients.
+    const uint32_t clients_num = options.getClientsNum() == 0 ?
+        1 : options.getClientsNum();
+    setMacAddrGenerator(NumberGeneratorPtr(
+        new SequentialGenerator(clients_num, thread_index % clients_num,
+                                threads_num)));
+}
+
+TestControl::~TestControl() {
+    if (send_socket_ >= 0) {
+        close(send_socket_);
+    }
+}
+
 void
 TestControl::checkLateMessages(RateControl& rate_control) {
     // If diagnostics is disabled, there is no need to log late sent messages.
@@ -114,33 +188,32 @@ TestControl::checkLateMessages(RateControl& rate_control) {
 
 void
 TestControl::cleanCachedPackets() {
-    CommandOptions& options = CommandOptions::instance();
-    // When Renews are not sent, Reply packets are not cached so there
-    // is nothing to do.
-    if (options.getRenewRate() == 0) {
+    // When no messages are sent for the leases, ACK and Reply packets are
+    // not cached so there is nothing to do.
+    const uint64_t lease_rate = getLeaseMessagesRate();
+    if (lease_rate == 0) {
         return;
     }
 
-    static boost::posix_time::ptime last_clean =
-        microsec_clock::universal_time();
-
     // Check how much time has passed since last cleanup.
-    time_period time_since_clean(last_clean,
+    time_period time_since_clean(last_clean_,
                                  microsec_clock::universal_time());
     // Cleanup every 1 second.
     if (time_since_clean.length().total_seconds() >= 1) {
         // Calculate how many cached packets to remove. Actually we could
-        // just leave enough packets to handle Renews for 1 second but
+        // just leave enough packets to handle the messages for 1 second but
         // since we want to randomize leases to be renewed so leave 5
         // times more packets to randomize from.
         // @todo The cache size might be controlled from the command line.
-        if (reply_storage_.size() > 5 * options.getRenewRate()) {
-            reply_storage_.clear(reply_storage_.size() -
-                                 5 * options.getRenewRate());
+        if (reply_storage_.size() > 5 * lease_rate) {
+            reply_storage_.clear(reply_storage_.size() - 5 * lease_rate);
+        }
+        if (ack_storage_.size() > 5 * lease_rate) {
+            ack_storage_.clear(ack_storage_.size() - 5 * lease_rate);
         }
         // Remember when we performed a cleanup for the last time.
         // We want to do the next cleanup not earlier than in one second.
-        last_clean = microsec_clock::universal_time();
+        last_clean_ = microsec_clock::universal_time();
     }
 }
 
@@ -205,7 +278,7 @@ TestControl::checkExitConditions() const {
         }
     }
     if (test_period_reached) {
-        if (testDiags('e')) {
+        if (testDiags('e') && !generator_) {
             std::cout << "reached test-period." << std::endl;
         }
         return (true);
@@ -241,7 +314,7 @@ TestControl::checkExitConditions() const {
         }
     }
     if (max_requests) {
-        if (testDiags('e')) {
+        if (testDiags('e') && !generator_) {
             std::cout << "Reached max requests limit." << std::endl;
         }
         return (true);
@@ -277,7 +350,7 @@ TestControl::checkExitConditions() const {
         }
     }
     if (max_drops) {
-        if (testDiags('e')) {
+        if (testDiags('e') && !generator_) {
             std::cout << "Reached maximum drops number." << std::endl;
         }
         return (true);
@@ -322,7 +395,7 @@ TestControl::checkExitConditions() const {
         }
     }
     if (max_pdrops) {
-        if (testDiags('e')) {
+        if (testDiags('e') && !generator_) {
             std::cout << "Reached maximum percentage of drops." << std::endl;
         }
         return (true);
@@ -330,18 +403,88 @@ TestControl::checkExitConditions() const {
     return (false);
 }
 
+Pkt4Ptr
+TestControl::createMessageFromAck(const LeaseMessage msg,
+                                  const dhcp::Pkt4Ptr& ack) {
+    uint8_t msg_type = DHCPREQUEST;
+    const char* msg_type_str = "DHCPREQUEST";
+    if (msg == LEASE_RELEASE) {
+        msg_type = DHCPRELEASE;
+        msg_type_str = "DHCPRELEASE";
+    } else if (msg == LEASE_DECLINE) {
+        msg_type = DHCPDECLINE;
+        msg_type_str = "DHCPDECLINE";
+    }
+    // ACK message must be specified.
+    if (!ack) {
+        bundy_throw(bundy::BadValue, "Unable to create " << msg_type_str
+                  << " message from the ACK message because the instance of"
+                  " the ACK message is NULL");
+    }
+    const IOAddress yiaddr = ack->getYiaddr();
+    if (!yiaddr.isV4() || (static_cast<uint32_t>(yiaddr) == 0)) {
+        bundy_throw(bundy::Unexpected, "failed to create " << msg_type_str
+                  << " message because the ACK message carries no address");
+    }
+
+    Pkt4Ptr pkt4(new Pkt4(msg_type, generateTransid()));
+    pkt4->setHWAddr(ack->getHWAddr());
+    // A client renewing or rebinding its lease, or releasing it, puts the
+    // leased address in ciaddr.  A client verifying its lease after a
+    // reboot, or declining it, requests the leased address.
+    if ((msg == LEASE_RENEW) || (msg == LEASE_REBIND) ||
+        (msg == LEASE_RELEASE)) {
+        pkt4->setCiaddr(yiaddr);
+    } else {
+        OptionPtr opt_requested_address =
+            OptionPtr(new Option(Option::V4, DHO_DHCP_REQUESTED_ADDRESS,
+                                 OptionBuffer()));
+        opt_requested_address->setUint32(static_cast<uint32_t>(yiaddr));
+        pkt4->addOption(opt_requested_address);
+    }
+    if ((msg == LEASE_RELEASE) || (msg == LEASE_DECLINE)) {
+        OptionPtr opt_serverid = ack->getOption(DHO_DHCP_SERVER_IDENTIFIER);
+        if (!opt_serverid) {
+            bundy_throw(bundy::Unexpected, "failed to create " << msg_type_str
+                      << " message because server id option has not been"
+                      " found in the ACK message");
+        }
+        pkt4->addOption(opt_serverid);
+    } else {
+        pkt4->addOption(Option::factory(Option::V4,
+                                        DHO_DHCP_PARAMETER_REQUEST_LIST));
+    }
+    return (pkt4);
+}
+
 Pkt6Ptr
 TestControl::createMessageFromReply(const uint16_t msg_type,
                                     const dhcp::Pkt6Ptr& reply) {
-    // Restrict messages to Release and Renew.
-    if (msg_type != DHCPV6_RENEW && msg_type != DHCPV6_RELEASE) {
-        bundy_throw(bundy::BadValue, "invalid message type " << msg_type
-                  << " to be created from Reply, expected DHCPV6_RENEW or"
-                  " DHCPV6_RELEASE");
-    }
     // Get the string representation of the message - to be used for error
     // logging purposes.
-    const char* msg_type_str = (msg_type == DHCPV6_RENEW ? "Renew" : "Release");
+    const char* msg_type_str = NULL;
+    switch (msg_type) {
+    case DHCPV6_RENEW:
+        msg_type_str = "Renew";
+        break;
+    case DHCPV6_REBIND:
+        msg_type_str = "Rebind";
+        break;
+    case DHCPV6_RELEASE:
+        msg_type_str = "Release";
+        break;
+    case DHCPV6_DECLINE:
+        msg_type_str = "Decline";
+        break;
+    case DHCPV6_CONFIRM:
+        msg_type_str = "Confirm";
+        break;
+    default:
+        bundy_throw(bundy::BadValue, "invalid message type " << msg_type
+                  << " to be created from Reply, expected DHCPV6_RENEW,"
+                  " DHCPV6_REBIND, DHCPV6_RELEASE, DHCPV6_DECLINE or"
+                  " DHCPV6_CONFIRM");
+    }
     // Reply message must be specified.
     if (!reply) {
         bundy_throw(bundy::BadValue, "Unable to create " << msg_type_str
@@ -358,6 +501,12 @@ TestControl::createMessageFromReply(const uint16_t msg_type,
                   " in the Reply message");
     }
     msg->addOption(opt_clientid);
+    // Rebind and Confirm may be answered by any server so they carry no
+    // server id.
+    if ((msg_type == DHCPV6_REBIND) || (msg_type == DHCPV6_CONFIRM)) {
+        copyIaOptions(reply, msg);
+        return (msg);
+    }
     // Server id.
     OptionPtr opt_serverid = reply->getOption(D6O_SERVERID);
     if (!opt_serverid) {
@@ -515,32 +664,57 @@ TestControl::generateDuid(uint8_t& randomized) const {
 
 uint32_t
 TestControl::getCurrentTimeout() const {
-    CommandOptions& options = CommandOptions::instance();
     ptime now(microsec_clock::universal_time());
+    // Let's assume that the due time for Solicit is the soonest.
+    ptime due = basic_rate_control_.getDue();
+    // If we are sending messages for the leases and the due time for
+    // any of them occurs sooner, set the due time to this due time.
+    for (size_t i = 0; i < lease_messages_num; ++i) {
+        const RateControl& rate_control =
+            getLeaseRateControl(lease_messages[i]);
+        if ((rate_control.getRate() != 0) && (rate_control.getDue() < due)) {
+            due = rate_control.getDue();
+        }
+    }
     // Check that we haven't passed the moment to send the next set of
     // packets.
-    if (now >= basic_rate_control_.getDue() ||
-        (options.getRenewRate() != 0 && now >= renew_rate_control_.getDue()) ||
-        (options.getReleaseRate() != 0 &&
-         now >= release_rate_control_.getDue())) {
+    if (now >= due) {
         return (0);
     }
+    // Return the timeout in microseconds.
+    return (time_period(now, due).length().total_microseconds());
+}
 
-    // Let's assume that the due time for Solicit is the soonest.
-    ptime due = basic_rate_control_.getDue();
-    // If we are sending Renews and due time for Renew occurs sooner,
-    // set the due time to Renew due time.
-    if ((options.getRenewRate()) != 0 && (renew_rate_control_.getDue() < due)) {
-        due = renew_rate_control_.getDue();
+RateControl&
+TestControl::getLeaseRateControl(const LeaseMessage msg) {
+    return (const_cast<RateControl&>(static_cast<const TestControl*>(this)->
+                                     getLeaseRateControl(msg)));
+}
+
+const RateControl&
+TestControl::getLeaseRateControl(const LeaseMessage msg) const {
+    switch (msg) {
+    case LEASE_RENEW:
+        return (renew_rate_control_);
+    case LEASE_REBIND:
+        return (rebind_rate_control_);
+    case LEASE_REBOOT:
+        return (reboot_rate_control_);
+    case LEASE_RELEASE:
+        return (release_rate_control_);
+    default:
+        ;
     }
-    // If we are sending Releases and the due time for Release occurs
-    // sooner than the current due time, let's use the due for Releases.
-    if ((options.getReleaseRate() != 0) &&
-        (release_rate_control_.getDue() < due)) {
-        due = release_rate_control_.getDue();
+    return (decline_rate_control_);
+}
+
+int
+TestControl::getLeaseMessagesRate() const {
+    int rate = 0;
+    for (size_t i = 0; i < lease_messages_num; ++i) {
+        rate += getLeaseRateControl(lease_messages[i]).getRate();
     }
-    // Return the timeout in microseconds.
-    return (time_period(now, due).length().total_microseconds());
+    return (rate);
 }
 
 int
@@ -678,6 +852,23 @@ TestControl::initializeStatsMgr() {
             stats_mgr4_->addExchangeStats(StatsMgr4::XCHG_RA,
                                           options.getDropTime()[1]);
         }
+        if (options.getRenewRate() != 0) {
+            stats_mgr4_->addExchangeStats(StatsMgr4::XCHG_RNA);
+        }
+        if (options.getRebindRate() != 0) {
+            stats_mgr4_->addExchangeStats(StatsMgr4::XCHG_RBA);
+        }
+        if (options.getRebootRate() != 0) {
+            stats_mgr4_->addExchangeStats(StatsMgr4::XCHG_IRA);
+        }
+        // DHCPRELEASE and DHCPDECLINE are not answered by the server so
+        // they are only counted.
+        if (options.getReleaseRate() != 0) {
+            stats_mgr4_->addCustomCounter("sentrelease", "Sent releases");
+        }
+        if (options.getDeclineRate() != 0) {
+            stats_mgr4_->addCustomCounter("sentdecline", "Sent declines");
+        }
 
     } else if (options.getIpVersion() == 6) {
         stats_mgr6_.reset();
@@ -691,9 +882,18 @@ TestControl::initializeStatsMgr() {
         if (options.getRenewRate() != 0) {
             stats_mgr6_->addExchangeStats(StatsMgr6::XCHG_RN);
         }
+        if (options.getRebindRate() != 0) {
+            stats_mgr6_->addExchangeStats(StatsMgr6::XCHG_RB);
+        }
         if (options.getReleaseRate() != 0) {
             stats_mgr6_->addExchangeStats(StatsMgr6::XCHG_RL);
         }
+        if (options.getDeclineRate() != 0) {
+            stats_mgr6_->addExchangeStats(StatsMgr6::XCHG_DC);
+        }
+        if (options.getRebootRate() != 0) {
+            stats_mgr6_->addExchangeStats(StatsMgr6::XCHG_CN);
+        }
     }
     if (testDiags('i')) {
         if (options.getIpVersion() == 4) {
@@ -805,6 +1005,70 @@ TestControl::openSocket() const {
     return (sock);
 }
 
+int
+TestControl::openGeneratorSocket(const TestControlSocket& socket) const {
+    CommandOptions& options = CommandOptions::instance();
+    int sock = -1;
+    int ret = -1;
+    if (options.getIpVersion() == 4) {
+        sock = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (sock >= 0) {
+            struct sockaddr_in addr4;
+            memset(&addr4, 0, sizeof(addr4));
+            addr4.sin_family = AF_INET;
+            addr4.sin_addr.s_addr =
+                htonl(static_cast<uint32_t>(socket.addr_));
+            ret = bind(sock, reinterpret_cast<struct sockaddr*>(&addr4),
+                       sizeof(addr4));
+        }
+    } else {
+        sock = ::socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+        if (sock >= 0) {
+            struct sockaddr_in6 addr6;
+            memset(&addr6, 0, sizeof(addr6));
+            addr6.sin6_family = AF_INET6;
+            const std::vector<uint8_t> bytes = socket.addr_.toBytes();
+            memcpy(&addr6.sin6_addr, &bytes[0], sizeof(addr6.sin6_addr));
+            if (socket.addr_.isV6LinkLocal()) {
+                addr6.sin6_scope_id = socket.ifindex_;
+            }
+            ret = bind(sock, reinterpret_cast<struct sockaddr*>(&addr6),
+                       sizeof(addr6));
+        }
+    }
+    if (ret < 0) {
+        if (sock >= 0) {
+            close(sock);
+        }
+        bundy_throw(BadValue, "unable to open socket to send messages to "
+                  "DHCP server, errno = " << errno);
+    }
+
+    // Set the broadcast and multicast options as for the main socket.
+    if ((options.getIpVersion() == 4) && options.isBroadcast()) {
+        int broadcast_enable = 1;
+        ret = setsockopt(sock, SOL_SOCKET, SO_BROADCAST,
+                         &broadcast_enable, sizeof(broadcast_enable));
+    } else if ((options.getIpVersion() == 6) &&
+               IOAddress(options.getServerName()).isV6Multicast()) {
+        int hops = 1;
+        ret = setsockopt(sock, IPPROTO_IPV6, IPV6_MULTICAST_HOPS,
+                         &hops, sizeof(hops));
+        if (ret >= 0) {
+            int idx = socket.ifindex_;
+            ret = setsockopt(sock, IPPROTO_IPV6, IPV6_MULTICAST_IF,
+                             &idx, sizeof(idx));
+        }
+    }
+    if (ret < 0) {
+        close(sock);
+        bundy_throw(InvalidOperation, "unable to set broadcast or multicast "
+                  "option on socket " << sock << ". errno = " << errno);
+    }
+
+    return (sock);
+}
+
 void
 TestControl::sendPackets(const TestControlSocket& socket,
                          const uint64_t packets_num,
@@ -858,6 +1122,39 @@ TestControl::sendMultipleMessages6(const TestControlSocket& socket,
     return (msg_num);
 }
 
+uint64_t
+TestControl::sendMultipleMessages4(const TestControlSocket& socket,
+                                   const LeaseMessage msg,
+                                   const uint64_t msg_num) {
+    for (uint64_t i = 0; i < msg_num; ++i) {
+        if (!sendMessageFromAck(msg, socket)) {
+            return (i);
+        }
+    }
+    return (msg_num);
+}
+
+void
+TestControl::sendLeaseMessages(const TestControlSocket& socket) {
+    const bool v4 = (CommandOptions::instance().getIpVersion() == 4);
+    for (size_t i = 0; i < lease_messages_num; ++i) {
+        RateControl& rate_control = getLeaseRateControl(lease_messages[i]);
+        if (rate_control.getRate() == 0) {
+            continue;
+        }
+        // Check how many messages should be sent to catch up with
+        // the desired rate.
+        const uint64_t packets_due = rate_control.getOutboundMessageCount();
+        checkLateMessages(rate_control);
+        if (v4) {
+            sendMultipleMessages4(socket, lease_messages[i], packets_due);
+        } else {
+            sendMultipleMessages6(socket, leaseMessageToType6(lease_messages[i]),
+                                  packets_due);
+        }
+    }
+}
+
 void
 TestControl::printDiagnostics() const {
     CommandOptions& options = CommandOptions::instance();
@@ -990,7 +1287,8 @@ TestControl::printStats() const {
                       "hasn't been initialized");
         }
         stats_mgr4_->printStats();
-        if (testDiags('i')) {
+        if (testDiags('i') || (options.getReleaseRate() != 0) ||
+            (options.getDeclineRate() != 0)) {
             stats_mgr4_->printCustomCounters();
         }
     } else if (options.getIpVersion() == 6) {
@@ -1086,8 +1384,37 @@ TestControl::processReceivedPacket4(const TestControlSocket& socket,
                 sendRequest4(socket, template_buffers_[1], discover_pkt4, pkt4);
             }
         }
-    } else if (pkt4->getType() == DHCPACK) {
-        stats_mgr4_->passRcvdPacket(StatsMgr4::XCHG_RA, pkt4);
+    } else if ((pkt4->getType() == DHCPACK) || (pkt4->getType() == DHCPNAK)) {
+        // The ACK may be the server's response to the DHCPREQUEST sent
+        // within the 4-way exchange, or to a DHCPREQUEST sent for an
+        // existing lease.  The ACK assigning a lease is kept in the storage
+        // if messages are sent for the leases, as it holds the information
+        // needed to construct them.
+        // A DHCPNAK to a DHCPREQUEST sent for an existing lease tells the
+        // client to restart from the beginning: it is counted as a response
+        // but the lease is forgotten.
+        if ((pkt4->getType() == DHCPACK) &&
+            stats_mgr4_->hasExchangeStats(StatsMgr4::XCHG_RA) &&
+            stats_mgr4_->passRcvdPacket(StatsMgr4::XCHG_RA, pkt4)) {
+            if (getLeaseMessagesRate() != 0) {
+                ack_storage_.append(pkt4);
+            }
+            return;
+        }
+        const StatsMgr4::ExchangeType xchg_types[] = {
+            StatsMgr4::XCHG_RNA, StatsMgr4::XCHG_RBA, StatsMgr4::XCHG_IRA
+        };
+        for (size_t i = 0; i < sizeof(xchg_types) / sizeof(xchg_types[0]);
+             ++i) {
+            if (stats_mgr4_->hasExchangeStats(xchg_types[i]) &&
+                stats_mgr4_->passRcvdPacket(xchg_types[i], pkt4)) {
+                // The client keeps its lease, so does the storage.
+                if (pkt4->getType() == DHCPACK) {
+                    ack_storage_.append(pkt4);
+                }
+                return;
+            }
+        }
     }
 }
 
@@ -1123,26 +1450,34 @@ TestControl::processReceivedPacket6(const TestControlSocket& socket,
             // being sent. Note that, Reply messages hold the information about
             // leases assigned. We use this information to construct Renew and
             // Release messages.
-            if (stats_mgr6_->hasExchangeStats(StatsMgr6::XCHG_RN) ||
-                stats_mgr6_->hasExchangeStats(StatsMgr6::XCHG_RL)) {
-                // Renew or Release messages are sent, because StatsMgr has the
-                // specific exchange type specified. Let's append the Reply
+            if (getLeaseMessagesRate() != 0) {
+                // Messages are sent for the leases. Let's append the Reply
                 // message to a storage.
                 reply_storage_.append(pkt6);
             }
+            return;
+        }
         // The Reply message is not a server's response to the Request message
-        // sent within the 4-way exchange. It may be a response to the Renew
-        // or Release message. In the if clause we first check if StatsMgr
-        // has exchange type for Renew specified, and if it has, if there is
-        // a corresponding Renew message for the received Reply. If not,
-        // we check that StatsMgr has exchange type for Release specified,
-        // as possibly the Reply has been sent in response to Release.
-        } else if (!(stats_mgr6_->hasExchangeStats(StatsMgr6::XCHG_RN) &&
-                     stats_mgr6_->passRcvdPacket(StatsMgr6::XCHG_RN, pkt6)) &&
-                   stats_mgr6_->hasExchangeStats(StatsMgr6::XCHG_RL)) {
-            // At this point, it is only possible that the Reply has been sent
-            // in response to a Release. Try to match the Reply with Release.
-            stats_mgr6_->passRcvdPacket(StatsMgr6::XCHG_RL, pkt6);
+        // sent within the 4-way exchange. It may be a response to one of the
+        // messages sent for the leases. For each of them, we check if StatsMgr
+        // has the exchange type specified, and if it has, if there is
+        // a corresponding message for the received Reply.
+        const StatsMgr6::ExchangeType xchg_types[] = {
+            StatsMgr6::XCHG_RN, StatsMgr6::XCHG_RB, StatsMgr6::XCHG_RL,
+            StatsMgr6::XCHG_DC, StatsMgr6::XCHG_CN
+        };
+        for (size_t i = 0; i < sizeof(xchg_types) / sizeof(xchg_types[0]);
+             ++i) {
+            if (stats_mgr6_->hasExchangeStats(xchg_types[i]) &&
+                stats_mgr6_->passRcvdPacket(xchg_types[i], pkt6)) {
+                // A client which has renewed or rebound its lease keeps it,
+                // so does the storage.
+                if ((xchg_types[i] == StatsMgr6::XCHG_RN) ||
+                    (xchg_types[i] == StatsMgr6::XCHG_RB)) {
+                    reply_storage_.append(pkt6);
+                }
+                return;
+            }
         }
     }
 }
@@ -1155,7 +1490,7 @@ TestControl::receivePackets(const TestControlSocket& socket) {
         if (CommandOptions::instance().getIpVersion() == 4) {
             Pkt4Ptr pkt4;
             try {
-                pkt4 = IfaceMgr::instance().receive4(0, getCurrentTimeout());
+                pkt4 = receive4(getCurrentTimeout());
             } catch (const Exception& e) {
                 std::cerr << "Failed to receive DHCPv4 packet: "
                           << e.what() <<  std::endl;
@@ -1173,7 +1508,7 @@ TestControl::receivePackets(const TestControlSocket& socket) {
         } else if (CommandOptions::instance().getIpVersion() == 6) {
             Pkt6Ptr pkt6;
             try {
-                pkt6 = IfaceMgr::instance().receive6(0, getCurrentTimeout());
+                pkt6 = receive6(getCurrentTimeout());
             } catch (const Exception& e) {
                 std::cerr << "Failed to receive DHCPv6 packet: "
                           << e.what() << std::endl;
@@ -1194,6 +1529,69 @@ TestControl::receivePackets(const TestControlSocket& socket) {
     return (received);
 }
 
+Pkt4Ptr
+TestControl::receive4(const uint32_t timeout) {
+    if (!generator_) {
+        return (IfaceMgr::instance().receive4(0, timeout));
+    }
+    bundy::util::thread::Mutex::Locker locker(queue_mutex_);
+    // The condition variable can't wait less than a millisecond.
+    if (queue4_.empty() && !stopping_ && (timeout >= 1000)) {
+        queue_cond_.timedWait(queue_mutex_, timeout / 1000);
+    }
+    if (queue4_.empty()) {
+        return (Pkt4Ptr());
+    }
+    Pkt4Ptr pkt4 = queue4_.front();
+    queue4_.pop_front();
+    return (pkt4);
+}
+
+Pkt6Ptr
+TestControl::receive6(const uint32_t timeout) {
+    if (!generator_) {
+        return (IfaceMgr::instance().receive6(0, timeout));
+    }
+    bundy::util::thread::Mutex::Locker locker(queue_mutex_);
+    // The condition variable can't wait less than a millisecond.
+    if (queue6_.empty() && !stopping_ && (timeout >= 1000)) {
+        queue_cond_.timedWait(queue_mutex_, timeout / 1000);
+    }
+    if (queue6_.empty()) {
+        return (Pkt6Ptr());
+    }
+    Pkt6Ptr pkt6 = queue6_.front();
+    queue6_.pop_front();
+    return (pkt6);
+}
+
+void
+TestControl::pushPacket(const Pkt4Ptr& pkt) {
+    bundy::util::thread::Mutex::Locker locker(queue_mutex_);
+    queue4_.push_back(pkt);
+    queue_cond_.signal();
+}
+
+void
+TestControl::pushPacket(const Pkt6Ptr& pkt) {
+    bundy::util::thread::Mutex::Locker locker(queue_mutex_);
+    queue6_.push_back(pkt);
+    queue_cond_.signal();
+}
+
+void
+TestControl::stop() {
+    bundy::util::thread::Mutex::Locker locker(queue_mutex_);
+    stopping_ = true;
+    queue_cond_.broadcast();
+}
+
+bool
+TestControl::isStopping() {
+    bundy::util::thread::Mutex::Locker locker(queue_mutex_);
+    return (stopping_);
+}
+
 void
 TestControl::registerOptionFactories4() const {
     static bool factories_registered = false;
@@ -1271,16 +1669,11 @@ TestControl::registerOptionFactories() const {
 
 void
 TestControl::reset() {
-    CommandOptions& options = CommandOptions::instance();
-    basic_rate_control_.setAggressivity(options.getAggressivity());
-    basic_rate_control_.setRate(options.getRate());
-    renew_rate_control_.setAggressivity(options.getAggressivity());
-    renew_rate_control_.setRate(options.getRenewRate());
-    release_rate_control_.setAggressivity(options.getAggressivity());
-    release_rate_control_.setRate(options.getReleaseRate());
+    setRateControls(1, 0);
 
     transid_gen_.reset();
     last_report_ = microsec_clock::universal_time();
+    last_clean_ = last_report_;
     // Actual generators will have to be set later on because we need to
     // get command line parameters first.
     setTransidGenerator(NumberGeneratorPtr());
@@ -1289,6 +1682,27 @@ TestControl::reset() {
     interrupted_ = false;
 }
 
+void
+TestControl::setRateControls(const int threads_num, const int thread_index) {
+    CommandOptions& options = CommandOptions::instance();
+    RateControl* rate_controls[] = {
+        &basic_rate_control_, &renew_rate_control_, &rebind_rate_control_,
+        &reboot_rate_control_, &release_rate_control_, &decline_rate_control_
+    };
+    const int rates[] = {
+        options.getRate(), options.getRenewRate(), options.getRebindRate(),
+        options.getRebootRate(), options.getReleaseRate(),
+        options.getDeclineRate()
+    };
+    for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); ++i) {
+        // The remainder of the division goes to the first generators.
+        const int rate = rates[i] / threads_num +
+            (thread_index < rates[i] % threads_num ? 1 : 0);
+        rate_controls[i]->setAggressivity(options.getAggressivity());
+        rate_controls[i]->setRate(rate);
+    }
+}
+
 int
 TestControl::run() {
     // Reset singleton state before test starts.
@@ -1345,66 +1759,10 @@ TestControl::run() {
 
     // Initialize Statistics Manager. Release previous if any.
     initializeStatsMgr();
-    for (;;) {
-        // Calculate number of packets to be sent to stay
-        // catch up with rate.
-        uint64_t packets_due = basic_rate_control_.getOutboundMessageCount();
-        checkLateMessages(basic_rate_control_);
-        if ((packets_due == 0) && testDiags('i')) {
-            if (options.getIpVersion() == 4) {
-                stats_mgr4_->incrementCounter("shortwait");
-            } else if (options.getIpVersion() == 6) {
-                stats_mgr6_->incrementCounter("shortwait");
-            }
-        }
-
-        // @todo: set non-zero timeout for packets once we implement
-        // microseconds timeout in IfaceMgr.
-        receivePackets(socket);
-
-        // If test period finished, maximum number of packet drops
-        // has been reached or test has been interrupted we have to
-        // finish the test.
-        if (checkExitConditions()) {
-            break;
-        }
-
-        // Initiate new DHCP packet exchanges.
-        sendPackets(socket, packets_due);
-
-        // If -f<renew-rate> option was specified we have to check how many
-        // Renew packets should be sent to catch up with a desired rate.
-        if ((options.getIpVersion() == 6) && (options.getRenewRate() != 0)) {
-            uint64_t renew_packets_due =
-                renew_rate_control_.getOutboundMessageCount();
-            checkLateMessages(renew_rate_control_);
-            // Send Renew messages.
-            sendMultipleMessages6(socket, DHCPV6_RENEW, renew_packets_due);
-        }
-
-        // If -F<release-rate> option was specified we have to check how many
-        // Release messages should be sent to catch up with a desired rate.
-        if ((options.getIpVersion() == 6) && (options.getReleaseRate() != 0)) {
-            uint64_t release_packets_due =
-                release_rate_control_.getOutboundMessageCount();
-            checkLateMessages(release_rate_control_);
-            // Send Release messages.
-            sendMultipleMessages6(socket, DHCPV6_RELEASE, release_packets_due);
-        }
-
-        // Report delay means that user requested printing number
-        // of sent/received/dropped packets repeatedly.
-        if (options.getReportDelay() > 0) {
-            printIntermediateStats();
-        }
-
-        // If we are sending Renews to the server, the Reply packets are cached
-        // so as leases for which we send Renews can be idenitfied. The major
-        // issue with this approach is that most of the time we are caching
-        // more packets than we actually need. This function removes excessive
-        // Reply messages to reduce the memory and CPU utilization. Note that
-        // searches in the long list of Reply packets increases CPU utilization.
-        cleanCachedPackets();
+    if (options.getThreadsNum() > 1) {
+        runGenerators(socket);
+    } else {
+        runGenerator(socket);
     }
     printStats();
 
@@ -1422,6 +1780,15 @@ TestControl::run() {
         }
     }
 
+    // Print the histograms of the delays.
+    if (testDiags('h')) {
+        if (options.getIpVersion() == 4) {
+            stats_mgr4_->printDelayHistograms();
+        } else if (options.getIpVersion() == 6) {
+            stats_mgr6_->printDelayHistograms();
+        }
+    }
+
     // Print server id.
     if (testDiags('s') && (first_packet_serverid_.size() > 0)) {
         std::cout << "Server id: " << vector2Hex(first_packet_serverid_) << std::endl;
@@ -1447,6 +1814,157 @@ TestControl::run() {
     return (ret_code);
 }
 
+void
+TestControl::runGenerator(const TestControlSocket& socket) {
+    CommandOptions& options = CommandOptions::instance();
+    try {
+        for (;;) {
+            // Calculate number of packets to be sent to stay
+            // catch up with rate.
+            uint64_t packets_due = basic_rate_control_.getOutboundMessageCount();
+            checkLateMessages(basic_rate_control_);
+            if ((packets_due == 0) && testDiags('i')) {
+                if (options.getIpVersion() == 4) {
+                    stats_mgr4_->incrementCounter("shortwait");
+                } else if (options.getIpVersion() == 6) {
+                    stats_mgr6_->incrementCounter("shortwait");
+                }
+            }
+
+            // @todo: set non-zero timeout for packets once we implement
+            // microseconds timeout in IfaceMgr.
+            receivePackets(socket);
+
+            // If test period finished, maximum number of packet drops
+            // has been reached or test has been interrupted we have to
+            // finish the test.  A generator is also stopped by the main
+            // thread.
+            if (checkExitConditions() || (generator_ && isStopping())) {
+                break;
+            }
+
+            // Initiate new DHCP packet exchanges.
+            sendPackets(socket, packets_due);
+
+            // If -f<renew-rate>, -j<rebind-rate>, -K<reboot-rate>,
+            // -F<release-rate> or -k<decline-rate> option was specified we
+            // have to check how many messages should be sent for the leases
+            // to catch up with a desired rate.
+            sendLeaseMessages(socket);
+
+            // Report delay means that user requested printing number
+            // of sent/received/dropped packets repeatedly.  The main
+            // thread prints them on behalf of the generators.
+            if ((options.getReportDelay() > 0) && !generator_) {
+                printIntermediateStats();
+            }
+
+            // If we are sending messages for the leases, the ACK or Reply
+            // packets are cached so as leases for which we send them can be
+            // idenitfied. The major issue with this approach is that most of
+            // the time we are caching more packets than we actually need.
+            // This function removes excessive packets to reduce the memory
+            // and CPU utilization. Note that searches in the long list of
+            // packets increases CPU utilization.
+            cleanCachedPackets();
+        }
+    } catch (...) {
+        // The other generators and the main thread have to stop too.
+        if (generator_) {
+            interrupted_ = true;
+        }
+        throw;
+    }
+}
+
+void
+TestControl::runGenerators(const TestControlSocket& socket) {
+    CommandOptions& options = CommandOptions::instance();
+    const int threads_num = options.getThreadsNum();
+    // The option definitions are initialized on first use, which must not
+    // happen in several threads at once.
+    LibDHCP::getOptionDefs(options.getIpVersion() == 4 ?
+                           Option::V4 : Option::V6);
+
+    generators_.clear();
+    for (int i = 0; i < threads_num; ++i) {
+        TestControlPtr generator(new TestControl(i));
+        generator->stats_mgr4_ = stats_mgr4_;
+        generator->stats_mgr6_ = stats_mgr6_;
+        generator->template_buffers_ = template_buffers_;
+        generator->send_socket_ = openGeneratorSocket(socket);
+        generators_.push_back(generator);
+    }
+
+    std::vector<boost::shared_ptr<util::thread::Thread> > threads;
+    for (int i = 0; i < threads_num; ++i) {
+        threads.push_back(boost::shared_ptr<util::thread::Thread>(
+            new util::thread::Thread(boost::bind(&TestControl::runGenerator,
+                                                 generators_[i].get(),
+                                                 boost::cref(socket)))));
+    }
+
+    // Hand the server's responses over to the generators which sent the
+    // messages, identified by the transaction ids.
+    while (!checkExitConditions()) {
+        try {
+            if (options.getIpVersion() == 4) {
+                Pkt4Ptr pkt4 = IfaceMgr::instance().receive4(0, 100000);
+                if (pkt4 && (pkt4->data_.size() >= 8)) {
+                    const uint32_t transid = (pkt4->data_[4] << 24) |
+                        (pkt4->data_[5] << 16) | (pkt4->data_[6] << 8) |
+                        pkt4->data_[7];
+                    generators_[transid % threads_num]->pushPacket(pkt4);
+                }
+            } else {
+                Pkt6Ptr pkt6 = IfaceMgr::instance().receive6(0, 100000);
+                if (pkt6 && (pkt6->data_.size() >= 4)) {
+                    const uint32_t transid = (pkt6->data_[1] << 16) |
+                        (pkt6->data_[2] << 8) | pkt6->data_[3];
+                    generators_[transid % threads_num]->pushPacket(pkt6);
+                }
+            }
+        } catch (const Exception& e) {
+            std::cerr << "Failed to receive DHCPv"
+                      << static_cast<int>(options.getIpVersion())
+                      << " packet: " << e.what() << std::endl;
+        }
+        if (options.getReportDelay() > 0) {
+            printIntermediateStats();
+        }
+    }
+
+    // Stop the generators and wait for them all before reporting the
+    // first failure.
+    for (int i = 0; i < threads_num; ++i) {
+        generators_[i]->stop();
+    }
+    std::string error;
+    for (int i = 0; i < threads_num; ++i) {
+        try {
+            threads[i]->wait();
+        } catch (const util::thread::Thread::UncaughtException& ex) {
+            if (error.empty()) {
+                error = ex.what();
+            }
+        }
+    }
+    if (!error.empty()) {
+        bundy_throw(Unexpected, "generator thread failed: " << error);
+    }
+
+    // Collect the diagnostics data gathered by the generators.
+    for (int i = 0; i < threads_num; ++i) {
+        if (first_packet_serverid_.empty()) {
+            first_packet_serverid_ = generators_[i]->first_packet_serverid_;
+        }
+        template_packets_v4_.insert(generators_[i]->template_packets_v4_.begin(),
+                                    generators_[i]->template_packets_v4_.end());
+        template_packets_v6_.insert(generators_[i]->template_packets_v6_.begin(),
+                                    generators_[i]->template_packets_v6_.end());
+    }
+}
+
 void
 TestControl::runWrapped(bool do_stop /*= false */) const {
     CommandOptions& options = CommandOptions::instance();
@@ -1515,7 +2033,7 @@ TestControl::sendDiscover4(const TestControlSocket& socket,
     pkt4->setHWAddr(HTYPE_ETHER, mac_address.size(), mac_address);
 
     pkt4->pack();
-    IfaceMgr::instance().send(pkt4);
+    sendToServer(pkt4);
     if (!preload) {
         if (!stats_mgr4_) {
             bundy_throw(InvalidOperation, "Statistics Manager for DHCPv4 "
@@ -1565,7 +2083,7 @@ TestControl::sendDiscover4(const TestControlSocket& socket,
     // Pack the input packet buffer to output buffer so as it can
     // be sent to server.
     pkt4->rawPack();
-    IfaceMgr::instance().send(boost::static_pointer_cast<Pkt4>(pkt4));
+    sendToServer(boost::static_pointer_cast<Pkt4>(pkt4));
     if (!preload) {
         if (!stats_mgr4_) {
             bundy_throw(InvalidOperation, "Statistics Manager for DHCPv4 "
@@ -1578,19 +2096,74 @@ TestControl::sendDiscover4(const TestControlSocket& socket,
     saveFirstPacket(pkt4);
 }
 
+bool
+TestControl::sendMessageFromAck(const LeaseMessage msg,
+                                const TestControlSocket& socket) {
+    // We track the timestamp of each message in its rate control.
+    getLeaseRateControl(msg).updateSendTime();
+    Pkt4Ptr ack = ack_storage_.getRandom();
+    if (!ack) {
+        return (false);
+    }
+    // Prepare the message of the specified type.
+    Pkt4Ptr pkt4 = createMessageFromAck(msg, ack);
+    setDefaults4(socket, pkt4);
+    pkt4->pack();
+    // And send it.
+    sendToServer(pkt4);
+    if (!stats_mgr4_) {
+        bundy_throw(Unexpected, "Statistics Manager for DHCPv4 "
+                  "hasn't been initialized");
+    }
+    switch (msg) {
+    case LEASE_RENEW:
+        stats_mgr4_->passSentPacket(StatsMgr4::XCHG_RNA, pkt4);
+        break;
+    case LEASE_REBIND:
+        stats_mgr4_->passSentPacket(StatsMgr4::XCHG_RBA, pkt4);
+        break;
+    case LEASE_REBOOT:
+        stats_mgr4_->passSentPacket(StatsMgr4::XCHG_IRA, pkt4);
+        break;
+    case LEASE_RELEASE:
+        stats_mgr4_->incrementCounter("sentrelease");
+        break;
+    default:
+        stats_mgr4_->incrementCounter("sentdecline");
+    }
+    return (true);
+}
+
 bool
 TestControl::sendMessageFromReply(const uint16_t msg_type,
                                   const TestControlSocket& socket) {
-    // We only permit Release or Renew messages to be sent using this function.
-    if (msg_type != DHCPV6_RENEW && msg_type != DHCPV6_RELEASE) {
-        bundy_throw(bundy::BadValue, "invalid message type " << msg_type
-                  << " to be sent, expected DHCPV6_RENEW or DHCPV6_RELEASE");
-    }
-    // We track the timestamp of last Release and Renew in different variables.
-    if (msg_type == DHCPV6_RENEW) {
+    // We track the timestamp of each message in its rate control.
+    StatsMgr6::ExchangeType xchg_type;
+    switch (msg_type) {
+    case DHCPV6_RENEW:
         renew_rate_control_.updateSendTime();
-    } else {
+        xchg_type = StatsMgr6::XCHG_RN;
+        break;
+    case DHCPV6_REBIND:
+        rebind_rate_control_.updateSendTime();
+        xchg_type = StatsMgr6::XCHG_RB;
+        break;
+    case DHCPV6_RELEASE:
         release_rate_control_.updateSendTime();
+        xchg_type = StatsMgr6::XCHG_RL;
+        break;
+    case DHCPV6_DECLINE:
+        decline_rate_control_.updateSendTime();
+        xchg_type = StatsMgr6::XCHG_DC;
+        break;
+    case DHCPV6_CONFIRM:
+        reboot_rate_control_.updateSendTime();
+        xchg_type = StatsMgr6::XCHG_CN;
+        break;
+    default:
+        bundy_throw(bundy::BadValue, "invalid message type " << msg_type
+                  << " to be sent, expected DHCPV6_RENEW, DHCPV6_REBIND,"
+                  " DHCPV6_RELEASE, DHCPV6_DECLINE or DHCPV6_CONFIRM");
     }
     Pkt6Ptr reply = reply_storage_.getRandom();
     if (!reply) {
@@ -1601,13 +2174,12 @@ TestControl::sendMessageFromReply(const uint16_t msg_type,
     setDefaults6(socket, msg);
     msg->pack();
     // And send it.
-    IfaceMgr::instance().send(msg);
+    sendToServer(msg);
     if (!stats_mgr6_) {
         bundy_throw(Unexpected, "Statistics Manager for DHCPv6 "
                   "hasn't been initialized");
     }
-    stats_mgr6_->passSentPacket((msg_type == DHCPV6_RENEW ? StatsMgr6::XCHG_RN
-                                 : StatsMgr6::XCHG_RL), msg);
+    stats_mgr6_->passSentPacket(xchg_type, msg);
     return (true);
 }
 
@@ -1662,7 +2234,7 @@ TestControl::sendRequest4(const TestControlSocket& socket,
     pkt4->setSecs(static_cast<uint16_t>(elapsed_time / 1000));
     // Prepare on wire data to send.
     pkt4->pack();
-    IfaceMgr::instance().send(pkt4);
+    sendToServer(pkt4);
     if (!stats_mgr4_) {
         bundy_throw(InvalidOperation, "Statistics Manager for DHCPv4 "
                   "hasn't been initialized");
@@ -1767,7 +2339,7 @@ TestControl::sendRequest4(const TestControlSocket& socket,
     setDefaults4(socket, boost::static_pointer_cast<Pkt4>(pkt4));
     // Prepare on-wire data.
     pkt4->rawPack();
-    IfaceMgr::instance().send(boost::static_pointer_cast<Pkt4>(pkt4));
+    sendToServer(boost::static_pointer_cast<Pkt4>(pkt4));
     if (!stats_mgr4_) {
         bundy_throw(InvalidOperation, "Statistics Manager for DHCPv4 "
                   "hasn't been initialized");
@@ -1822,7 +2394,7 @@ TestControl::sendRequest6(const TestControlSocket& socket,
     setDefaults6(socket, pkt6);
     // Prepare on-wire data.
     pkt6->pack();
-    IfaceMgr::instance().send(pkt6);
+    sendToServer(pkt6);
     if (!stats_mgr6_) {
         bundy_throw(InvalidOperation, "Statistics Manager for DHCPv6 "
                   "hasn't been initialized");
@@ -1927,7 +2499,7 @@ TestControl::sendRequest6(const TestControlSocket& socket,
     // Prepare on wire data.
     pkt6->rawPack();
     // Send packet.
-    IfaceMgr::instance().send(pkt6);
+    sendToServer(pkt6);
     if (!stats_mgr6_) {
         bundy_throw(InvalidOperation, "Statistics Manager for DHCPv6 "
                   "hasn't been initialized");
@@ -1982,7 +2554,7 @@ TestControl::sendSolicit6(const TestControlSocket& socket,
 
     setDefaults6(socket, pkt6);
     pkt6->pack();
-    IfaceMgr::instance().send(pkt6);
+    sendToServer(pkt6);
     if (!preload) {
         if (!stats_mgr6_) {
             bundy_throw(InvalidOperation, "Statistics Manager for DHCPv6 "
@@ -2027,7 +2599,7 @@ TestControl::sendSolicit6(const TestControlSocket& socket,
     pkt6->rawPack();
     setDefaults6(socket, pkt6);
     // Send solicit packet.
-    IfaceMgr::instance().send(pkt6);
+    sendToServer(pkt6);
     if (!preload) {
         if (!stats_mgr6_) {
             bundy_throw(InvalidOperation, "Statistics Manager for DHCPv6 "
@@ -2040,6 +2612,48 @@ TestControl::sendSolicit6(const TestControlSocket& socket,
 }
 
 
+void
+TestControl::sendToServer(const Pkt4Ptr& pkt) {
+    if (send_socket_ < 0) {
+        IfaceMgr::instance().send(pkt);
+        return;
+    }
+    pkt->updateTimestamp();
+    struct sockaddr_in to;
+    memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+    to.sin_port = htons(pkt->getRemotePort());
+    to.sin_addr.s_addr = htonl(static_cast<uint32_t>(pkt->getRemoteAddr()));
+    const util::OutputBuffer& buf = pkt->getBuffer();
+    if (sendto(send_socket_, buf.getData(), buf.getLength(), 0,
+               reinterpret_cast<struct sockaddr*>(&to), sizeof(to)) < 0) {
+        bundy_throw(SocketWriteError, "pkt4 send failed: sendto() returned "
+                  "error " << errno);
+    }
+}
+
+void
+TestControl::sendToServer(const Pkt6Ptr& pkt) {
+    if (send_socket_ < 0) {
+        IfaceMgr::instance().send(pkt);
+        return;
+    }
+    pkt->updateTimestamp();
+    struct sockaddr_in6 to;
+    memset(&to, 0, sizeof(to));
+    to.sin6_family = AF_INET6;
+    to.sin6_port = htons(pkt->getRemotePort());
+    const std::vector<uint8_t> bytes = pkt->getRemoteAddr().toBytes();
+    memcpy(&to.sin6_addr, &bytes[0], sizeof(to.sin6_addr));
+    to.sin6_scope_id = pkt->getIndex();
+    const util::OutputBuffer& buf = pkt->getBuffer();
+    if (sendto(send_socket_, buf.getData(), buf.getLength(), 0,
+               reinterpret_cast<struct sockaddr*>(&to), sizeof(to)) < 0) {
+        bundy_throw(SocketWriteError, "pkt6 send failed: sendto() returned "
+                  "error " << errno);
+    }
+}
+
 void
 TestControl::setDefaults4(const TestControlSocket& socket,
                           const Pkt4Ptr& pkt) {
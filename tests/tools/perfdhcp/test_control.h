@@ -23,12 +23,14 @@
 #include <dhcp/dhcp6.h>
 #include <dhcp/pkt4.h>
 #include <dhcp/pkt6.h>
+#include <util/threads/sync.h>
 
 #include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/function.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
+#include <list>
 #include <string>
 #include <vector>
 
@@ -100,6 +102,23 @@ public:
 /// - print statistics, e.g. achieved rate,
 /// - optionally print some diagnostics.
 ///
+/// Apart from the messages initiating new exchanges, the messages sent by
+/// the clients which have acquired a lease (Renew, Rebind, Release, Decline
+/// and the verification of the lease after a reboot) are sent at the rates
+/// given with -f, -j, -F, -k and -K.  They are built from the server's
+/// responses which assigned the leases (DHCPACK or Reply), which are cached
+/// for that purpose.
+///
+/// When several threads are requested with '-g', the main loop runs in
+/// each of them on a separate instance of this class, called a generator.
+/// Each generator simulates its own share of the clients and uses its own
+/// transaction ids, sends its share of the messages at its share of the
+/// rates, and sends them through its own socket.  The server's responses
+/// are sent to the DHCP client (or relay) port, on which only the socket
+/// opened by the main thread is bound: the main thread receives them and
+/// hands each over to the generator which owns its transaction id.  The
+/// generators share the Statistics Manager, which serializes the accesses.
+///
 /// With the '-w' command line option user may specify the external application
 /// or script to be executed. This is executed twice, first when the test starts
 /// and second time when the test ends. This external script or application must
@@ -213,9 +232,15 @@ public:
         ///
         /// \param range maximum number generated. If 0 is given then
         /// range defaults to maximum uint32_t value.
-        SequentialGenerator(uint32_t range = 0xFFFFFFFF) :
+        /// \param start first number generated, and the number generated
+        /// after the range is exhausted.
+        /// \param step difference between two numbers generated.
+        SequentialGenerator(uint32_t range = 0xFFFFFFFF,
+                            uint32_t start = 0, uint32_t step = 1) :
             NumberGenerator(),
-            num_(0),
+            num_(start),
+            start_(start),
+            step_(step),
             range_(range) {
             if (range_ == 0) {
                 range_ = 0xFFFFFFFF;
@@ -227,14 +252,29 @@ public:
         /// \return generated number.
         virtual uint32_t generate() {
             uint32_t num = num_;
-            num_ = (num_ + 1) % range_;
+            if (range_ - num_ <= step_) {
+                num_ = start_;
+            } else {
+                num_ += step_;
+            }
             return (num);
         }
     private:
         uint32_t num_;   ///< Current number.
+        uint32_t start_; ///< First number generated.
+        uint32_t step_;  ///< Difference between two numbers generated.
         uint32_t range_; ///< Number of unique numbers generated.
     };
 
+    /// \brief Messages sent by the clients which have acquired a lease.
+    enum LeaseMessage {
+        LEASE_RENEW,   ///< DHCPREQUEST (renewing) or Renew.
+        LEASE_REBIND,  ///< DHCPREQUEST (rebinding) or Rebind.
+        LEASE_REBOOT,  ///< DHCPREQUEST (init-reboot) or Confirm.
+        LEASE_RELEASE, ///< DHCPRELEASE or Release.
+        LEASE_DECLINE  ///< DHCPDECLINE or Decline.
+    };
+
     /// \brief Length of the Ethernet HW address (MAC) in bytes.
     ///
     /// \todo Make this variable length as there are cases when HW
@@ -247,6 +287,11 @@ public:
     /// \return the only existing instance of test control
     static TestControl& instance();
 
+    /// \brief Destructor.
+    ///
+    /// Closes the socket of a generator.
+    ~TestControl();
+
     /// brief\ Run performance test.
     ///
     /// Method runs whole performance test. Command line options must
@@ -289,6 +334,17 @@ protected:
     /// only via \ref instance method.
     TestControl();
 
+    /// \brief Constructor of a generator.
+    ///
+    /// Creates the instance running the main loop in one of the threads
+    /// requested with -g<threads>, see \ref runGenerators.  The rates,
+    /// the transaction ids and the simulated clients are split between
+    /// the generators.
+    ///
+    /// \param thread_index index of the generator, from 0 to the number
+    /// of threads - 1.
+    TestControl(const int thread_index);
+
     /// \brief Check if test exit conditions fulfilled.
     ///
     /// Method checks if the test exit conditions are fulfilled.
@@ -301,32 +357,58 @@ protected:
     /// \return true if any of the exit conditions is fulfilled.
     bool checkExitConditions() const;
 
-    /// \brief Removes cached DHCPv6 Reply packets every second.
+    /// \brief Removes cached DHCPv4 ACK and DHCPv6 Reply packets every second.
     ///
-    /// This function wipes cached Reply packets from the storage.
-    /// The number of packets left in the storage after the call
-    /// to this function should guarantee that the Renew packets
-    /// can be sent at the given rate. Note that the Renew packets
-    /// are generated for the existing leases, represented here as
-    /// replies from the server.
+    /// This function wipes cached ACK and Reply packets from the storages.
+    /// The number of packets left in the storages after the call
+    /// to this function should guarantee that the Renew, Rebind, Release,
+    /// Decline and reboot messages can be sent at the given rates. Note that
+    /// these messages are generated for the existing leases, represented
+    /// here as responses from the server.
     /// @todo Instead of cleaning packets periodically we could
     /// just stop adding new packets when the certain threshold
     /// has been reached.
     void cleanCachedPackets();
 
+    /// \brief Creates DHCPv4 message from the ACK packet.
+    ///
+    /// This function creates the DHCPv4 message sent by a client for the
+    /// lease it has acquired, using the data from the ACK message:
+    /// - a renewing or rebinding DHCPREQUEST carries the leased address in
+    /// ciaddr,
+    /// - an init-reboot DHCPREQUEST carries it in the requested IP address
+    /// option,
+    /// - a DHCPRELEASE carries it in ciaddr, along with the server
+    /// identifier,
+    /// - a DHCPDECLINE carries it in the requested IP address option, along
+    /// with the server identifier.
+    ///
+    /// \param msg A type of the message to be created.
+    /// \param ack An instance of the ACK packet which contents should
+    /// be used to create an instance of the new message.
+    ///
+    /// \return created message
+    /// \throw bundy::BadValue if the ack is NULL.
+    /// \throw bundy::Unexpected if the ACK carries no address or, for
+    /// DHCPRELEASE and DHCPDECLINE, no server identifier.
+    dhcp::Pkt4Ptr createMessageFromAck(const LeaseMessage msg,
+                                       const dhcp::Pkt4Ptr& ack);
+
     /// \brief Creates DHCPv6 message from the Reply packet.
     ///
-    /// This function creates DHCPv6 Renew or Release message using the
-    /// data from the Reply message by copying options from the Reply
-    /// message.
+    /// This function creates DHCPv6 Renew, Rebind, Release, Decline or
+    /// Confirm message using the data from the Reply message by copying
+    /// options from the Reply message.  Rebind and Confirm, which may be
+    /// answered by any server, carry no server identifier.
     ///
     /// \param msg_type A type of the message to be createad.
     /// \param reply An instance of the Reply packet which contents should
     /// be used to create an instance of the new message.
     ///
-    /// \return created Release or Renew message
-    /// \throw bundy::BadValue if the msg_type is neither DHCPV6_RENEW nor
-    /// DHCPV6_RELEASE or if the reply is NULL.
+    /// \return created message
+    /// \throw bundy::BadValue if the msg_type is not one of DHCPV6_RENEW,
+    /// DHCPV6_REBIND, DHCPV6_RELEASE, DHCPV6_DECLINE and DHCPV6_CONFIRM
+    /// or if the reply is NULL.
     /// \throw bundy::Unexpected if mandatory options are missing in the
     /// Reply message.
     dhcp::Pkt6Ptr createMessageFromReply(const uint16_t msg_type,
@@ -492,6 +574,27 @@ protected:
     /// \return A current timeout in microseconds.
     uint32_t getCurrentTimeout() const;
 
+    /// \brief Returns the rate control of a message sent for a lease.
+    ///
+    /// \param msg A type of the message.
+    /// \return the rate control of the messages of this type.
+    RateControl& getLeaseRateControl(const LeaseMessage msg);
+
+    /// \brief Returns the rate control of a message sent for a lease.
+    ///
+    /// \param msg A type of the message.
+    /// \return the rate control of the messages of this type.
+    const RateControl& getLeaseRateControl(const LeaseMessage msg) const;
+
+    /// \brief Returns the sum of the rates of the messages sent for the
+    /// leases.
+    ///
+    /// The server's responses assigning the leases are cached when it
+    /// isn't zero.
+    ///
+    /// \return number of messages sent per second for the leases.
+    int getLeaseMessagesRate() const;
+
     /// \brief Return template buffer.
     ///
     /// Method returns template buffer at specified index.
@@ -539,6 +642,22 @@ protected:
     /// \return socket descriptor.
     int openSocket() const;
 
+    /// \brief Open the socket of a generator.
+    ///
+    /// Opens an UDP socket bound to the address of the main socket and to
+    /// an ephemeral port, through which a generator sends its messages.
+    /// The socket is not registered in IfaceMgr: the server's responses
+    /// are received through the main socket.  The broadcast and multicast
+    /// options are set as for the main socket, see \ref openSocket.
+    ///
+    /// \param socket the main socket.
+    ///
+    /// \throw bundy::BadValue if the socket can't be opened.
+    /// \throw bundy::InvalidOperation if broadcast or multicast option
+    /// can't be set.
+    /// \return socket descriptor.
+    int openGeneratorSocket(const TestControlSocket& socket) const;
+
     /// \brief Print intermediate statistics.
     ///
     /// Print brief statistics regarding number of sent packets,
@@ -607,6 +726,49 @@ protected:
     /// \return number of received packets.
     uint64_t receivePackets(const TestControlSocket& socket);
 
+    /// \brief Receive a DHCPv4 packet.
+    ///
+    /// A generator takes the packets handed over by the main thread,
+    /// otherwise the packets are received from IfaceMgr.
+    ///
+    /// \param timeout the time to wait for a packet, in microseconds.
+    /// \return the packet received, or NULL if none was received.
+    dhcp::Pkt4Ptr receive4(const uint32_t timeout);
+
+    /// \brief Receive a DHCPv6 packet.
+    ///
+    /// A generator takes the packets handed over by the main thread,
+    /// otherwise the packets are received from IfaceMgr.
+    ///
+    /// \param timeout the time to wait for a packet, in microseconds.
+    /// \return the packet received, or NULL if none was received.
+    dhcp::Pkt6Ptr receive6(const uint32_t timeout);
+
+    /// \brief Hand a DHCPv4 packet over to a generator.
+    ///
+    /// This method is called from the main thread.
+    ///
+    /// \param pkt the packet received from the server.
+    void pushPacket(const dhcp::Pkt4Ptr& pkt);
+
+    /// \brief Hand a DHCPv6 packet over to a generator.
+    ///
+    /// This method is called from the main thread.
+    ///
+    /// \param pkt the packet received from the server.
+    void pushPacket(const dhcp::Pkt6Ptr& pkt);
+
+    /// \brief Stop a generator.
+    ///
+    /// The generator leaves its main loop when it next checks the exit
+    /// conditions.  This method is called from the main thread.
+    void stop();
+
+    /// \brief Check if a generator has been stopped.
+    ///
+    /// \return true if \ref stop has been called.
+    bool isStopping();
+
     /// \brief Register option factory functions for DHCPv4
     ///
     /// Method registers option factory functions for DHCPv4.
@@ -638,6 +800,36 @@ protected:
     /// called before new test is started.
     void reset();
 
+    /// \brief Run the main loop.
+    ///
+    /// Sends the messages at the given rates and processes the server's
+    /// responses until an exit condition is fulfilled.  This method is
+    /// run by the main thread, or by each generator thread, see
+    /// \ref runGenerators.
+    ///
+    /// \param socket socket to be used.
+    void runGenerator(const TestControlSocket& socket);
+
+    /// \brief Run the main loop in the generator threads.
+    ///
+    /// Starts one generator per thread requested with -g<threads>, and
+    /// hands each response received from the server over to the generator
+    /// which owns its transaction id, until an exit condition is fulfilled.
+    /// The generators are then stopped and waited for.
+    ///
+    /// \param socket the main socket.
+    /// \throw bundy::Unexpected if a generator thread failed.
+    void runGenerators(const TestControlSocket& socket);
+
+    /// \brief Sets the rates of the messages.
+    ///
+    /// The rates given in the command line are split evenly between the
+    /// generators.
+    ///
+    /// \param threads_num number of generators.
+    /// \param thread_index index of the generator.
+    void setRateControls(const int threads_num, const int thread_index);
+
     /// \brief Save the first DHCPv4 sent packet of the specified type.
     ///
     /// This method saves first packet of the specified being sent
@@ -746,14 +938,49 @@ protected:
                                    const uint32_t msg_type,
                                    const uint64_t msg_num);
 
-    /// \brief Send DHCPv6 Renew or Release message using specified socket.
+    /// \brief Send number of DHCPv4 messages for the existing leases.
+    ///
+    /// \param socket An object representing socket to be used to send packets.
+    /// \param msg A type of the messages to be sent.
+    /// \param msg_num A number of messages to be sent.
+    ///
+    /// \return A number of messages actually sent.
+    uint64_t sendMultipleMessages4(const TestControlSocket& socket,
+                                   const LeaseMessage msg,
+                                   const uint64_t msg_num);
+
+    /// \brief Send the messages due for the existing leases.
+    ///
+    /// Sends as many messages of each type as required to catch up with
+    /// the rates given by -f, -j, -K, -F and -k.
+    ///
+    /// \param socket An object representing socket to be used to send packets.
+    void sendLeaseMessages(const TestControlSocket& socket);
+
+    /// \brief Send DHCPv4 message for an existing lease.
+    ///
+    /// This method will select an existing lease from the ACK packet cache.
+    /// If there is no lease for which the message can be sent this method
+    /// will return false.  As DHCPRELEASE and DHCPDECLINE are not answered
+    /// by the server, they are only counted.
+    ///
+    /// \param msg A type of the message to be sent.
+    /// \param socket An object encapsulating socket to be used to send
+    /// a packet.
+    ///
+    /// \return true if the message has been sent, false otherwise.
+    bool sendMessageFromAck(const LeaseMessage msg,
+                            const TestControlSocket& socket);
+
+    /// \brief Send DHCPv6 message for an existing lease using specified
+    /// socket.
     ///
     /// This method will select an existing lease from the Reply packet cache
-    /// If there is no lease that can be renewed or released this method will
-    /// return false.
+    /// If there is no lease for which the message can be sent this method
+    /// will return false.
     ///
-    /// \param msg_type A type of the message to be sent (DHCPV6_RENEW or
-    /// DHCPV6_RELEASE).
+    /// \param msg_type A type of the message to be sent (DHCPV6_RENEW,
+    /// DHCPV6_REBIND, DHCPV6_RELEASE, DHCPV6_DECLINE or DHCPV6_CONFIRM).
     /// \param socket An object encapsulating socket to be used to send
     /// a packet.
     ///
@@ -866,6 +1093,24 @@ protected:
                       const std::vector<uint8_t>& template_buf,
                       const bool preload = false);
 
+    /// \brief Send a DHCPv4 packet to the server.
+    ///
+    /// A generator sends the packet through its own socket, otherwise the
+    /// packet is sent with IfaceMgr.
+    ///
+    /// \param pkt the packet, packed.
+    /// \throw bundy::dhcp::SocketWriteError if failed to send the packet.
+    void sendToServer(const dhcp::Pkt4Ptr& pkt);
+
+    /// \brief Send a DHCPv6 packet to the server.
+    ///
+    /// A generator sends the packet through its own socket, otherwise the
+    /// packet is sent with IfaceMgr.
+    ///
+    /// \param pkt the packet, packed.
+    /// \throw bundy::dhcp::SocketWriteError if failed to send the packet.
+    void sendToServer(const dhcp::Pkt6Ptr& pkt);
+
     /// \brief Set default DHCPv4 packet parameters.
     ///
     /// This method sets default parameters on the DHCPv4 packet:
@@ -898,7 +1143,7 @@ protected:
 
     /// \brief Find if diagnostic flag has been set.
     ///
-    /// \param diag diagnostic flag (a,e,i,s,r,t,T).
+    /// \param diag diagnostic flag (a,e,h,i,s,r,t,T).
     /// \return true if diagnostics flag has been set.
     bool testDiags(const char diag) const;
 
@@ -1067,13 +1312,21 @@ protected:
     RateControl renew_rate_control_;
     /// \brief A rate control class for Release messages.
     RateControl release_rate_control_;
+    /// \brief A rate control class for Rebind messages.
+    RateControl rebind_rate_control_;
+    /// \brief A rate control class for Decline messages.
+    RateControl decline_rate_control_;
+    /// \brief A rate control class for the messages sent after a reboot.
+    RateControl reboot_rate_control_;
 
     boost::posix_time::ptime last_report_; ///< Last intermediate report time.
+    boost::posix_time::ptime last_clean_;  ///< Last cleanup of the caches.
 
     StatsMgr4Ptr stats_mgr4_;  ///< Statistics Manager 4.
     StatsMgr6Ptr stats_mgr6_;  ///< Statistics Manager 6.
 
     PacketStorage<dhcp::Pkt6> reply_storage_; ///< A storage for reply messages.
+    PacketStorage<dhcp::Pkt4> ack_storage_;   ///< A storage for ACK messages.
 
     NumberGeneratorPtr transid_gen_; ///< Transaction id generator.
     NumberGeneratorPtr macaddr_gen_; ///< Numbers generator for MAC address.
@@ -1090,6 +1343,27 @@ protected:
     std::map<uint8_t, dhcp::Pkt6Ptr> template_packets_v6_;
 
     static bool interrupted_;  ///< Is program interrupted.
+
+    /// \name Generator threads.
+    //@{
+    /// Pointer to a generator.
+    typedef boost::shared_ptr<TestControl> TestControlPtr;
+
+    bool generator_;      ///< Is this instance a generator.
+    int thread_index_;    ///< Index of the generator.
+    int send_socket_;     ///< Socket of the generator, -1 if none.
+
+    /// Protects the packets handed over to the generator.
+    util::thread::Mutex queue_mutex_;
+    /// Signaled when a packet is handed over, or the generator is stopped.
+    util::thread::CondVar queue_cond_;
+    std::list<dhcp::Pkt4Ptr> queue4_;   ///< DHCPv4 packets handed over.
+    std::list<dhcp::Pkt6Ptr> queue6_;   ///< DHCPv6 packets handed over.
+    bool stopping_;       ///< Has the generator been stopped.
+
+    /// Generators run by the main thread.
+    std::vector<TestControlPtr> generators_;
+    //@}
 };
 
 } // namespace perfdhcp
@@ -170,6 +170,10 @@ protected:
         EXPECT_EQ(0, opt.getRate());
         EXPECT_EQ(0, opt.getRenewRate());
         EXPECT_EQ(0, opt.getReleaseRate());
+        EXPECT_EQ(0, opt.getRebindRate());
+        EXPECT_EQ(0, opt.getDeclineRate());
+        EXPECT_EQ(0, opt.getRebootRate());
+        EXPECT_EQ(1, opt.getThreadsNum());
         EXPECT_EQ(0, opt.getReportDelay());
         EXPECT_EQ(0, opt.getClientsNum());
 
@@ -360,10 +364,9 @@ TEST_F(CommandOptionsTest, RenewRate) {
     // be accepted.
     EXPECT_THROW(process("perfdhcp -6 -f 10 -l ethx all"),
                  bundy::InvalidParameter);
-    // Currently the -f<renew-rate> can be specified for IPv6 mode
-    // only.
-    EXPECT_THROW(process("perfdhcp -4 -r 10 -f 10 -l ethx all"),
-                 bundy::InvalidParameter);
+    // The -f<renew-rate> can be specified for IPv4 mode too.
+    EXPECT_NO_THROW(process("perfdhcp -4 -r 10 -f 10 -l ethx all"));
+    EXPECT_EQ(10, opt.getRenewRate());
     // Renew rate should be specified.
     EXPECT_THROW(process("perfdhcp -6 -r 10 -f -l ethx all"),
                  bundy::InvalidParameter);
@@ -397,10 +400,9 @@ TEST_F(CommandOptionsTest, ReleaseRate) {
     // be accepted.
     EXPECT_THROW(process("perfdhcp -6 -F 10 -l ethx all"),
                  bundy::InvalidParameter);
-    // Currently the -F<release-rate> can be specified for IPv6 mode
-    // only.
-    EXPECT_THROW(process("perfdhcp -4 -r 10 -F 10 -l ethx all"),
-                 bundy::InvalidParameter);
+    // The -F<release-rate> can be specified for IPv4 mode too.
+    EXPECT_NO_THROW(process("perfdhcp -4 -r 10 -F 10 -l ethx all"));
+    EXPECT_EQ(10, opt.getReleaseRate());
     // Release rate should be specified.
     EXPECT_THROW(process("perfdhcp -6 -r 10 -F -l ethx all"),
                  bundy::InvalidParameter);
@@ -429,6 +431,71 @@ TEST_F(CommandOptionsTest, ReleaseRenew) {
                  bundy::InvalidParameter);
 }
 
+TEST_F(CommandOptionsTest, LeaseRates) {
+    CommandOptions& opt = CommandOptions::instance();
+    // The rebind, decline and reboot rates are set along with -r.
+    EXPECT_NO_THROW(process("perfdhcp -4 -r 20 -j 3 -k 4 -K 5 -l ethx all"));
+    EXPECT_EQ(3, opt.getRebindRate());
+    EXPECT_EQ(4, opt.getDeclineRate());
+    EXPECT_EQ(5, opt.getRebootRate());
+    EXPECT_EQ(12, opt.getLeaseMessagesRate());
+    EXPECT_NO_THROW(process("perfdhcp -6 -r 20 -j 3 -k 4 -K 5 -l ethx all"));
+    EXPECT_EQ(12, opt.getLeaseMessagesRate());
+    // All the messages sent for the leases count against the rate.
+    EXPECT_NO_THROW(process("perfdhcp -6 -r 20 -f 4 -F 4 -j 4 -k 4 -K 4"
+                            " -l ethx all"));
+    EXPECT_EQ(20, opt.getLeaseMessagesRate());
+    EXPECT_THROW(process("perfdhcp -6 -r 20 -f 4 -F 4 -j 4 -k 4 -K 5"
+                         " -l ethx all"), bundy::InvalidParameter);
+    // The rates must be positive.
+    EXPECT_THROW(process("perfdhcp -r 10 -j 0 -l ethx all"),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(process("perfdhcp -r 10 -k -1 -l ethx all"),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(process("perfdhcp -r 10 -K 0 -l ethx all"),
+                 bundy::InvalidParameter);
+    // They require -r<rate>.
+    EXPECT_THROW(process("perfdhcp -j 10 -l ethx all"),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(process("perfdhcp -k 10 -l ethx all"),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(process("perfdhcp -K 10 -l ethx all"),
+                 bundy::InvalidParameter);
+    // And are not compatible with -i.
+    EXPECT_THROW(process("perfdhcp -r 10 -j 5 -i -l ethx all"),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(process("perfdhcp -r 10 -k 5 -i -l ethx all"),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(process("perfdhcp -r 10 -K 5 -i -l ethx all"),
+                 bundy::InvalidParameter);
+}
+
+TEST_F(CommandOptionsTest, Threads) {
+    CommandOptions& opt = CommandOptions::instance();
+    EXPECT_NO_THROW(process("perfdhcp -g 4 -r 100 -R 10 -l ethx all"));
+    EXPECT_EQ(4, opt.getThreadsNum());
+    EXPECT_NO_THROW(process("perfdhcp -6 -g 2 -r 10 -R 2 -f 2 -l ethx all"));
+    EXPECT_EQ(2, opt.getThreadsNum());
+
+    // The number of threads must be positive.
+    EXPECT_THROW(process("perfdhcp -g 0 -r 10 -l ethx all"),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(process("perfdhcp -g -2 -r 10 -l ethx all"),
+                 bundy::InvalidParameter);
+    // Each thread needs a share of the rate and of the clients.
+    EXPECT_THROW(process("perfdhcp -g 4 -l ethx all"),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(process("perfdhcp -g 4 -r 3 -R 10 -l ethx all"),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(process("perfdhcp -g 4 -r 100 -R 3 -l ethx all"),
+                 bundy::InvalidParameter);
+    // And of each rate of the messages sent for the leases.
+    EXPECT_THROW(process("perfdhcp -g 4 -r 100 -R 10 -f 3 -l ethx all"),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(process("perfdhcp -g 4 -r 100 -R 10 -K 2 -l ethx all"),
+                 bundy::InvalidParameter);
+}
+
 TEST_F(CommandOptionsTest, ReportDelay) {
     CommandOptions& opt = CommandOptions::instance();
     EXPECT_NO_THROW(process("perfdhcp -r 100 -t 17 -l ethx all"));
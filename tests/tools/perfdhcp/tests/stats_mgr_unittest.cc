@@ -269,6 +269,10 @@ TEST_F(StatsMgrTest, ExchangeToString) {
     EXPECT_EQ("DISCOVER-OFFER",
               StatsMgr4::exchangeToString(StatsMgr4::XCHG_DO));
     EXPECT_EQ("REQUEST-ACK", StatsMgr4::exchangeToString(StatsMgr4::XCHG_RA));
+    EXPECT_EQ("RENEW-ACK", StatsMgr4::exchangeToString(StatsMgr4::XCHG_RNA));
+    EXPECT_EQ("REBIND-ACK", StatsMgr4::exchangeToString(StatsMgr4::XCHG_RBA));
+    EXPECT_EQ("INIT-REBOOT-ACK",
+              StatsMgr4::exchangeToString(StatsMgr4::XCHG_IRA));
 
     // Test DHCPv6 specific exchange names.
     EXPECT_EQ("SOLICIT-ADVERTISE",
@@ -276,6 +280,9 @@ TEST_F(StatsMgrTest, ExchangeToString) {
     EXPECT_EQ("REQUEST-REPLY", StatsMgr6::exchangeToString(StatsMgr6::XCHG_RR));
     EXPECT_EQ("RENEW-REPLY", StatsMgr6::exchangeToString(StatsMgr6::XCHG_RN));
     EXPECT_EQ("RELEASE-REPLY", StatsMgr6::exchangeToString(StatsMgr6::XCHG_RL));
+    EXPECT_EQ("REBIND-REPLY", StatsMgr6::exchangeToString(StatsMgr6::XCHG_RB));
+    EXPECT_EQ("DECLINE-REPLY", StatsMgr6::exchangeToString(StatsMgr6::XCHG_DC));
+    EXPECT_EQ("CONFIRM-REPLY", StatsMgr6::exchangeToString(StatsMgr6::XCHG_CN));
 
 }
 
@@ -395,6 +402,69 @@ TEST_F(StatsMgrTest, Delays) {
     EXPECT_GT(stats_mgr->getStdDevDelay(StatsMgr4::XCHG_DO), 0);
 }
 
+TEST_F(StatsMgrTest, DelayHistogramBuckets) {
+    typedef StatsMgr4::ExchangeStats ExchangeStats;
+    // The buckets are contiguous and the delays fall into the bucket
+    // which bounds them.
+    EXPECT_EQ(0, ExchangeStats::bucketToDelay(0));
+    for (size_t bucket = 0; bucket < ExchangeStats::HISTOGRAM_BUCKETS - 1;
+         ++bucket) {
+        const uint64_t low = ExchangeStats::bucketToDelay(bucket);
+        const uint64_t high = ExchangeStats::bucketToDelay(bucket + 1);
+        ASSERT_LT(low, high);
+        EXPECT_EQ(bucket, ExchangeStats::delayToBucket(low));
+        EXPECT_EQ(bucket, ExchangeStats::delayToBucket(high - 1));
+    }
+    // The precision is 1/8 of the delay.
+    EXPECT_EQ(ExchangeStats::delayToBucket(1024),
+              ExchangeStats::delayToBucket(1100));
+    EXPECT_NE(ExchangeStats::delayToBucket(1024),
+              ExchangeStats::delayToBucket(1200));
+    // The delays which are too long go to the last bucket.
+    EXPECT_EQ(ExchangeStats::HISTOGRAM_BUCKETS - 1,
+              ExchangeStats::delayToBucket(0xFFFFFFFFFFFFFFFFull));
+}
+
+TEST_F(StatsMgrTest, DelayPercentiles) {
+    boost::shared_ptr<StatsMgr6> stats_mgr(new StatsMgr6());
+    stats_mgr->addExchangeStats(StatsMgr6::XCHG_SA);
+
+    // There is no percentile before the first response.
+    EXPECT_THROW(stats_mgr->getDelayPercentile(StatsMgr6::XCHG_SA, 50),
+                 bundy::InvalidOperation);
+
+    const int packets_num = 100;
+    passMultiplePackets6(stats_mgr, StatsMgr6::XCHG_SA, DHCPV6_SOLICIT,
+                         packets_num);
+    passMultiplePackets6(stats_mgr, StatsMgr6::XCHG_SA, DHCPV6_ADVERTISE,
+                         packets_num, true);
+    ASSERT_EQ(packets_num, stats_mgr->getRcvdPacketsNum(StatsMgr6::XCHG_SA));
+
+    // The percentiles are ordered and lie between the minimum and the
+    // maximum delay.
+    const double min_delay = stats_mgr->getMinDelay(StatsMgr6::XCHG_SA);
+    const double max_delay = stats_mgr->getMaxDelay(StatsMgr6::XCHG_SA);
+    double median = 0;
+    double p99 = 0;
+    ASSERT_NO_THROW(median =
+                    stats_mgr->getDelayPercentile(StatsMgr6::XCHG_SA, 50));
+    ASSERT_NO_THROW(p99 =
+                    stats_mgr->getDelayPercentile(StatsMgr6::XCHG_SA, 99));
+    EXPECT_LE(min_delay, median);
+    EXPECT_LE(median, p99);
+    EXPECT_LE(p99, max_delay);
+    EXPECT_DOUBLE_EQ(max_delay,
+                     stats_mgr->getDelayPercentile(StatsMgr6::XCHG_SA, 100));
+
+    // The percentile must be within (0, 100].
+    EXPECT_THROW(stats_mgr->getDelayPercentile(StatsMgr6::XCHG_SA, 0),
+                 bundy::BadValue);
+    EXPECT_THROW(stats_mgr->getDelayPercentile(StatsMgr6::XCHG_SA, 100.5),
+                 bundy::BadValue);
+
+    EXPECT_NO_THROW(stats_mgr->printDelayHistograms());
+}
+
 TEST_F(StatsMgrTest, CustomCounters) {
     boost::scoped_ptr<StatsMgr4> stats_mgr(new StatsMgr4());
 
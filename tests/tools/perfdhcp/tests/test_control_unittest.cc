@@ -99,6 +99,7 @@ public:
     }
 
     using TestControl::checkExitConditions;
+    using TestControl::createMessageFromAck;
     using TestControl::createMessageFromReply;
     using TestControl::factoryElapsedTime6;
     using TestControl::factoryGeneric;
@@ -112,26 +113,37 @@ public:
     using TestControl::getTemplateBuffer;
     using TestControl::initPacketTemplates;
     using TestControl::initializeStatsMgr;
+    using TestControl::isStopping;
+    using TestControl::openGeneratorSocket;
     using TestControl::openSocket;
     using TestControl::processReceivedPacket4;
     using TestControl::processReceivedPacket6;
+    using TestControl::pushPacket;
+    using TestControl::receive4;
     using TestControl::registerOptionFactories;
     using TestControl::reset;
     using TestControl::sendDiscover4;
     using TestControl::sendPackets;
+    using TestControl::sendMultipleMessages4;
     using TestControl::sendMultipleMessages6;
     using TestControl::sendRequest6;
     using TestControl::sendSolicit6;
     using TestControl::setDefaults4;
     using TestControl::setDefaults6;
+    using TestControl::stop;
     using TestControl::basic_rate_control_;
     using TestControl::renew_rate_control_;
     using TestControl::release_rate_control_;
+    using TestControl::rebind_rate_control_;
+    using TestControl::decline_rate_control_;
+    using TestControl::reboot_rate_control_;
     using TestControl::last_report_;
     using TestControl::transid_gen_;
     using TestControl::macaddr_gen_;
     using TestControl::first_packet_serverid_;
     using TestControl::interrupted_;
+    using TestControl::stats_mgr4_;
+    using TestControl::send_socket_;
 
     NakedTestControl() : TestControl() {
         uint32_t clients_num = CommandOptions::instance().getClientsNum() == 0 ?
@@ -139,6 +151,12 @@ public:
         setMacAddrGenerator(NumberGeneratorPtr(new TestControl::SequentialGenerator(clients_num)));
     };
 
+    /// \brief Constructor of a generator.
+    ///
+    /// \param thread_index index of the generator.
+    NakedTestControl(const int thread_index) : TestControl(thread_index) {
+    }
+
 };
 
 /// \brief Test Fixture Class
@@ -659,17 +677,37 @@ public:
         }
     }
 
-    /// \brief Test that the DHCPv4 Release or Renew message is created
-    /// correctly and comprises expected options.
+    /// \brief Return the command line option setting the rate of a message
+    /// sent for the leases.
+    ///
+    /// \param msg_type A type of the DHCPv6 message.
+    std::string leaseRateOption6(const uint16_t msg_type) const {
+        switch (msg_type) {
+        case DHCPV6_RENEW:
+            return ("-f");
+        case DHCPV6_REBIND:
+            return ("-j");
+        case DHCPV6_RELEASE:
+            return ("-F");
+        case DHCPV6_DECLINE:
+            return ("-k");
+        default:
+            ;
+        }
+        return ("-K");
+    }
+
+    /// \brief Test that the DHCPv6 Renew, Rebind, Release, Decline or
+    /// Confirm message is created correctly and comprises expected options.
     ///
-    /// \param msg_type A type of the message to be tested: DHCPV6_RELEASE
-    /// or DHCPV6_RENEW.
+    /// \param msg_type A type of the message to be tested: DHCPV6_RENEW,
+    /// DHCPV6_REBIND, DHCPV6_RELEASE, DHCPV6_DECLINE or DHCPV6_CONFIRM.
     void testCreateRenewRelease(const uint16_t msg_type) {
-        // This command line specifies that the Release/Renew messages should
-        // be sent with the same rate as the Solicit messages.
+        // This command line specifies that the messages should be sent with
+        // the same rate as the Solicit messages.
         std::ostringstream s;
         s << "perfdhcp -6 -l lo -r 10 ";
-        s << (msg_type == DHCPV6_RELEASE ? "-F" : "-f") << " 10 ";
+        s << leaseRateOption6(msg_type) << " 10 ";
         s << "-R 10 -L 10547 -n 10 -e address-and-prefix ::1";
         ASSERT_NO_THROW(processCmdLine(s.str()));
         // Create a test controller class.
@@ -702,11 +740,16 @@ public:
         EXPECT_TRUE(reply->getOption(D6O_CLIENTID)->getData() ==
                     opt_clientid->getData());
 
-        // Server identifier
+        // Server identifier, except in Rebind and Confirm which are sent to
+        // any server.
         OptionPtr opt_serverid = msg->getOption(D6O_SERVERID);
-        ASSERT_TRUE(opt_serverid);
-        EXPECT_TRUE(reply->getOption(D6O_SERVERID)->getData() ==
-                opt_serverid->getData());
+        if ((msg_type == DHCPV6_REBIND) || (msg_type == DHCPV6_CONFIRM)) {
+            EXPECT_FALSE(opt_serverid);
+        } else {
+            ASSERT_TRUE(opt_serverid);
+            EXPECT_TRUE(reply->getOption(D6O_SERVERID)->getData() ==
+                        opt_serverid->getData());
+        }
 
         // IA_NA
         OptionPtr opt_ia_na = msg->getOption(D6O_IA_NA);
@@ -820,6 +863,148 @@ public:
 
     }
 
+    /// \brief Test that the DHCPv4 message sent for a lease is created
+    /// correctly and comprises expected fields and options.
+    ///
+    /// \param msg A type of the message to be tested.
+    void testCreateFromAck(const TestControl::LeaseMessage msg) {
+        ASSERT_NO_THROW(processCmdLine("perfdhcp -4 -l lo -r 10 -f 5 -F 5"
+                                       " 127.0.0.1"));
+        NakedTestControl tc;
+        boost::shared_ptr<NakedTestControl::IncrementalGenerator>
+            generator(new NakedTestControl::IncrementalGenerator());
+        tc.setTransidGenerator(generator);
+
+        Pkt4Ptr ack = createAckPkt4(1);
+        Pkt4Ptr pkt4;
+        ASSERT_NO_THROW(pkt4 = tc.createMessageFromAck(msg, ack));
+        ASSERT_TRUE(pkt4);
+        EXPECT_EQ(1, pkt4->getTransid());
+        ASSERT_TRUE(pkt4->getHWAddr());
+        EXPECT_TRUE(ack->getHWAddr()->hwaddr_ == pkt4->getHWAddr()->hwaddr_);
+
+        // The leased address is in ciaddr or in the requested address option.
+        OptionPtr opt_requested = pkt4->getOption(DHO_DHCP_REQUESTED_ADDRESS);
+        if ((msg == TestControl::LEASE_RENEW) ||
+            (msg == TestControl::LEASE_REBIND) ||
+            (msg == TestControl::LEASE_RELEASE)) {
+            EXPECT_EQ("192.0.2.10", pkt4->getCiaddr().toText());
+            EXPECT_FALSE(opt_requested);
+        } else {
+            EXPECT_EQ("0.0.0.0", pkt4->getCiaddr().toText());
+            ASSERT_TRUE(opt_requested);
+            EXPECT_EQ(static_cast<uint32_t>(ack->getYiaddr()),
+                      opt_requested->getUint32());
+        }
+
+        // DHCPRELEASE and DHCPDECLINE are sent to the server which assigned
+        // the lease.  DHCPREQUEST asks for the configuration parameters.
+        OptionPtr opt_serverid = pkt4->getOption(DHO_DHCP_SERVER_IDENTIFIER);
+        OptionPtr opt_prl = pkt4->getOption(DHO_DHCP_PARAMETER_REQUEST_LIST);
+        if ((msg == TestControl::LEASE_RELEASE) ||
+            (msg == TestControl::LEASE_DECLINE)) {
+            EXPECT_EQ(msg == TestControl::LEASE_RELEASE ? DHCPRELEASE :
+                      DHCPDECLINE, pkt4->getType());
+            ASSERT_TRUE(opt_serverid);
+            EXPECT_TRUE(ack->getOption(DHO_DHCP_SERVER_IDENTIFIER)->getData()
+                        == opt_serverid->getData());
+            EXPECT_FALSE(opt_prl);
+
+            // The server identifier is mandatory.
+            ack->delOption(DHO_DHCP_SERVER_IDENTIFIER);
+            EXPECT_THROW(tc.createMessageFromAck(msg, ack), bundy::Unexpected);
+        } else {
+            EXPECT_EQ(DHCPREQUEST, pkt4->getType());
+            EXPECT_FALSE(opt_serverid);
+            EXPECT_TRUE(opt_prl);
+        }
+
+        // The ACK must carry an address.
+        ack = createAckPkt4(2);
+        ack->setYiaddr(asiolink::IOAddress("0.0.0.0"));
+        EXPECT_THROW(tc.createMessageFromAck(msg, ack), bundy::Unexpected);
+
+        // Make sure that exception is thrown if the ACK message is NULL.
+        EXPECT_THROW(tc.createMessageFromAck(msg, Pkt4Ptr()),
+                     bundy::BadValue);
+    }
+
+    /// \brief Test sending DHCPv4 messages for the existing leases.
+    ///
+    /// This function simulates acquiring 10 leases from the server. Returned
+    /// ACK messages are cached and used to send the messages.  A lease
+    /// which is released or declined is gone, so the number of these
+    /// messages is limited to the number of leases acquired.
+    ///
+    /// \param msg A type of the message which is simulated to be sent.
+    void testSendFromAck(const TestControl::LeaseMessage msg) {
+        std::string loopback_iface(getLocalLoopback());
+        if (loopback_iface.empty()) {
+            std::cout << "Skipping the test because loopback interface could"
+                " not be detected" << std::endl;
+            return;
+        }
+        const char* rate_options[] = { "-f", "-j", "-K", "-F", "-k" };
+        std::ostringstream s;
+        s << "perfdhcp -4 -l " << loopback_iface << " -r 10 "
+          << rate_options[msg] << " 10 -R 10 -L 10547 -n 10 127.0.0.1";
+        ASSERT_NO_THROW(processCmdLine(s.str()));
+        NakedTestControl tc;
+        tc.initializeStatsMgr();
+        boost::shared_ptr<NakedTestControl::IncrementalGenerator>
+            generator(new NakedTestControl::IncrementalGenerator());
+        tc.setTransidGenerator(generator);
+        int sock_handle = 0;
+        ASSERT_NO_THROW(sock_handle = tc.openSocket());
+        TestControl::TestControlSocket sock(sock_handle);
+
+        // Send 10 DHCPDISCOVERs with the transaction ids 1 to 10, and
+        // simulate the DHCPOFFERs triggering the DHCPREQUESTs with the
+        // transaction ids 11 to 20.
+        tc.sendPackets(sock, 10);
+        for (int i = generator->getNext() - 10; i < generator->getNext(); ++i) {
+            ASSERT_NO_THROW(tc.processReceivedPacket4(sock,
+                                                      createOfferPkt4(i)));
+        }
+        // The DHCPACKs are held so as the messages can be sent for the
+        // leases.
+        for (int i = generator->getNext() - 10; i < generator->getNext(); ++i) {
+            ASSERT_NO_THROW(tc.processReceivedPacket4(sock,
+                                                      createAckPkt4(i)));
+        }
+
+        uint64_t msg_num = 0;
+        ASSERT_NO_THROW(msg_num = tc.sendMultipleMessages4(sock, msg, 5));
+        EXPECT_EQ(5, msg_num);
+        ASSERT_NO_THROW(msg_num = tc.sendMultipleMessages4(sock, msg, 5));
+        EXPECT_EQ(5, msg_num);
+        // All the leases have been used.
+        ASSERT_NO_THROW(msg_num = tc.sendMultipleMessages4(sock, msg, 5));
+        EXPECT_EQ(0, msg_num);
+
+        if (msg == TestControl::LEASE_RELEASE) {
+            EXPECT_EQ(10, tc.stats_mgr4_->getCounter("sentrelease")->getValue());
+            return;
+        } else if (msg == TestControl::LEASE_DECLINE) {
+            EXPECT_EQ(10, tc.stats_mgr4_->getCounter("sentdecline")->getValue());
+            return;
+        }
+
+        // A lease for which a DHCPACK is received is kept.
+        typedef TestControl::StatsMgr4 StatsMgr4;
+        const StatsMgr4::ExchangeType xchg_type =
+            (msg == TestControl::LEASE_RENEW ? StatsMgr4::XCHG_RNA :
+             (msg == TestControl::LEASE_REBIND ? StatsMgr4::XCHG_RBA :
+              StatsMgr4::XCHG_IRA));
+        EXPECT_EQ(10, tc.stats_mgr4_->getSentPacketsNum(xchg_type));
+        ASSERT_NO_THROW(tc.processReceivedPacket4(sock,
+                                                  createAckPkt4(generator->
+                                                                getNext() - 1)));
+        EXPECT_EQ(1, tc.stats_mgr4_->getRcvdPacketsNum(xchg_type));
+        ASSERT_NO_THROW(msg_num = tc.sendMultipleMessages4(sock, msg, 5));
+        EXPECT_EQ(1, msg_num);
+    }
+
     /// \brief Parse command line string with CommandOptions.
     ///
     /// \param cmdline command line string to be parsed.
@@ -845,6 +1030,25 @@ public:
         return (offer);
     }
 
+    /// \brief Create DHCPv4 ACK packet.
+    ///
+    /// \param transid transaction id.
+    /// \return instance of the packet.
+    Pkt4Ptr
+    createAckPkt4(const uint32_t transid) const {
+        Pkt4Ptr ack(new Pkt4(DHCPACK, transid));
+        OptionPtr opt_serverid = Option::factory(Option::V4,
+                                                 DHO_DHCP_SERVER_IDENTIFIER,
+                                                 OptionBuffer(4, 1));
+        ack->setYiaddr(asiolink::IOAddress("192.0.2.10"));
+        ack->addOption(opt_serverid);
+        const uint8_t mac[] = { 0x00, 0x0C, 0x01, 0x02, 0x03, 0x05 };
+        ack->setHWAddr(HTYPE_ETHER, sizeof(mac),
+                       std::vector<uint8_t>(mac, mac + sizeof(mac)));
+        ack->updateTimestamp();
+        return (ack);
+    }
+
     /// \brief Create DHCPv6 ADVERTISE packet.
     ///
     /// \param transid transaction id.
@@ -906,15 +1110,22 @@ public:
 
 // This test verifies that the class members are reset to expected values.
 TEST_F(TestControlTest, reset) {
-    ASSERT_NO_THROW(processCmdLine("perfdhcp -6 -l ethx -r 50 -f 30 -F 10 -a 3 all"));
+    ASSERT_NO_THROW(processCmdLine("perfdhcp -6 -l ethx -r 50 -f 30 -F 10"
+                                   " -j 4 -k 3 -K 2 -a 3 all"));
     NakedTestControl tc;
     tc.reset();
     EXPECT_EQ(3, tc.basic_rate_control_.getAggressivity());
     EXPECT_EQ(3, tc.renew_rate_control_.getAggressivity());
     EXPECT_EQ(3, tc.release_rate_control_.getAggressivity());
+    EXPECT_EQ(3, tc.rebind_rate_control_.getAggressivity());
+    EXPECT_EQ(3, tc.decline_rate_control_.getAggressivity());
+    EXPECT_EQ(3, tc.reboot_rate_control_.getAggressivity());
     EXPECT_EQ(50, tc.basic_rate_control_.getRate());
     EXPECT_EQ(30, tc.renew_rate_control_.getRate());
     EXPECT_EQ(10, tc.release_rate_control_.getRate());
+    EXPECT_EQ(4, tc.rebind_rate_control_.getRate());
+    EXPECT_EQ(3, tc.decline_rate_control_.getRate());
+    EXPECT_EQ(2, tc.reboot_rate_control_.getRate());
     EXPECT_FALSE(tc.last_report_.is_not_a_date_time());
     EXPECT_FALSE(tc.transid_gen_);
     EXPECT_FALSE(tc.macaddr_gen_);
@@ -1459,6 +1670,148 @@ TEST_F(TestControlTest, createRelease) {
     testCreateRenewRelease(DHCPV6_RELEASE);
 }
 
+// This test verifies that the DHCPv6 Rebind, Decline and Confirm messages
+// are created correctly and that they comprise all required options.
+TEST_F(TestControlTest, createRebindDeclineConfirm) {
+    testCreateRenewRelease(DHCPV6_REBIND);
+    testCreateRenewRelease(DHCPV6_DECLINE);
+    testCreateRenewRelease(DHCPV6_CONFIRM);
+}
+
+// This test verifies that the DHCPv4 messages sent for the leases are
+// created correctly from the DHCPACKs.
+TEST_F(TestControlTest, createFromAck) {
+    testCreateFromAck(TestControl::LEASE_RENEW);
+    testCreateFromAck(TestControl::LEASE_REBIND);
+    testCreateFromAck(TestControl::LEASE_REBOOT);
+    testCreateFromAck(TestControl::LEASE_RELEASE);
+    testCreateFromAck(TestControl::LEASE_DECLINE);
+}
+
+TEST_F(TestControlTest, processRenew4) {
+    testSendFromAck(TestControl::LEASE_RENEW);
+}
+
+TEST_F(TestControlTest, processRebind4) {
+    testSendFromAck(TestControl::LEASE_REBIND);
+}
+
+TEST_F(TestControlTest, processReboot4) {
+    testSendFromAck(TestControl::LEASE_REBOOT);
+}
+
+TEST_F(TestControlTest, processRelease4) {
+    testSendFromAck(TestControl::LEASE_RELEASE);
+}
+
+TEST_F(TestControlTest, processDecline4) {
+    testSendFromAck(TestControl::LEASE_DECLINE);
+}
+
+// This test verifies that the sequential generator starts from the given
+// number, steps by the given difference and starts again when the range
+// is exhausted.
+TEST_F(TestControlTest, SequentialGenerator) {
+    TestControl::SequentialGenerator gen(10, 1, 4);
+    EXPECT_EQ(1, gen.generate());
+    EXPECT_EQ(5, gen.generate());
+    EXPECT_EQ(9, gen.generate());
+    EXPECT_EQ(1, gen.generate());
+
+    TestControl::SequentialGenerator gen_default(3);
+    EXPECT_EQ(0, gen_default.generate());
+    EXPECT_EQ(1, gen_default.generate());
+    EXPECT_EQ(2, gen_default.generate());
+    EXPECT_EQ(0, gen_default.generate());
+}
+
+// This test verifies that the rates, the transaction ids and the clients
+// are split between the generators.
+TEST_F(TestControlTest, generators) {
+    ASSERT_NO_THROW(processCmdLine("perfdhcp -4 -l lo -g 3 -r 10 -f 5 -F 3"
+                                   " -R 6 -P 4 127.0.0.1"));
+    NakedTestControl gen0(0);
+    NakedTestControl gen1(1);
+    NakedTestControl gen2(2);
+
+    // The remainder of the rate goes to the first generators.
+    EXPECT_EQ(4, gen0.basic_rate_control_.getRate());
+    EXPECT_EQ(3, gen1.basic_rate_control_.getRate());
+    EXPECT_EQ(3, gen2.basic_rate_control_.getRate());
+    EXPECT_EQ(2, gen0.renew_rate_control_.getRate());
+    EXPECT_EQ(2, gen1.renew_rate_control_.getRate());
+    EXPECT_EQ(1, gen2.renew_rate_control_.getRate());
+    EXPECT_EQ(1, gen0.release_rate_control_.getRate());
+    EXPECT_EQ(1, gen1.release_rate_control_.getRate());
+    EXPECT_EQ(1, gen2.release_rate_control_.getRate());
+    EXPECT_EQ(0, gen2.rebind_rate_control_.getRate());
+
+    // The transaction ids of a generator are equal to its index modulo
+    // the number of generators, and above those used by the preload.
+    EXPECT_EQ(6, gen0.transid_gen_->generate());
+    EXPECT_EQ(9, gen0.transid_gen_->generate());
+    EXPECT_EQ(7, gen1.transid_gen_->generate());
+    EXPECT_EQ(10, gen1.transid_gen_->generate());
+    EXPECT_EQ(8, gen2.transid_gen_->generate());
+
+    // Each generator simulates its own clients.
+    EXPECT_EQ(1, gen1.macaddr_gen_->generate());
+    EXPECT_EQ(4, gen1.macaddr_gen_->generate());
+    EXPECT_EQ(1, gen1.macaddr_gen_->generate());
+    EXPECT_EQ(2, gen2.macaddr_gen_->generate());
+    EXPECT_EQ(5, gen2.macaddr_gen_->generate());
+}
+
+// This test verifies that a generator receives the packets handed over
+// to it, and that it stops waiting for them when it is stopped.
+TEST_F(TestControlTest, generatorQueue) {
+    ASSERT_NO_THROW(processCmdLine("perfdhcp -4 -l lo -g 2 -r 10 -R 2"
+                                   " 127.0.0.1"));
+    NakedTestControl gen(1);
+
+    Pkt4Ptr offer = createOfferPkt4(1);
+    gen.pushPacket(offer);
+    EXPECT_TRUE(gen.receive4(0) == offer);
+    EXPECT_FALSE(gen.receive4(0));
+    EXPECT_FALSE(gen.receive4(2000));
+
+    EXPECT_FALSE(gen.isStopping());
+    gen.stop();
+    EXPECT_TRUE(gen.isStopping());
+    // A stopped generator doesn't wait for the packets.
+    ptime start = microsec_clock::universal_time();
+    EXPECT_FALSE(gen.receive4(5000000));
+    EXPECT_LT(time_period(start, microsec_clock::universal_time()).
+              length().total_seconds(), 5);
+}
+
+// This test verifies that a generator sends the packets through its own
+// socket.
+TEST_F(TestControlTest, generatorSocket) {
+    std::string loopback_iface(getLocalLoopback());
+    if (loopback_iface.empty()) {
+        std::cout << "Unable to find the loopback interface. Skip test."
+                  << std::endl;
+        return;
+    }
+    processCmdLine("perfdhcp -l " + loopback_iface
+                   + " -g 2 -r 100 -R 20 -L 10547 127.0.0.1");
+    NakedTestControl tc;
+    tc.initializeStatsMgr();
+    int sock_handle = 0;
+    ASSERT_NO_THROW(sock_handle = tc.openSocket());
+    TestControl::TestControlSocket sock(sock_handle);
+
+    NakedTestControl gen(0);
+    gen.stats_mgr4_ = tc.stats_mgr4_;
+    ASSERT_NO_THROW(gen.send_socket_ = gen.openGeneratorSocket(sock));
+    EXPECT_GE(gen.send_socket_, 0);
+    EXPECT_NE(sock_handle, gen.send_socket_);
+    ASSERT_NO_THROW(gen.sendDiscover4(sock));
+    EXPECT_EQ(1, tc.stats_mgr4_->
+              getSentPacketsNum(TestControl::StatsMgr4::XCHG_DO));
+}
+
 // This test verifies that the current timeout value for waiting for
 // the server's responses is valid. The timeout value corresponds to the
 // time period between now and the next message to be sent from the